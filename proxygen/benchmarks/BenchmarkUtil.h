@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <proxygen/lib/http/HTTPMessage.h>
+#include <proxygen/lib/http/codec/HTTPCodec.h>
+
+namespace proxygen {
+namespace bench {
+
+/**
+ * Codec callback that swallows everything; the counters keep the codec
+ * work observable so the optimizer cannot discard the parse.
+ */
+class BlackholeCodecCallback : public HTTPCodec::Callback {
+ public:
+  void onMessageBegin(HTTPCodec::StreamID, HTTPMessage*) override {
+  }
+  void onHeadersComplete(HTTPCodec::StreamID,
+                         std::unique_ptr<HTTPMessage> msg) override {
+    messages += msg ? 1 : 0;
+  }
+  void onBody(HTTPCodec::StreamID,
+              std::unique_ptr<folly::IOBuf> chain,
+              uint16_t) override {
+    bodyBytes += chain ? chain->computeChainDataLength() : 0;
+  }
+  void onTrailersComplete(HTTPCodec::StreamID,
+                          std::unique_ptr<HTTPHeaders>) override {
+  }
+  void onMessageComplete(HTTPCodec::StreamID, bool) override {
+  }
+  void onError(HTTPCodec::StreamID, const HTTPException&, bool) override {
+    errors++;
+  }
+
+  uint64_t messages{0};
+  uint64_t bodyBytes{0};
+  uint64_t errors{0};
+};
+
+/**
+ * A request with a browser-typical header mix.
+ */
+inline HTTPMessage makeBenchRequest() {
+  HTTPMessage req;
+  req.setMethod(HTTPMethod::GET);
+  req.setHTTPVersion(1, 1);
+  req.setURL("/feed/stories?cursor=AbC123&count=25");
+  auto& headers = req.getHeaders();
+  headers.add(HTTP_HEADER_HOST, "www.example.com");
+  headers.add(HTTP_HEADER_USER_AGENT,
+              "Mozilla/5.0 (Macintosh; Intel Mac OS X 10_15_7) "
+              "AppleWebKit/537.36 (KHTML, like Gecko) Chrome/96.0.4664.55 "
+              "Safari/537.36");
+  headers.add(HTTP_HEADER_ACCEPT,
+              "text/html,application/xhtml+xml,application/xml;q=0.9,"
+              "image/avif,image/webp,*/*;q=0.8");
+  headers.add(HTTP_HEADER_ACCEPT_ENCODING, "gzip, deflate, br");
+  headers.add(HTTP_HEADER_ACCEPT_LANGUAGE, "en-US,en;q=0.9");
+  headers.add(HTTP_HEADER_CACHE_CONTROL, "no-cache");
+  headers.add(HTTP_HEADER_COOKIE,
+              "sid=31d4d96e407aad42; pref=abcdef0123456789; dpr=2");
+  headers.add(HTTP_HEADER_REFERER, "https://www.example.com/feed");
+  headers.add("x-request-context", "bench");
+  return req;
+}
+
+} // namespace bench
+} // namespace proxygen
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/Benchmark.h>
+#include <folly/io/IOBuf.h>
+#include <proxygen/benchmarks/BenchmarkUtil.h>
+#include <proxygen/lib/http/codec/HTTP1xCodec.h>
+
+using namespace folly;
+using namespace proxygen;
+
+namespace {
+
+// Captured browser-typical requests; the POST exercises the body path
+constexpr StringPiece kGetRequest =
+    "GET /feed/stories?cursor=AbC123&count=25 HTTP/1.1\r\n"
+    "Host: www.example.com\r\n"
+    "User-Agent: Mozilla/5.0 (Macintosh; Intel Mac OS X 10_15_7) "
+    "AppleWebKit/537.36 (KHTML, like Gecko) Chrome/96.0.4664.55 "
+    "Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,"
+    "image/avif,image/webp,*/*;q=0.8\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Accept-Language: en-US,en;q=0.9\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Cookie: sid=31d4d96e407aad42; pref=abcdef0123456789; dpr=2\r\n"
+    "Referer: https://www.example.com/feed\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n";
+
+constexpr StringPiece kPostRequest =
+    "POST /api/graphql HTTP/1.1\r\n"
+    "Host: www.example.com\r\n"
+    "User-Agent: Mozilla/5.0 (Macintosh; Intel Mac OS X 10_15_7) "
+    "AppleWebKit/537.36 (KHTML, like Gecko) Chrome/96.0.4664.55 "
+    "Safari/537.36\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: 44\r\n"
+    "Origin: https://www.example.com\r\n"
+    "Cookie: sid=31d4d96e407aad42; pref=abcdef0123456789\r\n"
+    "\r\n"
+    "{\"query\":\"{viewer{id,name,profile{photo}}}\"}";
+
+} // namespace
+
+BENCHMARK(HTTP1xParseRequests, iters) {
+  auto getBuf = IOBuf::wrapBuffer(kGetRequest.data(), kGetRequest.size());
+  auto postBuf = IOBuf::wrapBuffer(kPostRequest.data(), kPostRequest.size());
+  for (unsigned i = 0; i < iters; ++i) {
+    HTTP1xCodec codec(TransportDirection::DOWNSTREAM);
+    bench::BlackholeCodecCallback callbacks;
+    codec.setCallback(&callbacks);
+    codec.onIngress(*getBuf);
+    codec.onIngress(*postBuf);
+    CHECK_EQ(callbacks.errors, 0);
+    doNotOptimizeAway(callbacks.messages);
+  }
+}
+
+BENCHMARK(HTTP1xSerializeRequest, iters) {
+  auto req = bench::makeBenchRequest();
+  for (unsigned i = 0; i < iters; ++i) {
+    HTTP1xCodec codec(TransportDirection::UPSTREAM);
+    bench::BlackholeCodecCallback callbacks;
+    codec.setCallback(&callbacks);
+    IOBufQueue writeBuf{IOBufQueue::cacheChainLength()};
+    auto id = codec.createStream();
+    codec.generateHeader(writeBuf, id, req);
+    codec.generateEOM(writeBuf, id);
+    doNotOptimizeAway(writeBuf.chainLength());
+  }
+}
+
+BENCHMARK(HTTP1xParseSerializeRoundTrip, iters) {
+  auto getBuf = IOBuf::wrapBuffer(kGetRequest.data(), kGetRequest.size());
+  HTTPMessage resp;
+  resp.setHTTPVersion(1, 1);
+  resp.setStatusCode(200);
+  resp.setStatusMessage("OK");
+  resp.getHeaders().add(HTTP_HEADER_CONTENT_TYPE, "text/html; charset=utf-8");
+  resp.getHeaders().add(HTTP_HEADER_CONTENT_LENGTH, "128");
+  auto body = IOBuf::create(128);
+  body->append(128);
+  for (unsigned i = 0; i < iters; ++i) {
+    HTTP1xCodec codec(TransportDirection::DOWNSTREAM);
+    bench::BlackholeCodecCallback callbacks;
+    codec.setCallback(&callbacks);
+    codec.onIngress(*getBuf);
+    IOBufQueue writeBuf{IOBufQueue::cacheChainLength()};
+    codec.generateHeader(writeBuf, 1, resp);
+    codec.generateBody(writeBuf, 1, body->clone(), folly::none, true /* eom */);
+    doNotOptimizeAway(writeBuf.chainLength());
+  }
+}
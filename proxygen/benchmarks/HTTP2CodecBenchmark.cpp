@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/Benchmark.h>
+#include <folly/io/IOBuf.h>
+#include <proxygen/benchmarks/BenchmarkUtil.h>
+#include <proxygen/lib/http/codec/HTTP2Codec.h>
+
+using namespace folly;
+using namespace proxygen;
+
+namespace {
+
+constexpr size_t kStreamsPerCorpus = 100;
+
+// Preface, settings and kStreamsPerCorpus requests (HEADERS + one DATA
+// frame each), encoded once; the decode benchmark replays it against a
+// fresh downstream codec so the HPACK table evolves the same way every
+// iteration
+std::unique_ptr<IOBuf> buildDecodeCorpus() {
+  HTTP2Codec client(TransportDirection::UPSTREAM);
+  IOBufQueue writeBuf{IOBufQueue::cacheChainLength()};
+  client.generateConnectionPreface(writeBuf);
+  client.generateSettings(writeBuf);
+  auto req = bench::makeBenchRequest();
+  auto body = IOBuf::create(512);
+  body->append(512);
+  for (size_t i = 0; i < kStreamsPerCorpus; ++i) {
+    HTTPCodec::StreamID id = 2 * i + 1;
+    client.generateHeader(writeBuf, id, req);
+    client.generateBody(writeBuf, id, body->clone(), folly::none, true);
+  }
+  return writeBuf.move();
+}
+
+} // namespace
+
+BENCHMARK(HTTP2CodecEncodeHeaders, iters) {
+  HTTP2Codec codec(TransportDirection::UPSTREAM);
+  bench::BlackholeCodecCallback callbacks;
+  codec.setCallback(&callbacks);
+  IOBufQueue writeBuf{IOBufQueue::cacheChainLength()};
+  codec.generateConnectionPreface(writeBuf);
+  codec.generateSettings(writeBuf);
+  auto req = bench::makeBenchRequest();
+  for (unsigned i = 0; i < iters; ++i) {
+    codec.generateHeader(writeBuf, 2 * i + 1, req, true /* eom */);
+    doNotOptimizeAway(writeBuf.chainLength());
+    writeBuf.move(); // drop the encoded frames, keep the codec state
+  }
+}
+
+BENCHMARK(HTTP2CodecEncodeBody, iters) {
+  HTTP2Codec codec(TransportDirection::UPSTREAM);
+  bench::BlackholeCodecCallback callbacks;
+  codec.setCallback(&callbacks);
+  IOBufQueue writeBuf{IOBufQueue::cacheChainLength()};
+  codec.generateConnectionPreface(writeBuf);
+  codec.generateSettings(writeBuf);
+  auto req = bench::makeBenchRequest();
+  codec.generateHeader(writeBuf, 1, req);
+  auto body = IOBuf::create(4096);
+  body->append(4096);
+  for (unsigned i = 0; i < iters; ++i) {
+    codec.generateBody(writeBuf, 1, body->clone(), folly::none, false);
+    doNotOptimizeAway(writeBuf.chainLength());
+    writeBuf.move();
+  }
+}
+
+BENCHMARK(HTTP2CodecDecodeCorpus, iters) {
+  folly::BenchmarkSuspender suspender;
+  auto corpus = buildDecodeCorpus();
+  suspender.dismiss();
+  for (unsigned i = 0; i < iters; ++i) {
+    HTTP2Codec server(TransportDirection::DOWNSTREAM);
+    bench::BlackholeCodecCallback callbacks;
+    server.setCallback(&callbacks);
+    server.onIngress(*corpus);
+    CHECK_EQ(callbacks.errors, 0);
+    CHECK_EQ(callbacks.messages, kStreamsPerCorpus);
+    doNotOptimizeAway(callbacks.bodyBytes);
+  }
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/Benchmark.h>
+#include <proxygen/lib/http/session/HTTP2PriorityQueue.h>
+
+using namespace folly;
+using namespace proxygen;
+
+namespace {
+
+// nextEgress() never dereferences the transactions, so fake pointers are
+// enough (same trick as HTTP2PriorityQueueBench)
+char* fakeTxn = (char*)0xface0000;
+
+const HTTPCodec::StreamID kRootNodeId = std::numeric_limits<uint64_t>::max();
+
+HTTPTransaction* makeFakeTxn(HTTPCodec::StreamID id) {
+  return (HTTPTransaction*)(fakeTxn + id);
+}
+
+void nextEgressBench(size_t numStreams, unsigned iters) {
+  folly::BenchmarkSuspender suspender;
+  HTTP2PriorityQueue queue(WheelTimerInstance(), kRootNodeId);
+  uint64_t depth = 0;
+  std::vector<HTTP2PriorityQueue::Handle> handles;
+  handles.reserve(numStreams);
+  for (size_t i = 0; i < numStreams; ++i) {
+    HTTPCodec::StreamID id = 2 * i + 1;
+    handles.push_back(queue.addTransaction(
+        id, http2::DefaultPriority, makeFakeTxn(id), false, &depth));
+  }
+  for (auto handle : handles) {
+    queue.signalPendingEgress(handle);
+  }
+  HTTP2PriorityQueue::NextEgressResult result;
+  suspender.dismiss();
+  for (unsigned i = 0; i < iters; ++i) {
+    queue.nextEgress(result);
+    doNotOptimizeAway(result.size());
+    result.clear();
+  }
+  suspender.rehire();
+}
+
+} // namespace
+
+BENCHMARK(NextEgress10Streams, iters) {
+  nextEgressBench(10, iters);
+}
+
+BENCHMARK(NextEgress100Streams, iters) {
+  nextEgressBench(100, iters);
+}
+
+BENCHMARK(NextEgress1000Streams, iters) {
+  nextEgressBench(1000, iters);
+}
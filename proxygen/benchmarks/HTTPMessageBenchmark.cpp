@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/Benchmark.h>
+#include <proxygen/benchmarks/BenchmarkUtil.h>
+
+using namespace folly;
+using namespace proxygen;
+
+BENCHMARK(HTTPMessageCopy, iters) {
+  auto req = bench::makeBenchRequest();
+  for (unsigned i = 0; i < iters; ++i) {
+    HTTPMessage copy(req);
+    doNotOptimizeAway(copy.getHeaders().size());
+  }
+}
+
+BENCHMARK(HTTPMessageMove, iters) {
+  folly::BenchmarkSuspender suspender;
+  auto req = bench::makeBenchRequest();
+  for (unsigned i = 0; i < iters; ++i) {
+    HTTPMessage copy(req); // made off the clock; only the move is timed
+    suspender.dismissing([&] {
+      HTTPMessage moved(std::move(copy));
+      doNotOptimizeAway(moved.getHeaders().size());
+    });
+  }
+}
+
+BENCHMARK(HTTPMessageCopyAssignOverExisting, iters) {
+  auto req = bench::makeBenchRequest();
+  HTTPMessage target(req);
+  for (unsigned i = 0; i < iters; ++i) {
+    target = req;
+    doNotOptimizeAway(target.getHeaders().size());
+  }
+}
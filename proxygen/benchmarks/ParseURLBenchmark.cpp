@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/Benchmark.h>
+#include <folly/Range.h>
+#include <proxygen/lib/utils/ParseURL.h>
+
+using namespace folly;
+using namespace proxygen;
+
+namespace {
+
+void parseBench(StringPiece url, unsigned iters) {
+  for (unsigned i = 0; i < iters; ++i) {
+    ParseURL parsed(url);
+    doNotOptimizeAway(parsed.valid());
+    doNotOptimizeAway(parsed.path().data());
+  }
+}
+
+} // namespace
+
+BENCHMARK(ParseURLRelative, iters) {
+  parseBench("/feed/stories?cursor=AbC123&count=25", iters);
+}
+
+BENCHMARK(ParseURLAbsolute, iters) {
+  parseBench(
+      "https://www.example.com:8443/feed/stories?cursor=AbC123&count=25"
+      "#latest",
+      iters);
+}
+
+BENCHMARK(ParseURLIPv6Authority, iters) {
+  parseBench("https://[2001:db8::1428:57ab]:8080/index.html?lang=en", iters);
+}
+
+BENCHMARK(ParseURLHostIsIPAddress, iters) {
+  for (unsigned i = 0; i < iters; ++i) {
+    ParseURL parsed("https://192.0.2.77:8443/healthcheck");
+    doNotOptimizeAway(parsed.hostIsIPAddress());
+  }
+}
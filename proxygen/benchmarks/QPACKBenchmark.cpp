@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/Benchmark.h>
+#include <folly/Conv.h>
+#include <proxygen/benchmarks/BenchmarkUtil.h>
+#include <proxygen/lib/http/codec/compress/QPACKCodec.h>
+
+using namespace folly;
+using namespace proxygen;
+
+namespace {
+
+class BlackholeStreamingCallback : public HPACK::StreamingCallback {
+ public:
+  void onHeader(const HPACKHeaderName& /*name*/,
+                const folly::fbstring& value) override {
+    bytes += value.size();
+  }
+  void onHeadersComplete(HTTPHeaderSize, bool) override {
+    blocks++;
+  }
+  void onDecodeError(HPACK::DecodeError) override {
+    errors++;
+  }
+
+  uint64_t bytes{0};
+  uint64_t blocks{0};
+  uint64_t errors{0};
+};
+
+} // namespace
+
+/**
+ * Encode with a live dynamic table: the cookie and request id rotate so
+ * entries keep getting inserted and evicted, and the decoder half acks
+ * each block so the encoder can actually reuse and evict entries the way
+ * it would on a real connection.
+ */
+BENCHMARK(QPACKEncodeDynamicTableChurn, iters) {
+  QPACKCodec codec;
+  codec.setEncoderHeaderTableSize(4096);
+  codec.setDecoderHeaderTableMaxSize(4096);
+  BlackholeStreamingCallback callback;
+  auto req = bench::makeBenchRequest();
+  IOBufQueue controlQueue{IOBufQueue::cacheChainLength()};
+  for (unsigned i = 0; i < iters; ++i) {
+    auto& headers = req.getHeaders();
+    headers.set(HTTP_HEADER_COOKIE,
+                folly::to<std::string>("sid=31d4d96e407aad42; gen=", i % 61));
+    headers.set("x-request-id", folly::to<std::string>(i));
+    const uint64_t id = i + 1;
+    auto block = codec.encodeHTTP(controlQueue, req, false /* date */, id);
+    const auto length = block->computeChainDataLength();
+    if (!controlQueue.empty()) {
+      CHECK(codec.decodeEncoderStream(controlQueue.move()) ==
+            HPACK::DecodeError::NONE);
+    }
+    codec.decodeStreaming(id, std::move(block), length, &callback);
+    // flow the section ack back so unacked entries do not pin the table
+    auto ack = codec.encodeHeaderAck(id);
+    if (ack) {
+      CHECK(codec.decodeDecoderStream(std::move(ack)) ==
+            HPACK::DecodeError::NONE);
+    }
+    doNotOptimizeAway(callback.bytes);
+  }
+  CHECK_EQ(callback.errors, 0);
+}
+
+/**
+ * Encode with the dynamic table disabled, as a baseline: all the time
+ * goes to static-table matching and literal emission.
+ */
+BENCHMARK_RELATIVE(QPACKEncodeStaticOnly, iters) {
+  QPACKCodec codec;
+  codec.setEncoderHeaderTableSize(0);
+  auto req = bench::makeBenchRequest();
+  IOBufQueue controlQueue{IOBufQueue::cacheChainLength()};
+  for (unsigned i = 0; i < iters; ++i) {
+    auto block = codec.encodeHTTP(controlQueue, req, false /* date */, i + 1);
+    doNotOptimizeAway(block->computeChainDataLength());
+    controlQueue.move();
+  }
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <folly/String.h>
+#include <folly/init/Init.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/SSLOptions.h>
+#include <folly/portability/GFlags.h>
+#include <folly/ssl/Init.h>
+#include <proxygen/httpclient/samples/loadgen/LoadGenerator.h>
+
+using namespace LoadGenService;
+
+DEFINE_string(server, "127.0.0.1:8080", "Server ip:port to load");
+DEFINE_string(host, "", "Host header value (defaults to --server)");
+DEFINE_int32(threads, 1, "Worker threads, one EventBase each");
+DEFINE_int32(connections, 8, "Connections per worker thread");
+DEFINE_double(rate,
+              0,
+              "Open-loop arrival rate in requests/sec across all workers; "
+              "0 runs closed-loop at the configured concurrency");
+DEFINE_int32(duration_secs, 10, "Length of the measured run");
+DEFINE_string(profile,
+              "",
+              "Recorded request corpus to replay (one request per line: "
+              "METHOD <path> [Name: Value; Name: Value]); empty = GET /");
+DEFINE_int64(body_bytes, 0, "Mean request body size for non-GET entries");
+DEFINE_double(body_sigma, 0.5, "Log-normal sigma for request body sizes");
+DEFINE_int32(max_requests_per_conn,
+             0,
+             "Reconnect after this many requests per connection (0 = never); "
+             "models connection churn");
+DEFINE_bool(tls, false, "Connect with TLS");
+DEFINE_string(next_protos, "h2,http/1.1", "ALPN list for TLS connects");
+DEFINE_string(plaintext_proto,
+              "",
+              "Plaintext codec protocol (e.g. h2c); empty = HTTP/1.1");
+DEFINE_string(ca_path, "", "Trusted CA file for TLS");
+DEFINE_int32(connect_timeout_ms, 1000, "Connect timeout");
+DEFINE_uint64(seed, 1, "RNG seed; same seed + profile reproduces a run");
+DEFINE_string(hdr_output,
+              "",
+              "Write the full HdrHistogram percentile table to this file "
+              "('-' for stdout)");
+
+int main(int argc, char* argv[]) {
+#if FOLLY_HAVE_LIBGFLAGS
+  gflags::SetCommandLineOptionWithMode(
+      "logtostderr", "1", gflags::SET_FLAGS_DEFAULT);
+#endif
+  folly::init(&argc, &argv, false);
+  folly::ssl::init();
+
+  LoadGenConfig config;
+  config.server = folly::SocketAddress(FLAGS_server, 0, true);
+  config.host = FLAGS_host.empty() ? FLAGS_server : FLAGS_host;
+  config.useTLS = FLAGS_tls;
+  config.plaintextProto = FLAGS_plaintext_proto;
+  config.connections = FLAGS_connections;
+  config.maxRequestsPerConn = FLAGS_max_requests_per_conn;
+  config.connectTimeout = std::chrono::milliseconds(FLAGS_connect_timeout_ms);
+  config.duration = std::chrono::seconds(FLAGS_duration_secs);
+
+  if (FLAGS_tls) {
+    auto ctx = std::make_shared<folly::SSLContext>();
+    ctx->setOptions(SSL_OP_NO_COMPRESSION);
+    ctx->setCipherList(folly::ssl::SSLCommonOptions::ciphers());
+    if (!FLAGS_ca_path.empty()) {
+      ctx->loadTrustedCertificates(FLAGS_ca_path.c_str());
+    }
+    std::list<std::string> nextProtoList;
+    folly::splitTo<std::string>(
+        ',',
+        FLAGS_next_protos,
+        std::inserter(nextProtoList, nextProtoList.begin()));
+    ctx->setAdvertisedNextProtocols(nextProtoList);
+    config.sslContext = std::move(ctx);
+  }
+
+  RequestProfile profile;
+  try {
+    profile = FLAGS_profile.empty() ? RequestProfile::defaultProfile()
+                                    : RequestProfile::fromFile(FLAGS_profile);
+  } catch (const std::runtime_error& ex) {
+    LOG(ERROR) << ex.what();
+    return EXIT_FAILURE;
+  }
+  profile.bodyBytesMean = FLAGS_body_bytes;
+  profile.bodyBytesSigma = FLAGS_body_sigma;
+
+  auto nThreads = std::max(1, FLAGS_threads);
+  std::vector<LoadGenStats> results(nThreads);
+  std::vector<std::thread> workers;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < nThreads; ++i) {
+    workers.emplace_back([&, i] {
+      auto workerConfig = config;
+      workerConfig.openLoopRate = FLAGS_rate / nThreads;
+      workerConfig.seed = FLAGS_seed + i;
+      folly::EventBase evb;
+      LoadGenerator generator(&evb, std::move(workerConfig), profile);
+      generator.run();
+      results[i] = generator.getStats();
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+
+  LoadGenStats total;
+  for (const auto& result : results) {
+    total.merge(result);
+  }
+
+  auto& latency = total.latency;
+  std::cout << "duration_ms " << elapsed.count() << "\n"
+            << "requests " << total.requestsStarted << "\n"
+            << "responses " << total.responses << "\n"
+            << "errors " << total.errors << "\n"
+            << "connects " << total.connects << "\n"
+            << "connect_errors " << total.connectErrors << "\n"
+            << "arrivals_dropped " << total.arrivalsDropped << "\n"
+            << "rps "
+            << (elapsed.count() > 0 ? total.responses * 1000 / elapsed.count()
+                                    : 0)
+            << "\n"
+            << "latency_usec_p50 " << latency.valueAtPercentile(50) << "\n"
+            << "latency_usec_p90 " << latency.valueAtPercentile(90) << "\n"
+            << "latency_usec_p99 " << latency.valueAtPercentile(99) << "\n"
+            << "latency_usec_p999 " << latency.valueAtPercentile(99.9) << "\n"
+            << "latency_usec_max " << latency.max() << "\n";
+
+  if (!FLAGS_hdr_output.empty()) {
+    if (FLAGS_hdr_output == "-") {
+      latency.dumpHdr(std::cout);
+    } else {
+      std::ofstream out(FLAGS_hdr_output);
+      latency.dumpHdr(out);
+    }
+  }
+
+  return total.responses > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
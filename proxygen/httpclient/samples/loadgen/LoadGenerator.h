@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <folly/SocketAddress.h>
+#include <folly/io/async/AsyncTimeout.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/SSLContext.h>
+#include <proxygen/lib/http/HTTPConnector.h>
+#include <proxygen/lib/http/session/HTTPUpstreamSession.h>
+
+namespace LoadGenService {
+
+/**
+ * The requests a load run replays.  Entries come from a recorded corpus
+ * file (one request per line: METHOD <path> [Name: Value; Name: Value])
+ * and are replayed round-robin.  Entries with a body-carrying method
+ * get a body whose size is drawn from a log-normal distribution around
+ * bodyBytesMean, the shape that request-size traces usually follow.
+ */
+struct RequestProfile {
+  struct Entry {
+    std::string method;
+    std::string path;
+    std::vector<std::pair<std::string, std::string>> headers;
+  };
+
+  std::vector<Entry> entries;
+  uint64_t bodyBytesMean{0};
+  double bodyBytesSigma{0.5};
+
+  /**
+   * Parse a corpus file.  Throws std::runtime_error on malformed input
+   * so a bad profile fails the run instead of skewing it.
+   */
+  static RequestProfile fromFile(const std::string& filename);
+
+  // A single GET / when no corpus is given
+  static RequestProfile defaultProfile();
+};
+
+/**
+ * HDR-style log-linear latency histogram: power-of-two major buckets
+ * split into 32 linear sub-buckets, so relative error stays under ~3%
+ * from 1us to over an hour while the whole table is a flat array that
+ * merges across worker threads with an add.
+ */
+class LatencyHistogram {
+ public:
+  void record(uint64_t usec);
+  void merge(const LatencyHistogram& other);
+
+  uint64_t count() const {
+    return total_;
+  }
+  uint64_t max() const {
+    return max_;
+  }
+  uint64_t valueAtPercentile(double pct) const;
+
+  /**
+   * Classic hdrhistogram-format percentile table (Value, Percentile,
+   * TotalCount, 1/(1-Percentile)), consumable by HdrHistogram plotters.
+   */
+  void dumpHdr(std::ostream& os) const;
+
+ private:
+  static constexpr uint32_t kSubBucketBits = 5;
+  static constexpr uint32_t kSubBuckets = 1 << kSubBucketBits;
+  static constexpr uint32_t kBuckets = 28;
+
+  static uint32_t indexFor(uint64_t usec);
+  // Upper bound of the values counted at this index
+  static uint64_t valueFor(uint32_t index);
+
+  std::array<uint64_t, kBuckets * kSubBuckets> counts_{};
+  uint64_t total_{0};
+  uint64_t max_{0};
+};
+
+struct LoadGenConfig {
+  folly::SocketAddress server;
+  std::string host;
+
+  // TLS with ALPN (nextProtos) or plaintext (plaintextProto, empty for
+  // HTTP/1.1); this is how H1 vs H2 is selected
+  bool useTLS{false};
+  std::string nextProtos{"h2,http/1.1"};
+  std::string plaintextProto;
+  std::shared_ptr<folly::SSLContext> sslContext;
+
+  // Concurrent connections driven by this worker
+  uint32_t connections{8};
+  // Open-loop arrival rate in requests/sec for this worker; 0 runs
+  // closed-loop, where each connection issues requests back to back
+  double openLoopRate{0};
+  // Reconnect after this many requests on a connection (0 = never);
+  // models connection churn
+  uint32_t maxRequestsPerConn{0};
+
+  std::chrono::milliseconds connectTimeout{1000};
+  std::chrono::seconds duration{10};
+  // Seed for arrivals and body sizing; fixed seed + fixed profile makes
+  // runs reproducible
+  uint64_t seed{1};
+};
+
+struct LoadGenStats {
+  uint64_t requestsStarted{0};
+  uint64_t responses{0};
+  uint64_t errors{0};
+  uint64_t connects{0};
+  uint64_t connectErrors{0};
+  // Open-loop arrivals that found every connection at capacity
+  uint64_t arrivalsDropped{0};
+  LatencyHistogram latency;
+
+  void merge(const LoadGenStats& other);
+};
+
+/**
+ * One worker's load loop: drives a set of connections against one
+ * server from a single EventBase, replaying a RequestProfile either
+ * closed-loop (fixed concurrency, requests back to back) or open-loop
+ * (Poisson arrivals at a fixed rate, the honest way to measure latency
+ * under load because slow responses don't throttle the offered rate).
+ *
+ * Run one LoadGenerator per thread and merge the stats; everything here
+ * is single-threaded on the EventBase.
+ */
+class LoadGenerator : private folly::AsyncTimeout {
+ public:
+  LoadGenerator(folly::EventBase* evb,
+                LoadGenConfig config,
+                RequestProfile profile);
+  ~LoadGenerator() override;
+
+  /**
+   * Run the load loop for the configured duration and drain; returns
+   * when every connection has finished.
+   */
+  void run();
+
+  const LoadGenStats& getStats() const {
+    return stats_;
+  }
+
+ private:
+  class Driver;
+  class RequestRunner;
+  friend class Driver;
+  friend class RequestRunner;
+
+  // Open-loop arrival timer
+  void timeoutExpired() noexcept override;
+  void scheduleNextArrival();
+  void onArrival();
+
+  bool pastDeadline() const;
+  const RequestProfile::Entry& nextEntry();
+  uint64_t nextBodyBytes();
+
+  folly::EventBase* const evb_;
+  const LoadGenConfig config_;
+  const RequestProfile profile_;
+
+  folly::HHWheelTimer::UniquePtr timer_;
+  std::vector<std::unique_ptr<Driver>> drivers_;
+  std::chrono::steady_clock::time_point deadline_;
+  std::chrono::steady_clock::time_point nextArrival_;
+  std::mt19937_64 rng_;
+  std::exponential_distribution<double> arrivalDist_;
+  std::lognormal_distribution<double> bodyDist_;
+  size_t nextEntryIndex_{0};
+  size_t nextDriverIndex_{0};
+  LoadGenStats stats_;
+};
+
+} // namespace LoadGenService
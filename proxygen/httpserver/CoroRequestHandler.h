@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <folly/Portability.h>
+
+#if FOLLY_HAS_COROUTINES
+
+#include <folly/CancellationToken.h>
+#include <folly/experimental/coro/Baton.h>
+#include <folly/experimental/coro/Task.h>
+#include <folly/experimental/coro/WithCancellation.h>
+#include <folly/io/IOBufQueue.h>
+#include <folly/io/async/EventBaseManager.h>
+#include <proxygen/httpserver/RequestHandler.h>
+#include <proxygen/httpserver/ResponseBuilder.h>
+#include <proxygen/httpserver/ResponseHandler.h>
+#include <proxygen/lib/utils/Exception.h>
+
+namespace proxygen {
+
+/**
+ * Pull-based view of a request body for coroutine handlers.  Chunks
+ * arriving from the transaction are buffered in an IOBufQueue; each
+ * next() returns everything buffered since the last call, or nullptr at
+ * EOM.  When data is already buffered, next() completes synchronously
+ * with no suspension and no executor hop; it only suspends (on a coro
+ * Baton) while the queue is empty.
+ */
+class CoroBodyStream {
+ public:
+  /**
+   * Returns the next span of body bytes, nullptr once the body is
+   * complete.  Throws proxygen::Exception if the request failed before
+   * the body finished.
+   */
+  folly::coro::Task<std::unique_ptr<folly::IOBuf>> next() {
+    while (true) {
+      if (!queue_.empty()) {
+        co_return queue_.move();
+      }
+      if (error_) {
+        throw Exception("request body terminated by error");
+      }
+      if (eom_) {
+        co_return nullptr;
+      }
+      ready_.reset();
+      co_await ready_;
+    }
+  }
+
+  // Feeder side, called by the adaptor on the IO thread.
+  void append(std::unique_ptr<folly::IOBuf> chunk) {
+    queue_.append(std::move(chunk));
+    ready_.post();
+  }
+
+  void markEom() {
+    eom_ = true;
+    ready_.post();
+  }
+
+  void markError() {
+    error_ = true;
+    ready_.post();
+  }
+
+ private:
+  folly::IOBufQueue queue_{folly::IOBufQueue::cacheChainLength()};
+  folly::coro::Baton ready_;
+  bool eom_{false};
+  bool error_{false};
+};
+
+/**
+ * A complete response from a coroutine handler: headers plus an
+ * optional body, sent with EOM when the handler's task completes.
+ */
+struct CoroHTTPResponse {
+  HTTPMessage headers;
+  std::unique_ptr<folly::IOBuf> body;
+};
+
+/**
+ * Coroutine-native request handler.  Implementations read the body by
+ * co_awaiting the stream and co_return the response; the adaptor below
+ * takes care of the callback plumbing, so service code needs no
+ * per-event wrapper allocations.  Cancellation is requested through the
+ * task's folly::CancellationToken when the transaction errors out.
+ */
+class CoroRequestHandler {
+ public:
+  virtual ~CoroRequestHandler() {
+  }
+
+  virtual folly::coro::Task<CoroHTTPResponse> co_handleRequest(
+      std::unique_ptr<HTTPMessage> request, CoroBodyStream& body) = 0;
+};
+
+/**
+ * Adaptor presenting a CoroRequestHandler as a RequestHandler, so it
+ * composes with the existing filter chain and factories.  The task is
+ * started inline from onRequest and runs on the IO thread until its
+ * first suspension; later resumptions are scheduled on the same
+ * EventBase.  Body chunks are handed to the stream by pointer move with
+ * no executor bounce.  onError cancels the task and fails any pending
+ * body read; the adaptor deletes itself once both the transaction has
+ * detached and the task has finished.
+ */
+class CoroRequestHandlerAdaptor : public RequestHandler {
+ public:
+  explicit CoroRequestHandlerAdaptor(
+      std::unique_ptr<CoroRequestHandler> handler)
+      : handler_(std::move(handler)) {
+  }
+
+  void onRequest(std::unique_ptr<HTTPMessage> headers) noexcept override {
+    auto evb = folly::EventBaseManager::get()->getEventBase();
+    running_ = true;
+    folly::coro::co_withCancellation(
+        cancellationSource_.getToken(),
+        handler_->co_handleRequest(std::move(headers), body_))
+        .scheduleOn(evb)
+        .startInlineUnsafe([this](folly::Try<CoroHTTPResponse>&& result) {
+          onTaskComplete(std::move(result));
+        });
+  }
+
+  void onBody(std::unique_ptr<folly::IOBuf> body) noexcept override {
+    body_.append(std::move(body));
+  }
+
+  void onUpgrade(UpgradeProtocol /*prot*/) noexcept override {
+  }
+
+  void onEOM() noexcept override {
+    body_.markEom();
+  }
+
+  void requestComplete() noexcept override {
+    detached_ = true;
+    maybeDelete();
+  }
+
+  void onError(ProxygenError /*err*/) noexcept override {
+    detached_ = true;
+    cancellationSource_.requestCancellation();
+    body_.markError();
+    maybeDelete();
+  }
+
+ private:
+  void onTaskComplete(folly::Try<CoroHTTPResponse>&& result) noexcept {
+    running_ = false;
+    if (detached_) {
+      maybeDelete();
+      return;
+    }
+    if (result.hasValue()) {
+      auto& response = result.value();
+      downstream_->sendHeaders(response.headers);
+      if (response.body) {
+        downstream_->sendBody(std::move(response.body));
+      }
+      downstream_->sendEOM();
+    } else {
+      ResponseBuilder(downstream_)
+          .status(500, "Internal Server Error")
+          .sendWithEOM();
+    }
+    // deletion happens in requestComplete/onError
+  }
+
+  void maybeDelete() {
+    if (detached_ && !running_) {
+      delete this;
+    }
+  }
+
+  std::unique_ptr<CoroRequestHandler> handler_;
+  CoroBodyStream body_;
+  folly::CancellationSource cancellationSource_;
+  bool running_{false};
+  bool detached_{false};
+};
+
+} // namespace proxygen
+
+#endif // FOLLY_HAS_COROUTINES
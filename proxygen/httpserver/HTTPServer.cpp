@@ -8,12 +8,26 @@
 
 #include <proxygen/httpserver/HTTPServer.h>
 
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <folly/executors/thread_factory/InitThreadFactory.h>
 #include <folly/executors/thread_factory/NamedThreadFactory.h>
 #include <folly/io/async/EventBaseManager.h>
+#include <folly/portability/Sockets.h>
 #include <folly/system/ThreadName.h>
 #include <proxygen/httpserver/HTTPServerAcceptor.h>
+#include <proxygen/httpserver/ServerHandoff.h>
+#include <proxygen/lib/services/WorkerThread.h>
 #include <proxygen/httpserver/SignalHandler.h>
 #include <proxygen/httpserver/filters/CompressionFilter.h>
+#include <proxygen/lib/http/codec/compress/CompressionWarmup.h>
 #include <proxygen/httpserver/filters/RejectConnectFilter.h>
 #include <wangle/ssl/SSLContextManager.h>
 
@@ -70,6 +84,8 @@ HTTPServer::HTTPServer(HTTPServerOptions options)
     opts.zlibCompressionLevel = options_->contentCompressionLevel;
     opts.compressibleContentTypes = options_->contentCompressionTypes;
     opts.enableGzip = options_->enableGzipCompression;
+    opts.offloadExecutor = options_->contentCompressionExecutor;
+    opts.offloadThreshold = options_->contentCompressionOffloadThreshold;
     if (options_->enableZstdCompression) {
       opts.enableZstd = options_->enableZstdCompression;
       opts.independentChunks = options_->useZstdIndependentChunks;
@@ -120,20 +136,156 @@ class HandlerCallbacks : public ThreadPoolExecutor::Observer {
   std::shared_ptr<HTTPServerOptions> options_;
 };
 
+namespace {
+
+void pinThreadToCore(folly::IOThreadPoolExecutor& exe, size_t index) {
+#ifdef __linux__
+  exe.add([index] {
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(index % std::thread::hardware_concurrency(), &cpuSet);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) != 0) {
+      PLOG(WARNING) << "Failed to pin IO thread to core";
+    }
+  });
+#else
+  (void)exe;
+  (void)index;
+#endif
+}
+
+void bindThreadToNumaNode(folly::IOThreadPoolExecutor& exe, int node) {
+  exe.add([node] {
+    if (!WorkerThread::bindCurrentThreadToNumaNode(node)) {
+      LOG(WARNING) << "Failed to bind IO thread to NUMA node " << node;
+    }
+  });
+}
+
+// IOThreadPoolExecutor adopts the calling thread's manager-default
+// EventBase, so installing a ring-backed one from the thread factory's
+// init hook routes all of the thread's socket IO through io_uring.
+std::shared_ptr<folly::ThreadFactory> wrapWithIoUringEventBase(
+    std::shared_ptr<folly::ThreadFactory> factory, size_t capacity) {
+  return std::make_shared<folly::InitThreadFactory>(
+      std::move(factory), [capacity] {
+        auto* evb = new folly::EventBase(
+            folly::EventBase::Options().setBackendFactory([capacity] {
+              auto ring = WorkerThread::createIoUringBackend(capacity);
+              if (!ring) {
+                LOG(WARNING) << "io_uring unavailable, IO thread falling "
+                                "back to the default event base backend";
+                return folly::EventBase::getDefaultBackend();
+              }
+              return ring;
+            }));
+        folly::EventBaseManager::get()->setEventBase(evb, true);
+      });
+}
+
+// Apply a listener's TCP tuning profile to its bound listening sockets.
+// Accepted sockets inherit these options from the listener, so applying
+// them here once replaces a setsockopt round trip on every accept.
+void applyListenerTCPTuning(
+    wangle::ServerBootstrap<wangle::DefaultPipeline>& bootstrap,
+    const TCPTuningProfile& tuning) {
+  if (tuning.empty()) {
+    return;
+  }
+  for (const auto& socket : bootstrap.getSockets()) {
+    auto serverSocket =
+        std::dynamic_pointer_cast<folly::AsyncServerSocket>(socket);
+    if (!serverSocket) {
+      continue;
+    }
+    for (auto netSocket : serverSocket->getNetworkSockets()) {
+      const auto fd = netSocket.toFd();
+#ifdef TCP_NOTSENT_LOWAT
+      if (tuning.notsentLowatBytes > 0) {
+        const uint32_t lowat = tuning.notsentLowatBytes;
+        if (setsockopt(
+                fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &lowat, sizeof(lowat)) !=
+            0) {
+          PLOG(WARNING) << "Failed to set TCP_NOTSENT_LOWAT on listener";
+        }
+      }
+#endif
+#ifdef SO_BUSY_POLL
+      if (tuning.busyPollUs > 0) {
+        const int busyPoll = tuning.busyPollUs;
+        if (setsockopt(
+                fd, SOL_SOCKET, SO_BUSY_POLL, &busyPoll, sizeof(busyPoll)) !=
+            0) {
+          PLOG(WARNING) << "Failed to set SO_BUSY_POLL on listener";
+        }
+      }
+#endif
+#ifdef TCP_CONGESTION
+      if (!tuning.congestionControl.empty()) {
+        // string-valued option; cannot be expressed via SocketOptionMap
+        if (setsockopt(fd,
+                       IPPROTO_TCP,
+                       TCP_CONGESTION,
+                       tuning.congestionControl.data(),
+                       tuning.congestionControl.size()) != 0) {
+          PLOG(WARNING) << "Failed to set TCP_CONGESTION="
+                        << tuning.congestionControl << " on listener";
+        }
+      }
+#endif
+      (void)fd;
+    }
+  }
+}
+
+} // namespace
+
 folly::Expected<folly::Unit, std::exception_ptr> HTTPServer::startTcpServer(
     std::shared_ptr<wangle::AcceptorFactory> inputAcceptorFactory,
     std::shared_ptr<folly::IOThreadPoolExecutor> ioExecutor) {
+  if (options_->shardedListeners) {
+    if (!ioExecutor && options_->preboundSockets_.empty()) {
+      return startShardedTcpServer(inputAcceptorFactory);
+    }
+    LOG(WARNING) << "shardedListeners ignored: a custom IO executor or "
+                    "prebound sockets are in use";
+  }
   auto accExe = std::make_shared<IOThreadPoolExecutor>(1);
   if (!ioExecutor) {
+    std::shared_ptr<folly::ThreadFactory> threadFactory =
+        std::make_shared<folly::NamedThreadFactory>("HTTPSrvExec");
+    const auto numaNodes = options_->numaAwareWorkers
+                               ? WorkerThread::getNumaNodes()
+                               : std::vector<int>();
+    if (!numaNodes.empty()) {
+      // Round-robin new IO threads across NUMA nodes; each thread's IO
+      // buffers are then first-touch allocated on its own node
+      auto nextThread = std::make_shared<std::atomic<size_t>>(0);
+      threadFactory = std::make_shared<folly::InitThreadFactory>(
+          std::move(threadFactory), [numaNodes, nextThread] {
+            const auto node =
+                numaNodes[nextThread->fetch_add(1) % numaNodes.size()];
+            if (!WorkerThread::bindCurrentThreadToNumaNode(node)) {
+              LOG(WARNING) << "Failed to bind IO thread to NUMA node " << node;
+            }
+          });
+    }
+    if (options_->ioUringBackend) {
+      threadFactory = wrapWithIoUringEventBase(
+          std::move(threadFactory), options_->ioUringBackendCapacity);
+    }
     ioExecutor = std::make_shared<IOThreadPoolExecutor>(
-        options_->threads,
-        std::make_shared<folly::NamedThreadFactory>("HTTPSrvExec"));
+        options_->threads, std::move(threadFactory));
+  } else if (options_->ioUringBackend) {
+    LOG(WARNING) << "ioUringBackend ignored: a custom IO executor is in use";
   }
   auto exeObserver = std::make_shared<HandlerCallbacks>(options_);
   // Observer has to be set before bind(), so onServerStart() callbacks run
   ioExecutor->addObserver(exeObserver);
 
   try {
+    // Phase one: configure every bootstrap without binding, so the binds
+    // below can run concurrently against a stable bootstrap_ vector.
     FOR_EACH_RANGE(i, 0, addresses_.size()) {
       auto accConfig = HTTPServerAcceptor::makeConfig(addresses_[i], *options_);
       // If user specified an acceptor factory to use, we will use it.
@@ -159,12 +311,140 @@ folly::Expected<folly::Unit, std::exception_ptr> HTTPServer::startTcpServer(
       if (accConfig.reusePort) {
         bootstrap_[i].setReusePort(true);
       }
+    }
+    // Phase two: bind all listeners concurrently; with many vIPs the
+    // serialized binds (each fans acceptor setup out to the workers and
+    // waits) dominated cold start.
+    std::vector<std::function<void()>> binds;
+    FOR_EACH_RANGE(i, 0, addresses_.size()) {
       if (options_->preboundSockets_.size() > i) {
-        bootstrap_[i].bind(std::move(options_->preboundSockets_[i]));
+        binds.push_back([this, i] {
+          bootstrap_[i].bind(std::move(options_->preboundSockets_[i]));
+        });
       } else {
-        bootstrap_[i].bind(addresses_[i].address);
+        binds.push_back([this, i] { bootstrap_[i].bind(addresses_[i].address); });
       }
     }
+    runBindsConcurrently(std::move(binds));
+    // Phase three: tune the bound listeners; accepted sockets inherit
+    // the options, so this is the only place they are applied.
+    FOR_EACH_RANGE(i, 0, addresses_.size()) {
+      applyListenerTCPTuning(bootstrap_[i], addresses_[i].tcpTuning);
+    }
+  } catch (const std::exception&) {
+    stop();
+
+    return folly::makeUnexpected(std::current_exception());
+  }
+
+  return folly::unit;
+}
+
+void HTTPServer::runBindsConcurrently(std::vector<std::function<void()>> binds) {
+  if (binds.size() == 1) {
+    binds[0]();
+    signalFirstListenerReady();
+    return;
+  }
+  std::vector<std::thread> binders;
+  std::vector<std::exception_ptr> errors(binds.size());
+  binders.reserve(binds.size());
+  FOR_EACH_RANGE(i, 0, binds.size()) {
+    binders.emplace_back([this, i, &binds, &errors] {
+      try {
+        binds[i]();
+        signalFirstListenerReady();
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    });
+  }
+  for (auto& binder : binders) {
+    binder.join();
+  }
+  for (auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+void HTTPServer::signalFirstListenerReady() {
+  if (!onFirstListenerReady_) {
+    return;
+  }
+  std::call_once(firstListenerReadyFlag_, onFirstListenerReady_);
+}
+
+folly::Expected<folly::Unit, std::exception_ptr>
+HTTPServer::startShardedTcpServer(
+    std::shared_ptr<wangle::AcceptorFactory> inputAcceptorFactory) {
+  auto exeObserver = std::make_shared<HandlerCallbacks>(options_);
+  const size_t numShards = std::max<size_t>(options_->threads, 1);
+  const auto numaNodes = options_->numaAwareWorkers ? WorkerThread::getNumaNodes()
+                                                    : std::vector<int>();
+
+  try {
+    for (const auto& ipConfig : addresses_) {
+      if (ipConfig.address.getPort() == 0) {
+        // every shard must bind the same port for SO_REUSEPORT to group them
+        throw std::invalid_argument(
+            "shardedListeners requires explicit ports, got port 0 for " +
+            ipConfig.address.describe());
+      }
+    }
+    std::vector<std::function<void()>> binds;
+    FOR_EACH_RANGE(shard, 0, numShards) {
+      // One single-thread executor per shard accepts and serves; the kernel
+      // spreads connections across the shards' listening sockets
+      std::shared_ptr<folly::ThreadFactory> shardThreadFactory =
+          std::make_shared<folly::NamedThreadFactory>("HTTPSrvExec");
+      if (options_->ioUringBackend) {
+        shardThreadFactory = wrapWithIoUringEventBase(
+            std::move(shardThreadFactory), options_->ioUringBackendCapacity);
+      }
+      auto shardExe = std::make_shared<IOThreadPoolExecutor>(
+          1, std::move(shardThreadFactory));
+      shardExe->addObserver(exeObserver);
+      if (!numaNodes.empty()) {
+        // The shard accepts and serves on a node-bound thread, so every
+        // connection stays on the node that accepted it
+        bindThreadToNumaNode(*shardExe, numaNodes[shard % numaNodes.size()]);
+      } else if (options_->pinWorkersToCores) {
+        pinThreadToCore(*shardExe, shard);
+      }
+      FOR_EACH_RANGE(i, 0, addresses_.size()) {
+        auto accConfig =
+            HTTPServerAcceptor::makeConfig(addresses_[i], *options_);
+        auto acceptorFactory = inputAcceptorFactory;
+        if (!acceptorFactory) {
+          acceptorFactory = std::make_shared<AcceptorFactory>(
+              options_, addresses_[i].codecFactory, accConfig, sessionInfoCb_);
+        }
+        bootstrap_.push_back(wangle::ServerBootstrap<wangle::DefaultPipeline>());
+        auto& bootstrap = bootstrap_.back();
+        bootstrap.childHandler(acceptorFactory);
+        if (accConfig.enableTCPFastOpen) {
+          bootstrap.socketConfig.enableTCPFastOpen = true;
+          bootstrap.socketConfig.fastOpenQueueSize = accConfig.fastOpenQueueSize;
+        }
+        bootstrap.group(shardExe, shardExe);
+        bootstrap.setReusePort(true);
+        auto bootstrapIdx = bootstrap_.size() - 1;
+        binds.push_back([this, bootstrapIdx, i] {
+          bootstrap_[bootstrapIdx].bind(addresses_[i].address);
+        });
+      }
+    }
+    // SO_REUSEPORT binds of the same address are independent in the
+    // kernel, so all shards can bind concurrently.
+    runBindsConcurrently(std::move(binds));
+    // Bootstraps were pushed shard-major over addresses_, so bootstrap
+    // idx listens on addresses_[idx % addresses_.size()]
+    FOR_EACH_RANGE(idx, 0, bootstrap_.size()) {
+      applyListenerTCPTuning(bootstrap_[idx],
+                             addresses_[idx % addresses_.size()].tcpTuning);
+    }
   } catch (const std::exception&) {
     stop();
 
@@ -181,6 +461,10 @@ void HTTPServer::start(
     std::shared_ptr<folly::IOThreadPoolExecutor> ioExecutor) {
   mainEventBase_ = EventBaseManager::get()->getEventBase();
 
+  // Build the lazy compression singletons now, off the request path, so
+  // the first HTTP/2 connection doesn't pay for them
+  compress::warmupStaticTables();
+
   auto tcpStarted = startTcpServer(acceptorFactory, ioExecutor);
   if (tcpStarted.hasError()) {
     if (onError) {
@@ -208,6 +492,82 @@ void HTTPServer::start(
   mainEventBase_->loopForever();
 }
 
+void HTTPServer::drain(DrainOptions opts) {
+  // New connections stop first so late arrivals can't slip in behind
+  // the acceptors' drain schedules
+  stopListening();
+
+  // Gather the HTTP acceptors up front so the progress aggregator knows
+  // how many workers will report.  Raw pointers are safe here for the
+  // same reason as in updateTLSCredentials(): acceptors live until
+  // stop() joins the bootstraps, and drain() precedes stop().
+  std::vector<std::pair<folly::EventBase*, HTTPSessionAcceptor*>> acceptors;
+  for (auto& bootstrap : bootstrap_) {
+    bootstrap.forEachWorker([&](wangle::Acceptor* acceptor) {
+      auto httpAcceptor = dynamic_cast<HTTPSessionAcceptor*>(acceptor);
+      if (!httpAcceptor || !httpAcceptor->getEventBase()) {
+        return;
+      }
+      acceptors.emplace_back(httpAcceptor->getEventBase(), httpAcceptor);
+    });
+  }
+  if (acceptors.empty()) {
+    if (opts.progressCallback) {
+      opts.progressCallback(0);
+    }
+    return;
+  }
+
+  // Sums the per-acceptor remaining counts; the user callback fires only
+  // once every acceptor has reported at least once, so early totals
+  // aren't missing whole workers.
+  struct Progress {
+    Progress(size_t n, std::function<void(size_t)> cb)
+        : remaining(n, 0), unreported(n), callback(std::move(cb)) {
+    }
+    std::mutex lock;
+    std::vector<size_t> remaining;
+    size_t unreported;
+    std::function<void(size_t)> callback;
+  };
+  auto progress = std::make_shared<Progress>(acceptors.size(),
+                                             std::move(opts.progressCallback));
+
+  FOR_EACH_RANGE(i, 0, acceptors.size()) {
+    auto evb = acceptors[i].first;
+    auto acceptor = acceptors[i].second;
+    evb->runInEventBaseThread([acceptor,
+                               window = opts.window,
+                               maxConcurrent =
+                                   opts.maxConcurrentDrainsPerWorker,
+                               progress,
+                               i]() {
+      acceptor->startGradualDrain(
+          window,
+          maxConcurrent,
+          [progress, i, first = true](size_t remaining) mutable {
+            size_t total = 0;
+            bool allReported;
+            {
+              std::lock_guard<std::mutex> guard(progress->lock);
+              if (first) {
+                progress->unreported--;
+                first = false;
+              }
+              progress->remaining[i] = remaining;
+              allReported = progress->unreported == 0;
+              for (auto r : progress->remaining) {
+                total += r;
+              }
+            }
+            if (allReported && progress->callback) {
+              progress->callback(total);
+            }
+          });
+    });
+  }
+}
+
 void HTTPServer::stopListening() {
   for (auto& bootstrap : bootstrap_) {
     bootstrap.stop();
@@ -267,6 +627,40 @@ int HTTPServer::getListenSocket() const {
   return socketFds[0].toFd();
 }
 
+std::vector<int> HTTPServer::getListenSockets() const {
+  std::vector<int> fds;
+  for (const auto& bootstrap : bootstrap_) {
+    for (const auto& socket : bootstrap.getSockets()) {
+      auto serverSocket =
+          std::dynamic_pointer_cast<folly::AsyncServerSocket>(socket);
+      if (!serverSocket) {
+        continue;
+      }
+      for (auto netSocket : serverSocket->getNetworkSockets()) {
+        fds.push_back(netSocket.toFd());
+      }
+    }
+  }
+  return fds;
+}
+
+bool HTTPServer::handoffListenSockets(const std::string& unixSocketPath,
+                                      const std::string& payload,
+                                      std::chrono::milliseconds timeout) {
+  auto fds = getListenSockets();
+  if (fds.empty()) {
+    LOG(ERROR) << "No listening sockets to hand off";
+    return false;
+  }
+  if (!handoff::exportListenSockets(unixSocketPath, fds, payload, timeout)) {
+    return false;
+  }
+  // The successor holds kernel duplicates by now, so closing our
+  // descriptors leaves the accept queue intact for it
+  stopListening();
+  return true;
+}
+
 void HTTPServer::updateTLSCredentials() {
   for (auto& bootstrap : bootstrap_) {
     bootstrap.forEachWorker([&](wangle::Acceptor* acceptor) {
@@ -8,11 +8,14 @@
 
 #pragma once
 
+#include <chrono>
 #include <folly/executors/IOThreadPoolExecutor.h>
 #include <folly/io/SocketOptionMap.h>
 #include <folly/io/async/EventBase.h>
 #include <proxygen/httpserver/HTTPServerOptions.h>
 #include <proxygen/lib/http/codec/HTTPCodecFactory.h>
+#include <proxygen/lib/services/AcceptorConfiguration.h>
+#include <mutex>
 #include <proxygen/lib/http/session/HTTPSession.h>
 #include <thread>
 #include <wangle/bootstrap/ServerBootstrap.h>
@@ -81,6 +84,16 @@ class HTTPServer final {
     bool strictSSL{true};
 
     folly::Optional<folly::SocketOptionMap> acceptorSocketOptions;
+
+    /*
+     * Kernel TCP tuning for this listener (TCP_NOTSENT_LOWAT,
+     * SO_BUSY_POLL, TCP_CONGESTION).  Applied once to the listening
+     * socket after bind; accepted sockets inherit the options from the
+     * listener, so there is no per-connection setsockopt cost.  For the
+     * TCP fast open queue depth use enableTCPFastOpen/fastOpenQueueSize
+     * above.
+     */
+    TCPTuningProfile tcpTuning;
   };
 
   /**
@@ -125,6 +138,43 @@ class HTTPServer final {
              std::shared_ptr<wangle::AcceptorFactory> acceptorFactory = nullptr,
              std::shared_ptr<folly::IOThreadPoolExecutor> ioExecutor = nullptr);
 
+  /**
+   * Options for drain(); see below.
+   */
+  struct DrainOptions {
+    /**
+     * Window over which each worker staggers its session drains.
+     */
+    std::chrono::milliseconds window{std::chrono::seconds(10)};
+
+    /**
+     * Cap on sessions actively draining per worker at any time
+     * (0 = no cap).
+     */
+    size_t maxConcurrentDrainsPerWorker{0};
+
+    /**
+     * Invoked with the total number of sessions still connected, each
+     * time a worker reports progress.  The final invocation is with 0.
+     * Called from worker IO threads; must be thread-safe and cheap.
+     */
+    std::function<void(size_t)> progressCallback;
+  };
+
+  /**
+   * Stop accepting new connections and drain existing sessions
+   * gradually: each worker drains its sessions longest-idle first,
+   * spread across the window, instead of sending every GOAWAY at once
+   * and letting all sessions race to finish.  Orchestration can track
+   * completion through the progress callback rather than sleeping a
+   * fixed timeout; call stop() once the count reaches 0 (or a deadline
+   * passes).  Sessions on acceptors that are not HTTPSessionAcceptors
+   * (an exotic custom AcceptorFactory) are not staggered; for those this
+   * is equivalent to stopListening().  Can be called from any thread,
+   * but only after start() has called onSuccess.
+   */
+  void drain(DrainOptions opts = DrainOptions());
+
   /**
    * Stop listening on bound ports. (Stop accepting new work).
    * It does not wait for pending work to complete.
@@ -164,11 +214,50 @@ class HTTPServer final {
     sessionInfoCb_ = cb;
   }
 
+  /**
+   * Install a callback invoked as soon as the first listener is bound and
+   * accepting, before the remaining listeners finish binding.  Listeners
+   * bind concurrently, so with many vIPs this fires well before start()'s
+   * onSuccess; use it to flip readiness checks early in a deploy.  Invoked
+   * at most once, from an internal bind thread.  Must be set before
+   * start().
+   */
+  void setOnFirstListenerReady(std::function<void()> cb) {
+    onFirstListenerReady_ = std::move(cb);
+  }
+
   /**
    * Returns a file descriptor associated with the listening socket
    */
   int getListenSocket() const;
 
+  /**
+   * Returns the file descriptors of every listening socket, across all
+   * bound addresses.  Empty before start() or after stopListening().
+   */
+  std::vector<int> getListenSockets() const;
+
+  /**
+   * Hand this server's listening sockets to a successor process over the
+   * unix socket at unixSocketPath (see ServerHandoff.h), then stop
+   * listening.  The successor starts accepting on the transferred
+   * descriptors before we close ours, so the accept queue survives the
+   * restart; established sessions keep draining on this process's IO
+   * threads, and the caller should stop() once they complete.
+   *
+   * payload is passed through opaquely - typically the filename of the
+   * PersistentFizzPskCache so the successor reopens the warm resumption
+   * state instead of cold-starting TLS caches.
+   *
+   * Blocks up to timeout waiting for the successor; returns false (and
+   * keeps listening) if none connects.  Call from any thread except an
+   * IO thread.
+   */
+  bool handoffListenSockets(
+      const std::string& unixSocketPath,
+      const std::string& payload = "",
+      std::chrono::milliseconds timeout = std::chrono::seconds(30));
+
   /**
    * Re-reads the certificate / key pair for all SSL vips on all acceptors
    */
@@ -192,7 +281,24 @@ class HTTPServer final {
       std::shared_ptr<wangle::AcceptorFactory> acceptorFactory,
       std::shared_ptr<folly::IOThreadPoolExecutor> ioExecutor);
 
+  /**
+   * Start the TCP server with one SO_REUSEPORT listening socket per IO
+   * thread; connections stay on the thread that accepted them.  See
+   * HTTPServerOptions::shardedListeners.
+   */
+  folly::Expected<folly::Unit, std::exception_ptr> startShardedTcpServer(
+      std::shared_ptr<wangle::AcceptorFactory> acceptorFactory);
+
  private:
+  /**
+   * Run the given bind tasks concurrently (one thread each; inline when
+   * there is only one), signalling onFirstListenerReady_ after the first
+   * success.  Rethrows the first failure after all tasks finish.
+   */
+  void runBindsConcurrently(std::vector<std::function<void()>> binds);
+
+  void signalFirstListenerReady();
+
   std::shared_ptr<HTTPServerOptions> options_;
 
   /**
@@ -215,6 +321,12 @@ class HTTPServer final {
    * Callback for session create/destruction
    */
   HTTPSession::InfoCallback* sessionInfoCb_{nullptr};
+
+  /**
+   * Early readiness signal; see setOnFirstListenerReady()
+   */
+  std::function<void()> onFirstListenerReady_;
+  std::once_flag firstListenerReadyFlag_;
 };
 
 } // namespace proxygen
@@ -11,9 +11,11 @@
 #include <folly/ExceptionString.h>
 #include <proxygen/httpserver/RequestHandlerAdaptor.h>
 #include <proxygen/httpserver/RequestHandlerFactory.h>
+#include <proxygen/httpserver/StatsEndpointHandler.h>
 #include <proxygen/lib/http/codec/HTTP1xCodec.h>
 #include <proxygen/lib/http/codec/HTTP2Constants.h>
 #include <proxygen/lib/http/session/HTTPDownstreamSession.h>
+#include <proxygen/lib/utils/AllocationTracker.h>
 
 using folly::SocketAddress;
 
@@ -31,6 +33,10 @@ AcceptorConfiguration HTTPServerAcceptor::makeConfig(
   conf.receiveSessionWindowSize = opts.receiveSessionWindowSize;
   conf.acceptBacklog = opts.listenBacklog;
   conf.maxConcurrentIncomingStreams = opts.maxConcurrentIncomingStreams;
+  conf.tlsRecordInitialSize = opts.tlsRecordInitialSize;
+  conf.tlsRecordMaxSize = opts.tlsRecordMaxSize;
+  conf.tlsRecordBulkThreshold = opts.tlsRecordBulkThreshold;
+  conf.tlsRecordIdleReset = opts.tlsRecordIdleReset;
 
   if (opts.enableExHeaders) {
     conf.egressSettings.push_back(
@@ -51,6 +57,7 @@ AcceptorConfiguration HTTPServerAcceptor::makeConfig(
       ipConfig.allowInsecureConnectionsOnSecureServer;
   conf.enableTCPFastOpen = ipConfig.enableTCPFastOpen;
   conf.fastOpenQueueSize = ipConfig.fastOpenQueueSize;
+  conf.tcpTuning = ipConfig.tcpTuning;
   if (ipConfig.ticketSeeds) {
     conf.initialTicketSeeds = *ipConfig.ticketSeeds;
   }
@@ -106,12 +113,22 @@ HTTPTransactionHandler* HTTPServerAcceptor::newHandler(
   msg->setClientAddress(clientAddr);
   msg->setDstAddress(vipAddr);
 
+  // Stats polls take the direct-handler fast path; no filter chain or
+  // RequestHandlerAdaptor is created for them
+  if (serverOptions_.statsEndpointStats &&
+      !serverOptions_.statsEndpointPath.empty() &&
+      msg->getPathAsStringPiece() == serverOptions_.statsEndpointPath) {
+    return new StatsEndpointHandler(serverOptions_.statsEndpointStats);
+  }
+
   // Create filters chain
   RequestHandler* h = nullptr;
   for (auto& factory : handlerFactories_) {
     h = factory->onRequest(h, msg);
   }
 
+  AllocationTracker::recordAllocation(AllocationTracker::HANDLER,
+                                      sizeof(RequestHandlerAdaptor));
   return new RequestHandlerAdaptor(h);
 }
 
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <folly/Executor.h>
 #include <folly/Function.h>
 #include <folly/SocketAddress.h>
 #include <folly/io/async/AsyncServerSocket.h>
@@ -23,6 +24,8 @@ namespace proxygen {
  * XXX: Provide a helper that can convert thrift/json to this config
  *      directly. We keep this object type-safe.
  */
+class ResourceStats;
+
 class HTTPServerOptions {
  public:
   /**
@@ -160,6 +163,84 @@ class HTTPServerOptions {
    */
   int zstdContentCompressionLevel{8};
 
+  /**
+   * Executor for compressing large response bodies off the IO threads
+   * (typically a bounded CPUThreadPoolExecutor shared across workers);
+   * compressed chunks are recommitted to the session in order.  Bodies
+   * smaller than contentCompressionOffloadThreshold still compress
+   * inline on the IO thread.  nullptr (the default) keeps all
+   * compression on the IO threads.
+   */
+  std::shared_ptr<folly::Executor> contentCompressionExecutor{nullptr};
+
+  uint32_t contentCompressionOffloadThreshold{64 * 1024};
+
+  /**
+   * Adaptive TLS record sizing for downstream sessions.  When
+   * tlsRecordInitialSize is non-zero, a TLS session's first writes are
+   * capped at that size (roughly one MTU keeps time-to-first-byte off
+   * the full-record serialization/loss penalty), ramping up to
+   * tlsRecordMaxSize once tlsRecordBulkThreshold bytes have been written,
+   * and dropping back to the initial size after tlsRecordIdleReset with
+   * no egress.  Plaintext sessions are unaffected.
+   */
+  uint32_t tlsRecordInitialSize{0};
+  uint32_t tlsRecordMaxSize{16384};
+  uint64_t tlsRecordBulkThreshold{65536};
+  std::chrono::milliseconds tlsRecordIdleReset{1000};
+
+  /**
+   * When non-empty, requests for exactly this path are answered by the
+   * built-in StatsEndpointHandler with a flat text snapshot of
+   * statsEndpointStats, bypassing the handlerFactories chain entirely.
+   * The ResourceStats instance must outlive the server.  Intended for
+   * high-frequency fleet polling that should not show up in profiles.
+   */
+  std::string statsEndpointPath;
+  ResourceStats* statsEndpointStats{nullptr};
+
+  /**
+   * If true, every IO thread owns its own SO_REUSEPORT listening socket
+   * bound to the same address and keeps the connections it accepts, instead
+   * of one accept thread round-robining fds to the workers.  The kernel
+   * load-balances incoming connections across the sockets, so accept is no
+   * longer a single-core bottleneck during connection storms.  Requires
+   * explicit (non-zero) ports and is ignored when the caller supplies its
+   * own IO executor or prebound sockets.
+   */
+  bool shardedListeners{false};
+
+  /**
+   * With shardedListeners, pin the i-th IO thread to CPU (i % ncpu).
+   */
+  bool pinWorkersToCores{false};
+
+  /**
+   * Spread IO threads round-robin across the machine's NUMA nodes, pinning
+   * each thread to its node's CPUs and preferring node-local memory for its
+   * allocations, so the IO buffers a thread touches first stay on its own
+   * node.  With shardedListeners each connection is additionally served
+   * entirely on the node whose shard accepted it.  Takes precedence over
+   * pinWorkersToCores and is a no-op on machines without NUMA topology.
+   */
+  bool numaAwareWorkers{false};
+
+  /**
+   * Drive each IO thread's event loop with an io_uring backend instead of
+   * the default (epoll) one, batching event submission and completion
+   * through per-thread rings.  Falls back to the default backend, with a
+   * warning, on kernels or builds without io_uring support, so the flag is
+   * safe to set unconditionally.  Ignored when the caller supplies its own
+   * IO executor to start().
+   */
+  bool ioUringBackend{false};
+
+  /**
+   * Submission queue capacity of each IO thread's ring when
+   * ioUringBackend is set.
+   */
+  size_t ioUringBackendCapacity{256};
+
   /**
    * Enable support for pub-sub extension.
    */
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/httpserver/RequestRouter.h>
+
+#include <glog/logging.h>
+#include <map>
+#include <memory>
+
+namespace proxygen {
+
+/**
+ * Pointer-based tree used only while compiling; flatten() turns it into
+ * the contiguous Node array.
+ */
+struct RequestRouter::BuildNode {
+  std::map<std::string, BuildNode> children; // sorted for the flat layout
+  std::unique_ptr<BuildNode> param;
+  std::string paramName;
+  std::unique_ptr<BuildNode> wildcard;
+  std::string wildcardName;
+  std::vector<Terminal> terminals;
+};
+
+void RequestRouter::addRoute(HTTPMethod method,
+                             folly::StringPiece pattern,
+                             HandlerId id) {
+  CHECK(!compiled_) << "addRoute() after compile()";
+  CHECK_NE(id, kNoMatch);
+  routes_.push_back(Route{method, pattern.str(), id});
+}
+
+void RequestRouter::compile() {
+  CHECK(!compiled_) << "compile() called twice";
+  BuildNode root;
+  for (const auto& route : routes_) {
+    BuildNode* cur = &root;
+    size_t numCaptures = 0;
+    folly::StringPiece rest(route.pattern);
+    while (!rest.empty()) {
+      auto slash = rest.find('/');
+      auto segment = (slash == std::string::npos) ? rest : rest.subpiece(0, slash);
+      rest = (slash == std::string::npos) ? folly::StringPiece()
+                                          : rest.subpiece(slash + 1);
+      if (segment.empty()) {
+        continue;
+      }
+      if (segment[0] == ':') {
+        auto name = segment.subpiece(1);
+        CHECK(!name.empty()) << "unnamed param in " << route.pattern;
+        if (!cur->param) {
+          cur->param = std::make_unique<BuildNode>();
+          cur->paramName = name.str();
+        } else {
+          CHECK_EQ(cur->paramName, name.str())
+              << "conflicting param names in " << route.pattern;
+        }
+        cur = cur->param.get();
+        numCaptures++;
+      } else if (segment[0] == '*') {
+        auto name = segment.subpiece(1);
+        CHECK(!name.empty()) << "unnamed wildcard in " << route.pattern;
+        CHECK(rest.empty()) << "wildcard must be the last segment in "
+                            << route.pattern;
+        if (!cur->wildcard) {
+          cur->wildcard = std::make_unique<BuildNode>();
+          cur->wildcardName = name.str();
+        } else {
+          CHECK_EQ(cur->wildcardName, name.str())
+              << "conflicting wildcard names in " << route.pattern;
+        }
+        cur = cur->wildcard.get();
+        numCaptures++;
+      } else {
+        cur = &cur->children[segment.str()];
+      }
+    }
+    CHECK_LE(numCaptures, Params::kMaxParams)
+        << "too many captures in " << route.pattern;
+    for (const auto& terminal : cur->terminals) {
+      CHECK(terminal.method != route.method)
+          << "duplicate route " << methodToString(route.method) << " "
+          << route.pattern;
+    }
+    cur->terminals.push_back(Terminal{route.method, route.id});
+  }
+
+  nodes_.clear();
+  terminals_.clear();
+  labels_.clear();
+  nodes_.emplace_back();
+  flatten(root, 0);
+  routes_.clear();
+  routes_.shrink_to_fit();
+  compiled_ = true;
+}
+
+uint32_t RequestRouter::flatten(const BuildNode& buildNode, uint32_t nodeIdx) {
+  auto setLabel = [&](uint32_t idx, const std::string& text) {
+    nodes_[idx].labelOffset = labels_.size();
+    nodes_[idx].labelLength = text.size();
+    labels_.append(text);
+  };
+
+  nodes_[nodeIdx].firstTerminal = terminals_.size();
+  nodes_[nodeIdx].numTerminals = buildNode.terminals.size();
+  terminals_.insert(terminals_.end(),
+                    buildNode.terminals.begin(),
+                    buildNode.terminals.end());
+
+  // lay out literal children contiguously (map order keeps them sorted
+  // by label), then recurse; children of children land further out
+  const uint32_t firstChild = nodes_.size();
+  nodes_[nodeIdx].firstChild = firstChild;
+  nodes_[nodeIdx].numChildren = buildNode.children.size();
+  for (const auto& child : buildNode.children) {
+    nodes_.emplace_back();
+    setLabel(nodes_.size() - 1, child.first);
+  }
+  uint32_t childIdx = firstChild;
+  for (const auto& child : buildNode.children) {
+    flatten(child.second, childIdx++);
+  }
+
+  if (buildNode.param) {
+    const uint32_t paramIdx = nodes_.size();
+    nodes_.emplace_back();
+    setLabel(paramIdx, buildNode.paramName);
+    nodes_[nodeIdx].paramChild = paramIdx;
+    flatten(*buildNode.param, paramIdx);
+  }
+  if (buildNode.wildcard) {
+    const uint32_t wildcardIdx = nodes_.size();
+    nodes_.emplace_back();
+    setLabel(wildcardIdx, buildNode.wildcardName);
+    nodes_[nodeIdx].wildcardChild = wildcardIdx;
+    flatten(*buildNode.wildcard, wildcardIdx);
+  }
+  return nodeIdx;
+}
+
+RequestRouter::HandlerId RequestRouter::matchTerminals(
+    const Node& node, HTTPMethod method) const {
+  for (uint32_t i = 0; i < node.numTerminals; i++) {
+    const auto& terminal = terminals_[node.firstTerminal + i];
+    if (terminal.method == method) {
+      return terminal.id;
+    }
+  }
+  return kNoMatch;
+}
+
+RequestRouter::HandlerId RequestRouter::matchNode(uint32_t nodeIdx,
+                                                  folly::StringPiece rest,
+                                                  HTTPMethod method,
+                                                  Params* params) const {
+  const Node& node = nodes_[nodeIdx];
+  if (rest.empty()) {
+    auto result = matchTerminals(node, method);
+    if (result == kNoMatch && node.wildcardChild != kNone) {
+      // "/static/*path" also serves "/static/" with an empty capture
+      const Node& wildcard = nodes_[node.wildcardChild];
+      result = matchTerminals(wildcard, method);
+      if (result != kNoMatch && params && params->count < Params::kMaxParams) {
+        params->entries[params->count++] = {label(wildcard),
+                                            folly::StringPiece()};
+      }
+    }
+    return result;
+  }
+
+  auto slash = rest.find('/');
+  auto segment =
+      (slash == std::string::npos) ? rest : rest.subpiece(0, slash);
+  auto next = (slash == std::string::npos) ? folly::StringPiece()
+                                           : rest.subpiece(slash + 1);
+  if (segment.empty()) {
+    // leading slash or duplicate slashes
+    return matchNode(nodeIdx, next, method, params);
+  }
+
+  // literal children are sorted by label: binary search
+  uint32_t lo = node.firstChild;
+  uint32_t hi = node.firstChild + node.numChildren;
+  while (lo < hi) {
+    const uint32_t mid = lo + (hi - lo) / 2;
+    const auto childLabel = label(nodes_[mid]);
+    if (childLabel == segment) {
+      auto result = matchNode(mid, next, method, params);
+      if (result != kNoMatch) {
+        return result;
+      }
+      break;
+    } else if (childLabel < segment) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  if (node.paramChild != kNone) {
+    const size_t savedCount = params ? params->count : 0;
+    if (params && params->count < Params::kMaxParams) {
+      params->entries[params->count++] = {label(nodes_[node.paramChild]),
+                                          segment};
+    }
+    auto result = matchNode(node.paramChild, next, method, params);
+    if (result != kNoMatch) {
+      return result;
+    }
+    if (params) {
+      params->count = savedCount; // undo the capture on backtrack
+    }
+  }
+
+  if (node.wildcardChild != kNone) {
+    const Node& wildcard = nodes_[node.wildcardChild];
+    auto result = matchTerminals(wildcard, method);
+    if (result != kNoMatch) {
+      if (params && params->count < Params::kMaxParams) {
+        params->entries[params->count++] = {label(wildcard), rest};
+      }
+      return result;
+    }
+  }
+
+  return kNoMatch;
+}
+
+RequestRouter::HandlerId RequestRouter::match(HTTPMethod method,
+                                              folly::StringPiece path,
+                                              Params* params) const {
+  DCHECK(compiled_) << "match() before compile()";
+  if (nodes_.empty()) {
+    return kNoMatch;
+  }
+  return matchNode(0, path, method, params);
+}
+
+RequestRouter::HandlerId RequestRouter::match(const HTTPMessage& msg,
+                                              Params* params) const {
+  auto method = msg.getMethod();
+  if (!method) {
+    return kNoMatch;
+  }
+  return match(*method, msg.getPathAsStringPiece(), params);
+}
+
+} // namespace proxygen
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <folly/Range.h>
+#include <proxygen/lib/http/HTTPMessage.h>
+#include <proxygen/lib/http/HTTPMethod.h>
+#include <string>
+#include <vector>
+
+namespace proxygen {
+
+/**
+ * Compiled method+path router for RequestHandlerFactory dispatch.
+ *
+ * Routes are registered at startup and compile() flattens them into an
+ * array-backed radix trie; after that, match() walks the trie with no
+ * allocation per request and hands captured parameters back as
+ * StringPieces into the request path.
+ *
+ * Pattern syntax, one segment per path component:
+ *   /users/:id/posts      ":id" captures exactly one segment
+ *   /static/*path         "*path" captures the rest of the path and
+ *                         must be the last segment
+ * Literal segments take precedence over a parameter, which takes
+ * precedence over a wildcard.  Patterns are matched against
+ * HTTPMessage::getPathAsStringPiece(), i.e. without the query string.
+ *
+ * Typical use inside a RequestHandlerFactory:
+ *
+ *   RequestHandler* onRequest(RequestHandler*, HTTPMessage* msg) noexcept {
+ *     RequestRouter::Params params;
+ *     auto route = router_.match(*msg, &params);
+ *     if (route == RequestRouter::kNoMatch) {
+ *       return new NotFoundHandler();
+ *     }
+ *     return makeHandler(route, params);
+ *   }
+ *
+ * Not thread safe during setup; immutable (and freely shared across
+ * workers) once compile() has run.
+ */
+class RequestRouter {
+ public:
+  using HandlerId = size_t;
+  static constexpr HandlerId kNoMatch = ~HandlerId(0);
+
+  /**
+   * Parameters captured by one match.  Fixed capacity so matching never
+   * allocates; the StringPieces point into the path passed to match()
+   * and are only valid as long as it is.
+   */
+  struct Params {
+    static constexpr size_t kMaxParams = 8;
+
+    folly::StringPiece get(folly::StringPiece name) const {
+      for (size_t i = 0; i < count; i++) {
+        if (entries[i].first == name) {
+          return entries[i].second;
+        }
+      }
+      return folly::StringPiece();
+    }
+
+    std::array<std::pair<folly::StringPiece, folly::StringPiece>, kMaxParams>
+        entries;
+    size_t count{0};
+  };
+
+  /**
+   * Register a route; patterns with more than Params::kMaxParams
+   * captures, a non-trailing wildcard, or registered after compile()
+   * are rejected with a CHECK since they are startup-time programming
+   * errors.
+   */
+  void addRoute(HTTPMethod method, folly::StringPiece pattern, HandlerId id);
+
+  /**
+   * Compile registered routes into the flat trie.  Call once, after the
+   * last addRoute() and before the first match().
+   */
+  void compile();
+
+  /**
+   * Match a method+path against the compiled routes.  Returns the
+   * HandlerId of the best route, or kNoMatch.  Captures are appended to
+   * *params if it is non-null.
+   */
+  HandlerId match(HTTPMethod method,
+                  folly::StringPiece path,
+                  Params* params = nullptr) const;
+
+  /**
+   * Convenience overload matching on the message's method and path.
+   * Requests without a recognized method never match.
+   */
+  HandlerId match(const HTTPMessage& msg, Params* params = nullptr) const;
+
+ private:
+  static constexpr uint32_t kNone = ~uint32_t(0);
+
+  struct Terminal {
+    HTTPMethod method;
+    HandlerId id;
+  };
+
+  // Flat trie node: literal children are contiguous in nodes_ and
+  // sorted by label so lookup is a binary search; labels and capture
+  // names live in the shared labels_ pool.
+  struct Node {
+    uint32_t labelOffset{0};
+    uint32_t labelLength{0};
+    uint32_t firstChild{0};
+    uint32_t numChildren{0};
+    uint32_t paramChild{kNone};
+    uint32_t wildcardChild{kNone};
+    uint32_t firstTerminal{0};
+    uint32_t numTerminals{0};
+  };
+
+  struct BuildNode;
+
+  folly::StringPiece label(const Node& node) const {
+    return folly::StringPiece(labels_.data() + node.labelOffset,
+                              node.labelLength);
+  }
+
+  HandlerId matchTerminals(const Node& node, HTTPMethod method) const;
+  HandlerId matchNode(uint32_t nodeIdx,
+                      folly::StringPiece rest,
+                      HTTPMethod method,
+                      Params* params) const;
+  uint32_t flatten(const BuildNode& buildNode, uint32_t nodeIdx);
+
+  struct Route {
+    HTTPMethod method;
+    std::string pattern;
+    HandlerId id;
+  };
+
+  std::vector<Route> routes_; // cleared by compile()
+  std::vector<Node> nodes_;
+  std::vector<Terminal> terminals_;
+  std::string labels_;
+  bool compiled_{false};
+};
+
+} // namespace proxygen
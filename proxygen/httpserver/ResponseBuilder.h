@@ -8,11 +8,17 @@
 
 #pragma once
 
+#include <folly/Optional.h>
 #include <folly/ScopeGuard.h>
 #include <proxygen/httpserver/ResponseHandler.h>
 
 namespace proxygen {
 
+namespace detail {
+template <typename>
+struct ResponseBuilderDependentFalse : std::false_type {};
+} // namespace detail
+
 /**
  * Helps you make responses and send them on demand.
  *
@@ -59,6 +65,13 @@ namespace proxygen {
  * ResponseBuilder(handler)
  *    .rejectUpgradeRequest() // send '400 Bad Request'
  *
+ * The headers are built in place in the builder (no per-response heap
+ * allocation) and body data moves through untouched: IOBuf chains are
+ * chained, and a std::string rvalue is adopted without copying its
+ * characters.  Anything else passed to body() is stringified and copied.
+ * Compiling with -DPROXYGEN_RESPONSE_BUILDER_STRICT_ZERO_COPY turns that
+ * copying fallback into a compile error, which makes accidental copies on
+ * hot send paths visible at build time.
  */
 class ResponseBuilder {
  public:
@@ -66,7 +79,7 @@ class ResponseBuilder {
   }
 
   ResponseBuilder& promise(const std::string& url, const std::string& host) {
-    headers_ = std::make_unique<HTTPMessage>();
+    headers_.emplace();
     headers_->setHTTPVersion(1, 1);
     headers_->setURL(url);
     headers_->getHeaders().set(HTTP_HEADER_HOST, host);
@@ -82,7 +95,7 @@ class ResponseBuilder {
   }
 
   ResponseBuilder& status(uint16_t code, const std::string& message) {
-    headers_ = std::make_unique<HTTPMessage>();
+    headers_.emplace();
     headers_->setHTTPVersion(1, 1);
     headers_->setStatusCode(code);
     headers_->setStatusMessage(message);
@@ -115,8 +128,22 @@ class ResponseBuilder {
     return *this;
   }
 
+  /**
+   * Adopts the string's buffer as the body with no copy of the
+   * characters; the IOBuf takes ownership of the moved-in string.
+   */
+  ResponseBuilder& body(std::string&& bodyIn) {
+    return body(folly::IOBuf::fromString(std::move(bodyIn)));
+  }
+
   template <typename T>
   ResponseBuilder& body(T&& t) {
+#ifdef PROXYGEN_RESPONSE_BUILDER_STRICT_ZERO_COPY
+    static_assert(detail::ResponseBuilderDependentFalse<T>::value,
+                  "ResponseBuilder::body copies this argument; pass a "
+                  "std::unique_ptr<folly::IOBuf> chain or a std::string&& "
+                  "for a zero-copy send");
+#endif
     return body(folly::IOBuf::maybeCopyBuffer(
         folly::to<std::string>(std::forward<T>(t))));
   }
@@ -130,6 +157,11 @@ class ResponseBuilder {
     return *this;
   }
 
+  ResponseBuilder& trailers(HTTPHeaders&& trailers) {
+    trailers_.reset(new HTTPHeaders(std::move(trailers)));
+    return *this;
+  }
+
   void sendWithEOM() {
     sendEOM_ = true;
     send();
@@ -193,7 +225,7 @@ class ResponseBuilder {
 
   void acceptUpgradeRequest(UpgradeType upgradeType,
                             const std::string upgradeProtocol = "") {
-    headers_ = std::make_unique<HTTPMessage>();
+    headers_.emplace();
     if (upgradeType == UpgradeType::CONNECT_REQUEST) {
       headers_->constructDirectResponse({1, 1}, 200, "OK");
     } else {
@@ -206,7 +238,7 @@ class ResponseBuilder {
   }
 
   void rejectUpgradeRequest() {
-    headers_ = std::make_unique<HTTPMessage>();
+    headers_.emplace();
     headers_->constructDirectResponse({1, 1}, 400, "Bad Request");
     txn_->sendHeaders(*headers_);
     txn_->sendEOM();
@@ -218,13 +250,14 @@ class ResponseBuilder {
   }
 
   const HTTPMessage* getHeaders() const {
-    return headers_.get();
+    return headers_ ? &headers_.value() : nullptr;
   }
 
  private:
   ResponseHandler* const txn_{nullptr};
 
-  std::unique_ptr<HTTPMessage> headers_;
+  // In-place; building a response does not heap-allocate the message
+  folly::Optional<HTTPMessage> headers_;
   std::unique_ptr<folly::IOBuf> body_;
   std::unique_ptr<HTTPHeaders> trailers_;
 
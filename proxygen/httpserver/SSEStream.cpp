@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/httpserver/SSEStream.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace proxygen {
+
+SSEStream::SSEStream(ResponseHandler* handler,
+                     folly::EventBase* evb,
+                     std::chrono::milliseconds keepaliveInterval)
+    : folly::AsyncTimeout(evb),
+      handler_(handler),
+      evb_(evb),
+      keepaliveInterval_(keepaliveInterval) {
+  armKeepalive();
+}
+
+SSEStream::~SSEStream() {
+  cancelLoopCallback();
+  cancelTimeout();
+}
+
+void SSEStream::sendEvent(folly::StringPiece data,
+                          folly::StringPiece event,
+                          folly::StringPiece id) {
+  if (!event.empty()) {
+    appendField("event", event);
+  }
+  if (!id.empty()) {
+    appendField("id", id);
+  }
+  // one data: line per payload line, per the SSE framing rules
+  while (true) {
+    auto pos = data.find('\n');
+    if (pos == folly::StringPiece::npos) {
+      appendField("data", data);
+      break;
+    }
+    appendField("data", data.subpiece(0, pos));
+    data.advance(pos + 1);
+  }
+  appendRaw("\n");
+  scheduleFlush();
+}
+
+void SSEStream::sendComment(folly::StringPiece text) {
+  appendRaw(": ");
+  appendRaw(text);
+  appendRaw("\n\n");
+  scheduleFlush();
+}
+
+void SSEStream::flush() {
+  cancelLoopCallback();
+  if (paused_ || buf_.empty()) {
+    return;
+  }
+  handler_->sendBody(buf_.move());
+  // idle is measured from the last bytes actually sent
+  armKeepalive();
+}
+
+void SSEStream::onEgressPaused() {
+  paused_ = true;
+  cancelLoopCallback();
+  cancelTimeout();
+}
+
+void SSEStream::onEgressResumed() {
+  paused_ = false;
+  if (!buf_.empty()) {
+    scheduleFlush();
+  } else {
+    armKeepalive();
+  }
+}
+
+void SSEStream::runLoopCallback() noexcept {
+  flush();
+}
+
+void SSEStream::timeoutExpired() noexcept {
+  // only fires when nothing was flushed for a full interval; the
+  // comment is invisible to SSE consumers but keeps middleboxes from
+  // reaping the idle connection
+  sendComment("keepalive");
+  flush();
+}
+
+void SSEStream::scheduleFlush() {
+  if (!paused_ && !isLoopCallbackScheduled()) {
+    evb_->runInLoop(this);
+  }
+}
+
+void SSEStream::armKeepalive() {
+  if (keepaliveInterval_.count() > 0) {
+    scheduleTimeout(keepaliveInterval_);
+  }
+}
+
+void SSEStream::appendField(folly::StringPiece field, folly::StringPiece value) {
+  appendRaw(field);
+  appendRaw(": ");
+  appendRaw(value);
+  appendRaw("\n");
+}
+
+void SSEStream::appendRaw(folly::StringPiece bytes) {
+  while (!bytes.empty()) {
+    auto space = buf_.preallocate(
+        std::min<size_t>(bytes.size(), kMinEgressChunk), kEgressSlabSize);
+    auto copied = std::min<size_t>(space.second, bytes.size());
+    memcpy(space.first, bytes.data(), copied);
+    buf_.postallocate(copied);
+    bytes.advance(copied);
+  }
+}
+
+} // namespace proxygen
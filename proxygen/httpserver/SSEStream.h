@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+
+#include <folly/Range.h>
+#include <folly/io/IOBufQueue.h>
+#include <folly/io/async/AsyncTimeout.h>
+#include <folly/io/async/EventBase.h>
+
+#include <proxygen/httpserver/ResponseHandler.h>
+
+namespace proxygen {
+
+/**
+ * Egress helper for server-sent-events responses.
+ *
+ * sendEvent() writes the `event:`/`id:`/`data:` framing directly into
+ * the pending egress buffer -- no per-event string concatenation or
+ * per-event IOBuf -- and flushes once per event loop tick, so all
+ * events queued within a tick coalesce into a single sendBody() call.
+ * While the transaction is egress-paused (forward the handler's
+ * onEgressPaused/onEgressResumed here) events keep accumulating and the
+ * flush happens on resume.  On idle, a `: keepalive` comment is emitted
+ * on the configured interval so intermediaries do not reap the
+ * connection; the timer re-arms off the last flush and is suppressed
+ * while paused.
+ *
+ * The stream does not own the handler: send the response headers
+ * (content-type text/event-stream) and the final EOM through the usual
+ * paths, and destroy the stream no later than the handler.  Must be
+ * used only from the given EventBase's thread.
+ */
+class SSEStream
+    : private folly::EventBase::LoopCallback
+    , private folly::AsyncTimeout {
+ public:
+  /**
+   * keepaliveInterval of zero disables the idle keepalive.
+   */
+  SSEStream(ResponseHandler* handler,
+            folly::EventBase* evb,
+            std::chrono::milliseconds keepaliveInterval =
+                std::chrono::milliseconds(15000));
+
+  ~SSEStream() override;
+
+  /**
+   * Queue one event.  Multi-line data is framed as one `data:` line per
+   * line; `event:` and `id:` lines are omitted when empty.
+   */
+  void sendEvent(folly::StringPiece data,
+                 folly::StringPiece event = folly::StringPiece(),
+                 folly::StringPiece id = folly::StringPiece());
+
+  /**
+   * Queue a comment line (`: <text>`), e.g. an application-level
+   * heartbeat.
+   */
+  void sendComment(folly::StringPiece text);
+
+  /**
+   * Flush the pending buffer now instead of waiting for the loop tick.
+   * No-op while paused or when nothing is pending.
+   */
+  void flush();
+
+  /**
+   * Egress pause integration; forward from the request handler's
+   * onEgressPaused/onEgressResumed callbacks.
+   */
+  void onEgressPaused();
+  void onEgressResumed();
+
+  /**
+   * Bytes framed but not yet flushed; grows while paused.
+   */
+  size_t getBufferedBytes() const {
+    return buf_.chainLength();
+  }
+
+ private:
+  void runLoopCallback() noexcept override;
+  void timeoutExpired() noexcept override;
+
+  void scheduleFlush();
+  void armKeepalive();
+  void appendField(folly::StringPiece field, folly::StringPiece value);
+  void appendRaw(folly::StringPiece bytes);
+
+  // preallocate/postallocate slab sizing for the pending buffer: one
+  // allocation per flush in the common case, never one per event
+  static constexpr size_t kEgressSlabSize = 4096;
+  static constexpr size_t kMinEgressChunk = 256;
+
+  ResponseHandler* handler_;
+  folly::EventBase* evb_;
+  std::chrono::milliseconds keepaliveInterval_;
+  folly::IOBufQueue buf_{folly::IOBufQueue::cacheChainLength()};
+  bool paused_{false};
+};
+
+} // namespace proxygen
@@ -10,9 +10,13 @@
 
 #include <boost/thread.hpp>
 #include <chrono>
+#include <folly/executors/IOThreadPoolExecutor.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
+#include <folly/io/async/AsyncServerSocket.h>
 #include <folly/io/async/SSLContext.h>
 #include <folly/system/ThreadName.h>
 #include <proxygen/httpserver/HTTPServer.h>
+#include <proxygen/httpserver/HTTPServerAcceptor.h>
 #include <proxygen/httpserver/ResponseBuilder.h>
 
 namespace proxygen {
@@ -94,6 +98,37 @@ class ScopedHandlerFactory : public RequestHandlerFactory {
  */
 class ScopedHTTPServer final {
  public:
+  /**
+   * A persistent, pre-warmed worker pool that many scoped servers can
+   * attach to.  Each start() spins up its own threads, which dominates
+   * wall time when a test suite creates hundreds of short-lived servers;
+   * create one WorkerPool per process instead and use startShared():
+   * servers then just bind an ephemeral port and hook acceptors onto the
+   * existing event bases, no thread is spawned or joined per server.
+   *
+   * The pool must outlive every server attached to it.  startShared()
+   * and the servers' destructors must not run on the pool's own threads.
+   */
+  class WorkerPool {
+   public:
+    explicit WorkerPool(size_t numThreads = 4)
+        : executor_(std::make_shared<folly::IOThreadPoolExecutor>(
+              numThreads,
+              std::make_shared<folly::NamedThreadFactory>("ScopedHTTPSrv"))) {
+      for (auto& ka : executor_->getAllEventBases()) {
+        evbs_.push_back(ka.get());
+      }
+    }
+
+    const std::vector<folly::EventBase*>& getEventBases() const {
+      return evbs_;
+    }
+
+   private:
+    std::shared_ptr<folly::IOThreadPoolExecutor> executor_;
+    std::vector<folly::EventBase*> evbs_;
+  };
+
   /**
    * Start a server listening on the requested `port`.
    * If `port` is 0, it will choose a random port.
@@ -112,6 +147,25 @@ class ScopedHTTPServer final {
   static std::unique_ptr<ScopedHTTPServer> start(HTTPServer::IPConfig cfg,
                                                  HTTPServerOptions options);
 
+  /**
+   * Like start(), but attached to a shared WorkerPool: one acceptor per
+   * pool thread, connections fanned out round-robin, and nothing spawned
+   * per server.  options.threads is ignored.  Note that unlike start(),
+   * no HTTPServer is constructed, so the filters HTTPServer's
+   * constructor injects (CONNECT rejection, content compression) only
+   * apply if put in options.handlerFactories explicitly.
+   */
+  template <typename HandlerType>
+  static std::unique_ptr<ScopedHTTPServer> startShared(
+      WorkerPool& pool,
+      HandlerType handler,
+      int port = 0,
+      std::unique_ptr<wangle::SSLContextConfig> sslCfg = nullptr,
+      std::chrono::milliseconds idleTimeoutMs = std::chrono::milliseconds(0));
+
+  static std::unique_ptr<ScopedHTTPServer> startShared(
+      WorkerPool& pool, HTTPServer::IPConfig cfg, HTTPServerOptions options);
+
   /**
    * Get the port the server is listening on. This is helpful if the port was
    * randomly chosen.
@@ -124,12 +178,19 @@ class ScopedHTTPServer final {
    * Get the addresses for the server.
    */
   std::vector<HTTPServer::IPConfig> getAddresses() const {
+    if (shared_) {
+      return {shared_->ipConfig};
+    }
     auto addresses = server_->addresses();
     CHECK(!addresses.empty());
     return addresses;
   }
 
   ~ScopedHTTPServer() {
+    if (shared_) {
+      stopShared();
+      return;
+    }
     server_->stop();
     thread_.join();
   }
@@ -139,8 +200,31 @@ class ScopedHTTPServer final {
       : thread_(std::move(thread)), server_(std::move(server)) {
   }
 
+  /**
+   * State of a server attached to a shared WorkerPool: the acceptors
+   * (one per pool thread, each living on its event base) and the listen
+   * socket, which lives on the first worker's event base.  The options
+   * are shared because HTTPServerAcceptor keeps a reference to them.
+   */
+  struct SharedState {
+    std::shared_ptr<HTTPServerOptions> options;
+    std::vector<std::unique_ptr<HTTPServerAcceptor>> acceptors;
+    std::vector<folly::EventBase*> evbs;
+    std::shared_ptr<folly::AsyncServerSocket> socket;
+    folly::EventBase* acceptEvb{nullptr};
+    HTTPServer::IPConfig ipConfig{folly::SocketAddress(),
+                                  HTTPServer::Protocol::HTTP};
+  };
+
+  explicit ScopedHTTPServer(std::unique_ptr<SharedState> shared)
+      : shared_(std::move(shared)) {
+  }
+
+  void stopShared();
+
   std::thread thread_;
   std::unique_ptr<HTTPServer> server_;
+  std::unique_ptr<SharedState> shared_;
 };
 
 template <typename HandlerType>
@@ -220,4 +304,97 @@ inline std::unique_ptr<ScopedHTTPServer> ScopedHTTPServer::start(
       new ScopedHTTPServer(std::move(t), std::move(server)));
 }
 
+template <typename HandlerType>
+inline std::unique_ptr<ScopedHTTPServer> ScopedHTTPServer::startShared(
+    WorkerPool& pool,
+    HandlerType handler,
+    int port,
+    std::unique_ptr<wangle::SSLContextConfig> sslCfg,
+    std::chrono::milliseconds idleTimeoutMs) {
+  folly::SocketAddress addr;
+  addr.setFromLocalPort(port);
+  HTTPServer::IPConfig cfg{addr, HTTPServer::Protocol::HTTP};
+  if (sslCfg) {
+    cfg.sslConfigs.push_back(*sslCfg);
+  }
+
+  HTTPServerOptions options;
+  options.handlerFactories.push_back(
+      std::make_unique<ScopedHandlerFactory<HandlerType>>(handler));
+  if (idleTimeoutMs.count() > 0) {
+    options.idleTimeout = idleTimeoutMs;
+  }
+  return startShared(pool, std::move(cfg), std::move(options));
+}
+
+inline std::unique_ptr<ScopedHTTPServer> ScopedHTTPServer::startShared(
+    WorkerPool& pool, HTTPServer::IPConfig cfg, HTTPServerOptions options) {
+  auto state = std::make_unique<SharedState>();
+  state->options =
+      std::make_shared<HTTPServerOptions>(std::move(options));
+  auto accConfig = HTTPServerAcceptor::makeConfig(cfg, *state->options);
+
+  // One acceptor per pre-warmed worker, brought up on its own loop, the
+  // same way HTTPServer's AcceptorFactory does on freshly spawned threads
+  for (auto* evb : pool.getEventBases()) {
+    evb->runInEventBaseThreadAndWait([&] {
+      auto acceptor =
+          HTTPServerAcceptor::make(accConfig, *state->options, cfg.codecFactory);
+      acceptor->init(nullptr, evb);
+      for (auto& factory : state->options->handlerFactories) {
+        factory->onServerStart(evb);
+      }
+      state->acceptors.push_back(std::move(acceptor));
+      state->evbs.push_back(evb);
+    });
+  }
+
+  // The listen socket lives on the first worker; accepted connections
+  // are handed round-robin to every acceptor's event base
+  state->acceptEvb = state->evbs.front();
+  std::exception_ptr eptr;
+  state->acceptEvb->runInEventBaseThreadAndWait([&] {
+    try {
+      state->socket = folly::AsyncServerSocket::newSocket(state->acceptEvb);
+      state->socket->bind(cfg.address);
+      state->socket->listen(accConfig.acceptBacklog);
+      for (size_t i = 0; i < state->acceptors.size(); i++) {
+        state->socket->addAcceptCallback(state->acceptors[i].get(),
+                                         state->evbs[i]);
+      }
+      state->socket->startAccepting();
+      state->socket->getAddress(&cfg.address);
+    } catch (...) {
+      eptr = std::current_exception();
+    }
+  });
+  state->ipConfig = std::move(cfg);
+
+  auto server =
+      std::unique_ptr<ScopedHTTPServer>(new ScopedHTTPServer(std::move(state)));
+  if (eptr) {
+    // ~ScopedHTTPServer tears the acceptors back down
+    server.reset();
+    std::rethrow_exception(eptr);
+  }
+  return server;
+}
+
+inline void ScopedHTTPServer::stopShared() {
+  auto& state = *shared_;
+  if (state.socket) {
+    state.acceptEvb->runInEventBaseThreadAndWait(
+        [&] { state.socket.reset(); });
+  }
+  for (size_t i = 0; i < state.acceptors.size(); i++) {
+    state.evbs[i]->runInEventBaseThreadAndWait([&, i] {
+      state.acceptors[i]->dropAllConnections();
+      for (auto& factory : state.options->handlerFactories) {
+        factory->onServerStop();
+      }
+      state.acceptors[i].reset();
+    });
+  }
+}
+
 } // namespace proxygen
@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/httpserver/ServerHandoff.h>
+
+#include <cstring>
+#include <thread>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <folly/ScopeGuard.h>
+#include <glog/logging.h>
+
+namespace proxygen { namespace handoff {
+
+namespace {
+
+// wire format: header, then payloadLength bytes of payload; the fds ride
+// in a single SCM_RIGHTS control message attached to the header
+struct HandoffHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t numFds;
+  uint32_t payloadLength;
+};
+
+constexpr uint32_t kHandoffMagic = 0x50474841; // "PGHA"
+constexpr uint32_t kHandoffVersion = 1;
+// SCM_MAX_FD; more listening sockets than this calls for a different
+// deployment scheme anyway
+constexpr size_t kMaxHandoffFds = 253;
+
+bool makeUnixAddress(const std::string& path, struct sockaddr_un& addr) {
+  if (path.size() >= sizeof(addr.sun_path)) {
+    LOG(ERROR) << "Handoff socket path too long: " << path;
+    return false;
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path, path.data(), path.size());
+  return true;
+}
+
+bool waitReadable(int fd, std::chrono::milliseconds timeout) {
+  struct pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  int rc;
+  do {
+    rc = poll(&pfd, 1, static_cast<int>(timeout.count()));
+  } while (rc < 0 && errno == EINTR);
+  return rc > 0 && (pfd.revents & POLLIN);
+}
+
+bool readFull(int fd, void* buf, size_t len) {
+  auto* p = static_cast<char*>(buf);
+  while (len > 0) {
+    ssize_t rc = recv(fd, p, len, 0);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc <= 0) {
+      return false;
+    }
+    p += rc;
+    len -= rc;
+  }
+  return true;
+}
+
+} // namespace
+
+bool exportListenSockets(const std::string& path,
+                         const std::vector<int>& fds,
+                         const std::string& payload,
+                         std::chrono::milliseconds timeout) {
+  if (fds.empty() || fds.size() > kMaxHandoffFds) {
+    LOG(ERROR) << "Cannot hand off " << fds.size() << " fds";
+    return false;
+  }
+  struct sockaddr_un addr;
+  if (!makeUnixAddress(path, addr)) {
+    return false;
+  }
+
+  int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listenFd < 0) {
+    PLOG(ERROR) << "Failed to create handoff socket";
+    return false;
+  }
+  SCOPE_EXIT {
+    close(listenFd);
+    unlink(path.c_str());
+  };
+  // a stale socket file from a crashed predecessor would fail the bind
+  unlink(path.c_str());
+  if (bind(listenFd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) <
+          0 ||
+      listen(listenFd, 1) < 0) {
+    PLOG(ERROR) << "Failed to bind handoff socket at " << path;
+    return false;
+  }
+
+  if (!waitReadable(listenFd, timeout)) {
+    LOG(WARNING) << "No successor connected to " << path << " within "
+                 << timeout.count() << "ms";
+    return false;
+  }
+  int peerFd = accept(listenFd, nullptr, nullptr);
+  if (peerFd < 0) {
+    PLOG(ERROR) << "Failed to accept successor on " << path;
+    return false;
+  }
+  SCOPE_EXIT {
+    close(peerFd);
+  };
+
+  HandoffHeader header;
+  header.magic = kHandoffMagic;
+  header.version = kHandoffVersion;
+  header.numFds = fds.size();
+  header.payloadLength = payload.size();
+
+  struct iovec iov[2];
+  iov[0].iov_base = &header;
+  iov[0].iov_len = sizeof(header);
+  iov[1].iov_base = const_cast<char*>(payload.data());
+  iov[1].iov_len = payload.size();
+
+  std::vector<char> cmsgBuf(CMSG_SPACE(fds.size() * sizeof(int)));
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = iov;
+  msg.msg_iovlen = payload.empty() ? 1 : 2;
+  msg.msg_control = cmsgBuf.data();
+  msg.msg_controllen = cmsgBuf.size();
+
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(fds.size() * sizeof(int));
+  memcpy(CMSG_DATA(cmsg), fds.data(), fds.size() * sizeof(int));
+
+  ssize_t rc;
+  do {
+    rc = sendmsg(peerFd, &msg, 0);
+  } while (rc < 0 && errno == EINTR);
+  if (rc < 0) {
+    PLOG(ERROR) << "Failed to send handoff message";
+    return false;
+  }
+  VLOG(2) << "Handed off " << fds.size() << " listen sockets via " << path;
+  return true;
+}
+
+folly::Optional<HandoffData> importListenSockets(
+    const std::string& path, std::chrono::milliseconds timeout) {
+  struct sockaddr_un addr;
+  if (!makeUnixAddress(path, addr)) {
+    return folly::none;
+  }
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    PLOG(ERROR) << "Failed to create handoff socket";
+    return folly::none;
+  }
+  SCOPE_EXIT {
+    close(fd);
+  };
+
+  // The predecessor may not have opened the socket yet (deploy tooling
+  // usually signals it and starts us concurrently), so retry the connect
+  // until the deadline
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) <
+         0) {
+    if (errno != ENOENT && errno != ECONNREFUSED && errno != EINTR) {
+      PLOG(ERROR) << "Failed to connect to handoff socket at " << path;
+      return folly::none;
+    }
+    if (std::chrono::steady_clock::now() >= deadline) {
+      LOG(WARNING) << "No predecessor at " << path << " within "
+                   << timeout.count() << "ms";
+      return folly::none;
+    }
+    /* sleep override */
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+
+  HandoffHeader header;
+  struct iovec iov;
+  iov.iov_base = &header;
+  iov.iov_len = sizeof(header);
+
+  std::vector<char> cmsgBuf(CMSG_SPACE(kMaxHandoffFds * sizeof(int)));
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = cmsgBuf.data();
+  msg.msg_controllen = cmsgBuf.size();
+
+  ssize_t rc;
+  do {
+    rc = recvmsg(fd, &msg, MSG_WAITALL);
+  } while (rc < 0 && errno == EINTR);
+  if (rc != sizeof(header) || header.magic != kHandoffMagic ||
+      header.version != kHandoffVersion || header.numFds == 0 ||
+      header.numFds > kMaxHandoffFds) {
+    LOG(ERROR) << "Malformed handoff message from " << path;
+    return folly::none;
+  }
+
+  HandoffData result;
+  for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+      const size_t n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      const int* cmsgFds = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
+      result.fds.insert(result.fds.end(), cmsgFds, cmsgFds + n);
+    }
+  }
+  if (result.fds.size() != header.numFds) {
+    LOG(ERROR) << "Expected " << header.numFds << " fds, received "
+               << result.fds.size();
+    for (auto received : result.fds) {
+      close(received);
+    }
+    return folly::none;
+  }
+
+  if (header.payloadLength > 0) {
+    result.payload.resize(header.payloadLength);
+    if (!readFull(fd, &result.payload[0], header.payloadLength)) {
+      PLOG(ERROR) << "Failed to read handoff payload";
+      for (auto received : result.fds) {
+        close(received);
+      }
+      return folly::none;
+    }
+  }
+  VLOG(2) << "Received " << result.fds.size() << " listen sockets via "
+          << path;
+  return result;
+}
+
+}} // namespace proxygen::handoff
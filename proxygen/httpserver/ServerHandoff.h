@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <folly/Optional.h>
+
+namespace proxygen { namespace handoff {
+
+/**
+ * Zero-downtime restart support: a retiring server process exports its
+ * listening file descriptors (and a small opaque payload) to a successor
+ * process over a unix domain socket, using SCM_RIGHTS.  The successor
+ * installs the descriptors via HTTPServerOptions::useExistingSockets and
+ * starts accepting before the predecessor stops listening, so the kernel
+ * accept queue is never torn down and no SYN is dropped.
+ *
+ * The payload is application-defined; the intended use is the filename of
+ * the process's PersistentFizzPskCache (or other file-backed TLS
+ * resumption state), so the successor reopens the same warm cache instead
+ * of cold-starting resumption and paying a handshake-CPU spike.
+ */
+
+/**
+ * What a successor receives from its predecessor.  The fds are owned by
+ * the caller, who should hand them to HTTPServerOptions::useExistingSockets
+ * (which adopts them) or close them.
+ */
+struct HandoffData {
+  std::vector<int> fds;
+  std::string payload;
+};
+
+/**
+ * Predecessor side: listen on the unix socket at path, wait up to timeout
+ * for the successor to connect, and send it every fd plus the payload.
+ * The fds are duplicated by the kernel, so the caller still owns (and
+ * should eventually close) its copies - HTTPServer::stopListening does
+ * that for sockets owned by a server.
+ *
+ * Blocks the calling thread; run it from a deploy/signal thread, not an
+ * IO thread.  Returns false on timeout or socket error, in which case
+ * the caller should keep serving as if no restart were happening.
+ */
+bool exportListenSockets(const std::string& path,
+                         const std::vector<int>& fds,
+                         const std::string& payload,
+                         std::chrono::milliseconds timeout);
+
+/**
+ * Successor side: connect to the unix socket at path (retrying until
+ * timeout, since the predecessor may not have opened it yet) and receive
+ * the descriptors and payload.  Returns none on timeout or a malformed
+ * message; the successor should then bind its addresses from scratch.
+ */
+folly::Optional<HandoffData> importListenSockets(
+    const std::string& path, std::chrono::milliseconds timeout);
+
+}} // namespace proxygen::handoff
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/httpserver/StatsEndpointHandler.h>
+
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdio>
+#include <folly/Conv.h>
+
+namespace {
+
+// snprintf-append into buf at pos, never writing past cap; returns the
+// new position, saturated at cap on truncation
+size_t appendf(char* buf, size_t pos, size_t cap, const char* fmt, ...) {
+  if (pos >= cap) {
+    return cap;
+  }
+  va_list args;
+  va_start(args, fmt);
+  int written = vsnprintf(buf + pos, cap - pos, fmt, args);
+  va_end(args);
+  if (written < 0) {
+    return pos;
+  }
+  return std::min(pos + size_t(written), cap);
+}
+
+} // namespace
+
+namespace proxygen {
+
+StatsEndpointHandler::StatsEndpointHandler(ResourceStats* stats)
+    : stats_(stats) {
+}
+
+StatsEndpointHandler::~StatsEndpointHandler() {
+}
+
+size_t StatsEndpointHandler::writeStatsText(const ResourceData& data,
+                                            char* buf,
+                                            size_t cap) {
+  size_t pos = 0;
+  pos = appendf(
+      buf, pos, cap, "cpu_util_ratio %.4f\n", data.getCpuRatioUtil());
+  pos = appendf(buf,
+                pos,
+                cap,
+                "cpu_softirq_util_ratio %.4f\n",
+                data.getSoftIrqCpuRatioUtil());
+  const auto& cores = data.getSoftIrqCpuCoreRatioUtils();
+  for (size_t i = 0; i < cores.size(); i++) {
+    pos = appendf(buf,
+                  pos,
+                  cap,
+                  "cpu_core_softirq_util_ratio{core=\"%zu\"} %.4f\n",
+                  i,
+                  cores[i]);
+  }
+  pos = appendf(buf,
+                pos,
+                cap,
+                "mem_used_bytes %" PRIu64 "\n",
+                data.getUsedMemBytes());
+  pos = appendf(buf,
+                pos,
+                cap,
+                "mem_total_bytes %" PRIu64 "\n",
+                data.getTotalMemBytes());
+  if (data.tcpMemoryStatsCollected()) {
+    pos = appendf(buf,
+                  pos,
+                  cap,
+                  "tcp_mem_pages %" PRIu64 "\n",
+                  data.getTcpMemPages());
+    pos = appendf(buf,
+                  pos,
+                  cap,
+                  "tcp_mem_limit_pages %" PRIu64 "\n",
+                  data.getMaxTcpMemLimitPages());
+  }
+  if (data.udpMemoryStatsCollected()) {
+    pos = appendf(buf,
+                  pos,
+                  cap,
+                  "udp_mem_pages %" PRIu64 "\n",
+                  data.getUdpMemPages());
+    pos = appendf(buf,
+                  pos,
+                  cap,
+                  "udp_mem_limit_pages %" PRIu64 "\n",
+                  data.getMaxUdpMemLimitPages());
+  }
+  pos = appendf(buf,
+                pos,
+                cap,
+                "stats_last_update_ms %" PRIu64 "\n",
+                uint64_t(data.getLastUpdateTime().count()));
+  return pos;
+}
+
+void StatsEndpointHandler::setTransaction(HTTPTransaction* txn) noexcept {
+  txn_ = txn;
+}
+
+void StatsEndpointHandler::detachTransaction() noexcept {
+  delete this;
+}
+
+void StatsEndpointHandler::sendResponse() {
+  responseSent_ = true;
+  size_t len = 0;
+  if (stats_) {
+    len = writeStatsText(stats_->getCurrentData(), buffer_.data(), kBufferSize);
+  }
+  HTTPMessage response;
+  response.setHTTPVersion(1, 1);
+  response.setStatusCode(200);
+  response.setStatusMessage("OK");
+  response.getHeaders().add(HTTP_HEADER_CONTENT_TYPE,
+                            "text/plain; version=0.0.4");
+  response.getHeaders().add(HTTP_HEADER_CONTENT_LENGTH,
+                            folly::to<std::string>(len));
+  txn_->sendHeaders(response);
+  if (len > 0) {
+    txn_->sendBody(folly::IOBuf::copyBuffer(buffer_.data(), len));
+  }
+}
+
+void StatsEndpointHandler::onHeadersComplete(
+    std::unique_ptr<HTTPMessage> /*msg*/) noexcept {
+  sendResponse();
+}
+
+void StatsEndpointHandler::onBody(
+    std::unique_ptr<folly::IOBuf> /*chain*/) noexcept {
+  VLOG(4) << "discarding request body";
+}
+
+void StatsEndpointHandler::onTrailers(
+    std::unique_ptr<HTTPHeaders> /*trailers*/) noexcept {
+  VLOG(4) << "discarding request trailers";
+}
+
+void StatsEndpointHandler::onEOM() noexcept {
+  eomSent_ = true;
+  txn_->sendEOM();
+}
+
+void StatsEndpointHandler::onUpgrade(UpgradeProtocol /*protocol*/) noexcept {
+}
+
+void StatsEndpointHandler::onError(const HTTPException& error) noexcept {
+  if (error.getDirection() == HTTPException::Direction::INGRESS) {
+    if (!responseSent_) {
+      sendResponse();
+    }
+    if (!eomSent_) {
+      onEOM();
+    }
+  }
+}
+
+} // namespace proxygen
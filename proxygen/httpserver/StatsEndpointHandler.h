@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <proxygen/lib/http/session/HTTPTransaction.h>
+#include <proxygen/lib/stats/ResourceStats.h>
+
+namespace proxygen {
+
+/**
+ * A built-in handler for high-frequency stats polling.  It is attached
+ * by HTTPServerAcceptor directly as the transaction handler (the same
+ * fast path HTTPDirectResponseHandler uses for error responses), so a
+ * stats poll never instantiates the RequestHandler filter chain or a
+ * RequestHandlerAdaptor.
+ *
+ * The response is a flat text exposition of the ResourceStats snapshot,
+ * formatted into an in-object buffer; the only per-request heap work is
+ * this handler and the single IOBuf carrying the body.  The snapshot
+ * itself comes from ResourceStats' RCU-refreshed thread-local data, so
+ * serving it does not touch the collection machinery.
+ *
+ * Enable via HTTPServerOptions::statsEndpointPath.
+ */
+class StatsEndpointHandler : public HTTPTransaction::Handler {
+ public:
+  explicit StatsEndpointHandler(ResourceStats* stats);
+
+  /**
+   * Format the data's metrics into buf in text exposition format,
+   * returning the number of bytes written (at most cap).
+   */
+  static size_t writeStatsText(const ResourceData& data,
+                               char* buf,
+                               size_t cap);
+
+  // HTTPTransaction::Handler methods
+  void setTransaction(HTTPTransaction* txn) noexcept override;
+  void detachTransaction() noexcept override;
+  void onHeadersComplete(std::unique_ptr<HTTPMessage> msg) noexcept override;
+  void onBody(std::unique_ptr<folly::IOBuf> chain) noexcept override;
+  void onTrailers(std::unique_ptr<HTTPHeaders> trailers) noexcept override;
+  void onEOM() noexcept override;
+  void onUpgrade(UpgradeProtocol protocol) noexcept override;
+  void onError(const HTTPException& error) noexcept override;
+  // No-ops; the response is a single small write
+  void onEgressPaused() noexcept override {
+  }
+  void onEgressResumed() noexcept override {
+  }
+
+ private:
+  ~StatsEndpointHandler() override;
+
+  void sendResponse();
+
+  // Large enough for the scalar metrics plus a per-core line on wide
+  // machines
+  static constexpr size_t kBufferSize = 32 * 1024;
+
+  HTTPTransaction* txn_{nullptr};
+  ResourceStats* const stats_;
+  bool responseSent_{false};
+  bool eomSent_{false};
+  std::array<char, kBufferSize> buffer_;
+};
+
+} // namespace proxygen
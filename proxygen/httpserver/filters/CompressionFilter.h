@@ -8,14 +8,21 @@
 
 #pragma once
 
+#include <map>
+#include <unordered_map>
+
 #include <folly/Memory.h>
+#include <folly/ThreadLocal.h>
 #include <folly/compression/Compression.h>
+#include <folly/executors/SerialExecutor.h>
+#include <folly/io/async/EventBaseManager.h>
 
 #include <proxygen/httpserver/Filters.h>
 #include <proxygen/httpserver/RequestHandlerFactory.h>
 #include <proxygen/lib/http/RFC2616.h>
 #include <proxygen/lib/utils/StreamCompressor.h>
 #include <proxygen/lib/utils/ZlibStreamCompressor.h>
+#include <proxygen/lib/utils/ZstdDictStreamCompressor.h>
 #include <proxygen/lib/utils/ZstdStreamCompressor.h>
 
 namespace proxygen {
@@ -23,26 +30,62 @@ namespace proxygen {
 /**
  * A Server filter to perform compression. If there are any errors it will
  * fall back to sending uncompressed responses.
+ *
+ * When constructed with an offload executor, body chunks at or above the
+ * offload threshold are compressed on that executor instead of the IO
+ * thread and recommitted to the session in order; smaller chunks still
+ * compress inline to avoid two thread hops per response.
  */
 class CompressionFilter : public Filter {
  public:
   using StreamCompressorFactory =
       std::function<std::unique_ptr<StreamCompressor>()>;
 
+  // Variant that receives the (lowercased, parameter-stripped) response
+  // content type, so the factory can pick e.g. a per-content-type
+  // compression dictionary
+  using ContentTypeAwareStreamCompressorFactory =
+      std::function<std::unique_ptr<StreamCompressor>(
+          folly::StringPiece contentType)>;
+
   CompressionFilter(
       RequestHandler* downstream,
       uint32_t minimumCompressionSize,
       StreamCompressorFactory factory,
       std::string headerEncoding,
-      const std::shared_ptr<std::set<std::string>> compressibleContentTypes)
+      const std::shared_ptr<std::set<std::string>> compressibleContentTypes,
+      folly::Executor::KeepAlive<> offloadExecutor = nullptr,
+      uint32_t offloadThreshold = 0)
       : Filter(downstream),
         minimumCompressionSize_(minimumCompressionSize),
         compressorFactory_(std::move(factory)),
         headerEncoding_(std::move(headerEncoding)),
-        compressibleContentTypes_(compressibleContentTypes) {
+        compressibleContentTypes_(compressibleContentTypes),
+        offloadThreshold_(offloadThreshold) {
+    initOffloadExecutor(std::move(offloadExecutor));
+  }
+
+  CompressionFilter(
+      RequestHandler* downstream,
+      uint32_t minimumCompressionSize,
+      ContentTypeAwareStreamCompressorFactory factory,
+      std::string headerEncoding,
+      const std::shared_ptr<std::set<std::string>> compressibleContentTypes,
+      folly::Executor::KeepAlive<> offloadExecutor = nullptr,
+      uint32_t offloadThreshold = 0)
+      : Filter(downstream),
+        minimumCompressionSize_(minimumCompressionSize),
+        contentTypeAwareCompressorFactory_(std::move(factory)),
+        headerEncoding_(std::move(headerEncoding)),
+        compressibleContentTypes_(compressibleContentTypes),
+        offloadThreshold_(offloadThreshold) {
+    initOffloadExecutor(std::move(offloadExecutor));
   }
 
   virtual ~CompressionFilter() override {
+    // Recommit callbacks run on this thread; anything still in flight
+    // must drop its result instead of touching the dead filter
+    *alive_ = false;
   }
 
   void sendHeaders(HTTPMessage& msg) noexcept override {
@@ -68,7 +111,9 @@ class CompressionFilter : public Filter {
     }
 
     // Initialize compressor
-    compressor_ = compressorFactory_();
+    compressor_ = contentTypeAwareCompressorFactory_
+                      ? contentTypeAwareCompressorFactory_(getContentType(msg))
+                      : compressorFactory_();
     if (!compressor_ || compressor_->hasError()) {
       return fail();
     }
@@ -97,6 +142,16 @@ class CompressionFilter : public Filter {
     return;
   }
 
+  void sendChunkTerminator() noexcept override {
+    // A terminator must trail its chunk; while that chunk is still out
+    // being compressed, hold the terminator and replay it on recommit
+    if (compress_ && (offloadsInFlight_ > 0 || !recommitQueue_.empty())) {
+      pendingTerminators_++;
+      return;
+    }
+    Filter::sendChunkTerminator();
+  }
+
   // Compress the body, if chunked may be called multiple times
   void sendBody(std::unique_ptr<folly::IOBuf> body) noexcept override {
     // If not compressing, pass the body through
@@ -108,12 +163,116 @@ class CompressionFilter : public Filter {
 
     CHECK(compressor_ && !compressor_->hasError());
 
+    if (shouldOffloadCompression(*body)) {
+      offloadCompression(std::move(body));
+      return;
+    }
+
     // If it's chunked, never write the trailer, it will be written on EOM
     auto compressed = compressor_->compress(body.get(), !chunked_);
     if (compressor_->hasError()) {
       return fail();
     }
 
+    sendCompressedBody(std::move(compressed));
+  }
+
+  void sendEOM() noexcept override {
+    if (offloadsInFlight_ > 0 || !recommitQueue_.empty()) {
+      // The EOM must trail the offloaded chunks; send it when the last
+      // one recommits
+      eomPending_ = true;
+      return;
+    }
+    sendCompressedEOM();
+  }
+
+ protected:
+  void fail() {
+    failed_ = true;
+    Filter::sendAbort();
+  }
+
+  void initOffloadExecutor(folly::Executor::KeepAlive<> executor) {
+    if (executor) {
+      // The compressor's stream state has to see chunks in order, so a
+      // response's offloads are serialized over the shared pool
+      offloadExecutor_ = folly::SerialExecutor::create(std::move(executor));
+    }
+  }
+
+  bool shouldOffloadCompression(const folly::IOBuf& body) const noexcept {
+    if (!offloadExecutor_) {
+      return false;
+    }
+    // Once a chunk is in flight, everything behind it must queue too,
+    // regardless of size: the compressor cannot see chunks out of order
+    return offloadsInFlight_ > 0 || !recommitQueue_.empty() ||
+           body.computeChainDataLength() >= offloadThreshold_;
+  }
+
+  // Compress the chunk on the offload executor and recommit the result
+  // to the session from the IO thread, in dispatch order
+  void offloadCompression(std::unique_ptr<folly::IOBuf> body) {
+    auto seq = nextSeqToDispatch_++;
+    offloadsInFlight_++;
+    auto* evb = folly::EventBaseManager::get()->getEventBase();
+    offloadExecutor_->add([this,
+                           alive = alive_,
+                           evb,
+                           seq,
+                           trailer = !chunked_,
+                           compressor = compressor_,
+                           body = std::move(body)]() mutable {
+      auto compressed = compressor->compress(body.get(), trailer);
+      auto hasError = compressor->hasError();
+      evb->runInEventBaseThread([this,
+                                 alive = std::move(alive),
+                                 seq,
+                                 hasError,
+                                 compressed =
+                                     std::move(compressed)]() mutable {
+        if (!*alive) {
+          return;
+        }
+        onChunkCompressed(seq, std::move(compressed), hasError);
+      });
+    });
+  }
+
+  void onChunkCompressed(uint64_t seq,
+                         std::unique_ptr<folly::IOBuf> compressed,
+                         bool hasError) {
+    offloadsInFlight_--;
+    recommitQueue_.emplace(seq, CompressedChunk{std::move(compressed),
+                                                hasError});
+    if (failed_) {
+      return;
+    }
+    // Recommit every chunk that is next in sequence; with the serial
+    // executor results normally arrive in order, but the queue keeps
+    // the stream correct regardless of notification order
+    while (!recommitQueue_.empty() &&
+           recommitQueue_.begin()->first == nextSeqToRecommit_) {
+      auto chunk = std::move(recommitQueue_.begin()->second);
+      recommitQueue_.erase(recommitQueue_.begin());
+      nextSeqToRecommit_++;
+      if (chunk.hasError) {
+        return fail();
+      }
+      sendCompressedBody(std::move(chunk.body));
+      if (pendingTerminators_ > 0) {
+        pendingTerminators_--;
+        Filter::sendChunkTerminator();
+      }
+    }
+    if (eomPending_ && offloadsInFlight_ == 0 && recommitQueue_.empty()) {
+      eomPending_ = false;
+      sendCompressedEOM();
+    }
+  }
+
+  void sendCompressedBody(std::unique_ptr<folly::IOBuf> compressed) {
     auto compressedBodyLength = compressed->computeChainDataLength();
 
     if (chunked_) {
@@ -134,7 +293,7 @@ class CompressionFilter : public Filter {
     Filter::sendBody(std::move(compressed));
   }
 
-  void sendEOM() noexcept override {
+  void sendCompressedEOM() {
 
     // Need to send the trailer for compressed chunked messages
     if (compress_ && chunked_) {
@@ -156,11 +315,6 @@ class CompressionFilter : public Filter {
     Filter::sendEOM();
   }
 
- protected:
-  void fail() {
-    Filter::sendAbort();
-  }
-
   // Verify the response is large enough to compress
   bool isMinimumCompressibleSize(const HTTPMessage& msg) const noexcept {
     auto contentLengthHeader =
@@ -174,9 +328,9 @@ class CompressionFilter : public Filter {
     return contentLength >= minimumCompressionSize_;
   }
 
-  // Check the response's content type against a list of compressible types
-  bool isCompressibleContentType(const HTTPMessage& msg) const noexcept {
-
+  // Extract the response's content type, lowercased and with any
+  // parameters (e.g. "; charset=utf-8") stripped
+  static std::string getContentType(const HTTPMessage& msg) noexcept {
     auto responseContentType =
         msg.getHeaders().getSingleOrEmpty(HTTP_HEADER_CONTENT_TYPE);
     folly::toLowerAscii(responseContentType);
@@ -186,8 +340,13 @@ class CompressionFilter : public Filter {
     if (parameter_idx != std::string::npos) {
       responseContentType = responseContentType.substr(0, parameter_idx);
     }
+    return responseContentType;
+  }
 
-    auto idx = compressibleContentTypes_->find(responseContentType);
+  // Check the response's content type against a list of compressible types
+  bool isCompressibleContentType(const HTTPMessage& msg) const noexcept {
+
+    auto idx = compressibleContentTypes_->find(getContentType(msg));
 
     if (idx != compressibleContentTypes_->end()) {
       return true;
@@ -196,15 +355,33 @@ class CompressionFilter : public Filter {
     return false;
   }
 
+  struct CompressedChunk {
+    std::unique_ptr<folly::IOBuf> body;
+    bool hasError{false};
+  };
+
   std::unique_ptr<HTTPMessage> responseMessage_;
-  std::unique_ptr<StreamCompressor> compressor_{nullptr};
+  // Shared so in-flight offload tasks keep the compressor alive past
+  // the filter; the serial executor prevents concurrent use
+  std::shared_ptr<StreamCompressor> compressor_{nullptr};
   const uint32_t minimumCompressionSize_{1000};
   StreamCompressorFactory compressorFactory_{};
+  ContentTypeAwareStreamCompressorFactory contentTypeAwareCompressorFactory_{};
   const std::string headerEncoding_{};
   const std::shared_ptr<std::set<std::string>> compressibleContentTypes_;
+  folly::Executor::KeepAlive<> offloadExecutor_;
+  const uint32_t offloadThreshold_{0};
+  std::map<uint64_t, CompressedChunk> recommitQueue_;
+  std::shared_ptr<bool> alive_{std::make_shared<bool>(true)};
+  uint64_t nextSeqToDispatch_{0};
+  uint64_t nextSeqToRecommit_{0};
+  uint32_t offloadsInFlight_{0};
+  uint32_t pendingTerminators_{0};
   bool header_{false};
   bool chunked_{false};
   bool compress_{false};
+  bool eomPending_{false};
+  bool failed_{false};
 };
 
 class CompressionFilterFactory : public RequestHandlerFactory {
@@ -222,9 +399,21 @@ class CompressionFilterFactory : public RequestHandlerFactory {
     std::set<std::string> compressibleContentTypes = {};
     int32_t zlibCompressionLevel = 4;
     int32_t zstdCompressionLevel = 8;
+    // Raw pretrained zstd dictionaries keyed by (lowercase) content
+    // type. Responses of these types are compressed against their
+    // dictionary; note the receiver must hold the same dictionary, so
+    // only enable this for clients you distribute dictionaries to.
+    std::map<std::string, std::string> zstdDictionaries = {};
     bool enableZstd = false;
     bool independentChunks = false;
     bool enableGzip = true;
+    // Compress bodies at least offloadThreshold bytes long on this
+    // executor (typically a bounded CPUThreadPoolExecutor shared across
+    // the server) instead of the IO thread; results are recommitted to
+    // the session in order.  Smaller bodies compress inline to avoid
+    // the thread hops.  nullptr keeps all compression on the IO thread.
+    std::shared_ptr<folly::Executor> offloadExecutor = nullptr;
+    uint32_t offloadThreshold = 64 * 1024;
   };
 
   CompressionFilterFactory(const Options& opts)
@@ -233,6 +422,9 @@ class CompressionFilterFactory : public RequestHandlerFactory {
         zstdCompressionLevel_(opts.zstdCompressionLevel),
         compressibleContentTypes_(std::make_shared<std::set<std::string>>(
             opts.compressibleContentTypes)),
+        zstdDictionaries_(digestDictionaries(opts)),
+        offloadExecutor_(opts.offloadExecutor),
+        offloadThreshold_(opts.offloadThreshold),
         enableZstd_(opts.enableZstd),
         independentChunks_(opts.independentChunks),
         enableGzip_(opts.enableGzip) {
@@ -260,17 +452,28 @@ class CompressionFilterFactory : public RequestHandlerFactory {
                   proxygen::CompressionType::GZIP, level);
             },
             "gzip",
-            compressibleContentTypes_};
+            compressibleContentTypes_,
+            offloadKeepAlive(),
+            offloadThreshold_};
       case CodecType::ZSTD:
         return new CompressionFilter{
             h,
             minimumCompressionSize_,
-            [level = zstdCompressionLevel_, independent = independentChunks_]()
+            [dictionaries = zstdDictionaries_,
+             level = zstdCompressionLevel_,
+             independent = independentChunks_](folly::StringPiece contentType)
                 -> std::unique_ptr<StreamCompressor> {
+              auto match = dictionaries->find(contentType.str());
+              if (match != dictionaries->end()) {
+                return std::make_unique<ZstdDictStreamCompressor>(
+                    match->second);
+              }
               return std::make_unique<ZstdStreamCompressor>(level, independent);
             },
             "zstd",
-            compressibleContentTypes_};
+            compressibleContentTypes_,
+            offloadKeepAlive(),
+            offloadThreshold_};
       case CodecType::NO_COMPRESSION:
         return h;
     };
@@ -278,15 +481,57 @@ class CompressionFilterFactory : public RequestHandlerFactory {
   }
 
  private:
-  // Check whether the client supports a compression type we support
-  CodecType determineCompressionType(HTTPMessage* msg) noexcept {
+  using ZstdDictionaryMap =
+      std::map<std::string, std::shared_ptr<const ZstdCompressionDictionary>>;
+
+  // Digest the configured raw dictionaries once at startup; the digested
+  // form is immutable and shared across every worker thread
+  static std::shared_ptr<const ZstdDictionaryMap> digestDictionaries(
+      const Options& opts) {
+    auto dictionaries = std::make_shared<ZstdDictionaryMap>();
+    for (const auto& entry : opts.zstdDictionaries) {
+      dictionaries->emplace(entry.first,
+                            std::make_shared<const ZstdCompressionDictionary>(
+                                entry.second, opts.zstdCompressionLevel));
+    }
+    return dictionaries;
+  }
 
-    RFC2616::TokenPairVec output;
+  folly::Executor::KeepAlive<> offloadKeepAlive() const {
+    return offloadExecutor_ ? folly::getKeepAliveToken(offloadExecutor_.get())
+                            : folly::Executor::KeepAlive<>();
+  }
+
+  // Check whether the client supports a compression type we support.
+  // Clients send a small set of distinct Accept-Encoding values
+  // fleet-wide, so negotiation results are cached per thread keyed on
+  // the exact header bytes; the q-value parser only runs for unseen
+  // values.  The cache is bounded to stay harmless against clients
+  // sending many distinct values.
+  CodecType determineCompressionType(HTTPMessage* msg) noexcept {
+    constexpr size_t kMaxNegotiationCacheSize = 128;
 
-    // Accept encoding header could have qvalues (gzip; q=5.0)
     auto acceptEncodingHeader =
         msg->getHeaders().getSingleOrEmpty(HTTP_HEADER_ACCEPT_ENCODING);
 
+    auto& cache = *negotiationCache_;
+    auto cached = cache.find(acceptEncodingHeader);
+    if (cached != cache.end()) {
+      return cached->second;
+    }
+    auto result = parseCompressionType(acceptEncodingHeader);
+    if (cache.size() < kMaxNegotiationCacheSize) {
+      cache.emplace(acceptEncodingHeader, result);
+    }
+    return result;
+  }
+
+  CodecType parseCompressionType(
+      const std::string& acceptEncodingHeader) const noexcept {
+
+    RFC2616::TokenPairVec output;
+
+    // Accept encoding header could have qvalues (gzip; q=5.0)
     if (!RFC2616::parseQvalues(acceptEncodingHeader, output)) {
       return CodecType::NO_COMPRESSION;
     }
@@ -319,8 +564,15 @@ class CompressionFilterFactory : public RequestHandlerFactory {
   const int32_t zlibCompressionLevel_;
   const int32_t zstdCompressionLevel_;
   const std::shared_ptr<std::set<std::string>> compressibleContentTypes_;
+  const std::shared_ptr<const ZstdDictionaryMap> zstdDictionaries_;
+  const std::shared_ptr<folly::Executor> offloadExecutor_;
+  const uint32_t offloadThreshold_;
   const bool enableZstd_;
   const bool independentChunks_;
   const bool enableGzip_;
+  // Per-thread Accept-Encoding value -> negotiated codec; per factory
+  // instance since the decision depends on the factory's options
+  folly::ThreadLocal<std::unordered_map<std::string, CodecType>>
+      negotiationCache_;
 };
 } // namespace proxygen
@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <folly/ThreadLocal.h>
+#include <folly/io/IOBufQueue.h>
+
+#include <proxygen/httpserver/Filters.h>
+#include <proxygen/httpserver/RequestHandlerFactory.h>
+#include <proxygen/lib/utils/StreamDecompressor.h>
+#include <proxygen/lib/utils/ZlibStreamDecompressor.h>
+#include <proxygen/lib/utils/ZstdStreamDecompressor.h>
+
+namespace proxygen {
+
+/**
+ * A server filter that transparently decompresses Content-Encoding'd
+ * request bodies (gzip, deflate, zstd) chunk-by-chunk as they arrive,
+ * so handlers always see plain bodies without buffering the request.
+ * The Content-Encoding and (now meaningless) Content-Length headers are
+ * removed before the message reaches the handler.
+ *
+ * A bounded inflation-ratio guard aborts streams that expand past
+ * maxInflationRatio once output clears a small floor, which stops zip
+ * bombs long before they exhaust memory.  While the handler has ingress
+ * paused, arriving input is queued in its cheap compressed form and
+ * only inflated on resume, so decompression cost and memory follow the
+ * handler's flow control instead of the sender's pacing.
+ */
+class DecompressionFilter : public Filter {
+ public:
+  using RecycleFn = std::function<void(std::unique_ptr<StreamDecompressor>)>;
+
+  DecompressionFilter(RequestHandler* upstream,
+                      std::unique_ptr<StreamDecompressor> decompressor,
+                      RecycleFn recycle,
+                      uint64_t maxInflationRatio)
+      : Filter(upstream),
+        decompressor_(std::move(decompressor)),
+        recycle_(std::move(recycle)),
+        maxInflationRatio_(maxInflationRatio) {
+    CHECK(decompressor_);
+  }
+
+  ~DecompressionFilter() override {
+    if (decompressor_ && recycle_) {
+      decompressor_->reset();
+      if (!decompressor_->hasError()) {
+        recycle_(std::move(decompressor_));
+      }
+    }
+  }
+
+  void onRequest(std::unique_ptr<HTTPMessage> headers) noexcept override {
+    auto& msgHeaders = headers->getHeaders();
+    msgHeaders.remove(HTTP_HEADER_CONTENT_ENCODING);
+    msgHeaders.remove(HTTP_HEADER_CONTENT_LENGTH);
+    Filter::onRequest(std::move(headers));
+  }
+
+  void onBody(std::unique_ptr<folly::IOBuf> body) noexcept override {
+    if (failed_ || !body) {
+      return;
+    }
+    if (paused_) {
+      pendingInput_.append(std::move(body));
+      return;
+    }
+    decompressAndDeliver(std::move(body));
+  }
+
+  void onEOM() noexcept override {
+    if (failed_) {
+      return;
+    }
+    if (paused_) {
+      pendingEOM_ = true;
+      return;
+    }
+    Filter::onEOM();
+  }
+
+  // Handler-initiated flow control: while paused, input stays
+  // compressed in pendingInput_ instead of being inflated eagerly
+  void pauseIngress() noexcept override {
+    paused_ = true;
+    Filter::pauseIngress();
+  }
+
+  void resumeIngress() noexcept override {
+    paused_ = false;
+    if (!pendingInput_.empty()) {
+      decompressAndDeliver(pendingInput_.move());
+    }
+    if (failed_) {
+      return;
+    }
+    if (pendingEOM_) {
+      pendingEOM_ = false;
+      Filter::onEOM();
+    }
+    Filter::resumeIngress();
+  }
+
+ private:
+  // Floor below which the ratio guard stays quiet; tiny bodies inflate
+  // wildly (an empty gzip member is ~20 bytes) without being bombs
+  static constexpr uint64_t kRatioCheckFloor = 64 * 1024;
+
+  void decompressAndDeliver(std::unique_ptr<folly::IOBuf> body) {
+    compressedBytes_ += body->computeChainDataLength();
+    auto decompressed = decompressor_->decompress(body.get());
+    if (decompressor_->hasError()) {
+      return fail();
+    }
+    if (!decompressed) {
+      return;
+    }
+    decompressedBytes_ += decompressed->computeChainDataLength();
+    if (decompressedBytes_ > kRatioCheckFloor &&
+        decompressedBytes_ > maxInflationRatio_ * compressedBytes_) {
+      return fail();
+    }
+    if (decompressed->computeChainDataLength() > 0) {
+      Filter::onBody(std::move(decompressed));
+    }
+  }
+
+  void fail() {
+    failed_ = true;
+    Filter::sendAbort();
+  }
+
+  std::unique_ptr<StreamDecompressor> decompressor_;
+  RecycleFn recycle_;
+  const uint64_t maxInflationRatio_;
+  folly::IOBufQueue pendingInput_{folly::IOBufQueue::cacheChainLength()};
+  uint64_t compressedBytes_{0};
+  uint64_t decompressedBytes_{0};
+  bool paused_{false};
+  bool pendingEOM_{false};
+  bool failed_{false};
+};
+
+class DecompressionFilterFactory : public RequestHandlerFactory {
+ public:
+  struct Options {
+    Options() = default;
+    // Abort when output exceeds this many times the input (past a small
+    // floor); legitimate text rarely exceeds ~20x
+    uint64_t maxInflationRatio = 100;
+    bool enableGzip = true;
+    bool enableZstd = true;
+  };
+
+  explicit DecompressionFilterFactory(const Options& opts = Options())
+      : maxInflationRatio_(opts.maxInflationRatio),
+        enableGzip_(opts.enableGzip),
+        enableZstd_(opts.enableZstd) {
+  }
+
+  void onServerStart(folly::EventBase* /*evb*/) noexcept override {
+  }
+
+  void onServerStop() noexcept override {
+  }
+
+  RequestHandler* onRequest(RequestHandler* h,
+                            HTTPMessage* msg) noexcept override {
+    auto encoding =
+        msg->getHeaders().getSingleOrEmpty(HTTP_HEADER_CONTENT_ENCODING);
+    CompressionType type = CompressionType::NONE;
+    if (enableGzip_ && encoding == "gzip") {
+      type = CompressionType::GZIP;
+    } else if (enableGzip_ && encoding == "deflate") {
+      type = CompressionType::DEFLATE;
+    } else if (enableZstd_ && encoding == "zstd") {
+      type = CompressionType::ZSTD;
+    } else {
+      return h;
+    }
+    return new DecompressionFilter(
+        h,
+        acquire(type),
+        [this, type](std::unique_ptr<StreamDecompressor> decompressor) {
+          recycle(type, std::move(decompressor));
+        },
+        maxInflationRatio_);
+  }
+
+ private:
+  // Reset decompression contexts are pooled per worker thread; filters
+  // construct and recycle on their own EventBase so no locking is needed
+  static constexpr size_t kMaxPooledPerType = 8;
+
+  struct Pool {
+    std::vector<std::unique_ptr<StreamDecompressor>> gzip;
+    std::vector<std::unique_ptr<StreamDecompressor>> deflate;
+    std::vector<std::unique_ptr<StreamDecompressor>> zstd;
+  };
+
+  std::vector<std::unique_ptr<StreamDecompressor>>& poolFor(
+      CompressionType type) {
+    switch (type) {
+      case CompressionType::GZIP:
+        return pools_->gzip;
+      case CompressionType::DEFLATE:
+        return pools_->deflate;
+      default:
+        DCHECK(type == CompressionType::ZSTD);
+        return pools_->zstd;
+    }
+  }
+
+  std::unique_ptr<StreamDecompressor> acquire(CompressionType type) {
+    auto& pool = poolFor(type);
+    if (!pool.empty()) {
+      auto decompressor = std::move(pool.back());
+      pool.pop_back();
+      return decompressor;
+    }
+    if (type == CompressionType::ZSTD) {
+      return std::make_unique<ZstdStreamDecompressor>();
+    }
+    return std::make_unique<ZlibStreamDecompressor>(type);
+  }
+
+  void recycle(CompressionType type,
+               std::unique_ptr<StreamDecompressor> decompressor) {
+    auto& pool = poolFor(type);
+    if (pool.size() < kMaxPooledPerType) {
+      pool.push_back(std::move(decompressor));
+    }
+  }
+
+  const uint64_t maxInflationRatio_;
+  const bool enableGzip_;
+  const bool enableZstd_;
+  folly::ThreadLocal<Pool> pools_;
+};
+
+} // namespace proxygen
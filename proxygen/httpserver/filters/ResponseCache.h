@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/ThreadLocal.h>
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/EventBase.h>
+#include <list>
+#include <proxygen/lib/http/HTTPMessage.h>
+#include <proxygen/lib/utils/Time.h>
+#include <unordered_map>
+
+namespace proxygen {
+
+/**
+ * Shared storage for ResponseCacheFilter: cached responses as immutable
+ * ref-counted IOBuf chains, served zero-copy (clone() shares the
+ * underlying buffers) to any number of concurrent readers.
+ *
+ * Layout is a per-worker L1 over a sharded L2.  The L1 is a small
+ * thread-local map touched with no synchronization at all; the L2 is
+ * striped across shards, each with its own lock and LRU, so writers on
+ * different keys rarely contend.  L1 entries are revalidated against
+ * their expiry only, so a worker may serve an entry for up to its TTL
+ * after another worker replaced it; keep TTLs short for content where
+ * that matters.
+ *
+ * Fills are coalesced per key: the first missing caller becomes the
+ * fill owner and the rest park a callback that runs (on their own
+ * EventBase) when the owner completes, so one render populates every
+ * concurrent waiter.
+ *
+ * All public methods are thread-safe.
+ */
+class ResponseCache {
+ public:
+  struct Entry {
+    // Response headers as stored; callers copy before mutating
+    HTTPMessage headers;
+    // Immutable master body chain; share via cloneBody()
+    std::unique_ptr<folly::IOBuf> body;
+    // Vary contract this variant was stored under: header name ->
+    // request value
+    std::vector<std::pair<std::string, std::string>> varyHeaders;
+    TimePoint expiry;
+    size_t bytes{0};
+
+    std::unique_ptr<folly::IOBuf> cloneBody() const {
+      return body ? body->clone() : nullptr;
+    }
+
+    bool expired() const {
+      return getCurrentTime() >= expiry;
+    }
+  };
+  using EntryPtr = std::shared_ptr<const Entry>;
+  using FillCallback = folly::Function<void(EntryPtr)>;
+
+  explicit ResponseCache(uint64_t maxSizeBytes = 64 * 1024 * 1024,
+                         uint32_t l1Capacity = 256)
+      : maxShardBytes_(maxSizeBytes / kNumShards), l1Capacity_(l1Capacity) {
+  }
+
+  /**
+   * Look the key up, L1 first.  Expired entries count as misses.
+   */
+  EntryPtr get(const std::string& key) {
+    auto& l1 = *l1_;
+    auto l1It = l1.find(key);
+    if (l1It != l1.end()) {
+      if (!l1It->second->expired()) {
+        return l1It->second;
+      }
+      l1.erase(l1It);
+    }
+    auto entry = getFromShard(key);
+    if (entry) {
+      if (l1.size() >= l1Capacity_) {
+        // Simple full-flush beats LRU bookkeeping at this size
+        l1.clear();
+      }
+      l1[key] = entry;
+    }
+    return entry;
+  }
+
+  /**
+   * Store an entry, evicting least recently used entries of its shard
+   * past the byte budget.
+   */
+  void put(const std::string& key, EntryPtr entry) {
+    CHECK(entry);
+    auto state = shard(key).lock();
+    auto it = state->entries.find(key);
+    if (it != state->entries.end()) {
+      state->bytes -= it->second.entry->bytes;
+      state->lru.erase(it->second.lruIt);
+      state->entries.erase(it);
+    }
+    state->lru.push_front(key);
+    state->bytes += entry->bytes;
+    state->entries.emplace(key, ShardEntry{std::move(entry), state->lru.begin()});
+    while (state->bytes > maxShardBytes_ && !state->lru.empty()) {
+      auto& victim = state->lru.back();
+      auto victimIt = state->entries.find(victim);
+      CHECK(victimIt != state->entries.end());
+      state->bytes -= victimIt->second.entry->bytes;
+      state->entries.erase(victimIt);
+      state->lru.pop_back();
+    }
+  }
+
+  /**
+   * Coalescing: returns true if the caller became the fill owner for the
+   * key and must eventually call completeFill().  Otherwise the callback
+   * is parked and will run on evb when the owner completes, with the
+   * freshly cached entry or nullptr if the response was uncacheable.
+   */
+  bool beginFillOrWait(const std::string& key,
+                       folly::EventBase* evb,
+                       FillCallback callback) {
+    auto state = shard(key).lock();
+    auto it = state->fills.find(key);
+    if (it == state->fills.end()) {
+      state->fills.emplace(key, std::vector<Waiter>());
+      return true;
+    }
+    it->second.push_back(Waiter{evb, std::move(callback)});
+    return false;
+  }
+
+  /**
+   * Finish a fill: cache the entry (nullptr for uncacheable responses)
+   * and wake every parked waiter.
+   */
+  void completeFill(const std::string& key, EntryPtr entry) {
+    std::vector<Waiter> waiters;
+    {
+      auto state = shard(key).lock();
+      auto it = state->fills.find(key);
+      if (it != state->fills.end()) {
+        waiters = std::move(it->second);
+        state->fills.erase(it);
+      }
+    }
+    if (entry) {
+      put(key, entry);
+    }
+    for (auto& waiter : waiters) {
+      waiter.evb->runInEventBaseThread(
+          [cb = std::move(waiter.callback), entry]() mutable { cb(entry); });
+    }
+  }
+
+ private:
+  static constexpr size_t kNumShards = 16;
+
+  struct ShardEntry {
+    EntryPtr entry;
+    std::list<std::string>::iterator lruIt;
+  };
+  struct Waiter {
+    folly::EventBase* evb;
+    FillCallback callback;
+  };
+  struct ShardState {
+    std::unordered_map<std::string, ShardEntry> entries;
+    std::list<std::string> lru;
+    size_t bytes{0};
+    std::unordered_map<std::string, std::vector<Waiter>> fills;
+  };
+
+  folly::Synchronized<ShardState, std::mutex>& shard(const std::string& key) {
+    return shards_[std::hash<std::string>()(key) % kNumShards];
+  }
+
+  EntryPtr getFromShard(const std::string& key) {
+    auto state = shard(key).lock();
+    auto it = state->entries.find(key);
+    if (it == state->entries.end()) {
+      return nullptr;
+    }
+    if (it->second.entry->expired()) {
+      state->bytes -= it->second.entry->bytes;
+      state->lru.erase(it->second.lruIt);
+      state->entries.erase(it);
+      return nullptr;
+    }
+    state->lru.splice(state->lru.begin(), state->lru, it->second.lruIt);
+    return it->second.entry;
+  }
+
+  const uint64_t maxShardBytes_;
+  const uint32_t l1Capacity_;
+  std::array<folly::Synchronized<ShardState, std::mutex>, kNumShards> shards_;
+  folly::ThreadLocal<std::unordered_map<std::string, EntryPtr>> l1_;
+};
+
+} // namespace proxygen
@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <folly/Conv.h>
+#include <folly/String.h>
+#include <folly/io/async/EventBaseManager.h>
+
+#include <proxygen/httpserver/Filters.h>
+#include <proxygen/httpserver/RequestHandlerFactory.h>
+#include <proxygen/httpserver/filters/ResponseCache.h>
+
+namespace proxygen {
+
+/**
+ * A server filter that caches responses in a shared ResponseCache and
+ * serves hits directly, without invoking the app handler.  On a miss the
+ * first request becomes the fill owner: its response streams through to
+ * the client unmodified while the filter keeps a zero-copy clone of the
+ * body chain, and concurrent requests for the same key park until the
+ * fill completes instead of each hitting the renderer.
+ *
+ * Cacheability follows the usual HTTP rules at the depth a reverse
+ * proxy needs: only GET requests without Authorization or a no-store /
+ * no-cache request directive are considered; only 200 responses without
+ * no-store / no-cache / private / Set-Cookie are stored; Vary is
+ * honored with one variant per key (a mismatched variant is a miss that
+ * re-fills the entry) and "Vary: *" is never cached.  Freshness comes
+ * from the response's max-age, falling back to the configured default
+ * TTL.
+ *
+ * Handlers behind this filter never see requests that were answered
+ * from cache; they only get requestComplete()/onError() for teardown.
+ */
+class ResponseCacheFilter : public Filter {
+ public:
+  ResponseCacheFilter(RequestHandler* upstream,
+                      std::shared_ptr<ResponseCache> cache,
+                      std::chrono::seconds defaultTtl,
+                      uint64_t maxCacheableBodySize)
+      : Filter(upstream),
+        cache_(std::move(cache)),
+        defaultTtl_(defaultTtl),
+        maxCacheableBodySize_(maxCacheableBodySize),
+        alive_(std::make_shared<char>()) {
+  }
+
+  ~ResponseCacheFilter() override {
+    if (fillOwner_ && !fillCompleted_) {
+      // Never leave waiters parked; an aborted fill wakes them with
+      // "uncacheable" so they fall through to their own handlers
+      cache_->completeFill(key_, nullptr);
+    }
+  }
+
+  void onRequest(std::unique_ptr<HTTPMessage> headers) noexcept override {
+    if (!isCacheableRequest(*headers)) {
+      Filter::onRequest(std::move(headers));
+      return;
+    }
+
+    key_ = folly::to<std::string>(
+        methodToString(headers->getMethod().value()), " ", headers->getURL());
+    requestMessage_ = std::make_unique<HTTPMessage>(*headers);
+
+    auto entry = cache_->get(key_);
+    if (entry && variantMatches(*entry)) {
+      serveFromCache(*entry);
+      return;
+    }
+
+    std::weak_ptr<char> alive = alive_;
+    fillOwner_ = cache_->beginFillOrWait(
+        key_,
+        folly::EventBaseManager::get()->getEventBase(),
+        [this, alive](ResponseCache::EntryPtr filled) {
+          if (!alive.expired()) {
+            onFillComplete(std::move(filled));
+          }
+        });
+    if (fillOwner_) {
+      capturing_ = true;
+      Filter::onRequest(std::move(headers));
+    } else {
+      // Parked: hold the request until the owner's fill completes
+      stashedRequest_ = std::move(headers);
+    }
+  }
+
+  void onBody(std::unique_ptr<folly::IOBuf> body) noexcept override {
+    if (served_ || stashedRequest_) {
+      return; // GET bodies are not forwarded on cache-managed paths
+    }
+    Filter::onBody(std::move(body));
+  }
+
+  void onEOM() noexcept override {
+    if (served_) {
+      return;
+    }
+    if (stashedRequest_) {
+      stashedEOM_ = true;
+      return;
+    }
+    Filter::onEOM();
+  }
+
+  // Response path: stream through while keeping a shared clone
+
+  void sendHeaders(HTTPMessage& msg) noexcept override {
+    if (capturing_) {
+      if (isCacheableResponse(msg)) {
+        pendingEntry_ = std::make_unique<ResponseCache::Entry>();
+        pendingEntry_->headers = msg;
+        pendingEntry_->expiry = getCurrentTime() + responseTtl(msg);
+        captureVary(msg);
+      } else {
+        abandonFill();
+      }
+    }
+    Filter::sendHeaders(msg);
+  }
+
+  void sendBody(std::unique_ptr<folly::IOBuf> body) noexcept override {
+    if (pendingEntry_ && body) {
+      capturedBytes_ += body->computeChainDataLength();
+      if (capturedBytes_ > maxCacheableBodySize_) {
+        abandonFill();
+      } else if (pendingEntry_->body) {
+        pendingEntry_->body->prependChain(body->clone());
+      } else {
+        pendingEntry_->body = body->clone();
+      }
+    }
+    Filter::sendBody(std::move(body));
+  }
+
+  void sendEOM() noexcept override {
+    if (pendingEntry_) {
+      pendingEntry_->bytes = key_.size() + capturedBytes_;
+      fillCompleted_ = true;
+      cache_->completeFill(
+          key_, ResponseCache::EntryPtr(std::move(pendingEntry_)));
+    } else if (fillOwner_ && !fillCompleted_) {
+      abandonFill();
+    }
+    Filter::sendEOM();
+  }
+
+  void sendAbort() noexcept override {
+    abandonFill();
+    Filter::sendAbort();
+  }
+
+ private:
+  bool isCacheableRequest(const HTTPMessage& msg) const noexcept {
+    if (msg.getMethod() != HTTPMethod::GET) {
+      return false;
+    }
+    const auto& headers = msg.getHeaders();
+    if (!headers.getSingleOrEmpty(HTTP_HEADER_AUTHORIZATION).empty()) {
+      return false;
+    }
+    auto cacheControl = headers.getSingleOrEmpty(HTTP_HEADER_CACHE_CONTROL);
+    return cacheControl.find("no-store") == std::string::npos &&
+           cacheControl.find("no-cache") == std::string::npos;
+  }
+
+  bool isCacheableResponse(const HTTPMessage& msg) const noexcept {
+    if (msg.getStatusCode() != 200) {
+      return false;
+    }
+    const auto& headers = msg.getHeaders();
+    if (!headers.getSingleOrEmpty(HTTP_HEADER_SET_COOKIE).empty()) {
+      return false;
+    }
+    if (headers.getSingleOrEmpty(HTTP_HEADER_VARY) == "*") {
+      return false;
+    }
+    auto cacheControl = headers.getSingleOrEmpty(HTTP_HEADER_CACHE_CONTROL);
+    return cacheControl.find("no-store") == std::string::npos &&
+           cacheControl.find("no-cache") == std::string::npos &&
+           cacheControl.find("private") == std::string::npos;
+  }
+
+  std::chrono::seconds responseTtl(const HTTPMessage& msg) const noexcept {
+    auto cacheControl =
+        msg.getHeaders().getSingleOrEmpty(HTTP_HEADER_CACHE_CONTROL);
+    auto pos = cacheControl.find("max-age=");
+    if (pos != std::string::npos) {
+      auto maxAge = folly::tryTo<uint32_t>(folly::StringPiece(cacheControl)
+                                               .subpiece(pos + 8)
+                                               .split_step(','));
+      if (maxAge.hasValue()) {
+        return std::chrono::seconds(maxAge.value());
+      }
+    }
+    return defaultTtl_;
+  }
+
+  // Record the Vary contract: which request header values this variant
+  // was stored under
+  void captureVary(const HTTPMessage& msg) {
+    auto vary = msg.getHeaders().getSingleOrEmpty(HTTP_HEADER_VARY);
+    folly::StringPiece remaining(vary);
+    while (!remaining.empty()) {
+      auto name = remaining.split_step(',');
+      auto trimmed = folly::trimWhitespace(name).str();
+      if (trimmed.empty()) {
+        continue;
+      }
+      pendingEntry_->varyHeaders.emplace_back(
+          trimmed, requestMessage_->getHeaders().getSingleOrEmpty(trimmed));
+    }
+  }
+
+  bool variantMatches(const ResponseCache::Entry& entry) const noexcept {
+    for (const auto& vary : entry.varyHeaders) {
+      if (requestMessage_->getHeaders().getSingleOrEmpty(vary.first) !=
+          vary.second) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void serveFromCache(const ResponseCache::Entry& entry) {
+    served_ = true;
+    HTTPMessage response(entry.headers);
+    downstream_->sendHeaders(response);
+    auto body = entry.cloneBody();
+    if (body) {
+      downstream_->sendBody(std::move(body));
+    }
+    downstream_->sendEOM();
+  }
+
+  void onFillComplete(ResponseCache::EntryPtr entry) {
+    auto request = std::move(stashedRequest_);
+    if (entry && variantMatches(*entry)) {
+      serveFromCache(*entry);
+      return;
+    }
+    // Uncacheable (or wrong variant): fall through to our own handler
+    Filter::onRequest(std::move(request));
+    if (stashedEOM_) {
+      Filter::onEOM();
+    }
+  }
+
+  void abandonFill() {
+    pendingEntry_.reset();
+    if (fillOwner_ && !fillCompleted_) {
+      fillCompleted_ = true;
+      cache_->completeFill(key_, nullptr);
+    }
+  }
+
+  std::shared_ptr<ResponseCache> cache_;
+  const std::chrono::seconds defaultTtl_;
+  const uint64_t maxCacheableBodySize_;
+  // Tombstone for the coalescing callback; it may fire after teardown
+  std::shared_ptr<char> alive_;
+
+  std::string key_;
+  std::unique_ptr<HTTPMessage> requestMessage_;
+  std::unique_ptr<HTTPMessage> stashedRequest_;
+  std::unique_ptr<ResponseCache::Entry> pendingEntry_;
+  uint64_t capturedBytes_{0};
+  bool served_{false};
+  bool fillOwner_{false};
+  bool fillCompleted_{false};
+  bool capturing_{false};
+  bool stashedEOM_{false};
+};
+
+class ResponseCacheFilterFactory : public RequestHandlerFactory {
+ public:
+  struct Options {
+    Options() = default;
+    uint64_t maxSizeBytes = 64 * 1024 * 1024;
+    uint64_t maxCacheableBodySize = 1024 * 1024;
+    std::chrono::seconds defaultTtl = std::chrono::seconds(60);
+  };
+
+  explicit ResponseCacheFilterFactory(const Options& opts)
+      : cache_(std::make_shared<ResponseCache>(opts.maxSizeBytes)),
+        defaultTtl_(opts.defaultTtl),
+        maxCacheableBodySize_(opts.maxCacheableBodySize) {
+  }
+
+  void onServerStart(folly::EventBase* /*evb*/) noexcept override {
+  }
+
+  void onServerStop() noexcept override {
+  }
+
+  RequestHandler* onRequest(RequestHandler* h,
+                            HTTPMessage* msg) noexcept override {
+    if (msg->getMethod() != HTTPMethod::GET) {
+      return h;
+    }
+    return new ResponseCacheFilter(
+        h, cache_, defaultTtl_, maxCacheableBodySize_);
+  }
+
+  std::shared_ptr<ResponseCache> getCache() const {
+    return cache_;
+  }
+
+ private:
+  std::shared_ptr<ResponseCache> cache_;
+  const std::chrono::seconds defaultTtl_;
+  const uint64_t maxCacheableBodySize_;
+};
+
+} // namespace proxygen
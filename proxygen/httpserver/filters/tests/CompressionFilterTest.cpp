@@ -10,7 +10,9 @@
 
 #include <folly/Conv.h>
 #include <folly/ScopeGuard.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/io/IOBuf.h>
+#include <folly/io/async/EventBaseManager.h>
 
 #include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
@@ -94,7 +96,10 @@ class CompressionFilterTest : public Test {
                             int32_t compressionLevel = T::getCompressionLevel(),
                             uint32_t minimumCompressionSize = 1,
                             bool sendCompressedResponse = false,
-                            bool disableCompressionForThisEncoding = false) {
+                            bool disableCompressionForThisEncoding = false,
+                            std::shared_ptr<folly::Executor> offloadExecutor =
+                                nullptr,
+                            uint32_t offloadThreshold = 0) {
 
     // If there is only one IOBuf, then it's not chunked.
     bool isResponseChunked = originalResponseBody->isChained();
@@ -167,7 +172,9 @@ class CompressionFilterTest : public Test {
             }),
             Return()));
 
-    EXPECT_CALL(*responseHandler_, sendEOM()).Times(1);
+    bool eomSent = false;
+    EXPECT_CALL(*responseHandler_, sendEOM())
+        .WillOnce(Assign(&eomSent, true));
 
     /* Simulate Request/Response  */
 
@@ -182,6 +189,8 @@ class CompressionFilterTest : public Test {
     opts.minimumCompressionSize = minimumCompressionSize;
     opts.compressibleContentTypes = compressibleTypes;
     opts.enableZstd = true;
+    opts.offloadExecutor = offloadExecutor;
+    opts.offloadThreshold = offloadThreshold;
     if (disableCompressionForThisEncoding) {
       if (CodecType::getExpectedEncoding() == "gzip") {
         opts.enableGzip = false;
@@ -234,6 +243,12 @@ class CompressionFilterTest : public Test {
           .sendWithEOM();
     }
 
+    // Offloaded chunks recommit through the event base; drain it until
+    // the EOM makes it out
+    while (!eomSent) {
+      folly::EventBaseManager::get()->getEventBase()->loopOnce();
+    }
+
     filter->requestComplete();
 
     EXPECT_THAT(responseBody, IOBufEquals(originalRequestBody));
@@ -291,6 +306,70 @@ TYPED_TEST(CompressionFilterTest, ChunkedCompression) {
   });
 }
 
+// Chunks above the offload threshold compress on the executor and
+// recommit in order
+TYPED_TEST(CompressionFilterTest, OffloadedChunkedCompression) {
+  using Codec = typename TestFixture::CodecType;
+  std::vector<std::string> chunks = {"Hello", " World", " Again", " Bye"};
+  auto executor = std::make_shared<folly::CPUThreadPoolExecutor>(2);
+  ASSERT_NO_FATAL_FAILURE({
+    this->exercise_compression(true,
+                               std::string("http://locahost/foo.compressme"),
+                               Codec::getExpectedEncoding(),
+                               Codec::getExpectedEncoding(),
+                               std::string("Hello World Again Bye"),
+                               std::string("text/html"),
+                               this->createResponseChain(chunks),
+                               Codec::getCompressionLevel(),
+                               1,
+                               false,
+                               false,
+                               executor,
+                               1 /* offloadThreshold */);
+  });
+}
+
+TYPED_TEST(CompressionFilterTest, OffloadedNonchunkedCompression) {
+  using Codec = typename TestFixture::CodecType;
+  auto executor = std::make_shared<folly::CPUThreadPoolExecutor>(2);
+  ASSERT_NO_FATAL_FAILURE({
+    this->exercise_compression(true,
+                               std::string("http://locahost/foo.compressme"),
+                               Codec::getExpectedEncoding(),
+                               Codec::getExpectedEncoding(),
+                               std::string("Hello World"),
+                               std::string("text/html"),
+                               folly::IOBuf::copyBuffer("Hello World"),
+                               Codec::getCompressionLevel(),
+                               1,
+                               false,
+                               false,
+                               executor,
+                               1 /* offloadThreshold */);
+  });
+}
+
+// Bodies below the threshold stay inline even with an executor set
+TYPED_TEST(CompressionFilterTest, OffloadSmallBodyStaysInline) {
+  using Codec = typename TestFixture::CodecType;
+  auto executor = std::make_shared<folly::CPUThreadPoolExecutor>(2);
+  ASSERT_NO_FATAL_FAILURE({
+    this->exercise_compression(true,
+                               std::string("http://locahost/foo.compressme"),
+                               Codec::getExpectedEncoding(),
+                               Codec::getExpectedEncoding(),
+                               std::string("Hello World"),
+                               std::string("text/html"),
+                               folly::IOBuf::copyBuffer("Hello World"),
+                               Codec::getCompressionLevel(),
+                               1,
+                               false,
+                               false,
+                               executor,
+                               1 << 20 /* offloadThreshold */);
+  });
+}
+
 TYPED_TEST(CompressionFilterTest, ParameterizedContenttype) {
   using Codec = typename TestFixture::CodecType;
   ASSERT_NO_FATAL_FAILURE({
@@ -559,3 +638,32 @@ TYPED_TEST(CompressionFilterTest, NoResponseBody) {
     filter->requestComplete();
   });
 }
+
+TEST(CompressionFilterFactoryTest, NegotiationCacheRepeatedRequests) {
+  CompressionFilterFactory::Options opts;
+  opts.compressibleContentTypes = {"text/html"};
+  opts.enableZstd = true;
+  CompressionFilterFactory factory{opts};
+
+  auto requestHandler = new MockRequestHandler();
+  SCOPE_EXIT {
+    delete requestHandler;
+  };
+
+  HTTPMessage msg;
+  msg.setURL("http://locahost/foo.compressme");
+  msg.getHeaders().set(HTTP_HEADER_ACCEPT_ENCODING, "gzip, deflate");
+
+  // The second identical request is answered from the per-thread
+  // negotiation cache and must get the same decision
+  for (int i = 0; i < 2; i++) {
+    auto handler = factory.onRequest(requestHandler, &msg);
+    EXPECT_NE(handler, requestHandler);
+    delete handler;
+  }
+
+  msg.getHeaders().set(HTTP_HEADER_ACCEPT_ENCODING, "identity");
+  for (int i = 0; i < 2; i++) {
+    EXPECT_EQ(factory.onRequest(requestHandler, &msg), requestHandler);
+  }
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/io/IOBuf.h>
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/httpserver/Mocks.h>
+#include <proxygen/httpserver/filters/DecompressionFilter.h>
+#include <proxygen/lib/utils/ZlibStreamCompressor.h>
+
+using namespace proxygen;
+using namespace testing;
+
+namespace {
+
+std::unique_ptr<folly::IOBuf> gzipCompress(const std::string& data) {
+  ZlibStreamCompressor compressor(proxygen::CompressionType::GZIP, 6);
+  auto in = folly::IOBuf::copyBuffer(data);
+  return compressor.compress(in.get(), true);
+}
+
+std::string toString(const folly::IOBuf& buf) {
+  auto cloned = buf.clone();
+  auto range = cloned->coalesce();
+  return std::string(range.begin(), range.end());
+}
+
+} // namespace
+
+class DecompressionFilterTest : public Test {
+ public:
+  void SetUp() override {
+    requestHandler_ = new MockRequestHandler();
+    responseHandler_ = std::make_unique<MockResponseHandler>(requestHandler_);
+  }
+
+  void TearDown() override {
+    Mock::VerifyAndClear(requestHandler_);
+    Mock::VerifyAndClear(responseHandler_.get());
+    delete requestHandler_;
+  }
+
+ protected:
+  DecompressionFilter* makeFilter(uint64_t maxInflationRatio = 100) {
+    auto filter = new DecompressionFilter(
+        requestHandler_,
+        std::make_unique<ZlibStreamDecompressor>(CompressionType::GZIP),
+        nullptr,
+        maxInflationRatio);
+    EXPECT_CALL(*requestHandler_, setResponseHandler(_));
+    filter->setResponseHandler(responseHandler_.get());
+    return filter;
+  }
+
+  static std::unique_ptr<HTTPMessage> makeCompressedPost() {
+    auto msg = std::make_unique<HTTPMessage>();
+    msg->setMethod(HTTPMethod::POST);
+    msg->setURL("/ingest");
+    msg->getHeaders().set(HTTP_HEADER_CONTENT_ENCODING, "gzip");
+    msg->getHeaders().set(HTTP_HEADER_CONTENT_LENGTH, "1234");
+    return msg;
+  }
+
+  MockRequestHandler* requestHandler_;
+  std::unique_ptr<MockResponseHandler> responseHandler_;
+};
+
+TEST_F(DecompressionFilterTest, FactoryWrapsOnlyEncodedBodies) {
+  DecompressionFilterFactory factory;
+
+  auto plain = std::make_unique<HTTPMessage>();
+  plain->setMethod(HTTPMethod::POST);
+  plain->setURL("/ingest");
+  EXPECT_EQ(factory.onRequest(requestHandler_, plain.get()), requestHandler_);
+
+  auto encoded = makeCompressedPost();
+  auto handler = factory.onRequest(requestHandler_, encoded.get());
+  EXPECT_NE(handler, requestHandler_);
+
+  EXPECT_CALL(*requestHandler_, setResponseHandler(_));
+  handler->setResponseHandler(responseHandler_.get());
+  EXPECT_CALL(*requestHandler_, requestComplete());
+  handler->requestComplete();
+}
+
+TEST_F(DecompressionFilterTest, DecompressesBodyAndScrubsHeaders) {
+  const std::string body =
+      "ingest payload ingest payload ingest payload ingest payload";
+  auto filter = makeFilter();
+
+  EXPECT_CALL(*requestHandler_, onRequest(_))
+      .WillOnce(Invoke([](std::shared_ptr<HTTPMessage> msg) {
+        EXPECT_FALSE(msg->getHeaders().exists(HTTP_HEADER_CONTENT_ENCODING));
+        EXPECT_FALSE(msg->getHeaders().exists(HTTP_HEADER_CONTENT_LENGTH));
+      }));
+  EXPECT_CALL(*requestHandler_, onBody(_))
+      .WillOnce(Invoke([&](std::shared_ptr<folly::IOBuf> decompressed) {
+        EXPECT_EQ(toString(*decompressed), body);
+      }));
+  EXPECT_CALL(*requestHandler_, onEOM());
+
+  filter->onRequest(makeCompressedPost());
+  filter->onBody(gzipCompress(body));
+  filter->onEOM();
+
+  EXPECT_CALL(*requestHandler_, requestComplete());
+  filter->requestComplete();
+}
+
+TEST_F(DecompressionFilterTest, InflationRatioGuardAborts) {
+  // A megabyte of zeros compresses to ~1KB; with a ratio cap of 4 the
+  // guard trips before any inflated output reaches the handler
+  auto filter = makeFilter(/*maxInflationRatio=*/4);
+
+  EXPECT_CALL(*requestHandler_, onRequest(_));
+  EXPECT_CALL(*requestHandler_, onBody(_)).Times(0);
+  EXPECT_CALL(*responseHandler_, sendAbort());
+
+  filter->onRequest(makeCompressedPost());
+  filter->onBody(gzipCompress(std::string(1024 * 1024, '\0')));
+
+  EXPECT_CALL(*requestHandler_, onError(_));
+  filter->onError(kErrorStreamAbort);
+}
+
+TEST_F(DecompressionFilterTest, PausedIngressQueuesCompressedInput) {
+  const std::string body = "deferred until the handler resumes, deferred";
+  auto filter = makeFilter();
+
+  EXPECT_CALL(*requestHandler_, onRequest(_));
+  filter->onRequest(makeCompressedPost());
+
+  // Handler pauses; arriving input is held compressed, nothing inflates
+  EXPECT_CALL(*responseHandler_, pauseIngress());
+  filter->pauseIngress();
+  EXPECT_CALL(*requestHandler_, onBody(_)).Times(0);
+  EXPECT_CALL(*requestHandler_, onEOM()).Times(0);
+  filter->onBody(gzipCompress(body));
+  filter->onEOM();
+  Mock::VerifyAndClearExpectations(requestHandler_);
+
+  // Resume drains the queued input through the decompressor in order
+  EXPECT_CALL(*requestHandler_, onBody(_))
+      .WillOnce(Invoke([&](std::shared_ptr<folly::IOBuf> decompressed) {
+        EXPECT_EQ(toString(*decompressed), body);
+      }));
+  EXPECT_CALL(*requestHandler_, onEOM());
+  EXPECT_CALL(*responseHandler_, resumeIngress());
+  filter->resumeIngress();
+
+  EXPECT_CALL(*requestHandler_, requestComplete());
+  filter->requestComplete();
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/io/IOBuf.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventBaseManager.h>
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/httpserver/Mocks.h>
+#include <proxygen/httpserver/filters/ResponseCacheFilter.h>
+
+using namespace proxygen;
+using namespace testing;
+
+namespace {
+
+std::unique_ptr<HTTPMessage> makeGetRequest(const std::string& url) {
+  auto msg = std::make_unique<HTTPMessage>();
+  msg->setMethod(HTTPMethod::GET);
+  msg->setURL(url);
+  return msg;
+}
+
+HTTPMessage makeOkResponse() {
+  HTTPMessage msg;
+  msg.setStatusCode(200);
+  msg.setStatusMessage("OK");
+  msg.getHeaders().set(HTTP_HEADER_CACHE_CONTROL, "max-age=60");
+  return msg;
+}
+
+} // namespace
+
+class ResponseCacheFilterTest : public Test {
+ public:
+  void SetUp() override {
+    folly::EventBaseManager::get()->setEventBase(&evb_, false);
+    cache_ = std::make_shared<ResponseCache>();
+  }
+
+ protected:
+  // Builds a filter wired to fresh mocks; the filter deletes itself on
+  // requestComplete(), the mocks outlive it for verification
+  ResponseCacheFilter* makeFilter(MockRequestHandler& upstream,
+                                  MockResponseHandler& client) {
+    auto filter = new ResponseCacheFilter(
+        &upstream, cache_, std::chrono::seconds(60), 1024 * 1024);
+    EXPECT_CALL(upstream, setResponseHandler(_));
+    filter->setResponseHandler(&client);
+    return filter;
+  }
+
+  folly::EventBase evb_;
+  std::shared_ptr<ResponseCache> cache_;
+};
+
+TEST_F(ResponseCacheFilterTest, MissFillsThenHitServesSharedBody) {
+  const std::string bodyText = "rendered response body";
+  const uint8_t* masterData = nullptr;
+
+  // First request misses and streams the handler's response through
+  // while capturing it
+  MockRequestHandler upstream1;
+  MockResponseHandler client1(&upstream1);
+  auto filter1 = makeFilter(upstream1, client1);
+  EXPECT_CALL(upstream1, onRequest(_));
+  EXPECT_CALL(upstream1, onEOM());
+  EXPECT_CALL(client1, sendHeaders(_));
+  EXPECT_CALL(client1, sendBody(_))
+      .WillOnce(Invoke([&](std::shared_ptr<folly::IOBuf> body) {
+        masterData = body->data();
+      }));
+  EXPECT_CALL(client1, sendEOM());
+
+  filter1->onRequest(makeGetRequest("/render"));
+  filter1->onEOM();
+  auto response = makeOkResponse();
+  filter1->sendHeaders(response);
+  filter1->sendBody(folly::IOBuf::copyBuffer(bodyText));
+  filter1->sendEOM();
+  EXPECT_CALL(upstream1, requestComplete());
+  filter1->requestComplete();
+
+  // Second request hits: the handler is never invoked and the body
+  // shares the cached buffer instead of copying it
+  MockRequestHandler upstream2;
+  MockResponseHandler client2(&upstream2);
+  auto filter2 = makeFilter(upstream2, client2);
+  EXPECT_CALL(upstream2, onRequest(_)).Times(0);
+  EXPECT_CALL(upstream2, onEOM()).Times(0);
+  EXPECT_CALL(client2, sendHeaders(_)).WillOnce(Invoke([](HTTPMessage& msg) {
+    EXPECT_EQ(msg.getStatusCode(), 200);
+  }));
+  EXPECT_CALL(client2, sendBody(_))
+      .WillOnce(Invoke([&](std::shared_ptr<folly::IOBuf> body) {
+        EXPECT_EQ(body->data(), masterData);
+        EXPECT_EQ(body->clone()->moveToFbString().toStdString(), bodyText);
+      }));
+  EXPECT_CALL(client2, sendEOM());
+
+  filter2->onRequest(makeGetRequest("/render"));
+  filter2->onEOM();
+  EXPECT_CALL(upstream2, requestComplete());
+  filter2->requestComplete();
+}
+
+TEST_F(ResponseCacheFilterTest, ConcurrentMissCoalescesOntoOneFill) {
+  // The second request for the key parks instead of reaching its handler
+  MockRequestHandler upstream1;
+  MockResponseHandler client1(&upstream1);
+  auto filter1 = makeFilter(upstream1, client1);
+  MockRequestHandler upstream2;
+  MockResponseHandler client2(&upstream2);
+  auto filter2 = makeFilter(upstream2, client2);
+
+  EXPECT_CALL(upstream1, onRequest(_));
+  EXPECT_CALL(upstream1, onEOM());
+  EXPECT_CALL(upstream2, onRequest(_)).Times(0);
+  EXPECT_CALL(upstream2, onEOM()).Times(0);
+  EXPECT_CALL(client1, sendHeaders(_));
+  EXPECT_CALL(client1, sendBody(_));
+  EXPECT_CALL(client1, sendEOM());
+
+  filter1->onRequest(makeGetRequest("/render"));
+  filter1->onEOM();
+  filter2->onRequest(makeGetRequest("/render"));
+  filter2->onEOM();
+
+  // The owner's fill completes and the parked request is answered from
+  // the fresh entry
+  EXPECT_CALL(client2, sendHeaders(_));
+  EXPECT_CALL(client2, sendBody(_));
+  EXPECT_CALL(client2, sendEOM());
+  auto response = makeOkResponse();
+  filter1->sendHeaders(response);
+  filter1->sendBody(folly::IOBuf::copyBuffer("rendered once"));
+  filter1->sendEOM();
+  evb_.loop();
+
+  EXPECT_CALL(upstream1, requestComplete());
+  filter1->requestComplete();
+  EXPECT_CALL(upstream2, requestComplete());
+  filter2->requestComplete();
+}
+
+TEST_F(ResponseCacheFilterTest, UncacheableResponseWakesWaiterToItsHandler) {
+  MockRequestHandler upstream1;
+  MockResponseHandler client1(&upstream1);
+  auto filter1 = makeFilter(upstream1, client1);
+  MockRequestHandler upstream2;
+  MockResponseHandler client2(&upstream2);
+  auto filter2 = makeFilter(upstream2, client2);
+
+  EXPECT_CALL(upstream1, onRequest(_));
+  EXPECT_CALL(upstream1, onEOM());
+  EXPECT_CALL(client1, sendHeaders(_));
+  EXPECT_CALL(client1, sendBody(_));
+  EXPECT_CALL(client1, sendEOM());
+
+  filter1->onRequest(makeGetRequest("/private"));
+  filter1->onEOM();
+  filter2->onRequest(makeGetRequest("/private"));
+  filter2->onEOM();
+
+  // no-store: nothing is cached, so the waiter falls through to its own
+  // handler with the stashed request and EOM
+  EXPECT_CALL(upstream2, onRequest(_));
+  EXPECT_CALL(upstream2, onEOM());
+  auto response = makeOkResponse();
+  response.getHeaders().set(HTTP_HEADER_CACHE_CONTROL, "no-store");
+  filter1->sendHeaders(response);
+  filter1->sendBody(folly::IOBuf::copyBuffer("secret"));
+  filter1->sendEOM();
+  evb_.loop();
+
+  EXPECT_EQ(cache_->get("GET /private"), nullptr);
+
+  EXPECT_CALL(upstream1, requestComplete());
+  filter1->requestComplete();
+  EXPECT_CALL(upstream2, requestComplete());
+  filter2->requestComplete();
+}
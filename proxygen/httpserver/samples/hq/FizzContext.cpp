@@ -13,7 +13,10 @@
 #include <fizz/server/AeadTicketCipher.h>
 #include <fizz/server/CertManager.h>
 #include <fizz/server/TicketCodec.h>
+#include <folly/String.h>
+#include <folly/Synchronized.h>
 #include <string>
+#include <unordered_map>
 
 namespace {
 const std::string kDefaultCertData = R"(
@@ -210,6 +213,30 @@ FizzClientContextPtr createFizzClientContext(const HQParams& params) {
   return ctx;
 }
 
+FizzClientContextPtr getCachedFizzClientContext(const HQParams& params) {
+  // Key on everything createFizzClientContext reads from the params
+  auto key = folly::to<std::string>(params.certificateFilePath,
+                                    '\0',
+                                    params.keyFilePath,
+                                    '\0',
+                                    folly::join(',', params.supportedAlpns),
+                                    '\0',
+                                    params.earlyData);
+  static folly::Synchronized<
+      std::unordered_map<std::string, FizzClientContextPtr>>
+      cache;
+  {
+    auto locked = cache.rlock();
+    auto iter = locked->find(key);
+    if (iter != locked->end()) {
+      return iter->second;
+    }
+  }
+  auto ctx = createFizzClientContext(params);
+  // On a race the first insert wins, so every caller shares one context
+  return cache.wlock()->emplace(key, std::move(ctx)).first->second;
+}
+
 wangle::SSLContextConfig createSSLContext(const HQParams& params) {
   wangle::SSLContextConfig sslCfg;
   sslCfg.isDefault = true;
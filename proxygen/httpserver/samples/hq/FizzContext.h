@@ -24,5 +24,13 @@ FizzServerContextPtr createFizzServerContext(const HQParams& params);
 
 FizzClientContextPtr createFizzClientContext(const HQParams& params);
 
+/**
+ * Cached variant of createFizzClientContext.  The context is immutable
+ * once built, so clients opening many short-lived connections share one
+ * instance per distinct parameter set instead of re-reading cert files
+ * and rebuilding the decompression manager on every connect.
+ */
+FizzClientContextPtr getCachedFizzClientContext(const HQParams& params);
+
 wangle::SSLContextConfig createSSLContext(const HQParams& params);
 }} // namespace quic::samples
@@ -20,6 +20,7 @@
 
 #include <proxygen/httpserver/samples/hq/FizzContext.h>
 #include <proxygen/httpserver/samples/hq/HQLoggerHelper.h>
+#include <proxygen/httpserver/samples/hq/StreamingResponseHandler.h>
 #include <proxygen/httpserver/samples/hq/InsecureVerifierDangerousDoNotUseInProduction.h>
 #include <proxygen/lib/http/codec/HTTP1xCodec.h>
 #include <proxygen/lib/utils/UtilInl.h>
@@ -29,6 +30,51 @@
 #include <quic/fizz/client/handshake/FizzClientQuicHandshakeContext.h>
 #include <quic/logging/FileQLogger.h>
 
+namespace {
+
+/**
+ * Sink mirroring CurlClient's console behavior for --stream_response:
+ * body chunks go to stdout as they arrive and are then dropped, so
+ * memory stays flat no matter how large the response is.
+ */
+class ConsoleStreamingSink : public quic::samples::StreamingSink {
+ public:
+  ConsoleStreamingSink(bool logResponse, bool logHeaders)
+      : logResponse_(logResponse), logHeaders_(logHeaders) {
+  }
+
+  void onHeaders(std::unique_ptr<proxygen::HTTPMessage> msg) override {
+    if (logHeaders_) {
+      msg->dumpMessage(0);
+    }
+  }
+
+  bool onBodyChunk(std::unique_ptr<folly::IOBuf> chain) override {
+    if (logResponse_) {
+      for (const auto& buf : *chain) {
+        fwrite(buf.data(), 1, buf.size(), stdout);
+      }
+    }
+    return true;
+  }
+
+  void onComplete() override {
+    if (logResponse_) {
+      fflush(stdout);
+    }
+  }
+
+  void onStreamingError(const proxygen::HTTPException& error) override {
+    LOG(ERROR) << "streaming request error: " << error.what();
+  }
+
+ private:
+  const bool logResponse_;
+  const bool logHeaders_;
+};
+
+} // namespace
+
 namespace quic { namespace samples {
 
 HQClient::HQClient(const HQParams& params) : params_(params) {
@@ -73,8 +119,47 @@ void HQClient::start() {
   evb_.loop();
 }
 
+proxygen::HTTPTransaction* FOLLY_NULLABLE
+HQClient::sendStreamingRequest(const proxygen::URL& requestUrl) {
+  proxygen::HTTPMessage request;
+  request.setMethod(params_.httpMethod);
+  request.setHTTPVersion(params_.httpVersion.major, params_.httpVersion.minor);
+  request.setURL(requestUrl.makeRelativeURL());
+  request.setSecure(true);
+  params_.httpHeaders.forEach([&](const std::string& name,
+                                  const std::string& value) {
+    request.getHeaders().add(name, value);
+  });
+  if (!request.getHeaders().exists(proxygen::HTTP_HEADER_HOST)) {
+    request.getHeaders().set(proxygen::HTTP_HEADER_HOST,
+                             requestUrl.getHostAndPort());
+  }
+  if (!request.getHeaders().exists(proxygen::HTTP_HEADER_USER_AGENT)) {
+    request.getHeaders().set(proxygen::HTTP_HEADER_USER_AGENT, "hq");
+  }
+
+  auto sink = std::make_unique<ConsoleStreamingSink>(
+      params_.logResponse, params_.logResponseHeaders);
+  // Self-deleting; the finished callback keeps draining pending paths
+  auto handler = new StreamingResponseHandler(std::move(sink), [this] {
+    if (streamingEOMFunc_) {
+      streamingEOMFunc_();
+    }
+  });
+  auto txn = session_->newTransaction(handler);
+  if (!txn) {
+    delete handler;
+    return nullptr;
+  }
+  handler->sendRequest(txn, request);
+  return txn;
+}
+
 proxygen::HTTPTransaction* FOLLY_NULLABLE
 HQClient::sendRequest(const proxygen::URL& requestUrl) {
+  if (params_.streamResponses) {
+    return sendStreamingRequest(requestUrl);
+  }
   std::unique_ptr<CurlService::CurlClient> client =
       std::make_unique<CurlService::CurlClient>(&evb_,
                                                 params_.httpMethod,
@@ -156,8 +241,12 @@ void HQClient::connectSuccess() {
             std::max(rtt, std::chrono::milliseconds(1)));
       }
     };
-    CHECK(!curls_.empty());
-    curls_.back()->setEOMFunc(selfSchedulingRequestRunner);
+    if (params_.streamResponses) {
+      streamingEOMFunc_ = selfSchedulingRequestRunner;
+    } else {
+      CHECK(!curls_.empty());
+      curls_.back()->setEOMFunc(selfSchedulingRequestRunner);
+    }
   }
 }
 
@@ -196,7 +285,7 @@ void HQClient::initializeQuicClient() {
       &evb_,
       std::move(sock),
       quic::FizzClientQuicHandshakeContext::Builder()
-          .setFizzClientContext(createFizzClientContext(params_))
+          .setFizzClientContext(getCachedFizzClientContext(params_))
           .setCertificateVerifier(
               std::make_unique<
                   proxygen::InsecureVerifierDangerousDoNotUseInProduction>())
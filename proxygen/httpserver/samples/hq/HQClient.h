@@ -33,6 +33,9 @@ class HQClient : private proxygen::HQSession::ConnectCallback {
  private:
   proxygen::HTTPTransaction* sendRequest(const proxygen::URL& requestUrl);
 
+  proxygen::HTTPTransaction* sendStreamingRequest(
+      const proxygen::URL& requestUrl);
+
   void sendRequests(bool closeSession, uint64_t numOpenableStreams);
 
   void sendKnobFrame(const folly::StringPiece str);
@@ -59,6 +62,9 @@ class HQClient : private proxygen::HQSession::ConnectCallback {
 
   std::list<std::unique_ptr<CurlService::CurlClient>> curls_;
 
+  // Invoked as streaming requests finish, to keep issuing pending paths
+  std::function<void()> streamingEOMFunc_;
+
   std::deque<folly::StringPiece> httpPaths_;
 };
 
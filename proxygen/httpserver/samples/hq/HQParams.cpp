@@ -42,6 +42,10 @@ DEFINE_bool(log_response,
 DEFINE_bool(log_response_headers,
             false,
             "Whether to log the response headers to stderr");
+DEFINE_bool(stream_response,
+            false,
+            "(HQClient) consume response bodies through the streaming "
+            "sink API instead of the buffering CurlClient handler");
 DEFINE_string(congestion, "cubic", "newreno/cubic/bbr/none");
 DEFINE_int32(conn_flow_control, 1024 * 1024 * 10, "Connection flow control");
 DEFINE_int32(stream_flow_control, 256 * 1024, "Stream flow control");
@@ -107,6 +111,10 @@ DEFINE_string(transport_knobs,
               "",
               "If send_knob_frame is set, this is the default transport knobs"
               " sent to peer");
+DEFINE_uint32(quic_host_id,
+              0,
+              "Host id encoded into server-chosen connection IDs, used to "
+              "route packets from migrated clients to the owning worker");
 DEFINE_bool(d6d_enabled, false, "Enable d6d");
 DEFINE_uint32(d6d_probe_raiser_constant_step_size,
               10,
@@ -187,6 +195,7 @@ void initializeCommonSettings(HQParams& hqParams) {
   hqParams.logdir = FLAGS_logdir;
   hqParams.logResponse = FLAGS_log_response;
   hqParams.logResponseHeaders = FLAGS_log_response_headers;
+  hqParams.streamResponses = FLAGS_stream_response;
   if (FLAGS_mode == "server") {
     CHECK(FLAGS_local_address.empty())
         << "local_address only allowed in client mode";
@@ -289,6 +298,7 @@ void initializeTransportSettings(HQParams& hqParams) {
   }
   hqParams.connectTimeout = std::chrono::milliseconds(FLAGS_connect_timeout);
   hqParams.ccpConfig = FLAGS_ccp_config;
+  hqParams.quicHostId = FLAGS_quic_host_id;
   hqParams.sendKnobFrame = FLAGS_send_knob_frame;
   if (hqParams.sendKnobFrame) {
     hqParams.transportSettings.knobs.push_back({kDefaultQuicTransportKnobSpace,
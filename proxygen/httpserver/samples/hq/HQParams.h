@@ -53,6 +53,7 @@ struct HQParams {
   std::string outdir;
   bool logResponse;
   bool logResponseHeaders;
+  bool streamResponses{false};
 
   // Transport section
   std::string host;
@@ -73,6 +74,7 @@ struct HQParams {
   std::chrono::milliseconds connectTimeout;
   std::string ccpConfig;
   bool sendKnobFrame;
+  uint32_t quicHostId{0};
 
   // HTTP section
   uint16_t h2port;
@@ -194,6 +194,14 @@ HQServer::HQServer(
       std::make_shared<ServerCongestionControllerFactory>());
   server_->setTransportSettings(params_.transportSettings);
 
+  // Encode routing information in server-chosen connection IDs.  Clients
+  // migrate paths (NAT rebind, WiFi to cell) and the kernel hashes migrated
+  // packets to an arbitrary worker; with host/process id set, the transport
+  // can parse the worker id out of the destination CID and forward the
+  // packet straight to the owning worker instead of bouncing it.
+  server_->setProcessId(quic::ProcessId::ZERO);
+  server_->setHostId(params_.quicHostId);
+
   if (params_.transportSettings.defaultCongestionController ==
       quic::CongestionControlType::CCP) {
     quicCcpThreadLauncher_.start(params_.ccpConfig);
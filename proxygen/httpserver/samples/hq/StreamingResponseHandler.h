@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <folly/Function.h>
+#include <proxygen/lib/http/HTTPMessage.h>
+#include <proxygen/lib/http/session/HTTPTransaction.h>
+
+namespace quic { namespace samples {
+
+/**
+ * Consumer side of a streaming response.  Body chunks arrive as the
+ * codec's own ref-counted IOBuf chains, straight from the transaction
+ * with no intermediate queueing or copying; the sink may hold on to
+ * them as long as it likes.  All callbacks run on the session's
+ * EventBase.
+ */
+class StreamingSink {
+ public:
+  virtual ~StreamingSink() = default;
+
+  virtual void onHeaders(std::unique_ptr<proxygen::HTTPMessage> msg) = 0;
+
+  /**
+   * One body chunk.  Return false to pause ingress (flow control stops
+   * the peer shortly after); deliver resumption via the resume callback
+   * handed to onStreamingStart.
+   */
+  virtual bool onBodyChunk(std::unique_ptr<folly::IOBuf> chain) = 0;
+
+  virtual void onComplete() = 0;
+
+  virtual void onStreamingError(const proxygen::HTTPException& error) = 0;
+
+  /**
+   * Called once before any other callback with a function the sink can
+   * invoke (on the session's EventBase) to resume ingress after
+   * onBodyChunk returned false.  The function is safe to call until
+   * onComplete/onStreamingError.
+   */
+  virtual void onStreamingStart(folly::Function<void()> /*resume*/) {
+  }
+};
+
+/**
+ * Transaction handler that pipes a response into a StreamingSink.
+ * Sends the request, forwards headers and every body chunk as-is, and
+ * translates the sink's backpressure into pauseIngress/resumeIngress.
+ * Self-deleting: owns the sink and destroys both on detach, reporting
+ * completion through the onFinished callback first.
+ */
+class StreamingResponseHandler : public proxygen::HTTPTransactionHandler {
+ public:
+  StreamingResponseHandler(std::unique_ptr<StreamingSink> sink,
+                           folly::Function<void()> onFinished)
+      : sink_(std::move(sink)), onFinished_(std::move(onFinished)) {
+  }
+
+  void sendRequest(proxygen::HTTPTransaction* txn,
+                   const proxygen::HTTPMessage& request) {
+    sink_->onStreamingStart([this] {
+      if (txn_ != nullptr) {
+        txn_->resumeIngress();
+      }
+    });
+    txn->sendHeadersWithEOM(request);
+  }
+
+  void setTransaction(proxygen::HTTPTransaction* txn) noexcept override {
+    txn_ = txn;
+  }
+
+  void detachTransaction() noexcept override {
+    txn_ = nullptr;
+    if (onFinished_) {
+      onFinished_();
+    }
+    delete this;
+  }
+
+  void onHeadersComplete(
+      std::unique_ptr<proxygen::HTTPMessage> msg) noexcept override {
+    sink_->onHeaders(std::move(msg));
+  }
+
+  void onBody(std::unique_ptr<folly::IOBuf> chain) noexcept override {
+    if (!sink_->onBodyChunk(std::move(chain)) && txn_ != nullptr) {
+      txn_->pauseIngress();
+    }
+  }
+
+  void onChunkHeader(size_t /*length*/) noexcept override {
+  }
+
+  void onChunkComplete() noexcept override {
+  }
+
+  void onTrailers(
+      std::unique_ptr<proxygen::HTTPHeaders> /*trailers*/) noexcept override {
+  }
+
+  void onEOM() noexcept override {
+    sink_->onComplete();
+  }
+
+  void onUpgrade(proxygen::UpgradeProtocol /*protocol*/) noexcept override {
+  }
+
+  void onError(const proxygen::HTTPException& error) noexcept override {
+    sink_->onStreamingError(error);
+  }
+
+  void onEgressPaused() noexcept override {
+  }
+
+  void onEgressResumed() noexcept override {
+  }
+
+ private:
+  std::unique_ptr<StreamingSink> sink_;
+  folly::Function<void()> onFinished_;
+  proxygen::HTTPTransaction* txn_{nullptr};
+};
+
+}} // namespace quic::samples
@@ -17,6 +17,7 @@
 #include <proxygen/lib/utils/URL.h>
 
 #include "ProxyStats.h"
+#include <proxygen/lib/utils/SocketTunnel.h>
 
 using namespace proxygen;
 using std::string;
@@ -69,7 +70,7 @@ void ProxyHandler::onRequest(std::unique_ptr<HTTPMessage> headers) noexcept {
   LOG(INFO) << "Trying to connect to " << addr;
   auto evb = folly::EventBaseManager::get()->getEventBase();
   if (request_->getMethod() == HTTPMethod::CONNECT) {
-    upstreamSock_ = folly::AsyncSocket::newSocket(evb);
+    upstreamSock_ = folly::AsyncSocket::UniquePtr(new folly::AsyncSocket(evb));
     upstreamSock_->connect(this, addr, FLAGS_proxy_connect_timeout);
   } else {
     // A more sophisticated proxy would have a connection pool here
@@ -216,6 +217,10 @@ void ProxyHandler::abortDownstream() {
 }
 
 bool ProxyHandler::checkForShutdown() {
+  if (tunnelStarting_) {
+    // maybeStartTunnel() is mid hand-off; it finishes the shutdown check
+    return false;
+  }
   if (clientTerminated_ && !txn_ &&
       (!upstreamSock_ || (sockStatus_ == CLOSED && !upstreamEgressPaused_))) {
     delete this;
@@ -225,10 +230,49 @@ bool ProxyHandler::checkForShutdown() {
 }
 
 void ProxyHandler::connectSuccess() noexcept {
-  LOG(INFO) << "Connected to upstream " << upstreamSock_;
+  LOG(INFO) << "Connected to upstream " << upstreamSock_.get();
   ResponseBuilder(downstream_).status(200, "OK").send();
   upstreamSock_->setReadCB(this);
   downstream_->resumeIngress();
+  // Once the 200 is on the wire, try to collapse both sides into a raw
+  // relay that bypasses the codec for the rest of the connection
+  folly::EventBaseManager::get()->getEventBase()->runInLoop(&tunnelProbe_);
+}
+
+void ProxyHandler::maybeStartTunnel() {
+  if (clientTerminated_ || !upstreamSock_) {
+    return;
+  }
+  auto clientTxn = downstream_->getTransaction();
+  if (!clientTxn) {
+    return;
+  }
+  // Extraction errors out the client transaction; move the upstream
+  // socket aside first so our onError doesn't tear it down, and hold
+  // off self-deletion until the tunnel owns both sockets.
+  tunnelStarting_ = true;
+  auto upstreamSock = std::move(upstreamSock_);
+  auto downstreamSock = clientTxn->extractTunnelTransport();
+  if (!downstreamSock) {
+    // Most likely the 200 hasn't flushed yet; retry a couple of times
+    // before settling for the transaction-based relay
+    tunnelStarting_ = false;
+    upstreamSock_ = std::move(upstreamSock);
+    if (++tunnelAttempts_ < 3) {
+      folly::EventBaseManager::get()->getEventBase()->runInLoop(&tunnelProbe_);
+    }
+    return;
+  }
+  LOG(INFO) << "Collapsing CONNECT into a raw tunnel";
+  upstreamSock->setReadCB(nullptr);
+  auto* stats = stats_;
+  SocketTunnel::start(std::move(downstreamSock),
+                      std::move(upstreamSock),
+                      [stats](uint64_t bytesToServer, uint64_t bytesToClient) {
+                        stats->recordTunnelBytes(bytesToServer, bytesToClient);
+                      });
+  tunnelStarting_ = false;
+  checkForShutdown();
 }
 
 void ProxyHandler::connectErr(const folly::AsyncSocketException& ex) noexcept {
@@ -11,6 +11,7 @@
 #include "SessionWrapper.h"
 #include <folly/Memory.h>
 #include <folly/io/async/AsyncSocket.h>
+#include <folly/io/async/EventBase.h>
 #include <proxygen/httpserver/RequestHandler.h>
 #include <proxygen/lib/http/HTTPConnector.h>
 
@@ -126,6 +127,25 @@ class ProxyHandler
   void abortDownstream();
   bool checkForShutdown();
 
+  // Tries to collapse an established CONNECT into a raw SocketTunnel,
+  // bypassing the HTTP codec for the rest of the connection
+  void maybeStartTunnel();
+
+  // Schedules tunnel attempts after the current loop's writes; cancels
+  // itself if the handler dies first
+  class TunnelProbe : public folly::EventBase::LoopCallback {
+   public:
+    explicit TunnelProbe(ProxyHandler& parent) : parent_(parent) {
+    }
+
+    void runLoopCallback() noexcept override {
+      parent_.maybeStartTunnel();
+    }
+
+   private:
+    ProxyHandler& parent_;
+  };
+
   ProxyStats* const stats_{nullptr};
   proxygen::HTTPConnector connector_;
   ServerTransactionHandler serverHandler_;
@@ -136,11 +156,14 @@ class ProxyHandler
   std::unique_ptr<proxygen::HTTPMessage> request_;
 
   // Only for CONNECT
-  std::shared_ptr<folly::AsyncSocket> upstreamSock_;
+  folly::AsyncSocket::UniquePtr upstreamSock_;
   uint8_t sockStatus_{0};
   folly::IOBufQueue body_{folly::IOBufQueue::cacheChainLength()};
   bool downstreamIngressPaused_{false};
   bool upstreamEgressPaused_{false};
+  TunnelProbe tunnelProbe_{*this};
+  uint8_t tunnelAttempts_{0};
+  bool tunnelStarting_{false};
 };
 
 } // namespace ProxyService
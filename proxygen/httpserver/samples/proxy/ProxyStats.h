@@ -35,8 +35,27 @@ class ProxyStats {
     return reqCount_;
   }
 
+  // Byte accounting reported by SocketTunnel when a collapsed CONNECT
+  // relay closes; tunneled bytes never pass through the HTTP codec, so
+  // this is the only place they are counted
+  virtual void recordTunnelBytes(uint64_t bytesToServer,
+                                 uint64_t bytesToClient) {
+    tunnelBytesToServer_ += bytesToServer;
+    tunnelBytesToClient_ += bytesToClient;
+  }
+
+  virtual uint64_t getTunnelBytesToServer() {
+    return tunnelBytesToServer_;
+  }
+
+  virtual uint64_t getTunnelBytesToClient() {
+    return tunnelBytesToClient_;
+  }
+
  private:
   uint64_t reqCount_{0};
+  uint64_t tunnelBytesToServer_{0};
+  uint64_t tunnelBytesToClient_{0};
 };
 
 } // namespace ProxyService
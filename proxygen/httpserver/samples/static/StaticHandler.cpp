@@ -8,22 +8,106 @@
 
 #include "StaticHandler.h"
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <folly/FileUtil.h>
+#include <folly/Random.h>
+#include <folly/Synchronized.h>
 #include <folly/executors/GlobalExecutor.h>
 #include <folly/io/async/EventBaseManager.h>
 #include <proxygen/httpserver/RequestHandler.h>
 #include <proxygen/httpserver/ResponseBuilder.h>
+#include <proxygen/lib/http/RFC2616.h>
+#include <unordered_map>
 
 using namespace proxygen;
 
+namespace {
+
+// how much file data each body call hands to the transport
+constexpr size_t kSendChunkSize = 256 * 1024;
+
+// Touch one byte per page so disk I/O happens on the CPU pool thread via
+// page faults instead of blocking the IO thread later
+void prefaultPages(const uint8_t* addr, size_t len) {
+  static const size_t pageSize = sysconf(_SC_PAGESIZE);
+  volatile uint8_t sink = 0;
+  for (size_t off = 0; off < len; off += pageSize) {
+    sink += addr[off];
+  }
+  (void)sink;
+}
+
+} // namespace
+
 namespace StaticService {
 
 /**
  * Handles requests by serving the file named in path.  Only supports GET.
- * reads happen in a CPU thread pool since read(2) is blocking.
+ *
+ * Regular files are mmapped and egressed as IOBufs that reference the
+ * mapping directly, so file bytes are never copied through userspace; the
+ * kernel writes (or the TLS layer encrypts) straight out of the page cache.
+ * Page faults are taken on a CPU thread pool.  Mappings are shared across
+ * concurrent requests for the same file, and Range requests (single and
+ * multipart) are served as slices of the shared mapping.  Files that can't
+ * be mapped fall back to chunked read(2) on the same pool.
  * If egress pauses, file reading is also paused.
  */
 
+struct StaticHandler::FileMapping {
+  FileMapping(void* addr, size_t length, time_t mtime)
+      : addr(addr), length(length), mtime(mtime) {
+  }
+
+  ~FileMapping() {
+    ::munmap(addr, length);
+  }
+
+  void* addr;
+  size_t length;
+  // for cache revalidation
+  time_t mtime;
+};
+
+std::shared_ptr<StaticHandler::FileMapping> StaticHandler::getOrCreateMapping(
+    const std::string& path, int fd, size_t size, time_t mtime) {
+  // Mappings are shared across requests (and threads) for the same file;
+  // weak entries keep the cache from pinning files nobody is serving.
+  // Leaked so slices in flight at shutdown never outlive the cache.
+  static auto& cache = *new folly::Synchronized<
+      std::unordered_map<std::string, std::weak_ptr<FileMapping>>>();
+
+  {
+    auto rlocked = cache.rlock();
+    auto it = rlocked->find(path);
+    if (it != rlocked->end()) {
+      auto mapping = it->second.lock();
+      if (mapping && mapping->length == size && mapping->mtime == mtime) {
+        return mapping;
+      }
+      // stale or expired; fall through and remap
+    }
+  }
+
+  void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (addr == MAP_FAILED) {
+    return nullptr;
+  }
+  ::madvise(addr, size, MADV_SEQUENTIAL);
+  auto mapping = std::make_shared<FileMapping>(addr, size, mtime);
+
+  auto wlocked = cache.wlock();
+  // sweep dead entries so the map tracks the working set, not history
+  for (auto it = wlocked->begin(); it != wlocked->end();) {
+    it = it->second.expired() ? wlocked->erase(it) : std::next(it);
+  }
+  (*wlocked)[path] = mapping;
+  return mapping;
+}
+
 void StaticHandler::onRequest(std::unique_ptr<HTTPMessage> headers) noexcept {
   if (headers->getMethod() != HTTPMethod::GET) {
     ResponseBuilder(downstream_)
@@ -34,10 +118,10 @@ void StaticHandler::onRequest(std::unique_ptr<HTTPMessage> headers) noexcept {
   }
   // a real webserver would validate this path didn't contain malicious
   // characters like '//' or '..'
+  // + 1 to kill leading /
+  const std::string path = headers->getPathAsStringPiece().subpiece(1).str();
   try {
-    // + 1 to kill leading /
-    file_ = std::make_unique<folly::File>(
-        headers->getPathAsStringPiece().subpiece(1));
+    file_ = std::make_unique<folly::File>(path);
   } catch (const std::system_error& ex) {
     ResponseBuilder(downstream_)
         .status(404, "Not Found")
@@ -48,8 +132,94 @@ void StaticHandler::onRequest(std::unique_ptr<HTTPMessage> headers) noexcept {
         .sendWithEOM();
     return;
   }
-  ResponseBuilder(downstream_).status(200, "Ok").send();
-  // use a CPU executor since read(2) of a file can block
+  struct stat st;
+  if (fstat(file_->fd(), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    mapping_ = getOrCreateMapping(
+        path, file_->fd(), size_t(st.st_size), st.st_mtime);
+    if (mapping_) {
+      fileSize_ = size_t(st.st_size);
+    }
+  }
+
+  // Range requests are honored only on mapped files, where each range is
+  // a zero-copy slice of the shared mapping
+  if (mapping_) {
+    auto rangeValue =
+        headers->getHeaders().getSingleOrEmpty(HTTP_HEADER_RANGE);
+    std::vector<RFC2616::ByteRange> parsed;
+    if (!rangeValue.empty() &&
+        RFC2616::parseRangeRequest(rangeValue, fileSize_, parsed)) {
+      if (parsed.empty()) {
+        ResponseBuilder(downstream_)
+            .status(416, "Range Not Satisfiable")
+            .header(HTTP_HEADER_CONTENT_RANGE,
+                    folly::to<std::string>("bytes */", fileSize_))
+            .sendWithEOM();
+        return;
+      }
+      for (const auto& range : parsed) {
+        ranges_.emplace_back(size_t(range.first),
+                             size_t(range.second - range.first + 1));
+      }
+    }
+    // a malformed Range header is ignored and the full file served
+  }
+
+  ResponseBuilder builder(downstream_);
+  if (ranges_.empty()) {
+    builder.status(200, "Ok");
+    if (mapping_) {
+      builder.header(HTTP_HEADER_ACCEPT_RANGES, "bytes");
+      builder.header(HTTP_HEADER_CONTENT_LENGTH,
+                     folly::to<std::string>(fileSize_));
+      ranges_.emplace_back(0, fileSize_);
+    }
+  } else if (ranges_.size() == 1) {
+    builder.status(206, "Partial Content");
+    builder.header(HTTP_HEADER_ACCEPT_RANGES, "bytes");
+    builder.header(HTTP_HEADER_CONTENT_RANGE,
+                   folly::to<std::string>("bytes ",
+                                          ranges_[0].first,
+                                          "-",
+                                          ranges_[0].first +
+                                              ranges_[0].second - 1,
+                                          "/",
+                                          fileSize_));
+    builder.header(HTTP_HEADER_CONTENT_LENGTH,
+                   folly::to<std::string>(ranges_[0].second));
+  } else {
+    // multipart/byteranges: the boundary framing is built up front (it is
+    // tiny), while the payload of each part stays a slice of the mapping
+    const auto boundary =
+        folly::to<std::string>(folly::Random::rand64(), folly::Random::rand64());
+    size_t contentLength = 0;
+    partHeaders_.reserve(ranges_.size());
+    for (size_t i = 0; i < ranges_.size(); ++i) {
+      partHeaders_.push_back(
+          folly::to<std::string>(i == 0 ? "" : "\r\n",
+                                 "--",
+                                 boundary,
+                                 "\r\nContent-Range: bytes ",
+                                 ranges_[i].first,
+                                 "-",
+                                 ranges_[i].first + ranges_[i].second - 1,
+                                 "/",
+                                 fileSize_,
+                                 "\r\n\r\n"));
+      contentLength += partHeaders_.back().size() + ranges_[i].second;
+    }
+    multipartEpilogue_ = folly::to<std::string>("\r\n--", boundary, "--\r\n");
+    contentLength += multipartEpilogue_.size();
+    builder.status(206, "Partial Content");
+    builder.header(HTTP_HEADER_ACCEPT_RANGES, "bytes");
+    builder.header(
+        HTTP_HEADER_CONTENT_TYPE,
+        folly::to<std::string>("multipart/byteranges; boundary=", boundary));
+    builder.header(HTTP_HEADER_CONTENT_LENGTH,
+                   folly::to<std::string>(contentLength));
+  }
+  builder.send();
+  // use a CPU executor since faulting in file pages can block
   readFileScheduled_ = true;
   folly::getCPUExecutor()->add(
       std::bind(&StaticHandler::readFile,
@@ -58,6 +228,10 @@ void StaticHandler::onRequest(std::unique_ptr<HTTPMessage> headers) noexcept {
 }
 
 void StaticHandler::readFile(folly::EventBase* evb) {
+  if (mapping_) {
+    sendFromMapping(evb);
+    return;
+  }
   folly::IOBufQueue buf;
   while (file_ && !paused_) {
     // read 4k-ish chunks and foward each one to the client
@@ -97,6 +271,70 @@ void StaticHandler::readFile(folly::EventBase* evb) {
   });
 }
 
+void StaticHandler::sendFromMapping(folly::EventBase* evb) {
+  while (mapping_ && !paused_) {
+    const auto& range = ranges_[rangeIndex_];
+    std::unique_ptr<folly::IOBuf> body;
+    if (rangeBytesSent_ == 0 && !partHeaders_.empty()) {
+      body = folly::IOBuf::copyBuffer(partHeaders_[rangeIndex_]);
+    }
+    auto chunkLen = std::min(kSendChunkSize, range.second - rangeBytesSent_);
+    auto* base =
+        static_cast<uint8_t*>(mapping_->addr) + range.first + rangeBytesSent_;
+    prefaultPages(base, chunkLen);
+    // The chunk references the mapping; the last chunk freed by the
+    // transport drops the last reference and unmaps the file (unless the
+    // cache has handed the mapping to another request meanwhile)
+    auto chunk = folly::IOBuf::takeOwnership(
+        base,
+        chunkLen,
+        [](void* /*buf*/, void* userData) {
+          delete static_cast<std::shared_ptr<FileMapping>*>(userData);
+        },
+        new std::shared_ptr<FileMapping>(mapping_));
+    rangeBytesSent_ += chunkLen;
+    if (body) {
+      body->prependChain(std::move(chunk));
+    } else {
+      body = std::move(chunk);
+    }
+    bool eof = false;
+    if (rangeBytesSent_ == range.second) {
+      ++rangeIndex_;
+      rangeBytesSent_ = 0;
+      if (rangeIndex_ == ranges_.size()) {
+        if (!multipartEpilogue_.empty()) {
+          body->prependChain(folly::IOBuf::copyBuffer(multipartEpilogue_));
+        }
+        eof = true;
+      }
+    }
+    evb->runInEventBaseThread([this, body = std::move(body), eof]() mutable {
+      ResponseBuilder builder(downstream_);
+      builder.body(std::move(body));
+      if (eof) {
+        builder.sendWithEOM();
+      } else {
+        builder.send();
+      }
+    });
+    if (eof) {
+      VLOG(4) << "Sent EOF";
+      mapping_.reset();
+      file_.reset();
+    }
+  }
+
+  // Notify the request thread that we terminated the send loop
+  evb->runInEventBaseThread([this] {
+    readFileScheduled_ = false;
+    if (!checkForCompletion() && !paused_) {
+      VLOG(4) << "Resuming deferred sendFromMapping";
+      onEgressResumed();
+    }
+  });
+}
+
 void StaticHandler::onEgressPaused() noexcept {
   // This will terminate readFile soon
   VLOG(4) << "StaticHandler paused";
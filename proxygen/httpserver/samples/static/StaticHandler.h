@@ -8,6 +8,10 @@
 
 #pragma once
 
+#include <string>
+#include <utility>
+#include <vector>
+
 #include <folly/File.h>
 #include <folly/Memory.h>
 #include <proxygen/httpserver/RequestHandler.h>
@@ -38,10 +42,36 @@ class StaticHandler : public proxygen::RequestHandler {
   void onEgressResumed() noexcept override;
 
  private:
+  struct FileMapping;
+
+  /**
+   * Look up (or create and cache) the shared mapping for path.  Entries
+   * are revalidated against the current size and mtime, so a changed
+   * file gets a fresh mapping while in-flight slices of the old one keep
+   * it alive until the transport frees them.
+   */
+  static std::shared_ptr<FileMapping> getOrCreateMapping(
+      const std::string& path, int fd, size_t size, time_t mtime);
+
   void readFile(folly::EventBase* evb);
+  void sendFromMapping(folly::EventBase* evb);
   bool checkForCompletion();
 
   std::unique_ptr<folly::File> file_;
+  // set when the file could be mmapped; body chunks then reference the
+  // mapping directly instead of copying through read(2)
+  std::shared_ptr<FileMapping> mapping_;
+  size_t fileSize_{0};
+  // (offset, length) segments of the mapping to egress, in order.  A full
+  // response is one segment covering the file; a Range request yields one
+  // per satisfiable range
+  std::vector<std::pair<size_t, size_t>> ranges_;
+  // multipart/byteranges framing, non-empty only for multi-range
+  // responses; payload slices still reference the mapping uncopied
+  std::vector<std::string> partHeaders_;
+  std::string multipartEpilogue_;
+  size_t rangeIndex_{0};
+  size_t rangeBytesSent_{0};
   bool readFileScheduled_{false};
   std::atomic<bool> paused_{false};
   bool finished_{false};
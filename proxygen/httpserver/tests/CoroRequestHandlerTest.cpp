@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/httpserver/CoroRequestHandler.h>
+
+#if FOLLY_HAS_COROUTINES
+
+#include <folly/io/async/EventBase.h>
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/httpserver/Mocks.h>
+
+using namespace proxygen;
+using namespace testing;
+
+namespace {
+
+// Collects the full body and echoes it back with a 200
+class EchoCoroHandler : public CoroRequestHandler {
+ public:
+  explicit EchoCoroHandler(bool* destroyed = nullptr)
+      : destroyed_(destroyed) {
+  }
+
+  ~EchoCoroHandler() override {
+    if (destroyed_) {
+      *destroyed_ = true;
+    }
+  }
+
+  folly::coro::Task<CoroHTTPResponse> co_handleRequest(
+      std::unique_ptr<HTTPMessage> /*request*/,
+      CoroBodyStream& body) override {
+    folly::IOBufQueue collected{folly::IOBufQueue::cacheChainLength()};
+    while (auto chunk = co_await body.next()) {
+      collected.append(std::move(chunk));
+    }
+    CoroHTTPResponse response;
+    response.headers.setStatusCode(200);
+    response.headers.setStatusMessage("OK");
+    response.body = collected.move();
+    co_return response;
+  }
+
+ private:
+  bool* destroyed_;
+};
+
+std::unique_ptr<HTTPMessage> makePost() {
+  auto msg = std::make_unique<HTTPMessage>();
+  msg->setURL("/echo");
+  msg->setMethod("POST");
+  return msg;
+}
+
+} // namespace
+
+class CoroRequestHandlerTest : public Test {
+ protected:
+  void SetUp() override {
+    folly::EventBaseManager::get()->setEventBase(&evb_, false);
+  }
+
+  folly::EventBase evb_;
+};
+
+TEST_F(CoroRequestHandlerTest, EchoesBody) {
+  auto* adaptor =
+      new CoroRequestHandlerAdaptor(std::make_unique<EchoCoroHandler>());
+  StrictMock<MockResponseHandler> responseHandler(adaptor);
+  adaptor->setResponseHandler(&responseHandler);
+
+  std::string echoed;
+  EXPECT_CALL(responseHandler, sendHeaders(_))
+      .WillOnce(Invoke(
+          [](HTTPMessage& msg) { EXPECT_EQ(msg.getStatusCode(), 200); }));
+  EXPECT_CALL(responseHandler, sendBody(_))
+      .WillOnce(Invoke([&echoed](std::shared_ptr<folly::IOBuf> body) {
+        echoed = body->clone()->moveToFbString().toStdString();
+      }));
+  EXPECT_CALL(responseHandler, sendEOM());
+
+  adaptor->onRequest(makePost());
+  adaptor->onBody(folly::IOBuf::copyBuffer("hello "));
+  adaptor->onBody(folly::IOBuf::copyBuffer("world"));
+  adaptor->onEOM();
+  evb_.loop();
+
+  EXPECT_EQ(echoed, "hello world");
+  adaptor->requestComplete(); // deletes the adaptor
+}
+
+TEST_F(CoroRequestHandlerTest, ErrorMidBodyCancelsTask) {
+  bool destroyed = false;
+  auto* adaptor = new CoroRequestHandlerAdaptor(
+      std::make_unique<EchoCoroHandler>(&destroyed));
+  StrictMock<MockResponseHandler> responseHandler(adaptor);
+  adaptor->setResponseHandler(&responseHandler);
+
+  // The transaction dies while the handler awaits more body; no response
+  // is sent and the adaptor cleans itself up once the task unwinds
+  adaptor->onRequest(makePost());
+  adaptor->onBody(folly::IOBuf::copyBuffer("partial"));
+  evb_.loop();
+  adaptor->onError(kErrorTimeout);
+  evb_.loop();
+
+  EXPECT_TRUE(destroyed);
+}
+
+#endif // FOLLY_HAS_COROUTINES
@@ -16,12 +16,14 @@
 #include <folly/io/async/AsyncServerSocket.h>
 #include <folly/io/async/EventBaseManager.h>
 #include <folly/portability/GTest.h>
+#include <folly/portability/Sockets.h>
 #include <folly/ssl/OpenSSLCertUtils.h>
 #include <folly/ssl/OpenSSLPtrTypes.h>
 #include <proxygen/httpclient/samples/curl/CurlClient.h>
 #include <proxygen/httpserver/HTTPServer.h>
 #include <proxygen/httpserver/ResponseBuilder.h>
 #include <proxygen/httpserver/ScopedHTTPServer.h>
+#include <proxygen/httpserver/ServerHandoff.h>
 #include <proxygen/lib/http/HTTPConnector.h>
 #include <proxygen/lib/utils/TestUtils.h>
 #include <wangle/acceptor/Acceptor.h>
@@ -190,6 +192,38 @@ TEST(HttpServerStartStop, TestUseExistingIoExecutor) {
   st->exitThread();
 }
 
+TEST(HttpServerStartStop, TestFirstListenerReadyCallback) {
+  std::vector<HTTPServer::IPConfig> ips = {
+      {folly::SocketAddress("127.0.0.1", 0), HTTPServer::Protocol::HTTP},
+      {folly::SocketAddress("127.0.0.1", 0), HTTPServer::Protocol::HTTP}};
+  HTTPServerOptions options;
+  options.threads = 2;
+  auto server = std::make_unique<HTTPServer>(std::move(options));
+  server->bind(ips);
+  std::atomic<uint32_t> readyCalls{0};
+  server->setOnFirstListenerReady([&] { ++readyCalls; });
+  auto st = std::make_unique<WaitableServerThread>(server.get());
+  EXPECT_TRUE(st->start());
+  // Fired exactly once, and no later than onSuccess
+  EXPECT_EQ(readyCalls.load(), 1);
+  server->stop();
+  st->exitThread();
+}
+
+TEST(HttpServerStartStop, TestIoUringBackendOption) {
+  HTTPServerOptions options;
+  options.ioUringBackend = true;
+  auto server = std::make_unique<HTTPServer>(std::move(options));
+  auto st = std::make_unique<WaitableServerThread>(server.get());
+  // Falls back to the default event base backend on hosts or builds
+  // without io_uring, so the server must come up either way
+  EXPECT_TRUE(st->start());
+
+  server->stop();
+  // Let the WaitableServerThread exit
+  st->exitThread();
+}
+
 class AcceptorFactoryForTest : public wangle::AcceptorFactory {
  public:
   std::shared_ptr<wangle::Acceptor> newAcceptor(
@@ -212,6 +246,52 @@ TEST(HttpServerStartStop, TestUseExistingAcceptorFactory) {
   st->exitThread();
 }
 
+TEST(HttpServerStartStop, TestDrainReportsCompletion) {
+  std::vector<HTTPServer::IPConfig> ips = {
+      {folly::SocketAddress("127.0.0.1", 0), HTTPServer::Protocol::HTTP}};
+  HTTPServerOptions options;
+  options.threads = 2;
+  auto server = std::make_unique<HTTPServer>(std::move(options));
+  server->bind(ips);
+  auto st = std::make_unique<WaitableServerThread>(server.get());
+  EXPECT_TRUE(st->start());
+
+  folly::Baton<> drained;
+  HTTPServer::DrainOptions drainOpts;
+  drainOpts.window = std::chrono::milliseconds(50);
+  drainOpts.progressCallback = [&](size_t remaining) {
+    if (remaining == 0) {
+      drained.post();
+    }
+  };
+  server->drain(drainOpts);
+  // With no connected sessions the workers report completion right away
+  EXPECT_TRUE(drained.try_wait_for(std::chrono::seconds(5)));
+
+  server->stop();
+  st->exitThread();
+}
+
+TEST(HttpServerStartStop, TestDrainWithCustomAcceptorFactory) {
+  HTTPServerOptions options;
+  auto server = std::make_unique<HTTPServer>(std::move(options));
+  auto acceptorFactory = std::make_shared<AcceptorFactoryForTest>();
+  auto st = std::make_unique<WaitableServerThread>(server.get());
+  EXPECT_TRUE(st->start(acceptorFactory));
+
+  // No HTTPSessionAcceptors to stagger; drain still reports completion
+  bool reportedZero = false;
+  HTTPServer::DrainOptions drainOpts;
+  drainOpts.progressCallback = [&](size_t remaining) {
+    reportedZero = remaining == 0;
+  };
+  server->drain(drainOpts);
+  EXPECT_TRUE(reportedZero);
+
+  server->stop();
+  st->exitThread();
+}
+
 // Make an SSL connection to the server
 class Cb : public folly::AsyncSocket::ConnectCallback {
  public:
@@ -618,6 +698,31 @@ TEST(GetListenSocket, TestBootstrapWithBinding) {
   ASSERT_NE(-1, socketFd);
 }
 
+#if defined(__linux__) && defined(TCP_NOTSENT_LOWAT)
+TEST(TCPTuning, AppliedToListener) {
+  HTTPServer::IPConfig cfg{folly::SocketAddress("127.0.0.1", 0),
+                           HTTPServer::Protocol::HTTP};
+  cfg.tcpTuning.notsentLowatBytes = 65536;
+
+  HTTPServerOptions options;
+  options.threads = 1;
+  options.handlerFactories =
+      RequestHandlerChain().addThen<TestHandlerFactory>().build();
+  auto server = std::make_unique<HTTPServer>(std::move(options));
+  server->bind({cfg});
+  auto st = std::make_unique<ServerThread>(server.get());
+  EXPECT_TRUE(st->start());
+
+  auto socketFd = server->getListenSocket();
+  ASSERT_NE(-1, socketFd);
+  uint32_t lowat = 0;
+  socklen_t len = sizeof(lowat);
+  ASSERT_EQ(
+      0, getsockopt(socketFd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &lowat, &len));
+  EXPECT_EQ(65536, lowat);
+}
+#endif
+
 TEST(UseExistingSocket, TestWithExistingAsyncServerSocket) {
   AsyncServerSocket::UniquePtr serverSocket(new folly::AsyncServerSocket);
   serverSocket->bind(0);
@@ -700,6 +805,49 @@ TEST(UseExistingSocket, TestWithMultipleSocketFds) {
   ASSERT_EQ(fdSocks[0], socketFd);
 }
 
+TEST(ServerHandoff, RoundTrip) {
+  AsyncServerSocket::UniquePtr serverSocket(new folly::AsyncServerSocket);
+  serverSocket->bind(0);
+  auto existingFd = serverSocket->getNetworkSocket().toFd();
+
+  folly::test::TemporaryDirectory tmpDir;
+  const auto path = (tmpDir.path() / "handoff.sock").string();
+  const std::string payload = "psk_cache_file";
+
+  // predecessor exports on one thread while the successor imports
+  std::thread predecessor([&] {
+    EXPECT_TRUE(handoff::exportListenSockets(
+        path, {existingFd}, payload, std::chrono::seconds(5)));
+  });
+  auto received = handoff::importListenSockets(path, std::chrono::seconds(5));
+  predecessor.join();
+
+  ASSERT_TRUE(received.hasValue());
+  ASSERT_EQ(1, received->fds.size());
+  EXPECT_EQ(payload, received->payload);
+
+  // the received duplicate must be usable as a listening socket
+  HTTPServerOptions options;
+  options.handlerFactories =
+      RequestHandlerChain().addThen<TestHandlerFactory>().build();
+  options.useExistingSockets(received->fds);
+
+  auto server = std::make_unique<HTTPServer>(std::move(options));
+  auto st = std::make_unique<ServerThread>(server.get());
+  server->bind(
+      {{folly::SocketAddress("127.0.0.1", 0), HTTPServer::Protocol::HTTP}});
+  EXPECT_TRUE(st->start());
+  EXPECT_NE(-1, server->getListenSocket());
+}
+
+TEST(ServerHandoff, ImportTimesOutWithoutPredecessor) {
+  folly::test::TemporaryDirectory tmpDir;
+  const auto path = (tmpDir.path() / "absent.sock").string();
+  auto received =
+      handoff::importListenSockets(path, std::chrono::milliseconds(100));
+  EXPECT_FALSE(received.hasValue());
+}
+
 class ScopedServerTest : public testing::Test {
  public:
   void SetUp() override {
@@ -814,6 +962,38 @@ TEST_F(ScopedServerTest, StartSSLWithInsecure) {
   EXPECT_EQ(200, resp->getStatusCode());
 }
 
+TEST_F(ScopedServerTest, SharedWorkerPool) {
+  // many servers attach to one pre-warmed pool, no threads per server
+  ScopedHTTPServer::WorkerPool pool(2);
+  for (int i = 0; i < 3; i++) {
+    auto server =
+        ScopedHTTPServer::startShared(pool, cfg_, createDefaultOpts());
+    address_ = server->getAddresses().front().address;
+    EXPECT_NE(0, address_.getPort());
+    auto client = connectPlainText();
+    auto resp = client->getResponse();
+    ASSERT_NE(nullptr, resp);
+    EXPECT_EQ(200, resp->getStatusCode());
+  }
+}
+
+TEST_F(ScopedServerTest, SharedWorkerPoolConcurrentServers) {
+  ScopedHTTPServer::WorkerPool pool(2);
+  auto server1 =
+      ScopedHTTPServer::startShared(pool, cfg_, createDefaultOpts());
+  auto server2 =
+      ScopedHTTPServer::startShared(pool, cfg_, createDefaultOpts());
+  EXPECT_NE(server1->getPort(), server2->getPort());
+
+  for (auto* server : {server1.get(), server2.get()}) {
+    address_ = server->getAddresses().front().address;
+    auto client = connectPlainText();
+    auto resp = client->getResponse();
+    ASSERT_NE(nullptr, resp);
+    EXPECT_EQ(200, resp->getStatusCode());
+  }
+}
+
 class ConnectionFilterTest : public ScopedServerTest {
  protected:
   HTTPServerOptions createDefaultOpts() override {
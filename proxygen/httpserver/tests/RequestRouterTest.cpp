@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/httpserver/RequestRouter.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+
+namespace {
+
+enum Routes : RequestRouter::HandlerId {
+  kRoot = 0,
+  kListUsers,
+  kGetUser,
+  kCreateUser,
+  kGetUserPost,
+  kStatic,
+  kHealth,
+};
+
+RequestRouter makeRouter() {
+  RequestRouter router;
+  router.addRoute(HTTPMethod::GET, "/", kRoot);
+  router.addRoute(HTTPMethod::GET, "/users", kListUsers);
+  router.addRoute(HTTPMethod::GET, "/users/:id", kGetUser);
+  router.addRoute(HTTPMethod::POST, "/users", kCreateUser);
+  router.addRoute(HTTPMethod::GET, "/users/:id/posts/:postId", kGetUserPost);
+  router.addRoute(HTTPMethod::GET, "/static/*path", kStatic);
+  router.addRoute(HTTPMethod::GET, "/users/health", kHealth);
+  router.compile();
+  return router;
+}
+
+} // namespace
+
+TEST(RequestRouterTest, LiteralRoutes) {
+  auto router = makeRouter();
+  EXPECT_EQ(router.match(HTTPMethod::GET, "/"), kRoot);
+  EXPECT_EQ(router.match(HTTPMethod::GET, "/users"), kListUsers);
+  EXPECT_EQ(router.match(HTTPMethod::POST, "/users"), kCreateUser);
+  EXPECT_EQ(router.match(HTTPMethod::GET, "/nope"), RequestRouter::kNoMatch);
+  // method must match too
+  EXPECT_EQ(router.match(HTTPMethod::DELETE, "/users"),
+            RequestRouter::kNoMatch);
+  // trailing and duplicate slashes are tolerated
+  EXPECT_EQ(router.match(HTTPMethod::GET, "/users/"), kListUsers);
+  EXPECT_EQ(router.match(HTTPMethod::GET, "//users"), kListUsers);
+}
+
+TEST(RequestRouterTest, ParamCapture) {
+  auto router = makeRouter();
+  RequestRouter::Params params;
+  EXPECT_EQ(router.match(HTTPMethod::GET, "/users/1234", &params), kGetUser);
+  EXPECT_EQ(params.count, 1);
+  EXPECT_EQ(params.get("id"), "1234");
+
+  params = RequestRouter::Params();
+  EXPECT_EQ(router.match(HTTPMethod::GET, "/users/42/posts/7", &params),
+            kGetUserPost);
+  EXPECT_EQ(params.count, 2);
+  EXPECT_EQ(params.get("id"), "42");
+  EXPECT_EQ(params.get("postId"), "7");
+  EXPECT_EQ(params.get("missing"), folly::StringPiece());
+}
+
+TEST(RequestRouterTest, LiteralBeatsParam) {
+  auto router = makeRouter();
+  RequestRouter::Params params;
+  // "/users/health" is registered literally and shadows "/users/:id"
+  EXPECT_EQ(router.match(HTTPMethod::GET, "/users/health", &params), kHealth);
+  EXPECT_EQ(params.count, 0);
+  // but the literal branch backtracks into the param when it dead-ends
+  EXPECT_EQ(router.match(HTTPMethod::GET, "/users/health/posts/9", &params),
+            kGetUserPost);
+  EXPECT_EQ(params.get("id"), "health");
+}
+
+TEST(RequestRouterTest, WildcardCapturesRest) {
+  auto router = makeRouter();
+  RequestRouter::Params params;
+  EXPECT_EQ(router.match(HTTPMethod::GET, "/static/css/site.css", &params),
+            kStatic);
+  EXPECT_EQ(params.get("path"), "css/site.css");
+
+  params = RequestRouter::Params();
+  EXPECT_EQ(router.match(HTTPMethod::GET, "/static/", &params), kStatic);
+  EXPECT_EQ(params.get("path"), folly::StringPiece());
+}
+
+TEST(RequestRouterTest, MatchOnHTTPMessage) {
+  auto router = makeRouter();
+  HTTPMessage msg;
+  msg.setMethod(HTTPMethod::GET);
+  msg.setURL("/users/99?verbose=1");
+  RequestRouter::Params params;
+  // query string is not part of the matched path
+  EXPECT_EQ(router.match(msg, &params), kGetUser);
+  EXPECT_EQ(params.get("id"), "99");
+}
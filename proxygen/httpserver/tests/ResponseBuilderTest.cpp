@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/httpserver/ResponseBuilder.h>
+
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/httpserver/Mocks.h>
+
+using namespace proxygen;
+using namespace testing;
+
+TEST(ResponseBuilderTest, MovedStringBodyIsZeroCopy) {
+  MockRequestHandler requestHandler;
+  MockResponseHandler handler(&requestHandler);
+  std::string body(1024, 'x');
+  const auto* bodyData = reinterpret_cast<const uint8_t*>(body.data());
+
+  std::shared_ptr<folly::IOBuf> sent;
+  HTTPMessage sentHeaders;
+  EXPECT_CALL(handler, sendHeaders(_)).WillOnce(SaveArg<0>(&sentHeaders));
+  EXPECT_CALL(handler, sendBody(_)).WillOnce(SaveArg<0>(&sent));
+  EXPECT_CALL(handler, sendEOM());
+
+  ResponseBuilder(&handler)
+      .status(200, "OK")
+      .body(std::move(body))
+      .sendWithEOM();
+
+  ASSERT_TRUE(sent);
+  // the string's heap buffer was adopted, not copied
+  EXPECT_EQ(sent->data(), bodyData);
+  EXPECT_EQ(sent->computeChainDataLength(), 1024);
+  EXPECT_EQ(
+      sentHeaders.getHeaders().getSingleOrEmpty(HTTP_HEADER_CONTENT_LENGTH),
+      "1024");
+}
+
+TEST(ResponseBuilderTest, IOBufChainBodyIsChained) {
+  MockRequestHandler requestHandler;
+  MockResponseHandler handler(&requestHandler);
+  auto first = folly::IOBuf::copyBuffer("hello ");
+  auto second = folly::IOBuf::copyBuffer("world");
+  const auto* firstData = first->data();
+
+  std::shared_ptr<folly::IOBuf> sent;
+  EXPECT_CALL(handler, sendHeaders(_));
+  EXPECT_CALL(handler, sendBody(_)).WillOnce(SaveArg<0>(&sent));
+  EXPECT_CALL(handler, sendEOM());
+
+  ResponseBuilder(&handler)
+      .status(200, "OK")
+      .body(std::move(first))
+      .body(std::move(second))
+      .sendWithEOM();
+
+  ASSERT_TRUE(sent);
+  EXPECT_EQ(sent->data(), firstData);
+  EXPECT_EQ(sent->computeChainDataLength(), 11);
+}
+
+TEST(ResponseBuilderTest, HeadersBuiltInPlace) {
+  MockRequestHandler requestHandler;
+  MockResponseHandler handler(&requestHandler);
+  ResponseBuilder builder(&handler);
+  EXPECT_EQ(builder.getHeaders(), nullptr);
+  builder.status(404, "Not Found").header("x-reason", "missing");
+  ASSERT_NE(builder.getHeaders(), nullptr);
+  EXPECT_EQ(builder.getHeaders()->getStatusCode(), 404);
+
+  EXPECT_CALL(handler, sendHeaders(_));
+  EXPECT_CALL(handler, sendEOM());
+  builder.sendWithEOM();
+  // consumed by the send
+  EXPECT_EQ(builder.getHeaders(), nullptr);
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/httpserver/SSEStream.h>
+
+#include <folly/io/async/EventBase.h>
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/httpserver/Mocks.h>
+
+using namespace proxygen;
+using namespace testing;
+
+namespace {
+
+std::string toString(const std::shared_ptr<folly::IOBuf>& buf) {
+  std::string out;
+  for (const auto& range : *buf) {
+    out.append(reinterpret_cast<const char*>(range.data()), range.size());
+  }
+  return out;
+}
+
+} // namespace
+
+TEST(SSEStreamTest, CoalescesEventsWithinLoopTick) {
+  folly::EventBase evb;
+  MockRequestHandler requestHandler;
+  MockResponseHandler handler(&requestHandler);
+  SSEStream stream(&handler, &evb, std::chrono::milliseconds(0));
+
+  std::shared_ptr<folly::IOBuf> sent;
+  EXPECT_CALL(handler, sendBody(_)).WillOnce(SaveArg<0>(&sent));
+
+  stream.sendEvent("one", "tick", "1");
+  stream.sendEvent("line1\nline2");
+  stream.sendComment("note");
+  EXPECT_GT(stream.getBufferedBytes(), 0);
+
+  // nothing goes out until the loop tick, then everything in one body
+  ASSERT_FALSE(sent);
+  evb.loopOnce();
+  ASSERT_TRUE(sent);
+  EXPECT_EQ(toString(sent),
+            "event: tick\n"
+            "id: 1\n"
+            "data: one\n"
+            "\n"
+            "data: line1\n"
+            "data: line2\n"
+            "\n"
+            ": note\n"
+            "\n");
+  EXPECT_EQ(stream.getBufferedBytes(), 0);
+}
+
+TEST(SSEStreamTest, PausedEventsFlushOnResume) {
+  folly::EventBase evb;
+  MockRequestHandler requestHandler;
+  MockResponseHandler handler(&requestHandler);
+  SSEStream stream(&handler, &evb, std::chrono::milliseconds(0));
+
+  std::shared_ptr<folly::IOBuf> sent;
+  EXPECT_CALL(handler, sendBody(_)).WillOnce(SaveArg<0>(&sent));
+
+  stream.onEgressPaused();
+  stream.sendEvent("while paused");
+  evb.loopOnce();
+  EXPECT_FALSE(sent);
+  EXPECT_GT(stream.getBufferedBytes(), 0);
+
+  stream.onEgressResumed();
+  evb.loopOnce();
+  ASSERT_TRUE(sent);
+  EXPECT_EQ(toString(sent), "data: while paused\n\n");
+}
+
+TEST(SSEStreamTest, KeepaliveCommentOnIdle) {
+  folly::EventBase evb;
+  MockRequestHandler requestHandler;
+  MockResponseHandler handler(&requestHandler);
+  SSEStream stream(&handler, &evb, std::chrono::milliseconds(20));
+
+  std::vector<std::string> bodies;
+  EXPECT_CALL(handler, sendBody(_))
+      .WillRepeatedly(Invoke([&](std::shared_ptr<folly::IOBuf> buf) {
+        bodies.push_back(toString(buf));
+      }));
+
+  evb.runAfterDelay([&] { evb.terminateLoopSoon(); }, 70);
+  evb.loopForever();
+
+  ASSERT_GE(bodies.size(), 1);
+  EXPECT_EQ(bodies[0], ": keepalive\n\n");
+}
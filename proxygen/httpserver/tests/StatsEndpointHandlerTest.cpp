@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/httpserver/StatsEndpointHandler.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+
+TEST(StatsEndpointHandlerTest, WriteStatsText) {
+  ResourceData data;
+  data.setCpuStats(0.25, 0.0625, {0.5, 0.125});
+  data.setMemStats(1024, 4096);
+  data.setTcpMemStats(10, 1, 50, 100);
+  data.setLastUpdateTime(std::chrono::milliseconds(1234));
+
+  char buf[4096];
+  auto len = StatsEndpointHandler::writeStatsText(data, buf, sizeof(buf));
+  std::string out(buf, len);
+
+  EXPECT_NE(out.find("cpu_util_ratio 0.2500\n"), std::string::npos);
+  EXPECT_NE(out.find("cpu_softirq_util_ratio 0.0625\n"), std::string::npos);
+  EXPECT_NE(out.find("cpu_core_softirq_util_ratio{core=\"0\"} 0.5000\n"),
+            std::string::npos);
+  EXPECT_NE(out.find("cpu_core_softirq_util_ratio{core=\"1\"} 0.1250\n"),
+            std::string::npos);
+  EXPECT_NE(out.find("mem_used_bytes 1024\n"), std::string::npos);
+  EXPECT_NE(out.find("mem_total_bytes 4096\n"), std::string::npos);
+  EXPECT_NE(out.find("tcp_mem_pages 10\n"), std::string::npos);
+  EXPECT_NE(out.find("tcp_mem_limit_pages 100\n"), std::string::npos);
+  // UDP stats were never collected, so their lines are omitted
+  EXPECT_EQ(out.find("udp_mem_pages"), std::string::npos);
+  EXPECT_NE(out.find("stats_last_update_ms 1234\n"), std::string::npos);
+}
+
+TEST(StatsEndpointHandlerTest, WriteStatsTextTruncatesAtCap) {
+  ResourceData data;
+  data.setCpuStats(0.5, 0.5, std::vector<double>(512, 0.5));
+  data.setMemStats(1, 2);
+
+  char buf[128];
+  auto len = StatsEndpointHandler::writeStatsText(data, buf, sizeof(buf));
+  EXPECT_LE(len, sizeof(buf));
+}
@@ -0,0 +1,412 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "proxygen/lib/healthcheck/MultiplexedHealthChecker.h"
+
+#include <algorithm>
+
+#include <folly/Random.h>
+
+#include "proxygen/lib/http/HTTPConnector.h"
+#include "proxygen/lib/http/HTTPMessage.h"
+#include "proxygen/lib/http/connpool/SessionPool.h"
+#include "proxygen/lib/http/session/HTTPTransaction.h"
+#include "proxygen/lib/http/session/HTTPUpstreamSession.h"
+
+namespace proxygen {
+
+/*
+ * One registered server: owns its SessionPool, schedules its own probes
+ * off the checker's event base, and reports each result back through
+ * the checker.
+ *
+ * Lifetime: owned by the checker's probes_ map while registered.  On
+ * removal shutdown() is called after releasing ownership; if a probe
+ * transaction is in flight the Probe aborts it and deletes itself from
+ * detachTransaction(), so the transaction never outlives its handler.
+ */
+class MultiplexedHealthChecker::Probe
+    : public HTTPConnector::Callback
+    , public HTTPTransactionHandler
+    , public folly::AsyncTimeout {
+ public:
+  Probe(MultiplexedHealthChecker* checker,
+        std::string name,
+        const folly::SocketAddress& address,
+        bool isSecure,
+        std::shared_ptr<ServerHealthCheckerCallback> callback,
+        folly::Optional<folly::SocketAddress> bindAddress,
+        folly::Optional<folly::SocketOptionMap> extraSockOpts,
+        folly::Optional<folly::SocketAddress> overrideAddress)
+      : folly::AsyncTimeout(checker->evb_),
+        checker_(checker),
+        name_(std::move(name)),
+        connectAddress_(overrideAddress ? *overrideAddress : address),
+        isSecure_(isSecure),
+        callback_(std::move(callback)),
+        bindAddress_(std::move(bindAddress)),
+        extraSockOpts_(std::move(extraSockOpts)),
+        interval_(checker->params_.minInterval),
+        pool_(nullptr /* stats */,
+              1 /* maxPooledSessions */,
+              checker->params_.maxInterval * 2 /* timeout */) {
+  }
+
+  ~Probe() override {
+    CHECK(!txn_) << "Probe destroyed with a transaction in flight";
+  }
+
+  // Schedule the first probe with jitter so a large pool doesn't probe
+  // every server in the same tick
+  void kickoff() {
+    scheduleTimeout(std::chrono::milliseconds(
+        1 + folly::Random::rand32(static_cast<uint32_t>(interval_.count()))));
+  }
+
+  // Detach from the checker; deletes this, possibly deferred until the
+  // in-flight transaction detaches.  Caller must have released ownership.
+  void shutdown() {
+    dying_ = true;
+    cancelTimeout();
+    connector_.reset();
+    if (txn_) {
+      txn_->sendAbort();
+    } else {
+      delete this;
+    }
+  }
+
+  HealthStatus status() const {
+    return HealthStatus{healthy_, consecutiveFailures_, lastProbe_};
+  }
+
+  void timeoutExpired() noexcept override {
+    runProbe();
+  }
+
+  // HTTPConnector::Callback
+  void connectSuccess(HTTPUpstreamSession* session) override {
+    if (dying_) {
+      session->drain();
+      return;
+    }
+    pool_.putSession(session);
+    auto* txn = pool_.getTransaction(this);
+    if (!txn) {
+      recordFailure(ServerDownInfo::HEALTHCHECK_CONNECT_ERROR,
+                    "no transaction on fresh session");
+      return;
+    }
+    sendRequest(txn);
+  }
+
+  void connectError(const folly::AsyncSocketException& ex) override {
+    if (dying_) {
+      return;
+    }
+    recordFailure(ServerDownInfo::HEALTHCHECK_CONNECT_ERROR, ex.what());
+  }
+
+  // HTTPTransactionHandler
+  void setTransaction(HTTPTransaction* txn) noexcept override {
+    txn_ = txn;
+  }
+
+  void detachTransaction() noexcept override {
+    txn_ = nullptr;
+    if (dying_) {
+      delete this;
+      return;
+    }
+    if (inFlight_) {
+      // detached without EOM or error, count it as a failed probe
+      recordFailure(ServerDownInfo::HEALTHCHECK_EOF, "transaction detached");
+    }
+  }
+
+  void onHeadersComplete(std::unique_ptr<HTTPMessage> msg) noexcept override {
+    if (!dying_) {
+      statusCode_ = msg->getStatusCode();
+    }
+  }
+
+  void onBody(std::unique_ptr<folly::IOBuf>) noexcept override {
+  }
+
+  void onTrailers(std::unique_ptr<HTTPHeaders>) noexcept override {
+  }
+
+  void onEOM() noexcept override {
+    if (dying_ || !inFlight_) {
+      return;
+    }
+    if (statusCode_ == 200) {
+      recordSuccess();
+    } else {
+      recordFailure(ServerDownInfo::HEALTHCHECK_NON200_STATUS,
+                    folly::to<std::string>(statusCode_));
+    }
+  }
+
+  void onUpgrade(UpgradeProtocol) noexcept override {
+    if (!dying_ && inFlight_) {
+      recordFailure(ServerDownInfo::HEALTHCHECK_UPGRADE_ERROR, "");
+    }
+  }
+
+  void onError(const HTTPException& error) noexcept override {
+    if (dying_ || !inFlight_) {
+      return;
+    }
+    auto reason = ServerDownInfo::HEALTHCHECK_MESSAGE_ERROR;
+    if (error.getProxygenError() == kErrorTimeout) {
+      reason = ServerDownInfo::HEALTHCHECK_TIMEOUT;
+    } else if (error.getProxygenError() == kErrorEOF) {
+      reason = ServerDownInfo::HEALTHCHECK_EOF;
+    }
+    recordFailure(reason, error.what());
+  }
+
+  void onEgressPaused() noexcept override {
+  }
+
+  void onEgressResumed() noexcept override {
+  }
+
+ private:
+  void runProbe() {
+    if (inFlight_) {
+      // previous probe still outstanding; its own timeout will fail it
+      scheduleNext();
+      return;
+    }
+    inFlight_ = true;
+    statusCode_ = 0;
+    startTime_ = getCurrentTime();
+    if (auto* txn = pool_.getTransaction(this)) {
+      sendRequest(txn);
+      return;
+    }
+    // no usable pooled session, reconnect
+    if (!connector_) {
+      connector_ =
+          std::make_unique<HTTPConnector>(this, checker_->wheelTimer_.get());
+    }
+    connector_->reset();
+    const auto& opts =
+        extraSockOpts_ ? *extraSockOpts_ : folly::emptySocketOptionMap;
+    const auto& bindAddr =
+        bindAddress_ ? *bindAddress_ : folly::AsyncSocket::anyAddress();
+    if (isSecure_) {
+      connector_->connectSSL(checker_->evb_,
+                             connectAddress_,
+                             checker_->getSSLContext(),
+                             nullptr,
+                             checker_->params_.probeTimeout,
+                             opts,
+                             bindAddr,
+                             name_);
+    } else {
+      connector_->connect(checker_->evb_,
+                          connectAddress_,
+                          checker_->params_.probeTimeout,
+                          opts,
+                          bindAddr);
+    }
+  }
+
+  void sendRequest(HTTPTransaction* txn) {
+    HTTPMessage req;
+    req.setMethod(HTTPMethod::GET);
+    req.setURL(checker_->params_.path);
+    req.setHTTPVersion(1, 1);
+    req.getHeaders().set(HTTP_HEADER_HOST, name_);
+    txn->sendHeaders(req);
+    txn->sendEOM();
+  }
+
+  void recordSuccess() {
+    inFlight_ = false;
+    healthy_ = true;
+    consecutiveFailures_ = 0;
+    lastProbe_ = getCurrentTime();
+    if (++stableStreak_ >= checker_->params_.stableStreak) {
+      interval_ = std::min(interval_ * 2, checker_->params_.maxInterval);
+      stableStreak_ = 0; // another full streak before the next back-off
+    }
+    if (callback_) {
+      callback_->processHealthCheckSuccess(startTime_, 0 /* load */);
+    }
+    checker_->publish();
+    scheduleNext();
+  }
+
+  void recordFailure(ServerDownInfo reason, const std::string& extra) {
+    inFlight_ = false;
+    healthy_ = false;
+    consecutiveFailures_++;
+    stableStreak_ = 0;
+    interval_ = checker_->params_.minInterval;
+    lastProbe_ = getCurrentTime();
+    if (callback_) {
+      callback_->processHealthCheckFailure(startTime_, reason, extra);
+    }
+    checker_->publish();
+    scheduleNext();
+  }
+
+  void scheduleNext() {
+    if (!dying_ && checker_->started_) {
+      scheduleTimeout(interval_);
+    }
+  }
+
+  MultiplexedHealthChecker* checker_;
+  std::string name_;
+  folly::SocketAddress connectAddress_;
+  bool isSecure_;
+  std::shared_ptr<ServerHealthCheckerCallback> callback_;
+  folly::Optional<folly::SocketAddress> bindAddress_;
+  folly::Optional<folly::SocketOptionMap> extraSockOpts_;
+  std::chrono::milliseconds interval_;
+  SessionPool pool_;
+  std::unique_ptr<HTTPConnector> connector_;
+  HTTPTransaction* txn_{nullptr};
+  TimePoint startTime_;
+  TimePoint lastProbe_;
+  uint16_t statusCode_{0};
+  uint32_t stableStreak_{0};
+  uint32_t consecutiveFailures_{0};
+  bool healthy_{false};
+  bool inFlight_{false};
+  bool dying_{false};
+};
+
+MultiplexedHealthChecker::MultiplexedHealthChecker(folly::EventBase* evb,
+                                                   Params params)
+    : evb_(CHECK_NOTNULL(evb)),
+      params_(std::move(params)),
+      wheelTimer_(folly::HHWheelTimer::newTimer(
+          evb_,
+          std::chrono::milliseconds(folly::HHWheelTimer::DEFAULT_TICK_INTERVAL),
+          folly::AsyncTimeout::InternalEnum::NORMAL,
+          params_.probeTimeout)) {
+  snapshot_ = std::make_shared<const HealthSnapshot>();
+}
+
+MultiplexedHealthChecker::~MultiplexedHealthChecker() {
+  deleteAllCheckers();
+}
+
+void MultiplexedHealthChecker::start() {
+  evb_->runInEventBaseThread([this] {
+    if (started_) {
+      return;
+    }
+    started_ = true;
+    for (auto& kv : probes_) {
+      kv.second->kickoff();
+    }
+  });
+}
+
+void MultiplexedHealthChecker::stop() {
+  evb_->runInEventBaseThread([this] {
+    started_ = false;
+    for (auto& kv : probes_) {
+      kv.second->cancelTimeout();
+    }
+  });
+}
+
+void MultiplexedHealthChecker::deleteAllCheckers() {
+  evb_->runInEventBaseThreadAndWait([this] {
+    for (auto& kv : probes_) {
+      kv.second.release()->shutdown();
+    }
+    probes_.clear();
+    publish();
+  });
+}
+
+void MultiplexedHealthChecker::addServer(
+    const std::string& name,
+    const folly::SocketAddress& address,
+    bool isSecure,
+    std::shared_ptr<ServerHealthCheckerCallback> callback,
+    folly::Optional<folly::SocketAddress> bindAddress,
+    folly::Optional<folly::SocketOptionMap> extraSockOpts,
+    folly::Optional<folly::SocketAddress> overrideAddress) {
+  evb_->runInEventBaseThread([this,
+                              name,
+                              address,
+                              isSecure,
+                              callback = std::move(callback),
+                              bindAddress = std::move(bindAddress),
+                              extraSockOpts = std::move(extraSockOpts),
+                              overrideAddress =
+                                  std::move(overrideAddress)]() mutable {
+    auto probe = std::make_unique<Probe>(this,
+                                         name,
+                                         address,
+                                         isSecure,
+                                         std::move(callback),
+                                         std::move(bindAddress),
+                                         std::move(extraSockOpts),
+                                         std::move(overrideAddress));
+    auto result = probes_.emplace(address, std::move(probe));
+    if (!result.second) {
+      LOG(WARNING) << "Health checker already registered for " << address
+                   << ", keeping existing probe";
+      return;
+    }
+    if (started_) {
+      result.first->second->kickoff();
+    }
+    publish();
+  });
+}
+
+void MultiplexedHealthChecker::removeServer(
+    const folly::SocketAddress& address) {
+  evb_->runInEventBaseThread([this, address] {
+    auto it = probes_.find(address);
+    if (it == probes_.end()) {
+      return;
+    }
+    it->second.release()->shutdown();
+    probes_.erase(it);
+    publish();
+  });
+}
+
+std::shared_ptr<const MultiplexedHealthChecker::HealthSnapshot>
+MultiplexedHealthChecker::getSnapshot() const {
+  return snapshot_.copy();
+}
+
+std::shared_ptr<folly::SSLContext> MultiplexedHealthChecker::getSSLContext() {
+  if (params_.sslContext) {
+    return params_.sslContext;
+  }
+  if (!sslContext_) {
+    sslContext_ = std::make_shared<folly::SSLContext>();
+  }
+  return sslContext_;
+}
+
+void MultiplexedHealthChecker::publish() {
+  auto snapshot = std::make_shared<HealthSnapshot>();
+  snapshot->reserve(probes_.size());
+  for (const auto& kv : probes_) {
+    snapshot->emplace(kv.first, kv.second->status());
+  }
+  snapshot_ = std::shared_ptr<const HealthSnapshot>(std::move(snapshot));
+}
+
+} // namespace proxygen
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <folly/SocketAddress.h>
+#include <folly/Synchronized.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/HHWheelTimer.h>
+#include <folly/io/async/SSLContext.h>
+
+#include "proxygen/lib/healthcheck/PoolHealthChecker.h"
+
+namespace proxygen {
+
+/*
+ * PoolHealthChecker that multiplexes every probe for a pool onto one
+ * designated worker event base, instead of each worker opening a
+ * dedicated probe connection per server.  Probes run over a per-server
+ * SessionPool, so servers that negotiate a multiplexed protocol are
+ * checked over one long-lived connection; the pool reconnects lazily
+ * when a probe finds no usable session.
+ *
+ * Results fan out two ways: the per-server ServerHealthCheckerCallback
+ * fires from the checker thread as before, and an immutable snapshot of
+ * every server's status is republished after each probe.  Workers read
+ * the snapshot via getSnapshot() without blocking the prober - RCU
+ * style, the old map stays valid for readers that still hold it.
+ *
+ * Probe frequency adapts per server: after stableStreak consecutive
+ * successes the interval doubles (up to maxInterval); any failure drops
+ * it back to minInterval, so flappers are watched closely and stable
+ * servers cost little.
+ *
+ * Public methods may be called from any thread.  As with other
+ * PoolHealthChecker implementations, call deleteAllCheckers() (or let
+ * the destructor do it) before destroying the checker.
+ */
+class MultiplexedHealthChecker : public PoolHealthChecker {
+ public:
+  struct Params {
+    // Request path probed with GET; 200 counts as healthy
+    std::string path{"/status"};
+    std::chrono::milliseconds minInterval{std::chrono::seconds(1)};
+    std::chrono::milliseconds maxInterval{std::chrono::seconds(30)};
+    std::chrono::milliseconds probeTimeout{std::chrono::seconds(2)};
+    // Consecutive successes before the probe interval doubles
+    uint32_t stableStreak{3};
+    // Context for servers registered with isSecure; a default context
+    // is created on first use if unset
+    std::shared_ptr<folly::SSLContext> sslContext;
+  };
+
+  struct HealthStatus {
+    bool healthy{false};
+    uint32_t consecutiveFailures{0};
+    TimePoint lastProbe;
+  };
+  using HealthSnapshot = std::unordered_map<folly::SocketAddress, HealthStatus>;
+
+  MultiplexedHealthChecker(folly::EventBase* evb, Params params);
+  ~MultiplexedHealthChecker() override;
+
+  void start() override;
+  void stop() override;
+  void deleteAllCheckers() override;
+
+  void addServer(const std::string& name,
+                 const folly::SocketAddress& address,
+                 bool isSecure,
+                 std::shared_ptr<ServerHealthCheckerCallback> callback,
+                 folly::Optional<folly::SocketAddress> bindAddress =
+                     folly::none,
+                 folly::Optional<folly::SocketOptionMap> extraSockOpts =
+                     folly::none,
+                 folly::Optional<folly::SocketAddress> overrideAddress =
+                     folly::none) override;
+
+  void removeServer(const folly::SocketAddress& address) override;
+
+  std::chrono::milliseconds getCheckInterval() const override {
+    return params_.minInterval;
+  }
+
+  /**
+   * Latest published status of every registered server.  Safe from any
+   * thread; the returned map is immutable and stays valid however long
+   * the caller holds it.
+   */
+  std::shared_ptr<const HealthSnapshot> getSnapshot() const;
+
+ private:
+  class Probe;
+  friend class Probe;
+
+  // Rebuild and publish the snapshot; evb thread only
+  void publish();
+
+  // Context for secure probes; evb thread only
+  std::shared_ptr<folly::SSLContext> getSSLContext();
+
+  folly::EventBase* evb_;
+  const Params params_;
+  folly::HHWheelTimer::UniquePtr wheelTimer_;
+  // Lazily created for secure servers when Params::sslContext is unset;
+  // evb thread only
+  std::shared_ptr<folly::SSLContext> sslContext_;
+  bool started_{false};
+  // evb thread only, keyed by the identifying (not override) address
+  std::unordered_map<folly::SocketAddress, std::unique_ptr<Probe>> probes_;
+  folly::Synchronized<std::shared_ptr<const HealthSnapshot>> snapshot_;
+};
+
+} // namespace proxygen
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/http/DnsResolutionCache.h>
+
+#include <folly/Conv.h>
+#include <folly/ScopeGuard.h>
+#include <folly/executors/GlobalExecutor.h>
+#include <folly/portability/Sockets.h>
+
+namespace {
+
+// Blocking getaddrinfo(); the cache runs it on the CPU executor
+std::vector<folly::SocketAddress> resolveWithGetaddrinfo(
+    const std::string& hostname, uint16_t port, std::string& errorMsg) {
+  std::vector<folly::SocketAddress> addresses;
+  struct addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo* results = nullptr;
+  auto portStr = folly::to<std::string>(port);
+  auto rc = getaddrinfo(hostname.c_str(), portStr.c_str(), &hints, &results);
+  if (rc != 0) {
+    errorMsg = folly::to<std::string>(
+        "Failed to resolve ", hostname, ": ", gai_strerror(rc));
+    return addresses;
+  }
+  SCOPE_EXIT {
+    freeaddrinfo(results);
+  };
+  for (auto* ai = results; ai != nullptr; ai = ai->ai_next) {
+    folly::SocketAddress address;
+    try {
+      address.setFromSockaddr(ai->ai_addr, ai->ai_addrlen);
+    } catch (const std::exception&) {
+      continue;
+    }
+    addresses.push_back(std::move(address));
+  }
+  if (addresses.empty()) {
+    errorMsg = folly::to<std::string>("No usable addresses for ", hostname);
+  }
+  return addresses;
+}
+
+} // namespace
+
+namespace proxygen {
+
+DnsResolutionCache& DnsResolutionCache::getInstance() {
+  static DnsResolutionCache instance;
+  return instance;
+}
+
+DnsResolutionCache::DnsResolutionCache(Params params)
+    : params_(params), resolver_(resolveWithGetaddrinfo) {
+}
+
+DnsResolutionCache::Shard& DnsResolutionCache::shardFor(
+    const std::string& key) {
+  return shards_[std::hash<std::string>()(key) % kNumShards];
+}
+
+void DnsResolutionCache::resolve(folly::EventBase* eventBase,
+                                 const std::string& hostname,
+                                 uint16_t port,
+                                 LookupCallback callback) {
+  auto key = folly::to<std::string>(hostname, ':', port);
+  auto now = getCurrentTime();
+
+  std::vector<folly::SocketAddress> servable;
+  std::string servableError;
+  bool serveNow = false;
+  bool refresh = false;
+  {
+    auto map = shardFor(key).wlock();
+    auto& entry = (*map)[key];
+    if (!entry) {
+      entry = std::make_shared<Entry>();
+    }
+    if (entry->valid && now < entry->freshUntil) {
+      // fresh hit (positive or negative-cached): serve synchronously
+      servable = entry->addresses;
+      servableError = entry->errorMsg;
+      serveNow = true;
+    } else if (entry->valid && !entry->addresses.empty() &&
+               now < entry->staleUntil) {
+      // expired but servable: hand out the stale answer and refresh
+      // behind it, at most once
+      servable = entry->addresses;
+      serveNow = true;
+      if (!entry->refreshing) {
+        entry->refreshing = true;
+        refresh = true;
+      }
+    } else {
+      // cold miss or aged-out entry: park the caller; the first one in
+      // starts the resolution that feeds every waiter
+      entry->waiters.push_back(Waiter{eventBase, std::move(callback)});
+      if (!entry->refreshing) {
+        entry->refreshing = true;
+        refresh = true;
+      }
+    }
+  }
+
+  if (serveNow) {
+    callback(std::move(servable), servableError);
+  }
+  if (refresh) {
+    startRefresh(std::move(key), hostname, port);
+  }
+}
+
+void DnsResolutionCache::startRefresh(std::string key,
+                                      std::string hostname,
+                                      uint16_t port) {
+  folly::getCPUExecutor()->add([this,
+                               key = std::move(key),
+                               hostname = std::move(hostname),
+                               port]() {
+    std::string errorMsg;
+    auto addresses = resolver_(hostname, port, errorMsg);
+    auto now = getCurrentTime();
+
+    std::vector<Waiter> waiters;
+    std::vector<folly::SocketAddress> result;
+    std::string resultError;
+    {
+      auto map = shardFor(key).wlock();
+      auto& entry = (*map)[key];
+      if (!entry) {
+        entry = std::make_shared<Entry>();
+      }
+      entry->refreshing = false;
+      if (!addresses.empty()) {
+        entry->valid = true;
+        entry->addresses = addresses;
+        entry->errorMsg.clear();
+        entry->freshUntil = now + params_.ttl;
+        entry->staleUntil = now + params_.ttl + params_.staleTtl;
+      } else if (entry->valid && !entry->addresses.empty() &&
+                 now < entry->staleUntil) {
+        // refresh behind a servable entry failed: keep serving stale
+        // and back off before the next refresh attempt
+        addresses = entry->addresses;
+        errorMsg.clear();
+        entry->freshUntil = now + params_.negativeTtl;
+      } else {
+        // negative cache: a dead name answers from memory for a while
+        entry->valid = true;
+        entry->addresses.clear();
+        entry->errorMsg = errorMsg;
+        entry->freshUntil = now + params_.negativeTtl;
+        entry->staleUntil = entry->freshUntil;
+      }
+      waiters = std::move(entry->waiters);
+      entry->waiters.clear();
+      result = addresses;
+      resultError = errorMsg;
+    }
+
+    for (auto& waiter : waiters) {
+      waiter.eventBase->runInEventBaseThread(
+          [callback = std::move(waiter.callback),
+           result,
+           resultError]() mutable { callback(result, resultError); });
+    }
+  });
+}
+
+} // namespace proxygen
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <folly/Function.h>
+#include <folly/SocketAddress.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <folly/io/async/EventBase.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <proxygen/lib/utils/Time.h>
+
+namespace proxygen {
+
+/**
+ * Read-through DNS cache shared by every upstream connector in the
+ * process, with stale-while-revalidate semantics.
+ *
+ * Entries are sharded by key hash so workers contend on a sliver of the
+ * table, never the whole cache.  A fresh hit invokes the callback
+ * synchronously on the calling (IO) thread, so a racing connect starts
+ * its first attempt with zero added latency.  An entry past its TTL but
+ * inside the serve-stale window is handed out the same way while one
+ * background refresh is kicked off; callers never stall on an expired
+ * entry that is still plausibly correct.  A cold miss parks the caller
+ * on the entry and starts one resolution no matter how many workers ask
+ * concurrently -- the answer feeds every waiter.  Failures are
+ * negative-cached briefly so a dead name cannot induce a resolution
+ * storm; a refresh failure behind a servable stale entry backs off and
+ * keeps serving stale.
+ */
+class DnsResolutionCache {
+ public:
+  struct Params {
+    std::chrono::milliseconds ttl{30000};
+    // how long past the TTL a positive entry may still be served
+    std::chrono::milliseconds staleTtl{300000};
+    std::chrono::milliseconds negativeTtl{5000};
+  };
+
+  /**
+   * Resolution outcome: addresses is empty on failure, with errorMsg
+   * explaining why.
+   */
+  using LookupCallback = folly::Function<void(
+      std::vector<folly::SocketAddress>, const std::string& errorMsg)>;
+
+  /**
+   * Blocking resolver, run off the IO thread on the CPU executor.
+   */
+  using Resolver = folly::Function<std::vector<folly::SocketAddress>(
+      const std::string& hostname, uint16_t port, std::string& errorMsg)>;
+
+  static DnsResolutionCache& getInstance();
+
+  explicit DnsResolutionCache(Params params = Params());
+
+  /**
+   * Resolve hostname:port through the cache.  Must be called from the
+   * eventBase thread; the callback runs synchronously on a servable hit
+   * or on eventBase otherwise.
+   */
+  void resolve(folly::EventBase* eventBase,
+               const std::string& hostname,
+               uint16_t port,
+               LookupCallback callback);
+
+  /**
+   * Replace the blocking resolver; for tests.  Call before any
+   * lookups are in flight.
+   */
+  void setResolverForTesting(Resolver resolver) {
+    resolver_ = std::move(resolver);
+  }
+
+  void setParams(Params params) {
+    params_ = params;
+  }
+
+ private:
+  struct Waiter {
+    folly::EventBase* eventBase;
+    LookupCallback callback;
+  };
+
+  struct Entry {
+    std::vector<folly::SocketAddress> addresses;
+    std::string errorMsg;
+    bool valid{false};
+    bool refreshing{false};
+    TimePoint freshUntil;
+    TimePoint staleUntil;
+    std::vector<Waiter> waiters;
+  };
+
+  using Shard =
+      folly::Synchronized<folly::F14FastMap<std::string, std::shared_ptr<Entry>>>;
+
+  static constexpr size_t kNumShards = 16;
+
+  Shard& shardFor(const std::string& key);
+  void startRefresh(std::string key, std::string hostname, uint16_t port);
+
+  Params params_;
+  Resolver resolver_;
+  std::array<Shard, kNumShards> shards_;
+};
+
+} // namespace proxygen
@@ -34,6 +34,12 @@ void HQConnector::reset() {
     session_->dropConnection();
     session_ = nullptr;
   }
+  if (connectPromise_ && !connectPromise_->isFulfilled()) {
+    // A pending connectWithFuture() that was abandoned; breaking the
+    // promise here, rather than at destruction, keeps the error tied to
+    // the reset.
+    connectPromise_.reset();
+  }
 }
 
 void HQConnector::setTransportSettings(
@@ -46,6 +52,17 @@ void HQConnector::setQuicPskCache(
   quicPskCache_ = std::move(quicPskCache);
 }
 
+void HQConnector::setQuicTokenCache(
+    std::shared_ptr<QuicTokenCache> quicTokenCache) {
+  quicTokenCache_ = std::move(quicTokenCache);
+}
+
+std::shared_ptr<const FizzClientContext> HQConnector::getSharedFizzContext() {
+  static const std::shared_ptr<const FizzClientContext> sharedContext =
+      std::make_shared<const FizzClientContext>();
+  return sharedContext;
+}
+
 void HQConnector::connect(
     EventBase* eventBase,
     folly::Optional<folly::SocketAddress> localAddr,
@@ -61,16 +78,29 @@ void HQConnector::connect(
         quicTransportStatsCallback) {
 
   DCHECK(!isBusy());
+  if (!fizzContext) {
+    fizzContext = getSharedFizzContext();
+  }
   auto sock = std::make_unique<folly::AsyncUDPSocket>(eventBase);
   auto quicClient = quic::QuicClientTransport::newClient(
       eventBase,
       std::move(sock),
       quic::FizzClientQuicHandshakeContext::Builder()
-          .setFizzClientContext(fizzContext)
+          .setFizzClientContext(std::move(fizzContext))
           .setCertificateVerifier(std::move(verifier))
           .setPskCache(quicPskCache_)
           .build());
-  quicClient->setHostname(sni.value_or(connectAddr.getAddressStr()));
+  auto identity = sni.value_or(connectAddr.getAddressStr());
+  quicClient->setHostname(identity);
+  if (quicTokenCache_) {
+    if (auto token = quicTokenCache_->getToken(identity)) {
+      quicClient->setNewToken(std::move(*token));
+    }
+    quicClient->setNewTokenCallback(
+        [cache = quicTokenCache_, identity](std::string token) {
+          cache->putToken(identity, std::move(token));
+        });
+  }
   quicClient->addNewPeerAddress(connectAddr);
   if (localAddr.hasValue()) {
     quicClient->setLocalAddress(*localAddr);
@@ -98,11 +128,47 @@ void HQConnector::connect(
   quicClient->start(session_);
 }
 
+folly::SemiFuture<HQUpstreamSession*> HQConnector::connectWithFuture(
+    EventBase* eventBase,
+    folly::Optional<folly::SocketAddress> localAddr,
+    const folly::SocketAddress& connectAddr,
+    std::shared_ptr<const FizzClientContext> fizzContext,
+    std::shared_ptr<const fizz::CertificateVerifier> verifier,
+    std::chrono::milliseconds connectTimeout,
+    const SocketOptionMap& socketOptions,
+    folly::Optional<std::string> sni,
+    std::shared_ptr<quic::QLogger> qLogger,
+    std::shared_ptr<quic::LoopDetectorCallback> quicLoopDetectorCallback,
+    std::shared_ptr<quic::QuicTransportStatsCallback>
+        quicTransportStatsCallback) {
+  DCHECK(!connectPromise_);
+  connectPromise_.emplace();
+  auto future = connectPromise_->getSemiFuture();
+  connect(eventBase,
+          std::move(localAddr),
+          connectAddr,
+          std::move(fizzContext),
+          std::move(verifier),
+          connectTimeout,
+          socketOptions,
+          std::move(sni),
+          std::move(qLogger),
+          std::move(quicLoopDetectorCallback),
+          std::move(quicTransportStatsCallback));
+  return future;
+}
+
 void HQConnector::onReplaySafe() noexcept {
   CHECK(session_);
+  auto session = session_;
+  session_ = nullptr;
+  if (connectPromise_) {
+    auto promise = std::move(*connectPromise_);
+    connectPromise_.reset();
+    promise.setValue(session);
+    return;
+  }
   if (cb_) {
-    auto session = session_;
-    session_ = nullptr;
     cb_->connectSuccess(session);
   }
 }
@@ -110,7 +176,13 @@ void HQConnector::onReplaySafe() noexcept {
 void HQConnector::connectError(
     std::pair<quic::QuicErrorCode, std::string> error) noexcept {
   CHECK(session_);
+  auto promise = std::move(connectPromise_);
+  connectPromise_.reset();
   reset();
+  if (promise) {
+    promise->setException(std::runtime_error(error.second));
+    return;
+  }
   if (cb_) {
     cb_->connectError(error.first);
   }
@@ -9,8 +9,10 @@
 #pragma once
 
 #include <fizz/client/AsyncFizzClient.h>
+#include <folly/futures/Future.h>
 #include <folly/io/SocketOptionMap.h>
 #include <proxygen/lib/http/session/HQUpstreamSession.h>
+#include <proxygen/lib/transport/QuicTokenCache.h>
 #include <quic/api/LoopDetectorCallback.h>
 #include <quic/api/QuicSocket.h>
 #include <quic/client/QuicClientTransport.h>
@@ -41,6 +43,15 @@ class HQConnector : public HQSession::ConnectCallback {
       : cb_(CHECK_NOTNULL(callback)), transactionTimeout_(transactionTimeout) {
   }
 
+  /**
+   * Constructor for the future-based API (connectWithFuture).  No
+   * callback is installed; each connect attempt reports through the
+   * future it returned.
+   */
+  explicit HQConnector(std::chrono::milliseconds transactionTimeout)
+      : cb_(nullptr), transactionTimeout_(transactionTimeout) {
+  }
+
   ~HQConnector() override {
     reset();
   }
@@ -49,6 +60,25 @@ class HQConnector : public HQSession::ConnectCallback {
 
   void setQuicPskCache(std::shared_ptr<quic::QuicPskCache> quicPskCache);
 
+  /**
+   * Installs a cache of NEW_TOKEN address-validation tokens keyed by
+   * server identity.  Cached tokens are presented on connect and tokens
+   * issued by the server are stored back, so a warm reconnect skips the
+   * server's address-validation round trip.  Transport parameters
+   * already travel with the cached PSK (see PersistentQuicPskCache), so
+   * the two caches together cover everything needed for 0-RTT resumption.
+   */
+  void setQuicTokenCache(std::shared_ptr<QuicTokenCache> quicTokenCache);
+
+  /**
+   * Returns a lazily-created, process-wide FizzClientContext.  Building
+   * a context is comparatively expensive; connectors that do not need
+   * custom crypto settings can pass nullptr for fizzContext to
+   * connect() and share this one.
+   */
+  static std::shared_ptr<const fizz::client::FizzClientContext>
+  getSharedFizzContext();
+
   void reset();
 
   void connect(
@@ -66,6 +96,29 @@ class HQConnector : public HQSession::ConnectCallback {
       std::shared_ptr<quic::QuicTransportStatsCallback>
           quicTransportStatsCallback = nullptr);
 
+  /**
+   * Same as connect(), but completion is delivered through the returned
+   * future instead of the constructor callback.  This allows a caller to
+   * start the handshake speculatively, ahead of the first request, and
+   * collect the ready session (or the error, as an exception carrying the
+   * error string) when it is actually needed.  The future completes on the
+   * connecting event base; the connector must stay alive until then.
+   */
+  folly::SemiFuture<HQUpstreamSession*> connectWithFuture(
+      folly::EventBase* eventBase,
+      folly::Optional<folly::SocketAddress> localAddr,
+      const folly::SocketAddress& connectAddr,
+      std::shared_ptr<const fizz::client::FizzClientContext> fizzContext,
+      std::shared_ptr<const fizz::CertificateVerifier> verifier,
+      std::chrono::milliseconds connectTimeout = std::chrono::milliseconds(0),
+      const folly::SocketOptionMap& socketOptions = folly::emptySocketOptionMap,
+      folly::Optional<std::string> sni = folly::none,
+      std::shared_ptr<quic::QLogger> qLogger = nullptr,
+      std::shared_ptr<quic::LoopDetectorCallback> quicLoopDetectorCallback =
+          nullptr,
+      std::shared_ptr<quic::QuicTransportStatsCallback>
+          quicTransportStatsCallback = nullptr);
+
   std::chrono::milliseconds timeElapsed();
 
   bool isBusy() const {
@@ -84,6 +137,8 @@ class HQConnector : public HQSession::ConnectCallback {
   HQUpstreamSession* session_{nullptr};
   quic::TransportSettings transportSettings_;
   std::shared_ptr<quic::QuicPskCache> quicPskCache_;
+  std::shared_ptr<QuicTokenCache> quicTokenCache_;
+  folly::Optional<folly::Promise<HQUpstreamSession*>> connectPromise_;
 };
 
 } // namespace proxygen
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/http/HTTPBodyTransformPipeline.h>
+
+#include <folly/io/IOBufQueue.h>
+#include <folly/small_vector.h>
+
+namespace {
+const std::string kTransformStageDefaultName = "Unknown";
+} // namespace
+
+namespace proxygen {
+
+const std::string& HTTPBodyTransformPipeline::Stage::getStageName()
+    const noexcept {
+  return kTransformStageDefaultName;
+}
+
+std::unique_ptr<folly::IOBuf> HTTPBodyTransformPipeline::transform(
+    std::unique_ptr<folly::IOBuf> chain) {
+  return transformFrom(0, std::move(chain));
+}
+
+std::unique_ptr<folly::IOBuf> HTTPBodyTransformPipeline::transformFrom(
+    size_t first, std::unique_ptr<folly::IOBuf> chain) {
+  if (!chain || chain->computeChainDataLength() == 0) {
+    return chain;
+  }
+  // Split the active stages around the first expanding one: everything
+  // before it can run wherever the body already lives.
+  folly::small_vector<Stage*, 4> leading; // in-place, before any expansion
+  folly::small_vector<Stage*, 4> trailing; // after the first expanding stage
+  Stage* expanding = nullptr;
+  for (size_t i = first; i < stages_.size(); i++) {
+    auto* stage = stages_[i].get();
+    if (stage->isPassThrough()) {
+      continue;
+    }
+    if (expanding) {
+      trailing.push_back(stage);
+    } else if (stage->isInPlace()) {
+      leading.push_back(stage);
+    } else {
+      expanding = stage;
+    }
+  }
+  if (leading.empty() && !expanding) {
+    // every stage passed through: forward the chain untouched
+    return chain;
+  }
+
+  if (!leading.empty()) {
+    // uniquely owned buffers (the common case for handler-built bodies)
+    // are rewritten where they are; unshare() only copies shared ones
+    folly::IOBuf* buf = chain.get();
+    do {
+      buf->unshare();
+      for (auto* stage : leading) {
+        stage->transformInPlace(buf->writableData(), buf->length());
+      }
+      buf = buf->next();
+    } while (buf != chain.get());
+  }
+  if (!expanding) {
+    return chain;
+  }
+
+  // One slab sized for the composed worst case of every expanding stage
+  // still to run; the first expanding stage streams the chain into it
+  // and that write is the pipeline's single copy.
+  const size_t chainLen = chain->computeChainDataLength();
+  size_t capacity = expanding->maxTransformedSize(chainLen);
+  for (auto* stage : trailing) {
+    if (!stage->isInPlace()) {
+      capacity = stage->maxTransformedSize(capacity);
+    }
+  }
+  auto slab = folly::IOBuf::create(capacity);
+  size_t written = 0;
+  for (auto range : *chain) {
+    written += expanding->transform(range.data(),
+                                    range.size(),
+                                    slab->writableData() + written,
+                                    capacity - written);
+    CHECK_LE(written, capacity)
+        << expanding->getStageName() << " overran its declared size";
+  }
+  for (auto* stage : trailing) {
+    if (stage->isInPlace()) {
+      stage->transformInPlace(slab->writableData(), written);
+    } else {
+      written = stage->reshape(slab->writableData(), written, capacity);
+      CHECK_LE(written, capacity)
+          << stage->getStageName() << " overran its declared size";
+    }
+  }
+  slab->append(written);
+  return slab;
+}
+
+std::unique_ptr<folly::IOBuf> HTTPBodyTransformPipeline::finish() {
+  folly::IOBufQueue out{folly::IOBufQueue::cacheChainLength()};
+  for (size_t i = 0; i < stages_.size(); i++) {
+    if (stages_[i]->isPassThrough()) {
+      continue;
+    }
+    auto tail = stages_[i]->finish();
+    if (tail && tail->computeChainDataLength() > 0) {
+      // a stage's buffered bytes still pass through the stages after it
+      out.append(transformFrom(i + 1, std::move(tail)));
+    }
+  }
+  return out.move();
+}
+
+} // namespace proxygen
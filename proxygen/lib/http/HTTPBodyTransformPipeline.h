@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <folly/io/IOBuf.h>
+#include <glog/logging.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace proxygen {
+
+/**
+ * A chain of egress body transforms (compression, encryption framing,
+ * chunk signing, ...) applied inside HTTPTransaction::sendBody() instead
+ * of as a stack of filters that each copy the chain.
+ *
+ * Stages declare what they need so the pipeline only pays for what is
+ * actually used:
+ *
+ *  - A pass-through stage (isPassThrough()) is skipped entirely; if
+ *    every stage passes through, the handler's chain is forwarded
+ *    untouched.
+ *  - An in-place stage (isInPlace()) rewrites bytes one-for-one and
+ *    runs directly on whatever buffer currently holds the body, so a
+ *    pipeline of only in-place stages copies nothing.
+ *  - An expanding stage may change the byte count.  When a chunk hits
+ *    one, the pipeline allocates a single output slab pre-sized for the
+ *    composed worst-case expansion of every remaining expanding stage,
+ *    and the first expanding stage streams the chain into it -- that
+ *    write is the pipeline's one copy.  Later expanding stages reshape
+ *    the slab within its spare capacity (see reshape()).
+ *
+ * Stages are per-message and stateful: a chunk may be fed to transform()
+ * in several slices, and slice boundaries carry no meaning.  Bytes a
+ * stage buffers internally (e.g. an unfinished compression block) are
+ * flushed by finish() at EOM and cascade through the stages after it.
+ */
+class HTTPBodyTransformPipeline {
+ public:
+  class Stage {
+   public:
+    virtual ~Stage() {
+    }
+
+    /**
+     * Largest number of bytes the stage can emit for inputLen input
+     * bytes, used to pre-size the shared output slab.  Overestimating
+     * wastes memory; underestimating is a logic error (CHECKed).
+     * Identity for in-place and pass-through stages.
+     */
+    virtual size_t maxTransformedSize(size_t inputLen) const noexcept {
+      return inputLen;
+    }
+
+    /**
+     * True when the stage has nothing to do for this message (e.g. its
+     * encoding was not negotiated).  Queried once per chunk, so a stage
+     * may flip mid-message.
+     */
+    virtual bool isPassThrough() const noexcept {
+      return false;
+    }
+
+    /**
+     * True when the stage rewrites bytes without changing their count
+     * and can run on the body wherever it currently lives.
+     */
+    virtual bool isInPlace() const noexcept {
+      return false;
+    }
+
+    /**
+     * In-place transform; only called when isInPlace() is true.  May be
+     * invoked once per buffer of a chain.
+     */
+    virtual void transformInPlace(uint8_t* /*data*/, size_t /*len*/) {
+      CHECK(false) << getStageName() << " declared in-place but does not"
+                   << " implement transformInPlace()";
+    }
+
+    /**
+     * Expanding transform: consume one input slice and append the output
+     * at 'output', which has at least maxTransformedSize(inputLen) bytes
+     * of room.  Returns the number of bytes written.  Only called on the
+     * first expanding stage a chunk reaches.
+     */
+    virtual size_t transform(const uint8_t* /*input*/,
+                             size_t /*inputLen*/,
+                             uint8_t* /*output*/,
+                             size_t /*outputCapacity*/) {
+      CHECK(false) << getStageName() << " declared expanding but does not"
+                   << " implement transform()";
+      return 0;
+    }
+
+    /**
+     * Expanding transform over the shared slab, for stages stacked after
+     * another expanding stage: [data, data + len) holds the current
+     * bytes and the stage owns the slab out to 'capacity', so it may
+     * rewrite and memmove freely (e.g. to prepend framing).  Returns the
+     * new length.  Stages that only ever run first need not implement
+     * this.
+     */
+    virtual size_t reshape(uint8_t* /*data*/,
+                           size_t /*len*/,
+                           size_t /*capacity*/) {
+      CHECK(false) << getStageName() << " is stacked after another expanding"
+                   << " stage and must implement reshape()";
+      return 0;
+    }
+
+    /**
+     * Emit any bytes the stage is still holding at EOM (compression
+     * tail, final signature).  May return nullptr.
+     */
+    virtual std::unique_ptr<folly::IOBuf> finish() {
+      return nullptr;
+    }
+
+    virtual const std::string& getStageName() const noexcept;
+  };
+
+  /**
+   * Stages run in the order they were added.
+   */
+  void addStage(std::unique_ptr<Stage> stage) {
+    stages_.push_back(std::move(stage));
+  }
+
+  bool empty() const {
+    return stages_.empty();
+  }
+
+  /**
+   * Run one body chunk through the pipeline.  Returns the transformed
+   * chain, which is the input chain itself unless an expanding stage
+   * ran; may return an empty chain when every byte was buffered.
+   */
+  std::unique_ptr<folly::IOBuf> transform(std::unique_ptr<folly::IOBuf> chain);
+
+  /**
+   * Flush all stages at EOM.  Bytes flushed by a stage are run through
+   * the stages after it, exactly as a regular chunk would be.
+   */
+  std::unique_ptr<folly::IOBuf> finish();
+
+ private:
+  std::unique_ptr<folly::IOBuf> transformFrom(
+      size_t first, std::unique_ptr<folly::IOBuf> chain);
+
+  std::vector<std::unique_ptr<Stage>> stages_;
+};
+
+} // namespace proxygen
@@ -10,6 +10,9 @@
 
 #include <folly/io/SocketOptionMap.h>
 #include <folly/io/async/AsyncSSLSocket.h>
+#include <folly/io/async/AsyncTimeout.h>
+#include <folly/portability/Sockets.h>
+#include <proxygen/lib/http/DnsResolutionCache.h>
 #include <proxygen/lib/http/codec/DefaultHTTPCodecFactory.h>
 #include <proxygen/lib/http/codec/HTTP1xCodec.h>
 #include <proxygen/lib/http/codec/HTTP2Codec.h>
@@ -23,6 +26,93 @@ using namespace std;
 
 namespace proxygen {
 
+namespace {
+
+// Per RFC 8305 section 4, alternate between address families so one
+// broken family only costs a single attempt delay, starting with IPv6
+std::vector<folly::SocketAddress> interleaveAddressFamilies(
+    std::vector<folly::SocketAddress> addresses) {
+  std::vector<folly::SocketAddress> v6;
+  std::vector<folly::SocketAddress> v4;
+  for (auto& address : addresses) {
+    (address.getFamily() == AF_INET6 ? v6 : v4).push_back(std::move(address));
+  }
+  std::vector<folly::SocketAddress> interleaved;
+  interleaved.reserve(addresses.size());
+  for (size_t i = 0; i < v6.size() || i < v4.size(); i++) {
+    if (i < v6.size()) {
+      interleaved.push_back(std::move(v6[i]));
+    }
+    if (i < v4.size()) {
+      interleaved.push_back(std::move(v4[i]));
+    }
+  }
+  return interleaved;
+}
+
+} // namespace
+
+/**
+ * One socket in the race. Success/failure is reported back to the owning
+ * connector, which arbitrates between attempts.
+ */
+class HTTPConnector::RacingAttempt : public folly::AsyncSocket::ConnectCallback {
+ public:
+  RacingAttempt(HTTPConnector& connector, size_t index)
+      : connector_(connector), index_(index) {
+  }
+
+  void connect(folly::EventBase* eventBase,
+               const folly::SocketAddress& address,
+               std::chrono::milliseconds timeout,
+               const folly::SocketOptionMap& socketOptions) {
+    auto sock = new folly::AsyncSocket(eventBase);
+    socket_.reset(sock);
+    sock->connect(this, address, timeout.count(), socketOptions);
+  }
+
+  void connectSuccess() noexcept override {
+    connector_.racingAttemptSucceeded(index_);
+  }
+
+  void connectErr(const folly::AsyncSocketException& ex) noexcept override {
+    connector_.racingAttemptFailed(index_, ex);
+  }
+
+  folly::AsyncSocket::UniquePtr& socket() {
+    return socket_;
+  }
+
+ private:
+  HTTPConnector& connector_;
+  size_t index_;
+  folly::AsyncSocket::UniquePtr socket_;
+};
+
+struct HTTPConnector::RacingState {
+  std::string hostname;
+  uint16_t port{0};
+  folly::EventBase* eventBase{nullptr};
+  std::chrono::milliseconds timeout{0};
+  folly::SocketOptionMap socketOptions;
+  std::chrono::milliseconds attemptDelay{0};
+
+  // TLS parameters; TCP attempts race and only the winner handshakes
+  std::shared_ptr<folly::SSLContext> sslContext;
+  std::shared_ptr<folly::ssl::SSLSession> sslSession;
+  std::string serverName;
+
+  std::vector<folly::SocketAddress> addresses;
+  size_t nextAddress{0};
+  std::vector<std::unique_ptr<RacingAttempt>> attempts;
+  size_t inFlight{0};
+  std::unique_ptr<folly::AsyncTimeout> attemptTimer;
+  folly::Optional<folly::AsyncSocketException> lastError;
+
+  TimePoint attemptsStart;
+  TimePoint tlsStart;
+};
+
 HTTPConnector::HTTPConnector(Callback* callback,
                              folly::HHWheelTimer* timeoutSet)
     : HTTPConnector(callback, WheelTimerInstance(timeoutSet)) {
@@ -40,6 +130,9 @@ HTTPConnector::~HTTPConnector() {
 }
 
 void HTTPConnector::reset() {
+  racingState_.reset();
+  // Expire the token so an in-flight DNS resolution can't call back in
+  aliveToken_ = std::make_shared<folly::Unit>();
   if (socket_) {
     auto cb = cb_;
     cb_ = nullptr;
@@ -95,6 +188,184 @@ void HTTPConnector::connectSSL(EventBase* eventBase,
       this, connectAddr, timeoutMs.count(), socketOptions, bindAddr);
 }
 
+void HTTPConnector::connectWithRacing(EventBase* eventBase,
+                                      std::string hostname,
+                                      uint16_t port,
+                                      std::chrono::milliseconds timeoutMs,
+                                      const SocketOptionMap& socketOptions,
+                                      std::chrono::milliseconds attemptDelay) {
+  DCHECK(!isBusy());
+  auto state = std::make_unique<RacingState>();
+  state->hostname = std::move(hostname);
+  state->port = port;
+  state->eventBase = eventBase;
+  state->timeout = timeoutMs;
+  state->socketOptions = socketOptions;
+  state->attemptDelay = attemptDelay;
+  startRacing(std::move(state));
+}
+
+void HTTPConnector::connectSSLWithRacing(
+    EventBase* eventBase,
+    std::string hostname,
+    uint16_t port,
+    const shared_ptr<SSLContext>& ctx,
+    std::shared_ptr<folly::ssl::SSLSession> session,
+    std::chrono::milliseconds timeoutMs,
+    const SocketOptionMap& socketOptions,
+    const std::string& serverName,
+    std::chrono::milliseconds attemptDelay) {
+  DCHECK(!isBusy());
+  CHECK(ctx);
+  auto state = std::make_unique<RacingState>();
+  state->hostname = std::move(hostname);
+  state->port = port;
+  state->eventBase = eventBase;
+  state->timeout = timeoutMs;
+  state->socketOptions = socketOptions;
+  state->attemptDelay = attemptDelay;
+  state->sslContext = ctx;
+  state->sslSession = std::move(session);
+  state->serverName = serverName;
+  startRacing(std::move(state));
+}
+
+void HTTPConnector::startRacing(std::unique_ptr<RacingState> state) {
+  racingState_ = std::move(state);
+  transportInfo_ = wangle::TransportInfo();
+  transportInfo_.secure = racingState_->sslContext != nullptr;
+  connectTiming_ = ConnectTiming();
+  connectStart_ = getCurrentTime();
+
+  // Resolution goes through the shared cache: a servable entry invokes
+  // the callback synchronously, so the first TCP attempt starts before
+  // this call returns; only a cold name pays for a lookup, and that
+  // lookup feeds every connector waiting on it
+  std::weak_ptr<folly::Unit> alive = aliveToken_;
+  DnsResolutionCache::getInstance().resolve(
+      racingState_->eventBase,
+      racingState_->hostname,
+      racingState_->port,
+      [this, alive](std::vector<folly::SocketAddress> addresses,
+                    const std::string& errorMsg) {
+        if (alive.expired()) {
+          // The connector was reset or destroyed while we resolved
+          return;
+        }
+        onRacingDnsResolved(std::move(addresses), errorMsg);
+      });
+}
+
+void HTTPConnector::onRacingDnsResolved(
+    std::vector<folly::SocketAddress> addresses, const std::string& errorMsg) {
+  CHECK(racingState_);
+  connectTiming_.dns = millisecondsSince(connectStart_);
+  if (addresses.empty()) {
+    connectErr(AsyncSocketException(AsyncSocketException::NOT_OPEN, errorMsg));
+    return;
+  }
+  racingState_->addresses = interleaveAddressFamilies(std::move(addresses));
+  racingState_->attemptsStart = getCurrentTime();
+  racingState_->attemptTimer = folly::AsyncTimeout::make(
+      *racingState_->eventBase,
+      [this]() noexcept { startNextRacingAttempt(); });
+  startNextRacingAttempt();
+}
+
+void HTTPConnector::startNextRacingAttempt() {
+  auto& state = *racingState_;
+  if (state.nextAddress >= state.addresses.size()) {
+    return;
+  }
+  auto address = state.addresses[state.nextAddress++];
+
+  std::chrono::milliseconds remaining = state.timeout;
+  if (state.timeout.count() > 0) {
+    auto elapsed = millisecondsSince(connectStart_);
+    remaining = elapsed >= state.timeout ? std::chrono::milliseconds(1)
+                                         : state.timeout - elapsed;
+  }
+
+  auto attempt = std::make_unique<RacingAttempt>(*this, state.attempts.size());
+  auto* rawAttempt = attempt.get();
+  state.attempts.push_back(std::move(attempt));
+  state.inFlight++;
+  VLOG(4) << "Racing connect attempt " << state.nextAddress << "/"
+          << state.addresses.size() << " to " << address.describe();
+  // Schedule the stagger before connecting; connect may fail
+  // synchronously and mutate the state
+  if (state.nextAddress < state.addresses.size()) {
+    state.attemptTimer->scheduleTimeout(state.attemptDelay);
+  }
+  rawAttempt->connect(state.eventBase, address, remaining, state.socketOptions);
+}
+
+void HTTPConnector::racingAttemptSucceeded(size_t index) {
+  CHECK(racingState_);
+  auto& state = *racingState_;
+  connectTiming_.tcp = millisecondsSince(state.attemptsStart);
+  state.attemptTimer->cancelTimeout();
+
+  auto socket = std::move(state.attempts[index]->socket());
+  // Abort the losers without invoking their callbacks
+  for (size_t i = 0; i < state.attempts.size(); i++) {
+    auto& loser = state.attempts[i]->socket();
+    if (i == index || !loser) {
+      continue;
+    }
+    loser->cancelConnect();
+    loser.reset();
+  }
+
+  if (state.sslContext) {
+    // Only the winner pays for a TLS handshake
+    state.tlsStart = getCurrentTime();
+    std::chrono::milliseconds remaining = state.timeout;
+    if (state.timeout.count() > 0) {
+      auto elapsed = millisecondsSince(connectStart_);
+      remaining = elapsed >= state.timeout ? std::chrono::milliseconds(1)
+                                           : state.timeout - elapsed;
+    }
+    auto sslSock = new AsyncSSLSocket(state.sslContext, std::move(socket));
+    if (state.sslSession) {
+      sslSock->setSSLSession(state.sslSession);
+    }
+    sslSock->setServerName(state.serverName);
+    sslSock->forceCacheAddrOnFailure(true);
+    socket_.reset(sslSock);
+    sslSock->sslConn(this, remaining);
+  } else {
+    socket_ = std::move(socket);
+    connectSuccess();
+  }
+}
+
+void HTTPConnector::racingAttemptFailed(size_t index,
+                                        const AsyncSocketException& ex) {
+  CHECK(racingState_);
+  auto& state = *racingState_;
+  state.attempts[index]->socket().reset();
+  state.lastError = ex;
+  state.inFlight--;
+  if (state.nextAddress < state.addresses.size()) {
+    // Per RFC 8305 section 5, a failure unblocks the next attempt
+    // without waiting out the stagger delay
+    state.attemptTimer->cancelTimeout();
+    startNextRacingAttempt();
+  } else if (state.inFlight == 0) {
+    connectErr(*state.lastError);
+  }
+}
+
+void HTTPConnector::handshakeSuc(AsyncSSLSocket* /*sock*/) noexcept {
+  connectSuccess();
+}
+
+void HTTPConnector::handshakeErr(AsyncSSLSocket* /*sock*/,
+                                 const AsyncSocketException& ex) noexcept {
+  connectErr(ex);
+}
+
 std::chrono::milliseconds HTTPConnector::timeElapsed() {
   if (timePointInitialized(connectStart_)) {
     return millisecondsSince(connectStart_);
@@ -160,11 +431,19 @@ void HTTPConnector::connectSuccess() noexcept {
                                                          transportInfo_,
                                                          nullptr);
 
+  if (racingState_) {
+    if (transportInfo_.secure) {
+      connectTiming_.tls = millisecondsSince(racingState_->tlsStart);
+    }
+    racingState_.reset();
+    cb_->connectTiming(connectTiming_);
+  }
   cb_->connectSuccess(session);
 }
 
 void HTTPConnector::connectErr(const AsyncSocketException& ex) noexcept {
   socket_.reset();
+  racingState_.reset();
   if (cb_) {
     cb_->connectError(ex);
   }
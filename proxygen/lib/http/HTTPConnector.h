@@ -8,7 +8,9 @@
 
 #pragma once
 
+#include <folly/Unit.h>
 #include <folly/io/SocketOptionMap.h>
+#include <folly/io/async/AsyncSSLSocket.h>
 #include <folly/io/async/AsyncSocket.h>
 #include <folly/io/async/HHWheelTimer.h>
 #include <folly/io/async/SSLContext.h>
@@ -29,8 +31,20 @@ extern const std::string empty_string;
  * can be reused, even to connect to different addresses, but it can only
  * service setting up one connection at a time.
  */
-class HTTPConnector : protected folly::AsyncSocket::ConnectCallback {
+class HTTPConnector : protected folly::AsyncSocket::ConnectCallback,
+                      private folly::AsyncSSLSocket::HandshakeCB {
  public:
+  /**
+   * Breakdown of where a racing connect spent its time. All fields are
+   * measured on this connector's event base; tls stays zero for
+   * plaintext connects.
+   */
+  struct ConnectTiming {
+    std::chrono::milliseconds dns{0};
+    std::chrono::milliseconds tcp{0};
+    std::chrono::milliseconds tls{0};
+  };
+
   /**
    * This class defines the pure virtual interface on which to receive the
    * result on.
@@ -41,6 +55,14 @@ class HTTPConnector : protected folly::AsyncSocket::ConnectCallback {
     }
     virtual void connectSuccess(HTTPUpstreamSession* session) = 0;
     virtual void connectError(const folly::AsyncSocketException& ex) = 0;
+
+    /**
+     * Invoked just before connectSuccess() when the connection was
+     * established by connectWithRacing()/connectSSLWithRacing(), with
+     * the DNS/TCP/TLS timing breakdown. Default is a no-op.
+     */
+    virtual void connectTiming(const ConnectTiming& /*timing*/) noexcept {
+    }
   };
 
   /**
@@ -128,6 +150,49 @@ class HTTPConnector : protected folly::AsyncSocket::ConnectCallback {
       const folly::SocketAddress& bindAddr = folly::AsyncSocket::anyAddress(),
       const std::string& serverName = empty_string);
 
+  /**
+   * Per RFC 8305, the default delay between starting consecutive
+   * connection attempts while racing.
+   */
+  static constexpr std::chrono::milliseconds kDefaultConnectionAttemptDelay{
+      250};
+
+  /**
+   * Begin a racing ("happy eyeballs", RFC 8305) plaintext connect to
+   * hostname:port. The host's A and AAAA records are resolved through
+   * the process-wide DnsResolutionCache -- a servable entry starts the
+   * first attempt before this call returns, and only a cold name pays
+   * for a lookup off the IO thread. Connects are started to the
+   * resulting addresses in
+   * family-interleaved order staggered by attemptDelay, the first
+   * attempt to complete wins and is handed to the codec, and the losers
+   * are aborted. Results arrive on the regular Callback; a DNS/TCP/TLS
+   * timing breakdown is reported via Callback::connectTiming().
+   */
+  void connectWithRacing(
+      folly::EventBase* eventBase,
+      std::string hostname,
+      uint16_t port,
+      std::chrono::milliseconds timeoutMs = std::chrono::milliseconds(0),
+      const folly::SocketOptionMap& socketOptions = folly::emptySocketOptionMap,
+      std::chrono::milliseconds attemptDelay = kDefaultConnectionAttemptDelay);
+
+  /**
+   * Racing variant of connectSSL(). Only TCP attempts race; the winning
+   * connection alone pays for a TLS handshake, which also yields a clean
+   * TCP vs TLS split in the reported timing.
+   */
+  void connectSSLWithRacing(
+      folly::EventBase* eventBase,
+      std::string hostname,
+      uint16_t port,
+      const std::shared_ptr<folly::SSLContext>& ctx,
+      std::shared_ptr<folly::ssl::SSLSession> session = nullptr,
+      std::chrono::milliseconds timeoutMs = std::chrono::milliseconds(0),
+      const folly::SocketOptionMap& socketOptions = folly::emptySocketOptionMap,
+      const std::string& serverName = empty_string,
+      std::chrono::milliseconds attemptDelay = kDefaultConnectionAttemptDelay);
+
   /**
    * @returns the number of milliseconds since connecting began, or
    * zero if connecting hasn't started yet.
@@ -139,7 +204,14 @@ class HTTPConnector : protected folly::AsyncSocket::ConnectCallback {
    * this is false, it is safe to call connect() or connectSSL() on it again.
    */
   bool isBusy() const {
-    return socket_.get();
+    return socket_.get() || racingState_.get();
+  }
+
+  /**
+   * @returns the timing breakdown of the last racing connect.
+   */
+  const ConnectTiming& getConnectTiming() const {
+    return connectTiming_;
   }
 
   void setHTTPCodecFactory(std::unique_ptr<DefaultHTTPCodecFactory> factory) {
@@ -150,6 +222,10 @@ class HTTPConnector : protected folly::AsyncSocket::ConnectCallback {
   void connectSuccess() noexcept override;
   void connectErr(const folly::AsyncSocketException& ex) noexcept override;
 
+  void handshakeSuc(folly::AsyncSSLSocket* sock) noexcept override;
+  void handshakeErr(folly::AsyncSSLSocket* sock,
+                    const folly::AsyncSocketException& ex) noexcept override;
+
   Callback* cb_;
   WheelTimerInstance timeout_;
   folly::AsyncTransport::UniquePtr socket_;
@@ -157,6 +233,23 @@ class HTTPConnector : protected folly::AsyncSocket::ConnectCallback {
   std::string plaintextProtocol_;
   TimePoint connectStart_;
   std::unique_ptr<DefaultHTTPCodecFactory> httpCodecFactory_;
+
+ private:
+  class RacingAttempt;
+  struct RacingState;
+
+  void startRacing(std::unique_ptr<RacingState> state);
+  void onRacingDnsResolved(std::vector<folly::SocketAddress> addresses,
+                           const std::string& errorMsg);
+  void startNextRacingAttempt();
+  void racingAttemptSucceeded(size_t index);
+  void racingAttemptFailed(size_t index,
+                           const folly::AsyncSocketException& ex);
+
+  std::unique_ptr<RacingState> racingState_;
+  ConnectTiming connectTiming_;
+  // Invalidates in-flight DNS resolutions on reset()/destruction
+  std::shared_ptr<folly::Unit> aliveToken_{std::make_shared<folly::Unit>()};
 };
 
 } // namespace proxygen
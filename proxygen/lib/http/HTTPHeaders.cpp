@@ -9,16 +9,88 @@
 #define PROXYGEN_HTTPHEADERS_IMPL
 #include <proxygen/lib/http/HTTPHeaders.h>
 
+#include <folly/Synchronized.h>
 #include <glog/logging.h>
 
+#include <unordered_set>
+
 using std::bitset;
 using std::string;
 
+namespace {
+
+/**
+ * Process-wide pool of uncommon header names.  Interning at parse time
+ * lets repeated instances of the same uncommon name share one canonical
+ * string, which InternedName lookups can then match by pointer.  The pool
+ * is capped so adversarial traffic full of unique names cannot grow it
+ * without bound; once full, new names from the wire fall back to
+ * per-collection copies.  Entries are never evicted -- interned pointers
+ * must stay valid for the life of the process.
+ */
+class HeaderNamePool {
+ public:
+  const std::string* tryIntern(folly::StringPiece name, bool force) {
+    std::string key = name.str();
+    {
+      auto pool = pool_.rlock();
+      auto it = pool->find(key);
+      if (it != pool->end()) {
+        return &*it;
+      }
+    }
+    auto pool = pool_.wlock();
+    if (!force && pool->size() >= kMaxPooledNames) {
+      // The name may have been interned since the read lock was dropped
+      auto it = pool->find(key);
+      return it != pool->end() ? &*it : nullptr;
+    }
+    return &*pool->insert(std::move(key)).first;
+  }
+
+ private:
+  // Far more distinct uncommon names than any sane peer uses; a full pool
+  // holds on to roughly 100KB
+  static constexpr size_t kMaxPooledNames = 1024;
+
+  // std::unordered_set never moves its elements, so the pointers handed
+  // out survive rehashing
+  folly::Synchronized<std::unordered_set<std::string>> pool_;
+};
+
+HeaderNamePool& headerNamePool() {
+  // Leaked deliberately: static InternedName handles in other translation
+  // units may be referenced during shutdown
+  static auto pool = new HeaderNamePool();
+  return *pool;
+}
+
+} // namespace
+
 namespace proxygen {
 
 const string empty_string;
 const std::string HTTPHeaders::COMBINE_SEPARATOR = ", ";
 
+HTTPHeaders::InternedName HTTPHeaders::internName(folly::StringPiece name) {
+  const HTTPHeaderCode code = HTTPCommonHeaders::hash(name.data(), name.size());
+  if (code != HTTP_HEADER_OTHER) {
+    return InternedName(code, HTTPCommonHeaders::getPointerToName(code));
+  }
+  // force: handles come from code that knows a bounded set of names, so
+  // they are allowed past the wire-name cap
+  return InternedName(code, headerNamePool().tryIntern(name, true /*force*/));
+}
+
+std::pair<std::string*, bool> HTTPHeaders::resolveOtherName(
+    folly::StringPiece name) {
+  auto interned = headerNamePool().tryIntern(name, false /*force*/);
+  if (interned) {
+    return {const_cast<std::string*>(interned), false};
+  }
+  return {new std::string(name.data(), name.size()), true};
+}
+
 bitset<256>& HTTPHeaders::perHopHeaderCodes() {
   static bitset<256> perHopHeaderCodes{[] {
     bitset<256> bs;
@@ -43,15 +115,26 @@ HTTPHeaders::HTTPHeaders() : deletedCount_(0) {
 void HTTPHeaders::add(folly::StringPiece name, folly::StringPiece value) {
   CHECK(name.size());
   const HTTPHeaderCode code = HTTPCommonHeaders::hash(name.data(), name.size());
-  emplace_back(code,
-               ((code == HTTP_HEADER_OTHER)
-                    ? new std::string(name.data(), name.size())
-                    : (std::string*)HTTPCommonHeaders::getPointerToName(code)),
-               value);
+  if (code == HTTP_HEADER_OTHER) {
+    auto namePtr = resolveOtherName(name);
+    emplace_back(code, namePtr.first, value, namePtr.second);
+  } else {
+    emplace_back(code,
+                 (std::string*)HTTPCommonHeaders::getPointerToName(code),
+                 value,
+                 false);
+  }
 }
 
 void HTTPHeaders::add(HTTPHeaders::headers_initializer_list l) {
-  for (auto& p : l) {
+  addBatch({l.begin(), l.size()});
+}
+
+void HTTPHeaders::addBatch(
+    folly::Range<const std::pair<HTTPHeaderName, folly::StringPiece>*>
+        headers) {
+  ensure(length_ + headers.size());
+  for (auto& p : headers) {
     if (p.first.type_ == HTTPHeaderName::CODE) {
       add(p.first.code_, folly::StringPiece(p.second.data(), p.second.size()));
     } else {
@@ -66,11 +149,30 @@ void HTTPHeaders::rawAdd(const std::string& name, const std::string& value) {
 
 void HTTPHeaders::addFromCodec(const char* str, size_t len, string&& value) {
   const HTTPHeaderCode code = HTTPCommonHeaders::hash(str, len);
-  auto namePtr = (code == HTTP_HEADER_OTHER)
-                     ? new string(str, len)
-                     : (std::string*)HTTPCommonHeaders::getPointerToName(code);
+  if (code == HTTP_HEADER_OTHER) {
+    auto namePtr = resolveOtherName(folly::StringPiece(str, len));
+    emplace_back(code, namePtr.first, std::move(value), namePtr.second);
+  } else {
+    emplace_back(code,
+                 (std::string*)HTTPCommonHeaders::getPointerToName(code),
+                 std::move(value),
+                 false);
+  }
+}
 
-  emplace_back(code, namePtr, std::move(value));
+void HTTPHeaders::addFromCodec(const char* str,
+                               size_t len,
+                               folly::StringPiece value) {
+  const HTTPHeaderCode code = HTTPCommonHeaders::hash(str, len);
+  if (code == HTTP_HEADER_OTHER) {
+    auto namePtr = resolveOtherName(folly::StringPiece(str, len));
+    emplace_back(code, namePtr.first, value, namePtr.second);
+  } else {
+    emplace_back(code,
+                 (std::string*)HTTPCommonHeaders::getPointerToName(code),
+                 value,
+                 false);
+  }
 }
 
 bool HTTPHeaders::exists(folly::StringPiece name) const {
@@ -87,6 +189,19 @@ bool HTTPHeaders::exists(HTTPHeaderCode code) const {
   return length_ > 0 && memchr((void*)codes(), code, length_) != nullptr;
 }
 
+bool HTTPHeaders::exists(const InternedName& name) const {
+  if (name.code_ != HTTP_HEADER_OTHER) {
+    return exists(name.code_);
+  }
+  ITERATE_OVER_CODES(HTTP_HEADER_OTHER, {
+    if (names()[pos] == name.name_ ||
+        caseInsensitiveEqual(*name.name_, *names()[pos])) {
+      return true;
+    }
+  });
+  return false;
+}
+
 size_t HTTPHeaders::getNumberOfValues(HTTPHeaderCode code) const {
   size_t count = 0;
   ITERATE_OVER_CODES(code, {
@@ -112,7 +227,10 @@ bool HTTPHeaders::remove(folly::StringPiece name) {
   } else {
     bool removed = false;
     ITERATE_OVER_STRINGS(name, {
-      delete names()[pos];
+      if (flags()[pos]) {
+        delete names()[pos];
+        flags()[pos] = 0;
+      }
       codes()[pos] = HTTP_HEADER_NONE;
       removed = true;
       ++deletedCount_;
@@ -138,7 +256,10 @@ bool HTTPHeaders::removeAllVersions(HTTPHeaderCode code,
     removed = remove(code);
   }
   ITERATE_OVER_STRINGS_ALL_VERSION(name, {
-    delete names()[pos];
+    if (flags()[pos]) {
+      delete names()[pos];
+      flags()[pos] = 0;
+    }
     codes()[pos] = HTTP_HEADER_NONE;
     removed = true;
     ++deletedCount_;
@@ -147,15 +268,20 @@ bool HTTPHeaders::removeAllVersions(HTTPHeaderCode code,
 }
 
 void HTTPHeaders::disposeOfHeaderNames() {
-  ITERATE_OVER_CODES(HTTP_HEADER_OTHER, { delete names()[pos]; });
+  ITERATE_OVER_CODES(HTTP_HEADER_OTHER, {
+    if (flags()[pos]) {
+      delete names()[pos];
+      flags()[pos] = 0;
+    }
+  });
 }
 
 void HTTPHeaders::destroy() {
-  auto c = codes();
+  auto f = flags();
   auto n = names();
   auto v = values();
   for (size_t i = 0; i < length_; ++i) {
-    if (c[i] == HTTP_HEADER_OTHER) {
+    if (f[i]) {
       delete n[i];
     }
     auto p = v + i;
@@ -186,11 +312,14 @@ void HTTPHeaders::copyFrom(const HTTPHeaders& other) {
   ensure(other.capacity_);
   memcpy(codes(), other.codes(), other.length_);
   for (size_t i = 0; i < other.length_; i++) {
-    if (codes()[i] == HTTP_HEADER_OTHER) {
+    if (other.flags()[i]) {
+      // Only names the source owns need a copy; common and interned
+      // names are shared
       names()[i] = new std::string(*other.names()[i]);
     } else {
       names()[i] = other.names()[i];
     }
+    flags()[i] = other.flags()[i];
     new (values() + i) std::string(other.values()[i]);
   }
   length_ = other.length_;
@@ -234,8 +363,12 @@ bool HTTPHeaders::transferHeaderIfPresent(folly::StringPiece name,
   const HTTPHeaderCode code = HTTPCommonHeaders::hash(name.data(), name.size());
   if (code == HTTP_HEADER_OTHER) {
     ITERATE_OVER_STRINGS(name, {
-      strippedHeaders.emplace_back(
-          HTTP_HEADER_OTHER, names()[pos], std::move(values()[pos]));
+      strippedHeaders.emplace_back(HTTP_HEADER_OTHER,
+                                   names()[pos],
+                                   std::move(values()[pos]),
+                                   flags()[pos] != 0);
+      // Name ownership moves with the entry
+      flags()[pos] = 0;
       codes()[pos] = HTTP_HEADER_NONE;
       transferred = true;
       ++deletedCount_;
@@ -243,7 +376,7 @@ bool HTTPHeaders::transferHeaderIfPresent(folly::StringPiece name,
   } else { // code != HTTP_HEADER_OTHER
     ITERATE_OVER_CODES(code, {
       strippedHeaders.emplace_back(
-          code, names()[pos], std::move(values()[pos]));
+          code, names()[pos], std::move(values()[pos]), false);
       codes()[pos] = HTTP_HEADER_NONE;
       transferred = true;
       ++deletedCount_;
@@ -307,7 +440,8 @@ void HTTPHeaders::stripPerHopHeaders(HTTPHeaders& strippedHeaders) {
   for (size_t i = 0; i < length_; ++i) {
     if (perHopHeaders[codes()[i]]) {
       strippedHeaders.emplace_back(
-          codes()[i], names()[i], std::move(values()[i]));
+          codes()[i], names()[i], std::move(values()[i]), flags()[i] != 0);
+      flags()[i] = 0;
       codes()[i] = HTTP_HEADER_NONE;
       ++deletedCount_;
       VLOG(5) << "Stripped hop-by-hop header " << *names()[i];
@@ -320,10 +454,9 @@ void HTTPHeaders::copyTo(HTTPHeaders& hdrs) const {
   for (size_t i = 0; i < length_; ++i) {
     if (codes()[i] != HTTP_HEADER_NONE) {
       hdrs.emplace_back(codes()[i],
-                        ((codes()[i] == HTTP_HEADER_OTHER)
-                             ? new string(*names()[i])
-                             : names()[i]),
-                        values()[i]);
+                        flags()[i] ? new string(*names()[i]) : names()[i],
+                        values()[i],
+                        flags()[i] != 0);
     }
   }
 }
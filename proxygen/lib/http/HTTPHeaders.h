@@ -12,6 +12,7 @@
 #include <folly/Range.h>
 #include <folly/String.h>
 #include <proxygen/lib/http/HTTPCommonHeaders.h>
+#include <proxygen/lib/utils/AllocationTracker.h>
 #include <proxygen/lib/utils/Export.h>
 #include <proxygen/lib/utils/UtilInl.h>
 
@@ -19,6 +20,7 @@
 #include <cstring>
 #include <initializer_list>
 #include <string>
+#include <utility>
 
 namespace proxygen {
 
@@ -53,8 +55,10 @@ inline bool isLWS(char c) {
  * Instead of creating strings with header names, we point to a static array
  * of strings in HTTPCommonHeaders. If the header name is not in our set of
  * common header names (this is considered unlikely, because we intend this set
- * to be very complete), then we create a new string with its name (we own that
- * pointer then). For such headers, we store the code HTTP_HEADER_OTHER.
+ * to be very complete), then we intern the name in a capped process-wide pool
+ * so repeated instances share one canonical string; once the pool is full,
+ * new names fall back to per-collection copies that we own. For such headers,
+ * we store the code HTTP_HEADER_OTHER.
  *
  * The code HTTP_HEADER_NONE signifies a header that has been removed.
  *
@@ -85,6 +89,40 @@ class HTTPHeaders {
     }
   };
 
+  /**
+   * A header name resolved once to its common-header code, or, for
+   * uncommon names, to a canonical interned string (see internName()).
+   * Lookups taking an InternedName skip the per-call perfect hash, and an
+   * uncommon name matches headers parsed through the same pool with a
+   * single pointer compare.  Handles are trivially copyable and valid for
+   * the life of the process; resolve well-known names once, e.g. into a
+   * function-local static.
+   */
+  class InternedName {
+   public:
+    HTTPHeaderCode code() const {
+      return code_;
+    }
+    const std::string& name() const {
+      return *name_;
+    }
+
+   private:
+    friend class HTTPHeaders;
+    InternedName(HTTPHeaderCode code, const std::string* name)
+        : code_(code), name_(name) {
+    }
+    HTTPHeaderCode code_;
+    const std::string* name_; // never nullptr
+  };
+
+  /**
+   * Resolve a header name to an InternedName.  Uncommon names are added
+   * to the intern pool unconditionally, so call this for a bounded set of
+   * names your code knows about, not for names taken from the wire.
+   */
+  static InternedName internName(folly::StringPiece name);
+
   using headers_initializer_list =
       std::initializer_list<std::pair<HTTPHeaderName, folly::StringPiece>>;
 
@@ -122,10 +160,34 @@ class HTTPHeaders {
   }
   template <typename T> // T = string
   void add(HTTPHeaderCode code, T&& value);
+  template <typename T> // T = string
+  void add(const InternedName& name, T&& value);
   void add(headers_initializer_list l);
   void rawAdd(const std::string& name, const std::string& value);
 
+  /**
+   * Reserve room for at least 'n' additional headers, so that a subsequent
+   * run of add() calls performs at most one reallocation.  Codecs that
+   * learn the header count before inserting (e.g. from a parsed header
+   * block) should call this first.
+   */
+  void reserve(size_t n) {
+    ensure(length_ + n);
+  }
+
+  /**
+   * Add every (name, value) pair in the range, doing the capacity check
+   * once up front instead of per header.  Takes the same pair type as the
+   * initializer-list overload of add(), so both codes and string names
+   * work:
+   *     hdrs.addBatch({pairs.data(), pairs.size()});
+   */
+  void addBatch(
+      folly::Range<const std::pair<HTTPHeaderName, folly::StringPiece>*>
+          headers);
+
   void addFromCodec(const char* str, size_t len, std::string&& value);
+  void addFromCodec(const char* str, size_t len, folly::StringPiece value);
 
   /**
    * For the header 'name', set its value to the single header 'value',
@@ -161,6 +223,7 @@ class HTTPHeaders {
    */
   bool exists(folly::StringPiece name) const;
   bool exists(HTTPHeaderCode code) const;
+  bool exists(const InternedName& name) const;
   bool rawExists(std::string& name) const {
     return exists(name);
   }
@@ -221,7 +284,7 @@ class HTTPHeaders {
    * only value under the given name. If either of these is violated, returns
    * empty_string.
    */
-  template <typename T> // either uint8_t or string
+  template <typename T> // uint8_t, string or InternedName
   const std::string& getSingleOrEmpty(const T& nameOrCode) const;
   const std::string rawGet(const std::string& header) const {
     return getSingleOrEmpty(header);
@@ -249,6 +312,9 @@ class HTTPHeaders {
   inline bool forEachValueOfHeader(folly::StringPiece name, LAMBDA func) const;
   template <typename LAMBDA> // const string & -> bool
   inline bool forEachValueOfHeader(HTTPHeaderCode code, LAMBDA func) const;
+  template <typename LAMBDA> // const string & -> bool
+  inline bool forEachValueOfHeader(const InternedName& name,
+                                   LAMBDA func) const;
 
   /**
    * Remove all instances of the given header, returning true if anything was
@@ -287,6 +353,25 @@ class HTTPHeaders {
    */
   void copyTo(HTTPHeaders& hdrs) const;
 
+  /**
+   * Raw struct-of-arrays view of the header table: three parallel arrays
+   * indexed 0..codeRange().size().  Entries whose code is HTTP_HEADER_NONE
+   * are deleted headers and must be skipped (their name pointer may be
+   * null); consequently the view can be longer than size().  Scanning
+   * codeRange() touches one byte per header and no strings, which is what
+   * filters that only dispatch on the code should use.  Any mutation of
+   * this HTTPHeaders invalidates the view.
+   */
+  folly::Range<const HTTPHeaderCode*> codeRange() const {
+    return {codes(), length_};
+  }
+  folly::Range<const std::string* const*> nameRange() const {
+    return {names(), length_};
+  }
+  folly::Range<const std::string*> valueRange() const {
+    return {values(), length_};
+  }
+
   /**
    * Determines whether header with a given code is a per-hop header,
    * which should be stripped by stripPerHopHeaders().
@@ -327,12 +412,35 @@ class HTTPHeaders {
   }
 
   /**
-   * The initial capacity of the three vectors, reserved right after
+   * Per-entry flag: nonzero iff names()[i] is heap-allocated and owned by
+   * this collection (always an HTTP_HEADER_OTHER name that missed the
+   * intern pool).  Common and interned names are shared, never deleted.
+   */
+  uint8_t* flags() const {
+    return flags(memory_.get(), capacity_);
+  }
+
+  uint8_t* flags(const uint8_t* memory, size_t capacity) const {
+    return (uint8_t*)(memory +
+                      capacity * (sizeof(std::string*) + sizeof(std::string) +
+                                  sizeof(char)));
+  }
+
+  /**
+   * The initial capacity of the four vectors, reserved right after
    * construction.
    */
   static const size_t kInitialVectorReserve = 16;
   static const size_t kRecSize =
-      (sizeof(char) + sizeof(std::string*) + sizeof(std::string));
+      (2 * sizeof(char) + sizeof(std::string*) + sizeof(std::string));
+
+  /**
+   * Look up an uncommon name in the intern pool, falling back to a heap
+   * copy once the pool is full.  The bool is true iff the caller owns the
+   * returned string.
+   */
+  static std::pair<std::string*, bool> resolveOtherName(
+      folly::StringPiece name);
 
   /**
    * Moves the named header and values from this group to the destination
@@ -367,11 +475,14 @@ class HTTPHeaders {
       return;
     }
     auto newMemory = std::make_unique<uint8_t[]>(capacity * kRecSize);
+    AllocationTracker::recordAllocation(AllocationTracker::MESSAGE,
+                                        capacity * kRecSize);
     if (length_ > 0) {
       memcpy(codes(newMemory.get(), capacity), codes(), length_);
       memcpy(names(newMemory.get(), capacity),
              names(),
              sizeof(std::string*) * length_);
+      memcpy(flags(newMemory.get(), capacity), flags(), length_);
       auto vNew = values(newMemory.get(), capacity);
       auto v = values();
       for (size_t i = 0; i < length_; i++) {
@@ -385,30 +496,40 @@ class HTTPHeaders {
   template <typename T>
   typename std::enable_if<std::is_same<T, const std::string&>::value ||
                           std::is_same<T, std::string&&>::value>::type
-  emplace_back(HTTPHeaderCode code, std::string* name, T&& value) {
+  emplace_back(HTTPHeaderCode code,
+               std::string* name,
+               T&& value,
+               bool ownsName) {
     auto v = values();
     void* valuePtr = (void*)&value;
     if (length_ == capacity_ && valuePtr >= (void*)v &&
         valuePtr < (void*)(v + length_)) {
       std::string savedValue = std::forward<T>(value);
-      emplace_back_impl(code, name, std::move(savedValue));
+      emplace_back_impl(code, name, std::move(savedValue), ownsName);
     } else {
-      emplace_back_impl(code, name, std::forward<T>(value));
+      emplace_back_impl(code, name, std::forward<T>(value), ownsName);
     }
   }
 
   template <typename T>
   typename std::enable_if<!std::is_same<T, const std::string&>::value &&
                           !std::is_same<T, std::string&&>::value>::type
-  emplace_back(HTTPHeaderCode code, std::string* name, T&& value) {
-    emplace_back_impl(code, name, std::forward<T>(value));
+  emplace_back(HTTPHeaderCode code,
+               std::string* name,
+               T&& value,
+               bool ownsName) {
+    emplace_back_impl(code, name, std::forward<T>(value), ownsName);
   }
 
   template <typename T>
-  void emplace_back_impl(HTTPHeaderCode code, std::string* name, T&& value) {
+  void emplace_back_impl(HTTPHeaderCode code,
+                         std::string* name,
+                         T&& value,
+                         bool ownsName) {
     ensure(length_ + 1);
     codes()[length_] = code;
     names()[length_] = name;
+    flags()[length_] = ownsName;
     std::string* p = values() + length_++;
     new (p) std::string(std::forward<T>(value));
     if (!p->empty() && isLWS(p->back())) {
@@ -424,17 +545,31 @@ template <typename T> // T = string
 void HTTPHeaders::add(folly::StringPiece name, T&& value) {
   assert(name.size());
   const HTTPHeaderCode code = HTTPCommonHeaders::hash(name.data(), name.size());
-  auto namePtr =
-      ((code == HTTP_HEADER_OTHER)
-           ? new std::string(name.data(), name.size())
-           : (std::string*)HTTPCommonHeaders::getPointerToName(code));
-  emplace_back(code, namePtr, std::forward<T>(value));
+  if (code == HTTP_HEADER_OTHER) {
+    auto namePtr = resolveOtherName(name);
+    emplace_back(code, namePtr.first, std::forward<T>(value), namePtr.second);
+  } else {
+    emplace_back(code,
+                 (std::string*)HTTPCommonHeaders::getPointerToName(code),
+                 std::forward<T>(value),
+                 false);
+  }
 }
 
 template <typename T> // T = string
 void HTTPHeaders::add(HTTPHeaderCode code, T&& value) {
   auto namePtr = (std::string*)HTTPCommonHeaders::getPointerToName(code);
-  emplace_back(code, namePtr, std::forward<T>(value));
+  emplace_back(code, namePtr, std::forward<T>(value), false);
+}
+
+template <typename T> // T = string
+void HTTPHeaders::add(const InternedName& name, T&& value) {
+  // Both common and interned name strings outlive any HTTPHeaders, so the
+  // entry never owns its name
+  emplace_back(name.code_,
+               const_cast<std::string*>(name.name_),
+               std::forward<T>(value),
+               false);
 }
 
 // iterate over the positions (in vector) of all headers with given code
@@ -517,6 +652,26 @@ bool HTTPHeaders::forEachValueOfHeader(HTTPHeaderCode code, LAMBDA func) const {
   return false;
 }
 
+template <typename LAMBDA> // const string & -> bool
+bool HTTPHeaders::forEachValueOfHeader(const InternedName& name,
+                                       LAMBDA func) const {
+  if (name.code_ != HTTP_HEADER_OTHER) {
+    return forEachValueOfHeader(name.code_, func);
+  }
+  ITERATE_OVER_CODES(HTTP_HEADER_OTHER, {
+    // Names added through the intern pool share the handle's pointer, so
+    // the common case is one compare; entries holding per-collection
+    // copies (pool misses) still take the string comparison
+    if (names()[pos] == name.name_ ||
+        caseInsensitiveEqual(*name.name_, *names()[pos])) {
+      if (func(values()[pos])) {
+        return true;
+      }
+    }
+  });
+  return false;
+}
+
 template <typename T>
 std::string HTTPHeaders::combine(const T& header,
                                  const std::string& separator) const {
@@ -545,7 +700,10 @@ bool HTTPHeaders::removeByPredicate(LAMBDA func) {
     }
 
     if (c[i] == HTTP_HEADER_OTHER) {
-      delete n[i];
+      if (flags()[i]) {
+        delete n[i];
+        flags()[i] = 0;
+      }
       n[i] = nullptr;
     }
 
@@ -557,7 +715,7 @@ bool HTTPHeaders::removeByPredicate(LAMBDA func) {
   return removed;
 }
 
-template <typename T> // either uint8_t or string
+template <typename T> // uint8_t, string or InternedName
 const std::string& HTTPHeaders::getSingleOrEmpty(const T& nameOrCode) const {
   const std::string* res = nullptr;
   forEachValueOfHeader(nameOrCode, [&](const std::string& value) -> bool {
@@ -8,10 +8,17 @@
 
 #include <proxygen/lib/http/HTTPMessage.h>
 
+#include <proxygen/lib/http/codec/CodecUtil.h>
+
 #include <boost/algorithm/string.hpp>
 #include <folly/Format.h>
+#include <folly/Indestructible.h>
 #include <folly/Range.h>
 #include <folly/SingletonThreadLocal.h>
+#include <folly/concurrency/AtomicSharedPtr.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -40,6 +47,49 @@ std::string httpPriorityToString(uint8_t urgency, bool incremental) {
 
 std::mutex HTTPMessage::mutexDump_;
 
+namespace {
+// Thread-local recycling of HTTPMessage-sized blocks; sized to cover the
+// messages in flight on one event base loop without pinning much memory
+constexpr size_t kMessageBlockCacheSize = 32;
+
+struct MessageBlockCache {
+  std::array<void*, kMessageBlockCacheSize> blocks;
+  size_t size{0};
+
+  ~MessageBlockCache() {
+    while (size > 0) {
+      ::operator delete(blocks[--size]);
+    }
+  }
+};
+
+MessageBlockCache& messageBlockCache() {
+  struct CacheTag {};
+  return folly::SingletonThreadLocal<MessageBlockCache, CacheTag>::get();
+}
+} // namespace
+
+void* HTTPMessage::operator new(size_t size) {
+  if (LIKELY(size == sizeof(HTTPMessage))) {
+    auto& cache = messageBlockCache();
+    if (cache.size > 0) {
+      return cache.blocks[--cache.size];
+    }
+  }
+  return ::operator new(size);
+}
+
+void HTTPMessage::operator delete(void* ptr, size_t size) {
+  if (LIKELY(size == sizeof(HTTPMessage))) {
+    auto& cache = messageBlockCache();
+    if (cache.size < kMessageBlockCacheSize) {
+      cache.blocks[cache.size++] = ptr;
+      return;
+    }
+  }
+  ::operator delete(ptr);
+}
+
 const pair<uint8_t, uint8_t> HTTPMessage::kHTTPVersion09(0, 9);
 const pair<uint8_t, uint8_t> HTTPMessage::kHTTPVersion10(1, 0);
 const pair<uint8_t, uint8_t> HTTPMessage::kHTTPVersion11(1, 1);
@@ -60,7 +110,7 @@ void HTTPMessage::stripPerHopHeaders() {
     trailersAllowed_ = checkForHeaderToken(HTTP_HEADER_TE, "trailers", false);
   }
 
-  headers_.stripPerHopHeaders(*strippedPerHopHeaders_);
+  mutableHeaders().stripPerHopHeaders(*strippedPerHopHeaders_);
 }
 
 HTTPMessage::HTTPMessage()
@@ -76,7 +126,9 @@ HTTPMessage::HTTPMessage()
       pri_(kDefaultHttpPriorityUrgency),
       version_(1, 0),
       parsedCookies_(false),
+      parsedCookieIndex_(false),
       parsedQueryParams_(false),
+      parsedQueryParamIndex_(false),
       chunked_(false),
       upgraded_(false),
       wantsKeepalive_(true),
@@ -98,7 +150,9 @@ HTTPMessage::HTTPMessage(const HTTPMessage& message)
       cookies_(message.cookies_),
       queryParams_(message.queryParams_),
       headers_(message.headers_),
+      sharedHeaders_(message.sharedHeaders_),
       upgradeWebsocket_(message.upgradeWebsocket_),
+      preSerializedHeaders_(message.preSerializedHeaders_),
       seqNo_(message.seqNo_),
       sslVersion_(message.sslVersion_),
       sslCipher_(message.sslCipher_),
@@ -107,7 +161,9 @@ HTTPMessage::HTTPMessage(const HTTPMessage& message)
       h2Pri_(message.h2Pri_),
       version_(message.version_),
       parsedCookies_(message.parsedCookies_),
+      parsedCookieIndex_(false),
       parsedQueryParams_(message.parsedQueryParams_),
+      parsedQueryParamIndex_(false),
       chunked_(message.chunked_),
       upgraded_(message.upgraded_),
       wantsKeepalive_(message.wantsKeepalive_),
@@ -136,9 +192,11 @@ HTTPMessage::HTTPMessage(HTTPMessage&& message) noexcept
       cookies_(std::move(message.cookies_)),
       queryParams_(std::move(message.queryParams_)),
       headers_(std::move(message.headers_)),
+      sharedHeaders_(std::move(message.sharedHeaders_)),
       strippedPerHopHeaders_(std::move(message.strippedPerHopHeaders_)),
       upgradeWebsocket_(message.upgradeWebsocket_),
       trailers_(std::move(message.trailers_)),
+      preSerializedHeaders_(std::move(message.preSerializedHeaders_)),
       seqNo_(message.seqNo_),
       sslVersion_(message.sslVersion_),
       sslCipher_(message.sslCipher_),
@@ -147,7 +205,9 @@ HTTPMessage::HTTPMessage(HTTPMessage&& message) noexcept
       h2Pri_(message.h2Pri_),
       version_(message.version_),
       parsedCookies_(message.parsedCookies_),
+      parsedCookieIndex_(false),
       parsedQueryParams_(message.parsedQueryParams_),
+      parsedQueryParamIndex_(false),
       chunked_(message.chunked_),
       upgraded_(message.upgraded_),
       wantsKeepalive_(message.wantsKeepalive_),
@@ -177,6 +237,7 @@ HTTPMessage& HTTPMessage::operator=(const HTTPMessage& message) {
   queryParams_ = message.queryParams_;
   version_ = message.version_;
   headers_ = message.headers_;
+  sharedHeaders_ = message.sharedHeaders_;
   if (message.strippedPerHopHeaders_) {
     strippedPerHopHeaders_ =
         std::make_unique<HTTPHeaders>(*message.strippedPerHopHeaders_);
@@ -189,13 +250,18 @@ HTTPMessage& HTTPMessage::operator=(const HTTPMessage& message) {
   pri_ = message.pri_;
   h2Pri_ = message.h2Pri_;
   parsedCookies_ = message.parsedCookies_;
+  cookieIndex_.clear();
+  parsedCookieIndex_ = false;
   parsedQueryParams_ = message.parsedQueryParams_;
+  queryParamIndex_.clear();
+  parsedQueryParamIndex_ = false;
   chunked_ = message.chunked_;
   upgraded_ = message.upgraded_;
   wantsKeepalive_ = message.wantsKeepalive_;
   trailersAllowed_ = message.trailersAllowed_;
   secure_ = message.secure_;
   upgradeWebsocket_ = message.upgradeWebsocket_;
+  preSerializedHeaders_ = message.preSerializedHeaders_;
 
   if (message.trailers_) {
     trailers_ = std::make_unique<HTTPHeaders>(*message.trailers_);
@@ -224,6 +290,7 @@ HTTPMessage& HTTPMessage::operator=(HTTPMessage&& message) {
   queryParams_ = std::move(message.queryParams_);
   version_ = message.version_;
   headers_ = std::move(message.headers_);
+  sharedHeaders_ = std::move(message.sharedHeaders_);
   strippedPerHopHeaders_ = std::move(message.strippedPerHopHeaders_);
   sslVersion_ = message.sslVersion_;
   sslCipher_ = message.sslCipher_;
@@ -231,7 +298,11 @@ HTTPMessage& HTTPMessage::operator=(HTTPMessage&& message) {
   pri_ = message.pri_;
   h2Pri_ = message.h2Pri_;
   parsedCookies_ = message.parsedCookies_;
+  cookieIndex_.clear();
+  parsedCookieIndex_ = false;
   parsedQueryParams_ = message.parsedQueryParams_;
+  queryParamIndex_.clear();
+  parsedQueryParamIndex_ = false;
   chunked_ = message.chunked_;
   upgraded_ = message.upgraded_;
   wantsKeepalive_ = message.wantsKeepalive_;
@@ -239,9 +310,21 @@ HTTPMessage& HTTPMessage::operator=(HTTPMessage&& message) {
   secure_ = message.secure_;
   upgradeWebsocket_ = message.upgradeWebsocket_;
   trailers_ = std::move(message.trailers_);
+  preSerializedHeaders_ = std::move(message.preSerializedHeaders_);
   return *this;
 }
 
+HTTPMessage HTTPMessage::cloneShallow() {
+  if (!sharedHeaders_) {
+    // Freeze this message's headers into a shared block; moving leaves
+    // headers_ valid and empty, ready for copy-on-write materialization
+    sharedHeaders_ = std::make_shared<const HTTPHeaders>(std::move(headers_));
+  }
+  // The copy constructor copies sharedHeaders_, so the clone (and any
+  // further plain copies of either message) shares the same block
+  return HTTPMessage(*this);
+}
+
 void HTTPMessage::setMethod(HTTPMethod method) {
   Request& req = request();
   req.method_ = method;
@@ -304,7 +387,7 @@ const pair<uint8_t, uint8_t>& HTTPMessage::getHTTPVersion() const {
 
 int HTTPMessage::processMaxForwards() {
   if (getMethod() == HTTPMethod::TRACE || getMethod() == HTTPMethod::OPTIONS) {
-    const string& value = headers_.getSingleOrEmpty(HTTP_HEADER_MAX_FORWARDS);
+    const string& value = cheaders().getSingleOrEmpty(HTTP_HEADER_MAX_FORWARDS);
     if (value.length() > 0) {
       int64_t max_forwards = 0;
       try {
@@ -318,8 +401,8 @@ int HTTPMessage::processMaxForwards() {
       } else if (max_forwards == 0) {
         return 501;
       } else {
-        headers_.set(HTTP_HEADER_MAX_FORWARDS,
-                     folly::to<string>(max_forwards - 1));
+        mutableHeaders().set(HTTP_HEADER_MAX_FORWARDS,
+                             folly::to<string>(max_forwards - 1));
       }
     }
   }
@@ -335,24 +418,46 @@ bool HTTPMessage::isHTTP1_1() const {
 }
 
 namespace {
-struct FormattedDate {
-  time_t lastTime{0};
+// The formatted Date header is cached process-wide: the first caller in
+// each second renders it and publishes it through an atomic_shared_ptr,
+// and every other thread picks up the shared copy with a wait-free load.
+// Each thread additionally keeps the shared_ptr it last saw so the common
+// path (many responses within one second) touches only thread-local state.
+struct CachedDate {
+  time_t second{0};
   string date;
+};
+
+folly::atomic_shared_ptr<const CachedDate>& sharedDate() {
+  static folly::Indestructible<folly::atomic_shared_ptr<const CachedDate>>
+      cache;
+  return *cache;
+}
+
+struct FormattedDate {
+  std::shared_ptr<const CachedDate> local;
 
   string formatDate() {
     const auto now =
         std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
 
-    if (now != lastTime) {
+    if (local && local->second == now) {
+      return local->date;
+    }
+    local = sharedDate().load(std::memory_order_acquire);
+    if (!local || local->second != now) {
       char buff[1024];
       tm timeTupple;
       gmtime_r(&now, &timeTupple);
 
       strftime(buff, 1024, "%a, %d %b %Y %H:%M:%S %Z", &timeTupple);
-      date = std::string(buff);
-      lastTime = now;
+      auto fresh = std::make_shared<const CachedDate>(
+          CachedDate{now, std::string(buff)});
+      // Threads racing here publish equivalent strings; last writer wins
+      sharedDate().store(fresh, std::memory_order_release);
+      local = std::move(fresh);
     }
-    return date;
+    return local->date;
   }
 };
 } // namespace
@@ -363,9 +468,31 @@ string HTTPMessage::formatDateHeader() {
   return obj.formatDate();
 }
 
+std::unique_ptr<folly::IOBuf> HTTPMessage::serializeHeaderBlock(
+    const HTTPHeaders& headers) {
+  size_t blockLen = 0;
+  headers.forEach([&blockLen](const string& name, const string& value) {
+    blockLen += name.length() + value.length() + 4; // 4 for ": " + CRLF
+  });
+  auto block = folly::IOBuf::create(blockLen);
+  char* dst = reinterpret_cast<char*>(block->writableTail());
+  headers.forEach([&dst](const string& name, const string& value) {
+    memcpy(dst, name.data(), name.length());
+    dst += name.length();
+    *dst++ = ':';
+    *dst++ = ' ';
+    memcpy(dst, value.data(), value.length());
+    dst += value.length();
+    *dst++ = '\r';
+    *dst++ = '\n';
+  });
+  block->append(blockLen);
+  return block;
+}
+
 void HTTPMessage::ensureHostHeader() {
-  if (!headers_.exists(HTTP_HEADER_HOST)) {
-    headers_.add(HTTP_HEADER_HOST,
+  if (!cheaders().exists(HTTP_HEADER_HOST)) {
+    mutableHeaders().add(HTTP_HEADER_HOST,
                  getDstAddress().getFamily() == AF_INET6
                      ? '[' + getDstIP() + ']'
                      : getDstIP());
@@ -406,10 +533,11 @@ void HTTPMessage::constructDirectResponse(const pair<uint8_t, uint8_t>& version,
                                           int contentLength) {
   setHTTPVersion(version.first, version.second);
 
-  headers_.set(HTTP_HEADER_CONTENT_LENGTH, folly::to<string>(contentLength));
+  auto& headers = mutableHeaders();
+  headers.set(HTTP_HEADER_CONTENT_LENGTH, folly::to<string>(contentLength));
 
-  if (!headers_.exists(HTTP_HEADER_CONTENT_TYPE)) {
-    headers_.add(HTTP_HEADER_CONTENT_TYPE, "text/plain");
+  if (!headers.exists(HTTP_HEADER_CONTENT_TYPE)) {
+    headers.add(HTTP_HEADER_CONTENT_TYPE, "text/plain");
   }
   setIsChunked(false);
   setIsUpgraded(false);
@@ -419,7 +547,7 @@ void HTTPMessage::parseCookies() const {
   DCHECK(!parsedCookies_);
   parsedCookies_ = true;
 
-  headers_.forEachValueOfHeader(
+  cheaders().forEachValueOfHeader(
       HTTP_HEADER_COOKIE, [&](const string& headerval) {
         splitNameValuePieces(
             headerval,
@@ -436,6 +564,49 @@ void HTTPMessage::parseCookies() const {
 void HTTPMessage::unparseCookies() const {
   cookies_.clear();
   parsedCookies_ = false;
+  cookieIndex_.clear();
+  parsedCookieIndex_ = false;
+}
+
+void HTTPMessage::parseCookieIndex() const {
+  DCHECK(!parsedCookieIndex_);
+  parsedCookieIndex_ = true;
+
+  cheaders().forEachValueOfHeader(
+      HTTP_HEADER_COOKIE, [&](const string& headerval) {
+        splitNameValuePieces(headerval,
+                             ';',
+                             '=',
+                             [this](StringPiece name, StringPiece value) {
+                               cookieIndex_.emplace_back(name, value);
+                             });
+
+        return false; // continue processing "cookie" headers
+      });
+  // A stable sort keeps duplicates in header order, so lookups that take
+  // the first equal entry match getCookie()'s map-insertion behavior
+  std::stable_sort(cookieIndex_.begin(),
+                   cookieIndex_.end(),
+                   [](const auto& a, const auto& b) { return a.first < b.first; });
+}
+
+const HTTPMessage::CookieIndex& HTTPMessage::getCookieIndex() const {
+  if (!parsedCookieIndex_) {
+    parseCookieIndex();
+  }
+  return cookieIndex_;
+}
+
+StringPiece HTTPMessage::getCookieFast(StringPiece name) const {
+  const auto& index = getCookieIndex();
+  auto it = std::lower_bound(
+      index.begin(), index.end(), name, [](const auto& entry, StringPiece key) {
+        return entry.first < key;
+      });
+  if (it == index.end() || it->first != name) {
+    return StringPiece();
+  }
+  return it->second;
 }
 
 const StringPiece HTTPMessage::getCookie(const string& name) const {
@@ -482,6 +653,45 @@ void HTTPMessage::parseQueryParams() const {
 void HTTPMessage::unparseQueryParams() {
   queryParams_.clear();
   parsedQueryParams_ = false;
+  queryParamIndex_.clear();
+  parsedQueryParamIndex_ = false;
+}
+
+void HTTPMessage::parseQueryParamIndex() const {
+  DCHECK(!parsedQueryParamIndex_);
+  const Request& req = request();
+
+  parsedQueryParamIndex_ = true;
+  if (req.query_.empty()) {
+    return;
+  }
+
+  splitNameValuePieces(
+      req.query_, '&', '=', [this](StringPiece name, StringPiece value) {
+        queryParamIndex_.emplace_back(name, value);
+      });
+  // A stable sort keeps duplicates in query-string order, so lookups that
+  // take the last equal entry keep getQueryParam()'s last-wins behavior
+  std::stable_sort(queryParamIndex_.begin(),
+                   queryParamIndex_.end(),
+                   [](const auto& a, const auto& b) { return a.first < b.first; });
+}
+
+StringPiece HTTPMessage::getQueryParamNoCopy(StringPiece name) const {
+  // Build the flat index if we haven't done so yet
+  if (!parsedQueryParamIndex_) {
+    parseQueryParamIndex();
+  }
+
+  auto it = std::upper_bound(
+      queryParamIndex_.begin(),
+      queryParamIndex_.end(),
+      name,
+      [](StringPiece key, const auto& entry) { return key < entry.first; });
+  if (it == queryParamIndex_.begin() || (--it)->first != name) {
+    return StringPiece();
+  }
+  return it->second;
 }
 
 const string* HTTPMessage::getQueryParamPtr(const string& name) const {
@@ -523,10 +733,8 @@ std::string HTTPMessage::getDecodedQueryParam(const std::string& name) const {
   auto val = getQueryParam(name);
 
   std::string result;
-  try {
-    folly::uriUnescape(val, result, folly::UriEscapeMode::QUERY);
-  } catch (const std::exception& ex) {
-    LOG(WARNING) << "Invalid escaped query param: " << folly::exceptionStr(ex);
+  if (!CodecUtil::unescapeQuery(val, result)) {
+    LOG(WARNING) << "Invalid escaped query param";
   }
   return result;
 }
@@ -631,29 +839,30 @@ void HTTPMessage::splitNameValuePieces(
     std::function<void(StringPiece, StringPiece)> callback) {
 
   while (!sp.empty()) {
-    size_t pairDelimPos = sp.find(pairDelim);
-    StringPiece keyValue;
-
-    if (pairDelimPos == string::npos) {
-      keyValue = sp;
-      sp.advance(sp.size());
-    } else {
-      keyValue = sp.subpiece(0, pairDelimPos);
-      // Skip '&' char
-      sp.advance(pairDelimPos + 1);
-    }
-
-    if (keyValue.empty()) {
-      continue;
-    }
-
-    size_t valueDelimPos = keyValue.find(valueDelim);
-    if (valueDelimPos == string::npos) {
+    // One vectorized pass finds whichever delimiter comes first
+    size_t delimPos =
+        CodecUtil::findFirstOf(folly::ByteRange(sp), pairDelim, valueDelim);
+    if (delimPos == sp.size() || sp[delimPos] == pairDelim) {
       // Key only query param
+      StringPiece keyValue = sp.subpiece(0, delimPos);
+      sp.advance(std::min(delimPos + 1, sp.size()));
+      if (keyValue.empty()) {
+        continue;
+      }
       callback(trim(keyValue), StringPiece());
     } else {
-      auto name = keyValue.subpiece(0, valueDelimPos);
-      auto value = keyValue.subpiece(valueDelimPos + 1);
+      auto name = sp.subpiece(0, delimPos);
+      sp.advance(delimPos + 1);
+      size_t pairDelimPos = sp.find(pairDelim);
+      StringPiece value;
+      if (pairDelimPos == string::npos) {
+        value = sp;
+        sp.advance(sp.size());
+      } else {
+        value = sp.subpiece(0, pairDelimPos);
+        // Skip '&' char
+        sp.advance(pairDelimPos + 1);
+      }
       callback(trim(name), trim(value));
     }
   }
@@ -676,33 +885,34 @@ void HTTPMessage::splitNameValue(
 
   folly::StringPiece sp(input);
   while (!sp.empty()) {
-    size_t pairDelimPos = sp.find(pairDelim);
-    folly::StringPiece keyValue;
-
-    if (pairDelimPos == string::npos) {
-      keyValue = sp;
-      sp.advance(sp.size());
-    } else {
-      keyValue = sp.subpiece(0, pairDelimPos);
-      // Skip '&' char
-      sp.advance(pairDelimPos + 1);
-    }
-
-    if (keyValue.empty()) {
-      continue;
-    }
-
-    size_t valueDelimPos = keyValue.find(valueDelim);
-    if (valueDelimPos == string::npos) {
+    // One vectorized pass finds whichever delimiter comes first
+    size_t delimPos =
+        CodecUtil::findFirstOf(folly::ByteRange(sp), pairDelim, valueDelim);
+    if (delimPos == sp.size() || sp[delimPos] == pairDelim) {
       // Key only query param
+      folly::StringPiece keyValue = sp.subpiece(0, delimPos);
+      sp.advance(std::min(delimPos + 1, sp.size()));
+      if (keyValue.empty()) {
+        continue;
+      }
       string name = keyValue.str();
       string value;
 
       boost::trim(name, defaultLocale);
       callback(std::move(name), std::move(value));
     } else {
-      string name = keyValue.subpiece(0, valueDelimPos).str();
-      string value = keyValue.subpiece(valueDelimPos + 1).str();
+      string name = sp.subpiece(0, delimPos).str();
+      sp.advance(delimPos + 1);
+      size_t pairDelimPos = sp.find(pairDelim);
+      string value;
+      if (pairDelimPos == string::npos) {
+        value = sp.str();
+        sp.advance(sp.size());
+      } else {
+        value = sp.subpiece(0, pairDelimPos).str();
+        // Skip '&' char
+        sp.advance(pairDelimPos + 1);
+      }
 
       boost::trim(name, defaultLocale);
       boost::trim(value, defaultLocale);
@@ -766,7 +976,7 @@ void HTTPMessage::describe(std::ostream& os) const {
   // This little loop prints the headers and (if present) any per-hop headers
   // that were stripped.  It executes at most twice.
   bool first = true;
-  const HTTPHeaders* hdrs = &headers_;
+  const HTTPHeaders* hdrs = &cheaders();
   while (hdrs) {
     if (!first && hdrs->size() != 0) {
       os << "Per-Hop Headers" << std::endl;
@@ -839,7 +1049,7 @@ bool HTTPMessage::computeKeepalive() const {
 bool HTTPMessage::checkForHeaderToken(const HTTPHeaderCode headerCode,
                                       char const* token,
                                       bool caseSensitive) const {
-  return doHeaderTokenCheck(headers_, headerCode, token, caseSensitive);
+  return doHeaderTokenCheck(cheaders(), headerCode, token, caseSensitive);
 }
 
 bool HTTPMessage::doHeaderTokenCheck(const HTTPHeaders& headers,
@@ -968,6 +1178,10 @@ ParseURL HTTPMessage::setURLImplInternal(bool unparse) {
   }
   req.pathStr_.reset();
   req.queryStr_.reset();
+  // The flat index points into the old url_, so it must go even when the
+  // owned-string params survive (unparse == false)
+  queryParamIndex_.clear();
+  parsedQueryParamIndex_ = false;
   if (unparse) {
     unparseQueryParams();
   }
@@ -975,12 +1189,12 @@ ParseURL HTTPMessage::setURLImplInternal(bool unparse) {
 }
 
 void HTTPMessage::setHTTPPriority(uint8_t urgency, bool incremental) {
-  headers_.set(HTTP_HEADER_PRIORITY,
-               httpPriorityToString(urgency, incremental));
+  mutableHeaders().set(HTTP_HEADER_PRIORITY,
+                       httpPriorityToString(urgency, incremental));
 }
 
 void HTTPMessage::setHTTPPriority(HTTPPriority httpPriority) {
-  headers_.set(
+  mutableHeaders().set(
       HTTP_HEADER_PRIORITY,
       httpPriorityToString(httpPriority.urgency, httpPriority.incremental));
 }
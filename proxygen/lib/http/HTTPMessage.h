@@ -14,6 +14,7 @@
 #include <folly/Optional.h>
 #include <folly/SocketAddress.h>
 #include <folly/io/IOBufQueue.h>
+#include <folly/small_vector.h>
 #include <glog/logging.h>
 #include <map>
 #include <mutex>
@@ -84,6 +85,26 @@ class HTTPMessage {
   HTTPMessage& operator=(const HTTPMessage& message);
   HTTPMessage& operator=(HTTPMessage&& message);
 
+  /**
+   * Return a copy of this message that shares its header block instead of
+   * copying every name/value string.  The block becomes logically immutable:
+   * the first mutable getHeaders() (or extractHeaders()) call on either
+   * message materializes a private copy for that message, so callers never
+   * observe shared mutation.  Intended for flows that duplicate a message
+   * wholesale, e.g. traffic mirroring and server push.  Non-const because
+   * this message's headers move into the shared block.
+   */
+  HTTPMessage cloneShallow();
+
+  /**
+   * An HTTPMessage is heap-allocated for every transaction, so same-size
+   * blocks are recycled through a small thread-local free list instead of
+   * going back to malloc.  The sized delete only recycles exact
+   * sizeof(HTTPMessage) blocks, so the (unusual) derived class still works.
+   */
+  static void* operator new(size_t size);
+  static void operator delete(void* ptr, size_t size);
+
   // upgradeWebsocket_ can have three states, WebSocketUpgrade::NONE by
   // default. WebSocketUpgrade::INGRESS is used by the codec to indicate a
   // websocket upgrade request was received from downstream or a successful
@@ -348,17 +369,17 @@ class HTTPMessage {
    * Access the headers (fpreq, fpres)
    */
   HTTPHeaders& getHeaders() {
-    return headers_;
+    return mutableHeaders();
   }
   const HTTPHeaders& getHeaders() const {
-    return headers_;
+    return cheaders();
   }
 
   /**
    * Move headers out of current message (returns rvalue ref)
    */
   HTTPHeaders&& extractHeaders() {
-    return std::move(headers_);
+    return std::move(mutableHeaders());
   }
 
   /**
@@ -385,6 +406,34 @@ class HTTPMessage {
     return std::move(trailers_);
   }
 
+  /**
+   * Attach a pre-serialized HTTP/1.x header block to this message.  The
+   * buffer must contain complete "Name: value\r\n" lines; HTTP1xCodec
+   * splices it verbatim into the egress message ahead of the headers in
+   * getHeaders().  Because the block bypasses the codec's per-header
+   * processing, it must not contain headers with connection-level
+   * semantics (Connection, Content-Length, Transfer-Encoding, Date,
+   * Upgrade, Proxy-Connection) -- keep those in getHeaders() so the codec
+   * can still rewrite them.  Handlers that send near-identical responses
+   * can render the invariant headers once with serializeHeaderBlock() and
+   * share the buffer across messages.  Only HTTP/1.x egress consults this;
+   * other codecs ignore it.
+   */
+  void setPreSerializedHeaders(std::shared_ptr<folly::IOBuf> headerBlock) {
+    preSerializedHeaders_ = std::move(headerBlock);
+  }
+
+  const std::shared_ptr<folly::IOBuf>& getPreSerializedHeaders() const {
+    return preSerializedHeaders_;
+  }
+
+  /**
+   * Render the given headers as "Name: value\r\n" lines into a single
+   * contiguous buffer, suitable for setPreSerializedHeaders().
+   */
+  static std::unique_ptr<folly::IOBuf> serializeHeaderBlock(
+      const HTTPHeaders& headers);
+
   /**
    * Decrements Max-Forwards header, when present on OPTIONS or TRACE methods.
    *
@@ -560,6 +609,20 @@ class HTTPMessage {
    */
   std::string getDecodedQueryParam(const std::string& name) const;
 
+  /**
+   * Get the query parameter with the specified name without materializing
+   * any strings.
+   *
+   * On first access the query string is split into a flat sorted index of
+   * StringPiece pairs over the stored URL, so callers that read a single
+   * parameter per request pay one binary search and no allocations.
+   * Duplicate names resolve to the last occurrence, same as
+   * getQueryParam().  Returns an empty piece when the parameter is absent;
+   * the result points into this message's URL and is invalidated by
+   * setURL()/setQueryString()/setQueryParam().
+   */
+  folly::StringPiece getQueryParamNoCopy(folly::StringPiece name) const;
+
   /**
    * Get all the query parameters.
    *
@@ -601,6 +664,29 @@ class HTTPMessage {
    */
   const folly::StringPiece getCookie(const std::string& name) const;
 
+  /**
+   * Indexed counterpart of getCookie().  The first access builds a flat
+   * array of (name, value) pieces over the original Cookie header
+   * storage, sorted by name and cached on the message; lookups are
+   * binary searches with no re-parse and no allocation.  Returns an
+   * empty StringPiece if there is no cookie with the specified name.
+   *
+   * Like getCookie(), the returned pieces are only valid while the
+   * Cookie header is unchanged; callers must call unparseCookies()
+   * after editing it.
+   */
+  folly::StringPiece getCookieFast(folly::StringPiece name) const;
+
+  using CookieIndex =
+      folly::small_vector<std::pair<folly::StringPiece, folly::StringPiece>, 8>;
+
+  /**
+   * The flat cookie index behind getCookieFast(), in name order, built
+   * on first access.  Allows zero-copy iteration over all cookies, e.g.
+   * for forwarding filters.  Same validity rules as getCookieFast().
+   */
+  const CookieIndex& getCookieIndex() const;
+
   /**
    * Print the message out.
    */
@@ -843,6 +929,7 @@ class HTTPMessage {
 
  private:
   void parseCookies() const;
+  void parseCookieIndex() const;
 
   template <typename T> // T = string
   ParseURL setURLImpl(T&& url, bool unparse) {
@@ -857,6 +944,7 @@ class HTTPMessage {
 
   bool setQueryStringImpl(const std::string& queryString, bool unparse);
   void parseQueryParams() const;
+  void parseQueryParamIndex() const;
   void unparseQueryParams();
 
   bool doHeaderTokenCheck(const HTTPHeaders& headers_,
@@ -1049,14 +1137,52 @@ class HTTPMessage {
    * getQueryParam()
    */
   mutable std::map<folly::StringPiece, folly::StringPiece> cookies_;
+  // Flat (name, value) index over the Cookie header(s), sorted by name
+  // and built lazily by getCookieFast()/getCookieIndex().  The pieces
+  // point into this message's header storage, so the index is never
+  // copied or moved between messages; it is simply rebuilt on first
+  // access
+  mutable CookieIndex cookieIndex_;
   // TODO: use StringPiece for queryParams_ and delete splitNameValue()
   mutable std::map<std::string, std::string> queryParams_;
+  // Flat (name, value) index over request().query_, sorted by name and
+  // built lazily by getQueryParamNoCopy().  The pieces point into this
+  // message's url_, so the index is never copied or moved between
+  // messages; it is simply rebuilt on first access
+  mutable folly::
+      small_vector<std::pair<folly::StringPiece, folly::StringPiece>, 8>
+          queryParamIndex_;
+
+  /**
+   * Read-only view of the headers.  Returns the shared block when this
+   * message was produced by (or turned into a source of) cloneShallow(),
+   * otherwise the private headers_.
+   */
+  const HTTPHeaders& cheaders() const {
+    return sharedHeaders_ ? *sharedHeaders_ : headers_;
+  }
+
+  /**
+   * Writable headers.  If this message is currently sharing its header
+   * block, detach by copying it into headers_ first (copy-on-write).
+   */
+  HTTPHeaders& mutableHeaders() {
+    if (sharedHeaders_) {
+      headers_ = *sharedHeaders_;
+      sharedHeaders_.reset();
+    }
+    return headers_;
+  }
 
   HTTPHeaders headers_;
+  // When set, headers_ is empty and the message reads its headers from this
+  // immutable shared block.  See cloneShallow()
+  std::shared_ptr<const HTTPHeaders> sharedHeaders_;
   std::unique_ptr<HTTPHeaders> strippedPerHopHeaders_;
   HTTPHeaderSize size_;
   WebSocketUpgrade upgradeWebsocket_;
   std::unique_ptr<HTTPHeaders> trailers_;
+  std::shared_ptr<folly::IOBuf> preSerializedHeaders_;
 
   int32_t seqNo_;
   int sslVersion_;
@@ -1068,7 +1194,9 @@ class HTTPMessage {
 
   std::pair<uint8_t, uint8_t> version_;
   mutable bool parsedCookies_ : 1;
+  mutable bool parsedCookieIndex_ : 1;
   mutable bool parsedQueryParams_ : 1;
+  mutable bool parsedQueryParamIndex_ : 1;
   bool chunked_ : 1;
   bool upgraded_ : 1;
   bool wantsKeepalive_ : 1;
@@ -30,44 +30,27 @@ folly::Optional<HTTPPriority> httpPriorityFromString(
       LOG(ERROR) << "Received ill-formated priority header=" << priority;
     }
   };
+  // A known-shape dictionary ("u=3, i"), decoded without building a map
   StructuredHeadersDecoder decoder(priority);
-  StructuredHeaders::Dictionary dict;
-  auto ret = decoder.decodeDictionary(dict);
-  if (ret != StructuredHeaders::DecodeError::OK) {
+  StructuredHeadersDecoder::DictionaryField fields[2] = {
+      {"u", StructuredHeaderItem::Type::INT64, {}, false},
+      {"i", StructuredHeaderItem::Type::BOOLEAN, {}, false}};
+  auto& urgencyField = fields[0];
+  auto& incrementalField = fields[1];
+  size_t numUnknownKeys = 0;
+  auto ret = decoder.decodeKnownDictionary({fields, 2}, &numUnknownKeys);
+  if (ret != StructuredHeaders::DecodeError::OK || numUnknownKeys > 0 ||
+      !urgencyField.present) {
     logBadHeader = true;
     return folly::none;
   }
-  if (dict.size() > 2) {
-    logBadHeader = true;
-    return folly::none;
-  }
-  bool hasUrgency = dict.find("u") != dict.end();
-  bool hasIncremental = dict.find("i") != dict.end();
-  if (dict.size() == 2 && !(hasUrgency && hasIncremental)) {
-    logBadHeader = true;
-    return folly::none;
-  }
-  if (dict.size() == 1 && !hasUrgency) {
-    logBadHeader = true;
-    return folly::none;
-  }
-  if (!hasUrgency || dict["u"].tag != StructuredHeaderItem::Type::INT64) {
-    logBadHeader = true;
-    return folly::none;
-  }
-  folly::tryTo<uint8_t>(dict["u"].get<int64_t>()).then([&](uint8_t urgency) {
-    if (urgency > kMaxPriority) {
-      logBadHeader = true;
-    }
-    bool incremental = false;
-    if (hasIncremental) {
-      if (dict["i"].tag != StructuredHeaderItem::Type::BOOLEAN) {
-        logBadHeader = true;
-      }
-      incremental = true;
-    }
-    httpPriority.emplace(urgency, incremental);
-  });
+  folly::tryTo<uint8_t>(urgencyField.value.get<int64_t>())
+      .then([&](uint8_t urgency) {
+        if (urgency > kMaxPriority) {
+          logBadHeader = true;
+        }
+        httpPriority.emplace(urgency, incrementalField.present);
+      });
   return httpPriority;
 }
 
@@ -15,6 +15,14 @@ namespace {
 constexpr folly::StringPiece kProxyParam{"e_proxy"};
 constexpr folly::StringPiece kUpstreamIPParam{"e_upip"};
 
+// proxy-status is emitted on every response; reuse one encoder (and its
+// string buffer) per thread instead of constructing one per call
+proxygen::StructuredHeadersEncoder& getPooledEncoder() {
+  static thread_local proxygen::StructuredHeadersEncoder encoder;
+  encoder.clear();
+  return encoder;
+}
+
 } // namespace
 
 namespace proxygen {
@@ -43,8 +51,28 @@ ProxyStatus& ProxyStatus::setProxyStatusParameter(folly::StringPiece name,
   return *this;
 }
 
+ProxyStatus& ProxyStatus::setPresetProxyStatusParameter(
+    folly::StringPiece name, const std::string& text) {
+  if (text.empty()) {
+    return *this;
+  }
+
+  StructuredHeaders::Dictionary entry;
+  entry.emplace(name.str(),
+                StructuredHeaderItem(StructuredHeaderItem::Type::STRING, text));
+  auto& encoder = getPooledEncoder();
+  if (encoder.encodeDictionary(entry) == EncodeError::OK) {
+    presetParams_ += "; ";
+    presetParams_ += encoder.get();
+  } else {
+    encoder.clear();
+  }
+  return *this;
+}
+
 ProxyStatus& ProxyStatus::setProxy(const std::string& proxy) {
-  return setProxyStatusParameter(kProxyParam, proxy);
+  // The proxy name is fixed at startup; intern its serialized form
+  return setPresetProxyStatusParameter(kProxyParam, proxy);
 }
 
 ProxyStatus& ProxyStatus::setUpstreamIP(const std::string& upstreamIP) {
@@ -58,11 +86,17 @@ bool ProxyStatus::hasUpstreamIP() const {
 
 std::string ProxyStatus::toString() const {
   StructuredHeaders::ParameterisedList plist;
-  StructuredHeadersEncoder encoder;
+  auto& encoder = getPooledEncoder();
   plist.emplace_back(std::move(pIdent_));
   encoder.encodeParameterisedList(plist);
 
-  return encoder.get();
+  auto result = encoder.get();
+  if (!result.empty()) {
+    // Preset parameters were serialized when they were registered;
+    // only the variable parameters went through the encoder above
+    result += presetParams_;
+  }
+  return result;
 }
 
 bool ProxyStatus::isEmpty() const {
@@ -42,6 +42,13 @@ class ProxyStatus {
   virtual ProxyStatus& setProxyStatusParameter(folly::StringPiece name,
                                                const std::string& text);
 
+  // Serializes the parameter once and appends the cached fragment to
+  // every subsequent toString().  Intended for parameters that are fixed
+  // at startup (e.g. the proxy name); preset parameters are not visible
+  // through the parameter map and cannot be overwritten.
+  ProxyStatus& setPresetProxyStatusParameter(folly::StringPiece name,
+                                             const std::string& text);
+
   // Serialize ProxyStatus to std::string
   // e.g. proxy-status: destination_unavailable; \
   // e_proxy="devbig623.prn2"; e_upip="fe:de:fa:ce:fe:de:fa:ce"
@@ -53,6 +60,8 @@ class ProxyStatus {
  protected:
   StructuredHeaders::ParameterisedIdentifier pIdent_;
   StatusType statusType_;
+  // Pre-serialized "; name=value" fragments for preset parameters
+  std::string presetParams_;
 };
 
 } // namespace proxygen
@@ -8,8 +8,10 @@
 
 #include <proxygen/lib/http/RFC2616.h>
 
+#include <algorithm>
 #include <stdlib.h>
 
+#include <folly/Conv.h>
 #include <folly/String.h>
 #include <folly/ThreadLocal.h>
 #include <proxygen/lib/http/HTTPHeaders.h>
@@ -165,6 +167,76 @@ bool parseByteRangeSpec(folly::StringPiece value,
   return true;
 }
 
+bool parseRangeRequest(folly::StringPiece value,
+                       uint64_t instanceLength,
+                       std::vector<ByteRange>& output) {
+  output.clear();
+  // The unit is case-insensitive per RFC 7233, but "bytes" is the only one
+  // registered and senders emit it lowercase in practice
+  if (!value.startsWith("bytes=")) {
+    return false;
+  }
+  value.advance(6 /* strlen("bytes=") */);
+
+  std::vector<folly::StringPiece> specs;
+  folly::split(',', value, specs);
+  if (specs.empty()) {
+    return false;
+  }
+  for (auto spec : specs) {
+    spec = folly::trimWhitespace(spec);
+    auto dash = spec.find('-');
+    if (dash == std::string::npos) {
+      return false;
+    }
+    auto firstStr = spec.subpiece(0, dash);
+    auto lastStr = spec.subpiece(dash + 1);
+    uint64_t first = 0;
+    uint64_t last = 0;
+    if (firstStr.empty()) {
+      // suffix-byte-range-spec: the final N bytes of the instance
+      auto suffix = folly::tryTo<uint64_t>(lastStr);
+      if (!suffix.hasValue()) {
+        return false;
+      }
+      if (*suffix == 0 || instanceLength == 0) {
+        // well formed but unsatisfiable
+        continue;
+      }
+      first = *suffix >= instanceLength ? 0 : instanceLength - *suffix;
+      last = instanceLength - 1;
+    } else {
+      auto parsedFirst = folly::tryTo<uint64_t>(firstStr);
+      if (!parsedFirst.hasValue()) {
+        return false;
+      }
+      first = *parsedFirst;
+      if (lastStr.empty()) {
+        // open-ended range: everything from first to the end
+        if (first >= instanceLength) {
+          continue;
+        }
+        last = instanceLength - 1;
+      } else {
+        auto parsedLast = folly::tryTo<uint64_t>(lastStr);
+        if (!parsedLast.hasValue()) {
+          return false;
+        }
+        last = *parsedLast;
+        if (first > last) {
+          return false;
+        }
+        if (first >= instanceLength) {
+          continue;
+        }
+        last = std::min(last, instanceLength - 1);
+      }
+    }
+    output.emplace_back(first, last);
+  }
+  return true;
+}
+
 EncodingList parseEncoding(const folly::StringPiece header) {
   EncodingList result;
   std::vector<folly::StringPiece> topLevelTokens;
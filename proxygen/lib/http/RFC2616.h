@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include <cstdint>
+#include <utility>
 #include <vector>
 
 #if !FOLLY_MOBILE
@@ -128,5 +130,23 @@ bool parseByteRangeSpec(folly::StringPiece value,
                         unsigned long& lastByte,
                         unsigned long& instanceLength);
 
+/**
+ * Parse an RFC 7233 "Range" request header value ("bytes=0-99, -500") into
+ * byte ranges resolved against the given instance length: suffix ranges
+ * ("-N") and open-ended ranges ("N-") are converted to explicit first/last
+ * byte pairs (both inclusive), and last bytes beyond the instance are
+ * clamped to it.
+ *
+ * Returns false if the value is syntactically invalid or uses a unit other
+ * than "bytes"; such a header should be ignored and the full instance
+ * served.  Returns true with an empty output when the header is well
+ * formed but no range overlaps the instance, which calls for a 416.
+ */
+using ByteRange = std::pair<uint64_t, uint64_t>;
+
+bool parseRangeRequest(folly::StringPiece value,
+                       uint64_t instanceLength,
+                       std::vector<ByteRange>& output);
+
 } // namespace RFC2616
 } // namespace proxygen
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/http/ShardedLruQuicPskCache.h>
+
+#include <folly/hash/Hash.h>
+
+namespace proxygen {
+
+ShardedLruQuicPskCache::ShardedLruQuicPskCache(size_t numShards,
+                                               uint64_t perShardMax) {
+  CHECK_GT(numShards, 0u);
+  shards_.reserve(numShards);
+  for (size_t i = 0; i < numShards; i++) {
+    shards_.emplace_back(std::make_unique<Shard>(perShardMax));
+  }
+}
+
+folly::Synchronized<ShardedLruQuicPskCache::EvictingPskMap>&
+ShardedLruQuicPskCache::shard(size_t hash) {
+  return shards_[hash % shards_.size()]->map;
+}
+
+folly::atomic_shared_ptr<ShardedLruQuicPskCache::HotEntry>&
+ShardedLruQuicPskCache::hotSlot(size_t hash) {
+  // Remix so the slot index does not correlate with the shard index when
+  // kHotEntrySlots and the shard count share factors.
+  return hotEntries_[folly::hash::twang_mix64(hash) % kHotEntrySlots];
+}
+
+void ShardedLruQuicPskCache::publishHotEntry(const std::string& identity,
+                                             const quic::QuicCachedPsk& psk) {
+  hotSlot(std::hash<std::string>()(identity))
+      .store(std::make_shared<HotEntry>(HotEntry{identity, psk}));
+}
+
+void ShardedLruQuicPskCache::retireHotEntry(const std::string& identity) {
+  auto& slot = hotSlot(std::hash<std::string>()(identity));
+  auto hot = slot.load(std::memory_order_acquire);
+  if (hot && hot->identity == identity) {
+    // A concurrent publish for another identity losing this CAS is fine;
+    // the slot then holds that newer entry.
+    slot.compare_exchange_strong(hot, nullptr);
+  }
+}
+
+folly::Optional<quic::QuicCachedPsk> ShardedLruQuicPskCache::getPsk(
+    const std::string& identity) {
+  const auto hash = std::hash<std::string>()(identity);
+  auto hot = hotSlot(hash).load(std::memory_order_acquire);
+  if (hot && hot->identity == identity) {
+    if (std::chrono::system_clock::now() <=
+        hot->psk.cachedPsk.ticketExpirationTime) {
+      return hot->psk;
+    }
+    // Expired; fall through so the shard erases it below
+  }
+
+  auto cacheMap = shard(hash).wlock();
+  auto result = cacheMap->find(identity);
+  if (result != cacheMap->end()) {
+    if (std::chrono::system_clock::now() >
+        result->second.cachedPsk.ticketExpirationTime) {
+      VLOG(1) << "PSK expired: " << identity << ", id: "
+              << (result->second.cachedPsk.serverCert
+                      ? result->second.cachedPsk.serverCert->getIdentity()
+                      : "none");
+      cacheMap->erase(result);
+      cacheMap.unlock();
+      retireHotEntry(identity);
+      return folly::none;
+    }
+    publishHotEntry(identity, result->second);
+    return result->second;
+  } else {
+    return folly::none;
+  }
+}
+
+void ShardedLruQuicPskCache::putPsk(const std::string& identity,
+                                    quic::QuicCachedPsk psk) {
+  const auto hash = std::hash<std::string>()(identity);
+  publishHotEntry(identity, psk);
+  auto cacheMap = shard(hash).wlock();
+  cacheMap->set(identity, std::move(psk));
+}
+
+void ShardedLruQuicPskCache::removePsk(const std::string& identity) {
+  const auto hash = std::hash<std::string>()(identity);
+  {
+    auto cacheMap = shard(hash).wlock();
+    cacheMap->erase(identity);
+  }
+  retireHotEntry(identity);
+}
+
+} // namespace proxygen
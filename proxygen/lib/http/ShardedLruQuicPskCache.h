@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/concurrency/AtomicSharedPtr.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <quic/fizz/client/handshake/QuicPskCache.h>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace proxygen {
+
+/**
+ * A sharded alternative to SynchronizedLruQuicPskCache.  PSKs are
+ * distributed over N independent LRU maps keyed by a hash of the server
+ * identity, each behind its own lock, so 0-RTT lookups from different IO
+ * threads only contend when they hash to the same shard.  On top of the
+ * shards sits a small lock-free hot-entry array: the most recently
+ * fetched or stored PSK per slot is published through an
+ * atomic_shared_ptr and can be read without taking any shard lock.  Hot
+ * hits do not promote the entry in the shard LRU; the promotion happens
+ * on the next miss of the hot slot, which is a fine trade for reconnect
+ * storms where the same identities are fetched over and over.
+ */
+class ShardedLruQuicPskCache : public quic::QuicPskCache {
+ public:
+  ~ShardedLruQuicPskCache() override = default;
+
+  ShardedLruQuicPskCache(size_t numShards, uint64_t perShardMax);
+
+  folly::Optional<quic::QuicCachedPsk> getPsk(
+      const std::string& identity) override;
+
+  void putPsk(const std::string& identity, quic::QuicCachedPsk psk) override;
+
+  void removePsk(const std::string& identity) override;
+
+ private:
+  using EvictingPskMap =
+      folly::EvictingCacheMap<std::string, quic::QuicCachedPsk>;
+
+  struct Shard {
+    explicit Shard(uint64_t mapMax) : map(EvictingPskMap(mapMax)) {
+    }
+    folly::Synchronized<EvictingPskMap> map;
+  };
+
+  struct HotEntry {
+    std::string identity;
+    quic::QuicCachedPsk psk;
+  };
+
+  folly::Synchronized<EvictingPskMap>& shard(size_t hash);
+  folly::atomic_shared_ptr<HotEntry>& hotSlot(size_t hash);
+  void publishHotEntry(const std::string& identity,
+                       const quic::QuicCachedPsk& psk);
+  void retireHotEntry(const std::string& identity);
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  static constexpr size_t kHotEntrySlots = 64;
+  std::array<folly::atomic_shared_ptr<HotEntry>, kHotEntrySlots> hotEntries_;
+};
+
+} // namespace proxygen
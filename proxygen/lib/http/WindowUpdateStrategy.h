@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include <proxygen/lib/http/Window.h>
+
+namespace proxygen {
+
+/**
+ * Policy for when bytes freed from a receive Window are advertised back
+ * to the peer via WINDOW_UPDATE.  The Window itself is pure arithmetic;
+ * a strategy decides which freed bytes are eligible for an update and
+ * when enough are pending to be worth a frame.
+ *
+ * Eagerly releasing window as bytes arrive lets a sender keep our
+ * buffers full regardless of how fast the handler drains them; clocking
+ * the release on confirmed consumption bounds per-session memory by
+ * what the handler has actually absorbed.
+ */
+class WindowUpdateStrategy {
+ public:
+  virtual ~WindowUpdateStrategy() {
+  }
+
+  /**
+   * len ingress body bytes were delivered toward the handler.  Returns
+   * how many bytes become eligible for a WINDOW_UPDATE as a result.
+   */
+  virtual uint32_t onIngressBytesProcessed(uint32_t len) = 0;
+
+  /**
+   * len bytes were confirmed consumed out-of-band - e.g. a proxy's
+   * egress-side ByteEventTracker delivery callback reporting the bytes
+   * left the process.  Returns how many previously withheld bytes
+   * become eligible for a WINDOW_UPDATE.
+   */
+  virtual uint32_t onIngressBytesConsumed(uint32_t len) = 0;
+
+  /**
+   * Whether pendingAck eligible bytes warrant generating a
+   * WINDOW_UPDATE now.  Draining transports historically only update
+   * once the window is fully consumed; strategies should preserve that.
+   */
+  virtual bool shouldSendWindowUpdate(const Window& recvWindow,
+                                      uint32_t pendingAck,
+                                      bool draining) const = 0;
+};
+
+/**
+ * The historical policy: every byte handed to the handler is released
+ * immediately, and an update goes out at half the window capacity
+ * (full capacity while draining).
+ */
+class EagerWindowUpdateStrategy : public WindowUpdateStrategy {
+ public:
+  uint32_t onIngressBytesProcessed(uint32_t len) override {
+    return len;
+  }
+
+  uint32_t onIngressBytesConsumed(uint32_t /*len*/) override {
+    return 0;
+  }
+
+  bool shouldSendWindowUpdate(const Window& recvWindow,
+                              uint32_t pendingAck,
+                              bool draining) const override {
+    return pendingAck >= recvWindow.getCapacity() / (draining ? 1 : 2);
+  }
+};
+
+/**
+ * Release window only as consumption is confirmed: bytes delivered to
+ * the handler are withheld until a matching onIngressBytesConsumed,
+ * so the advertised window tracks what was absorbed, not what arrived.
+ */
+class AckClockedWindowUpdateStrategy : public WindowUpdateStrategy {
+ public:
+  uint32_t onIngressBytesProcessed(uint32_t len) override {
+    unconfirmed_ += len;
+    return 0;
+  }
+
+  uint32_t onIngressBytesConsumed(uint32_t len) override {
+    const auto release = std::min<uint64_t>(len, unconfirmed_);
+    unconfirmed_ -= release;
+    return static_cast<uint32_t>(release);
+  }
+
+  bool shouldSendWindowUpdate(const Window& recvWindow,
+                              uint32_t pendingAck,
+                              bool draining) const override {
+    return pendingAck >= recvWindow.getCapacity() / (draining ? 1 : 2);
+  }
+
+ private:
+  uint64_t unconfirmed_{0};
+};
+
+/**
+ * Release eagerly, but batch updates into fixed-size quanta instead of
+ * fractions of the capacity - fewer, more predictable WINDOW_UPDATE
+ * frames on large windows.
+ */
+class QuantumWindowUpdateStrategy : public WindowUpdateStrategy {
+ public:
+  explicit QuantumWindowUpdateStrategy(uint32_t quantumBytes)
+      : quantumBytes_(quantumBytes) {
+  }
+
+  uint32_t onIngressBytesProcessed(uint32_t len) override {
+    return len;
+  }
+
+  uint32_t onIngressBytesConsumed(uint32_t /*len*/) override {
+    return 0;
+  }
+
+  bool shouldSendWindowUpdate(const Window& recvWindow,
+                              uint32_t pendingAck,
+                              bool draining) const override {
+    if (draining) {
+      return pendingAck >= recvWindow.getCapacity();
+    }
+    return pendingAck >= quantumBytes_;
+  }
+
+ private:
+  const uint32_t quantumBytes_;
+};
+
+} // namespace proxygen
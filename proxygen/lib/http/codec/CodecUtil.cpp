@@ -12,6 +12,205 @@
 #include <proxygen/lib/http/RFC2616.h>
 #include <proxygen/lib/http/codec/HeaderConstants.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+/**
+ * Vectorized scanners for the validation hot paths.  Each returns the index
+ * of the first byte that needs the scalar slow path (or len if there is
+ * none); bytes before that index are guaranteed valid.  The scalar callers
+ * re-examine everything from the returned index, so these only have to be
+ * conservative, never exact.
+ */
+
+#if defined(__SSE2__)
+
+// Index of the first byte <= 0x20 or == 0x7f, or len
+size_t findFirstCtlOrSpace(const uint8_t* buf, size_t len) {
+  size_t i = 0;
+  const __m128i space = _mm_set1_epi8(0x20);
+  const __m128i del = _mm_set1_epi8(0x7f);
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + i));
+    __m128i bad = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(v, space), v),
+                               _mm_cmpeq_epi8(v, del));
+    int mask = _mm_movemask_epi8(bad);
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return i;
+}
+
+// Index of the first byte that is not a lowercase RFC2616 token character
+// (a conservative subset of CodecUtil::http_tokens), or len
+size_t findFirstNonCommonToken(const uint8_t* buf, size_t len) {
+  size_t i = 0;
+  const __m128i dash = _mm_set1_epi8('-');
+  // unsigned range checks via min/max against the bounds
+  const __m128i digit0 = _mm_set1_epi8('0');
+  const __m128i digit9 = _mm_set1_epi8('9');
+  const __m128i lowerA = _mm_set1_epi8('a');
+  const __m128i lowerZ = _mm_set1_epi8('z');
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + i));
+    __m128i isDigit =
+        _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(v, digit0), v),
+                      _mm_cmpeq_epi8(_mm_min_epu8(v, digit9), v));
+    __m128i isLower =
+        _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(v, lowerA), v),
+                      _mm_cmpeq_epi8(_mm_min_epu8(v, lowerZ), v));
+    __m128i ok = _mm_or_si128(_mm_or_si128(isDigit, isLower),
+                              _mm_cmpeq_epi8(v, dash));
+    int mask = _mm_movemask_epi8(ok) ^ 0xffff;
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return i;
+}
+
+// Index of the first byte that can affect the header value state machine:
+// a CTL other than HT (including CR), DEL or a double quote; or len
+size_t findFirstNonPlainValueByte(const uint8_t* buf, size_t len) {
+  size_t i = 0;
+  const __m128i ctlMax = _mm_set1_epi8(0x1f);
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i del = _mm_set1_epi8(0x7f);
+  const __m128i quote = _mm_set1_epi8('"');
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + i));
+    __m128i isCtl = _mm_andnot_si128(
+        _mm_cmpeq_epi8(v, tab), _mm_cmpeq_epi8(_mm_min_epu8(v, ctlMax), v));
+    __m128i bad = _mm_or_si128(
+        _mm_or_si128(isCtl, _mm_cmpeq_epi8(v, del)), _mm_cmpeq_epi8(v, quote));
+    int mask = _mm_movemask_epi8(bad);
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return i;
+}
+
+// Index of the first byte equal to c1 or c2, or the start of the
+// unscanned tail
+size_t findFirstOf2(const uint8_t* buf, size_t len, char c1, char c2) {
+  size_t i = 0;
+  const __m128i d1 = _mm_set1_epi8(c1);
+  const __m128i d2 = _mm_set1_epi8(c2);
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + i));
+    int mask = _mm_movemask_epi8(
+        _mm_or_si128(_mm_cmpeq_epi8(v, d1), _mm_cmpeq_epi8(v, d2)));
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return i;
+}
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+
+size_t findFirstCtlOrSpace(const uint8_t* buf, size_t len) {
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    uint8x16_t v = vld1q_u8(buf + i);
+    uint8x16_t bad = vorrq_u8(vcleq_u8(v, vdupq_n_u8(0x20)),
+                              vceqq_u8(v, vdupq_n_u8(0x7f)));
+    if (vmaxvq_u8(bad) != 0) {
+      break;
+    }
+  }
+  return i;
+}
+
+size_t findFirstNonCommonToken(const uint8_t* buf, size_t len) {
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    uint8x16_t v = vld1q_u8(buf + i);
+    uint8x16_t isDigit = vandq_u8(vcgeq_u8(v, vdupq_n_u8('0')),
+                                  vcleq_u8(v, vdupq_n_u8('9')));
+    uint8x16_t isLower = vandq_u8(vcgeq_u8(v, vdupq_n_u8('a')),
+                                  vcleq_u8(v, vdupq_n_u8('z')));
+    uint8x16_t ok = vorrq_u8(vorrq_u8(isDigit, isLower),
+                             vceqq_u8(v, vdupq_n_u8('-')));
+    if (vminvq_u8(ok) == 0) {
+      break;
+    }
+  }
+  return i;
+}
+
+size_t findFirstNonPlainValueByte(const uint8_t* buf, size_t len) {
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    uint8x16_t v = vld1q_u8(buf + i);
+    uint8x16_t isCtl = vbicq_u8(vcleq_u8(v, vdupq_n_u8(0x1f)),
+                                vceqq_u8(v, vdupq_n_u8('\t')));
+    uint8x16_t bad = vorrq_u8(vorrq_u8(isCtl, vceqq_u8(v, vdupq_n_u8(0x7f))),
+                              vceqq_u8(v, vdupq_n_u8('"')));
+    if (vmaxvq_u8(bad) != 0) {
+      break;
+    }
+  }
+  return i;
+}
+
+size_t findFirstOf2(const uint8_t* buf, size_t len, char c1, char c2) {
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    uint8x16_t v = vld1q_u8(buf + i);
+    uint8x16_t hit = vorrq_u8(vceqq_u8(v, vdupq_n_u8(c1)),
+                              vceqq_u8(v, vdupq_n_u8(c2)));
+    if (vmaxvq_u8(hit) != 0) {
+      break;
+    }
+  }
+  return i;
+}
+
+#else
+
+size_t findFirstCtlOrSpace(const uint8_t* /*buf*/, size_t /*len*/) {
+  return 0;
+}
+
+size_t findFirstNonCommonToken(const uint8_t* /*buf*/, size_t /*len*/) {
+  return 0;
+}
+
+size_t findFirstNonPlainValueByte(const uint8_t* /*buf*/, size_t /*len*/) {
+  return 0;
+}
+
+size_t findFirstOf2(const uint8_t* /*buf*/,
+                    size_t /*len*/,
+                    char /*c1*/,
+                    char /*c2*/) {
+  return 0;
+}
+
+#endif
+
+// Value of a hex digit, or -1
+int8_t hexVal(uint8_t c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  uint8_t lower = c | 0x20;
+  if (lower >= 'a' && lower <= 'f') {
+    return 10 + (lower - 'a');
+  }
+  return -1;
+}
+
+} // anonymous namespace
+
 namespace proxygen {
 
 /**
@@ -59,6 +258,157 @@ const char CodecUtil::http_tokens[256] = {
 };
 // clang-format on
 
+bool CodecUtil::validateURL(folly::ByteRange url) {
+  size_t i = findFirstCtlOrSpace(url.data(), url.size());
+  for (; i < url.size(); i++) {
+    if (url[i] <= 0x20 || url[i] == 0x7f) {
+      // no controls or unescaped spaces
+      return false;
+    }
+  }
+  return true;
+}
+
+bool CodecUtil::validateHeaderName(folly::ByteRange name) {
+  if (name.size() == 0) {
+    return false;
+  }
+  // bytes before i are lowercase alpha, digits or '-', all of which are
+  // valid token characters
+  size_t i = findFirstNonCommonToken(name.data(), name.size());
+  for (; i < name.size(); i++) {
+    uint8_t p = name[i];
+    if (p < 0x80 && http_tokens[p] != p) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool CodecUtil::validateHeaderValue(folly::ByteRange value,
+                                    CtlEscapeMode mode) {
+  bool escape = false;
+  bool quote = false;
+  enum {
+    lws_none,
+    lws_expect_nl,
+    lws_expect_ws1,
+    lws_expect_ws2
+  } state = lws_none;
+
+  // bytes before start cannot affect the state machine below: no CTLs
+  // (including CR), no DEL and no quotes, so we can skip straight past them
+  auto start = std::begin(value) + findFirstNonPlainValueByte(value.data(),
+                                                              value.size());
+  for (auto p = start; p != std::end(value); ++p) {
+    if (escape) {
+      escape = false;
+      if (mode == COMPLIANT) {
+        // prev char escaped.  Turn off escape and go to next char
+        // COMPLIANT mode only
+        assert(quote);
+        continue;
+      }
+    }
+    switch (state) {
+      case lws_none:
+        switch (*p) {
+          case '\\':
+            if (quote) {
+              escape = true;
+            }
+            break;
+          case '\"':
+            quote = !quote;
+            break;
+          case '\r':
+            state = lws_expect_nl;
+            break;
+          default:
+            if ((*p < 0x20 || *p == 0x7f) && *p != '\t') {
+              // unexpected ctl per rfc2616, HT OK
+              return false;
+            }
+            break;
+        }
+        break;
+      case lws_expect_nl:
+        if (*p != '\n') {
+          // unescaped \r must be LWS
+          return false;
+        }
+        state = lws_expect_ws1;
+        break;
+      case lws_expect_ws1:
+        if (*p != ' ' && *p != '\t') {
+          // unescaped \r\n must be LWS
+          return false;
+        }
+        state = lws_expect_ws2;
+        break;
+      case lws_expect_ws2:
+        if (*p != ' ' && *p != '\t') {
+          // terminated LWS
+          state = lws_none;
+          // check this char again
+          p--;
+        }
+        break;
+    }
+  }
+  // Unterminated quotes are OK, since the value can be* TEXT which treats
+  // the " like any other char.
+  // Unterminated escapes are bad because it will escape the next character
+  // when converting to HTTP
+  // Unterminated LWS (dangling \r or \r\n) is bad because it could
+  // prematurely terminate the headers when converting to HTTP
+  return !escape && (state == lws_none || state == lws_expect_ws2);
+}
+
+size_t CodecUtil::findFirstOf(folly::ByteRange buf, char c1, char c2) {
+  size_t i = findFirstOf2(buf.data(), buf.size(), c1, c2);
+  for (; i < buf.size(); i++) {
+    if (buf[i] == static_cast<uint8_t>(c1) ||
+        buf[i] == static_cast<uint8_t>(c2)) {
+      break;
+    }
+  }
+  return i;
+}
+
+bool CodecUtil::unescapeQuery(folly::StringPiece in, std::string& out) {
+  out.clear();
+  out.reserve(in.size());
+  auto buf = reinterpret_cast<const uint8_t*>(in.data());
+  size_t len = in.size();
+  size_t i = 0;
+  while (i < len) {
+    // Append the clean run up to the next escape in one shot
+    size_t next =
+        i + findFirstOf(folly::ByteRange(buf + i, len - i), '%', '+');
+    out.append(in.data() + i, next - i);
+    if (next >= len) {
+      break;
+    }
+    if (buf[next] == '+') {
+      out.push_back(' ');
+      i = next + 1;
+      continue;
+    }
+    if (next + 2 >= len) {
+      return false;
+    }
+    int8_t hi = hexVal(buf[next + 1]);
+    int8_t lo = hexVal(buf[next + 2]);
+    if (hi < 0 || lo < 0) {
+      return false;
+    }
+    out.push_back(static_cast<char>((hi << 4) | lo));
+    i = next + 3;
+  }
+  return true;
+}
+
 bool CodecUtil::hasGzipAndDeflate(const std::string& value,
                                   bool& hasGzip,
                                   bool& hasDeflate) {
@@ -8,6 +8,8 @@
 
 #include <proxygen/lib/http/codec/FlowControlFilter.h>
 
+#include <algorithm>
+
 namespace proxygen {
 
 namespace {
@@ -17,6 +19,11 @@ HTTPException getException(const std::string& msg) {
   return ex;
 }
 
+// Receive-window auto-tuning: RTT assumed until samples are fed, and the
+// floor for the measurement interval.
+constexpr std::chrono::microseconds kDefaultRttEstimate{100 * 1000};
+constexpr std::chrono::microseconds kMinAutoTuneInterval{10 * 1000};
+
 } // namespace
 
 FlowControlFilter::FlowControlFilter(Callback& callback,
@@ -27,7 +34,8 @@ FlowControlFilter::FlowControlFilter(Callback& callback,
       recvWindow_(codec->getDefaultWindowSize()),
       sendWindow_(codec->getDefaultWindowSize()),
       error_(false),
-      sendsBlocked_(false) {
+      sendsBlocked_(false),
+      autoTuneRecvWindow_(false) {
   if (recvCapacity > 0) {
     if (recvCapacity < codec->getDefaultWindowSize()) {
       VLOG(4) << "Ignoring low conn-level recv window size of " << recvCapacity;
@@ -65,9 +73,74 @@ void FlowControlFilter::setReceiveWindowSize(folly::IOBufQueue& writeBuf,
   }
 }
 
+void FlowControlFilter::enableReceiveWindowAutoTuning(uint32_t maxCapacity) {
+  autoTuneRecvWindow_ = true;
+  autoTuneMinCapacity_ = call_->getDefaultWindowSize();
+  autoTuneMaxCapacity_ = std::max(maxCapacity, autoTuneMinCapacity_);
+  autoTuneBytes_ = 0;
+  autoTuneSampleStart_ = getCurrentTime();
+}
+
+void FlowControlFilter::onRttSample(std::chrono::microseconds rtt) {
+  if (srtt_.count() == 0) {
+    srtt_ = rtt;
+  } else {
+    srtt_ = (srtt_ * 7 + rtt) / 8;
+  }
+}
+
+void FlowControlFilter::maybeAutoTuneReceiveWindow(folly::IOBufQueue& writeBuf) {
+  const auto rtt = srtt_.count() > 0 ? srtt_ : kDefaultRttEstimate;
+  const auto interval = std::max(rtt, kMinAutoTuneInterval);
+  const auto now = getCurrentTime();
+  const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      now - autoTuneSampleStart_);
+  if (elapsed < interval) {
+    return;
+  }
+  // Bytes delivered in one RTT approximate the BDP; target twice that so
+  // the sender can keep a full window in flight while our updates are in
+  // transit.
+  const uint64_t bytesPerRtt = autoTuneBytes_ * rtt.count() / elapsed.count();
+  const uint64_t target = std::min<uint64_t>(
+      std::max<uint64_t>(2 * bytesPerRtt, autoTuneMinCapacity_),
+      autoTuneMaxCapacity_);
+  autoTuneBytes_ = 0;
+  autoTuneSampleStart_ = now;
+
+  const uint32_t capacity = recvWindow_.getCapacity();
+  if (target > capacity) {
+    if (recvWindow_.setCapacity(target)) {
+      VLOG(4) << "Auto-tuned conn-level recv window up to " << target;
+      call_->generateWindowUpdate(writeBuf, 0, target - capacity);
+    }
+  } else if (target < capacity / 2) {
+    // Never shrink below what is currently outstanding
+    const uint32_t newCapacity =
+        std::max<uint32_t>(target, recvWindow_.getOutstanding());
+    if (newCapacity < capacity && recvWindow_.setCapacity(newCapacity)) {
+      VLOG(4) << "Auto-tuned conn-level recv window down to " << newCapacity;
+      autoTuneShrinkDebt_ += capacity - newCapacity;
+    }
+  }
+}
+
 bool FlowControlFilter::ingressBytesProcessed(folly::IOBufQueue& writeBuf,
                                               uint32_t delta) {
   toAck_ += delta;
+  if (autoTuneRecvWindow_) {
+    maybeAutoTuneReceiveWindow(writeBuf);
+    if (autoTuneShrinkDebt_ > 0 && toAck_ > 0) {
+      // Withhold acks after a shrink: the bytes are freed locally but
+      // never re-advertised, so the peer's view of the window drains by
+      // exactly the amount the capacity dropped.
+      const uint32_t consumed =
+          std::min<uint32_t>(autoTuneShrinkDebt_, toAck_);
+      autoTuneShrinkDebt_ -= consumed;
+      toAck_ -= consumed;
+      CHECK(recvWindow_.free(consumed));
+    }
+  }
   bool willAck =
       (toAck_ > 0 && uint32_t(toAck_) > recvWindow_.getCapacity() / 2);
   VLOG(4) << "processed " << delta << " toAck_=" << toAck_
@@ -110,6 +183,9 @@ void FlowControlFilter::onBody(StreamID stream,
     }
     toAck_ += padding;
     CHECK(recvWindow_.free(padding));
+    if (autoTuneRecvWindow_) {
+      autoTuneBytes_ += amount;
+    }
     callback_->onBody(stream, std::move(chain), padding);
   }
 }
@@ -10,6 +10,9 @@
 
 #include <proxygen/lib/http/Window.h>
 #include <proxygen/lib/http/codec/HTTPCodecFilter.h>
+#include <proxygen/lib/utils/Time.h>
+
+#include <chrono>
 
 namespace folly {
 class IOBufQueue;
@@ -73,6 +76,25 @@ class FlowControlFilter : public PassThroughHTTPCodecFilter {
    */
   bool ingressBytesProcessed(folly::IOBufQueue& writeBuf, uint32_t delta);
 
+  /**
+   * Enable receive-window auto-tuning.  The filter measures delivered
+   * ingress bytes per smoothed RTT and retargets the conn-level receive
+   * window to twice the observed bandwidth-delay product, clamped
+   * between the codec default window and maxCapacity.  Growth is
+   * advertised immediately with a WINDOW_UPDATE; shrinking happens
+   * silently by withholding acks until the peer's view of the window has
+   * drained to the new capacity, so it can never trigger a
+   * FLOW_CONTROL_ERROR.  RTT samples should be fed by the session via
+   * onRttSample() (e.g. off transport byte events); with no samples a
+   * conservative default estimate is used.
+   */
+  void enableReceiveWindowAutoTuning(uint32_t maxCapacity);
+
+  /**
+   * Feed an RTT sample for receive-window auto-tuning (EWMA smoothed).
+   */
+  void onRttSample(std::chrono::microseconds rtt);
+
   /**
    * @returns the number of bytes available in the connection-level send window
    */
@@ -107,12 +129,25 @@ class FlowControlFilter : public PassThroughHTTPCodecFilter {
   }
 
  private:
+  void maybeAutoTuneReceiveWindow(folly::IOBufQueue& writeBuf);
+
   Callback& notify_;
   Window recvWindow_;
   Window sendWindow_;
   int32_t toAck_{0};
+
+  // Receive-window auto-tuning state, see enableReceiveWindowAutoTuning().
+  uint32_t autoTuneMinCapacity_{0};
+  uint32_t autoTuneMaxCapacity_{0};
+  // Acks withheld from the peer after a shrink, in bytes.
+  uint32_t autoTuneShrinkDebt_{0};
+  std::chrono::microseconds srtt_{0};
+  uint64_t autoTuneBytes_{0};
+  TimePoint autoTuneSampleStart_;
+
   bool error_ : 1;
   bool sendsBlocked_ : 1;
+  bool autoTuneRecvWindow_ : 1;
 };
 
 } // namespace proxygen
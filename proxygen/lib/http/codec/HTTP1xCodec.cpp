@@ -106,7 +106,9 @@ HTTP1xCodec::HTTP1xCodec(TransportDirection direction, bool force1_1)
       ingressUpgradeComplete_(false),
       egressUpgrade_(false),
       nativeUpgrade_(false),
-      headersComplete_(false) {
+      headersComplete_(false),
+      batchedBodyCallbacks_(false),
+      requestLineDelivered_(false) {
   switch (direction) {
     case TransportDirection::DOWNSTREAM:
       http_parser_init(&parser_, HTTP_REQUEST);
@@ -194,6 +196,9 @@ size_t HTTP1xCodec::onIngress(const IOBuf& buf) {
     }
     size_t bytesParsed = http_parser_execute(
         &parser_, getParserSettings(), (const char*)buf.data(), buf.length());
+    // Any body batched up during this buffer has to go out before the
+    // buffer does; the accumulated slices point into it
+    flushPendingBody();
     // in case we parsed a section of the headers but we're not done parsing
     // the headers we need to keep accounting of it for total header size
     if (!headersComplete_) {
@@ -212,6 +217,12 @@ size_t HTTP1xCodec::onIngress(const IOBuf& buf) {
       currentHeaderName_.assign(currentHeaderNameStringPiece_.begin(),
                                 currentHeaderNameStringPiece_.size());
     }
+    if (currentHeaderValue_.empty() && !currentHeaderValueStringPiece_.empty()) {
+      // same as above, but for the partially received header value
+      currentHeaderValue_.assign(currentHeaderValueStringPiece_.begin(),
+                                 currentHeaderValueStringPiece_.size());
+      currentHeaderValueStringPiece_.clear();
+    }
     currentIngressBuf_ = nullptr;
     if (pendingEOF_) {
       onIngressEOF();
@@ -568,6 +579,13 @@ void HTTP1xCodec::generateHeader(
     writeBuf.postallocate(lineLen);
     len += lineLen;
   };
+  if (const auto& preSerialized = msg.getPreSerializedHeaders()) {
+    // Pre-rendered "Name: value\r\n" lines registered by the handler; the
+    // contract in HTTPMessage::setPreSerializedHeaders guarantees they carry
+    // no connection-level semantics, so they can be spliced in verbatim.
+    len += preSerialized->computeChainDataLength();
+    writeBuf.append(preSerialized->clone());
+  }
   msg.getHeaders().forEachWithCode(headerEncoder);
   if (extraHeaders) {
     extraHeaders->forEachWithCode(headerEncoder);
@@ -814,6 +832,11 @@ void HTTP1xCodec::setAllowedUpgradeProtocols(std::list<std::string> protocols) {
   }
 }
 
+void HTTP1xCodec::setAllowedUpgradeProtocolsJoined(std::string protocols) {
+  CHECK(transportDirection_ == TransportDirection::DOWNSTREAM);
+  allowedNativeUpgrades_ = std::move(protocols);
+}
+
 const std::string& HTTP1xCodec::getAllowedUpgradeProtocols() {
   return allowedNativeUpgrades_;
 }
@@ -823,6 +846,7 @@ int HTTP1xCodec::onMessageBegin() {
   headerSize_.uncompressed = 0;
   headerSize_.compressed = 0;
   headerParseState_ = HeaderParseState::kParsingHeaderStart;
+  requestLineDelivered_ = false;
   msg_.reset(new HTTPMessage());
   trailers_.reset();
   if (transportDirection_ == TransportDirection::DOWNSTREAM) {
@@ -851,22 +875,91 @@ int HTTP1xCodec::onReason(const char* buf, size_t len) {
   return 0;
 }
 
+void HTTP1xCodec::maybeDeliverRequestLine() {
+  if (!requestLineCb_ || requestLineDelivered_ ||
+      transportDirection_ != TransportDirection::DOWNSTREAM) {
+    return;
+  }
+  requestLineDelivered_ = true;
+  // path/query are bounds into url_, which stays alive until
+  // onHeadersComplete moves it onto the message
+  ParseURL parseUrl(url_);
+  requestLineCb_->onRequestLineComplete(
+      ingressTxnID_,
+      folly::StringPiece(
+          http_method_str(static_cast<http_method>(parser_.method))),
+      parseUrl);
+}
+
 void HTTP1xCodec::pushHeaderNameAndValue(HTTPHeaders& hdrs) {
   if (LIKELY(currentHeaderName_.empty())) {
-    hdrs.addFromCodec(currentHeaderNameStringPiece_.begin(),
-                      currentHeaderNameStringPiece_.size(),
-                      std::move(currentHeaderValue_));
+    if (LIKELY(currentHeaderValue_.empty())) {
+      // both name and value are still borrowed from the ingress buffer, so
+      // the single copy happens inside HTTPHeaders
+      hdrs.addFromCodec(currentHeaderNameStringPiece_.begin(),
+                        currentHeaderNameStringPiece_.size(),
+                        currentHeaderValueStringPiece_);
+    } else {
+      hdrs.addFromCodec(currentHeaderNameStringPiece_.begin(),
+                        currentHeaderNameStringPiece_.size(),
+                        std::move(currentHeaderValue_));
+    }
   } else {
-    hdrs.add(currentHeaderName_, std::move(currentHeaderValue_));
+    if (currentHeaderValue_.empty()) {
+      hdrs.add(currentHeaderName_, currentHeaderValueStringPiece_);
+    } else {
+      hdrs.add(currentHeaderName_, std::move(currentHeaderValue_));
+    }
     currentHeaderName_.clear();
   }
   currentHeaderNameStringPiece_.clear();
+  currentHeaderValueStringPiece_.clear();
   currentHeaderValue_.clear();
 }
 
+bool HTTP1xCodec::isFramingHeader(folly::StringPiece name) {
+  return caseInsensitiveEqual(name, "connection") ||
+         caseInsensitiveEqual(name, "content-length") ||
+         caseInsensitiveEqual(name, "transfer-encoding") ||
+         caseInsensitiveEqual(name, "upgrade") ||
+         caseInsensitiveEqual(name, "expect") ||
+         caseInsensitiveEqual(name, "proxy-connection") ||
+         caseInsensitiveEqual(name, "host");
+}
+
+void HTTP1xCodec::deliverOrPushHeader(HTTPHeaders& hdrs) {
+  if (streamingHeaderCb_ == nullptr ||
+      transportDirection_ != TransportDirection::DOWNSTREAM) {
+    pushHeaderNameAndValue(hdrs);
+    return;
+  }
+  folly::StringPiece name = currentHeaderName_.empty()
+                                ? currentHeaderNameStringPiece_
+                                : folly::StringPiece(currentHeaderName_);
+  folly::StringPiece value = currentHeaderValue_.empty()
+                                 ? currentHeaderValueStringPiece_
+                                 : folly::StringPiece(currentHeaderValue_);
+  streamingHeaderCb_->onIngressHeader(ingressTxnID_, name, value);
+  if (isFramingHeader(name)) {
+    pushHeaderNameAndValue(hdrs);
+    return;
+  }
+  // Streamed and not stored; discard the in-flight header state the same
+  // way pushHeaderNameAndValue would have
+  currentHeaderName_.clear();
+  currentHeaderNameStringPiece_.clear();
+  currentHeaderValue_.clear();
+  currentHeaderValueStringPiece_.clear();
+}
+
 int HTTP1xCodec::onHeaderField(const char* buf, size_t len) {
+  if (headerParseState_ == HeaderParseState::kParsingHeaderStart) {
+    // request line (including the version) is fully parsed once the
+    // first header field begins
+    maybeDeliverRequestLine();
+  }
   if (headerParseState_ == HeaderParseState::kParsingHeaderValue) {
-    pushHeaderNameAndValue(msg_->getHeaders());
+    deliverOrPushHeader(msg_->getHeaders());
   } else if (headerParseState_ == HeaderParseState::kParsingTrailerValue) {
     if (!trailers_) {
       trailers_.reset(new HTTPHeaders());
@@ -918,13 +1011,35 @@ int HTTP1xCodec::onHeaderValue(const char* buf, size_t len) {
   } else {
     headerParseState_ = HeaderParseState::kParsingTrailerValue;
   }
-  currentHeaderValue_.append(buf, len);
+  if (currentHeaderValue_.empty()) {
+    if (currentHeaderValueStringPiece_.empty()) {
+      // first chunk of this value (typically, the only one) - keep borrowing
+      // from the ingress buffer like we do for the header name
+      currentHeaderValueStringPiece_.reset(buf, len);
+    } else if (currentHeaderValueStringPiece_.end() == buf) {
+      // the value is contiguous in memory, so we just adjust the right end
+      // of our StringPiece
+      currentHeaderValueStringPiece_.advance(len);
+    } else {
+      // discontinuity (e.g., obs-fold) - fall back to currentHeaderValue_
+      currentHeaderValue_.reserve(currentHeaderValueStringPiece_.size() + len);
+      currentHeaderValue_.assign(currentHeaderValueStringPiece_.begin(),
+                                 currentHeaderValueStringPiece_.size());
+      currentHeaderValue_.append(buf, len);
+      currentHeaderValueStringPiece_.clear();
+    }
+  } else {
+    // we had already fallen back to currentHeaderValue_ before
+    currentHeaderValue_.append(buf, len);
+  }
   return 0;
 }
 
 int HTTP1xCodec::onHeadersComplete(size_t len) {
+  // header-less requests reach here without any onHeaderField call
+  maybeDeliverRequestLine();
   if (headerParseState_ == HeaderParseState::kParsingHeaderValue) {
-    pushHeaderNameAndValue(msg_->getHeaders());
+    deliverOrPushHeader(msg_->getHeaders());
   }
 
   // discard messages with folded or multiple valued Transfer-Encoding headers
@@ -1150,13 +1265,29 @@ int HTTP1xCodec::onBody(const char* buf, size_t len) {
   clone->trimStart(buf - dataStart);
   clone->trimEnd(dataEnd - (buf + len));
   DCHECK_EQ(len, clone->computeChainDataLength());
+  if (batchedBodyCallbacks_) {
+    if (pendingBodyBatch_) {
+      pendingBodyBatch_->prependChain(std::move(clone));
+    } else {
+      pendingBodyBatch_ = std::move(clone);
+    }
+    return 0;
+  }
   callback_->onBody(ingressTxnID_, std::move(clone), 0);
   return 0;
 }
 
+void HTTP1xCodec::flushPendingBody() {
+  if (pendingBodyBatch_) {
+    callback_->onBody(ingressTxnID_, std::move(pendingBodyBatch_), 0);
+  }
+}
+
 int HTTP1xCodec::onChunkHeader(size_t len) {
   if (len > 0) {
-    callback_->onChunkHeader(ingressTxnID_, len);
+    if (!batchedBodyCallbacks_) {
+      callback_->onChunkHeader(ingressTxnID_, len);
+    }
   } else {
     VLOG(5) << "Suppressed onChunkHeader callback for final zero length "
             << "chunk";
@@ -1168,7 +1299,7 @@ int HTTP1xCodec::onChunkHeader(size_t len) {
 int HTTP1xCodec::onChunkComplete() {
   if (inRecvLastChunk_) {
     inRecvLastChunk_ = false;
-  } else {
+  } else if (!batchedBodyCallbacks_) {
     callback_->onChunkComplete(ingressTxnID_);
   }
   return 0;
@@ -1177,6 +1308,9 @@ int HTTP1xCodec::onChunkComplete() {
 int HTTP1xCodec::onMessageComplete() {
   DCHECK(!isParsingHeaders());
   DCHECK(!inRecvLastChunk_);
+  // The full body must be delivered before trailers and EOM, even if the
+  // message ended mid-buffer (pipelined requests, keepalive)
+  flushPendingBody();
   if (headerParseState_ == HeaderParseState::kParsingTrailerValue) {
     if (!trailers_) {
       trailers_.reset(new HTTPHeaders());
@@ -11,6 +11,7 @@
 #include <proxygen/lib/http/HTTPMessage.h>
 #include <proxygen/lib/http/codec/HTTPCodec.h>
 #include <proxygen/lib/http/codec/TransportDirection.h>
+#include <proxygen/lib/utils/ParseURL.h>
 #include <string>
 
 #include <proxygen/external/http_parser/http_parser.h>
@@ -46,6 +47,49 @@ class HTTP1xCodec : public HTTPCodec {
   void setCallback(Callback* callback) override {
     callback_ = callback;
   }
+  /**
+   * Streaming header delivery for ingress request headers; see
+   * HTTPCodec::StreamingHeaderCallback.  Framing headers (connection,
+   * content-length, transfer-encoding, etc.) are still stored on the
+   * message since this codec's own parsing depends on them.  Trailers
+   * keep the buffered path.
+   */
+  void setStreamingHeaderCallback(StreamingHeaderCallback* cb) override {
+    streamingHeaderCb_ = cb;
+  }
+  /**
+   * Coalesce ingress body delivery.  When enabled, consecutive body
+   * slices decoded from a single onIngress buffer are chained together
+   * and delivered in one onBody callback, and the per-chunk
+   * onChunkHeader/onChunkComplete callbacks are suppressed.  For streams
+   * of many tiny chunks (gRPC-web, SSE over HTTP/1.1) this trades chunk
+   * boundary visibility for one callback per ingress buffer instead of
+   * three per chunk; do not enable if the session above needs to
+   * re-chunk egress identically.  Ingress only.
+   */
+  void setBatchedBodyCallbacks(bool enabled) {
+    batchedBodyCallbacks_ = enabled;
+  }
+  /**
+   * Early receiver for ingress request lines.  Invoked once per request,
+   * as soon as the request line has been parsed and before any header is
+   * delivered, so routing work can overlap with header parsing.  The
+   * method string and the ParseURL (path/query bounds into the raw URL)
+   * borrow from codec-internal storage and are only valid for the
+   * duration of the call; nothing is materialized beyond what ingress
+   * parsing already keeps.  DOWNSTREAM only.
+   */
+  class RequestLineCallback {
+   public:
+    virtual ~RequestLineCallback() {
+    }
+    virtual void onRequestLineComplete(StreamID stream,
+                                       folly::StringPiece method,
+                                       const ParseURL& url) noexcept = 0;
+  };
+  void setRequestLineCallback(RequestLineCallback* cb) {
+    requestLineCb_ = cb;
+  }
   bool isBusy() const override;
   void setParserPaused(bool paused) override;
   bool isParserPaused() const override {
@@ -115,6 +159,9 @@ class HTTP1xCodec : public HTTPCodec {
   }
 
   void setAllowedUpgradeProtocols(std::list<std::string> protocols);
+  // Same as above, but takes the comma-separated form directly so callers
+  // serving many connections can join the list once and reuse the string.
+  void setAllowedUpgradeProtocolsJoined(std::string protocols);
   const std::string& getAllowedUpgradeProtocols();
 
   /**
@@ -187,7 +234,38 @@ class HTTP1xCodec : public HTTPCodec {
   int onChunkComplete();
   int onMessageComplete();
 
+  /**
+   * Push the in-flight ingress header into hdrs, or, in streaming mode,
+   * hand it to the streaming callback and store it only if it is
+   * framing-relevant.
+   */
+  void deliverOrPushHeader(HTTPHeaders& hdrs);
+
+  /**
+   * Deliver the request line to requestLineCb_ if it hasn't been
+   * delivered for this message yet.  Called when the first header field
+   * arrives (the request line, including the version, is complete by
+   * then) and from onHeadersComplete for header-less requests.
+   */
+  void maybeDeliverRequestLine();
+
+  /**
+   * Deliver any body accumulated by batched body mode.  Called when the
+   * current ingress buffer is exhausted and before any callback that
+   * must observe the body as already delivered (message complete).
+   */
+  void flushPendingBody();
+
+  /**
+   * Headers this codec (or the session above it) reads for message
+   * framing and connection handling; these stay on the message even in
+   * streaming mode.
+   */
+  static bool isFramingHeader(folly::StringPiece name);
+
   HTTPCodec::Callback* callback_;
+  StreamingHeaderCallback* streamingHeaderCb_{nullptr};
+  RequestLineCallback* requestLineCb_{nullptr};
   StreamID ingressTxnID_;
   StreamID egressTxnID_;
   http_parser parser_;
@@ -195,9 +273,12 @@ class HTTP1xCodec : public HTTPCodec {
   std::unique_ptr<HTTPMessage> msg_;
   std::unique_ptr<HTTPMessage> upgradeRequest_;
   std::unique_ptr<HTTPHeaders> trailers_;
+  // Body slices accumulated (but not yet delivered) in batched body mode
+  std::unique_ptr<folly::IOBuf> pendingBodyBatch_;
   std::string currentHeaderName_;
   folly::StringPiece currentHeaderNameStringPiece_;
   std::string currentHeaderValue_;
+  folly::StringPiece currentHeaderValueStringPiece_;
   std::string url_;
   std::string userAgent_;
   std::string reason_;
@@ -232,6 +313,8 @@ class HTTP1xCodec : public HTTPCodec {
   bool egressUpgrade_ : 1;
   bool nativeUpgrade_ : 1;
   bool headersComplete_ : 1;
+  bool batchedBodyCallbacks_ : 1;
+  bool requestLineDelivered_ : 1;
 
   // C-callable wrappers for the http_parser callbacks
   static int onMessageBeginCB(http_parser* parser);
@@ -12,12 +12,16 @@
 #include <proxygen/lib/http/codec/HTTP2Constants.h>
 #include <proxygen/lib/utils/Base64.h>
 #include <proxygen/lib/utils/Logging.h>
+#include <proxygen/lib/utils/Tracepoints.h>
 
 #include <folly/Conv.h>
 #include <folly/Random.h>
+#include <folly/String.h>
+#include <folly/Synchronized.h>
 #include <folly/ThreadLocal.h>
 #include <folly/io/Cursor.h>
 #include <folly/tracing/ScopedTraceSection.h>
+#include <array>
 #include <type_traits>
 
 using namespace folly::io;
@@ -37,6 +41,109 @@ std::string base64url_decode(const std::string& str) {
 const size_t kDefaultGrowth = 4000;
 constexpr auto kOkhttp2 = "okhttp/2";
 constexpr int kOkhttp2GoawayLogFreq = 1000;
+
+/**
+ * Pre-encoded HPACK fragments for the common unary gRPC trailer case:
+ * "grpc-status: <0..16>" as a literal header field without indexing
+ * with a literal name (RFC 7541 section 6.2.2).  These opcodes never
+ * modify the dynamic table, so the cached bytes can be replayed on any
+ * stream without touching encoder state.  Returns nullptr when the
+ * trailers don't match the template.
+ */
+const folly::IOBuf* getPrecodedGrpcStatusFragment(
+    const proxygen::HTTPHeaders& trailers) {
+  static const std::array<std::unique_ptr<folly::IOBuf>, 17> fragments = [] {
+    std::array<std::unique_ptr<folly::IOBuf>, 17> result;
+    constexpr folly::StringPiece name{"grpc-status"};
+    for (size_t status = 0; status < result.size(); status++) {
+      auto value = folly::to<std::string>(status);
+      std::string block;
+      block.push_back('\0'); // literal without indexing, new name
+      block.push_back(static_cast<char>(name.size()));
+      block.append(name.data(), name.size());
+      block.push_back(static_cast<char>(value.size()));
+      block.append(value);
+      result[status] = folly::IOBuf::copyBuffer(block);
+    }
+    return result;
+  }();
+  if (trailers.size() != 1) {
+    return nullptr;
+  }
+  const auto& status = trailers.getSingleOrEmpty("grpc-status");
+  auto idx = folly::tryTo<uint32_t>(status);
+  if (!idx.hasValue() || *idx >= fragments.size() ||
+      status != folly::to<std::string>(*idx)) {
+    // Reject non-canonical spellings ("01") so the replay stays
+    // byte-faithful to what the encoder would have produced
+    return nullptr;
+  }
+  return fragments[*idx].get();
+}
+
+/**
+ * Process-wide cache of pre-encoded HPACK fragments for 103 Early
+ * Hints blocks.  Hint blocks are configuration-driven and repeat
+ * verbatim on every response for a route, so each distinct block is
+ * encoded once -- ":status: 103" with the static-table :status name,
+ * then one literal without indexing per hint header (RFC 7541 section
+ * 6.2.2) -- and the bytes replayed on any stream of any session
+ * without touching encoder state.  Returns nullptr for blocks that
+ * don't fit the single-byte-length template or once the cache is full;
+ * entries are never evicted, so the returned pointer stays valid.
+ */
+const folly::IOBuf* getPrecodedEarlyHintsFragment(
+    const proxygen::HTTPHeaders& hints) {
+  constexpr size_t kMaxCachedHintBlocks = 64;
+  constexpr size_t kMaxFieldLen = 126;
+  if (hints.size() == 0) {
+    return nullptr;
+  }
+  std::string block;
+  block.push_back('\x08'); // :status, static table index 8, not indexed
+  block.push_back('\x03');
+  block.append("103");
+  bool encodable = true;
+  hints.forEach([&](const std::string& name, const std::string& value) {
+    if (name.empty() || name.size() > kMaxFieldLen ||
+        value.size() > kMaxFieldLen) {
+      encodable = false;
+      return;
+    }
+    block.push_back('\0'); // literal without indexing, new name
+    block.push_back(static_cast<char>(name.size()));
+    const auto nameOffset = block.size();
+    block.append(name);
+    folly::toLowerAscii(&block[nameOffset], name.size());
+    block.push_back(static_cast<char>(value.size()));
+    block.append(value);
+  });
+  if (!encodable) {
+    return nullptr;
+  }
+  static folly::Synchronized<
+      std::unordered_map<std::string, std::unique_ptr<folly::IOBuf>>>
+      cache;
+  {
+    auto rlocked = cache.rlock();
+    auto it = rlocked->find(block);
+    if (it != rlocked->end()) {
+      return it->second.get();
+    }
+  }
+  auto wlocked = cache.wlock();
+  auto it = wlocked->find(block);
+  if (it != wlocked->end()) {
+    return it->second.get();
+  }
+  if (wlocked->size() >= kMaxCachedHintBlocks) {
+    return nullptr;
+  }
+  auto fragment = folly::IOBuf::copyBuffer(block);
+  const auto* ret = fragment.get();
+  wlocked->emplace(std::move(block), std::move(fragment));
+  return ret;
+}
 } // namespace
 
 namespace proxygen {
@@ -61,11 +168,67 @@ HTTP2Codec::HTTP2Codec(TransportDirection direction)
 HTTP2Codec::~HTTP2Codec() {
 }
 
+bool HTTP2Codec::reset() {
+  resetParallelCodecState();
+  headerCodec_.reset();
+  curHeader_ = http2::FrameHeader();
+  expectedContinuationStream_ = 0;
+  curBlockContinuationFrames_ = 0;
+  promisedStream_ = folly::none;
+  parsingReq_ = false;
+  pendingEndStreamHandling_ = false;
+  ingressWebsocketUpgrade_ = false;
+  upgradedStreams_.clear();
+  curCertId_ = 0;
+  curAuthenticatorBlock_.move();
+  curHeaderBlock_.move();
+  ingressSettings_ = HTTPSettings{
+      {SettingsId::HEADER_TABLE_SIZE, 4096},
+      {SettingsId::ENABLE_PUSH, 1},
+      {SettingsId::MAX_FRAME_SIZE, 16384},
+  };
+  egressSettings_ = HTTPSettings{
+      {SettingsId::HEADER_TABLE_SIZE, 4096},
+      {SettingsId::ENABLE_PUSH, 0},
+      {SettingsId::MAX_FRAME_SIZE, 16384},
+      {SettingsId::MAX_HEADER_LIST_SIZE, 1 << 17},
+  };
+  maxSendFrameSize_ = http2::kMaxFramePayloadLengthMin;
+#ifndef NDEBUG
+  receivedFrameCount_ = 0;
+#endif
+  frameState_ = transportDirection_ == TransportDirection::DOWNSTREAM
+                    ? FrameState::UPSTREAM_CONNECTION_PREFACE
+                    : FrameState::DOWNSTREAM_CONNECTION_PREFACE;
+  userAgent_.clear();
+  pendingDataFrameBytes_ = 0;
+  pendingDataFramePaddingBytes_ = 0;
+  decodeInfo_.msg.reset();
+  virtualPriorityNodes_.clear();
+  pendingTableMaxSize_ = folly::none;
+  parsingDownstreamTrailers_ = false;
+  headerBlockFrameType_ = http2::FrameType::DATA;
+  pendingWindowUpdates_.clear();
+  pendingSettingsAcks_ = 0;
+  pendingPingAcks_.clear();
+  fastRejectFired_ = false;
+  // Configuration knobs (header indexing strategy, header validation,
+  // date header, etc) deliberately survive the reset; they are
+  // per-listener, not per-connection.
+  const auto maxHeaderListSize =
+      egressSettings_.getSetting(SettingsId::MAX_HEADER_LIST_SIZE);
+  if (maxHeaderListSize) {
+    headerCodec_.setMaxUncompressed(maxHeaderListSize->value);
+  }
+  return true;
+}
+
 // HTTPCodec API
 
 size_t HTTP2Codec::onIngress(const folly::IOBuf& buf) {
   // TODO: ensure only 1 parse at a time on stack.
   FOLLY_SCOPED_TRACE_SECTION("HTTP2Codec - onIngress");
+  PROXYGEN_SDT(codec_ingress, this, buf.length());
 
   Cursor cursor(&buf);
   size_t parsed = 0;
@@ -77,9 +240,14 @@ size_t HTTP2Codec::onIngress(const folly::IOBuf& buf) {
         auto test = cursor.readFixedString(http2::kConnectionPreface.length());
         parsed += http2::kConnectionPreface.length();
         if (test != http2::kConnectionPreface) {
-          goawayErrorMessage_ = "missing connection preface";
-          VLOG(4) << goawayErrorMessage_;
-          connError = ErrorCode::PROTOCOL_ERROR;
+          if (fastRejectCounters_) {
+            connError = fastReject(&FastRejectCounters::badPreface,
+                                   ErrorCode::PROTOCOL_ERROR);
+          } else {
+            goawayErrorMessage_ = "missing connection preface";
+            VLOG(4) << goawayErrorMessage_;
+            connError = ErrorCode::PROTOCOL_ERROR;
+          }
         }
         frameState_ = FrameState::FRAME_HEADER;
       } else {
@@ -93,20 +261,30 @@ size_t HTTP2Codec::onIngress(const folly::IOBuf& buf) {
         parsed += http2::kFrameHeaderSize;
         if (frameState_ == FrameState::DOWNSTREAM_CONNECTION_PREFACE &&
             curHeader_.type != http2::FrameType::SETTINGS) {
-          goawayErrorMessage_ = folly::to<string>(
-              "GOAWAY error: got invalid connection preface frame type=",
-              getFrameTypeString(curHeader_.type),
-              "(",
-              curHeader_.type,
-              ")",
-              " for streamID=",
-              curHeader_.stream);
-          VLOG(4) << goawayErrorMessage_;
-          connError = ErrorCode::PROTOCOL_ERROR;
+          if (fastRejectCounters_) {
+            connError = fastReject(&FastRejectCounters::badPreface,
+                                   ErrorCode::PROTOCOL_ERROR);
+          } else {
+            goawayErrorMessage_ = folly::to<string>(
+                "GOAWAY error: got invalid connection preface frame type=",
+                getFrameTypeString(curHeader_.type),
+                "(",
+                curHeader_.type,
+                ")",
+                " for streamID=",
+                curHeader_.stream);
+            VLOG(4) << goawayErrorMessage_;
+            connError = ErrorCode::PROTOCOL_ERROR;
+          }
         }
         if (curHeader_.length > maxRecvFrameSize()) {
-          VLOG(4) << "Excessively large frame len=" << curHeader_.length;
-          connError = ErrorCode::FRAME_SIZE_ERROR;
+          if (fastRejectCounters_) {
+            connError = fastReject(&FastRejectCounters::oversizedFrame,
+                                   ErrorCode::FRAME_SIZE_ERROR);
+          } else {
+            VLOG(4) << "Excessively large frame len=" << curHeader_.length;
+            connError = ErrorCode::FRAME_SIZE_ERROR;
+          }
         }
 
         if (callback_) {
@@ -164,6 +342,10 @@ ErrorCode HTTP2Codec::parseFrame(folly::io::Cursor& cursor) {
   if (expectedContinuationStream_ != 0 &&
       (curHeader_.type != http2::FrameType::CONTINUATION ||
        expectedContinuationStream_ != curHeader_.stream)) {
+    if (fastRejectCounters_) {
+      return fastReject(&FastRejectCounters::continuationMisuse,
+                        ErrorCode::PROTOCOL_ERROR);
+    }
     goawayErrorMessage_ = folly::to<string>(
         "GOAWAY error: while expected CONTINUATION with stream=",
         expectedContinuationStream_,
@@ -176,12 +358,34 @@ ErrorCode HTTP2Codec::parseFrame(folly::io::Cursor& cursor) {
   }
   if (expectedContinuationStream_ == 0 &&
       curHeader_.type == http2::FrameType::CONTINUATION) {
+    if (fastRejectCounters_) {
+      return fastReject(&FastRejectCounters::continuationMisuse,
+                        ErrorCode::PROTOCOL_ERROR);
+    }
     goawayErrorMessage_ = folly::to<string>(
         "GOAWAY error: unexpected CONTINUATION received with streamID=",
         curHeader_.stream);
     VLOG(4) << goawayErrorMessage_;
     return ErrorCode::PROTOCOL_ERROR;
   }
+  if (curHeader_.type == http2::FrameType::CONTINUATION) {
+    if (++curBlockContinuationFrames_ > maxContinuationFrames_) {
+      if (fastRejectCounters_) {
+        return fastReject(&FastRejectCounters::continuationFlood,
+                          ErrorCode::PROTOCOL_ERROR);
+      }
+      goawayErrorMessage_ = folly::to<string>(
+          "GOAWAY error: too many CONTINUATION frames for stream=",
+          curHeader_.stream,
+          ", max=",
+          maxContinuationFrames_);
+      VLOG(4) << goawayErrorMessage_;
+      return ErrorCode::PROTOCOL_ERROR;
+    }
+  } else if (frameAffectsCompression(curHeader_.type)) {
+    // start of a new header block
+    curBlockContinuationFrames_ = 0;
+  }
   if (frameAffectsCompression(curHeader_.type) &&
       curHeaderBlock_.chainLength() + curHeader_.length >
           egressSettings_.getSetting(SettingsId::MAX_HEADER_LIST_SIZE, 0)) {
@@ -194,6 +398,10 @@ ErrorCode HTTP2Codec::parseFrame(folly::io::Cursor& cursor) {
     // block to keep the connection state consistent without consuming
     // memory, and fail just the request per the HTTP/2 spec (section
     // 10.3)
+    if (fastRejectCounters_) {
+      return fastReject(&FastRejectCounters::headerBlockOverflow,
+                        ErrorCode::PROTOCOL_ERROR);
+    }
     goawayErrorMessage_ = folly::to<string>(
         "Failing connection due to excessively large headers");
     LOG(ERROR) << goawayErrorMessage_;
@@ -558,8 +766,19 @@ HTTP2Codec::parseHeadersDecodeFrames(
         priority->streamDependency, priority->exclusive, priority->weight));
   }
 
-  headerCodec_.decodeStreaming(
-      headerCursor, curHeaderBlock_.chainLength(), this);
+  if (streamingHeaderCb_ != nullptr && parsingReq_ &&
+      !parsingDownstreamTrailers_) {
+    // Streaming mode: per-header delivery straight off the decoder, so
+    // regular headers never accumulate on the message
+    decodeInfo_.streamingCallback = streamingHeaderCb_;
+    decodeInfo_.streamingStreamID = curHeader_.stream;
+    headerCodec_.decodeStreaming(
+        headerCursor, curHeaderBlock_.chainLength(), this);
+  } else {
+    // Bulk mode: one onHeaderBlock call instead of a virtual onHeader per
+    // header, and the message reserves header capacity in a single shot
+    headerCodec_.decodeBulk(headerCursor, curHeaderBlock_.chainLength(), this);
+  }
   auto msg = std::move(decodeInfo_.msg);
   // Saving this in case we need to log it on error
   auto g = folly::makeGuard([this] { curHeaderBlock_.move(); });
@@ -677,6 +896,22 @@ void HTTP2Codec::onHeader(const HPACKHeaderName& name,
   }
 }
 
+void HTTP2Codec::onHeaderBlock(const std::vector<HPACKHeader>& headers) {
+  if (decodeInfo_.onHeaders(headers)) {
+    if (userAgent_.empty()) {
+      for (const auto& header : headers) {
+        if (header.name.getHeaderCode() == HTTP_HEADER_USER_AGENT) {
+          userAgent_ = header.value.toStdString();
+          break;
+        }
+      }
+    }
+  } else {
+    VLOG(4) << "dir=" << uint32_t(transportDirection_)
+            << decodeInfo_.parsingError << " codec=" << headerCodec_;
+  }
+}
+
 void HTTP2Codec::onHeadersComplete(HTTPHeaderSize decodedSize,
                                    bool /*acknowledge*/) {
   decodeInfo_.onHeadersComplete(decodedSize);
@@ -809,6 +1044,10 @@ ErrorCode HTTP2Codec::handleSettings(const std::deque<SettingPair>& settings) {
           tableSize = http2::kMaxHeaderTableSize;
         }
         headerCodec_.setEncoderHeaderTableSize(tableSize);
+        // The encoder owes the peer a dynamic table size update at the
+        // start of its next header block; precoded fragments would skip
+        // it, so hold them off until a full encode runs
+        precodedFragmentOk_ = false;
       } break;
       case SettingsId::ENABLE_PUSH:
         if ((setting.second != 0 && setting.second != 1) ||
@@ -848,6 +1087,7 @@ ErrorCode HTTP2Codec::handleSettings(const std::deque<SettingPair>& settings) {
           return ErrorCode::PROTOCOL_ERROR;
         }
         ingressSettings_.setSetting(SettingsId::MAX_FRAME_SIZE, setting.second);
+        maxSendFrameSize_ = setting.second;
         break;
       case SettingsId::MAX_HEADER_LIST_SIZE:
         break;
@@ -1159,6 +1399,23 @@ void HTTP2Codec::generateHeader(
     bool eom,
     HTTPHeaderSize* size,
     const folly::Optional<HTTPHeaders>& extraHeaders) {
+  if (precodedFragmentOk_ && !eom && !extraHeaders &&
+      transportDirection_ == TransportDirection::DOWNSTREAM &&
+      msg.isResponse() && msg.getStatusCode() == 103 &&
+      !msg.getHTTP2Priority() && isStreamIngressEgressAllowed(stream)) {
+    if (const auto* fragment =
+            getPrecodedEarlyHintsFragment(msg.getHeaders())) {
+      VLOG(4) << "generating precoded 103 HEADERS for stream=" << stream;
+      auto blockLen = fragment->computeChainDataLength();
+      generatePrecodedEarlyHints(writeBuf, stream, *fragment);
+      if (size) {
+        // literals without indexing are not compressed
+        size->uncompressed = blockLen;
+        size->compressed = blockLen;
+      }
+      return;
+    }
+  }
   generateHeaderImpl(writeBuf,
                      stream,
                      msg,
@@ -1285,6 +1542,8 @@ void HTTP2Codec::generateHeaderImpl(
   writeBuf.postallocate(headerSize);
   headerCodec_.encodeHTTP(msg, writeBuf, addDateToResponse_, extraHeaders);
   *size = headerCodec_.getEncodedSize();
+  // Any pending dynamic table size update went out with this block
+  precodedFragmentOk_ = true;
 
   IOBufQueue queue(IOBufQueue::cacheChainLength());
   auto chunkLen =
@@ -1397,6 +1656,7 @@ size_t HTTP2Codec::generateBody(folly::IOBufQueue& writeBuf,
                                 folly::Optional<uint8_t> padding,
                                 bool eom) {
   // todo: generate random padding for everything?
+  PROXYGEN_SDT(codec_egress, this, stream);
   size_t written = 0;
   if (!isStreamIngressEgressAllowed(stream)) {
     VLOG(2) << "Suppressing DATA for stream=" << stream
@@ -1406,17 +1666,25 @@ size_t HTTP2Codec::generateBody(folly::IOBufQueue& writeBuf,
   IOBufQueue queue(IOBufQueue::cacheChainLength());
   queue.append(std::move(chain));
   size_t maxFrameSize = maxSendFrameSize();
-  while (queue.chainLength() > maxFrameSize) {
-    auto chunk = queue.split(maxFrameSize);
-    written += generateHeaderCallbackWrapper(
-        stream,
-        http2::FrameType::DATA,
-        http2::writeData(writeBuf,
-                         std::move(chunk),
-                         stream,
-                         padding,
-                         false,
-                         reuseIOBufHeadroomForData_));
+  if (queue.chainLength() > maxFrameSize) {
+    // Multiple frames: lay out all the frame headers in one contiguous
+    // buffer instead of fragmenting the egress chain with a small IOBuf
+    // per frame.
+    uint64_t remaining = queue.chainLength();
+    written =
+        http2::writeDataFrames(writeBuf, queue, stream, maxFrameSize, padding,
+                               eom);
+    if (callback_) {
+      const size_t overhead =
+          http2::kFrameHeaderSize + (padding ? 1 + *padding : 0);
+      while (remaining > 0) {
+        const size_t chunk = std::min<uint64_t>(remaining, maxFrameSize);
+        generateHeaderCallbackWrapper(
+            stream, http2::FrameType::DATA, overhead + chunk);
+        remaining -= chunk;
+      }
+    }
+    return written;
   }
 
   return written + generateHeaderCallbackWrapper(
@@ -1447,6 +1715,11 @@ size_t HTTP2Codec::generateTrailers(folly::IOBufQueue& writeBuf,
                                     StreamID stream,
                                     const HTTPHeaders& trailers) {
   VLOG(4) << "generating TRAILERS for stream=" << stream;
+  if (precodedFragmentOk_) {
+    if (const auto* fragment = getPrecodedGrpcStatusFragment(trailers)) {
+      return generatePrecodedTrailers(writeBuf, stream, *fragment);
+    }
+  }
   std::vector<compress::Header> allHeaders;
   CodecUtil::appendHeaders(trailers, allHeaders, HTTP_HEADER_NONE);
 
@@ -1476,9 +1749,74 @@ size_t HTTP2Codec::generateTrailers(folly::IOBufQueue& writeBuf,
     generateContinuation(writeBuf, queue, stream, remainingFrameSize);
   }
 
+  // The encoder has emitted a block, flushing any pending dynamic table
+  // size update; precoded fragments are safe to replay again
+  precodedFragmentOk_ = true;
+
   return size.compressed;
 }
 
+size_t HTTP2Codec::generatePrecodedTrailers(folly::IOBufQueue& writeBuf,
+                                            StreamID stream,
+                                            const folly::IOBuf& fragment) {
+  uint8_t headerSize = http2::kFrameHeaderSize;
+  auto frameHeader = writeBuf.preallocate(headerSize, kDefaultGrowth);
+  writeBuf.postallocate(headerSize);
+  writeBuf.append(fragment.clone());
+  return generateHeaderCallbackWrapper(
+      stream,
+      http2::FrameType::HEADERS,
+      http2::writeHeaders((uint8_t*)frameHeader.first,
+                          frameHeader.second,
+                          writeBuf,
+                          fragment.computeChainDataLength(),
+                          stream,
+                          folly::none,
+                          http2::kNoPadding,
+                          true /*eom*/,
+                          true /*endHeaders*/));
+}
+
+size_t HTTP2Codec::generatePrecodedEarlyHints(folly::IOBufQueue& writeBuf,
+                                              StreamID stream,
+                                              const folly::IOBuf& fragment) {
+  uint8_t headerSize = http2::kFrameHeaderSize;
+  auto frameHeader = writeBuf.preallocate(headerSize, kDefaultGrowth);
+  writeBuf.postallocate(headerSize);
+  writeBuf.append(fragment.clone());
+  return generateHeaderCallbackWrapper(
+      stream,
+      http2::FrameType::HEADERS,
+      http2::writeHeaders((uint8_t*)frameHeader.first,
+                          frameHeader.second,
+                          writeBuf,
+                          fragment.computeChainDataLength(),
+                          stream,
+                          folly::none,
+                          http2::kNoPadding,
+                          false /*eom*/,
+                          true /*endHeaders*/));
+}
+
+size_t HTTP2Codec::generateBodyWithTrailers(folly::IOBufQueue& writeBuf,
+                                            StreamID stream,
+                                            std::unique_ptr<folly::IOBuf> chain,
+                                            folly::Optional<uint8_t> padding,
+                                            const HTTPHeaders& trailers) {
+  if (!isStreamIngressEgressAllowed(stream)) {
+    VLOG(2) << "Suppressing DATA+trailers for stream=" << stream
+            << " ingressGoawayAck_=" << ingressGoawayAck_;
+    return 0;
+  }
+  size_t written = 0;
+  if (chain) {
+    // The trailing HEADERS frame carries END_STREAM, not the DATA frame
+    written = generateBody(
+        writeBuf, stream, std::move(chain), padding, false /*eom*/);
+  }
+  return written + generateTrailers(writeBuf, stream, trailers);
+}
+
 size_t HTTP2Codec::generateEOM(folly::IOBufQueue& writeBuf, StreamID stream) {
   VLOG(4) << "sending EOM for stream=" << stream;
   upgradedStreams_.erase(stream);
@@ -1577,6 +1915,11 @@ size_t HTTP2Codec::generateGoaway(folly::IOBufQueue& writeBuf,
   }
 
   auto code = http2::errorCodeToGoaway(statusCode);
+  if (fastRejectFired_) {
+    // Fast-rejected peers get a fixed-shape GOAWAY with no debug data;
+    // nothing attacker-paced gets serialized
+    debugData.reset();
+  }
   return generateHeaderCallbackWrapper(
       0,
       http2::FrameType::GOAWAY,
@@ -1599,6 +1942,11 @@ size_t HTTP2Codec::generatePingRequest(folly::IOBufQueue& writeBuf,
 
 size_t HTTP2Codec::generatePingReply(folly::IOBufQueue& writeBuf,
                                      uint64_t data) {
+  if (coalesceControlFrames_) {
+    VLOG(4) << "Deferring ping reply with data=" << data;
+    pendingPingAcks_.push_back(data);
+    return 0;
+  }
   VLOG(4) << "Generating ping reply with data=" << data;
   return generateHeaderCallbackWrapper(
       0,
@@ -1661,6 +2009,23 @@ size_t HTTP2Codec::generateSettings(folly::IOBufQueue& writeBuf) {
   }
   VLOG(4) << getTransportDirectionString(getTransportDirection())
           << " generating " << (unsigned)settings.size() << " settings";
+  if (settingsBufferCache_) {
+    auto& cache = *settingsBufferCache_;
+    if (!cache.frame || cache.settings != settings) {
+      // First connection with these settings serializes the frame;
+      // every later one clones it.  The bookkeeping above (table size
+      // in flight, max uncompressed) still ran for this codec.
+      folly::IOBufQueue frameBuf{folly::IOBufQueue::cacheChainLength()};
+      http2::writeSettings(frameBuf, settings);
+      cache.frame = frameBuf.move();
+      cache.frame->coalesce();
+      cache.settings = std::move(settings);
+    }
+    writeBuf.append(cache.frame->clone());
+    return generateHeaderCallbackWrapper(0,
+                                         http2::FrameType::SETTINGS,
+                                         cache.frame->computeChainDataLength());
+  }
   return generateHeaderCallbackWrapper(
       0, http2::FrameType::SETTINGS, http2::writeSettings(writeBuf, settings));
 }
@@ -1693,6 +2058,12 @@ void HTTP2Codec::requestUpgrade(HTTPMessage& request) {
 }
 
 size_t HTTP2Codec::generateSettingsAck(folly::IOBufQueue& writeBuf) {
+  if (coalesceControlFrames_) {
+    VLOG(4) << getTransportDirectionString(getTransportDirection())
+            << " deferring settings ack";
+    pendingSettingsAcks_++;
+    return 0;
+  }
   VLOG(4) << getTransportDirectionString(getTransportDirection())
           << " generating settings ack";
   return generateHeaderCallbackWrapper(
@@ -1709,12 +2080,88 @@ size_t HTTP2Codec::generateWindowUpdate(folly::IOBufQueue& writeBuf,
             << " ingressGoawayAck_=" << ingressGoawayAck_;
     return 0;
   }
+  if (coalesceControlFrames_) {
+    pendingWindowUpdates_[stream] += delta;
+    return 0;
+  }
   return generateHeaderCallbackWrapper(
       stream,
       http2::FrameType::WINDOW_UPDATE,
       http2::writeWindowUpdate(writeBuf, stream, delta));
 }
 
+bool HTTP2Codec::hasDeferredFrames() const {
+  if (pendingSettingsAcks_ > 0 || !pendingPingAcks_.empty()) {
+    return true;
+  }
+  // Sub-threshold stream deltas alone don't warrant a flush of their own;
+  // they ride along with the next one
+  const uint64_t thresholdBytes = windowUpdateCoalesceThreshold_ *
+      egressSettings_.getSetting(SettingsId::INITIAL_WINDOW_SIZE,
+                                 http2::kInitialWindow);
+  for (const auto& pending : pendingWindowUpdates_) {
+    if (pending.first == 0 || pending.second >= thresholdBytes) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t HTTP2Codec::generateDeferredFrames(folly::IOBufQueue& writeBuf) {
+  size_t bytes = 0;
+  if (!pendingWindowUpdates_.empty()) {
+    const uint64_t thresholdBytes = windowUpdateCoalesceThreshold_ *
+        egressSettings_.getSetting(SettingsId::INITIAL_WINDOW_SIZE,
+                                   http2::kInitialWindow);
+    // The connection-level update goes first so the peer unblocks the
+    // session window before any stream windows
+    auto connIt = pendingWindowUpdates_.find(0);
+    if (connIt != pendingWindowUpdates_.end()) {
+      bytes += generateHeaderCallbackWrapper(
+          0,
+          http2::FrameType::WINDOW_UPDATE,
+          http2::writeWindowUpdate(
+              writeBuf, 0, static_cast<uint32_t>(connIt->second)));
+      pendingWindowUpdates_.erase(connIt);
+    }
+    for (auto it = pendingWindowUpdates_.begin();
+         it != pendingWindowUpdates_.end();) {
+      if (!isStreamIngressEgressAllowed(it->first)) {
+        // stream went away since the delta was queued
+        it = pendingWindowUpdates_.erase(it);
+        continue;
+      }
+      if (it->second < thresholdBytes) {
+        // keep accumulating until the delta is worth a frame
+        it++;
+        continue;
+      }
+      VLOG(4) << "generating coalesced window update for stream=" << it->first
+              << ": Processed " << it->second << " bytes";
+      bytes += generateHeaderCallbackWrapper(
+          it->first,
+          http2::FrameType::WINDOW_UPDATE,
+          http2::writeWindowUpdate(
+              writeBuf, it->first, static_cast<uint32_t>(it->second)));
+      it = pendingWindowUpdates_.erase(it);
+    }
+  }
+  // Each SETTINGS and each PING still gets its own ack, as the spec
+  // requires; only their emission was deferred to this flush
+  for (; pendingSettingsAcks_ > 0; pendingSettingsAcks_--) {
+    bytes += generateHeaderCallbackWrapper(
+        0, http2::FrameType::SETTINGS, http2::writeSettingsAck(writeBuf));
+  }
+  for (auto data : pendingPingAcks_) {
+    bytes += generateHeaderCallbackWrapper(
+        0,
+        http2::FrameType::PING,
+        http2::writePing(writeBuf, data, true /* ack */));
+  }
+  pendingPingAcks_.clear();
+  return bytes;
+}
+
 size_t HTTP2Codec::generatePriority(folly::IOBufQueue& writeBuf,
                                     StreamID stream,
                                     const HTTPMessage::HTTP2Priority& pri) {
@@ -1767,8 +2214,26 @@ size_t HTTP2Codec::generateCertificate(folly::IOBufQueue& writeBuf,
          http2::writeCertificate(writeBuf, certId, queue.move(), false);
 }
 
+ErrorCode HTTP2Codec::fastReject(uint64_t FastRejectCounters::*counter,
+                                 ErrorCode code) {
+  fastRejectCounters_->*counter += 1;
+  fastRejectFired_ = true;
+  return code;
+}
+
 bool HTTP2Codec::checkConnectionError(ErrorCode err, const folly::IOBuf* buf) {
   if (err != ErrorCode::NO_ERROR) {
+    if (fastRejectFired_) {
+      // Known attack signature: the counter was already bumped, skip
+      // the per-error logging and description machinery
+      if (callback_) {
+        HTTPException ex(HTTPException::Direction::INGRESS_AND_EGRESS,
+                         "fast reject");
+        ex.setCodecStatusCode(err);
+        callback_->onError(0, ex, false);
+      }
+      return true;
+    }
     LOG(ERROR) << "Connection error " << getErrorCodeString(err)
                << " with ingress=";
     VLOG(3) << IOBufPrinter::printHexFolly(buf, true);
@@ -16,11 +16,27 @@
 #include <proxygen/lib/http/codec/HeaderDecodeInfo.h>
 #include <proxygen/lib/http/codec/compress/HPACKCodec.h>
 
+#include <algorithm>
 #include <bitset>
 #include <set>
+#include <unordered_map>
 
 namespace proxygen {
 
+/**
+ * A serialized SETTINGS frame shared across the connections of one
+ * acceptor, keyed by the exact settings it encodes.  Every accepted
+ * connection advertises identical settings, so generateSettings() can
+ * clone one immutable buffer instead of re-encoding the same frame per
+ * accept; if the egress settings ever diverge from the cached key the
+ * frame is re-serialized and the cache refreshed.  Not thread-safe -
+ * share only among codecs on the same worker thread.
+ */
+struct HTTP2SettingsBufferCache {
+  std::deque<SettingPair> settings;
+  std::unique_ptr<folly::IOBuf> frame;
+};
+
 /**
  * An implementation of the framing layer for HTTP/2. Instances of this
  * class must not be used from multiple threads concurrently.
@@ -31,6 +47,7 @@ class HTTP2Codec
  public:
   void onHeader(const HPACKHeaderName& name,
                 const folly::fbstring& value) override;
+  void onHeaderBlock(const std::vector<HPACKHeader>& headers) override;
   void onHeadersComplete(HTTPHeaderSize decodedSize, bool acknowledge) override;
   void onDecodeError(HPACK::DecodeError decodeError) override;
 
@@ -85,6 +102,25 @@ class HTTP2Codec
   size_t generateTrailers(folly::IOBufQueue& writeBuf,
                           StreamID stream,
                           const HTTPHeaders& trailers) override;
+
+  /**
+   * Emits the final DATA frame and the trailing HEADERS frame in one
+   * call into the same write buffer, for protocols like gRPC that
+   * terminate every response with trailers.  The DATA frame is written
+   * without END_STREAM; the trailers carry it.
+   *
+   * Trailers consisting of exactly one grpc-status header with value
+   * 0-16 are served from a table of pre-encoded HPACK fragments
+   * (literals without indexing, so they never touch the dynamic table)
+   * instead of re-entering the header codec; generateTrailers() uses
+   * the same fast path.
+   */
+  size_t generateBodyWithTrailers(folly::IOBufQueue& writeBuf,
+                                  StreamID stream,
+                                  std::unique_ptr<folly::IOBuf> chain,
+                                  folly::Optional<uint8_t> padding,
+                                  const HTTPHeaders& trailers);
+
   size_t generateEOM(folly::IOBufQueue& writeBuf, StreamID stream) override;
   size_t generateRstStream(folly::IOBufQueue& writeBuf,
                            StreamID stream,
@@ -103,6 +139,8 @@ class HTTP2Codec
   size_t generateWindowUpdate(folly::IOBufQueue& writeBuf,
                               StreamID stream,
                               uint32_t delta) override;
+  bool hasDeferredFrames() const override;
+  size_t generateDeferredFrames(folly::IOBufQueue& writeBuf) override;
   size_t generatePriority(folly::IOBufQueue& writeBuf,
                           StreamID stream,
                           const HTTPMessage::HTTP2Priority& pri) override;
@@ -190,6 +228,93 @@ class HTTP2Codec
     validateHeaders_ = validate;
   }
 
+  /**
+   * Default cap on the number of CONTINUATION frames accepted per header
+   * block.  A compliant peer needs one CONTINUATION per MAX_FRAME_SIZE
+   * of compressed headers, so well-formed jumbo trailers stay far under
+   * this; abusive clients shredding a block into hundreds of tiny
+   * frames hit it and get a connection error.
+   */
+  static constexpr uint32_t kDefaultMaxContinuationFrames = 64;
+
+  void setMaxContinuationFrames(uint32_t max) {
+    maxContinuationFrames_ = max;
+  }
+
+  /**
+   * Counters for connection errors rejected via the fast path, one per
+   * known attack signature; see enableFastReject().  Meant to be shared
+   * by all codecs of one listener (same worker thread), bumped with
+   * plain increments.
+   */
+  struct FastRejectCounters {
+    uint64_t badPreface{0};
+    uint64_t oversizedFrame{0};
+    uint64_t continuationMisuse{0};
+    uint64_t continuationFlood{0};
+    uint64_t headerBlockOverflow{0};
+  };
+
+  /**
+   * Fast-reject mode for malformed-frame floods.  Connection errors
+   * matching known attack signatures (bad connection preface, frame
+   * length over the advertised maximum, CONTINUATION misuse or floods,
+   * header blocks past the list-size limit) skip the per-error string
+   * formatting, exception description and log lines and surface a
+   * shared static description instead; the resulting GOAWAY carries no
+   * debug data, so the egress frame is a fixed-shape template.  Each
+   * rejection bumps the matching per-listener counter, keeping floods
+   * visible without log volume.  Errors outside the signature set take
+   * the regular descriptive path.  The counters object must outlive
+   * the codec.
+   */
+  void enableFastReject(FastRejectCounters* counters) {
+    fastRejectCounters_ = counters;
+  }
+
+  /**
+   * Streaming header delivery for ingress request header blocks; see
+   * HTTPCodec::StreamingHeaderCallback.  Trailers and pushed/response
+   * blocks keep the regular buffered path.
+   */
+  void setStreamingHeaderCallback(StreamingHeaderCallback* cb) override {
+    streamingHeaderCb_ = cb;
+  }
+
+  /**
+   * Default fraction of the advertised stream receive window a deferred
+   * per-stream WINDOW_UPDATE must reach before it is emitted.
+   */
+  static constexpr double kDefaultWindowUpdateCoalesceThreshold = 0.25;
+
+  /**
+   * Coalesce control frames: generateWindowUpdate(), generateSettingsAck()
+   * and generatePingReply() buffer their frames instead of writing them,
+   * and generateDeferredFrames() emits the merged result at the next
+   * egress flush - the connection WINDOW_UPDATE first, then per-stream
+   * updates whose accumulated delta has reached windowUpdateThreshold of
+   * the advertised stream window, then the pending acks.  The threshold is
+   * clamped to [0, 0.5]; transactions ack at half their window, so a
+   * larger value could withhold those acks indefinitely.
+   */
+  void enableControlFrameCoalescing(
+      double windowUpdateThreshold = kDefaultWindowUpdateCoalesceThreshold) {
+    coalesceControlFrames_ = true;
+    windowUpdateCoalesceThreshold_ =
+        std::min(std::max(windowUpdateThreshold, 0.0), 0.5);
+  }
+
+  /**
+   * Share a pre-serialized SETTINGS frame with other codecs advertising
+   * the same egress settings; see HTTP2SettingsBufferCache.  The first
+   * generateSettings() populates the cache and later ones clone it.
+   */
+  void setSettingsBufferCache(std::shared_ptr<HTTP2SettingsBufferCache> cache) {
+    settingsBufferCache_ = std::move(cache);
+  }
+
+  bool reset() override;
+
  private:
   size_t splitCompressed(size_t compressed,
                          uint32_t remainingFrameSize,
@@ -209,6 +334,26 @@ class HTTP2Codec
                      std::vector<compress::Header>& allHeaders,
                      HTTPHeaderSize* size);
 
+  /**
+   * Wraps a pre-encoded HPACK fragment in a HEADERS frame carrying
+   * END_STREAM and END_HEADERS, bypassing the header codec.  See
+   * generateBodyWithTrailers().
+   */
+  size_t generatePrecodedTrailers(folly::IOBufQueue& writeBuf,
+                                  StreamID stream,
+                                  const folly::IOBuf& fragment);
+
+  /**
+   * Wraps a pre-encoded HPACK fragment for a 103 Early Hints block in a
+   * HEADERS frame with END_HEADERS but no END_STREAM.  generateHeader()
+   * routes eligible 103 responses here, serving the fragment from a
+   * process-wide per-hint-block cache instead of re-entering the header
+   * codec on every response.
+   */
+  size_t generatePrecodedEarlyHints(folly::IOBufQueue& writeBuf,
+                                    StreamID stream,
+                                    const folly::IOBuf& fragment);
+
   size_t generateHeaderCallbackWrapper(StreamID stream,
                                        http2::FrameType type,
                                        size_t length);
@@ -260,11 +405,15 @@ class HTTP2Codec
   ErrorCode handleEndStream();
   ErrorCode checkNewStream(uint32_t stream, bool trailersAllowed);
   bool checkConnectionError(ErrorCode, const folly::IOBuf* buf);
+  // Bumps the signature's counter and marks the error as fast-rejected;
+  // see enableFastReject().  Only call with fastRejectCounters_ set.
+  ErrorCode fastReject(uint64_t FastRejectCounters::*counter, ErrorCode code);
   ErrorCode handleSettings(const std::deque<SettingPair>& settings);
   void handleSettingsAck();
   size_t maxSendFrameSize() const {
-    return (uint32_t)ingressSettings_.getSetting(
-        SettingsId::MAX_FRAME_SIZE, http2::kMaxFramePayloadLengthMin);
+    // cached copy of the peer's MAX_FRAME_SIZE; only SETTINGS receipt can
+    // change it, so per-frame callers skip the settings lookup entirely
+    return maxSendFrameSize_;
   }
   uint32_t maxRecvFrameSize() const {
     return (uint32_t)egressSettings_.getSetting(
@@ -282,6 +431,8 @@ class HTTP2Codec
   // Current frame state
   http2::FrameHeader curHeader_;
   StreamID expectedContinuationStream_{0};
+  uint32_t curBlockContinuationFrames_{0};
+  uint32_t maxContinuationFrames_{kDefaultMaxContinuationFrames};
   // Used for parsing PUSH_PROMISE+CONTINUATION
   folly::Optional<StreamID> promisedStream_;
   bool parsingReq_{false};
@@ -306,6 +457,9 @@ class HTTP2Codec
       {SettingsId::MAX_FRAME_SIZE, 16384},
       {SettingsId::MAX_HEADER_LIST_SIZE, 1 << 17}, // same as SPDYCodec
   };
+  std::shared_ptr<HTTP2SettingsBufferCache> settingsBufferCache_;
+  // Mirrors ingress MAX_FRAME_SIZE; see maxSendFrameSize()
+  uint32_t maxSendFrameSize_{http2::kMaxFramePayloadLengthMin};
 #ifndef NDEBUG
   uint64_t receivedFrameCount_{0};
 #endif
@@ -327,15 +481,35 @@ class HTTP2Codec
   folly::Optional<uint32_t> pendingTableMaxSize_;
   bool reuseIOBufHeadroomForData_{true};
 
+  // Fast-reject state; see enableFastReject().  fastRejectFired_ marks
+  // the pending connection error as a known attack signature so the
+  // error and GOAWAY paths skip their string machinery.
+  FastRejectCounters* fastRejectCounters_{nullptr};
+  bool fastRejectFired_{false};
+
+  // Control frame coalescing state; see enableControlFrameCoalescing()
+  bool coalesceControlFrames_{false};
+  double windowUpdateCoalesceThreshold_{kDefaultWindowUpdateCoalesceThreshold};
+  std::unordered_map<StreamID, uint64_t> pendingWindowUpdates_;
+  uint32_t pendingSettingsAcks_{0};
+  std::vector<uint64_t> pendingPingAcks_;
+
   // True if last parsed HEADERS frame was trailers.
   // Reset only when HEADERS frame is parsed, thus
   // remains unchanged and used during CONTINUATION frame
   // parsing as well.
   // Applies only to DOWNSTREAM, for UPSTREAM we use
+  // Precoded fragments (trailers, early hints) are only replayable
+  // while the encoder does not owe the peer a dynamic table size
+  // update; cleared when the egress encoder table size changes, set
+  // again once a full header encode has flushed the update.
+  bool precodedFragmentOk_{true};
+
   // diffrent heuristic - lack of status code.
   bool parsingDownstreamTrailers_{false};
   bool addDateToResponse_{true};
   bool validateHeaders_{true};
+  StreamingHeaderCallback* streamingHeaderCb_{nullptr};
 
   // CONTINUATION frame can follow either HEADERS or PUSH_PROMISE frames.
   // Keeps frame type of iniating frame of header block.
@@ -387,6 +387,32 @@ size_t writeData(folly::IOBufQueue& writeBuf,
                  bool endStream,
                  bool reuseIOBufHeadroom) noexcept;
 
+/**
+ * Generate a run of DATA frames for one stream, splitting 'data' at
+ * maxFrameSize boundaries.  All frame headers -- plus any payload chunk
+ * small enough that copying it beats another iovec entry at writev time --
+ * are laid out into one pre-sized contiguous buffer; larger chunks are
+ * chained zero-copy.  Compared with calling writeData() in a loop this
+ * keeps the egress chain to one IOBuf node per large chunk instead of
+ * two or more per frame.
+ *
+ * @param writeBuf The output queue to write to.
+ * @param data The body data to write out; consumed by this call.
+ * @param stream The stream identifier of the DATA frames.
+ * @param maxFrameSize Maximum payload length per frame; must not exceed
+ *                     the peer's MAX_FRAME_SIZE setting.
+ * @param padding If not kNoPadding, adds 1 byte pad len and @padding pad
+ *                bytes to every frame.
+ * @param endStream True iff the final frame ends the stream.
+ * @return The number of bytes written to writeBuf.
+ */
+size_t writeDataFrames(folly::IOBufQueue& writeBuf,
+                       folly::IOBufQueue& data,
+                       uint32_t stream,
+                       size_t maxFrameSize,
+                       folly::Optional<uint8_t> padding,
+                       bool endStream) noexcept;
+
 /**
  * Generate an entire HEADERS frame, including the common frame header. The
  * combined length of the data buffer and the padding and priority fields MUST
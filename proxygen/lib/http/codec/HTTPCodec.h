@@ -358,6 +358,43 @@ class HTTPCodec {
     }
   };
 
+  /**
+   * Opt-in receiver for streaming header delivery.  When installed via
+   * setStreamingHeaderCallback on a codec that supports it, regular
+   * (non-pseudo) ingress headers of non-trailer blocks are delivered here
+   * one at a time as they decode, instead of being accumulated on the
+   * HTTPMessage.  The message passed to Callback::onHeadersComplete then
+   * carries only the request line / pseudo headers and framing-relevant
+   * headers (e.g. content-length), bounding the decoded message footprint
+   * for very large header blocks.  Header validation and error handling
+   * are unchanged: a bad header still fails the block after any earlier
+   * headers were delivered, so consumers must be prepared to discard
+   * state for a stream that subsequently errors.
+   */
+  class StreamingHeaderCallback {
+   public:
+    virtual ~StreamingHeaderCallback() {
+    }
+
+    /**
+     * One decoded header, delivered in block order.  The underlying
+     * storage is only valid for the duration of the call.
+     */
+    virtual void onIngressHeader(StreamID stream,
+                                 folly::StringPiece name,
+                                 folly::StringPiece value) noexcept = 0;
+
+    /**
+     * Invoked once per header block as soon as everything needed for
+     * routing is known: after the pseudo headers, before the bulk of the
+     * regular headers.  The message carries method/path/scheme/authority
+     * but is not yet fully verified.
+     */
+    virtual void onRoutingHeadersComplete(
+        StreamID /*stream*/, const HTTPMessage& /*partialMsg*/) noexcept {
+    }
+  };
+
   virtual ~HTTPCodec() {
   }
 
@@ -417,6 +454,14 @@ class HTTPCodec {
    */
   virtual void setCallback(Callback* callback) = 0;
 
+  /**
+   * Install a streaming header receiver; see StreamingHeaderCallback.
+   * Codecs without streaming support ignore this and keep delivering
+   * complete header blocks.
+   */
+  virtual void setStreamingHeaderCallback(StreamingHeaderCallback*) {
+  }
+
   /**
    * Check whether the codec still has at least one HTTP
    * stream to parse.
@@ -468,6 +513,18 @@ class HTTPCodec {
    */
   virtual bool isReusable() const = 0;
 
+  /**
+   * Restore the codec to its freshly-constructed state so the instance
+   * itself can be reused for a new connection, keeping expensive
+   * allocations (e.g. compression tables) warm. Returns false if this
+   * codec does not support instance reuse (the default), in which case
+   * it must be destroyed instead. Not to be confused with isReusable(),
+   * which is about reusing the underlying transport.
+   */
+  virtual bool reset() {
+    return false;
+  }
+
   /**
    * Returns true if this codec is in a state where it accepting new
    * requests but will soon begin to reject new requests. For SPDY and
@@ -670,6 +727,25 @@ class HTTPCodec {
     return 0;
   }
 
+  /**
+   * Returns true iff the codec has buffered control frames (e.g., coalesced
+   * window updates or acks) waiting for generateDeferredFrames().  A caller
+   * that sees a generate call return zero bytes should still schedule a
+   * flush when this is true.
+   */
+  virtual bool hasDeferredFrames() const {
+    return false;
+  }
+
+  /**
+   * Write out any control frames the codec has buffered for coalescing.
+   * Callers invoke this at the start of an egress flush so the deferred
+   * frames ride along with the data.  Returns the number of bytes written.
+   */
+  virtual size_t generateDeferredFrames(folly::IOBufQueue& /* writeBuf */) {
+    return 0;
+  }
+
   /*
    * Generate a PRIORITY message, if supported
    */
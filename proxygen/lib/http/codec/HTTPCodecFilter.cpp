@@ -333,6 +333,15 @@ size_t PassThroughHTTPCodecFilter::generateWindowUpdate(folly::IOBufQueue& buf,
   return call_->generateWindowUpdate(buf, stream, delta);
 }
 
+bool PassThroughHTTPCodecFilter::hasDeferredFrames() const {
+  return call_->hasDeferredFrames();
+}
+
+size_t PassThroughHTTPCodecFilter::generateDeferredFrames(
+    folly::IOBufQueue& buf) {
+  return call_->generateDeferredFrames(buf);
+}
+
 size_t PassThroughHTTPCodecFilter::generatePriority(
     folly::IOBufQueue& writeBuf,
     StreamID stream,
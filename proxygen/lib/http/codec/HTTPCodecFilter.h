@@ -220,6 +220,10 @@ class PassThroughHTTPCodecFilter : public HTTPCodecFilter {
                               StreamID stream,
                               uint32_t delta) override;
 
+  bool hasDeferredFrames() const override;
+
+  size_t generateDeferredFrames(folly::IOBufQueue& writeBuf) override;
+
   size_t generatePriority(folly::IOBufQueue& writeBuf,
                           StreamID stream,
                           const HTTPMessage::HTTP2Priority& pri) override;
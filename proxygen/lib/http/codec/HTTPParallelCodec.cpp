@@ -29,6 +29,17 @@ HTTPParallelCodec::HTTPParallelCodec(TransportDirection direction)
   }
 }
 
+void HTTPParallelCodec::resetParallelCodecState() {
+  nextEgressStreamID_ =
+      (transportDirection_ == TransportDirection::DOWNSTREAM) ? 2 : 1;
+  lastStreamID_ = 0;
+  callback_ = nullptr;
+  ingressGoawayAck_ = std::numeric_limits<uint32_t>::max();
+  egressGoawayAck_ = std::numeric_limits<uint32_t>::max();
+  goawayErrorMessage_.clear();
+  sessionClosing_ = ClosingState::OPEN;
+}
+
 HTTPCodec::StreamID HTTPParallelCodec::createStream() {
   auto ret = nextEgressStreamID_;
   nextEgressStreamID_ += 2;
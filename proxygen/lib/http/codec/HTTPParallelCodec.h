@@ -95,6 +95,10 @@ class HTTPParallelCodec : public HTTPCodec {
   }
 
  protected:
+  // Restore the base codec state to its freshly-constructed values, for
+  // subclasses implementing HTTPCodec::reset()
+  void resetParallelCodecState();
+
   TransportDirection transportDirection_;
   StreamID nextEgressStreamID_;
   StreamID lastStreamID_{0};
@@ -9,56 +9,87 @@
 #include <proxygen/lib/http/codec/HTTPSettings.h>
 
 #include <algorithm>
+#include <folly/lang/Bits.h>
 
 namespace proxygen {
 
 void HTTPSettings::setSetting(SettingsId id, SettingsValue val) {
-  auto iter = getSettingIter(id);
-  if (iter != settings_.end()) {
-    (*iter).value = val;
+  auto idx = standardIndex(id);
+  if (idx >= 0) {
+    standard_[idx].value = val;
+    standardSetMask_ |= uint8_t(1 << idx);
   } else {
-    settings_.emplace_back(id, val);
+    auto iter = std::find_if(overflow_.begin(),
+                             overflow_.end(),
+                             [&](HTTPSetting const& s) { return s.id == id; });
+    if (iter != overflow_.end()) {
+      iter->value = val;
+    } else {
+      overflow_.emplace_back(id, val);
+    }
   }
+  allSettingsDirty_ = true;
 }
 
 void HTTPSettings::unsetSetting(SettingsId id) {
-  auto iter = getSettingIter(id);
-  if (iter != settings_.end()) {
-    *iter = settings_.back();
-    settings_.pop_back();
+  auto idx = standardIndex(id);
+  if (idx >= 0) {
+    standardSetMask_ &= uint8_t(~(1 << idx));
+  } else {
+    auto iter = std::find_if(overflow_.begin(),
+                             overflow_.end(),
+                             [&](HTTPSetting const& s) { return s.id == id; });
+    if (iter != overflow_.end()) {
+      *iter = overflow_.back();
+      overflow_.pop_back();
+    }
   }
+  allSettingsDirty_ = true;
 }
 
 const HTTPSetting* HTTPSettings::getSetting(SettingsId id) const {
-  auto iter = getSettingConstIter(id);
-  if (iter != settings_.end()) {
+  auto idx = standardIndex(id);
+  if (idx >= 0) {
+    return (standardSetMask_ & (1 << idx)) ? &standard_[idx] : nullptr;
+  }
+  auto iter = std::find_if(overflow_.begin(),
+                           overflow_.end(),
+                           [&](HTTPSetting const& s) { return s.id == id; });
+  if (iter != overflow_.end()) {
     return &(*iter);
-  } else {
-    return nullptr;
   }
+  return nullptr;
 }
 
 SettingsValue HTTPSettings::getSetting(SettingsId id,
                                        SettingsValue defaultValue) const {
-  auto iter = getSettingConstIter(id);
-  if (iter != settings_.end()) {
-    return (*iter).value;
-  } else {
-    return defaultValue;
-  }
+  auto setting = getSetting(id);
+  return setting ? setting->value : defaultValue;
+}
+
+std::size_t HTTPSettings::getNumSettings() const {
+  return folly::popcount(standardSetMask_) + overflow_.size();
 }
 
-std::vector<HTTPSetting>::iterator HTTPSettings::getSettingIter(SettingsId id) {
-  return std::find_if(settings_.begin(),
-                      settings_.end(),
-                      [&](HTTPSetting const& s) { return s.id == id; });
+const std::vector<HTTPSetting>& HTTPSettings::getAllSettings() {
+  if (allSettingsDirty_) {
+    allSettings_.clear();
+    allSettings_.reserve(getNumSettings());
+    for (size_t i = 0; i < kNumStandardSettings; i++) {
+      if (standardSetMask_ & (1 << i)) {
+        allSettings_.push_back(standard_[i]);
+      }
+    }
+    allSettings_.insert(allSettings_.end(), overflow_.begin(), overflow_.end());
+    allSettingsDirty_ = false;
+  }
+  return allSettings_;
 }
 
-std::vector<HTTPSetting>::const_iterator HTTPSettings::getSettingConstIter(
-    SettingsId id) const {
-  return std::find_if(settings_.begin(),
-                      settings_.end(),
-                      [&](HTTPSetting const& s) { return s.id == id; });
+void HTTPSettings::clearSettings() {
+  standardSetMask_ = 0;
+  overflow_.clear();
+  allSettingsDirty_ = true;
 }
 
 } // namespace proxygen
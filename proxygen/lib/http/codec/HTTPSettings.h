@@ -8,15 +8,17 @@
 
 #pragma once
 
+#include <array>
 #include <initializer_list>
 #include <proxygen/lib/http/codec/SettingsId.h>
 #include <vector>
 
 /*
- * HTTPSettings are stored in an underlying vector, presumably to limit the
- * amount of memory required.  Access various settings thus generally involves
- * iterating over available entries.  Removing entries does not require any
- * shifts.
+ * The standard settings (the small, dense ID space from RFC 7540 plus the
+ * registered extensions we speak) live in a fixed-index array so getSetting
+ * is O(1) on the per-frame paths that consult them; anything else goes to a
+ * small overflow vector searched linearly.  getAllSettings materializes a
+ * flat list on demand, cached until the next mutation.
  */
 
 namespace proxygen {
@@ -34,17 +36,13 @@ struct HTTPSetting {
 class HTTPSettings {
  public:
   // HTTP/2 Defaults
-  HTTPSettings()
-      : settings_({{SettingsId::HEADER_TABLE_SIZE, 4096},
-                   {SettingsId::ENABLE_PUSH, 1},
-                   {SettingsId::MAX_FRAME_SIZE, 16384}}) {
+  HTTPSettings() {
+    setSetting(SettingsId::HEADER_TABLE_SIZE, 4096);
+    setSetting(SettingsId::ENABLE_PUSH, 1);
+    setSetting(SettingsId::MAX_FRAME_SIZE, 16384);
   }
   explicit HTTPSettings(
       const std::initializer_list<SettingPair>& initialSettings) {
-    settings_.reserve(initialSettings.size());
-    // TODO: setSetting involves looping over all settings so the below actually
-    // models as O(n^2) which is pretty bad.  Can't change it outright without
-    // making sure we handle duplicates (same setting id)
     for (auto& setting : initialSettings) {
       setSetting(setting.first, setting.second);
     }
@@ -54,27 +52,44 @@ class HTTPSettings {
   const HTTPSetting* getSetting(SettingsId id) const;
   SettingsValue getSetting(SettingsId id, SettingsValue defaultVal) const;
   // Note: this does not count disabled settings
-  std::size_t getNumSettings() const {
-    return settings_.size();
-  }
-  const std::vector<HTTPSetting>& getAllSettings() {
-    return settings_;
-  }
-  void clearSettings() {
-    settings_.clear();
-  }
+  std::size_t getNumSettings() const;
+  const std::vector<HTTPSetting>& getAllSettings();
+  void clearSettings();
 
  private:
-  // Returns the specified type of iterator to the setting associated with the
-  // specified id
-  std::vector<HTTPSetting>::iterator getSettingIter(SettingsId id);
-  std::vector<HTTPSetting>::const_iterator getSettingConstIter(
-      SettingsId id) const;
+  // Slot in standard_ for the given id, or -1 for overflow ids
+  static int8_t standardIndex(SettingsId id) {
+    auto raw = static_cast<uint64_t>(id);
+    if (raw >= 1 && raw <= 6) {
+      // HEADER_TABLE_SIZE .. MAX_HEADER_LIST_SIZE
+      return int8_t(raw - 1);
+    }
+    if (raw == 8 || raw == 9) {
+      // ENABLE_CONNECT_PROTOCOL, NO_RFC7540_PRIORITIES
+      return int8_t(raw - 2);
+    }
+    return -1;
+  }
+
+  static constexpr std::size_t kNumStandardSettings = 8;
+
+  // Values for the standard slots; standardSetMask_ says which are set.
+  // Slot ids are fixed, so getSetting can hand out stable pointers.
+  std::array<HTTPSetting, kNumStandardSettings> standard_{
+      {{SettingsId::HEADER_TABLE_SIZE, 0},
+       {SettingsId::ENABLE_PUSH, 0},
+       {SettingsId::MAX_CONCURRENT_STREAMS, 0},
+       {SettingsId::INITIAL_WINDOW_SIZE, 0},
+       {SettingsId::MAX_FRAME_SIZE, 0},
+       {SettingsId::MAX_HEADER_LIST_SIZE, 0},
+       {SettingsId::ENABLE_CONNECT_PROTOCOL, 0},
+       {SettingsId::NO_RFC7540_PRIORITIES, 0}}};
+  uint8_t standardSetMask_{0};
+  std::vector<HTTPSetting> overflow_;
 
-  // TODO: evaluate whether using a list or default initializing vector with
-  // all settings so that size == capacity (else on push_backs capacity is
-  // likely to be > size)
-  std::vector<HTTPSetting> settings_;
+  // Flat view handed out by getAllSettings, rebuilt lazily
+  std::vector<HTTPSetting> allSettings_;
+  bool allSettingsDirty_{true};
 };
 
 using SettingsList = std::vector<HTTPSetting>;
@@ -111,6 +111,20 @@ bool HeaderDecodeInfo::onHeader(const HPACKHeaderName& name,
           "Bad header value: name=", nameSp, " value=", valueSp);
       return false;
     }
+    if (streamingCallback != nullptr) {
+      if (!routingSignaled_) {
+        // Pseudo headers must precede regular headers, so everything
+        // needed for routing is on msg by now.
+        routingSignaled_ = true;
+        streamingCallback->onRoutingHeadersComplete(streamingStreamID, *msg);
+      }
+      streamingCallback->onIngressHeader(streamingStreamID, nameSp, valueSp);
+      // Framing-relevant headers are stored on msg as well; everything
+      // else lives only in the callback's hands.
+      if (headerCode != HTTP_HEADER_CONTENT_LENGTH) {
+        return true;
+      }
+    }
     // Add the (name, value) pair to headers
     if (headerCode == HTTP_HEADER_OTHER) {
       msg->getHeaders().add(nameSp, valueSp);
@@ -121,6 +135,18 @@ bool HeaderDecodeInfo::onHeader(const HPACKHeaderName& name,
   return true;
 }
 
+bool HeaderDecodeInfo::onHeaders(const std::vector<HPACKHeader>& headers) {
+  // One capacity check up front; pseudo headers make this a slight
+  // over-reservation, which is fine
+  msg->getHeaders().reserve(headers.size());
+  for (const auto& header : headers) {
+    if (!onHeader(header.name, header.value)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void HeaderDecodeInfo::onHeadersComplete(HTTPHeaderSize decodedSize) {
   HTTPHeaders& headers = msg->getHeaders();
 
@@ -141,6 +167,12 @@ void HeaderDecodeInfo::onHeadersComplete(HTTPHeaderSize decodedSize) {
     return;
   }
 
+  if (streamingCallback != nullptr && !routingSignaled_) {
+    // Block with no regular headers at all
+    routingSignaled_ = true;
+    streamingCallback->onRoutingHeadersComplete(streamingStreamID, *msg);
+  }
+
   msg->setHTTPVersion(1, 1);
   msg->setIngressHeaderSize(decodedSize);
 }
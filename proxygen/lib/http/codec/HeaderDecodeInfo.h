@@ -8,9 +8,14 @@
 
 #pragma once
 
+#include <vector>
+
+#include <proxygen/lib/http/codec/HTTPCodec.h>
 #include <proxygen/lib/http/codec/HTTPRequestVerifier.h>
 #include <proxygen/lib/http/codec/compress/HPACKConstants.h>
+#include <proxygen/lib/http/codec/compress/HPACKHeader.h>
 #include <proxygen/lib/http/codec/compress/HPACKHeaderName.h>
+#include <proxygen/lib/utils/AllocationTracker.h>
 
 namespace proxygen {
 
@@ -21,6 +26,8 @@ class HeaderDecodeInfo {
   void init(bool isRequestIn, bool isRequestTrailers, bool validate = true) {
     CHECK(!msg);
     msg.reset(new HTTPMessage());
+    AllocationTracker::recordAllocation(AllocationTracker::CODEC,
+                                        sizeof(HTTPMessage));
     isRequest_ = isRequestIn;
     isRequestTrailers_ = isRequestTrailers;
     validate_ = validate;
@@ -30,11 +37,21 @@ class HeaderDecodeInfo {
     pseudoHeaderSeen_ = false;
     parsingError = "";
     decodeError = HPACK::DecodeError::NONE;
+    streamingCallback = nullptr;
+    streamingStreamID = 0;
+    routingSignaled_ = false;
     verifier.reset(msg.get());
   }
 
   bool onHeader(const HPACKHeaderName& name, const folly::fbstring& value);
 
+  /**
+   * Install a fully decoded header block in one pass, reserving message
+   * header capacity up front.  Returns false on the first bad header,
+   * with the reason in parsingError.
+   */
+  bool onHeaders(const std::vector<HPACKHeader>& headers);
+
   void onHeadersComplete(HTTPHeaderSize decodedSize);
 
   bool hasStatus() const;
@@ -45,6 +62,12 @@ class HeaderDecodeInfo {
   HTTPRequestVerifier verifier;
   std::string parsingError;
   HPACK::DecodeError decodeError{HPACK::DecodeError::NONE};
+  // When set (by the owning codec, after init), validated regular headers
+  // are handed to this callback instead of being added to msg; framing
+  // headers like content-length are stored on msg as well.  Pseudo
+  // headers always go through the verifier onto msg.
+  HTTPCodec::StreamingHeaderCallback* streamingCallback{nullptr};
+  HTTPCodec::StreamID streamingStreamID{0};
 
  private:
   bool isRequest_{false};
@@ -53,6 +76,7 @@ class HeaderDecodeInfo {
   bool hasStatus_{false};
   bool regularHeaderSeen_{false};
   bool pseudoHeaderSeen_{false};
+  bool routingSignaled_{false};
 
   folly::Optional<uint32_t> contentLength_;
 };
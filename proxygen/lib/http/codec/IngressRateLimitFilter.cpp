@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/http/codec/IngressRateLimitFilter.h>
+
+#include <algorithm>
+
+#include <folly/lang/Assume.h>
+
+namespace proxygen {
+
+IngressRateLimiter::IngressRateLimiter(folly::TimeoutManager* timeoutManager,
+                                       const IngressRateLimitConfig& listenerConfig,
+                                       std::chrono::milliseconds tickInterval,
+                                       TokenBucketRateLimiter::Clock* clock)
+    : limiter_(timeoutManager, tickInterval, clock) {
+  for (size_t i = 0; i < kNumIngressRateLimitCategories; i++) {
+    listenerBuckets_[i] = limiter_.makeBucket(
+        nullptr, listenerConfig[i].ratePerSecond, listenerConfig[i].burst);
+  }
+}
+
+IngressRateLimitFilter::IngressRateLimitFilter(
+    IngressRateLimiter& scope,
+    const IngressRateLimitConfig& sessionConfig,
+    ReadThrottler* readThrottler)
+    : scope_(scope), config_(sessionConfig), readThrottler_(readThrottler) {
+  for (size_t i = 0; i < kNumIngressRateLimitCategories; i++) {
+    buckets_[i] = scope_.limiter().makeBucket(
+        scope_.listenerBucket(static_cast<IngressRateLimitCategory>(i)),
+        config_[i].ratePerSecond,
+        config_[i].burst);
+  }
+}
+
+IngressRateLimitFilter::~IngressRateLimitFilter() {
+  if (readsDelayed_) {
+    scope_.limiter().cancelWait(this);
+  }
+}
+
+void IngressRateLimitFilter::onAbort(HTTPCodec::StreamID streamID,
+                                     ErrorCode code) {
+  if (consume(IngressRateLimitCategory::CONTROL_FRAMES, 1, 0, "RST_STREAM")) {
+    callback_->onAbort(streamID, code);
+  }
+}
+
+void IngressRateLimitFilter::onPingRequest(uint64_t data) {
+  if (consume(IngressRateLimitCategory::CONTROL_FRAMES, 1, 0, "PING")) {
+    callback_->onPingRequest(data);
+  }
+}
+
+void IngressRateLimitFilter::onSettings(const SettingsList& settings) {
+  if (consume(IngressRateLimitCategory::CONTROL_FRAMES, 1, 0, "SETTINGS")) {
+    callback_->onSettings(settings);
+  }
+}
+
+void IngressRateLimitFilter::onPriority(HTTPCodec::StreamID streamID,
+                                        const HTTPMessage::HTTP2Priority& pri) {
+  if (consume(IngressRateLimitCategory::CONTROL_FRAMES, 1, 0, "PRIORITY")) {
+    callback_->onPriority(streamID, pri);
+  }
+}
+
+void IngressRateLimitFilter::onMessageBegin(HTTPCodec::StreamID streamID,
+                                            HTTPMessage* msg) {
+  if (consume(
+          IngressRateLimitCategory::NEW_STREAMS, 1, streamID, "new streams")) {
+    callback_->onMessageBegin(streamID, msg);
+  }
+}
+
+void IngressRateLimitFilter::onHeadersComplete(HTTPCodec::StreamID streamID,
+                                               std::unique_ptr<HTTPMessage> msg) {
+  // Charge the uncompressed size: that is what decompression and header
+  // processing actually cost us, regardless of how small the flood's
+  // HPACK encoding was on the wire
+  uint64_t cost =
+      std::max<uint64_t>(msg->getIngressHeaderSize().uncompressed, 1);
+  if (consume(
+          IngressRateLimitCategory::HEADER_BYTES, cost, streamID, "headers")) {
+    callback_->onHeadersComplete(streamID, std::move(msg));
+  }
+}
+
+bool IngressRateLimitFilter::consume(IngressRateLimitCategory category,
+                                     uint64_t cost,
+                                     HTTPCodec::StreamID streamID,
+                                     const char* what) {
+  auto index = static_cast<size_t>(category);
+  auto& bucket = *buckets_[index];
+  if (scope_.limiter().tryConsume(bucket, cost)) {
+    return true;
+  }
+  switch (config_[index].action) {
+    case IngressOverflowAction::DELAY_READ: {
+      if (readThrottler_ && !readsDelayed_) {
+        VLOG(4) << "ingress rate limit hit for " << what
+                << ", delaying reads until tokens refill";
+        readsDelayed_ = true;
+        readThrottler_->pauseIngressForRateLimit();
+        scope_.limiter().waitForTokens(bucket, cost, this);
+      }
+      // The event itself is still delivered; only the socket slows down
+      return true;
+    }
+    case IngressOverflowAction::RESET_STREAM: {
+      if (streamID != 0) {
+        HTTPException ex(
+            HTTPException::Direction::INGRESS_AND_EGRESS,
+            folly::to<std::string>("ingress rate limit exceeded for ", what));
+        ex.setCodecStatusCode(ErrorCode::REFUSED_STREAM);
+        callback_->onError(streamID, ex, true);
+      }
+      return false;
+    }
+    case IngressOverflowAction::CLOSE_SESSION: {
+      HTTPException ex(
+          HTTPException::Direction::INGRESS_AND_EGRESS,
+          folly::to<std::string>(
+              "dropping connection, ingress rate limit exceeded for ", what));
+      ex.setProxygenError(kErrorDropped);
+      callback_->onError(0, ex, true);
+      return false;
+    }
+  }
+  folly::assume_unreachable();
+}
+
+void IngressRateLimitFilter::tokensAvailable() noexcept {
+  readsDelayed_ = false;
+  if (readThrottler_) {
+    readThrottler_->resumeIngressForRateLimit();
+  }
+}
+
+} // namespace proxygen
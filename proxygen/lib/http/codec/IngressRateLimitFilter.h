@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <proxygen/lib/http/codec/HTTPCodecFilter.h>
+#include <proxygen/lib/utils/TokenBucketRateLimiter.h>
+
+namespace proxygen {
+
+/**
+ * What an ingress token bucket meters.  Costs are one token per control
+ * frame, one per new stream, and uncompressed bytes for header blocks.
+ */
+enum class IngressRateLimitCategory : uint8_t {
+  CONTROL_FRAMES = 0,
+  HEADER_BYTES = 1,
+  NEW_STREAMS = 2,
+};
+
+constexpr size_t kNumIngressRateLimitCategories = 3;
+
+/**
+ * What to do when a bucket runs dry.  DELAY_READ still delivers the
+ * offending event but pauses the session's reads until tokens refill;
+ * RESET_STREAM refuses the stream (or drops the frame when there is no
+ * stream to refuse); CLOSE_SESSION converts the event into a session
+ * error with kErrorDropped, matching ControlMessageRateLimitFilter.
+ */
+enum class IngressOverflowAction : uint8_t {
+  DELAY_READ,
+  RESET_STREAM,
+  CLOSE_SESSION,
+};
+
+struct IngressBucketConfig {
+  uint64_t ratePerSecond{0}; // 0 = unlimited
+  uint64_t burst{0};
+  IngressOverflowAction action{IngressOverflowAction::CLOSE_SESSION};
+};
+
+using IngressRateLimitConfig =
+    std::array<IngressBucketConfig, kNumIngressRateLimitCategories>;
+
+/**
+ * Per-worker scope for ingress rate limiting.  Owns the shared
+ * TokenBucketRateLimiter, so every session's delayed-read wakeups ride
+ * one timer tick, plus the listener-scope root buckets that cap each
+ * category across all sessions on the worker during attacks.  Create
+ * one per worker thread next to the acceptor and hand it to each
+ * session through HTTPSession::setIngressRateLimiter().
+ */
+class IngressRateLimiter {
+ public:
+  explicit IngressRateLimiter(
+      folly::TimeoutManager* timeoutManager,
+      const IngressRateLimitConfig& listenerConfig = {},
+      std::chrono::milliseconds tickInterval = std::chrono::milliseconds(10),
+      TokenBucketRateLimiter::Clock* clock = nullptr);
+
+  TokenBucketRateLimiter& limiter() {
+    return limiter_;
+  }
+
+  TokenBucketRateLimiter::Bucket* listenerBucket(
+      IngressRateLimitCategory category) {
+    return listenerBuckets_[static_cast<size_t>(category)].get();
+  }
+
+ private:
+  TokenBucketRateLimiter limiter_;
+  std::array<std::unique_ptr<TokenBucketRateLimiter::Bucket>,
+             kNumIngressRateLimitCategories>
+      listenerBuckets_;
+};
+
+/**
+ * Token-bucket generalization of ControlMessageRateLimitFilter.
+ * Meters control frames, header bytes and new streams against
+ * session-scope buckets nested under the worker's listener-scope
+ * buckets, so a flood is caught per session first and in aggregate when
+ * many sessions misbehave at once.  Buckets refill lazily from
+ * timestamps, so a well-behaved session costs no timers at all, unlike
+ * the per-session interval resets this replaces.
+ *
+ * The filter's buckets belong to one worker's limiter, so sessions
+ * that migrate threads (detachThreadLocals) must not use it.
+ */
+class IngressRateLimitFilter
+    : public PassThroughHTTPCodecFilter
+    , private TokenBucketRateLimiter::Callback {
+ public:
+  /**
+   * Implemented by the session so DELAY_READ can throttle the socket.
+   */
+  class ReadThrottler {
+   public:
+    virtual ~ReadThrottler() = default;
+    virtual void pauseIngressForRateLimit() noexcept = 0;
+    virtual void resumeIngressForRateLimit() noexcept = 0;
+  };
+
+  IngressRateLimitFilter(IngressRateLimiter& scope,
+                         const IngressRateLimitConfig& sessionConfig,
+                         ReadThrottler* readThrottler);
+
+  ~IngressRateLimitFilter() override;
+
+  // Filter functions
+  void onAbort(HTTPCodec::StreamID streamID, ErrorCode code) override;
+  void onPingRequest(uint64_t data) override;
+  void onSettings(const SettingsList& settings) override;
+  void onPriority(HTTPCodec::StreamID streamID,
+                  const HTTPMessage::HTTP2Priority& pri) override;
+  void onMessageBegin(HTTPCodec::StreamID streamID, HTTPMessage* msg) override;
+  void onHeadersComplete(HTTPCodec::StreamID streamID,
+                         std::unique_ptr<HTTPMessage> msg) override;
+
+  const TokenBucketRateLimiter::Bucket& getBucket(
+      IngressRateLimitCategory category) const {
+    return *buckets_[static_cast<size_t>(category)];
+  }
+
+ private:
+  // Returns true when the event should be delivered downstream
+  bool consume(IngressRateLimitCategory category,
+               uint64_t cost,
+               HTTPCodec::StreamID streamID,
+               const char* what);
+
+  void tokensAvailable() noexcept override;
+
+  IngressRateLimiter& scope_;
+  IngressRateLimitConfig config_;
+  std::array<std::unique_ptr<TokenBucketRateLimiter::Bucket>,
+             kNumIngressRateLimitCategories>
+      buckets_;
+  ReadThrottler* readThrottler_{nullptr};
+  bool readsDelayed_{false};
+};
+
+} // namespace proxygen
@@ -27,6 +27,9 @@ enum class SettingsId : uint64_t {
   MAX_HEADER_LIST_SIZE = 6,
 
   ENABLE_CONNECT_PROTOCOL = 8,
+  // RFC 9218: deprecate the RFC 7540 dependency tree in favor of
+  // urgency/incremental priorities
+  NO_RFC7540_PRIORITIES = 9,
 
   THRIFT_CHANNEL_ID_DEPRECATED = 100,
 
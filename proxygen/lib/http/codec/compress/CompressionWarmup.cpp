@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/http/codec/compress/CompressionWarmup.h>
+
+#include <proxygen/lib/http/codec/compress/Huffman.h>
+#include <proxygen/lib/http/codec/compress/QPACKStaticHeaderTable.h>
+#include <proxygen/lib/http/codec/compress/StaticHeaderTable.h>
+
+namespace proxygen { namespace compress {
+
+void warmupStaticTables(folly::Executor* executor) {
+  auto run = [&](folly::Func fn) {
+    if (executor) {
+      executor->add(std::move(fn));
+    } else {
+      fn();
+    }
+  };
+  run([] { StaticHeaderTable::get(); });
+  run([] { QPACKStaticHeaderTable::get(); });
+  run([] { huffman::huffTree(); });
+}
+
+}} // namespace proxygen::compress
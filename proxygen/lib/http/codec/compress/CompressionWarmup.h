@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <folly/Executor.h>
+
+namespace proxygen { namespace compress {
+
+/**
+ * Force construction of the lazily built compression singletons - the
+ * HPACK and QPACK static header tables and the Huffman decode tree -
+ * ahead of the first connection that would otherwise pay for them.
+ * With an executor each table builds as its own task, so they
+ * initialize in parallel; with nullptr they build serially on the
+ * calling thread.  Safe to race against first real use: the singletons
+ * are function-local statics, so a late caller simply blocks on the
+ * initialization guard exactly as it would without warmup.  Processes
+ * that never touch HPACK/QPACK (plain HTTP/1.x tooling) should not
+ * call this and pay nothing, as before.
+ */
+void warmupStaticTables(folly::Executor* executor = nullptr);
+
+}} // namespace proxygen::compress
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/http/codec/compress/FrequencyIndexingStrategy.h>
+
+#include <folly/hash/Hash.h>
+#include <limits>
+
+namespace proxygen {
+
+uint32_t FrequencyIndexingStrategy::estimateAndCount(uint64_t hash) const {
+  uint32_t estimate = std::numeric_limits<uint32_t>::max();
+  for (size_t row = 0; row < kSketchDepth; row++) {
+    const size_t col =
+        folly::hash::twang_mix64(hash + row * 0x9e3779b97f4a7c15ULL) &
+        (kSketchWidth - 1);
+    auto& counter = sketch_[row][col];
+    const uint32_t count = counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    estimate = std::min(estimate, count);
+  }
+  return estimate;
+}
+
+void FrequencyIndexingStrategy::maybeDecay() const {
+  if (samples_.fetch_add(1, std::memory_order_relaxed) + 1 < kDecayInterval) {
+    return;
+  }
+  samples_.store(0, std::memory_order_relaxed);
+  for (auto& row : sketch_) {
+    for (auto& counter : row) {
+      counter.store(counter.load(std::memory_order_relaxed) / 2,
+                    std::memory_order_relaxed);
+    }
+  }
+}
+
+bool FrequencyIndexingStrategy::indexHeader(const HPACKHeaderName& name,
+                                            folly::StringPiece value) const {
+  // The static rules still veto entries known to never repeat
+  if (!HeaderIndexingStrategy::indexHeader(name, value)) {
+    return false;
+  }
+  maybeDecay();
+  const uint64_t hash = folly::hash::hash_combine(name.get(), value);
+  const bool index = estimateAndCount(hash) >= threshold_;
+  if (stats_) {
+    stats_->recordIndexingDecision(index);
+  }
+  return index;
+}
+
+} // namespace proxygen
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <proxygen/lib/http/codec/compress/HeaderCodec.h>
+#include <proxygen/lib/http/codec/compress/HeaderIndexingStrategy.h>
+
+namespace proxygen {
+
+/**
+ * A HeaderIndexingStrategy that learns which headers are worth dynamic
+ * table space from the traffic it actually sees.  Every name/value pair
+ * offered for indexing is counted in a small count-min sketch, and a
+ * pair is only indexed once its estimated frequency reaches a
+ * threshold.  One-shot headers (request ids, trace tokens, etc) thus
+ * never displace frequently reused entries from the dynamic table.
+ *
+ * The sketch is periodically decayed so the strategy tracks shifts in
+ * traffic rather than saturating.  Counters are relaxed atomics, so a
+ * single instance can be shared by every encoder on a listener;
+ * estimates may be slightly off under concurrency, which is acceptable
+ * for a heuristic.
+ */
+class FrequencyIndexingStrategy : public HeaderIndexingStrategy {
+ public:
+  // Index a header once it has been offered this many times within one
+  // decay interval
+  static constexpr uint32_t kDefaultIndexingThreshold = 2;
+
+  explicit FrequencyIndexingStrategy(
+      uint32_t indexingThreshold = kDefaultIndexingThreshold)
+      : threshold_(indexingThreshold) {
+  }
+
+  /**
+   * Report indexing decisions to the given stats object, which must
+   * outlive this strategy.
+   */
+  void setStats(HeaderCodec::Stats* stats) {
+    stats_ = stats;
+  }
+
+  bool indexHeader(const HPACKHeaderName& name,
+                   folly::StringPiece value) const override;
+
+ private:
+  static constexpr size_t kSketchDepth = 4;
+  static constexpr size_t kSketchWidth = 1024; // must be a power of two
+  // Halve every counter after this many samples so old traffic fades out
+  static constexpr uint64_t kDecayInterval = 64 * 1024;
+
+  uint32_t estimateAndCount(uint64_t hash) const;
+  void maybeDecay() const;
+
+  const uint32_t threshold_;
+  HeaderCodec::Stats* stats_{nullptr};
+
+  // indexHeader() is const on the interface, but learning mutates the
+  // sketch
+  mutable std::array<std::array<std::atomic<uint32_t>, kSketchWidth>,
+                     kSketchDepth>
+      sketch_{};
+  mutable std::atomic<uint64_t> samples_{0};
+};
+
+} // namespace proxygen
@@ -37,7 +37,7 @@ class GzipHeaderCodec : public HeaderCodec {
                   const SPDYVersionSettings& versionSettings);
   explicit GzipHeaderCodec(int compressionLevel,
                            SPDYVersion version = SPDYVersion::SPDY3_1);
-  ~GzipHeaderCodec() override;
+  ~GzipHeaderCodec();
 
   std::unique_ptr<folly::IOBuf> encode(
       std::vector<compress::Header>& headers) noexcept;
@@ -11,11 +11,14 @@
 #include <algorithm>
 #include <folly/String.h>
 #include <folly/ThreadLocal.h>
+#include <folly/hash/SpookyHashV2.h>
 #include <folly/io/Cursor.h>
+#include <folly/lang/Bits.h>
 #include <iosfwd>
 #include <proxygen/lib/http/HTTPMessage.h>
 #include <proxygen/lib/http/codec/CodecUtil.h>
 #include <proxygen/lib/http/codec/HeaderConstants.h>
+#include <proxygen/lib/utils/AllocationTracker.h>
 #include <proxygen/lib/http/codec/compress/HPACKHeader.h>
 
 using folly::IOBuf;
@@ -63,6 +66,11 @@ void HPACKCodec::encode(vector<Header>& headers,
   auto& prepared = *preparedTL.get();
   encodedSize_.uncompressed = compress::prepareHeaders(headers, prepared);
   auto prevSize = writeBuf.chainLength();
+  // Reserve-ahead: compressed output virtually never exceeds the
+  // uncompressed bytes, so reserving that much tailroom up front lets the
+  // whole block land contiguously instead of spilling across the encode
+  // buffer's fixed growth increments.
+  writeBuf.preallocate(encodedSize_.uncompressed, encodedSize_.uncompressed);
   encoder_.encode(prepared, writeBuf);
   recordCompressedSize(writeBuf.chainLength() - prevSize);
 }
@@ -73,6 +81,14 @@ void HPACKCodec::encodeHTTP(
     bool includeDate,
     const folly::Optional<HTTPHeaders>& extraHeaders) noexcept {
   auto prevSize = writeBuf.chainLength();
+  // Rough reserve-ahead from the uncompressed header bytes, plus slack for
+  // the pseudo-headers; see encode() above
+  size_t reserveEstimate = 128 + (msg.isRequest() ? msg.getURL().size() : 0);
+  msg.getHeaders().forEach(
+      [&reserveEstimate](const std::string& name, const std::string& value) {
+        reserveEstimate += name.size() + value.size() + 2;
+      });
+  writeBuf.preallocate(reserveEstimate, reserveEstimate);
   encoder_.startEncode(writeBuf);
 
   auto uncompressed = 0;
@@ -160,27 +176,280 @@ void HPACKCodec::recordCompressedSize(const IOBuf* stream) {
     encodedSize_.compressed += streamDataLength;
     encodedSize_.compressedBlock += streamDataLength;
   }
+  AllocationTracker::recordAllocation(AllocationTracker::COMPRESS,
+                                      encodedSize_.compressed);
   if (stats_) {
     stats_->recordEncode(Type::HPACK, encodedSize_);
+    recordTableEfficiency();
   }
 }
 
 void HPACKCodec::recordCompressedSize(size_t size) {
   encodedSize_.compressed = size;
   encodedSize_.compressedBlock += size;
+  AllocationTracker::recordAllocation(AllocationTracker::COMPRESS, size);
   if (stats_) {
     stats_->recordEncode(Type::HPACK, encodedSize_);
+    recordTableEfficiency();
   }
 }
 
+void HPACKCodec::recordTableEfficiency() {
+  TableEfficiency sample;
+  const auto& table = encoder_.getTable();
+  sample.staticHits = encoder_.getStaticRefs() - prevStaticRefs_;
+  sample.dynamicHits = encoder_.getDynamicRefs() - prevDynamicRefs_;
+  sample.literals = encoder_.getLiteralsEncoded() - prevLiterals_;
+  sample.evictions = table.getEvictions() - prevEvictions_;
+  sample.evictedBytesNeverReused =
+      table.getEvictedNeverReusedBytes() - prevEvictionWaste_;
+  if (table.capacity() > 0) {
+    sample.tableOccupancyPct = table.bytes() * 100 / table.capacity();
+  }
+  prevStaticRefs_ += sample.staticHits;
+  prevDynamicRefs_ += sample.dynamicHits;
+  prevLiterals_ += sample.literals;
+  prevEvictions_ += sample.evictions;
+  prevEvictionWaste_ += sample.evictedBytesNeverReused;
+  stats_->recordTableEfficiency(Type::HPACK, sample);
+}
+
+namespace {
+
+/**
+ * Tees a decode into a copy of the headers so a cacheable block can be
+ * replayed later, forwarding everything to the wrapped callback.
+ */
+class RecordingStreamingCallback : public HPACK::StreamingCallback {
+ public:
+  explicit RecordingStreamingCallback(HPACK::StreamingCallback* wrapped)
+      : wrapped_(wrapped) {
+    stats = wrapped->stats;
+  }
+
+  void onHeader(const HPACKHeaderName& name,
+                const folly::fbstring& value) override {
+    headers_.emplace_back(name,
+                          folly::StringPiece(value.data(), value.size()));
+    wrapped_->onHeader(name, value);
+  }
+
+  void onHeaderBlock(const std::vector<HPACKHeader>& headers) override {
+    headers_.reserve(headers.size());
+    for (const auto& header : headers) {
+      headers_.emplace_back(
+          header.name,
+          folly::StringPiece(header.value.data(), header.value.size()));
+    }
+    wrapped_->onHeaderBlock(headers);
+  }
+
+  void onHeadersComplete(HTTPHeaderSize decodedSize,
+                         bool acknowledge) override {
+    decodedSize_ = decodedSize;
+    acknowledge_ = acknowledge;
+    success_ = true;
+    wrapped_->onHeadersComplete(decodedSize, acknowledge);
+  }
+
+  void onDecodeError(HPACK::DecodeError decodeError) override {
+    wrapped_->onDecodeError(decodeError);
+  }
+
+  HPACK::StreamingCallback* wrapped_;
+  std::vector<HPACKHeader> headers_;
+  HTTPHeaderSize decodedSize_;
+  bool acknowledge_{false};
+  bool success_{false};
+};
+
+} // namespace
+
+void HPACKCodec::enableDecodedBlockCache(size_t maxEntries,
+                                         uint32_t maxBlockBytes) {
+  decodedBlockCacheMaxEntries_ = maxEntries;
+  decodedBlockCacheMaxBlockBytes_ = maxBlockBytes;
+  if (maxEntries == 0) {
+    decodedBlockCache_.clear();
+  }
+}
+
+bool HPACKCodec::decodeWithBlockCache(
+    Cursor& cursor,
+    uint32_t length,
+    HPACK::StreamingCallback* streamingCb,
+    bool bulk) noexcept {
+  if (decodedBlockCacheMaxEntries_ == 0 || length == 0 ||
+      length > decodedBlockCacheMaxBlockBytes_) {
+    return false;
+  }
+  std::string block;
+  block.resize(length);
+  {
+    Cursor peek(cursor);
+    if (peek.pullAtMost(&block[0], length) != length) {
+      // truncated block; let the decoder report the error
+      return false;
+    }
+  }
+  const uint64_t hash =
+      folly::hash::SpookyHashV2::Hash64(block.data(), block.size(), 0);
+  const uint32_t insertCount = decoder_.getInsertCount();
+  const uint32_t bytesStored = decoder_.getBytesStored();
+  const uint32_t tableCapacity = decoder_.getTableSize();
+  for (auto it = decodedBlockCache_.begin(); it != decodedBlockCache_.end();
+       ++it) {
+    if (it->hash == hash && it->insertCount == insertCount &&
+        it->bytesStored == bytesStored && it->tableCapacity == tableCapacity &&
+        it->block == block) {
+      // Identical bytes under an identical table: decoding would yield
+      // exactly these headers with no side effects, so replay them
+      cursor.skip(length);
+      decodedBlockCacheHits_++;
+      if (bulk) {
+        streamingCb->onHeaderBlock(it->headers);
+      } else {
+        for (const auto& header : it->headers) {
+          streamingCb->onHeader(header.name, header.value);
+        }
+      }
+      if (streamingCb->stats) {
+        streamingCb->stats->recordDecode(Type::HPACK, it->decodedSize);
+      }
+      streamingCb->onHeadersComplete(it->decodedSize, it->acknowledge);
+      decodedBlockCache_.splice(
+          decodedBlockCache_.begin(), decodedBlockCache_, it);
+      return true;
+    }
+  }
+  RecordingStreamingCallback recorder(streamingCb);
+  if (bulk) {
+    decoder_.decodeBulk(cursor, length, &recorder);
+  } else {
+    decoder_.decodeStreaming(cursor, length, &recorder);
+  }
+  // Cache only blocks whose decode left the table untouched: replaying
+  // such a block later is side-effect free, and the state comparison on
+  // lookup guarantees its indexed references still resolve identically
+  if (recorder.success_ && decoder_.getInsertCount() == insertCount &&
+      decoder_.getBytesStored() == bytesStored &&
+      decoder_.getTableSize() == tableCapacity) {
+    decodedBlockCache_.emplace_front();
+    auto& entry = decodedBlockCache_.front();
+    entry.block = std::move(block);
+    entry.hash = hash;
+    entry.insertCount = insertCount;
+    entry.bytesStored = bytesStored;
+    entry.tableCapacity = tableCapacity;
+    entry.headers = std::move(recorder.headers_);
+    entry.decodedSize = recorder.decodedSize_;
+    entry.acknowledge = recorder.acknowledge_;
+    while (decodedBlockCache_.size() > decodedBlockCacheMaxEntries_) {
+      decodedBlockCache_.pop_back();
+    }
+  }
+  return true;
+}
+
 void HPACKCodec::decodeStreaming(
     Cursor& cursor,
     uint32_t length,
     HPACK::StreamingCallback* streamingCb) noexcept {
   streamingCb->stats = stats_;
+  if (decodeWithBlockCache(cursor, length, streamingCb, /*bulk=*/false)) {
+    return;
+  }
   decoder_.decodeStreaming(cursor, length, streamingCb);
 }
 
+void HPACKCodec::decodeBulk(Cursor& cursor,
+                            uint32_t length,
+                            HPACK::StreamingCallback* streamingCb) noexcept {
+  streamingCb->stats = stats_;
+  if (decodeWithBlockCache(cursor, length, streamingCb, /*bulk=*/true)) {
+    return;
+  }
+  decoder_.decodeBulk(cursor, length, streamingCb);
+}
+
+namespace {
+
+constexpr uint8_t kWarmStateVersion = 1;
+
+// Parses a blob produced by exportWarmTableState(): a version byte
+// followed by length-prefixed name/value pairs, oldest entry first.
+// Fails without partial output on truncation, trailing garbage, or an
+// entry too large for the given table capacity.
+bool parseWarmTableState(folly::StringPiece blob,
+                         uint32_t tableCapacity,
+                         std::vector<HPACKHeader>& entries) {
+  auto buf = IOBuf::wrapBufferAsValue(blob.data(), blob.size());
+  Cursor cursor(&buf);
+  try {
+    if (cursor.read<uint8_t>() != kWarmStateVersion) {
+      return false;
+    }
+    while (cursor.totalLength() > 0) {
+      auto name = cursor.readFixedString(cursor.readBE<uint32_t>());
+      auto value = cursor.readFixedString(cursor.readBE<uint32_t>());
+      if (HPACKHeader::bytes(name.size(), value.size()) > tableCapacity) {
+        return false;
+      }
+      entries.emplace_back(name, value);
+    }
+  } catch (const std::out_of_range&) {
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+std::string HPACKCodec::exportWarmTableState() const {
+  const auto& table = encoder_.getTable();
+  std::string blob;
+  blob.reserve(1 + table.bytes());
+  blob.push_back(char(kWarmStateVersion));
+  auto appendLengthPrefixed = [&blob](folly::StringPiece str) {
+    const uint32_t len =
+        folly::Endian::big<uint32_t>(static_cast<uint32_t>(str.size()));
+    blob.append(reinterpret_cast<const char*>(&len), sizeof(len));
+    blob.append(str.data(), str.size());
+  };
+  // external index 1 is the newest entry; walk backwards so the blob
+  // is oldest-first and importing reproduces the original indices
+  for (uint32_t i = table.size(); i >= 1; i--) {
+    const auto& header = table.getHeader(i);
+    appendLengthPrefixed(header.name.get());
+    appendLengthPrefixed({header.value.data(), header.value.size()});
+  }
+  return blob;
+}
+
+bool HPACKCodec::importWarmTableState(folly::StringPiece blob) {
+  if (encoder_.getInsertCount() > 0) {
+    return false;
+  }
+  std::vector<HPACKHeader> entries;
+  if (!parseWarmTableState(blob, encoder_.getTableSize(), entries)) {
+    return false;
+  }
+  encoder_.seedHeaderTable(entries);
+  return true;
+}
+
+bool HPACKCodec::importPeerWarmTableState(folly::StringPiece blob) {
+  if (decoder_.getInsertCount() > 0) {
+    return false;
+  }
+  std::vector<HPACKHeader> entries;
+  if (!parseWarmTableState(blob, decoder_.getTableSize(), entries)) {
+    return false;
+  }
+  decoder_.seedHeaderTable(entries);
+  return true;
+}
+
 void HPACKCodec::describe(std::ostream& stream) const {
   stream << "DecoderTable:\n" << decoder_;
   stream << "EncoderTable:\n" << encoder_;
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <list>
 #include <memory>
 #include <proxygen/lib/http/codec/TransportDirection.h>
 #include <proxygen/lib/http/codec/compress/CompressionInfo.h>
@@ -41,8 +42,6 @@ uint32_t prepareHeaders(const std::vector<Header>& headers,
 class HPACKCodec : public HeaderCodec {
  public:
   explicit HPACKCodec(TransportDirection direction);
-  ~HPACKCodec() override {
-  }
 
   std::unique_ptr<folly::IOBuf> encode(
       std::vector<compress::Header>& headers) noexcept;
@@ -60,6 +59,35 @@ class HPACKCodec : public HeaderCodec {
                        uint32_t length,
                        HPACK::StreamingCallback* streamingCb) noexcept;
 
+  /**
+   * Enable the decoded-block fingerprint cache.  Many clients (mobile
+   * SDKs especially) send byte-identical header blocks on every request
+   * of a session; on a fingerprint hit the stored headers are replayed
+   * to the callback, skipping HPACK decode entirely.
+   *
+   * This is only sound when re-decoding would be a no-op: entries are
+   * created solely for blocks whose decode left the dynamic table
+   * untouched, and a hit requires the table's insert count, stored
+   * bytes and capacity to match the entry, so any intervening insert,
+   * eviction or resize turns the lookup into a miss.  Exact block bytes
+   * are compared on hit to rule out hash collisions.
+   */
+  void enableDecodedBlockCache(
+      size_t maxEntries = kDefaultDecodedBlockCacheEntries,
+      uint32_t maxBlockBytes = kDefaultDecodedBlockCacheBlockBytes);
+
+  uint64_t getDecodedBlockCacheHits() const {
+    return decodedBlockCacheHits_;
+  }
+
+  /**
+   * Decode the whole block into a vector and deliver it through a single
+   * onHeaderBlock call; see HPACKDecoder::decodeBulk.
+   */
+  void decodeBulk(folly::io::Cursor& cursor,
+                  uint32_t length,
+                  HPACK::StreamingCallback* streamingCb) noexcept;
+
   void setEncoderHeaderTableSize(uint32_t size) {
     encoder_.setHeaderTableSize(size);
   }
@@ -68,9 +96,59 @@ class HPACKCodec : public HeaderCodec {
     decoder_.setHeaderTableMaxSize(size);
   }
 
+  /**
+   * Export the encoder's dynamic table as an opaque blob so a resumed
+   * connection -- possibly to a different box -- can start with a warm
+   * table instead of re-sending every common header as a literal.  The
+   * blob is meant to travel with the TLS session ticket (see
+   * PersistentFizzPskCache::putWarmHeaderState).
+   *
+   * This is a private extension with no wire representation: it is only
+   * sound when both endpoints install the same blob before the first
+   * header block flows -- the exporter imports it into its encoder via
+   * importWarmTableState() and the peer into its decoder via
+   * importPeerWarmTableState().  Entries are serialized oldest-first so
+   * importing reproduces the original indices.
+   */
+  std::string exportWarmTableState() const;
+
+  /**
+   * Pre-populate the encoder's dynamic table from a blob produced by
+   * exportWarmTableState().  Must be called before anything has been
+   * encoded; returns false and leaves the table untouched if traffic
+   * has already flowed, the blob is malformed, or an entry does not fit
+   * the current table capacity.
+   */
+  bool importWarmTableState(folly::StringPiece blob);
+
+  /**
+   * Decoder-side counterpart of importWarmTableState(), for the
+   * endpoint that received the blob alongside the session ticket.
+   */
+  bool importPeerWarmTableState(folly::StringPiece blob);
+
   void describe(std::ostream& os) const;
 
-  void setMaxUncompressed(uint64_t maxUncompressed) override {
+  /**
+   * Restore encoder and decoder to their freshly-constructed state,
+   * keeping table allocations, so the codec can be reused on a new
+   * connection.
+   */
+  void reset() {
+    encoder_.reset();
+    decoder_.reset();
+    decodedBlockCache_.clear();
+    encodedSize_ = HTTPHeaderSize();
+    // table eviction counters survive encoder_.reset(); re-baseline the
+    // per-block snapshots against the current values
+    prevStaticRefs_ = encoder_.getStaticRefs();
+    prevDynamicRefs_ = encoder_.getDynamicRefs();
+    prevLiterals_ = encoder_.getLiteralsEncoded();
+    prevEvictions_ = encoder_.getTable().getEvictions();
+    prevEvictionWaste_ = encoder_.getTable().getEvictedNeverReusedBytes();
+  }
+
+  void setMaxUncompressed(uint64_t maxUncompressed) {
     HeaderCodec::setMaxUncompressed(maxUncompressed);
     decoder_.setMaxUncompressed(maxUncompressed);
   }
@@ -99,15 +177,62 @@ class HPACKCodec : public HeaderCodec {
     return encoder_.getHeaderIndexingStrategy();
   }
 
+  void setIndexingHints(HPACKIndexingHints* hints) {
+    encoder_.setIndexingHints(hints);
+  }
+
  protected:
   HPACKEncoder encoder_;
   HPACKDecoder decoder_;
 
+ public:
+  static constexpr size_t kDefaultDecodedBlockCacheEntries = 4;
+  static constexpr uint32_t kDefaultDecodedBlockCacheBlockBytes = 1024;
+
  private:
   void recordCompressedSize(const folly::IOBuf* buf);
   void recordCompressedSize(size_t size);
+  void recordTableEfficiency();
+
+  struct DecodedBlockCacheEntry {
+    // Exact compressed bytes, the collision guard behind the hash
+    std::string block;
+    uint64_t hash{0};
+    // Decoder table state the entry was decoded under; all three must
+    // still match for the stored headers to be valid
+    uint32_t insertCount{0};
+    uint32_t bytesStored{0};
+    uint32_t tableCapacity{0};
+    std::vector<HPACKHeader> headers;
+    HTTPHeaderSize decodedSize;
+    bool acknowledge{false};
+  };
+
+  /**
+   * Serve the block from the fingerprint cache, or decode it while
+   * recording a new entry.  Returns false when the cache is disabled or
+   * cannot handle this block, in which case the caller decodes as usual.
+   */
+  bool decodeWithBlockCache(folly::io::Cursor& cursor,
+                            uint32_t length,
+                            HPACK::StreamingCallback* streamingCb,
+                            bool bulk) noexcept;
 
   std::vector<HPACKHeader> decodedHeaders_;
+
+  // MRU-ordered, see decodeWithBlockCache()
+  std::list<DecodedBlockCacheEntry> decodedBlockCache_;
+  size_t decodedBlockCacheMaxEntries_{0};
+  uint32_t decodedBlockCacheMaxBlockBytes_{0};
+  uint64_t decodedBlockCacheHits_{0};
+
+  // Snapshots of the encoder's running counters at the last reported
+  // block, so recordTableEfficiency() can emit per-block deltas
+  uint32_t prevStaticRefs_{0};
+  uint32_t prevDynamicRefs_{0};
+  uint32_t prevLiterals_{0};
+  uint32_t prevEvictions_{0};
+  uint64_t prevEvictionWaste_{0};
 };
 
 std::ostream& operator<<(std::ostream& os, const HPACKCodec& codec);
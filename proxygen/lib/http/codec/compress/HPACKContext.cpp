@@ -47,6 +47,7 @@ uint32_t HPACKContext::getIndex(const HPACKHeaderName& name,
   // Else check the dynamic table
   uint32_t dynamicIndex = table_.getIndex(name, value);
   if (dynamicIndex) {
+    dynamicRefs_++;
     return dynamicToGlobalIndex(dynamicIndex);
   } else {
     return dynamicIndex;
@@ -66,12 +66,30 @@ class HPACKContext {
 
   void seedHeaderTable(std::vector<HPACKHeader>& headers);
 
+  /**
+   * Empty the dynamic table and restore its default capacity, keeping
+   * the underlying allocation warm so the context can serve a new
+   * connection.
+   */
+  void reset() {
+    table_.reset();
+    if (table_.capacity() != HPACK::kTableSize) {
+      table_.setCapacity(HPACK::kTableSize);
+    }
+    staticRefs_ = 0;
+    dynamicRefs_ = 0;
+  }
+
   void describe(std::ostream& os) const;
 
   uint32_t getStaticRefs() const {
     return staticRefs_;
   }
 
+  uint32_t getDynamicRefs() const {
+    return dynamicRefs_;
+  }
+
   uint32_t getInsertCount() const {
     return table_.getInsertCount();
   }
@@ -96,6 +114,7 @@ class HPACKContext {
 
   HeaderTable table_;
   mutable uint32_t staticRefs_{0};
+  mutable uint32_t dynamicRefs_{0};
 };
 
 std::ostream& operator<<(std::ostream& os, const HPACKContext& context);
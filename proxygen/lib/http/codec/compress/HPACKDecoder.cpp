@@ -39,6 +39,35 @@ void HPACKDecoder::decodeStreaming(Cursor& cursor,
                  emittedSize);
 }
 
+void HPACKDecoder::decodeBulk(Cursor& cursor,
+                              uint32_t totalBytes,
+                              HPACK::StreamingCallback* streamingCb) {
+  HPACKDecodeBuffer dbuf(cursor, totalBytes, maxUncompressed_);
+  uint32_t emittedSize = 0;
+  emittedHeaders_.clear();
+
+  while (!hasError() && !dbuf.empty()) {
+    emittedSize += decodeHeader(dbuf, nullptr, &emittedHeaders_);
+
+    if (emittedSize > maxUncompressed_) {
+      LOG(ERROR) << "exceeded uncompressed size limit of " << maxUncompressed_
+                 << " bytes";
+      err_ = HPACK::DecodeError::HEADERS_TOO_LARGE;
+      break;
+    }
+    emittedSize += 2;
+  }
+  if (!hasError()) {
+    streamingCb->onHeaderBlock(emittedHeaders_);
+  }
+  auto compressedSize = dbuf.consumedBytes();
+  completeDecode(HeaderCodec::Type::HPACK,
+                 streamingCb,
+                 compressedSize,
+                 compressedSize,
+                 emittedSize);
+}
+
 uint32_t HPACKDecoder::decodeLiteralHeader(
     HPACKDecodeBuffer& dbuf,
     HPACK::StreamingCallback* streamingCb,
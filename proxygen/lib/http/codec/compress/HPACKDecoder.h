@@ -36,10 +36,31 @@ class HPACKDecoder
                        uint32_t totalBytes,
                        HPACK::StreamingCallback* streamingCb);
 
+  /**
+   * Like decodeStreaming, but the entire header block is decoded into a
+   * reusable vector first and handed to the callback through a single
+   * onHeaderBlock call, skipping the per-header virtual dispatch.  The
+   * emitted entries own their strings, so they remain valid even if the
+   * source table entry is evicted later in the block.
+   */
+  void decodeBulk(folly::io::Cursor& cursor,
+                  uint32_t totalBytes,
+                  HPACK::StreamingCallback* streamingCb);
+
   void setHeaderTableMaxSize(uint32_t maxSize) {
     HPACKDecoderBase::setHeaderTableMaxSize(table_, maxSize);
   }
 
+  /**
+   * Restore the decoder to its freshly-constructed state for reuse on a
+   * new connection.
+   */
+  void reset() {
+    HPACKContext::reset();
+    err_ = HPACK::DecodeError::NONE;
+    maxTableSize_ = HPACK::kTableSize;
+  }
+
  private:
   bool isValid(uint32_t index);
 
@@ -54,6 +75,9 @@ class HPACKDecoder
   uint32_t decodeHeader(HPACKDecodeBuffer& dbuf,
                         HPACK::StreamingCallback* streamingCb,
                         headers_t* emitted);
+
+  // scratch space for decodeBulk; cleared per block, capacity retained
+  headers_t emittedHeaders_;
 };
 
 } // namespace proxygen
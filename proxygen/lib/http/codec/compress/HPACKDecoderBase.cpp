@@ -11,6 +11,18 @@
 
 namespace proxygen {
 
+uint32_t HPACKDecoderBase::emit(const HPACKHeaderName& name,
+                                folly::StringPiece value,
+                                HPACK::StreamingCallback* streamingCb,
+                                headers_t* emitted) {
+  if (streamingCb) {
+    streamingCb->onHeader(name, folly::fbstring(value.data(), value.size()));
+  } else if (emitted) {
+    emitted->emplace_back(name.get(), value);
+  }
+  return HPACKHeader::realBytes(name.size(), value.size());
+}
+
 uint32_t HPACKDecoderBase::emit(const HPACKHeader& header,
                                 HPACK::StreamingCallback* streamingCb,
                                 headers_t* emitted) {
@@ -43,6 +43,15 @@ class HPACKDecoderBase {
   }
 
  protected:
+  /**
+   * Emit a header materialized from table storage; the value may be a view
+   * into the table's byte ring.
+   */
+  uint32_t emit(const HPACKHeaderName& name,
+                folly::StringPiece value,
+                HPACK::StreamingCallback* streamingCb,
+                headers_t* emitted);
+
   uint32_t emit(const HPACKHeader& header,
                 HPACK::StreamingCallback* streamingCb,
                 headers_t* emitted);
@@ -124,7 +124,19 @@ uint32_t HPACKEncodeBuffer::encodeLiteral(folly::StringPiece literal) {
 uint32_t HPACKEncodeBuffer::encodeLiteral(uint8_t instruction,
                                           uint8_t nbit,
                                           folly::StringPiece literal) {
-  if (huffmanEnabled_) {
+  return encodeLiteral(instruction, nbit, literal, shouldHuffman(literal));
+}
+
+uint32_t HPACKEncodeBuffer::encodeLiteral(folly::StringPiece literal,
+                                          bool useHuffman) {
+  return encodeLiteral(0, 7, literal, useHuffman);
+}
+
+uint32_t HPACKEncodeBuffer::encodeLiteral(uint8_t instruction,
+                                          uint8_t nbit,
+                                          folly::StringPiece literal,
+                                          bool useHuffman) {
+  if (huffmanEnabled_ && useHuffman) {
     return encodeHuffman(instruction, nbit, literal);
   }
   // otherwise use simple layout
@@ -135,6 +147,25 @@ uint32_t HPACKEncodeBuffer::encodeLiteral(uint8_t instruction,
   return count;
 }
 
+bool HPACKEncodeBuffer::shouldHuffman(folly::StringPiece literal) const {
+  if (!huffmanEnabled_) {
+    return false;
+  }
+  static const auto& huffmanTree = huffman::huffTree();
+  if (literal.size() <= kHuffmanSampleSize) {
+    // Cheap enough to measure exactly; also keeps short literals
+    // byte-identical to the unconditional-Huffman encoding
+    return huffmanTree.getEncodeSize(literal) < literal.size() ||
+           literal.empty();
+  }
+  // High-entropy values (UUIDs, signatures, base64 tokens) encode at or
+  // above one byte per byte; estimate from a prefix and skip the full
+  // encode pass when the projected savings are under 1/8
+  uint32_t sampleSize =
+      huffmanTree.getEncodeSize(literal.subpiece(0, kHuffmanSampleSize));
+  return sampleSize * 8 <= kHuffmanSampleSize * 7;
+}
+
 string HPACKEncodeBuffer::toBin() {
   return IOBufPrinter::printBin(bufQueuePtr_->front());
 }
@@ -82,6 +82,27 @@ class HPACKEncodeBuffer {
                          uint8_t nbit,
                          folly::StringPiece literal);
 
+  /**
+   * Variants taking a precomputed Huffman decision, for callers that
+   * remember shouldHuffman() results across literals (e.g. per header
+   * name).  The plain layout is used when useHuffman is false.
+   */
+  uint32_t encodeLiteral(folly::StringPiece literal, bool useHuffman);
+
+  uint32_t encodeLiteral(uint8_t instruction,
+                         uint8_t nbit,
+                         folly::StringPiece literal,
+                         bool useHuffman);
+
+  /**
+   * Whether Huffman coding is expected to shrink the literal.  Short
+   * literals are measured exactly; longer ones are estimated from the
+   * Huffman code lengths of a 16-byte prefix, so high-entropy values
+   * (UUIDs, signatures) skip the full encode pass without scanning the
+   * whole string.  Always false when Huffman is disabled.
+   */
+  bool shouldHuffman(folly::StringPiece literal) const;
+
   /**
    * encodes a string using huffman encoding
    */
@@ -110,6 +131,9 @@ class HPACKEncodeBuffer {
   }
 
  private:
+  // Prefix length sampled by shouldHuffman() on long literals
+  static constexpr uint32_t kHuffmanSampleSize = 16;
+
   /**
    * append one byte at the end of buffer ensuring we always have enough space
    */
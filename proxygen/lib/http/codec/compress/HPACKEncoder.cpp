@@ -8,6 +8,8 @@
 
 #include <proxygen/lib/http/codec/compress/HPACKEncoder.h>
 
+#include <proxygen/lib/http/codec/compress/HPACKIndexingHints.h>
+
 using std::vector;
 
 namespace proxygen {
@@ -84,6 +86,12 @@ void HPACKEncoder::encodeAsLiteralImpl(const HPACKHeaderName& name,
       (indexing) ? HPACK::LITERAL_INC_INDEX : HPACK::LITERAL;
 
   encodeLiteral(name, value, nameIndex(name), instruction);
+
+  // Pairs that earn table space are worth indexing early on future
+  // connections sharing these hints
+  if (indexing && indexingHints_) {
+    indexingHints_->recordIndexed(name, value);
+  }
 }
 
 bool HPACKEncoder::encodeAsLiteral(const HPACKHeaderName& name,
@@ -123,6 +131,7 @@ void HPACKEncoder::encodeLiteral(const HPACKHeaderName& name,
                                  folly::StringPiece value,
                                  uint32_t nameIndex,
                                  const HPACK::Instruction& instruction) {
+  literalsEncoded_++;
   // name
   if (nameIndex) {
     VLOG(10) << "encoding name index=" << nameIndex;
@@ -132,7 +141,22 @@ void HPACKEncoder::encodeLiteral(const HPACKHeaderName& name,
     streamBuffer_.encodeLiteral(name.get());
   }
   // value
-  streamBuffer_.encodeLiteral(value);
+  streamBuffer_.encodeLiteral(value, shouldHuffmanValue(name, value));
+}
+
+bool HPACKEncoder::shouldHuffmanValue(const HPACKHeaderName& name,
+                                      folly::StringPiece value) {
+  auto it = huffmanByName_.find(name.get());
+  if (it != huffmanByName_.end()) {
+    return it->second;
+  }
+  bool decision = streamBuffer_.shouldHuffman(value);
+  if (huffmanByName_.size() >= kMaxHuffmanDecisions) {
+    // Past any sane header-name cardinality; start over rather than grow
+    huffmanByName_.clear();
+  }
+  huffmanByName_.emplace(name.get(), decision);
+  return decision;
 }
 
 void HPACKEncoder::encodeAsIndex(uint32_t index) {
@@ -147,6 +171,12 @@ bool HPACKEncoder::encodeHeaderImpl(const HPACKHeaderName& name,
   // set strategy if applicable, else assume it is indexable
   indexable = !indexingStrat_ || indexingStrat_->indexHeader(name, value);
 
+  // A pair that proved itself on prior connections skips the strategy's
+  // ramp and gets indexed on first sight
+  if (!indexable && indexingHints_ && indexingHints_->wasIndexed(name, value)) {
+    indexable = true;
+  }
+
   // If the header was not defined as indexable, its a reasonable assumption
   // that it does not appear in either the static or dynamic table and should
   // not be searched.  The only time this is not true is if the header indexing
@@ -11,6 +11,7 @@
 #include <folly/io/IOBuf.h>
 #include <proxygen/lib/http/codec/compress/HPACKConstants.h>
 #include <proxygen/lib/http/codec/compress/HPACKEncoderBase.h>
+#include <unordered_map>
 #include <vector>
 
 namespace proxygen {
@@ -24,6 +25,25 @@ class HPACKEncoder
       : HPACKEncoderBase(huffman), HPACKContext(tableSize) {
   }
 
+  /**
+   * Restore the encoder to its freshly-constructed state for reuse on a
+   * new connection.
+   */
+  void reset() {
+    HPACKContext::reset();
+    pendingContextUpdate_ = false;
+    huffmanByName_.clear();
+    literalsEncoded_ = 0;
+  }
+
+  /**
+   * Running count of headers encoded as literals (with or without
+   * incremental indexing).
+   */
+  uint32_t getLiteralsEncoded() const {
+    return literalsEncoded_;
+  }
+
   /**
    * Encode the given headers.
    */
@@ -84,6 +104,17 @@ class HPACKEncoder
                      folly::StringPiece value,
                      uint32_t nameIndex,
                      const HPACK::Instruction& instruction);
+
+  bool shouldHuffmanValue(const HPACKHeaderName& name,
+                          folly::StringPiece value);
+
+  // Remembered Huffman decisions keyed by header name: a name whose
+  // values never compress (request ids, signatures) is sampled once per
+  // connection instead of per occurrence
+  static constexpr size_t kMaxHuffmanDecisions = 128;
+  std::unordered_map<std::string, bool> huffmanByName_;
+
+  uint32_t literalsEncoded_{0};
 };
 
 } // namespace proxygen
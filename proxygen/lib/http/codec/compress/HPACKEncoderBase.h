@@ -14,6 +14,8 @@
 
 namespace proxygen {
 
+class HPACKIndexingHints;
+
 /**
  * Common encoder functionality between HPACK and QPACK
  */
@@ -45,11 +47,24 @@ class HPACKEncoderBase {
     return indexingStrat_;
   }
 
+  /**
+   * Attach a (usually process-wide) record of pairs that earned dynamic
+   * table slots on prior connections, so this encoder indexes them on
+   * first occurrence.  The hints must outlive the encoder.
+   */
+  void setIndexingHints(HPACKIndexingHints* hints) {
+    indexingHints_ = hints;
+  }
+  HPACKIndexingHints* getIndexingHints() const {
+    return indexingHints_;
+  }
+
  protected:
   uint32_t handlePendingContextUpdate(HPACKEncodeBuffer& buf,
                                       uint32_t tableCapacity);
 
   const HeaderIndexingStrategy* indexingStrat_;
+  HPACKIndexingHints* indexingHints_{nullptr};
   HPACKEncodeBuffer streamBuffer_;
   bool pendingContextUpdate_{false};
 };
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/http/codec/compress/HPACKIndexingHints.h>
+
+#include <algorithm>
+
+namespace proxygen {
+
+std::string HPACKIndexingHints::makeKey(const HPACKHeaderName& name,
+                                        folly::StringPiece value) {
+  std::string key;
+  key.reserve(name.size() + value.size() + 1);
+  key.append(name.get());
+  key.push_back('\0');
+  key.append(value.data(), value.size());
+  return key;
+}
+
+void HPACKIndexingHints::recordIndexed(const HPACKHeaderName& name,
+                                       folly::StringPiece value) {
+  auto key = makeKey(name, value);
+  auto counts = counts_.wlock();
+  auto it = counts->find(key);
+  if (it != counts->end()) {
+    it->second++;
+  } else if (counts->size() < kMaxTracked) {
+    counts->emplace(std::move(key), 1);
+  }
+}
+
+bool HPACKIndexingHints::wasIndexed(const HPACKHeaderName& name,
+                                    folly::StringPiece value) const {
+  auto key = makeKey(name, value);
+  auto counts = counts_.rlock();
+  auto it = counts->find(key);
+  return it != counts->end() && it->second >= threshold_;
+}
+
+std::vector<HPACKHeader> HPACKIndexingHints::rankedEntries(
+    uint32_t maxBytes) const {
+  std::vector<std::pair<folly::StringPiece, uint64_t>> ranked;
+  auto counts = counts_.rlock();
+  ranked.reserve(counts->size());
+  for (const auto& entry : *counts) {
+    if (entry.second >= threshold_) {
+      ranked.emplace_back(entry.first, entry.second);
+    }
+  }
+  std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {
+    if (a.second != b.second) {
+      return a.second > b.second;
+    }
+    return a.first < b.first;
+  });
+
+  std::vector<HPACKHeader> result;
+  uint64_t bytes = 0;
+  for (const auto& entry : ranked) {
+    auto sep = entry.first.find('\0');
+    DCHECK_NE(sep, folly::StringPiece::npos);
+    auto name = entry.first.subpiece(0, sep);
+    auto value = entry.first.subpiece(sep + 1);
+    bytes += HPACKHeader::bytes(name.size(), value.size());
+    if (bytes > maxBytes) {
+      break;
+    }
+    result.emplace_back(name, value);
+  }
+  return result;
+}
+
+} // namespace proxygen
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <proxygen/lib/http/codec/compress/HPACKHeader.h>
+#include <unordered_map>
+#include <vector>
+
+namespace proxygen {
+
+/**
+ * A process-level, read-mostly record of which name/value pairs earned
+ * dynamic table slots on prior connections.  A freshly created encoder
+ * starts with an empty dynamic table, so every recurring header (auth
+ * tokens, tracing baggage, ...) pays the literal + indexing ramp again
+ * on each new upstream connection.  Sharing one instance of this class
+ * across encoders lets a new connection index those proven pairs on
+ * their first occurrence instead of rediscovering them.
+ *
+ * HPACK has no out-of-band table instruction (unlike the QPACK encoder
+ * stream), so entries cannot literally be inserted right after SETTINGS
+ * without desynchronizing the decoder; upgrading the first-use indexing
+ * decision is the closest the protocol allows.  rankedEntries() exposes
+ * the best pairs in ranked order for callers that can pre-insert, e.g.
+ * to seed a QPACK encoder stream or for diagnostics.
+ *
+ * recordIndexed() takes a write lock but only runs when an encoder
+ * actually inserts into its table, which is rare at steady state;
+ * wasIndexed() takes a shared lock and only runs for headers the
+ * indexing strategy declined.
+ */
+class HPACKIndexingHints {
+ public:
+  // Trust a pair once this many connections chose to index it
+  static constexpr uint64_t kDefaultHintThreshold = 2;
+
+  explicit HPACKIndexingHints(uint64_t hintThreshold = kDefaultHintThreshold)
+      : threshold_(hintThreshold) {
+  }
+
+  /**
+   * Note that an encoder added this pair to its dynamic table.
+   */
+  void recordIndexed(const HPACKHeaderName& name, folly::StringPiece value);
+
+  /**
+   * Whether this pair has earned table space often enough that a new
+   * connection should index it on first sight.
+   */
+  bool wasIndexed(const HPACKHeaderName& name, folly::StringPiece value) const;
+
+  /**
+   * The best known pairs, most frequently indexed first, cut off once
+   * their cumulative HPACK table cost would exceed maxBytes.
+   */
+  std::vector<HPACKHeader> rankedEntries(uint32_t maxBytes) const;
+
+ private:
+  // Stop admitting new pairs past this many distinct keys; existing
+  // pairs keep counting
+  static constexpr size_t kMaxTracked = 512;
+
+  static std::string makeKey(const HPACKHeaderName& name,
+                             folly::StringPiece value);
+
+  const uint64_t threshold_;
+
+  // name + '\0' + value -> times an encoder indexed the pair
+  folly::Synchronized<std::unordered_map<std::string, uint64_t>> counts_;
+};
+
+} // namespace proxygen
@@ -8,7 +8,10 @@
 
 #pragma once
 
+#include <vector>
+
 #include <proxygen/lib/http/codec/compress/HPACKConstants.h>
+#include <proxygen/lib/http/codec/compress/HPACKHeader.h>
 #include <proxygen/lib/http/codec/compress/HPACKHeaderName.h>
 #include <proxygen/lib/http/codec/compress/HeaderCodec.h>
 
@@ -20,6 +23,18 @@ class StreamingCallback {
 
   virtual void onHeader(const HPACKHeaderName& name,
                         const folly::fbstring& value) = 0;
+
+  /**
+   * Delivery hook for bulk decoding (HPACKDecoder::decodeBulk): the whole
+   * header block arrives in one call instead of one virtual dispatch per
+   * header.  Callbacks that have not been taught bulk emission fall back
+   * to the per-header path.
+   */
+  virtual void onHeaderBlock(const std::vector<HPACKHeader>& headers) {
+    for (const auto& header : headers) {
+      onHeader(header.name, header.value);
+    }
+  }
   virtual void onHeadersComplete(HTTPHeaderSize decodedSize,
                                  bool acknowledge) = 0;
   virtual void onDecodeError(HPACK::DecodeError decodeError) = 0;
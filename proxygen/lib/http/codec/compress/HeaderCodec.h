@@ -38,6 +38,24 @@ class HeaderCodec {
 
   enum class Type : uint8_t { GZIP = 0, HPACK = 1, QPACK = 2 };
 
+  /**
+   * Per-block sample of how the encoder's dynamic table is earning its
+   * keep: how the headers in one encoded block were represented, plus
+   * table churn since the previous block.  Cheap to produce -- the
+   * codecs keep running counters and emit deltas once per block.
+   */
+  struct TableEfficiency {
+    uint32_t staticHits{0};
+    uint32_t dynamicHits{0};
+    uint32_t literals{0};
+    uint32_t evictions{0};
+    // bytes of evicted entries that were never referenced after
+    // insertion -- table space spent indexing headers that never repeat
+    uint64_t evictedBytesNeverReused{0};
+    // dynamic table fill level, 0-100
+    uint32_t tableOccupancyPct{0};
+  };
+
   class Stats {
    public:
     Stats() {
@@ -49,12 +67,26 @@ class HeaderCodec {
     virtual void recordDecode(Type type, HTTPHeaderSize& size) = 0;
     virtual void recordDecodeError(Type type) = 0;
     virtual void recordDecodeTooLarge(Type type) = 0;
+
+    /**
+     * Indexing decision made by a learning HeaderIndexingStrategy; see
+     * FrequencyIndexingStrategy.  Default is a no-op so existing stats
+     * implementations are unaffected.
+     */
+    virtual void recordIndexingDecision(bool /*indexed*/) {
+    }
+
+    /**
+     * One TableEfficiency sample per encoded header block.  Default is
+     * a no-op so existing stats implementations are unaffected.
+     */
+    virtual void recordTableEfficiency(Type /*type*/,
+                                       const TableEfficiency& /*sample*/) {
+    }
   };
 
   HeaderCodec() {
   }
-  virtual ~HeaderCodec() {
-  }
 
   /**
    * compressed and uncompressed size of the last encode
@@ -70,7 +102,7 @@ class HeaderCodec {
     encodeHeadroom_ = headroom;
   }
 
-  virtual void setMaxUncompressed(uint64_t maxUncompressed) {
+  void setMaxUncompressed(uint64_t maxUncompressed) {
     maxUncompressed_ = maxUncompressed;
   }
 
@@ -86,6 +118,13 @@ class HeaderCodec {
   }
 
  protected:
+  // Not a polymorphic base: codecs are always held and dispatched by
+  // concrete type (HPACKCodec, QPACKCodec, GzipHeaderCodec), so this
+  // class carries no vtable and derived codecs pay no vptr or virtual
+  // dispatch on the header hot path.  Subclasses shadow
+  // setMaxUncompressed() where they need to propagate the limit.
+  ~HeaderCodec() = default;
+
   HTTPHeaderSize encodedSize_;
   uint32_t encodeHeadroom_{0};
   uint64_t maxUncompressed_{kMaxUncompressed};
@@ -81,7 +81,9 @@ uint32_t HeaderTable::getIndexImpl(const HPACKHeaderName& headerName,
        ++indexIt) {
     auto i = *indexIt;
     if (nameOnly || table_[i].value == value) {
-      return toExternal(i);
+      auto external = toExternal(i);
+      markEntryReferenced(insertCount_ - external + 1);
+      return external;
     }
   }
   return 0;
@@ -126,12 +128,15 @@ uint32_t HeaderTable::removeLast() {
   bytes_ -= headerBytes;
   VLOG(10) << "Removing local idx=" << t << " name=" << header.name
            << " value=" << header.value;
+  // the tail is the oldest insert still in the table
+  recordEviction(insertCount_ - size_ + 1, headerBytes);
   --size_;
   return headerBytes;
 }
 
 void HeaderTable::reset() {
   names_.clear();
+  referencedInserts_.clear();
 
   bytes_ = 0;
   size_ = 0;
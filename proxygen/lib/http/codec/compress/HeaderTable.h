@@ -13,6 +13,7 @@
 #include <vector>
 
 #include <folly/container/F14Map.h>
+#include <folly/container/F14Set.h>
 #include <proxygen/lib/http/codec/compress/HPACKHeader.h>
 
 namespace proxygen {
@@ -137,6 +138,21 @@ class HeaderTable {
     return table_.size();
   }
 
+  /**
+   * Total number of entries evicted from this table.
+   */
+  uint32_t getEvictions() const {
+    return evictions_;
+  }
+
+  /**
+   * Bytes of evicted entries that were never referenced by a lookup
+   * after insertion -- table space spent on headers that never repeated.
+   */
+  uint64_t getEvictedNeverReusedBytes() const {
+    return evictedNeverReusedBytes_;
+  }
+
   bool operator==(const HeaderTable& other) const;
 
   /**
@@ -184,6 +200,26 @@ class HeaderTable {
    */
   virtual uint32_t evict(uint32_t needed, uint32_t desiredCapacity);
 
+  /**
+   * Note that the entry with the given absolute insert number satisfied
+   * a lookup, so its eviction won't count as wasted bytes.
+   */
+  void markEntryReferenced(uint32_t absoluteIndex) const {
+    referencedInserts_.insert(absoluteIndex);
+  }
+
+  /**
+   * Account for the eviction of the entry with the given absolute insert
+   * number; entries never marked referenced charge their bytes to
+   * evictedNeverReusedBytes_.
+   */
+  void recordEviction(uint32_t absoluteIndex, uint32_t headerBytes) {
+    evictions_++;
+    if (referencedInserts_.erase(absoluteIndex) == 0) {
+      evictedNeverReusedBytes_ += headerBytes;
+    }
+  }
+
   /**
    * Move the index to the right.
    */
@@ -214,6 +250,13 @@ class HeaderTable {
 
   names_map names_;
 
+  // Eviction efficiency accounting; see recordEviction().  The set is
+  // keyed on absolute insert numbers and bounded by the live entry
+  // count, since recordEviction erases as entries leave the table.
+  uint32_t evictions_{0};
+  uint64_t evictedNeverReusedBytes_{0};
+  mutable folly::F14FastSet<uint32_t> referencedInserts_;
+
  private:
   /*
    * Shared implementation for getIndex and nameIndex
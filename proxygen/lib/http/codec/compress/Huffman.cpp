@@ -9,6 +9,7 @@
 #include <proxygen/lib/http/codec/compress/Huffman.h>
 
 #include <folly/Indestructible.h>
+#include <folly/Likely.h>
 #include <folly/portability/Sockets.h>
 
 using std::pair;
@@ -28,6 +29,14 @@ HuffTree::HuffTree(const HuffTree& tree)
 bool HuffTree::decode(const uint8_t* buf,
                       uint32_t size,
                       folly::fbstring& literal) const {
+  // the shortest huffman code is 5 bits, so `size` bytes decode to at most
+  // size * 8 / 5 characters; reserving upfront keeps the appends below from
+  // reallocating mid-decode
+  literal.reserve(literal.size() + size * 8 / 5 + 1);
+  // stage decoded characters in a local buffer and append in bulk instead of
+  // a push_back (with its capacity check) per symbol
+  char out[512];
+  size_t outlen = 0;
   const SuperHuffNode* snode = &table_[0];
   uint32_t w = 0;
   uint32_t wbits = 0;
@@ -54,7 +63,11 @@ bool HuffTree::decode(const uint8_t* buf,
     const HuffNode& node = snode->index[key];
     if (node.isLeaf()) {
       // final node, we can emit the character
-      literal.push_back(node.data.ch);
+      out[outlen++] = node.data.ch;
+      if (UNLIKELY(outlen == sizeof(out))) {
+        literal.append(out, outlen);
+        outlen = 0;
+      }
       wbits -= node.metadata.bits;
       snode = &table_[0];
     } else {
@@ -65,6 +78,9 @@ bool HuffTree::decode(const uint8_t* buf,
     // remove what we've just used
     w = w & ((1 << wbits) - 1);
   }
+  if (outlen > 0) {
+    literal.append(out, outlen);
+  }
   return true;
 }
 
@@ -128,35 +144,72 @@ void HuffTree::buildTree() {
   for (uint32_t i = 0; i < kTableSize; i++) {
     insert(codes_[i], bits_[i], i);
   }
+  buildPairTable();
+}
+
+/**
+ * precomputes the combined code for every pair of bytes whose codes fit
+ * together in 32 bits; the few pairs that don't (both bytes rare) are
+ * marked with length 0 and encode() falls back to the per-symbol tables
+ */
+void HuffTree::buildPairTable() {
+  pairCodes_ = std::make_unique<uint32_t[]>(kPairTableSize);
+  pairBits_ = std::make_unique<uint8_t[]>(kPairTableSize);
+  for (uint32_t a = 0; a < kTableSize; a++) {
+    for (uint32_t b = 0; b < kTableSize; b++) {
+      const uint32_t idx = (a << 8) | b;
+      const uint32_t combined = bits_[a] + bits_[b];
+      if (combined <= 32) {
+        pairCodes_[idx] = (codes_[a] << bits_[b]) | codes_[b];
+        pairBits_[idx] = combined;
+      } else {
+        pairCodes_[idx] = 0;
+        pairBits_[idx] = 0;
+      }
+    }
+  }
 }
 
 uint32_t HuffTree::encode(folly::StringPiece literal,
                           folly::io::QueueAppender& buf) const {
-  uint32_t code;     // the huffman code of a given character
-  uint8_t bits;      // on how many bits code is represented
-  uint32_t w = 0;    // 4-byte word used for packing bits and write it to memory
+  uint64_t w = 0;    // bit accumulator; holds at most 31 bits between appends
   uint8_t wbits = 0; // how many bits we have in 'w'
   uint32_t totalBytes = 0;
-  for (size_t i = 0; i < literal.size(); i++) {
-    uint8_t ch = literal[i];
-    code = codes_[ch];
-    bits = bits_[ch];
 
-    if (wbits + bits < 32) {
-      w = (w << bits) | code;
-      wbits += bits;
-    } else {
-      uint8_t xbits = wbits + bits - 32;
-      w = (w << (bits - xbits)) | (code >> xbits);
-      // write the word into the buffer by converting to network order, which
-      // takes care of the endianness problems
-      buf.writeBE<uint32_t>(w);
+  // append a code of up to 32 bits and flush full words; with wbits <= 31
+  // on entry the accumulator cannot overflow 64 bits
+  auto append = [&](uint32_t code, uint8_t bits) {
+    w = (w << bits) | code;
+    wbits += bits;
+    while (wbits >= 32) {
+      // write the word into the buffer by converting to network order,
+      // which takes care of the endianness problems
+      buf.writeBE<uint32_t>(uint32_t(w >> (wbits - 32)));
       totalBytes += 4;
-      // carry for next batch
-      wbits = xbits;
-      w = code & ((1 << xbits) - 1);
+      wbits -= 32;
+    }
+    w &= (uint64_t(1) << wbits) - 1;
+  };
+
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(literal.data());
+  const size_t size = literal.size();
+  size_t i = 0;
+  // consume two bytes per iteration through the precomputed pair table
+  for (; i + 1 < size; i += 2) {
+    const uint32_t idx = (uint32_t(data[i]) << 8) | data[i + 1];
+    const uint8_t bits = pairBits_[idx];
+    if (LIKELY(bits != 0)) {
+      append(pairCodes_[idx], bits);
+    } else {
+      // rare pair whose combined code doesn't fit in 32 bits
+      append(codes_[data[i]], bits_[data[i]]);
+      append(codes_[data[i + 1]], bits_[data[i + 1]]);
     }
   }
+  if (i < size) {
+    append(codes_[data[i]], bits_[data[i]]);
+  }
+
   // we might have some padding at the byte level
   if (wbits & 0x7) {
     // padding bits
@@ -168,29 +221,40 @@ uint32_t HuffTree::encode(folly::StringPiece literal,
   // we need to write the leftover bytes, from 1 to 4 bytes
   if (wbits > 0) {
     uint8_t bytes = wbits >> 3;
-    // align the bits to the MSB
-    w = w << (32 - wbits);
-    // set the bytes in the network order and copy w[0], w[1]...
-    w = htonl(w);
+    // align the bits to the MSB and set the bytes in the network order
+    uint32_t out = htonl(uint32_t(w) << (32 - wbits));
     // we need to use memcpy because we might write less than 4 bytes
-    buf.push((uint8_t*)&w, bytes);
+    buf.push((uint8_t*)&out, bytes);
     totalBytes += bytes;
   }
   return totalBytes;
 }
 
 uint32_t HuffTree::getEncodeSize(folly::StringPiece literal) const {
-  uint32_t totalBits = 0;
-  for (size_t i = 0; i < literal.size(); i++) {
-    // we just need the number of bits
-    uint8_t ch = literal[i];
-    totalBits += bits_[ch];
+  // four independent accumulators break the loop-carried dependency so the
+  // per-byte length lookups can overlap
+  uint32_t t0 = 0;
+  uint32_t t1 = 0;
+  uint32_t t2 = 0;
+  uint32_t t3 = 0;
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(literal.data());
+  const size_t size = literal.size();
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    t0 += bits_[data[i]];
+    t1 += bits_[data[i + 1]];
+    t2 += bits_[data[i + 2]];
+    t3 += bits_[data[i + 3]];
+  }
+  for (; i < size; i++) {
+    t0 += bits_[data[i]];
   }
-  uint32_t size = totalBits >> 3;
+  uint32_t totalBits = t0 + t1 + t2 + t3;
+  uint32_t encodedSize = totalBits >> 3;
   if (totalBits & 0x07) {
-    ++size;
+    ++encodedSize;
   }
-  return size;
+  return encodedSize;
 }
 
 pair<uint32_t, uint8_t> HuffTree::getCode(uint8_t ch) const {
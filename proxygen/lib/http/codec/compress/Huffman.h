@@ -11,6 +11,7 @@
 #include <folly/FBString.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
+#include <memory>
 #include <proxygen/lib/http/codec/compress/HPACKConstants.h>
 #include <string>
 
@@ -146,12 +147,20 @@ class HuffTree {
                  uint8_t ch,
                  uint8_t level);
   void buildTree();
+  void buildPairTable();
   void insert(uint32_t code, uint8_t bits, uint8_t ch);
 
   uint32_t nodes_{0};
   const uint32_t* codes_;
   const uint8_t* bits_;
 
+  // Precomputed combined code + length for every byte pair whose codes
+  // fit together in 32 bits, so encode() can consume two bytes per lookup.
+  // A length of 0 marks the rare pairs that fall back to per-symbol codes.
+  static const uint32_t kPairTableSize = 1 << 16;
+  std::unique_ptr<uint32_t[]> pairCodes_;
+  std::unique_ptr<uint8_t[]> pairBits_;
+
  protected:
   explicit HuffTree(const HuffTree& tree);
   SuperHuffNode table_[46];
@@ -39,9 +39,30 @@ void QPACKCodec::recordCompressedSize(const folly::IOBuf* stream,
   }
   if (stats_) {
     stats_->recordEncode(Type::QPACK, encodedSize_);
+    recordTableEfficiency();
   }
 }
 
+void QPACKCodec::recordTableEfficiency() {
+  TableEfficiency sample;
+  const auto& table = encoder_.getTable();
+  sample.staticHits = encoder_.getStaticRefs() - prevStaticRefs_;
+  sample.dynamicHits = encoder_.getDynamicRefs() - prevDynamicRefs_;
+  sample.literals = encoder_.getLiteralsEncoded() - prevLiterals_;
+  sample.evictions = table.getEvictions() - prevEvictions_;
+  sample.evictedBytesNeverReused =
+      table.getEvictedNeverReusedBytes() - prevEvictionWaste_;
+  if (table.capacity() > 0) {
+    sample.tableOccupancyPct = table.bytes() * 100 / table.capacity();
+  }
+  prevStaticRefs_ += sample.staticHits;
+  prevDynamicRefs_ += sample.dynamicHits;
+  prevLiterals_ += sample.literals;
+  prevEvictions_ += sample.evictions;
+  prevEvictionWaste_ += sample.evictedBytesNeverReused;
+  stats_->recordTableEfficiency(Type::QPACK, sample);
+}
+
 QPACKEncoder::EncodeResult QPACKCodec::encode(
     vector<Header>& headers,
     uint64_t streamId,
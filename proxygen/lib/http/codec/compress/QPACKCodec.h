@@ -35,8 +35,6 @@ class HPACKHeader;
 class QPACKCodec : public HeaderCodec {
  public:
   QPACKCodec();
-  ~QPACKCodec() override {
-  }
 
   // QPACK encode: id is used for internal tracking of references
   QPACKEncoder::EncodeResult encode(
@@ -112,7 +110,7 @@ class QPACKCodec : public HeaderCodec {
 
   void describe(std::ostream& os) const;
 
-  void setMaxUncompressed(uint64_t maxUncompressed) override {
+  void setMaxUncompressed(uint64_t maxUncompressed) {
     HeaderCodec::setMaxUncompressed(maxUncompressed);
     decoder_.setMaxUncompressed(maxUncompressed);
   }
@@ -167,8 +165,17 @@ class QPACKCodec : public HeaderCodec {
 
  private:
   void recordCompressedSize(const folly::IOBuf* stream, size_t controlSize);
+  void recordTableEfficiency();
 
   std::vector<HPACKHeader> decodedHeaders_;
+
+  // Snapshots of the encoder's running counters at the last reported
+  // block, so recordTableEfficiency() can emit per-block deltas
+  uint32_t prevStaticRefs_{0};
+  uint32_t prevDynamicRefs_{0};
+  uint32_t prevLiterals_{0};
+  uint32_t prevEvictions_{0};
+  uint64_t prevEvictionWaste_{0};
 };
 
 std::ostream& operator<<(std::ostream& os, const QPACKCodec& codec);
@@ -16,13 +16,15 @@ QPACKContext::QPACKContext(uint32_t tableSize, bool trackReferences)
     : table_(tableSize, trackReferences) {
 }
 
-const HPACKHeader& QPACKContext::getHeader(bool isStatic,
-                                           uint32_t index,
-                                           uint32_t base,
-                                           bool aboveBase) {
+QPACKHeaderTable::HeaderEntryView QPACKContext::getHeader(bool isStatic,
+                                                          uint32_t index,
+                                                          uint32_t base,
+                                                          bool aboveBase) {
   if (isStatic) {
     staticRefs_++;
-    return getStaticTable().getHeader(index);
+    const auto& header = getStaticTable().getHeader(index);
+    return QPACKHeaderTable::HeaderEntryView{header.name,
+                                             folly::StringPiece(header.value)};
   }
   if (aboveBase) {
     CHECK_LE(base, std::numeric_limits<uint32_t>::max() - index);
@@ -21,12 +21,14 @@ class QPACKContext {
   }
 
   /**
-   * @return header at the given index by composing dynamic and static tables
+   * @return view of the header at the given index by composing dynamic and
+   * static tables.  Views into the dynamic table are only valid until its
+   * next mutation.
    */
-  const HPACKHeader& getHeader(bool isStatic,
-                               uint32_t index,
-                               uint32_t base,
-                               bool aboveBase);
+  QPACKHeaderTable::HeaderEntryView getHeader(bool isStatic,
+                                              uint32_t index,
+                                              uint32_t base,
+                                              bool aboveBase);
 
   const QPACKHeaderTable& getTable() const {
     return table_;
@@ -60,6 +62,10 @@ class QPACKContext {
     return staticRefs_;
   }
 
+  uint32_t getDynamicRefs() const {
+    return dynamicRefs_;
+  }
+
   void seedHeaderTable(std::vector<HPACKHeader>& headers);
 
   void describe(std::ostream& os) const;
@@ -77,6 +83,7 @@ class QPACKContext {
   uint32_t blockedInsertions_{0};
   uint32_t duplications_{0};
   uint32_t staticRefs_{0};
+  uint32_t dynamicRefs_{0};
 };
 
 std::ostream& operator<<(std::ostream& os, const QPACKContext& context);
@@ -334,7 +334,9 @@ uint32_t QPACKDecoder::decodeLiteralHeaderQ(
   uint32_t emittedSize = emit(partial->header, streamingCb, nullptr);
 
   if (indexing) {
-    if (!table_.add(std::move(partial->header))) {
+    // The table copies the value into its storage ring, so partial keeps
+    // (and reuses) its own buffers across headers
+    if (!table_.add(partial->header.name, partial->header.value)) {
       // the only case is the header was > table capacity
       LOG(ERROR) << "Encoder inserted a header larger than capacity";
       err_ = HPACK::DecodeError::INSERT_TOO_LARGE;
@@ -368,8 +370,8 @@ uint32_t QPACKDecoder::decodeIndexedHeaderQ(
     return 0;
   }
 
-  auto& header = getHeader(isStatic, index, baseIndex_, aboveBase);
-  return emit(header, streamingCb, emitted);
+  auto header = getHeader(isStatic, index, baseIndex_, aboveBase);
+  return emit(header.name, header.value, streamingCb, emitted);
 }
 
 bool QPACKDecoder::isValid(bool isStatic, uint64_t index, bool aboveBase) {
@@ -118,8 +118,12 @@ size_t QPACKEncoder::encodeHeaderQ(HPACKHeaderName name,
   }
 
   bool indexable = shouldIndex(name, value);
+  folly::Optional<uint32_t> dynamicNameIndex;
   if (indexable) {
-    index = table_.getIndex(name, value, allowVulnerable());
+    // One probe resolves both the value match and the name-only match
+    auto dynIndex = table_.getIndexAndName(name, value, allowVulnerable());
+    index = dynIndex.valueIndex;
+    dynamicNameIndex = dynIndex.nameIndex;
     if (index == QPACKHeaderTable::UNACKED) {
       index = 0;
       indexable = false;
@@ -131,13 +135,16 @@ size_t QPACKEncoder::encodeHeaderQ(HPACKHeaderName name,
     std::tie(duplicated, index) = maybeDuplicate(index);
     // index is now 0 or absolute
     indexable &= (duplicated && index == 0);
+    // the duplicate may have changed the table; re-probe the name if needed
+    dynamicNameIndex.reset();
   }
   if (index == 0) {
     // No valid entry matching header, see if there's a matching name
     uint32_t nameIndex = 0;
     uint32_t absoluteNameIndex = 0;
     bool isStaticName = false;
-    std::tie(isStaticName, nameIndex, absoluteNameIndex) = getNameIndexQ(name);
+    std::tie(isStaticName, nameIndex, absoluteNameIndex) =
+        getNameIndexQ(name, dynamicNameIndex);
 
     // Now check if we should emit an insertion on the control stream
     // Don't try to index if we're out of encoder flow control
@@ -145,14 +152,11 @@ size_t QPACKEncoder::encodeHeaderQ(HPACKHeaderName name,
     if (indexable) {
       if (table_.canIndex(name, value)) {
         encodeInsertQ(name, value, isStaticName, nameIndex);
-        CHECK(table_.add(HPACKHeader(std::move(name), value)));
+        // The table copies name and value, so both stay valid here
+        CHECK(table_.add(name, value));
         if (allowVulnerable() && lastEntryAvailable()) {
           index = table_.getInsertCount();
-          // name is invalid on this branch, but index must be non-zero since
-          // we inserted just above.
         } else {
-          // We still need name.  Get it from the table
-          name = getHeader(false, 1, table_.getInsertCount(), false).name;
           index = 0;
           if (absoluteNameIndex > 0 &&
               !table_.isValid(table_.absoluteToRelative(absoluteNameIndex))) {
@@ -182,6 +186,7 @@ size_t QPACKEncoder::encodeHeaderQ(HPACKHeaderName name,
 
   // Encoding a dynamic index reference
   DCHECK_NE(index, 0);
+  dynamicRefs_++;
   trackReference(index, requiredInsertCount);
   if (index > baseIndex) {
     streamBuffer_.encodeInteger(index - baseIndex - 1, HPACK::Q_INDEXED_POST);
@@ -220,13 +225,16 @@ std::pair<bool, uint32_t> QPACKEncoder::maybeDuplicate(uint32_t relativeIndex) {
 }
 
 std::tuple<bool, uint32_t, uint32_t> QPACKEncoder::getNameIndexQ(
-    const HPACKHeaderName& headerName) {
+    const HPACKHeaderName& headerName,
+    folly::Optional<uint32_t> dynamicNameIndex) {
   uint32_t absoluteNameIndex = 0;
   uint32_t nameIndex = getStaticTable().nameIndex(headerName);
   bool isStatic = true;
   if (nameIndex == 0 && dynamicReferenceAllowed()) {
-    // check dynamic table
-    nameIndex = table_.nameIndex(headerName, allowVulnerable());
+    // check dynamic table, unless the caller already probed it
+    nameIndex = dynamicNameIndex
+                    ? *dynamicNameIndex
+                    : table_.nameIndex(headerName, allowVulnerable());
     if (nameIndex != 0) {
       absoluteNameIndex = maybeDuplicate(nameIndex).second;
       if (absoluteNameIndex) {
@@ -249,6 +257,7 @@ size_t QPACKEncoder::encodeStreamLiteralQ(const HPACKHeaderName& name,
                                           uint32_t absoluteNameIndex,
                                           uint32_t baseIndex,
                                           uint32_t& requiredInsertCount) {
+  literalsEncoded_++;
   if (absoluteNameIndex > 0) {
     // Dynamic name reference, vulnerability checks already done
     CHECK(absoluteNameIndex <= baseIndex || allowVulnerable());
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <folly/Optional.h>
 #include <folly/io/IOBuf.h>
 #include <list>
 #include <proxygen/lib/http/codec/compress/HPACKConstants.h>
@@ -96,6 +97,13 @@ class QPACKEncoder
 
   void setMaxNumOutstandingBlocks(uint32_t value);
 
+  /**
+   * Running count of headers encoded as literals on request streams.
+   */
+  uint32_t getLiteralsEncoded() const {
+    return literalsEncoded_;
+  }
+
   uint32_t startEncode(folly::IOBufQueue& controlQueue,
                        uint32_t headroom,
                        uint32_t maxEncoderStreamBytes);
@@ -123,7 +131,8 @@ class QPACKEncoder
   std::pair<bool, uint32_t> maybeDuplicate(uint32_t relativeIndex);
 
   std::tuple<bool, uint32_t, uint32_t> getNameIndexQ(
-      const HPACKHeaderName& headerName);
+      const HPACKHeaderName& headerName,
+      folly::Optional<uint32_t> dynamicNameIndex = folly::none);
 
   size_t encodeStreamLiteralQ(const HPACKHeaderName& name,
                               folly::StringPiece value,
@@ -187,6 +196,7 @@ class QPACKEncoder
   folly::IOBufQueue decoderIngress_{folly::IOBufQueue::cacheChainLength()};
   uint32_t numOutstandingBlocks_{0};
   uint32_t maxNumOutstandingBlocks_{kDefaultMaxOutstandingListSize};
+  uint32_t literalsEncoded_{0};
 };
 
 } // namespace proxygen
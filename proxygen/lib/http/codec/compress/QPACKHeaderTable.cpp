@@ -8,6 +8,8 @@
 
 #include <proxygen/lib/http/codec/compress/QPACKHeaderTable.h>
 
+#include <cmath>
+#include <cstring>
 #include <glog/logging.h>
 
 namespace {
@@ -32,7 +34,9 @@ uint32_t getMinFree(uint32_t tableSize) {
 namespace proxygen {
 
 QPACKHeaderTable::QPACKHeaderTable(uint32_t capacityVal, bool trackReferences)
-    : HeaderTable(capacityVal) {
+    : HeaderTable(capacityVal),
+      storage_(capacityVal),
+      valueRefs_(table_.size()) {
   if (trackReferences) {
     refCount_ = std::make_unique<std::vector<uint16_t>>(table_.size(), 0);
     minFree_ = getMinFree(capacityVal);
@@ -42,25 +46,60 @@ QPACKHeaderTable::QPACKHeaderTable(uint32_t capacityVal, bool trackReferences)
 }
 
 bool QPACKHeaderTable::add(HPACKHeader header) {
+  return add(std::move(header.name), folly::StringPiece(header.value));
+}
+
+bool QPACKHeaderTable::add(HPACKHeaderName name, folly::StringPiece value) {
   if (insertCount_ == std::numeric_limits<uint32_t>::max()) {
     LOG(ERROR) << "Cowardly refusing to add more entries since insertCount_ "
                   " would wrap";
     return false;
   }
 
-  VLOG(6) << "Adding header=" << header;
-  if (!HeaderTable::add(std::move(header))) {
+  VLOG(6) << "Adding header=" << name << ": " << value;
+  auto headerBytes = HPACKHeader::bytes(name.size(), value.size());
+  if (headerBytes > capacity_) {
+    // Per the RFC spec https://tools.ietf.org/html/rfc7541#page-11, we must
+    // flush the underlying table if a request is made for a header that is
+    // larger than the current table capacity
+    reset();
+    writeOffset_ = 0;
+    tailOffset_ = 0;
+    liveValueBytes_ = 0;
     return false;
   }
+
+  // Make the necessary room in the table if appropriate per RFC spec
+  if ((bytes_ + headerBytes) > capacity_) {
+    if (evict(headerBytes, capacity_) == 0) {
+      return false;
+    }
+  }
+
+  if (size_ == length()) {
+    increaseTableLengthTo(
+        std::min((uint32_t)ceil(size_ * 1.5), getMaxTableLength(capacity_)));
+  }
+  head_ = next(head_);
+  // index name
+  names_[name].push_back(head_);
+  bytes_ += headerBytes;
+  table_[head_].name = std::move(name);
+  // The value bytes live in the storage ring, not in the entry
+  DCHECK(table_[head_].value.empty());
+  valueRefs_[head_] = writeValue(value);
   if (refCount_) {
     (*refCount_)[head_] = 0;
   }
+
+  ++size_;
+  ++insertCount_;
   DCHECK_EQ(internalToAbsolute(head_), insertCount_);
   // Increase minUsable_ until the free space + drainedBytes is >= minFree.
   // For HPACK, minFree is 0 and this is a no-op.
   while (capacity_ - bytes_ + drainedBytes_ < minFree_ &&
          minUsable_ <= insertCount_) {
-    auto bytes = table_[absoluteToInternal(minUsable_)].bytes();
+    auto bytes = entryBytes(absoluteToInternal(minUsable_));
     VLOG(5) << "Draining absolute index " << minUsable_ << " bytes=" << bytes
             << " drainedBytes_= " << (drainedBytes_ + bytes);
     drainedBytes_ += bytes;
@@ -76,6 +115,9 @@ bool QPACKHeaderTable::setCapacity(uint32_t capacity) {
   if (refCount_) {
     minFree_ = getMinFree(capacity);
   } // else minFree is always 0
+  if (storage_.size() != capacity) {
+    compactStorage(capacity);
+  }
   return true;
 }
 
@@ -104,10 +146,11 @@ uint32_t QPACKHeaderTable::getIndexImpl(const HPACKHeaderName& headerName,
   for (auto indexIt = it->second.rbegin(); indexIt != it->second.rend();
        ++indexIt) {
     auto i = *indexIt;
-    if (nameOnly || table_[i].value == value) {
+    if (nameOnly || valueAt(i) == value) {
       // allow vulnerable or not vulnerable
       if (allowVulnerable || internalToAbsolute(i) <= ackedInsertCount_) {
         // index *may* be draining, caller has to check
+        markEntryReferenced(internalToAbsolute(i));
         return toExternal(i);
       } else {
         encoderHasUnackedEntry = true;
@@ -120,29 +163,94 @@ uint32_t QPACKHeaderTable::getIndexImpl(const HPACKHeaderName& headerName,
   return 0;
 }
 
+QPACKHeaderTable::NameValueIndex QPACKHeaderTable::getIndexAndName(
+    const HPACKHeaderName& headerName,
+    folly::StringPiece value,
+    bool allowVulnerable) const {
+  NameValueIndex result;
+  auto it = names_.find(headerName);
+  if (it == names_.end()) {
+    return result;
+  }
+  bool unackedValue = false;
+  bool unackedName = false;
+  // Same iteration order as getIndexImpl; the first usable entry is the name
+  // match and the first usable entry with an equal value is the value match
+  for (auto indexIt = it->second.rbegin(); indexIt != it->second.rend();
+       ++indexIt) {
+    auto i = *indexIt;
+    const bool usable =
+        allowVulnerable || internalToAbsolute(i) <= ackedInsertCount_;
+    if (usable) {
+      if (result.nameIndex == 0) {
+        result.nameIndex = toExternal(i);
+      }
+      if (valueAt(i) == value) {
+        result.valueIndex = toExternal(i);
+        markEntryReferenced(internalToAbsolute(i));
+        break;
+      }
+    } else {
+      unackedName = true;
+      if (valueAt(i) == value) {
+        unackedValue = true;
+      }
+    }
+  }
+  if (result.valueIndex == 0 && unackedValue) {
+    result.valueIndex = UNACKED;
+  }
+  if (result.nameIndex == 0 && unackedName) {
+    result.nameIndex = UNACKED;
+  }
+  return result;
+}
+
 uint32_t QPACKHeaderTable::nameIndex(const HPACKHeaderName& headerName,
                                      bool allowVulnerable) const {
   folly::fbstring value;
   return getIndexImpl(headerName, value, true /* name only */, allowVulnerable);
 }
 
-const HPACKHeader& QPACKHeaderTable::getHeader(uint32_t index,
-                                               uint32_t base) const {
+QPACKHeaderTable::HeaderEntryView QPACKHeaderTable::getHeader(
+    uint32_t index, uint32_t base) const {
   CHECK(isValid(index, base));
-  return table_[toInternal(index, base)];
+  auto i = toInternal(index, base);
+  return HeaderEntryView{table_[i].name, valueAt(i)};
 }
 
 uint32_t QPACKHeaderTable::removeLast() {
-  auto idx = tail();
+  auto t = tail();
   if (refCount_) {
-    CHECK_EQ((*refCount_)[idx], 0) << "Removed header with nonzero references";
+    CHECK_EQ((*refCount_)[t], 0) << "Removed header with nonzero references";
   }
-  auto removedBytes = HeaderTable::removeLast();
+  // remove the first element from the names index
+  auto names_it = names_.find(table_[t].name);
+  DCHECK(names_it != names_.end());
+  auto& ilist = names_it->second;
+  DCHECK_EQ(ilist.front(), t);
+  ilist.pop_front();
+
+  // remove the name if there are no indices associated with it
+  if (ilist.empty()) {
+    names_.erase(names_it);
+  }
+  uint32_t removedBytes = entryBytes(t);
+  bytes_ -= removedBytes;
+  recordEviction(internalToAbsolute(t), removedBytes);
+  VLOG(10) << "Removing local idx=" << t << " name=" << table_[t].name
+           << " value=" << valueAt(t);
+  // Release the entry's range in the storage ring; the tail just advances
+  // to the next oldest entry
+  liveValueBytes_ -= valueRefs_[t].length;
+  --size_;
+  tailOffset_ = (size_ > 0) ? valueRefs_[tail()].offset : writeOffset_;
+
   // Only non-zero when minUsable_ > insertCount_ - size_.
   if (drainedBytes_ > 0) {
-    VLOG(5) << "Removing draining entry=" << idx << " size=" << removedBytes
-            << " drainedBytes_=" << drainedBytes_
-            << " new drainedBytes_=" << (int32_t(drainedBytes_) - removedBytes);
+    VLOG(5) << "Removing draining entry=" << t << " size=" << removedBytes
+            << " drainedBytes_=" << drainedBytes_ << " new drainedBytes_="
+            << (int32_t(drainedBytes_) - removedBytes);
     CHECK_GE(drainedBytes_, removedBytes);
     drainedBytes_ -= removedBytes;
   } else {
@@ -166,6 +274,7 @@ void QPACKHeaderTable::increaseTableLengthTo(uint32_t newLength) {
 
 void QPACKHeaderTable::resizeTable(uint32_t newLength) {
   HeaderTable::resizeTable(newLength);
+  valueRefs_.resize(newLength);
   if (refCount_) {
     refCount_->resize(newLength);
   }
@@ -175,6 +284,9 @@ void QPACKHeaderTable::updateResizedTable(uint32_t oldTail,
                                           uint32_t oldLength,
                                           uint32_t newLength) {
   HeaderTable::updateResizedTable(oldTail, oldLength, newLength);
+  std::move_backward(valueRefs_.begin() + oldTail,
+                     valueRefs_.begin() + oldLength,
+                     valueRefs_.begin() + newLength);
   if (refCount_) {
     std::move_backward(refCount_->begin() + oldTail,
                        refCount_->begin() + oldLength,
@@ -200,11 +312,11 @@ bool QPACKHeaderTable::canEvict(uint32_t needed) {
   while (nChecked++ < size() && freeable < needed &&
          ((*refCount_)[i] == 0) && // don't evict referenced or unacked headers
          internalToAbsolute(i) <= ackedInsertCount_) {
-    freeable += table_[i].bytes();
+    freeable += entryBytes(i);
     i = next(i);
   }
   if (freeable < needed) {
-    VLOG(5) << "header=" << table_[i].name << ":" << table_[i].value
+    VLOG(5) << "header=" << table_[i].name << ":" << valueAt(i)
             << " blocked eviction, recount=" << (*refCount_)[i];
     return false;
   }
@@ -237,9 +349,12 @@ std::pair<bool, uint32_t> QPACKHeaderTable::maybeDuplicate(
   DCHECK(!isVulnerable(absIndex) || allowVulnerable);
   if (absIndex < minUsable_) {
     // draining
-    const HPACKHeader& header = getHeader(relativeIndex);
-    if (canIndex(header.name, header.value)) {
-      CHECK(add(header.copy()));
+    auto view = getHeader(relativeIndex);
+    if (canIndex(view.name, view.value)) {
+      // Materialize before add(): the insert may evict the source entry and
+      // reuse its range in the storage ring
+      HPACKHeader header(view.name, view.value);
+      CHECK(add(std::move(header)));
       if (allowVulnerable) {
         return {true, insertCount_};
       } else {
@@ -266,6 +381,67 @@ void QPACKHeaderTable::subRef(uint32_t absIndex) {
   (*refCount_)[index]--;
 }
 
+QPACKHeaderTable::ValueRef QPACKHeaderTable::writeValue(
+    folly::StringPiece value) {
+  uint32_t len = value.size();
+  if (len == 0) {
+    // Zero-length values carry the current write offset so tailOffset_
+    // stays monotonic in insertion order
+    return ValueRef{writeOffset_, 0};
+  }
+  // Post-eviction, the live bytes plus this value always fit: each entry
+  // carries at least kMinLength bytes of overhead against capacity
+  DCHECK_LE(liveValueBytes_ + len, storage_.size());
+  if (size_ == 0) {
+    writeOffset_ = 0;
+    tailOffset_ = 0;
+  }
+  uint32_t offset;
+  if (writeOffset_ >= tailOffset_) {
+    if (storage_.size() - writeOffset_ >= len) {
+      offset = writeOffset_;
+    } else if (tailOffset_ >= len) {
+      // wrap around; the gap left at the end is reclaimed once the tail
+      // passes it
+      offset = 0;
+    } else {
+      compactStorage(storage_.size());
+      offset = writeOffset_;
+    }
+  } else if (tailOffset_ - writeOffset_ >= len) {
+    offset = writeOffset_;
+  } else {
+    compactStorage(storage_.size());
+    offset = writeOffset_;
+  }
+  DCHECK_LE(offset + len, storage_.size());
+  memcpy(storage_.data() + offset, value.data(), len);
+  writeOffset_ = offset + len;
+  liveValueBytes_ += len;
+  return ValueRef{offset, len};
+}
+
+void QPACKHeaderTable::compactStorage(uint32_t ringSize) {
+  DCHECK_LE(liveValueBytes_, ringSize);
+  std::vector<char> newStorage(ringSize);
+  uint32_t offset = 0;
+  uint32_t i = (size_ > 0) ? tail() : 0;
+  for (uint32_t n = 0; n < size_; n++, i = next(i)) {
+    auto& ref = valueRefs_[i];
+    if (ref.length > 0) {
+      memcpy(newStorage.data() + offset,
+             storage_.data() + ref.offset,
+             ref.length);
+    }
+    ref.offset = offset;
+    offset += ref.length;
+  }
+  DCHECK_EQ(offset, liveValueBytes_);
+  storage_ = std::move(newStorage);
+  tailOffset_ = 0;
+  writeOffset_ = offset;
+}
+
 // Converts an array index in [0..table_.size() - 1] to an absolute
 // external index
 uint32_t QPACKHeaderTable::internalToAbsolute(uint32_t internalIndex) const {
@@ -286,4 +462,16 @@ uint32_t QPACKHeaderTable::toInternal(uint32_t externalIndex,
   return HeaderTable::toInternal(externalIndex);
 }
 
+std::ostream& operator<<(std::ostream& os, const QPACKHeaderTable& table) {
+  os << std::endl;
+  for (size_t i = 1; i <= table.size(); i++) {
+    auto view = table.getHeader(i);
+    os << '[' << i
+       << "] (s=" << HPACKHeader::bytes(view.name.size(), view.value.size())
+       << ") " << view.name << ": " << view.value << std::endl;
+  }
+  os << "total size: " << table.bytes() << std::endl;
+  return os;
+}
+
 } // namespace proxygen
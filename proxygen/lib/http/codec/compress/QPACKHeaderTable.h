@@ -18,6 +18,13 @@ namespace proxygen {
 /**
  * Data structure for maintaining indexed headers, based on a fixed-length ring
  * with FIFO semantics. Externally it acts as an array.
+ *
+ * Unlike the base HeaderTable, entry values are not stored as individually
+ * allocated strings.  They live in a contiguous byte ring sized to the table
+ * capacity: insert is a bump-copy at the write offset, eviction just releases
+ * the oldest entry's range, and lookups return views into the ring.  Dynamic
+ * table churn therefore performs no per-entry allocation (common header names
+ * point at the static name table; uncommon names still own their string).
  */
 
 class QPACKHeaderTable : public HeaderTable {
@@ -66,6 +73,20 @@ class QPACKHeaderTable : public HeaderTable {
   std::pair<bool, uint32_t> maybeDuplicate(uint32_t relativeIndex,
                                            bool allowVulnerable);
 
+  /**
+   * A header entry materialized from the table.  The name is a handle into
+   * shared name storage and the value is a view into the byte ring; both are
+   * only valid until the next mutation of the table.
+   */
+  struct HeaderEntryView {
+    const HPACKHeaderName& name;
+    folly::StringPiece value;
+
+    bool operator==(const HPACKHeader& other) const {
+      return name == other.name && value == folly::StringPiece(other.value);
+    }
+  };
+
   /**
    * Add the header entry at the beginning of the table (index=1)
    *
@@ -73,6 +94,13 @@ class QPACKHeaderTable : public HeaderTable {
    */
   bool add(HPACKHeader header) override;
 
+  /**
+   * Same as above, but copies the value bytes directly into the table's
+   * storage ring, so the caller keeps (and can reuse) its own buffer.  The
+   * value must not alias this table's storage.
+   */
+  bool add(HPACKHeaderName name, folly::StringPiece value);
+
   bool setCapacity(uint32_t capacity) override;
 
   // This API is only for tests, and doesn't work correctly if the table is
@@ -95,14 +123,28 @@ class QPACKHeaderTable : public HeaderTable {
                     folly::StringPiece value,
                     bool allowVulnerable = true) const;
 
+  /**
+   * Combined getIndex + nameIndex result, resolved with a single probe of
+   * the name map.  Each field is 0, UNACKED, or a relative index with the
+   * same semantics as the corresponding standalone lookup.
+   */
+  struct NameValueIndex {
+    uint32_t valueIndex{0};
+    uint32_t nameIndex{0};
+  };
+
+  NameValueIndex getIndexAndName(const HPACKHeaderName& name,
+                                 folly::StringPiece value,
+                                 bool allowVulnerable) const;
+
   /**
    * Get the table entry at the given external index.  If base is 0,
    * index is relative to head/insertCount.  If base is non-zero, index is
    * relative to base.
    *
-   * @return the header entry
+   * @return a view of the header entry, valid until the table is mutated
    */
-  const HPACKHeader& getHeader(uint32_t index, uint32_t base = 0) const;
+  HeaderEntryView getHeader(uint32_t index, uint32_t base = 0) const;
 
   /**
    * Checks if an external index is valid.  If base is 0,
@@ -212,11 +254,57 @@ class QPACKHeaderTable : public HeaderTable {
   uint32_t internalToAbsolute(uint32_t internalIndex) const;
   uint32_t absoluteToInternal(uint32_t absoluteIndex) const;
 
+  /**
+   * Location of an entry's value bytes within storage_.
+   */
+  struct ValueRef {
+    uint32_t offset{0};
+    uint32_t length{0};
+  };
+
+  folly::StringPiece valueAt(uint32_t internalIndex) const {
+    const auto& ref = valueRefs_[internalIndex];
+    return folly::StringPiece(storage_.data() + ref.offset, ref.length);
+  }
+
+  /**
+   * Size in bytes of the entry at the given internal index, per the HPACK
+   * spec formula.  The base class can't compute this since values don't
+   * live in table_.
+   */
+  uint32_t entryBytes(uint32_t internalIndex) const {
+    return HPACKHeader::bytes(table_[internalIndex].name.size(),
+                              valueRefs_[internalIndex].length);
+  }
+
+  /**
+   * Bump-copy value into the storage ring and return its location.  Falls
+   * back to compaction on the rare wrap where the contiguous tail is too
+   * small.
+   */
+  ValueRef writeValue(folly::StringPiece value);
+
+  /**
+   * Re-pack all live values contiguously into a ring of ringSize bytes.
+   */
+  void compactStorage(uint32_t ringSize);
+
   uint32_t drainedBytes_{0};
   uint32_t minUsable_{1};
   uint32_t ackedInsertCount_{0};
   uint32_t minFree_{0};
   std::unique_ptr<std::vector<uint16_t>> refCount_;
+
+  // Value byte ring.  Entries occupy [offset, offset + length) ranges in
+  // FIFO order; tailOffset_ tracks the oldest live entry's offset and
+  // writeOffset_ is where the next value will be copied.
+  std::vector<char> storage_;
+  std::vector<ValueRef> valueRefs_;
+  uint32_t writeOffset_{0};
+  uint32_t tailOffset_{0};
+  uint32_t liveValueBytes_{0};
 };
 
+std::ostream& operator<<(std::ostream& os, const QPACKHeaderTable& table);
+
 } // namespace proxygen
@@ -11,6 +11,7 @@
 #include <folly/Indestructible.h>
 
 #include <glog/logging.h>
+#include <limits>
 #include <list>
 
 using std::list;
@@ -117,6 +118,57 @@ StaticHeaderTable::StaticHeaderTable(const char* entries[][2], int size)
   for (auto& header : hlist) {
     CHECK(add(std::move(header)));
   }
+  buildCodeIndex();
+}
+
+void StaticHeaderTable::buildCodeIndex() {
+  if (size() > std::numeric_limits<uint8_t>::max()) {
+    return;
+  }
+  for (uint32_t i = 1; i <= size(); ++i) {
+    const HTTPHeaderCode code = getHeader(i).name.getHeaderCode();
+    if (code == HTTP_HEADER_OTHER) {
+      // name not in HTTPCommonHeaders; can't key by code
+      return;
+    }
+    if (codeFirstIndex_[code] == 0) {
+      codeFirstIndex_[code] = i;
+    } else if (codeLastIndex_[code] != i - 1) {
+      // repeated names must occupy adjacent slots for the range scan below
+      return;
+    }
+    codeLastIndex_[code] = i;
+  }
+  useCodeIndex_ = true;
+}
+
+uint32_t StaticHeaderTable::getIndex(const HPACKHeaderName& name,
+                                     folly::StringPiece value) const {
+  if (!useCodeIndex_) {
+    return HeaderTable::getIndex(name, value);
+  }
+  const HTTPHeaderCode code = name.getHeaderCode();
+  if (code == HTTP_HEADER_OTHER) {
+    return 0;
+  }
+  for (uint32_t i = codeFirstIndex_[code]; i != 0 && i <= codeLastIndex_[code];
+       ++i) {
+    if (getHeader(i).value == value) {
+      return i;
+    }
+  }
+  return 0;
+}
+
+uint32_t StaticHeaderTable::nameIndex(const HPACKHeaderName& name) const {
+  if (!useCodeIndex_) {
+    return HeaderTable::nameIndex(name);
+  }
+  const HTTPHeaderCode code = name.getHeaderCode();
+  if (code == HTTP_HEADER_OTHER) {
+    return 0;
+  }
+  return codeFirstIndex_[code];
 }
 
 const StaticHeaderTable& StaticHeaderTable::get() {
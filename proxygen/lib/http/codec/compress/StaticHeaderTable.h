@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <array>
 #include <proxygen/lib/http/HTTPCommonHeaders.h>
 #include <proxygen/lib/http/codec/compress/HeaderTable.h>
 
@@ -21,6 +22,25 @@ class StaticHeaderTable : public HeaderTable {
   static const StaticHeaderTable& get();
 
   static bool isHeaderCodeInTableWithNonEmptyValue(HTTPHeaderCode headerCode);
+
+  /**
+   * O(1) lookups keyed by the gperf-generated common header code, shadowing
+   * the F14 map based lookups in HeaderTable.  The table contents are fixed,
+   * so the code -> index ranges are computed once at construction.  If the
+   * table ever held a name outside HTTPCommonHeaders, or duplicate names in
+   * non-adjacent slots, construction falls back to the map.
+   */
+  uint32_t getIndex(const HPACKHeaderName& name,
+                    folly::StringPiece value) const;
+  uint32_t nameIndex(const HPACKHeaderName& name) const;
+
+ private:
+  void buildCodeIndex();
+
+  // first/last external index holding each common header code; 0 = absent
+  std::array<uint8_t, HTTPCommonHeaders::num_codes> codeFirstIndex_{};
+  std::array<uint8_t, HTTPCommonHeaders::num_codes> codeLastIndex_{};
+  bool useCodeIndex_{false};
 };
 
 } // namespace proxygen
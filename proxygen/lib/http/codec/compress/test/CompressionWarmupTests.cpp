@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/http/codec/compress/CompressionWarmup.h>
+
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/http/codec/compress/QPACKStaticHeaderTable.h>
+#include <proxygen/lib/http/codec/compress/StaticHeaderTable.h>
+
+using namespace proxygen;
+
+TEST(CompressionWarmupTests, Serial) {
+  compress::warmupStaticTables();
+  EXPECT_GT(StaticHeaderTable::get().size(), 0);
+  EXPECT_GT(QPACKStaticHeaderTable::get().size(), 0);
+}
+
+TEST(CompressionWarmupTests, Parallel) {
+  folly::CPUThreadPoolExecutor executor(3);
+  compress::warmupStaticTables(&executor);
+  executor.join();
+  EXPECT_GT(StaticHeaderTable::get().size(), 0);
+  EXPECT_GT(QPACKStaticHeaderTable::get().size(), 0);
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/Conv.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/http/codec/compress/FrequencyIndexingStrategy.h>
+
+using namespace proxygen;
+
+namespace {
+
+class TestIndexingStats : public HeaderCodec::Stats {
+ public:
+  void recordEncode(HeaderCodec::Type, HTTPHeaderSize&) override {
+  }
+  void recordDecode(HeaderCodec::Type, HTTPHeaderSize&) override {
+  }
+  void recordDecodeError(HeaderCodec::Type) override {
+  }
+  void recordDecodeTooLarge(HeaderCodec::Type) override {
+  }
+  void recordIndexingDecision(bool indexed) override {
+    if (indexed) {
+      indexed_++;
+    } else {
+      skipped_++;
+    }
+  }
+
+  uint32_t indexed_{0};
+  uint32_t skipped_{0};
+};
+
+} // namespace
+
+TEST(FrequencyIndexingStrategyTests, IndexAfterThreshold) {
+  FrequencyIndexingStrategy strategy;
+  HPACKHeaderName name("x-custom-hot");
+  // The first sighting is not yet worth dynamic table space
+  EXPECT_FALSE(strategy.indexHeader(name, "value"));
+  EXPECT_TRUE(strategy.indexHeader(name, "value"));
+  EXPECT_TRUE(strategy.indexHeader(name, "value"));
+}
+
+TEST(FrequencyIndexingStrategyTests, OneShotValuesNotIndexed) {
+  FrequencyIndexingStrategy strategy;
+  HPACKHeaderName name("x-request-id");
+  // Same name, always-changing value: never reaches the threshold
+  for (uint32_t i = 0; i < 100; i++) {
+    EXPECT_FALSE(strategy.indexHeader(name, folly::to<std::string>("id-", i)));
+  }
+}
+
+TEST(FrequencyIndexingStrategyTests, StaticRulesStillApply) {
+  // Even with a threshold of 1, the base strategy's veto list holds
+  FrequencyIndexingStrategy strategy(1);
+  HPACKHeaderName contentLength(HTTP_HEADER_CONTENT_LENGTH);
+  EXPECT_FALSE(strategy.indexHeader(contentLength, "42"));
+}
+
+TEST(FrequencyIndexingStrategyTests, StatsExport) {
+  TestIndexingStats stats;
+  FrequencyIndexingStrategy strategy;
+  strategy.setStats(&stats);
+  HPACKHeaderName name("x-custom-hot");
+  strategy.indexHeader(name, "value");
+  strategy.indexHeader(name, "value");
+  EXPECT_EQ(stats.skipped_, 1);
+  EXPECT_EQ(stats.indexed_, 1);
+}
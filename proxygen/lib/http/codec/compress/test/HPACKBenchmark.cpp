@@ -7,11 +7,13 @@
  */
 
 #include <folly/Benchmark.h>
+#include <folly/Conv.h>
 #include <folly/Range.h>
 #include <proxygen/lib/http/codec/compress/test/TestStreamingCallback.h>
 #include <proxygen/lib/http/codec/compress/test/TestUtil.h>
 
 #include <algorithm>
+#include <limits>
 
 using namespace std;
 using namespace folly;
@@ -77,6 +79,97 @@ void encodeDecodeBench(int reencodes, int iters) {
   }
 }
 
+void huffmanDecodeBench(int iters) {
+  // pre-encode the string literals once, then time only the huffman decode
+  const auto& tree = huffman::huffTree();
+  vector<std::string> encoded;
+  for (const auto& header : headers) {
+    folly::IOBufQueue queue;
+    folly::io::QueueAppender appender(&queue, 512);
+    tree.encode(header.value, appender);
+    auto buf = queue.move();
+    buf->coalesce();
+    encoded.emplace_back(reinterpret_cast<const char*>(buf->data()),
+                         buf->length());
+  }
+  for (int i = 0; i < iters; i++) {
+    for (const auto& bits : encoded) {
+      folly::fbstring literal;
+      tree.decode(
+          reinterpret_cast<const uint8_t*>(bits.data()), bits.size(), literal);
+      folly::doNotOptimizeAway(literal.size());
+    }
+  }
+}
+
+// Jumbo trailer-style block: many long, uncompressible values, the kind
+// of header block that arrives split across CONTINUATION frames
+vector<HPACKHeader> getJumboTrailers() {
+  vector<HPACKHeader> trailers;
+  for (int i = 0; i < 60; i++) {
+    trailers.emplace_back(folly::to<std::string>("x-trace-span-", i),
+                          std::string(120, char('a' + i % 26)));
+  }
+  return trailers;
+}
+
+// Clone the block into fragment-sized chained IOBufs, the shape codec
+// ingress produces for a block split across CONTINUATION frames
+unique_ptr<IOBuf> splitIntoFragments(const IOBuf& block, size_t fragment) {
+  folly::io::Cursor cursor(&block);
+  unique_ptr<IOBuf> head;
+  while (cursor.totalLength() > 0) {
+    unique_ptr<IOBuf> piece;
+    cursor.clone(piece, std::min(fragment, cursor.totalLength()));
+    if (head) {
+      head->prependChain(std::move(piece));
+    } else {
+      head = std::move(piece);
+    }
+  }
+  return head;
+}
+
+void decodeFragmentedBench(size_t fragment, bool coalesceFirst, int iters) {
+  folly::BenchmarkSuspender suspender;
+  HPACKEncoder encoder(true);
+  auto trailers = getJumboTrailers();
+  auto block = encoder.encode(trailers);
+  auto chain = splitIntoFragments(*block, fragment);
+  suspender.dismiss();
+  for (int i = 0; i < iters; i++) {
+    HPACKDecoder decoder;
+    TestStreamingCallback cb;
+    if (coalesceFirst) {
+      // the old copy-based path: flatten the chain before decoding
+      auto copy = chain->clone();
+      copy->coalesce();
+      folly::io::Cursor c(copy.get());
+      decoder.decodeStreaming(c, c.totalLength(), &cb);
+    } else {
+      folly::io::Cursor c(chain.get());
+      decoder.decodeStreaming(c, c.totalLength(), &cb);
+    }
+    CHECK(!cb.hasError());
+  }
+}
+
+BENCHMARK(DecodeJumboSingleBuffer, iters) {
+  decodeFragmentedBench(std::numeric_limits<size_t>::max(), false, iters);
+}
+
+BENCHMARK(DecodeJumboChained64, iters) {
+  decodeFragmentedBench(64, false, iters);
+}
+
+BENCHMARK(DecodeJumboCoalesceFirst64, iters) {
+  decodeFragmentedBench(64, true, iters);
+}
+
+BENCHMARK(HuffmanDecode, iters) {
+  huffmanDecodeBench(iters);
+}
+
 BENCHMARK(Encode, iters) {
   encodeBench(0, iters);
 }
@@ -136,6 +136,34 @@ TEST_F(HPACKBufferTests, EncodeHuffmanLiteralN) {
   EXPECT_EQ(data_[11], 0x7f);
 }
 
+TEST_F(HPACKBufferTests, EncodeLiteralSkipsHuffmanForHighEntropy) {
+  // Every sampled character takes a full 8-bit code, so the projected
+  // savings fall under the skip threshold and the plain layout is used
+  string token;
+  for (int i = 0; i < 8; i++) {
+    token += "X*Z&";
+  }
+  HPACKEncodeBuffer encoder(512, true);
+  EXPECT_FALSE(encoder.shouldHuffman(token));
+  uint32_t size = encoder.encodeLiteral(token);
+  EXPECT_EQ(size, 33);
+  releaseData(encoder);
+  EXPECT_EQ(buf_->length(), 33);
+  EXPECT_EQ(data_[0], 32); // huffman bit off, plain length
+  EXPECT_EQ(data_[1], 'X');
+}
+
+TEST_F(HPACKBufferTests, EncodeLiteralStillHuffmansCompressible) {
+  // 'e' has a 5-bit code, well past the threshold
+  string value(32, 'e');
+  HPACKEncodeBuffer encoder(512, true);
+  EXPECT_TRUE(encoder.shouldHuffman(value));
+  uint32_t size = encoder.encodeLiteral(value);
+  EXPECT_EQ(size, 21); // 32 * 5 bits payload + length byte
+  releaseData(encoder);
+  EXPECT_EQ(data_[0], 0x80 | 20);
+}
+
 TEST_F(HPACKBufferTests, DecodeSingleByte) {
   buf_ = IOBuf::create(512);
   uint8_t* wdata = buf_->writableData();
@@ -110,6 +110,95 @@ TEST_F(HPACKCodecTests, Headroom) {
   EXPECT_EQ(result->headers.size(), 12);
 }
 
+/**
+ * bulk decoding delivers the whole block through one onHeaderBlock call;
+ * callbacks without a bulk override still get per-header delivery
+ */
+TEST_F(HPACKCodecTests, BulkDecode) {
+  struct BlockCallback : public TestStreamingCallback {
+    void onHeaderBlock(const std::vector<HPACKHeader>& headers) override {
+      blockSize = headers.size();
+      // fall back to per-header delivery so the base class collects them
+      HPACK::StreamingCallback::onHeaderBlock(headers);
+    }
+    size_t blockSize{0};
+  };
+
+  vector<Header> req = basicHeaders();
+  unique_ptr<IOBuf> encoded = client.encode(req);
+
+  BlockCallback cb;
+  Cursor cursor(encoded.get());
+  server.decodeBulk(cursor, cursor.totalLength(), &cb);
+  EXPECT_FALSE(cb.hasError());
+  EXPECT_EQ(cb.blockSize, 6);
+  EXPECT_EQ(cb.getResult()->headers.size(), 12);
+}
+
+/**
+ * a repeated byte-identical block that doesn't touch the dynamic table
+ * is served from the fingerprint cache; blocks that insert are not cached
+ */
+TEST_F(HPACKCodecTests, DecodedBlockCache) {
+  server.enableDecodedBlockCache();
+
+  vector<Header> req = basicHeaders();
+  // first encoding inserts into the dynamic table; its decode mutates the
+  // decoder table and must not be cached
+  unique_ptr<IOBuf> inserting = client.encode(req);
+  Cursor c1(inserting.get());
+  auto result = decode(server, c1, c1.totalLength());
+  EXPECT_TRUE(!result.hasError());
+  EXPECT_EQ(server.getDecodedBlockCacheHits(), 0);
+
+  // second encoding is all indexed references: its decode is side-effect
+  // free, so the first pass populates the cache and the replay hits it
+  unique_ptr<IOBuf> indexed = client.encode(req);
+  for (int i = 0; i < 3; i++) {
+    Cursor c2(indexed.get());
+    auto replayed = decode(server, c2, c2.totalLength());
+    EXPECT_TRUE(!replayed.hasError());
+    EXPECT_EQ(replayed->headers.size(), 12);
+  }
+  EXPECT_EQ(server.getDecodedBlockCacheHits(), 2);
+}
+
+/**
+ * a dynamic table change between occurrences of the same bytes turns the
+ * lookup into a miss, so stale headers are never replayed
+ */
+TEST_F(HPACKCodecTests, DecodedBlockCacheInvalidatedByTableChange) {
+  server.enableDecodedBlockCache();
+
+  vector<Header> req = basicHeaders();
+  unique_ptr<IOBuf> inserting = client.encode(req);
+  Cursor c1(inserting.get());
+  EXPECT_TRUE(!decode(server, c1, c1.totalLength()).hasError());
+
+  // cache the indexed re-encoding
+  unique_ptr<IOBuf> indexed = client.encode(req);
+  Cursor c2(indexed.get());
+  EXPECT_TRUE(!decode(server, c2, c2.totalLength()).hasError());
+
+  // a block that inserts invalidates every cached entry
+  vector<vector<string>> extra = {{"x-fb-debug", "invalidate"}};
+  vector<Header> extraReq = headersFromArray(extra);
+  unique_ptr<IOBuf> mutating = client.encode(extraReq);
+  Cursor c3(mutating.get());
+  EXPECT_TRUE(!decode(server, c3, c3.totalLength()).hasError());
+
+  // same bytes, different table state: decoded afresh, then re-cached
+  Cursor c4(indexed.get());
+  auto result = decode(server, c4, c4.totalLength());
+  EXPECT_TRUE(!result.hasError());
+  EXPECT_EQ(result->headers.size(), 12);
+  EXPECT_EQ(server.getDecodedBlockCacheHits(), 0);
+
+  Cursor c5(indexed.get());
+  EXPECT_TRUE(!decode(server, c5, c5.totalLength()).hasError());
+  EXPECT_EQ(server.getDecodedBlockCacheHits(), 1);
+}
+
 /**
  * makes sure that the encoder will lowercase the header names
  */
@@ -211,6 +300,31 @@ TEST_F(HPACKCodecTests, HeaderCodecStats) {
   client.setStats(nullptr);
 }
 
+TEST_F(HPACKCodecTests, TableEfficiencyStats) {
+  TestHeaderCodecStats stats(HeaderCodec::Type::HPACK);
+  HPACKCodec codec{TransportDirection::DOWNSTREAM};
+  codec.setStats(&stats);
+
+  vector<Header> req = basicHeaders();
+  codec.encode(req);
+  EXPECT_EQ(stats.tableSamples, 1);
+  // first sighting: every header is a static hit or a literal
+  EXPECT_EQ(stats.table.dynamicHits, 0);
+  EXPECT_GT(stats.table.literals, 0);
+  EXPECT_GT(stats.table.staticHits, 0);
+  EXPECT_GT(stats.table.tableOccupancyPct, 0);
+  auto firstLiterals = stats.table.literals;
+
+  req = basicHeaders();
+  codec.encode(req);
+  EXPECT_EQ(stats.tableSamples, 2);
+  // repeats of the indexed headers are now dynamic table hits
+  EXPECT_EQ(stats.table.dynamicHits, firstLiterals);
+  EXPECT_EQ(stats.table.literals, 0);
+  EXPECT_EQ(stats.table.evictions, 0);
+  codec.setStats(nullptr);
+}
+
 /**
  * check that we're enforcing the limit on total uncompressed size
  */
@@ -280,6 +394,60 @@ TEST_F(HPACKCodecTests, DefaultHeaderIndexingStrategy) {
             headersIndexableSize);
 }
 
+/**
+ * A fresh codec pair seeded with an exported warm-state blob starts with
+ * the original dynamic table: repeated headers encode as indexed refs
+ * from the very first block, matching the warmed-up pair's output size.
+ */
+TEST_F(HPACKCodecTests, WarmTableStateExportImport) {
+  vector<vector<string>> headerStrings = {
+      {"x-fb-debug", "longdebugtoken1234567890abcdef"},
+      {"x-device-id", "abcdef0123456789abcdef0123456789"}};
+
+  // warm up the original pair, then measure a fully-indexed block
+  EXPECT_FALSE(
+      encodeDecode(client, server, headersFromArray(headerStrings)).hasError());
+  vector<Header> req = headersFromArray(headerStrings);
+  auto warmBlockSize = bufLen(client.encode(req));
+
+  auto blob = client.exportWarmTableState();
+  EXPECT_GT(blob.size(), 1);
+
+  // a seeded fresh pair matches the warm block size on its first block
+  HPACKCodec resumedClient{TransportDirection::UPSTREAM};
+  HPACKCodec resumedServer{TransportDirection::DOWNSTREAM};
+  EXPECT_TRUE(resumedClient.importWarmTableState(blob));
+  EXPECT_TRUE(resumedServer.importPeerWarmTableState(blob));
+  vector<Header> resumedReq = headersFromArray(headerStrings);
+  auto encoded = resumedClient.encode(resumedReq);
+  EXPECT_EQ(bufLen(encoded), warmBlockSize);
+  Cursor cursor(encoded.get());
+  auto result = decode(resumedServer, cursor, cursor.totalLength());
+  EXPECT_FALSE(result.hasError());
+  EXPECT_EQ(result->headers.size(), 4);
+
+  // the seeded table round-trips byte-identically
+  EXPECT_EQ(resumedClient.exportWarmTableState(), blob);
+}
+
+TEST_F(HPACKCodecTests, WarmTableStateImportRefused) {
+  EXPECT_FALSE(
+      encodeDecode(client, server, basicHeaders()).hasError());
+  auto blob = client.exportWarmTableState();
+
+  // once traffic has flowed the tables are wire state; importing would
+  // desync them from the peer
+  EXPECT_FALSE(client.importWarmTableState(blob));
+  EXPECT_FALSE(server.importPeerWarmTableState(blob));
+
+  // malformed blobs leave a fresh codec untouched
+  HPACKCodec fresh{TransportDirection::UPSTREAM};
+  EXPECT_FALSE(fresh.importWarmTableState("not a warm state blob"));
+  EXPECT_FALSE(fresh.importWarmTableState(blob.substr(0, blob.size() - 2)));
+  EXPECT_EQ(fresh.getCompressionInfo().egress.headersStored_, 0);
+  EXPECT_TRUE(fresh.importWarmTableState(blob));
+}
+
 class HPACKQueueTests : public testing::TestWithParam<int> {
  public:
   HPACKQueueTests() : queue(std::make_unique<HPACKQueue>(server)) {
@@ -119,6 +119,36 @@ TEST_F(HPACKContextTests, EncoderMultipleValues) {
   EXPECT_GT(encoded2->computeChainDataLength(), 0);
 }
 
+TEST_F(HPACKContextTests, EncoderRemembersHuffmanDecisionPerName) {
+  // The first value under a name that doesn't compress turns Huffman
+  // off for that name; a later compressible value under the same name
+  // stays plain while a fresh encoder would have Huffman coded it
+  std::string entropic;
+  for (int i = 0; i < 8; i++) {
+    entropic += "X*Z&";
+  }
+  std::string compressible(32, 'e');
+
+  HPACKEncoder encoder(true);
+  vector<HPACKHeader> first;
+  first.push_back(HPACKHeader("x-signature", entropic));
+  encoder.encode(first);
+
+  vector<HPACKHeader> second;
+  second.push_back(HPACKHeader("x-signature", compressible));
+  auto rememberedPlain = encoder.encode(second);
+
+  HPACKEncoder fresh(true);
+  auto sampledHuffman = fresh.encode(second);
+  EXPECT_GT(rememberedPlain->computeChainDataLength(),
+            sampledHuffman->computeChainDataLength());
+
+  // either layout decodes to the same headers
+  HPACKDecoder decoder;
+  auto decoded = proxygen::hpack::decode(decoder, rememberedPlain.get());
+  EXPECT_EQ(*decoded, second);
+}
+
 TEST_F(HPACKContextTests, DecoderLargeHeader) {
   // with this size basically the table will not be able to store any entry
   uint32_t size = 32;
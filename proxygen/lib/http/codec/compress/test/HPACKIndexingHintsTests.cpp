@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/http/codec/compress/FrequencyIndexingStrategy.h>
+#include <proxygen/lib/http/codec/compress/HPACKEncoder.h>
+#include <proxygen/lib/http/codec/compress/HPACKIndexingHints.h>
+
+using namespace proxygen;
+
+TEST(HPACKIndexingHintsTests, HintAfterThreshold) {
+  HPACKIndexingHints hints;
+  HPACKHeaderName name("x-auth-token");
+  // One connection indexing a pair is not yet a trend
+  hints.recordIndexed(name, "secret");
+  EXPECT_FALSE(hints.wasIndexed(name, "secret"));
+  hints.recordIndexed(name, "secret");
+  EXPECT_TRUE(hints.wasIndexed(name, "secret"));
+  // Same name, different value is a different pair
+  EXPECT_FALSE(hints.wasIndexed(name, "other"));
+}
+
+TEST(HPACKIndexingHintsTests, RankedEntriesOrderAndBudget) {
+  HPACKIndexingHints hints(1);
+  HPACKHeaderName hot("x-hot");
+  HPACKHeaderName warm("x-warm");
+  for (uint32_t i = 0; i < 5; i++) {
+    hints.recordIndexed(hot, "aaaa");
+  }
+  hints.recordIndexed(warm, "bbbb");
+
+  auto ranked = hints.rankedEntries(4096);
+  ASSERT_EQ(ranked.size(), 2);
+  EXPECT_EQ(ranked[0].name.get(), "x-hot");
+  EXPECT_EQ(ranked[1].name.get(), "x-warm");
+
+  // A budget with room for only one entry cuts the list off
+  auto budget = HPACKHeader::bytes(5, 4);
+  ranked = hints.rankedEntries(budget);
+  ASSERT_EQ(ranked.size(), 1);
+  EXPECT_EQ(ranked[0].name.get(), "x-hot");
+}
+
+TEST(HPACKIndexingHintsTests, NewEncoderIndexesProvenPairOnFirstSight) {
+  HPACKIndexingHints hints;
+  HPACKHeaderName name("x-trace-baggage");
+  const std::string value{"tenant=acme"};
+
+  // Two prior connections, each with a frequency strategy that needs
+  // two sightings before granting a table slot
+  for (int conn = 0; conn < 2; conn++) {
+    FrequencyIndexingStrategy strategy;
+    HPACKEncoder encoder(true);
+    encoder.setHeaderIndexingStrategy(&strategy);
+    encoder.setIndexingHints(&hints);
+    encoder.encode({HPACKHeader(name, folly::StringPiece(value))});
+    encoder.encode({HPACKHeader(name, folly::StringPiece(value))});
+    EXPECT_EQ(encoder.getTable().size(), 1);
+  }
+
+  // A fresh connection sharing the hints indexes it immediately
+  FrequencyIndexingStrategy strategy;
+  HPACKEncoder encoder(true);
+  encoder.setHeaderIndexingStrategy(&strategy);
+  encoder.setIndexingHints(&hints);
+  encoder.encode({HPACKHeader(name, folly::StringPiece(value))});
+  EXPECT_EQ(encoder.getTable().size(), 1);
+
+  // Without the hints the first sighting stays a plain literal
+  FrequencyIndexingStrategy coldStrategy;
+  HPACKEncoder coldEncoder(true);
+  coldEncoder.setHeaderIndexingStrategy(&coldStrategy);
+  coldEncoder.encode({HPACKHeader(name, folly::StringPiece(value))});
+  EXPECT_EQ(coldEncoder.getTable().size(), 0);
+}
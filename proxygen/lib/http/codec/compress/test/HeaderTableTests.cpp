@@ -117,6 +117,25 @@ TEST_F(HeaderTableTests, Evict) {
   EXPECT_EQ(table.names().size(), 0);
 }
 
+TEST_F(HeaderTableTests, EvictionAccounting) {
+  HPACKHeader used("accept-encoding", "gzip");
+  HPACKHeader unused("x-request-id", "1234567890");
+  uint32_t capacity = used.bytes() + unused.bytes();
+  HeaderTable table(capacity);
+  EXPECT_EQ(table.add(used.copy()), true);
+  EXPECT_EQ(table.add(unused.copy()), true);
+  // Only the first entry satisfies a lookup before eviction
+  EXPECT_GT(table.getIndex(used), 0);
+  EXPECT_EQ(table.getEvictions(), 0);
+  EXPECT_EQ(table.getEvictedNeverReusedBytes(), 0);
+
+  // Force both out; the referenced entry's bytes are not counted wasted
+  HPACKHeader filler("cache-control", std::string(capacity - used.bytes(), 'x'));
+  EXPECT_EQ(table.add(filler.copy()), true);
+  EXPECT_EQ(table.getEvictions(), 2);
+  EXPECT_EQ(table.getEvictedNeverReusedBytes(), unused.bytes());
+}
+
 TEST_F(HeaderTableTests, ReduceCapacity) {
   HPACKHeader accept("accept-encoding", "gzip");
   uint32_t max = 10;
@@ -162,6 +162,31 @@ TEST_F(HuffmanTests, UserAgent) {
   CHECK_EQ(user_agent, decoded);
 }
 
+/*
+ * pairs of rare characters whose combined codes exceed 32 bits take the
+ * per-symbol fallback in encode(); mix them with common ASCII and use an
+ * odd length to also cover the single-byte tail
+ */
+TEST_F(HuffmanTests, RareSymbolPairs) {
+  folly::fbstring literal("x");
+  literal += '\x01'; // 26 bits
+  literal += '\xf0'; // 23 bits, pair doesn't fit in 32
+  literal += '\x09'; // 24 bits
+  literal += '\x26'; // 8 bits
+  literal += "value";
+  IOBufQueue bufQueue;
+  QueueAppender appender(&bufQueue, 512);
+  appender.ensure(512);
+
+  uint32_t size = tree_.getEncodeSize(literal);
+  uint32_t encodedSize = tree_.encode(literal, appender);
+  EXPECT_EQ(size, encodedSize);
+
+  folly::fbstring decoded;
+  tree_.decode(bufQueue.front()->data(), size, decoded);
+  CHECK_EQ(literal, decoded);
+}
+
 /*
  * this test is verifying the CHECK for length at the end of huffman::encode()
  */
@@ -6,6 +6,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <deque>
 #include <folly/portability/GTest.h>
 #include <memory>
 #include <proxygen/lib/http/codec/compress/Logging.h>
@@ -128,6 +129,35 @@ TEST_F(QPACKHeaderTableTests, GetIndex) {
   EXPECT_EQ(table_.getIndex(accept2), 0);
 }
 
+TEST_F(QPACKHeaderTableTests, GetIndexAndName) {
+  HPACKHeader accept1("accept-encoding", "gzip");
+  HPACKHeader accept2("accept-encoding", "blarf");
+
+  auto res = table_.getIndexAndName(accept1.name, accept1.value, true);
+  EXPECT_EQ(res.valueIndex, 0);
+  EXPECT_EQ(res.nameIndex, 0);
+
+  EXPECT_TRUE(table_.add(accept1.copy()));
+  // Vulnerable - both lookups report UNACKED
+  res = table_.getIndexAndName(accept1.name, accept1.value, false);
+  EXPECT_EQ(res.valueIndex, uint32_t(QPACKHeaderTable::UNACKED));
+  EXPECT_EQ(res.nameIndex, uint32_t(QPACKHeaderTable::UNACKED));
+
+  res = table_.getIndexAndName(accept1.name, accept1.value, true);
+  EXPECT_EQ(res.valueIndex, 1);
+  EXPECT_EQ(res.nameIndex, 1);
+
+  // name matches, value doesn't
+  res = table_.getIndexAndName(accept2.name, accept2.value, true);
+  EXPECT_EQ(res.valueIndex, 0);
+  EXPECT_EQ(res.nameIndex, 1);
+
+  EXPECT_TRUE(table_.onInsertCountIncrement(1));
+  res = table_.getIndexAndName(accept1.name, accept1.value, false);
+  EXPECT_EQ(res.valueIndex, 1);
+  EXPECT_EQ(res.nameIndex, 1);
+}
+
 TEST_F(QPACKHeaderTableTests, Duplication) {
   HPACKHeader accept("accept-encoding", "gzip");
 
@@ -224,6 +254,46 @@ TEST_F(QPACKHeaderTableTests, BadSync) {
   EXPECT_FALSE(table_.onInsertCountIncrement(1));
 }
 
+TEST_F(QPACKHeaderTableTests, StorageRingWrap) {
+  // Uneven value sizes force the value storage ring to wrap and
+  // occasionally compact; live entries must survive both
+  std::deque<std::string> values;
+  for (auto i = 0; i < 50; i++) {
+    std::string value(10 + (i % 17), 'a' + (i % 26));
+    HPACKHeader header("x-custom", value);
+    EXPECT_TRUE(table_.add(header.copy()));
+    table_.setAcknowledgedInsertCount(table_.getInsertCount());
+    values.push_back(value);
+    while (values.size() > table_.size()) {
+      values.pop_front();
+    }
+    // Index 1 is the newest entry
+    for (uint32_t j = 1; j <= table_.size(); j++) {
+      auto view = table_.getHeader(j, table_.getInsertCount());
+      EXPECT_EQ(view.name.get(), "x-custom");
+      EXPECT_EQ(view.value, values[values.size() - j]);
+    }
+  }
+}
+
+TEST_F(QPACKHeaderTableTests, StorageRingCapacityChange) {
+  HPACKHeader accept("accept-encoding", "gzip");
+  HPACKHeader agent("user-agent", "SeaMonkey");
+  EXPECT_TRUE(table_.add(accept.copy()));
+  EXPECT_TRUE(table_.add(agent.copy()));
+  table_.setAcknowledgedInsertCount(table_.getInsertCount());
+
+  // Growing re-packs the ring; entries keep their contents
+  EXPECT_TRUE(table_.setCapacity(640));
+  EXPECT_EQ(table_.getHeader(1, table_.getInsertCount()), agent);
+  EXPECT_EQ(table_.getHeader(2, table_.getInsertCount()), accept);
+
+  // Shrinking evicts the oldest entry and compacts the survivor
+  EXPECT_TRUE(table_.setCapacity(agent.bytes()));
+  EXPECT_EQ(table_.size(), 1);
+  EXPECT_EQ(table_.getHeader(1, table_.getInsertCount()), agent);
+}
+
 TEST_F(QPACKHeaderTableTests, TinyTable) {
   // This table will tell you it can't hold any headers, but it can!
   QPACKHeaderTable table(0, true);
@@ -68,6 +68,14 @@ class TestHeaderCodecStats : public HeaderCodec::Stats {
     tooLarge++;
   }
 
+  void recordTableEfficiency(
+      HeaderCodec::Type type,
+      const HeaderCodec::TableEfficiency& sample) override {
+    EXPECT_EQ(type, type_);
+    tableSamples++;
+    table = sample;
+  }
+
   void reset() {
     encodes = 0;
     decodes = 0;
@@ -78,6 +86,8 @@ class TestHeaderCodecStats : public HeaderCodec::Stats {
     decodedBytesUncompr = 0;
     errors = 0;
     tooLarge = 0;
+    tableSamples = 0;
+    table = HeaderCodec::TableEfficiency();
   }
 
   HeaderCodec::Type type_;
@@ -90,6 +100,8 @@ class TestHeaderCodecStats : public HeaderCodec::Stats {
   uint32_t decodedBytesUncompr{0};
   uint32_t errors{0};
   uint32_t tooLarge{0};
+  uint32_t tableSamples{0};
+  HeaderCodec::TableEfficiency table; // most recent sample
 };
 
 }} // namespace proxygen::hpack
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/Benchmark.h>
+#include <folly/Range.h>
+#include <proxygen/lib/http/codec/CodecUtil.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace proxygen;
+
+namespace {
+
+// Representative header corpus: names/values sampled from a proxy workload
+const std::vector<folly::StringPiece> kHeaderNames = {
+    "host",
+    "content-length",
+    "content-type",
+    "accept",
+    "accept-encoding",
+    "accept-language",
+    "user-agent",
+    "cache-control",
+    "x-forwarded-for",
+    "x-fb-debug",
+    "if-modified-since",
+    "sec-fetch-dest",
+};
+
+const std::vector<folly::StringPiece> kHeaderValues = {
+    "www.facebook.com",
+    "text/html; charset=utf-8",
+    "gzip, deflate, br",
+    "en-US,en;q=0.9,es;q=0.8",
+    "Mozilla/5.0 (Macintosh; Intel Mac OS X 10_15_7) AppleWebKit/537.36 "
+    "(KHTML, like Gecko) Chrome/91.0.4472.114 Safari/537.36",
+    "max-age=0, no-cache, no-store, must-revalidate",
+    "2a03:2880:f101:83:face:b00c:0:25de, 192.168.12.34",
+    "Wed, 21 Oct 2015 07:28:00 GMT",
+    "0",
+};
+
+const std::vector<folly::StringPiece> kURLs = {
+    "/",
+    "/ajax/bz?ph=A&barrier=1",
+    "/intern/agent/dashboards/latency?duration=3600&agg=p99",
+    "/videos/vod/10155278547321729/?offset=0&length=30000",
+};
+
+// A search-style query string: long values, sparse escapes
+const folly::StringPiece kQuery =
+    "q=how%20to%20tune%20http%2F1.1+pipelining&client=web&num=30"
+    "&source=hp&biw=2560&bih=1271&filters=safe%3Aon%2Clang%3Aen"
+    "&sessionid=8f2c1f0a9d4e4b21aa310c9e";
+
+} // namespace
+
+BENCHMARK(ValidateHeaderName, iters) {
+  bool valid = true;
+  for (size_t i = 0; i < iters; i++) {
+    for (auto name : kHeaderNames) {
+      valid &= CodecUtil::validateHeaderName(folly::ByteRange(name));
+    }
+  }
+  folly::doNotOptimizeAway(valid);
+}
+
+BENCHMARK(ValidateHeaderValue, iters) {
+  bool valid = true;
+  for (size_t i = 0; i < iters; i++) {
+    for (auto value : kHeaderValues) {
+      valid &= CodecUtil::validateHeaderValue(folly::ByteRange(value),
+                                              CodecUtil::CtlEscapeMode::STRICT);
+    }
+  }
+  folly::doNotOptimizeAway(valid);
+}
+
+BENCHMARK(ValidateURL, iters) {
+  bool valid = true;
+  for (size_t i = 0; i < iters; i++) {
+    for (auto url : kURLs) {
+      valid &= CodecUtil::validateURL(folly::ByteRange(url));
+    }
+  }
+  folly::doNotOptimizeAway(valid);
+}
+
+BENCHMARK(FindFirstOf, iters) {
+  size_t total = 0;
+  for (size_t i = 0; i < iters; i++) {
+    folly::StringPiece sp = kQuery;
+    while (!sp.empty()) {
+      size_t pos = CodecUtil::findFirstOf(folly::ByteRange(sp), '&', '=');
+      total += pos;
+      sp.advance(std::min(pos + 1, sp.size()));
+    }
+  }
+  folly::doNotOptimizeAway(total);
+}
+
+BENCHMARK(UnescapeQuery, iters) {
+  std::string out;
+  bool ok = true;
+  for (size_t i = 0; i < iters; i++) {
+    ok &= CodecUtil::unescapeQuery(kQuery, out);
+  }
+  folly::doNotOptimizeAway(ok);
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+  return 0;
+}
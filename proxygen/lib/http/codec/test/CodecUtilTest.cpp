@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/http/codec/CodecUtil.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+
+namespace {
+folly::ByteRange toRange(folly::StringPiece sp) {
+  return folly::ByteRange(sp);
+}
+} // namespace
+
+TEST(CodecUtilTest, ValidateHeaderName) {
+  EXPECT_TRUE(CodecUtil::validateHeaderName(toRange("content-length")));
+  EXPECT_TRUE(CodecUtil::validateHeaderName(toRange("x-fb-debug")));
+  EXPECT_TRUE(
+      CodecUtil::validateHeaderName(toRange("a-fairly-long-header-name-27")));
+  EXPECT_FALSE(CodecUtil::validateHeaderName(toRange("")));
+  EXPECT_FALSE(CodecUtil::validateHeaderName(toRange("Content-Length")));
+  EXPECT_FALSE(CodecUtil::validateHeaderName(toRange("foo:bar")));
+  // bad byte past the first 16-byte block exercises the scalar tail
+  EXPECT_FALSE(
+      CodecUtil::validateHeaderName(toRange("a-fairly-long-header:name")));
+  EXPECT_FALSE(CodecUtil::validateHeaderName(toRange("a-fairly-long-header-name-27\x01")));
+}
+
+TEST(CodecUtilTest, ValidateHeaderValue) {
+  auto strict = CodecUtil::CtlEscapeMode::STRICT;
+  auto compliant = CodecUtil::CtlEscapeMode::COMPLIANT;
+  EXPECT_TRUE(CodecUtil::validateHeaderValue(
+      toRange("text/html; charset=utf-8, application/xhtml+xml;q=0.9"),
+      strict));
+  EXPECT_TRUE(CodecUtil::validateHeaderValue(toRange("with\ttab"), strict));
+  EXPECT_TRUE(CodecUtil::validateHeaderValue(
+      toRange("long plain value then lws\r\n more"), compliant));
+  EXPECT_FALSE(CodecUtil::validateHeaderValue(
+      toRange("long plain value then ctl \x01 nope"), strict));
+  EXPECT_FALSE(
+      CodecUtil::validateHeaderValue(toRange("dangling cr \r"), strict));
+  EXPECT_FALSE(
+      CodecUtil::validateHeaderValue(toRange("bare crlf \r\nx"), strict));
+  EXPECT_TRUE(CodecUtil::validateHeaderValue(
+      toRange("quoted \"stuff \\\" more\" end"), compliant));
+  EXPECT_FALSE(CodecUtil::validateHeaderValue(
+      toRange("quoted \"stuff \\\x01\" more"), strict));
+}
+
+TEST(CodecUtilTest, FindFirstOf) {
+  EXPECT_EQ(CodecUtil::findFirstOf(toRange("a=b"), '&', '='), 1);
+  EXPECT_EQ(CodecUtil::findFirstOf(toRange("abc"), '&', '='), 3);
+  EXPECT_EQ(CodecUtil::findFirstOf(toRange(""), '&', '='), 0);
+  // delimiter past the first 16-byte block exercises the vector loop
+  EXPECT_EQ(
+      CodecUtil::findFirstOf(
+          toRange("a-long-query-parameter-name=value"), '&', '='),
+      27);
+  EXPECT_EQ(
+      CodecUtil::findFirstOf(
+          toRange("a-long-query-parameter&name=value"), '&', '='),
+      22);
+}
+
+TEST(CodecUtilTest, UnescapeQuery) {
+  std::string out;
+  EXPECT_TRUE(CodecUtil::unescapeQuery("plain", out));
+  EXPECT_EQ(out, "plain");
+  EXPECT_TRUE(CodecUtil::unescapeQuery("a+b%20c", out));
+  EXPECT_EQ(out, "a b c");
+  EXPECT_TRUE(CodecUtil::unescapeQuery("%41%6a%6B", out));
+  EXPECT_EQ(out, "AjK");
+  EXPECT_TRUE(CodecUtil::unescapeQuery("", out));
+  EXPECT_EQ(out, "");
+  // escapes past the first 16-byte block exercise the vector loop
+  EXPECT_TRUE(CodecUtil::unescapeQuery(
+      "a-fairly-long-clean-run-of-bytes%2Fwith%20escapes+at+the-end", out));
+  EXPECT_EQ(out, "a-fairly-long-clean-run-of-bytes/with escapes at the-end");
+  // truncated and non-hex escapes fail
+  EXPECT_FALSE(CodecUtil::unescapeQuery("abc%2", out));
+  EXPECT_FALSE(CodecUtil::unescapeQuery("abc%", out));
+  EXPECT_FALSE(CodecUtil::unescapeQuery("abc%2z", out));
+}
+
+TEST(CodecUtilTest, ValidateURL) {
+  EXPECT_TRUE(CodecUtil::validateURL(
+      toRange("/some/fairly/long/path?with=query&strings=1")));
+  EXPECT_FALSE(CodecUtil::validateURL(
+      toRange("/some/fairly/long/path?with=query strings")));
+  EXPECT_FALSE(CodecUtil::validateURL(toRange("/a\x7fb")));
+  EXPECT_FALSE(CodecUtil::validateURL(toRange("/a\rb")));
+}
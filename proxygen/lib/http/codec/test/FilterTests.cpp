@@ -6,15 +6,18 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <folly/io/async/EventBase.h>
 #include <folly/portability/GTest.h>
 #include <limits>
 #include <proxygen/lib/http/HTTPHeaderSize.h>
 #include <proxygen/lib/http/HTTPMessage.h>
 #include <proxygen/lib/http/codec/FlowControlFilter.h>
 #include <proxygen/lib/http/codec/HTTPChecks.h>
+#include <proxygen/lib/http/codec/IngressRateLimitFilter.h>
 #include <proxygen/lib/http/codec/test/MockHTTPCodec.h>
 #include <proxygen/lib/http/codec/test/TestUtils.h>
 #include <random>
+#include <thread>
 
 using namespace proxygen;
 using namespace std;
@@ -145,6 +148,42 @@ TEST_F(DefaultFlowControl, SendUpdate) {
   filter_->ingressBytesProcessed(writeBuf_, 1);
 }
 
+TEST_F(DefaultFlowControl, AutoTuneGrow) {
+  EXPECT_CALL(callback_, onBody(_, _, _)).WillRepeatedly(Return());
+  EXPECT_CALL(*codec_, generateWindowUpdate(_, 0, _)).Times(AtLeast(1));
+
+  filter_->enableReceiveWindowAutoTuning(1000000);
+  filter_->onRttSample(std::chrono::milliseconds(20));
+
+  // Deliver a full default window's worth within one measurement
+  // interval; the measured BDP should pull the capacity up
+  callbackStart_->onBody(1, makeBuf(kInitialCapacity / 2), 0);
+  filter_->ingressBytesProcessed(writeBuf_, kInitialCapacity / 2);
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  callbackStart_->onBody(1, makeBuf(kInitialCapacity / 2), 0);
+  filter_->ingressBytesProcessed(writeBuf_, kInitialCapacity / 2);
+
+  EXPECT_GT(filter_->getRecvWindow().getCapacity(), kInitialCapacity);
+}
+
+TEST_F(BigWindow, AutoTuneShrink) {
+  EXPECT_CALL(callback_, onBody(_, _, _)).WillRepeatedly(Return());
+
+  filter_->enableReceiveWindowAutoTuning(2000000);
+  filter_->onRttSample(std::chrono::milliseconds(20));
+
+  // A trickle of data means a tiny BDP; the window should shrink back to
+  // the codec default, with the capacity difference withheld from acks
+  callbackStart_->onBody(1, makeBuf(1000), 0);
+  filter_->ingressBytesProcessed(writeBuf_, 1000);
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  callbackStart_->onBody(1, makeBuf(1000), 0);
+  EXPECT_FALSE(filter_->ingressBytesProcessed(writeBuf_, 1000));
+
+  EXPECT_EQ(filter_->getRecvWindow().getCapacity(), kInitialCapacity);
+  EXPECT_EQ(filter_->getRecvWindow().getOutstanding(), 0);
+}
+
 TEST_F(BigWindow, RecvTooMuch) {
   // Constructing the filter with a large capacity causes a WINDOW_UPDATE
   // for stream zero to be generated
@@ -246,3 +285,137 @@ TEST_F(HTTPChecksTest, RecvTraceBody) {
 
   callbackStart_->onHeadersComplete(0, std::move(msg));
 }
+
+namespace {
+
+class ManualClock : public TokenBucketRateLimiter::Clock {
+ public:
+  TimePoint now() override {
+    return now_;
+  }
+
+  void advance(std::chrono::milliseconds delta) {
+    now_ += delta;
+  }
+
+ private:
+  TimePoint now_{getCurrentTime()};
+};
+
+class FakeReadThrottler : public IngressRateLimitFilter::ReadThrottler {
+ public:
+  void pauseIngressForRateLimit() noexcept override {
+    pauses++;
+  }
+  void resumeIngressForRateLimit() noexcept override {
+    resumes++;
+  }
+
+  int pauses{0};
+  int resumes{0};
+};
+
+} // namespace
+
+class IngressRateLimitFilterTest : public testing::Test {
+ protected:
+  // Tests tweak the configs first, then install
+  void install() {
+    scope_ = std::make_unique<IngressRateLimiter>(
+        &evb_, listenerConfig_, std::chrono::milliseconds(10), &clock_);
+    filter_ = std::make_unique<IngressRateLimitFilter>(
+        *scope_, sessionConfig_, &throttler_);
+    filter_->setCallback(&callback_);
+  }
+
+  static constexpr size_t kControl =
+      static_cast<size_t>(IngressRateLimitCategory::CONTROL_FRAMES);
+  static constexpr size_t kNewStreams =
+      static_cast<size_t>(IngressRateLimitCategory::NEW_STREAMS);
+
+  folly::EventBase evb_;
+  ManualClock clock_;
+  FakeReadThrottler throttler_;
+  IngressRateLimitConfig listenerConfig_{};
+  IngressRateLimitConfig sessionConfig_{};
+  std::unique_ptr<IngressRateLimiter> scope_;
+  std::unique_ptr<IngressRateLimitFilter> filter_;
+  MockHTTPCodecCallback callback_;
+};
+
+TEST_F(IngressRateLimitFilterTest, ControlFloodClosesSession) {
+  sessionConfig_[kControl] = {2, 2, IngressOverflowAction::CLOSE_SESSION};
+  install();
+
+  EXPECT_CALL(callback_, onPingRequest(_)).Times(2);
+  EXPECT_CALL(callback_, onError(0, _, _))
+      .WillOnce(Invoke([](HTTPCodec::StreamID,
+                          std::shared_ptr<HTTPException> exc,
+                          bool) {
+        EXPECT_EQ(exc->getProxygenError(), kErrorDropped);
+      }));
+  filter_->onPingRequest(1);
+  filter_->onPingRequest(2);
+  filter_->onPingRequest(3);
+
+  // Refill restores service without any timer having run
+  clock_.advance(std::chrono::seconds(2));
+  EXPECT_CALL(callback_, onPingRequest(4));
+  filter_->onPingRequest(4);
+}
+
+TEST_F(IngressRateLimitFilterTest, NewStreamOverflowRefusesStream) {
+  sessionConfig_[kNewStreams] = {1, 1, IngressOverflowAction::RESET_STREAM};
+  install();
+
+  EXPECT_CALL(callback_, onMessageBegin(1, _));
+  filter_->onMessageBegin(1, nullptr);
+
+  // Over budget: the stream is refused, the session stays up
+  EXPECT_CALL(callback_, onError(3, _, _))
+      .WillOnce(Invoke([](HTTPCodec::StreamID,
+                          std::shared_ptr<HTTPException> exc,
+                          bool) {
+        EXPECT_EQ(exc->getCodecStatusCode(), ErrorCode::REFUSED_STREAM);
+      }));
+  filter_->onMessageBegin(3, nullptr);
+
+  clock_.advance(std::chrono::seconds(2));
+  EXPECT_CALL(callback_, onMessageBegin(5, _));
+  filter_->onMessageBegin(5, nullptr);
+}
+
+TEST_F(IngressRateLimitFilterTest, DelayReadThrottlesAndResumes) {
+  sessionConfig_[kControl] = {1, 1, IngressOverflowAction::DELAY_READ};
+  install();
+
+  // The offending frame is still delivered; only the socket slows down
+  EXPECT_CALL(callback_, onPingRequest(_)).Times(2);
+  filter_->onPingRequest(1);
+  filter_->onPingRequest(2);
+  EXPECT_EQ(throttler_.pauses, 1);
+  EXPECT_EQ(scope_->limiter().getNumWaiters(), 1);
+
+  clock_.advance(std::chrono::seconds(1));
+  evb_.loop(); // the shared tick serves the wakeup
+  EXPECT_EQ(throttler_.resumes, 1);
+  EXPECT_EQ(scope_->limiter().getNumWaiters(), 0);
+}
+
+TEST_F(IngressRateLimitFilterTest, ListenerScopeAggregatesSessions) {
+  listenerConfig_[kControl] = {1, 1, IngressOverflowAction::CLOSE_SESSION};
+  sessionConfig_[kControl] = {100, 100, IngressOverflowAction::CLOSE_SESSION};
+  install();
+
+  IngressRateLimitFilter other(*scope_, sessionConfig_, nullptr);
+  MockHTTPCodecCallback otherCallback;
+  other.setCallback(&otherCallback);
+
+  EXPECT_CALL(callback_, onPingRequest(_));
+  filter_->onPingRequest(1);
+
+  // The listener bucket is dry, so the second session overflows even
+  // though its own bucket has plenty of tokens
+  EXPECT_CALL(otherCallback, onError(0, _, _));
+  other.onPingRequest(2);
+}
@@ -91,6 +91,72 @@ TEST(HTTP1xCodecTest, TestSimpleHeaders) {
   EXPECT_EQ(callbacks.headerSize.compressed, callbacks.headerSize.uncompressed);
 }
 
+namespace {
+// Collects headers delivered through the streaming header path
+class StreamingHeaderCollector : public HTTPCodec::StreamingHeaderCallback {
+ public:
+  void onIngressHeader(HTTPCodec::StreamID /*stream*/,
+                       folly::StringPiece name,
+                       folly::StringPiece value) noexcept override {
+    headers.emplace_back(name.str(), value.str());
+  }
+
+  std::vector<std::pair<std::string, std::string>> headers;
+};
+} // namespace
+
+TEST(HTTP1xCodecTest, TestStreamingHeaderDelivery) {
+  HTTP1xCodec codec(TransportDirection::DOWNSTREAM);
+  HTTP1xCodecCallback callbacks;
+  StreamingHeaderCollector collector;
+  codec.setCallback(&callbacks);
+  codec.setStreamingHeaderCallback(&collector);
+  string req(
+      "GET /auth HTTP/1.1\r\n"
+      "Host: www.facebook.com\r\n"
+      "Content-Length: 0\r\n"
+      "X-Jwt-Assertion: averylongconsenttoken\r\n"
+      "X-Consent-State: granted\r\n"
+      "\r\n");
+  codec.onIngress(*folly::IOBuf::copyBuffer(req));
+
+  EXPECT_EQ(callbacks.headersComplete, 1);
+  EXPECT_EQ(callbacks.errors, 0);
+  // Every header was streamed, in wire order
+  ASSERT_EQ(collector.headers.size(), 4);
+  EXPECT_EQ(collector.headers[2].first, "X-Jwt-Assertion");
+  EXPECT_EQ(collector.headers[2].second, "averylongconsenttoken");
+  // Only framing-relevant headers were retained on the message
+  const auto& headers = callbacks.msg_->getHeaders();
+  EXPECT_EQ(headers.getSingleOrEmpty(HTTP_HEADER_HOST), "www.facebook.com");
+  EXPECT_EQ(headers.getSingleOrEmpty(HTTP_HEADER_CONTENT_LENGTH), "0");
+  EXPECT_TRUE(headers.getSingleOrEmpty("X-Jwt-Assertion").empty());
+  EXPECT_TRUE(headers.getSingleOrEmpty("X-Consent-State").empty());
+}
+
+TEST(HTTP1xCodecTest, TestHeaderValueSplitAcrossBuffers) {
+  // header values are borrowed from the ingress buffer until the parse is
+  // interrupted; make sure a value split across onIngress() calls is
+  // materialized correctly
+  HTTP1xCodec codec(TransportDirection::DOWNSTREAM);
+  HTTP1xCodecCallback callbacks;
+  codec.setCallback(&callbacks);
+  string req(
+      "GET /yeah HTTP/1.1\r\n"
+      "Host: www.facebook.com\r\n"
+      "X-Custom-Header: one two three four\r\n"
+      "\r\n");
+  for (size_t i = 0; i < req.length(); i++) {
+    auto buffer = folly::IOBuf::copyBuffer(req.substr(i, 1));
+    codec.onIngress(*buffer);
+  }
+  EXPECT_EQ(callbacks.headersComplete, 1);
+  EXPECT_EQ(callbacks.errors, 0);
+  const auto& headers = callbacks.msg_->getHeaders();
+  EXPECT_EQ(headers.getSingleOrEmpty(HTTP_HEADER_HOST), "www.facebook.com");
+  EXPECT_EQ(headers.getSingleOrEmpty("X-Custom-Header"), "one two three four");
+}
+
 TEST(HTTP1xCodecTest, Test09Req) {
   HTTP1xCodec codec(TransportDirection::DOWNSTREAM);
   HTTP1xCodecCallback callbacks;
@@ -236,6 +302,43 @@ TEST(HTTP1xCodecTest, TestKeepalive09_10) {
   buf.move();
 }
 
+TEST(HTTP1xCodecTest, TestPreSerializedHeaders) {
+  HTTP1xCodec codec(TransportDirection::DOWNSTREAM);
+  HTTP1xCodecCallback callbacks;
+  codec.setCallback(&callbacks);
+  auto buffer = folly::IOBuf::copyBuffer(
+      string("GET / HTTP/1.1\r\nHost: example.com\r\n\r\n"));
+  codec.onIngress(*buffer);
+  EXPECT_EQ(callbacks.headersComplete, 1);
+
+  // Invariant headers rendered once, shared across responses
+  HTTPHeaders invariant;
+  invariant.add(HTTP_HEADER_SERVER, "unit");
+  invariant.add(HTTP_HEADER_CACHE_CONTROL, "private");
+  std::shared_ptr<folly::IOBuf> block =
+      HTTPMessage::serializeHeaderBlock(invariant);
+
+  HTTPMessage resp;
+  resp.setHTTPVersion(1, 1);
+  resp.setStatusCode(200);
+  resp.setPreSerializedHeaders(block);
+  resp.getHeaders().set(HTTP_HEADER_CONTENT_LENGTH, "0");
+  resp.getHeaders().set(HTTP_HEADER_DATE, "");
+  folly::IOBufQueue buf{folly::IOBufQueue::cacheChainLength()};
+  HTTPHeaderSize size;
+  codec.generateHeader(buf, 1, resp, true, &size);
+  EXPECT_TRUE(folly::IOBufEqualTo()(
+      *buf.front(),
+      *folly::IOBuf::copyBuffer("HTTP/1.1 200 \r\n"
+                                "Server: unit\r\n"
+                                "Cache-Control: private\r\n"
+                                "Date: \r\n"
+                                "Connection: keep-alive\r\n"
+                                "Content-Length: 0\r\n\r\n")));
+  EXPECT_EQ(size.uncompressed, buf.chainLength());
+  EXPECT_TRUE(codec.isReusable());
+}
+
 TEST(HTTP1xCodecTest, TestBadHeaders) {
   HTTP1xCodec codec(TransportDirection::DOWNSTREAM);
   MockHTTPCodecCallback callbacks;
@@ -482,6 +585,115 @@ TEST(HTTP1xCodecTest, TestCorrectTransferEncodingHeader) {
   EXPECT_EQ(callbacks.headersComplete, 1);
 }
 
+TEST(HTTP1xCodecTest, TestBatchedBodyCallbacks) {
+  HTTP1xCodec downstream(TransportDirection::DOWNSTREAM);
+  FakeHTTPCodecCallback callbacks;
+  downstream.setCallback(&callbacks);
+  downstream.setBatchedBodyCallbacks(true);
+
+  // Five tiny chunks in a single ingress buffer
+  auto reqBuf = folly::IOBuf::copyBuffer(
+      "POST /events HTTP/1.1\r\nHost: www.facebook.com\r\n"
+      "Transfer-Encoding: chunked\r\n\r\n"
+      "5\r\naaaaa\r\n5\r\nbbbbb\r\n5\r\nccccc\r\n5\r\nddddd\r\n5\r\neeeee\r\n");
+  downstream.onIngress(*reqBuf);
+
+  // One merged body callback, chunk boundary callbacks suppressed
+  EXPECT_EQ(callbacks.bodyCalls, 1);
+  EXPECT_EQ(callbacks.bodyLength, 25);
+  EXPECT_EQ(callbacks.chunkHeaders, 0);
+  EXPECT_EQ(callbacks.chunkComplete, 0);
+  EXPECT_EQ(callbacks.messageComplete, 0);
+
+  // The terminating chunk plus a pipelined follow-up chunk: the first
+  // message's EOM fires before the second message's body
+  auto reqBuf2 = folly::IOBuf::copyBuffer(
+      "0\r\n\r\n"
+      "POST /events HTTP/1.1\r\nHost: www.facebook.com\r\n"
+      "Transfer-Encoding: chunked\r\n\r\n"
+      "5\r\nfffff\r\n0\r\n\r\n");
+  downstream.onIngress(*reqBuf2);
+
+  EXPECT_EQ(callbacks.messageBegin, 2);
+  EXPECT_EQ(callbacks.bodyCalls, 2);
+  EXPECT_EQ(callbacks.bodyLength, 30);
+  EXPECT_EQ(callbacks.messageComplete, 2);
+  EXPECT_EQ(callbacks.streamErrors, 0);
+}
+
+TEST(HTTP1xCodecTest, TestUnbatchedBodyCallbacks) {
+  HTTP1xCodec downstream(TransportDirection::DOWNSTREAM);
+  FakeHTTPCodecCallback callbacks;
+  downstream.setCallback(&callbacks);
+
+  auto reqBuf = folly::IOBuf::copyBuffer(
+      "POST /events HTTP/1.1\r\nHost: www.facebook.com\r\n"
+      "Transfer-Encoding: chunked\r\n\r\n"
+      "5\r\naaaaa\r\n5\r\nbbbbb\r\n5\r\nccccc\r\n0\r\n\r\n");
+  downstream.onIngress(*reqBuf);
+
+  // Default mode still delivers per-chunk callbacks
+  EXPECT_EQ(callbacks.bodyCalls, 3);
+  EXPECT_EQ(callbacks.bodyLength, 15);
+  EXPECT_EQ(callbacks.chunkHeaders, 3);
+  EXPECT_EQ(callbacks.chunkComplete, 3);
+  EXPECT_EQ(callbacks.messageComplete, 1);
+}
+
+class TestRequestLineCallback : public HTTP1xCodec::RequestLineCallback {
+ public:
+  explicit TestRequestLineCallback(const FakeHTTPCodecCallback& callbacks)
+      : callbacks_(callbacks) {
+  }
+
+  void onRequestLineComplete(HTTPCodec::StreamID /*stream*/,
+                             folly::StringPiece method,
+                             const ParseURL& url) noexcept override {
+    ++calls;
+    method_ = method.str();
+    path_ = url.path().str();
+    query_ = url.query().str();
+    headersCompleteAtDelivery_ = callbacks_.headersComplete;
+  }
+
+  uint32_t calls{0};
+  std::string method_;
+  std::string path_;
+  std::string query_;
+  uint32_t headersCompleteAtDelivery_{0};
+
+ private:
+  const FakeHTTPCodecCallback& callbacks_;
+};
+
+TEST(HTTP1xCodecTest, TestRequestLineCallback) {
+  HTTP1xCodec downstream(TransportDirection::DOWNSTREAM);
+  FakeHTTPCodecCallback callbacks;
+  downstream.setCallback(&callbacks);
+  TestRequestLineCallback rlCallback(callbacks);
+  downstream.setRequestLineCallback(&rlCallback);
+
+  auto reqBuf = folly::IOBuf::copyBuffer(
+      "GET /foo/bar?baz=1 HTTP/1.1\r\nHost: www.facebook.com\r\n\r\n");
+  downstream.onIngress(*reqBuf);
+
+  // delivered exactly once, before the header block completed
+  EXPECT_EQ(rlCallback.calls, 1);
+  EXPECT_EQ(rlCallback.method_, "GET");
+  EXPECT_EQ(rlCallback.path_, "/foo/bar");
+  EXPECT_EQ(rlCallback.query_, "baz=1");
+  EXPECT_EQ(rlCallback.headersCompleteAtDelivery_, 0);
+  EXPECT_EQ(callbacks.headersComplete, 1);
+
+  // a second request on the same connection delivers again
+  auto reqBuf2 =
+      folly::IOBuf::copyBuffer("GET /plain HTTP/1.1\r\nHost: foo\r\n\r\n");
+  downstream.onIngress(*reqBuf2);
+  EXPECT_EQ(rlCallback.calls, 2);
+  EXPECT_EQ(rlCallback.path_, "/plain");
+  EXPECT_EQ(rlCallback.query_, "");
+}
+
 TEST(HTTP1xCodecTest, TestFoldedTransferEncodingHeader) {
   HTTP1xCodec downstream(TransportDirection::DOWNSTREAM);
   FakeHTTPCodecCallback callbacks;
@@ -100,6 +100,31 @@ TEST_F(HTTP2CodecTest, IgnoreUnknownSettings) {
             downstreamCodec_.getIngressSettings()->getNumSettings());
 }
 
+TEST_F(HTTP2CodecTest, ResetForReuse) {
+  HTTPMessage req = getGetRequest("/guacamole");
+  upstreamCodec_.generateHeader(output_, 1, req, true /* eom */);
+  parse();
+  EXPECT_EQ(callbacks_.messageBegin, 1);
+  EXPECT_EQ(callbacks_.messageComplete, 1);
+
+  ASSERT_TRUE(downstreamCodec_.reset());
+  // reset() detaches the callback, like a fresh codec
+  downstreamCodec_.setCallback(&callbacks_);
+
+  // The recycled codec expects a brand new connection: preface, then a
+  // request reusing stream id 1
+  output_.move();
+  HTTP2Codec freshUpstream(TransportDirection::UPSTREAM);
+  freshUpstream.generateConnectionPreface(output_);
+  freshUpstream.generateSettings(output_);
+  freshUpstream.generateHeader(output_, 1, req, true /* eom */);
+  parse();
+  EXPECT_EQ(callbacks_.messageBegin, 2);
+  EXPECT_EQ(callbacks_.messageComplete, 2);
+  EXPECT_EQ(callbacks_.sessionErrors, 0);
+  EXPECT_EQ(callbacks_.streamErrors, 0);
+}
+
 TEST_F(HTTP2CodecTest, NoExHeaders) {
   // do not emit ENABLE_EX_HEADERS setting, if disabled
   SetUpUpstreamTest();
@@ -226,6 +251,54 @@ TEST_F(HTTP2CodecTest, BasicHeader) {
   EXPECT_EQ("www.foo.com", headers.getSingleOrEmpty(HTTP_HEADER_HOST));
 }
 
+TEST_F(HTTP2CodecTest, StreamingHeaderDelivery) {
+  // Headers stream to the sanctioned callback as they decode; the message
+  // delivered at onHeadersComplete keeps only pseudo/framing headers
+  class Collector : public HTTPCodec::StreamingHeaderCallback {
+   public:
+    void onIngressHeader(HTTPCodec::StreamID stream,
+                         folly::StringPiece name,
+                         folly::StringPiece value) noexcept override {
+      streamID = stream;
+      headers.emplace_back(name.str(), value.str());
+    }
+    void onRoutingHeadersComplete(HTTPCodec::StreamID /*stream*/,
+                                  const HTTPMessage& partialMsg) noexcept
+        override {
+      routingSignals++;
+      routingUrl = partialMsg.getURL();
+      headersSeenAtRouting = headers.size();
+    }
+    std::vector<std::pair<std::string, std::string>> headers;
+    HTTPCodec::StreamID streamID{0};
+    uint32_t routingSignals{0};
+    std::string routingUrl;
+    size_t headersSeenAtRouting{0};
+  } collector;
+  downstreamCodec_.setStreamingHeaderCallback(&collector);
+
+  HTTPMessage req = getGetRequest("/consent");
+  req.getHeaders().add(HTTP_HEADER_USER_AGENT, "coolio");
+  req.getHeaders().add("x-jwt-assertion", std::string(1024, 'j'));
+  upstreamCodec_.generateHeader(output_, 1, req, true /* eom */);
+
+  parse();
+  // Routing info was available before any regular header was delivered
+  EXPECT_EQ(collector.routingSignals, 1);
+  EXPECT_EQ(collector.routingUrl, "/consent");
+  EXPECT_EQ(collector.headersSeenAtRouting, 0);
+  // Regular headers were streamed, not stored
+  EXPECT_EQ(collector.streamID, 1);
+  ASSERT_EQ(collector.headers.size(), 2);
+  EXPECT_EQ(collector.headers[0].first, "user-agent");
+  EXPECT_EQ(collector.headers[1].first, "x-jwt-assertion");
+  EXPECT_EQ(collector.headers[1].second, std::string(1024, 'j'));
+  // Only the pseudo-header-derived Host header remains on the message
+  callbacks_.expectMessage(true, 1, "/consent");
+  EXPECT_EQ("www.foo.com",
+            callbacks_.msg->getHeaders().getSingleOrEmpty(HTTP_HEADER_HOST));
+}
+
 TEST_F(HTTP2CodecTest, GenerateExtraHeaders) {
   HTTPMessage req = getGetRequest("/fish_taco");
   req.getHeaders().add(HTTP_HEADER_CONTENT_LENGTH, "157");
@@ -669,6 +742,83 @@ TEST_F(HTTP2CodecTest, DontDoubleDate) {
   EXPECT_EQ("x-coolio", headers.getSingleOrEmpty(HTTP_HEADER_CONTENT_TYPE));
 }
 
+TEST_F(HTTP2CodecTest, EarlyHintsPrecoded) {
+  SetUpUpstreamTest();
+  HTTPMessage hints;
+  hints.setStatusCode(103);
+  hints.getHeaders().add("link", "</style.css>; rel=preload; as=style");
+  downstreamCodec_.generateHeader(output_, 1, hints);
+
+  parseUpstream();
+  EXPECT_EQ(callbacks_.headersComplete, 1);
+  EXPECT_EQ(callbacks_.messageComplete, 0);
+  EXPECT_EQ(callbacks_.msg->getStatusCode(), 103);
+  EXPECT_EQ("</style.css>; rel=preload; as=style",
+            callbacks_.msg->getHeaders().getSingleOrEmpty("link"));
+  // The precoded fragment bypasses the header codec, so no date header
+  // gets injected
+  EXPECT_FALSE(callbacks_.msg->getHeaders().exists(HTTP_HEADER_DATE));
+
+  // The final response follows on the same stream
+  HTTPMessage resp;
+  resp.setStatusCode(200);
+  resp.getHeaders().add(HTTP_HEADER_CONTENT_TYPE, "text/html");
+  downstreamCodec_.generateHeader(output_, 1, resp);
+  downstreamCodec_.generateEOM(output_, 1);
+
+  parseUpstream();
+  EXPECT_EQ(callbacks_.headersComplete, 2);
+  EXPECT_EQ(callbacks_.msg->getStatusCode(), 200);
+  EXPECT_EQ(callbacks_.messageComplete, 1);
+  EXPECT_EQ(callbacks_.streamErrors, 0);
+  EXPECT_EQ(callbacks_.sessionErrors, 0);
+
+  // The cached fragment is replayable on other streams
+  callbacks_.reset();
+  downstreamCodec_.generateHeader(output_, 3, hints);
+  parseUpstream();
+  EXPECT_EQ(callbacks_.headersComplete, 1);
+  EXPECT_EQ(callbacks_.msg->getStatusCode(), 103);
+  EXPECT_FALSE(callbacks_.msg->getHeaders().exists(HTTP_HEADER_DATE));
+  EXPECT_EQ(callbacks_.sessionErrors, 0);
+}
+
+TEST_F(HTTP2CodecTest, EarlyHintsAfterTableSizeChange) {
+  // A pending dynamic table size update must lead the next header
+  // block, so precoded hint fragments are held off until a full encode
+  // has flushed it
+  auto settings = upstreamCodec_.getEgressSettings();
+  settings->setSetting(SettingsId::HEADER_TABLE_SIZE, 2048);
+  upstreamCodec_.generateSettings(output_);
+  parse();
+  EXPECT_EQ(callbacks_.sessionErrors, 0);
+
+  SetUpUpstreamTest();
+  HTTPMessage hints;
+  hints.setStatusCode(103);
+  hints.getHeaders().add("link", "</app.js>; rel=preload; as=script");
+  downstreamCodec_.generateHeader(output_, 1, hints);
+
+  parseUpstream();
+  EXPECT_EQ(callbacks_.headersComplete, 1);
+  EXPECT_EQ(callbacks_.msg->getStatusCode(), 103);
+  EXPECT_EQ("</app.js>; rel=preload; as=script",
+            callbacks_.msg->getHeaders().getSingleOrEmpty("link"));
+  // Regular encoder path: the table size update went out with this
+  // block, and the codec injected a date header
+  EXPECT_TRUE(callbacks_.msg->getHeaders().exists(HTTP_HEADER_DATE));
+  EXPECT_EQ(callbacks_.sessionErrors, 0);
+
+  // With the update flushed, the next hint block is precoded again
+  callbacks_.reset();
+  downstreamCodec_.generateHeader(output_, 3, hints);
+  parseUpstream();
+  EXPECT_EQ(callbacks_.headersComplete, 1);
+  EXPECT_EQ(callbacks_.msg->getStatusCode(), 103);
+  EXPECT_FALSE(callbacks_.msg->getHeaders().exists(HTTP_HEADER_DATE));
+  EXPECT_EQ(callbacks_.sessionErrors, 0);
+}
+
 TEST_F(HTTP2CodecTest, BadHeadersReply) {
   static const std::string v1("200");
   static const vector<proxygen::compress::Header> respHeaders = {
@@ -782,6 +932,78 @@ TEST_F(HTTP2CodecTest, BadContinuation) {
   EXPECT_EQ(callbacks_.sessionErrors, 1);
 }
 
+TEST_F(HTTP2CodecTest, FastRejectContinuationMisuse) {
+  // Same malformed input as BadContinuation, but the fast path bumps a
+  // counter instead of formatting an error description
+  HTTP2Codec::FastRejectCounters counters;
+  downstreamCodec_.enableFastReject(&counters);
+  auto fakeHeaders = makeBuf(5);
+  http2::writeContinuation(output_, 3, true, std::move(fakeHeaders));
+
+  parse();
+  EXPECT_EQ(callbacks_.streamErrors, 0);
+  EXPECT_EQ(callbacks_.sessionErrors, 1);
+  EXPECT_EQ(counters.continuationMisuse, 1);
+  EXPECT_EQ(counters.continuationFlood, 0);
+}
+
+TEST_F(HTTP2CodecTest, FastRejectOversizedFrame) {
+  HTTP2Codec::FastRejectCounters counters;
+  downstreamCodec_.enableFastReject(&counters);
+  HTTPMessage req = getBigGetRequest("/guacamole");
+  auto settings = downstreamCodec_.getEgressSettings();
+
+  parse(); // consume preface
+  // trick upstream into sending a 2x bigger HEADERS frame
+  settings->setSetting(SettingsId::MAX_FRAME_SIZE,
+                       http2::kMaxFramePayloadLengthMin * 2);
+  downstreamCodec_.generateSettings(output_);
+  parseUpstream();
+  settings->setSetting(SettingsId::MAX_FRAME_SIZE,
+                       http2::kMaxFramePayloadLengthMin);
+  upstreamCodec_.generateHeader(output_, 1, req, true /* eom */);
+
+  parse();
+  EXPECT_EQ(callbacks_.headersComplete, 0);
+  EXPECT_EQ(callbacks_.streamErrors, 0);
+  EXPECT_EQ(callbacks_.sessionErrors, 1);
+  EXPECT_EQ(counters.oversizedFrame, 1);
+}
+
+TEST_F(HTTP2CodecTest, ContinuationFrameBudget) {
+  // A header block shredded into tiny CONTINUATIONs trips the per-block
+  // frame budget before the block completes
+  downstreamCodec_.setMaxContinuationFrames(10);
+  writeHeaders(output_,
+               makeBuf(5),
+               1,
+               folly::none,
+               http2::kNoPadding,
+               false,
+               false /* endHeaders */);
+  for (auto i = 0; i < 11; i++) {
+    http2::writeContinuation(output_, 1, false, makeBuf(1));
+  }
+
+  parse();
+  EXPECT_EQ(callbacks_.headersComplete, 0);
+  EXPECT_EQ(callbacks_.streamErrors, 0);
+  EXPECT_EQ(callbacks_.sessionErrors, 1);
+}
+
+TEST_F(HTTP2CodecTest, ContinuationFrameBudgetCompliantBlock) {
+  // A compliant multi-frame block stays under the budget, and the
+  // counter resets between blocks
+  HTTPMessage req = getBigGetRequest();
+  upstreamCodec_.generateHeader(output_, 1, req);
+  upstreamCodec_.generateHeader(output_, 3, req);
+
+  parse();
+  EXPECT_EQ(callbacks_.headersComplete, 2);
+  EXPECT_EQ(callbacks_.streamErrors, 0);
+  EXPECT_EQ(callbacks_.sessionErrors, 0);
+}
+
 TEST_F(HTTP2CodecTest, MissingContinuation) {
   IOBufQueue output(IOBufQueue::cacheChainLength());
   HTTPMessage req = getBigGetRequest();
@@ -1168,6 +1390,52 @@ TEST_F(HTTP2CodecTest, BasicWindow) {
   EXPECT_EQ(callbacks_.sessionErrors, 0);
 }
 
+TEST_F(HTTP2CodecTest, ControlFrameCoalescing) {
+  upstreamCodec_.enableControlFrameCoalescing();
+
+  // Deferred generators emit nothing until the next flush
+  auto preLength = output_.chainLength();
+  EXPECT_EQ(upstreamCodec_.generateWindowUpdate(output_, 0, 10), 0);
+  EXPECT_EQ(upstreamCodec_.generateWindowUpdate(output_, 1, 10000), 0);
+  EXPECT_EQ(upstreamCodec_.generateWindowUpdate(output_, 1, 10000), 0);
+  EXPECT_EQ(upstreamCodec_.generateSettingsAck(output_), 0);
+  EXPECT_EQ(upstreamCodec_.generatePingReply(output_, 17), 0);
+  EXPECT_EQ(output_.chainLength(), preLength);
+  EXPECT_TRUE(upstreamCodec_.hasDeferredFrames());
+
+  EXPECT_GT(upstreamCodec_.generateDeferredFrames(output_), 0);
+  parse();
+  EXPECT_EQ(callbacks_.windowUpdateCalls, 2);
+  EXPECT_EQ(callbacks_.windowUpdates[0], std::vector<uint32_t>({10}));
+  EXPECT_EQ(callbacks_.windowUpdates[1], std::vector<uint32_t>({20000}));
+  EXPECT_EQ(callbacks_.settingsAcks, 1);
+  EXPECT_EQ(callbacks_.recvPingReply, 17);
+  EXPECT_EQ(callbacks_.streamErrors, 0);
+  EXPECT_EQ(callbacks_.sessionErrors, 0);
+}
+
+TEST_F(HTTP2CodecTest, ControlFrameCoalescingThreshold) {
+  upstreamCodec_.enableControlFrameCoalescing();
+
+  // A small stream delta accumulates without warranting a flush
+  EXPECT_EQ(upstreamCodec_.generateWindowUpdate(output_, 1, 100), 0);
+  EXPECT_FALSE(upstreamCodec_.hasDeferredFrames());
+  EXPECT_EQ(upstreamCodec_.generateDeferredFrames(output_), 0);
+
+  // Once the accumulated delta crosses the threshold it is worth a frame
+  EXPECT_EQ(
+      upstreamCodec_.generateWindowUpdate(output_, 1, http2::kInitialWindow / 2),
+      0);
+  EXPECT_TRUE(upstreamCodec_.hasDeferredFrames());
+  EXPECT_GT(upstreamCodec_.generateDeferredFrames(output_), 0);
+  parse();
+  EXPECT_EQ(callbacks_.windowUpdateCalls, 1);
+  EXPECT_EQ(callbacks_.windowUpdates[1],
+            std::vector<uint32_t>({http2::kInitialWindow / 2 + 100}));
+  EXPECT_EQ(callbacks_.streamErrors, 0);
+  EXPECT_EQ(callbacks_.sessionErrors, 0);
+}
+
 TEST_F(HTTP2CodecTest, ZeroWindow) {
   auto streamID = HTTPCodec::StreamID(1);
   // First generate a frame with delta=1 so as to pass the checks, and then
@@ -1375,6 +1643,40 @@ TEST_F(HTTP2CodecTest, SettingsAck) {
   EXPECT_EQ(callbacks_.sessionErrors, 0);
 }
 
+TEST_F(HTTP2CodecTest, SettingsBufferCache) {
+  auto cache = std::make_shared<HTTP2SettingsBufferCache>();
+  HTTP2Codec otherCodec(TransportDirection::UPSTREAM);
+  upstreamCodec_.setSettingsBufferCache(cache);
+  otherCodec.setSettingsBufferCache(cache);
+  upstreamCodec_.getEgressSettings()->setSetting(
+      SettingsId::MAX_CONCURRENT_STREAMS, 37);
+  otherCodec.getEgressSettings()->setSetting(SettingsId::MAX_CONCURRENT_STREAMS,
+                                             37);
+
+  // The first codec serializes and populates the cache, the second
+  // clones it; the bytes must be identical
+  upstreamCodec_.generateSettings(output_);
+  IOBufQueue cloned{IOBufQueue::cacheChainLength()};
+  otherCodec.generateSettings(cloned);
+  EXPECT_TRUE(IOBufEqualTo()(*output_.front(), *cloned.front()));
+
+  parse();
+  EXPECT_EQ(callbacks_.settings, 1);
+  EXPECT_EQ(callbacks_.maxStreams, 37);
+  EXPECT_EQ(callbacks_.streamErrors, 0);
+  EXPECT_EQ(callbacks_.sessionErrors, 0);
+
+  // A codec whose settings differ refreshes the cache rather than
+  // cloning a stale frame
+  HTTP2Codec thirdCodec(TransportDirection::UPSTREAM);
+  thirdCodec.setSettingsBufferCache(cache);
+  thirdCodec.getEgressSettings()->setSetting(SettingsId::MAX_CONCURRENT_STREAMS,
+                                             38);
+  IOBufQueue refreshed{IOBufQueue::cacheChainLength()};
+  thirdCodec.generateSettings(refreshed);
+  EXPECT_FALSE(IOBufEqualTo()(*cloned.front(), *refreshed.front()));
+}
+
 TEST_F(HTTP2CodecTest, BadSettings) {
   auto settings = upstreamCodec_.getEgressSettings();
   settings->setSetting(SettingsId::INITIAL_WINDOW_SIZE, 0xffffffff);
@@ -2142,6 +2444,83 @@ TEST_F(HTTP2CodecTest, Trailers) {
 #endif
 }
 
+TEST_F(HTTP2CodecTest, GrpcTrailersFastPath) {
+  HTTPMessage req = getGetRequest("/guacamole");
+  req.getHeaders().add(HTTP_HEADER_USER_AGENT, "coolio");
+  upstreamCodec_.generateHeader(output_, 1, req);
+
+  string data("abcde");
+  auto buf = folly::IOBuf::copyBuffer(data.data(), data.length());
+
+  HTTPHeaders trailers;
+  trailers.add("grpc-status", "0");
+  upstreamCodec_.generateBodyWithTrailers(
+      output_, 1, std::move(buf), HTTPCodec::NoPadding, trailers);
+
+  parse();
+
+  EXPECT_EQ(callbacks_.messageBegin, 1);
+  EXPECT_EQ(callbacks_.headersComplete, 1);
+  EXPECT_EQ(callbacks_.bodyCalls, 1);
+  EXPECT_EQ(callbacks_.bodyLength, 5);
+  EXPECT_EQ(callbacks_.trailers, 1);
+  EXPECT_NE(nullptr, callbacks_.msg->getTrailers());
+  EXPECT_EQ("0", callbacks_.msg->getTrailers()->getSingleOrEmpty("grpc-status"));
+  EXPECT_EQ(callbacks_.messageComplete, 1);
+  EXPECT_EQ(callbacks_.streamErrors, 0);
+  EXPECT_EQ(callbacks_.sessionErrors, 0);
+#ifndef NDEBUG
+  EXPECT_EQ(downstreamCodec_.getReceivedFrameCount(), 3);
+#endif
+
+  // The cached fragment is replayable on other streams
+  callbacks_.reset();
+  upstreamCodec_.generateHeader(output_, 3, req);
+  HTTPHeaders trailers2;
+  trailers2.add("grpc-status", "13");
+  upstreamCodec_.generateBodyWithTrailers(
+      output_, 3, nullptr, HTTPCodec::NoPadding, trailers2);
+
+  parse();
+
+  EXPECT_EQ(callbacks_.trailers, 1);
+  EXPECT_NE(nullptr, callbacks_.msg->getTrailers());
+  EXPECT_EQ("13",
+            callbacks_.msg->getTrailers()->getSingleOrEmpty("grpc-status"));
+  EXPECT_EQ(callbacks_.messageComplete, 1);
+  EXPECT_EQ(callbacks_.streamErrors, 0);
+  EXPECT_EQ(callbacks_.sessionErrors, 0);
+}
+
+TEST_F(HTTP2CodecTest, GrpcTrailersFastPathFallback) {
+  HTTPMessage req = getGetRequest("/guacamole");
+  req.getHeaders().add(HTTP_HEADER_USER_AGENT, "coolio");
+  upstreamCodec_.generateHeader(output_, 1, req);
+
+  // Extra trailers and non-canonical status values take the regular
+  // encoder path
+  HTTPHeaders trailers;
+  trailers.add("grpc-status", "01");
+  trailers.add("grpc-message", "bad things");
+  upstreamCodec_.generateBodyWithTrailers(
+      output_, 1, nullptr, HTTPCodec::NoPadding, trailers);
+
+  parse();
+
+  EXPECT_EQ(callbacks_.messageBegin, 1);
+  EXPECT_EQ(callbacks_.headersComplete, 1);
+  EXPECT_EQ(callbacks_.bodyCalls, 0);
+  EXPECT_EQ(callbacks_.trailers, 1);
+  EXPECT_NE(nullptr, callbacks_.msg->getTrailers());
+  EXPECT_EQ("01",
+            callbacks_.msg->getTrailers()->getSingleOrEmpty("grpc-status"));
+  EXPECT_EQ("bad things",
+            callbacks_.msg->getTrailers()->getSingleOrEmpty("grpc-message"));
+  EXPECT_EQ(callbacks_.messageComplete, 1);
+  EXPECT_EQ(callbacks_.streamErrors, 0);
+  EXPECT_EQ(callbacks_.sessionErrors, 0);
+}
+
 TEST_F(HTTP2CodecTest, TrailersWithPseudoHeaders) {
   HTTPMessage req = getGetRequest("/guacamole");
   req.getHeaders().add(HTTP_HEADER_USER_AGENT, "coolio");
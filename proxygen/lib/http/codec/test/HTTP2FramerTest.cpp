@@ -113,6 +113,65 @@ TEST_F(HTTP2FramerTest, ManyDataFrameSizes) {
   }
 }
 
+TEST_F(HTTP2FramerTest, WriteDataFrameBatch) {
+  // Large chunks get chained zero-copy, the sub-limit tail gets coalesced
+  const uint32_t dataLen = 10000;
+  const size_t maxFrameSize = 4096;
+  auto body = makeBuf(dataLen);
+  IOBufQueue data{IOBufQueue::cacheChainLength()};
+  data.append(body->clone());
+  auto written = writeDataFrames(queue_, data, 1, maxFrameSize, kNoPadding,
+                                 true);
+  EXPECT_EQ(written, dataLen + 3 * kFrameHeaderSize);
+  EXPECT_EQ(written, queue_.chainLength());
+
+  Cursor cursor(queue_.front());
+  IOBufQueue parsed{IOBufQueue::cacheChainLength()};
+  uint32_t frames = 0;
+  while (!cursor.isAtEnd()) {
+    FrameHeader outHeader;
+    std::unique_ptr<IOBuf> outBuf;
+    uint16_t padding = 0;
+    ASSERT_EQ(parseFrameHeader(cursor, outHeader), ErrorCode::NO_ERROR);
+    ASSERT_EQ(parseData(cursor, outHeader, outBuf, padding),
+              ErrorCode::NO_ERROR);
+    EXPECT_EQ(padding, 0);
+    EXPECT_EQ(outHeader.flags & END_STREAM,
+              cursor.isAtEnd() ? END_STREAM : 0);
+    parsed.append(std::move(outBuf));
+    frames++;
+  }
+  EXPECT_EQ(frames, 3);
+  EXPECT_EQ(parsed.move()->moveToFbString(), body->moveToFbString());
+}
+
+TEST_F(HTTP2FramerTest, WriteDataFrameBatchPadded) {
+  // Every chunk is under the coalesce limit and lands in one buffer
+  const uint32_t dataLen = 3500;
+  auto body = makeBuf(dataLen);
+  IOBufQueue data{IOBufQueue::cacheChainLength()};
+  data.append(body->clone());
+  writeDataFrames(queue_, data, 1, 1000, Padding(7), false);
+
+  Cursor cursor(queue_.front());
+  IOBufQueue parsed{IOBufQueue::cacheChainLength()};
+  uint32_t frames = 0;
+  while (!cursor.isAtEnd()) {
+    FrameHeader outHeader;
+    std::unique_ptr<IOBuf> outBuf;
+    uint16_t padding = 0;
+    ASSERT_EQ(parseFrameHeader(cursor, outHeader), ErrorCode::NO_ERROR);
+    ASSERT_EQ(parseData(cursor, outHeader, outBuf, padding),
+              ErrorCode::NO_ERROR);
+    EXPECT_EQ(padding, 8);
+    EXPECT_EQ(outHeader.flags & END_STREAM, 0);
+    parsed.append(std::move(outBuf));
+    frames++;
+  }
+  EXPECT_EQ(frames, 4);
+  EXPECT_EQ(parsed.move()->moveToFbString(), body->moveToFbString());
+}
+
 TEST_F(HTTP2FramerTest, BadStreamData) {
   writeFrameHeaderManual(
       queue_, 0, static_cast<uint8_t>(FrameType::DATA), 0, 0);
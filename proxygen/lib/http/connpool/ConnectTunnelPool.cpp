@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "proxygen/lib/http/connpool/ConnectTunnelPool.h"
+
+#include <folly/io/Cursor.h>
+#include <proxygen/lib/http/codec/HTTP2Codec.h>
+#include <proxygen/lib/http/session/HTTPUpstreamSession.h>
+#include <proxygen/lib/utils/Time.h>
+
+namespace proxygen {
+
+ConnectTunnelPool::ConnectTunnelPool(folly::EventBase* evb,
+                                     folly::HHWheelTimer* timer)
+    : evb_(evb), timer_(timer) {
+}
+
+ConnectTunnelPool::~ConnectTunnelPool() {
+  // tunnels unlink themselves via removeTunnel() as they tear down, so
+  // work off a copy and sever the back-pointers first
+  auto tunnels = std::move(tunnels_);
+  tunnels_.clear();
+  for (auto* tunnel : tunnels) {
+    tunnel->poolDestroyed();
+  }
+}
+
+void ConnectTunnelPool::addTunnel(HTTPTransaction* connectTxn,
+                                  const std::string& authority) {
+  auto* tunnel = new Tunnel(*this, connectTxn);
+  tunnels_.push_back(tunnel);
+
+  HTTPMessage connect;
+  connect.setMethod(HTTPMethod::CONNECT);
+  connect.setHTTPVersion(1, 1);
+  connect.setURL(authority);
+  connectTxn->sendHeaders(connect);
+}
+
+HTTPTransaction* ConnectTunnelPool::getTransaction(
+    HTTPTransactionHandler* handler) {
+  // Congestion-first selection: an egress-paused outer stream means any
+  // inner transaction opened there queues behind outer flow control, so
+  // congested tunnels only get traffic when every tunnel is congested.
+  // Within a class the tunnel with the fewest outstanding inner
+  // transactions wins.
+  Tunnel* best = nullptr;
+  auto better = [](Tunnel* candidate, Tunnel* incumbent) {
+    if (!incumbent) {
+      return true;
+    }
+    if (candidate->congested() != incumbent->congested()) {
+      return incumbent->congested();
+    }
+    return candidate->getInnerSession()->getNumOutgoingStreams() <
+           incumbent->getInnerSession()->getNumOutgoingStreams();
+  };
+  for (auto* tunnel : tunnels_) {
+    if (!tunnel->established() || !tunnel->good()) {
+      continue;
+    }
+    auto* inner = tunnel->getInnerSession();
+    if (inner->isClosing() || !inner->supportsMoreTransactions()) {
+      continue;
+    }
+    if (better(tunnel, best)) {
+      best = tunnel;
+    }
+  }
+  if (!best) {
+    return nullptr;
+  }
+  return best->getInnerSession()->newTransaction(handler);
+}
+
+uint32_t ConnectTunnelPool::getNumEstablishedTunnels() const {
+  uint32_t count = 0;
+  for (auto* tunnel : tunnels_) {
+    if (tunnel->established() && tunnel->good()) {
+      count++;
+    }
+  }
+  return count;
+}
+
+void ConnectTunnelPool::drainAllTunnels() {
+  for (auto* tunnel : tunnels_) {
+    tunnel->startDrain();
+  }
+}
+
+void ConnectTunnelPool::removeTunnel(Tunnel* tunnel) {
+  tunnels_.remove(tunnel);
+}
+
+// === Tunnel ===
+
+ConnectTunnelPool::Tunnel::Tunnel(ConnectTunnelPool& pool,
+                                  HTTPTransaction* connectTxn)
+    : pool_(&pool), txn_(connectTxn), eventBase_(pool.evb_) {
+  txn_->setHandler(this);
+  txn_->getLocalAddress(localAddress_);
+  txn_->getPeerAddress(peerAddress_);
+}
+
+void ConnectTunnelPool::Tunnel::poolDestroyed() {
+  pool_ = nullptr;
+  closeNow();
+}
+
+void ConnectTunnelPool::Tunnel::startDrain() {
+  if (innerSession_) {
+    // the inner session winds down its streams; close() follows once it
+    // releases the transport
+    innerSession_->drain();
+  } else if (txn_) {
+    // never established (or still waiting for the CONNECT response)
+    txn_->sendAbort();
+  }
+}
+
+void ConnectTunnelPool::Tunnel::setTransaction(
+    HTTPTransaction* txn) noexcept {
+  DCHECK_EQ(txn, txn_);
+}
+
+void ConnectTunnelPool::Tunnel::detachTransaction() noexcept {
+  txn_ = nullptr;
+  if (pool_) {
+    pool_->removeTunnel(this);
+    pool_ = nullptr;
+  }
+  if (innerReleased_) {
+    folly::DelayedDestruction::destroy();
+    return;
+  }
+  if (readCallback_) {
+    // the outer stream died under a live inner session; surface it as a
+    // transport error so the session tears down and releases us
+    auto* callback = readCallback_;
+    readCallback_ = nullptr;
+    error_ = true;
+    callback->readErr(folly::AsyncSocketException(
+        folly::AsyncSocketException::INTERNAL_ERROR, "CONNECT tunnel closed"));
+  }
+}
+
+void ConnectTunnelPool::Tunnel::onHeadersComplete(
+    std::unique_ptr<HTTPMessage> msg) noexcept {
+  if (!txn_ || msg->getStatusCode() / 100 != 2) {
+    VLOG(3) << "CONNECT tunnel refused, status="
+            << (msg ? msg->getStatusCode() : 0);
+    if (txn_) {
+      txn_->sendAbort();
+    }
+    return;
+  }
+  wangle::TransportInfo tinfo;
+  tinfo.acceptTime = getCurrentTime();
+  // The inner session owns this transport from here on; see the class
+  // comment for the two-sided teardown
+  innerSession_ = new HTTPUpstreamSession(
+      pool_->timer_,
+      folly::AsyncTransport::UniquePtr(this),
+      localAddress_,
+      peerAddress_,
+      std::make_unique<HTTP2Codec>(TransportDirection::UPSTREAM),
+      tinfo,
+      nullptr);
+  innerSession_->startNow();
+}
+
+void ConnectTunnelPool::Tunnel::onBody(
+    std::unique_ptr<folly::IOBuf> chain) noexcept {
+  if (!chain) {
+    return;
+  }
+  appBytesReceived_ += chain->computeChainDataLength();
+  readBuf_.append(std::move(chain));
+  pumpReads();
+}
+
+void ConnectTunnelPool::Tunnel::onEOM() noexcept {
+  ingressEof_ = true;
+  pumpReads();
+}
+
+void ConnectTunnelPool::Tunnel::onError(const HTTPException& error) noexcept {
+  VLOG(3) << "CONNECT tunnel error: " << error.what();
+  error_ = true;
+  if (readCallback_) {
+    auto* callback = readCallback_;
+    readCallback_ = nullptr;
+    callback->readErr(folly::AsyncSocketException(
+        folly::AsyncSocketException::INTERNAL_ERROR, error.what()));
+  }
+}
+
+void ConnectTunnelPool::Tunnel::onEgressPaused() noexcept {
+  egressPaused_ = true;
+}
+
+void ConnectTunnelPool::Tunnel::onEgressResumed() noexcept {
+  egressPaused_ = false;
+}
+
+void ConnectTunnelPool::Tunnel::setReadCB(ReadCallback* callback) {
+  readCallback_ = callback;
+  if (callback) {
+    pumpReads();
+  }
+}
+
+void ConnectTunnelPool::Tunnel::pumpReads() {
+  while (readCallback_ && !readBuf_.empty()) {
+    if (readCallback_->isBufferMovable()) {
+      readCallback_->readBufferAvailable(readBuf_.move());
+    } else {
+      void* buf = nullptr;
+      size_t len = 0;
+      readCallback_->getReadBuffer(&buf, &len);
+      if (!buf || len == 0) {
+        onError(HTTPException(HTTPException::Direction::INGRESS,
+                              "inner session provided no read buffer"));
+        return;
+      }
+      folly::io::Cursor cursor(readBuf_.front());
+      auto copied = cursor.pullAtMost(buf, len);
+      readBuf_.trimStart(copied);
+      readCallback_->readDataAvailable(copied);
+    }
+  }
+  if (ingressEof_ && readCallback_ && readBuf_.empty()) {
+    auto* callback = readCallback_;
+    readCallback_ = nullptr;
+    callback->readEOF();
+  }
+}
+
+void ConnectTunnelPool::Tunnel::write(WriteCallback* callback,
+                                      const void* buf,
+                                      size_t bytes,
+                                      folly::WriteFlags flags) {
+  writeChain(callback, folly::IOBuf::copyBuffer(buf, bytes), flags);
+}
+
+void ConnectTunnelPool::Tunnel::writev(WriteCallback* callback,
+                                       const struct iovec* vec,
+                                       size_t count,
+                                       folly::WriteFlags flags) {
+  folly::IOBufQueue queue(folly::IOBufQueue::cacheChainLength());
+  for (size_t i = 0; i < count; i++) {
+    queue.append(folly::IOBuf::copyBuffer(vec[i].iov_base, vec[i].iov_len));
+  }
+  writeChain(callback, queue.move(), flags);
+}
+
+void ConnectTunnelPool::Tunnel::writeChain(WriteCallback* callback,
+                                           std::unique_ptr<folly::IOBuf>&& buf,
+                                           folly::WriteFlags /*flags*/) {
+  if (!good()) {
+    if (callback) {
+      callback->writeErr(0,
+                         folly::AsyncSocketException(
+                             folly::AsyncSocketException::NOT_OPEN,
+                             "CONNECT tunnel closed"));
+    }
+    return;
+  }
+  appBytesWritten_ += buf->computeChainDataLength();
+  // the outer transaction buffers under its own flow control; success
+  // here means "accepted", with backpressure reported via
+  // onEgressPaused() and consumed by the pool's tunnel selection
+  txn_->sendBody(std::move(buf));
+  if (callback) {
+    callback->writeSuccess();
+  }
+}
+
+void ConnectTunnelPool::Tunnel::close() {
+  readCallback_ = nullptr;
+  if (txn_) {
+    txn_->sendEOM();
+  }
+}
+
+void ConnectTunnelPool::Tunnel::closeNow() {
+  readCallback_ = nullptr;
+  if (txn_) {
+    txn_->sendAbort();
+  }
+}
+
+void ConnectTunnelPool::Tunnel::shutdownWrite() {
+  if (txn_) {
+    txn_->sendEOM();
+  }
+}
+
+void ConnectTunnelPool::Tunnel::destroy() {
+  innerReleased_ = true;
+  innerSession_ = nullptr;
+  readCallback_ = nullptr;
+  if (txn_) {
+    // aborting detaches the outer transaction, which completes the
+    // teardown in detachTransaction(); this may happen synchronously
+    txn_->sendAbort();
+    return;
+  }
+  folly::DelayedDestruction::destroy();
+}
+
+} // namespace proxygen
@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <list>
+#include <string>
+
+#include <folly/io/IOBufQueue.h>
+#include <folly/io/async/AsyncTransport.h>
+
+#include "proxygen/lib/http/session/HTTPTransaction.h"
+
+namespace proxygen {
+
+class HTTPUpstreamSession;
+
+/**
+ * Pools established CONNECT tunnels to gateway nodes and vends inner
+ * HTTP/2 upstream sessions multiplexed over them, so inner connections
+ * reuse warm outer tunnels instead of paying tunnel setup and slow
+ * start per connection.
+ *
+ * The caller opens a CONNECT transaction on an outer gateway session
+ * (typically checked out of a regular SessionPool) and hands it to
+ * addTunnel(), which sends the CONNECT request and, once the gateway
+ * answers 2xx, brings up one inner HTTP/2 session over the tunnel's
+ * byte stream.  getTransaction() then opens inner transactions on the
+ * least congested established tunnel: tunnels whose outer stream is
+ * egress-paused by flow control are passed over while an uncongested
+ * one remains, and ties go to the tunnel with the fewest outstanding
+ * inner transactions.
+ *
+ * Like SessionPool this is strictly single-threaded; everything runs on
+ * the outer sessions' EventBase.  Destroying the pool aborts all
+ * tunnels outright; to wind down gracefully call drainAllTunnels() and
+ * destroy the pool once it is empty.
+ */
+class ConnectTunnelPool {
+ public:
+  ConnectTunnelPool(folly::EventBase* evb, folly::HHWheelTimer* timer);
+
+  ~ConnectTunnelPool();
+
+  /**
+   * Take over the given outer transaction as a tunnel to `authority`.
+   * The pool installs itself as the transaction's handler and sends the
+   * CONNECT request; the tunnel becomes eligible for getTransaction()
+   * once the gateway responds 2xx, and is discarded on any other
+   * response or stream error.  The transaction must not have had
+   * headers sent on it yet.
+   */
+  void addTunnel(HTTPTransaction* connectTxn, const std::string& authority);
+
+  /**
+   * Open an inner transaction on the least congested established
+   * tunnel.  Returns nullptr if no tunnel can take another transaction.
+   */
+  HTTPTransaction* getTransaction(HTTPTransactionHandler* handler);
+
+  /**
+   * All tunnels, including those still waiting for the CONNECT
+   * response.
+   */
+  uint32_t getNumTunnels() const {
+    return tunnels_.size();
+  }
+
+  uint32_t getNumEstablishedTunnels() const;
+
+  /**
+   * Drain the inner sessions; each tunnel closes once its inner session
+   * exhausts and removes itself from the pool.
+   */
+  void drainAllTunnels();
+
+ private:
+  /**
+   * One outer CONNECT stream and the inner session riding on it.  The
+   * tunnel is the handler of the outer transaction and, at the same
+   * time, the folly::AsyncTransport the inner HTTPUpstreamSession reads
+   * from and writes to: outer ingress body is the inner session's read
+   * stream, inner writes become outer sendBody() calls.
+   *
+   * Lifetime is shared between the two sides: the inner session owns
+   * the tunnel through its AsyncTransport::UniquePtr (which calls
+   * destroy()), and the outer transaction requires its handler to stay
+   * alive until detachTransaction().  The tunnel therefore frees itself
+   * only once the inner session has released it AND the outer
+   * transaction has detached, whichever order the two sides die in.
+   */
+  class Tunnel
+      : public folly::AsyncTransport
+      , public HTTPTransactionHandler {
+   public:
+    Tunnel(ConnectTunnelPool& pool, HTTPTransaction* connectTxn);
+
+    bool established() const {
+      return innerSession_ != nullptr;
+    }
+
+    /**
+     * The outer stream cannot accept more egress right now; inner
+     * transactions opened here would only queue behind it.
+     */
+    bool congested() const {
+      return egressPaused_;
+    }
+
+    HTTPUpstreamSession* getInnerSession() const {
+      return innerSession_;
+    }
+
+    void startDrain();
+
+    /**
+     * The pool is going away first; sever the back-pointer and abort
+     * the tunnel.  The tunnel then frees itself through the usual
+     * two-sided teardown.
+     */
+    void poolDestroyed();
+
+    // HTTPTransactionHandler (outer CONNECT stream)
+    void setTransaction(HTTPTransaction* txn) noexcept override;
+    void detachTransaction() noexcept override;
+    void onHeadersComplete(std::unique_ptr<HTTPMessage> msg) noexcept override;
+    void onBody(std::unique_ptr<folly::IOBuf> chain) noexcept override;
+    void onChunkHeader(size_t /*length*/) noexcept override {
+    }
+    void onChunkComplete() noexcept override {
+    }
+    void onTrailers(std::unique_ptr<HTTPHeaders> /*trailers*/) noexcept
+        override {
+    }
+    void onEOM() noexcept override;
+    void onUpgrade(UpgradeProtocol /*protocol*/) noexcept override {
+    }
+    void onError(const HTTPException& error) noexcept override;
+    void onEgressPaused() noexcept override;
+    void onEgressResumed() noexcept override;
+
+    // folly::AsyncTransport (inner session's byte stream)
+    void setReadCB(ReadCallback* callback) override;
+    ReadCallback* getReadCallback() const override {
+      return readCallback_;
+    }
+    void write(WriteCallback* callback,
+               const void* buf,
+               size_t bytes,
+               folly::WriteFlags flags = folly::WriteFlags::NONE) override;
+    void writev(WriteCallback* callback,
+                const struct iovec* vec,
+                size_t count,
+                folly::WriteFlags flags = folly::WriteFlags::NONE) override;
+    void writeChain(WriteCallback* callback,
+                    std::unique_ptr<folly::IOBuf>&& buf,
+                    folly::WriteFlags flags = folly::WriteFlags::NONE) override;
+    void close() override;
+    void closeNow() override;
+    void closeWithReset() override {
+      closeNow();
+    }
+    void shutdownWrite() override;
+    void shutdownWriteNow() override {
+      shutdownWrite();
+    }
+    bool good() const override {
+      return txn_ != nullptr && !error_;
+    }
+    bool readable() const override {
+      return good();
+    }
+    bool connecting() const override {
+      return false;
+    }
+    bool error() const override {
+      return error_;
+    }
+    void attachEventBase(folly::EventBase* /*eventBase*/) override {
+    }
+    void detachEventBase() override {
+    }
+    bool isDetachable() const override {
+      return false;
+    }
+    folly::EventBase* getEventBase() const override {
+      return eventBase_;
+    }
+    void getLocalAddress(folly::SocketAddress* addr) const override {
+      *addr = localAddress_;
+    }
+    void getPeerAddress(folly::SocketAddress* addr) const override {
+      *addr = peerAddress_;
+    }
+    void setSendTimeout(uint32_t /*milliseconds*/) override {
+    }
+    uint32_t getSendTimeout() const override {
+      return 0;
+    }
+    size_t getAppBytesWritten() const override {
+      return appBytesWritten_;
+    }
+    size_t getRawBytesWritten() const override {
+      return appBytesWritten_;
+    }
+    size_t getAppBytesReceived() const override {
+      return appBytesReceived_;
+    }
+    size_t getRawBytesReceived() const override {
+      return appBytesReceived_;
+    }
+    bool isEorTrackingEnabled() const override {
+      return false;
+    }
+    void setEorTracking(bool /*track*/) override {
+    }
+
+   protected:
+    // reached through destroy() once both sides have let go
+    ~Tunnel() override = default;
+
+    // called by the inner session's AsyncTransport::UniquePtr
+    void destroy() override;
+
+   private:
+    void pumpReads();
+    void closeInner(ProxygenError err);
+
+    ConnectTunnelPool* pool_{nullptr};
+    HTTPTransaction* txn_{nullptr};
+    HTTPUpstreamSession* innerSession_{nullptr};
+    folly::EventBase* eventBase_{nullptr};
+    folly::SocketAddress localAddress_;
+    folly::SocketAddress peerAddress_;
+
+    ReadCallback* readCallback_{nullptr};
+    // outer ingress not yet delivered to the inner session
+    folly::IOBufQueue readBuf_{folly::IOBufQueue::cacheChainLength()};
+    size_t appBytesWritten_{0};
+    size_t appBytesReceived_{0};
+    bool egressPaused_{false};
+    bool ingressEof_{false};
+    bool error_{false};
+    bool innerReleased_{false};
+  };
+
+  void removeTunnel(Tunnel* tunnel);
+
+  folly::EventBase* evb_{nullptr};
+  folly::HHWheelTimer* timer_{nullptr};
+  std::list<Tunnel*> tunnels_;
+};
+
+} // namespace proxygen
@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "proxygen/lib/http/connpool/HedgingController.h"
+
+#include <algorithm>
+#include <folly/io/async/EventBase.h>
+
+using std::chrono::milliseconds;
+
+namespace proxygen {
+
+/**
+ * One hedged request in flight: up to two attempts racing on the pool,
+ * plus the timer that launches the second one.  Self-owning; deletes
+ * itself once neither attempt holds a transaction and the timer is
+ * disarmed.
+ */
+class HedgingController::HedgedRequest : private folly::AsyncTimeout {
+ public:
+  HedgedRequest(HedgingController& controller,
+                HTTPTransaction::Handler* handler,
+                const HTTPMessage& request)
+      : folly::AsyncTimeout(controller.pool_->getEventBase()),
+        controller_(controller),
+        handler_(handler),
+        request_(request) {
+    primary_.request_ = this;
+    hedge_.request_ = this;
+    ++controller_.outstanding_;
+  }
+
+  ~HedgedRequest() override {
+    --controller_.outstanding_;
+  }
+
+  /**
+   * Fire the primary attempt and arm the hedge timer.  Returns false
+   * (and leaves the handler untouched) if the pool has no session; the
+   * caller deletes us in that case.
+   */
+  bool start() {
+    if (!launch(primary_)) {
+      return false;
+    }
+    startTime_ = getCurrentTime();
+    scheduleTimeout(controller_.getHedgeDelay().count());
+    return true;
+  }
+
+ private:
+  class Attempt : public HTTPTransaction::Handler {
+   public:
+    void setTransaction(HTTPTransaction* txn) noexcept override {
+      txn_ = txn;
+    }
+    void detachTransaction() noexcept override {
+      txn_ = nullptr;
+      request_->onAttemptDetached(*this);
+    }
+    void onHeadersComplete(std::unique_ptr<HTTPMessage> msg) noexcept override {
+      request_->onAttemptHeaders(*this, std::move(msg));
+    }
+    void onBody(std::unique_ptr<folly::IOBuf> chain) noexcept override {
+      if (request_->isWinner(*this)) {
+        request_->handler_->onBody(std::move(chain));
+      }
+    }
+    void onChunkHeader(size_t length) noexcept override {
+      if (request_->isWinner(*this)) {
+        request_->handler_->onChunkHeader(length);
+      }
+    }
+    void onChunkComplete() noexcept override {
+      if (request_->isWinner(*this)) {
+        request_->handler_->onChunkComplete();
+      }
+    }
+    void onTrailers(std::unique_ptr<HTTPHeaders> trailers) noexcept override {
+      if (request_->isWinner(*this)) {
+        request_->handler_->onTrailers(std::move(trailers));
+      }
+    }
+    void onEOM() noexcept override {
+      if (request_->isWinner(*this)) {
+        request_->handler_->onEOM();
+      }
+    }
+    void onUpgrade(UpgradeProtocol protocol) noexcept override {
+      if (request_->isWinner(*this)) {
+        request_->handler_->onUpgrade(protocol);
+      }
+    }
+    void onError(const HTTPException& error) noexcept override {
+      request_->onAttemptError(*this, error);
+    }
+    void onEgressPaused() noexcept override {
+    }
+    void onEgressResumed() noexcept override {
+    }
+
+    HedgedRequest* request_{nullptr};
+    HTTPTransaction* txn_{nullptr};
+  };
+
+  void timeoutExpired() noexcept override {
+    if (winner_ == nullptr && primary_.txn_ != nullptr) {
+      launch(hedge_);
+    }
+    // If the launch failed there is nothing to do: the primary is still
+    // racing alone, or everything is already detached and maybeDelete
+    // will run from the last detach.
+    maybeDelete();
+  }
+
+  bool launch(Attempt& attempt) {
+    auto txn = controller_.pool_->getTransaction(&attempt);
+    if (txn == nullptr) {
+      return false;
+    }
+    if (&attempt == &hedge_) {
+      hedgeLaunched_ = true;
+      ++controller_.hedgesLaunched_;
+    }
+    txn->sendHeadersWithEOM(request_);
+    return true;
+  }
+
+  bool isWinner(const Attempt& attempt) const {
+    return winner_ == &attempt;
+  }
+
+  void onAttemptHeaders(Attempt& attempt, std::unique_ptr<HTTPMessage> msg) {
+    if (winner_ != nullptr) {
+      // The loser got its headers in before our abort reached it.
+      return;
+    }
+    winner_ = &attempt;
+    cancelTimeout();
+    controller_.recordLatency(millisecondsBetween(getCurrentTime(), startTime_));
+    if (&attempt == &hedge_) {
+      ++controller_.hedgesWon_;
+      if (primary_.txn_ != nullptr) {
+        primary_.txn_->sendAbort();
+      }
+    } else if (hedge_.txn_ != nullptr) {
+      hedge_.txn_->sendAbort();
+    }
+    handler_->setTransaction(attempt.txn_);
+    handler_->onHeadersComplete(std::move(msg));
+  }
+
+  void onAttemptError(Attempt& attempt, const HTTPException& error) {
+    if (winner_ != nullptr) {
+      if (isWinner(attempt)) {
+        handler_->onError(error);
+      }
+      // Loser errors (including the abort we sent it) are expected.
+      return;
+    }
+    Attempt& other = (&attempt == &primary_) ? hedge_ : primary_;
+    if (other.txn_ != nullptr) {
+      // The other attempt is still racing; let it run.
+      return;
+    }
+    if (!hedgeLaunched_ && isScheduled()) {
+      // The only attempt died before the hedge delay elapsed.  Fire the
+      // hedge immediately as a retry rather than failing the request.
+      cancelTimeout();
+      if (launch(hedge_)) {
+        return;
+      }
+    }
+    if (!errorDelivered_) {
+      errorDelivered_ = true;
+      handler_->onError(error);
+    }
+  }
+
+  void onAttemptDetached(Attempt& attempt) {
+    if (isWinner(attempt)) {
+      handler_->detachTransaction();
+    }
+    maybeDelete();
+  }
+
+  void maybeDelete() {
+    if (primary_.txn_ == nullptr && hedge_.txn_ == nullptr &&
+        !isScheduled()) {
+      delete this;
+    }
+  }
+
+  HedgingController& controller_;
+  HTTPTransaction::Handler* const handler_;
+  const HTTPMessage request_;
+  TimePoint startTime_;
+  Attempt primary_;
+  Attempt hedge_;
+  Attempt* winner_{nullptr};
+  bool hedgeLaunched_{false};
+  bool errorDelivered_{false};
+};
+
+HedgingController::HedgingController(SessionPool* pool,
+                                     double hedgePercentile,
+                                     milliseconds minHedgeDelay,
+                                     milliseconds maxHedgeDelay,
+                                     milliseconds histogramWindow)
+    : pool_(CHECK_NOTNULL(pool)),
+      hedgePercentile_(hedgePercentile),
+      minHedgeDelay_(minHedgeDelay),
+      maxHedgeDelay_(maxHedgeDelay),
+      histogramWindow_(histogramWindow),
+      generationStart_(getCurrentTime()) {
+  CHECK_GT(hedgePercentile_, 0.0);
+  CHECK_LE(hedgePercentile_, 1.0);
+  CHECK_LE(minHedgeDelay_, maxHedgeDelay_);
+}
+
+HedgingController::~HedgingController() {
+  DCHECK_EQ(outstanding_, 0) << "destroyed with hedged requests in flight";
+}
+
+bool HedgingController::isHedgeable(const HTTPMessage& request) {
+  auto method = request.getMethod();
+  if (!method) {
+    return false;
+  }
+  switch (*method) {
+    case HTTPMethod::GET:
+    case HTTPMethod::HEAD:
+    case HTTPMethod::OPTIONS:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool HedgingController::sendRequest(HTTPTransaction::Handler* handler,
+                                    const HTTPMessage& request) {
+  DCHECK(isHedgeable(request));
+  auto hedgedRequest = new HedgedRequest(*this, handler, request);
+  if (!hedgedRequest->start()) {
+    delete hedgedRequest;
+    return false;
+  }
+  return true;
+}
+
+uint32_t HedgingController::bucketFor(milliseconds value) {
+  uint32_t bucket = 0;
+  auto ms = value.count();
+  while (ms > 0 && bucket < kNumBuckets - 1) {
+    ms >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+void HedgingController::recordLatency(milliseconds ttfb) {
+  maybeRotateHistogram();
+  ++buckets_[currentGeneration_][bucketFor(ttfb)];
+}
+
+void HedgingController::maybeRotateHistogram() {
+  auto now = getCurrentTime();
+  if (millisecondsBetween(now, generationStart_) < histogramWindow_) {
+    return;
+  }
+  currentGeneration_ ^= 1;
+  buckets_[currentGeneration_].fill(0);
+  generationStart_ = now;
+}
+
+std::chrono::milliseconds HedgingController::getHedgeDelay() const {
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < kNumBuckets; ++i) {
+    total += buckets_[0][i] + buckets_[1][i];
+  }
+  if (total < kMinSamples) {
+    return maxHedgeDelay_;
+  }
+  // Walk to the bucket containing the target percentile and take its
+  // upper bound, erring on the side of hedging a little later.
+  const auto target = static_cast<uint64_t>(hedgePercentile_ * total);
+  uint64_t cumulative = 0;
+  uint32_t bucket = kNumBuckets - 1;
+  for (uint32_t i = 0; i < kNumBuckets; ++i) {
+    cumulative += buckets_[0][i] + buckets_[1][i];
+    if (cumulative >= target) {
+      bucket = i;
+      break;
+    }
+  }
+  auto estimate = milliseconds(1LL << bucket);
+  return std::min(maxHedgeDelay_, std::max(minHedgeDelay_, estimate));
+}
+
+} // namespace proxygen
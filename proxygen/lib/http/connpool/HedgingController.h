@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <folly/io/async/AsyncTimeout.h>
+#include <proxygen/lib/utils/Time.h>
+
+#include "proxygen/lib/http/connpool/SessionPool.h"
+#include "proxygen/lib/http/session/HTTPTransaction.h"
+
+namespace proxygen {
+
+/**
+ * Sends idempotent requests through a SessionPool with tail-latency
+ * hedging: if the first byte of the response has not arrived within the
+ * hedge delay, the same request is fired again on a second transaction
+ * from the pool, and whichever attempt responds first wins.  The loser
+ * is aborted as soon as the winner's headers arrive, so the extra load
+ * on the upstream is bounded by the fraction of requests slower than
+ * the delay.
+ *
+ * The hedge delay is auto-tuned: every request feeds its time to first
+ * byte into a sliding-window latency histogram, and the delay tracks a
+ * configurable percentile of it (clamped to [minHedgeDelay,
+ * maxHedgeDelay]).  Until enough samples have accumulated the delay
+ * stays at maxHedgeDelay, so a cold controller hedges conservatively.
+ *
+ * One controller covers one endpoint, matching the one-pool-per-endpoint
+ * layout, so the histogram reflects a single upstream's latency.  Like
+ * SessionPool, this class is single-threaded: all methods must be called
+ * on the pool's EventBase thread, and the controller must outlive any
+ * requests in flight through it.
+ *
+ * Handler contract: the caller's Handler is attached only to the winning
+ * attempt.  It receives setTransaction with the winning transaction
+ * immediately before onHeadersComplete, then the rest of that attempt's
+ * ingress, and finally detachTransaction.  If every attempt fails before
+ * producing headers, the handler receives onError exactly once, with no
+ * setTransaction or detachTransaction; handlers that self-delete on
+ * detachTransaction should also do so on such an early onError.
+ */
+class HedgingController {
+ public:
+  /**
+   * @param pool            The pool to draw both attempts from.
+   * @param hedgePercentile The latency percentile the hedge delay tracks.
+   * @param minHedgeDelay   Lower clamp on the auto-tuned delay.
+   * @param maxHedgeDelay   Upper clamp, and the delay used before the
+   *                        histogram has kMinSamples samples.
+   * @param histogramWindow Generation lifetime of the latency histogram;
+   *                        samples age out after at most two windows.
+   */
+  explicit HedgingController(
+      SessionPool* pool,
+      double hedgePercentile = 0.95,
+      std::chrono::milliseconds minHedgeDelay = std::chrono::milliseconds(2),
+      std::chrono::milliseconds maxHedgeDelay = std::chrono::milliseconds(250),
+      std::chrono::milliseconds histogramWindow = std::chrono::seconds(60));
+
+  ~HedgingController();
+
+  /**
+   * Returns true if the request is safe to send twice: an idempotent
+   * method and no body.
+   */
+  static bool isHedgeable(const HTTPMessage& request);
+
+  /**
+   * Send the request (headers + EOM) on a transaction from the pool and
+   * arm the hedge timer.  The request must satisfy isHedgeable().
+   * Returns false, without invoking the handler, if the pool cannot
+   * supply a transaction.
+   */
+  bool sendRequest(HTTPTransaction::Handler* handler,
+                   const HTTPMessage& request);
+
+  /**
+   * The delay after which the next request will hedge.
+   */
+  std::chrono::milliseconds getHedgeDelay() const;
+
+  /**
+   * Feed a time-to-first-byte sample into the latency histogram.  Called
+   * automatically for requests sent through the controller; exposed so
+   * an owner can also fold in latencies observed elsewhere.
+   */
+  void recordLatency(std::chrono::milliseconds ttfb);
+
+  /**
+   * Number of hedge attempts actually fired, and the subset that beat
+   * the primary to the first byte.
+   */
+  uint64_t getHedgesLaunched() const {
+    return hedgesLaunched_;
+  }
+  uint64_t getHedgesWon() const {
+    return hedgesWon_;
+  }
+
+  // Samples required before the delay leaves maxHedgeDelay.
+  static constexpr uint32_t kMinSamples = 32;
+
+ private:
+  class HedgedRequest;
+  friend class HedgedRequest;
+
+  // Power-of-two latency buckets: bucket i covers [2^(i-1), 2^i) ms,
+  // bucket 0 is [0, 1) ms and the last bucket is unbounded.
+  static constexpr uint32_t kNumBuckets = 18;
+
+  static uint32_t bucketFor(std::chrono::milliseconds value);
+  void maybeRotateHistogram();
+
+  SessionPool* const pool_;
+  const double hedgePercentile_;
+  const std::chrono::milliseconds minHedgeDelay_;
+  const std::chrono::milliseconds maxHedgeDelay_;
+  const std::chrono::milliseconds histogramWindow_;
+
+  // Two-generation sliding window, same aging scheme as
+  // RotatingBloomFilter: estimates read both generations, rotation
+  // clears the older one.
+  std::array<std::array<uint32_t, kNumBuckets>, 2> buckets_{};
+  uint8_t currentGeneration_{0};
+  TimePoint generationStart_;
+
+  uint64_t hedgesLaunched_{0};
+  uint64_t hedgesWon_{0};
+  // Requests in flight; must be zero when the controller is destroyed.
+  uint64_t outstanding_{0};
+};
+
+} // namespace proxygen
@@ -13,15 +13,24 @@ namespace proxygen {
 folly::Future<HTTPSessionBase*> ServerIdleSessionController::getIdleSession() {
   folly::Promise<HTTPSessionBase*> promise;
   folly::Future<HTTPSessionBase*> future = promise.getFuture();
-  SessionPool* maxPool = nullptr;
+  if (isMarkedForDeath()) {
+    return folly::makeFuture<HTTPSessionBase*>(nullptr);
+  }
 
-  {
+  // Fast path: claim an advertised pool with one exchange, no mutex.  The
+  // pool's own idle list is revalidated on its thread below, so a stale
+  // hint can only produce a nullptr miss.
+  SessionPool* maxPool = claimIdlePoolHint();
+  if (!maxPool) {
     std::lock_guard<std::mutex> lock(lock_);
     maxPool = popBestIdlePool();
-    if (markedForDeath_ || !maxPool || !maxPool->getEventBase()) {
+    if (markedForDeath_.load(std::memory_order_relaxed) || !maxPool) {
       return folly::makeFuture<HTTPSessionBase*>(nullptr);
     }
   }
+  if (!maxPool->getEventBase()) {
+    return folly::makeFuture<HTTPSessionBase*>(nullptr);
+  }
 
   if (maxPool->getEventBase()->isInEventBaseThread()) {
     LOG(ERROR) << "Idle session already belongs to current thread!";
@@ -54,6 +63,7 @@ void ServerIdleSessionController::addIdleSession(const HTTPSessionBase* session,
     auto newIt = sessionsByIdleAge_.insert(sessionsByIdleAge_.end(),
                                            {session, sessionPool});
     sessionMap_[session] = newIt;
+    publishIdlePoolHint(sessionPool);
   }
 }
 
@@ -62,16 +72,21 @@ void ServerIdleSessionController::removeIdleSession(
   std::lock_guard<std::mutex> lock(lock_);
   auto it = sessionMap_.find(session);
   if (it != sessionMap_.end()) {
+    auto* pool = it->second->sessionPool;
     sessionsByIdleAge_.erase(it->second);
     sessionMap_.erase(it);
+    purgeIdlePoolHintsIfUnlisted(pool);
   }
 }
 
 void ServerIdleSessionController::markForDeath() {
   std::lock_guard<std::mutex> lock(lock_);
-  markedForDeath_ = true;
+  markedForDeath_.store(true, std::memory_order_release);
   sessionMap_.clear();
   sessionsByIdleAge_.clear();
+  for (auto& slot : idleHints_) {
+    slot.store(nullptr, std::memory_order_release);
+  }
 }
 
 // must be called under lock_
@@ -80,9 +95,49 @@ SessionPool* FOLLY_NULLABLE ServerIdleSessionController::popBestIdlePool() {
     auto ret = *sessionsByIdleAge_.begin();
     sessionsByIdleAge_.erase(sessionsByIdleAge_.begin());
     sessionMap_.erase(ret.session);
+    purgeIdlePoolHintsIfUnlisted(ret.sessionPool);
     return ret.sessionPool;
   }
   return nullptr;
 }
 
+void ServerIdleSessionController::publishIdlePoolHint(SessionPool* pool) {
+  for (auto& slot : idleHints_) {
+    SessionPool* expected = nullptr;
+    if (slot.compare_exchange_strong(
+            expected, pool, std::memory_order_release)) {
+      return;
+    }
+  }
+  // every stripe is taken; the locked list still covers this session
+}
+
+SessionPool* FOLLY_NULLABLE ServerIdleSessionController::claimIdlePoolHint() {
+  for (auto& slot : idleHints_) {
+    if (slot.load(std::memory_order_relaxed) != nullptr) {
+      if (auto* pool = slot.exchange(nullptr, std::memory_order_acquire)) {
+        return pool;
+      }
+    }
+  }
+  return nullptr;
+}
+
+void ServerIdleSessionController::purgeIdlePoolHints(SessionPool* pool) {
+  for (auto& slot : idleHints_) {
+    SessionPool* expected = pool;
+    slot.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
+  }
+}
+
+void ServerIdleSessionController::purgeIdlePoolHintsIfUnlisted(
+    SessionPool* pool) {
+  for (const auto& info : sessionsByIdleAge_) {
+    if (info.sessionPool == pool) {
+      return;
+    }
+  }
+  purgeIdlePoolHints(pool);
+}
+
 } // namespace proxygen
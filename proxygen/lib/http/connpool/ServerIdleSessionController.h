@@ -10,6 +10,8 @@
 
 #include "proxygen/lib/http/connpool/SessionPool.h"
 
+#include <array>
+#include <atomic>
 #include <folly/futures/Future.h>
 
 namespace proxygen {
@@ -66,9 +68,24 @@ class ServerIdleSessionController {
    */
   SessionPool* FOLLY_NULLABLE popBestIdlePool();
 
+  /**
+   * Lock-free fast path.  Pools with idle sessions advertise themselves in
+   * a small striped array of atomic slots; getIdleSession() claims one
+   * with a single exchange and skips the mutex entirely.  Slots are only
+   * hints -- the authoritative idle list lives in the owning SessionPool
+   * and is revalidated on its EventBase thread by removeOldestIdleSession,
+   * so a stale hint costs a reuse miss, never a wrong session.
+   */
+  void publishIdlePoolHint(SessionPool* pool);
+  SessionPool* FOLLY_NULLABLE claimIdlePoolHint();
+  // Drop all hints advertising the given pool.
+  void purgeIdlePoolHints(SessionPool* pool);
+  // Must be called under lock_: purge hints once the pool has no sessions
+  // left in sessionsByIdleAge_, so a hint can never outlive its pool.
+  void purgeIdlePoolHintsIfUnlisted(SessionPool* pool);
+
   bool isMarkedForDeath() {
-    std::lock_guard<std::mutex> lock(lock_);
-    return markedForDeath_;
+    return markedForDeath_.load(std::memory_order_acquire);
   }
 
   std::mutex lock_;
@@ -83,7 +100,13 @@ class ServerIdleSessionController {
   IdleSessionList sessionsByIdleAge_;
   // Store iterators in sessionsByIdleAge_ to be able to find sessions.
   std::unordered_map<const HTTPSessionBase*, IdleSessionListIter> sessionMap_;
-  bool markedForDeath_{false};
+
+  // Striped idle pool hints, see publishIdlePoolHint().
+  static constexpr size_t kIdleHintStripes = 8;
+  std::array<std::atomic<SessionPool*>, kIdleHintStripes> idleHints_{};
+
+  // Written under lock_, read lock-free by the claim fast path.
+  std::atomic<bool> markedForDeath_{false};
 
   // Default idle pool size to 2.
   unsigned int maxIdleCount_{2};
@@ -324,6 +324,21 @@ void SessionHolder::onSettingsAck(const HTTPSessionBase& sess) {
   }
 }
 
+void SessionHolder::onGoawayReceived(const HTTPSessionBase& sess) {
+  if (originalSessionInfoCb_) {
+    originalSessionInfoCb_->onGoawayReceived(sess);
+  }
+  if (state_ != ListState::DETACHED) {
+    VLOG(4) << *this << " retiring on GOAWAY";
+    // Retire immediately: tell the pool first (while the holder is still
+    // linked, so it can see its remaining capacity), then drain.  This
+    // closes the window where a new checkout races the drain and pays a
+    // failed transaction.
+    parent_->onSessionRetired(this);
+    drain();
+  }
+}
+
 void SessionHolder::describe(std::ostream& os) const {
   const AsyncSocket* sock =
       session_->getTransport()->getUnderlyingTransport<AsyncSocket>();
@@ -35,6 +35,13 @@ class SessionHolder : private HTTPSessionBase::InfoCallback {
     virtual void attachPartiallyFilled(SessionHolder*) = 0;
     virtual void attachFilled(SessionHolder*) = 0;
     virtual void addDrainingSession(HTTPSessionBase*) = 0;
+    /**
+     * Invoked when a pooled session is proactively retired because the
+     * server sent GOAWAY, while the holder is still linked.  The holder
+     * drains (and deletes itself) immediately after this returns.
+     */
+    virtual void onSessionRetired(SessionHolder*) {
+    }
   };
 
   class Stats {
@@ -141,6 +148,7 @@ class SessionHolder : private HTTPSessionBase::InfoCallback {
   void onEgressBufferCleared(const HTTPSessionBase&) override;
   void onSettings(const HTTPSessionBase&, const SettingsList&) override;
   void onSettingsAck(const HTTPSessionBase&) override;
+  void onGoawayReceived(const HTTPSessionBase&) override;
 
   // Hook in the first session pool list.
   folly::SafeIntrusiveListHook listHook;
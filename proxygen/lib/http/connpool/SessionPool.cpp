@@ -10,9 +10,39 @@
 #include "proxygen/lib/http/connpool/ServerIdleSessionController.h"
 #include "proxygen/lib/http/connpool/ThreadIdleSessionController.h"
 
+#include <algorithm>
 #include <chrono>
 #include <folly/io/async/EventBaseManager.h>
 
+namespace {
+
+// How many sessions at the front of the unfilled list load-aware
+// scheduling considers per transaction.  Pools are per-endpoint, so this
+// usually covers the whole list.
+constexpr uint32_t kLoadAwareScanLimit = 8;
+
+/**
+ * Weighted-least-loaded score for a multiplexed session; lower is
+ * better.  Outstanding transactions are normalized by the session's
+ * advertised concurrency limit, so the session with the most headroom
+ * wins among equally fast peers, then weighted by the observed transport
+ * RTT so a nearly idle but slow session doesn't beat a moderately busy
+ * fast one.  Sessions without an RTT sample yet compete on load alone.
+ */
+double sessionLoadScore(const proxygen::HTTPSessionBase& session) {
+  double relativeLoad =
+      (session.getNumOutgoingStreams() + 1) /
+      double(std::max(session.getMaxConcurrentOutgoingStreams(), 1u));
+  wangle::TransportInfo tinfo;
+  std::chrono::microseconds rtt{0};
+  if (session.getCurrentTransportInfoWithoutUpdate(&tinfo)) {
+    rtt = tinfo.rtt;
+  }
+  return relativeLoad * std::max<int64_t>(rtt.count(), 1);
+}
+
+} // namespace
+
 namespace proxygen {
 
 SessionPool::SessionPool(
@@ -100,6 +130,19 @@ void SessionPool::putSession(HTTPSessionBase* session) {
 
 HTTPTransaction* SessionPool::getTransaction(
     HTTPTransaction::Handler* upstreamHandler) {
+  if (loadAwareScheduling_) {
+    auto txn = attemptOpenTransactionLoadAware(upstreamHandler);
+    if (!txn) {
+      purgeExcessIdleSessions();
+      txn = attemptOpenTransaction(upstreamHandler, idleSessionList_);
+    }
+    if (!txn) {
+      // Every unfilled session is past the knee and no idle session is
+      // left; use the least bad option rather than failing
+      txn = attemptOpenTransaction(upstreamHandler, unfilledSessionList_);
+    }
+    return txn;
+  }
   auto txn = attemptOpenTransaction(upstreamHandler, unfilledSessionList_);
   if (!txn) {
     purgeExcessIdleSessions();
@@ -108,6 +151,12 @@ HTTPTransaction* SessionPool::getTransaction(
   return txn;
 }
 
+void SessionPool::setLoadAwareScheduling(bool enabled,
+                                         uint32_t concurrencyKnee) {
+  loadAwareScheduling_ = enabled;
+  concurrencyKnee_ = concurrencyKnee;
+}
+
 void SessionPool::purgeExcessIdleSessions() {
   auto thresh = std::chrono::steady_clock::now() - getTimeout();
 
@@ -180,6 +229,44 @@ HTTPTransaction* SessionPool::attemptOpenTransaction(
   return nullptr;
 }
 
+HTTPTransaction* SessionPool::attemptOpenTransactionLoadAware(
+    HTTPTransaction::Handler* upstreamHandler) {
+  while (!unfilledSessionList_.empty()) {
+    SessionHolder* best = nullptr;
+    double bestScore = 0;
+    uint32_t scanned = 0;
+    for (auto it = unfilledSessionList_.begin();
+         it != unfilledSessionList_.end() && scanned < kLoadAwareScanLimit;
+         ++it, ++scanned) {
+      if (concurrencyKnee_ > 0 &&
+          it->getSession().getNumOutgoingStreams() >= concurrencyKnee_) {
+        continue;
+      }
+      auto score = sessionLoadScore(it->getSession());
+      if (!best || score < bestScore) {
+        best = &*it;
+        bestScore = score;
+      }
+    }
+    if (!best) {
+      return nullptr;
+    }
+    if (best->shouldAgeOut(maxAge_)) {
+      best->drain(); // implicit unlink and delete
+      continue;      // re-score the remaining sessions
+    }
+    auto txn = best->newTransaction(upstreamHandler);
+    best->unlink();
+    best->link();
+    if (txn) {
+      return txn;
+    }
+    // As in attemptOpenTransaction: if no transaction came back, link()
+    // moved the session to the full list, so re-score what remains
+  }
+  return nullptr;
+}
+
 // SessionHolder::Callback methods
 
 void SessionPool::detachIdle(SessionHolder* sess) {
@@ -236,6 +323,13 @@ void SessionPool::attachFilled(SessionHolder* sess) {
 void SessionPool::addDrainingSession(HTTPSessionBase* /*session*/) {
 }
 
+void SessionPool::onSessionRetired(SessionHolder* /*sess*/) {
+  if (sessionRetiredCallback_) {
+    // The retiring holder is still linked; don't count it as capacity.
+    sessionRetiredCallback_(getNumSessions() - 1);
+  }
+}
+
 std::ostream& operator<<(std::ostream& os, const SessionPool& pool) {
   os << "[idle=" << pool.getNumIdleSessions()
      << ", partial=" << pool.getNumActiveNonFullSessions()
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <folly/Function.h>
 #include <folly/io/async/EventBase.h>
 
 #include "proxygen/lib/http/connpool/SessionHolder.h"
@@ -151,6 +152,42 @@ class SessionPool : private SessionHolder::Callback {
    */
   HTTPTransaction* getTransaction(HTTPTransaction::Handler*);
 
+  /**
+   * Enable load-aware scheduling of new transactions across multiplexed
+   * (H2/H3) sessions.  Instead of filling the session at the front of
+   * 'unfilledSessionList_', getTransaction() scores the first few
+   * sessions in it by outstanding transactions relative to their
+   * advertised concurrency limit, weighted by the observed transport
+   * RTT, and opens the transaction on the least loaded one.
+   *
+   * concurrencyKnee, if nonzero, is the number of outstanding
+   * transactions past which a session is passed over in favor of an idle
+   * session; once no under-knee or idle session remains, over-knee
+   * sessions are still used rather than failing the request.
+   */
+  void setLoadAwareScheduling(bool enabled, uint32_t concurrencyKnee = 0);
+
+  bool getLoadAwareScheduling() const {
+    return loadAwareScheduling_;
+  }
+
+  /**
+   * Install a callback invoked when a pooled session is proactively
+   * retired because the server sent GOAWAY.  The pool unlinks and drains
+   * the session the moment the GOAWAY arrives, so new checkouts no
+   * longer race the closure; the callback fires at that point (before
+   * the draining session exhausts) so the owner can speculatively open a
+   * replacement connection and putSession() it.  Transactions the server
+   * never processed are errored with kErrorStreamUnacknowledged as
+   * before, which is the retry-safe signal.
+   *
+   * The argument is the remaining number of usable sessions in the pool,
+   * not counting the one being retired.
+   */
+  void setSessionRetiredCallback(folly::Function<void(uint32_t)> callback) {
+    sessionRetiredCallback_ = std::move(callback);
+  }
+
   /**
    * Remove oldest idle session from idleSessionList_.
    */
@@ -197,6 +234,15 @@ class SessionPool : private SessionHolder::Callback {
   HTTPTransaction* attemptOpenTransaction(
       HTTPTransaction::Handler* upstreamHandler, SessionList& list);
 
+  /**
+   * Load-aware counterpart of attemptOpenTransaction for the unfilled
+   * list: open the transaction on the session with the lowest load
+   * score, skipping sessions at or past the concurrency knee.  Returns
+   * nullptr if no session below the knee is available.
+   */
+  HTTPTransaction* attemptOpenTransactionLoadAware(
+      HTTPTransaction::Handler* upstreamHandler);
+
   // SessionHolder::Callback methods
   void detachIdle(SessionHolder*) override;
   void detachPartiallyFilled(SessionHolder*) override;
@@ -205,6 +251,7 @@ class SessionPool : private SessionHolder::Callback {
   void attachPartiallyFilled(SessionHolder*) override;
   void attachFilled(SessionHolder*) override;
   void addDrainingSession(HTTPSessionBase*) override;
+  void onSessionRetired(SessionHolder*) override;
 
   SessionHolder::Stats* stats_{nullptr};
   // Max number of connections stored in the pool.
@@ -224,6 +271,11 @@ class SessionPool : private SessionHolder::Callback {
   // List of active sessions are full and cannot open any more
   // transactions.
   SessionList fullSessionList_;
+  // See setSessionRetiredCallback().
+  folly::Function<void(uint32_t)> sessionRetiredCallback_;
+  // See setLoadAwareScheduling().
+  bool loadAwareScheduling_{false};
+  uint32_t concurrencyKnee_{0};
   // Manages idle sessions for the same thread across servers.
   ThreadIdleSessionController* threadIdleSessionController_{nullptr};
   // Manages idle sessions for the same server across threads.
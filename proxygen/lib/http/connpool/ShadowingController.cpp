@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "proxygen/lib/http/connpool/ShadowingController.h"
+
+#include <folly/Random.h>
+
+namespace proxygen {
+
+/**
+ * The fire-and-forget side of one shadow: owns nothing but the
+ * transaction, drains every ingress callback into the void and deletes
+ * itself when the transaction detaches.
+ */
+class ShadowingController::ShadowAttempt : public HTTPTransaction::Handler {
+ public:
+  explicit ShadowAttempt(ShadowingController& controller)
+      : controller_(controller) {
+    ++controller_.outstanding_;
+  }
+
+  ~ShadowAttempt() override {
+    --controller_.outstanding_;
+  }
+
+  void setTransaction(HTTPTransaction* txn) noexcept override {
+    txn_ = txn;
+  }
+  void detachTransaction() noexcept override {
+    delete this;
+  }
+  void onHeadersComplete(std::unique_ptr<HTTPMessage>) noexcept override {
+  }
+  void onBody(std::unique_ptr<folly::IOBuf>) noexcept override {
+  }
+  void onChunkHeader(size_t) noexcept override {
+  }
+  void onChunkComplete() noexcept override {
+  }
+  void onTrailers(std::unique_ptr<HTTPHeaders>) noexcept override {
+  }
+  void onEOM() noexcept override {
+  }
+  void onUpgrade(UpgradeProtocol) noexcept override {
+  }
+  void onError(const HTTPException&) noexcept override {
+    // Shadow failures are invisible by design; detachTransaction (or the
+    // absence of one, handled by sendShadow) does the cleanup.
+  }
+  void onEgressPaused() noexcept override {
+  }
+  void onEgressResumed() noexcept override {
+  }
+
+ private:
+  ShadowingController& controller_;
+  HTTPTransaction* txn_{nullptr};
+};
+
+ShadowingController::ShadowingController(SessionPool* pool, Budget budget)
+    : pool_(CHECK_NOTNULL(pool)),
+      budget_(std::move(budget)),
+      windowStart_(getCurrentTime()) {
+  CHECK_GE(budget_.samplePercent, 0.0);
+  CHECK_LE(budget_.samplePercent, 100.0);
+}
+
+ShadowingController::~ShadowingController() {
+  DCHECK_EQ(outstanding_, 0) << "destroyed with shadows in flight";
+}
+
+void ShadowingController::maybeRotateWindow() {
+  auto now = getCurrentTime();
+  if (millisecondsBetween(now, windowStart_) <
+      std::chrono::milliseconds(1000)) {
+    return;
+  }
+  windowStart_ = now;
+  windowCount_ = 0;
+  tenantWindowCounts_.clear();
+}
+
+bool ShadowingController::shouldShadow(const HTTPMessage& request) {
+  if (budget_.samplePercent <= 0.0 ||
+      (budget_.samplePercent < 100.0 &&
+       folly::Random::randDouble01() * 100.0 >= budget_.samplePercent)) {
+    ++droppedBudget_;
+    return false;
+  }
+  maybeRotateWindow();
+  if (budget_.maxShadowsPerSecond != 0 &&
+      windowCount_ >= budget_.maxShadowsPerSecond) {
+    ++droppedBudget_;
+    return false;
+  }
+  if (budget_.maxPerTenantPerSecond != 0 && !budget_.tenantHeader.empty()) {
+    auto& tenantCount = tenantWindowCounts_[request.getHeaders().getSingleOrEmpty(
+        budget_.tenantHeader)];
+    if (tenantCount >= budget_.maxPerTenantPerSecond) {
+      ++droppedBudget_;
+      return false;
+    }
+    ++tenantCount;
+  }
+  ++windowCount_;
+  return true;
+}
+
+bool ShadowingController::maybeShadow(const HTTPMessage& request,
+                                      std::unique_ptr<folly::IOBuf> body) {
+  if (!shouldShadow(request)) {
+    return false;
+  }
+  return sendShadow(request, std::move(body));
+}
+
+bool ShadowingController::sendShadow(const HTTPMessage& request,
+                                     std::unique_ptr<folly::IOBuf> body) {
+  auto attempt = new ShadowAttempt(*this);
+  auto txn = pool_->getTransaction(attempt);
+  if (txn == nullptr) {
+    ++droppedNoSession_;
+    delete attempt;
+    return false;
+  }
+  // The clone shares the original's header block until one side writes
+  HTTPMessage shadowRequest(request);
+  if (body) {
+    txn->sendHeaders(shadowRequest);
+    txn->sendBody(std::move(body));
+    txn->sendEOM();
+  } else {
+    txn->sendHeadersWithEOM(shadowRequest);
+  }
+  ++shadowsSent_;
+  return true;
+}
+
+} // namespace proxygen
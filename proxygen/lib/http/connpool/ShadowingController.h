@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+#include <proxygen/lib/utils/Time.h>
+
+#include "proxygen/lib/http/connpool/SessionPool.h"
+#include "proxygen/lib/http/session/HTTPTransaction.h"
+
+namespace proxygen {
+
+/**
+ * Mirrors a sampled subset of requests to a second upstream (typically a
+ * canary) as fire-and-forget copies.  The original request is untouched;
+ * the shadow is cloned from it — cheap, since HTTPMessage headers are
+ * copy-on-write — and sent on a transaction from the shadow pool whose
+ * response is drained and discarded by an internal handler without ever
+ * reaching application code.
+ *
+ * Sampling is budget-based.  A request is shadowed only if it passes the
+ * sample percentage, the global shadows-per-second cap, and the
+ * per-tenant cap (tenants are identified by a configurable request
+ * header).  Budget that is declined is simply not spent: shadowing never
+ * delays or fails the original request.
+ *
+ * One controller covers one route's shadow target, matching the
+ * one-pool-per-endpoint layout; routes with different targets or budgets
+ * get their own controller.  Like SessionPool, this class is
+ * single-threaded: all methods must be called on the pool's EventBase
+ * thread, and the controller must outlive any shadows in flight.
+ */
+class ShadowingController {
+ public:
+  struct Budget {
+    // Percentage of eligible requests to shadow, 0..100.
+    double samplePercent{100.0};
+    // Cap on shadows per second across all tenants; 0 means uncapped.
+    uint32_t maxShadowsPerSecond{0};
+    // Cap on shadows per second for any single tenant; 0 means uncapped.
+    uint32_t maxPerTenantPerSecond{0};
+    // Request header whose value names the tenant.  Empty disables the
+    // per-tenant cap; requests without the header share one bucket.
+    std::string tenantHeader;
+  };
+
+  ShadowingController(SessionPool* pool, Budget budget);
+
+  ~ShadowingController();
+
+  /**
+   * Decide whether this request should be shadowed, consuming budget if
+   * so.  Exposed separately from maybeShadow() for callers that need to
+   * capture the request body only when a shadow will actually be sent.
+   */
+  bool shouldShadow(const HTTPMessage& request);
+
+  /**
+   * Shadow the request if it passes the budget: clone it, send it on a
+   * transaction from the pool (headers, then the body if one is given,
+   * then EOM) and discard the response.  Returns true if a shadow was
+   * sent.  Returns false, refunding nothing, when the budget declines
+   * the request or the pool cannot supply a transaction.
+   */
+  bool maybeShadow(const HTTPMessage& request,
+                   std::unique_ptr<folly::IOBuf> body = nullptr);
+
+  /**
+   * Like maybeShadow(), but for callers that already consumed budget via
+   * shouldShadow().
+   */
+  bool sendShadow(const HTTPMessage& request,
+                  std::unique_ptr<folly::IOBuf> body = nullptr);
+
+  uint64_t getShadowsSent() const {
+    return shadowsSent_;
+  }
+  uint64_t getShadowsDroppedByBudget() const {
+    return droppedBudget_;
+  }
+  uint64_t getShadowsDroppedNoSession() const {
+    return droppedNoSession_;
+  }
+
+ private:
+  class ShadowAttempt;
+  friend class ShadowAttempt;
+
+  // Roll the 1-second accounting window forward if it has elapsed.
+  void maybeRotateWindow();
+
+  SessionPool* const pool_;
+  const Budget budget_;
+
+  // Fixed 1-second windows; the per-tenant counts are cleared on
+  // rotation, so the map never outgrows one window's worth of tenants.
+  TimePoint windowStart_;
+  uint32_t windowCount_{0};
+  std::unordered_map<std::string, uint32_t> tenantWindowCounts_;
+
+  uint64_t shadowsSent_{0};
+  uint64_t droppedBudget_{0};
+  uint64_t droppedNoSession_{0};
+  // Shadows in flight; must be zero when the controller is destroyed.
+  uint64_t outstanding_{0};
+};
+
+} // namespace proxygen
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "proxygen/lib/http/connpool/WarmPoolController.h"
+
+#include <cmath>
+#include <folly/Random.h>
+
+#include "proxygen/lib/http/connpool/ServerIdleSessionController.h"
+#include "proxygen/lib/http/session/HTTPSessionBase.h"
+
+namespace proxygen {
+
+WarmPoolController::WarmPoolController(
+    folly::EventBase* evb,
+    Connector* connector,
+    std::chrono::milliseconds evaluationInterval,
+    std::chrono::milliseconds connectCoverWindow,
+    uint32_t maxWarmSessionsPerEndpoint,
+    ServerIdleSessionController* serverIdleSessionController)
+    : folly::AsyncTimeout(evb),
+      evb_(evb),
+      connector_(connector),
+      evaluationInterval_(evaluationInterval),
+      connectCoverWindow_(connectCoverWindow),
+      maxWarmSessions_(maxWarmSessionsPerEndpoint),
+      serverIdleSessionController_(serverIdleSessionController) {
+  CHECK(connector_);
+  CHECK_GT(evaluationInterval_.count(), 0);
+}
+
+WarmPoolController::~WarmPoolController() {
+  cancelTimeout();
+}
+
+void WarmPoolController::trackEndpoint(const Endpoint& endpoint,
+                                       SessionPool* pool) {
+  CHECK(pool);
+  endpoints_[endpoint].pool = pool;
+}
+
+void WarmPoolController::untrackEndpoint(const Endpoint& endpoint) {
+  endpoints_.erase(endpoint);
+}
+
+void WarmPoolController::recordRequest(const Endpoint& endpoint) {
+  auto it = endpoints_.find(endpoint);
+  if (it != endpoints_.end()) {
+    it->second.arrivalsSinceTick++;
+  }
+}
+
+void WarmPoolController::onConnectOutcome(const Endpoint& endpoint,
+                                          bool /*success*/) {
+  auto it = endpoints_.find(endpoint);
+  if (it != endpoints_.end() && it->second.pendingConnects > 0) {
+    it->second.pendingConnects--;
+  }
+}
+
+uint32_t WarmPoolController::getTargetIdleSessions(
+    const Endpoint& endpoint) const {
+  auto it = endpoints_.find(endpoint);
+  return it != endpoints_.end() ? it->second.target : 0;
+}
+
+void WarmPoolController::start() {
+  scheduleNextEvaluation();
+}
+
+void WarmPoolController::stop() {
+  cancelTimeout();
+}
+
+void WarmPoolController::timeoutExpired() noexcept {
+  evaluate();
+  scheduleNextEvaluation();
+}
+
+void WarmPoolController::scheduleNextEvaluation() {
+  // Jitter each tick by up to a quarter interval so synchronized fleets
+  // do not evaluate (and dial) in lockstep
+  auto jitter =
+      folly::Random::rand32(uint32_t(evaluationInterval_.count() / 4 + 1));
+  scheduleTimeout(evaluationInterval_ + std::chrono::milliseconds(jitter));
+}
+
+void WarmPoolController::evaluate() {
+  for (auto& entry : endpoints_) {
+    evaluateEndpoint(entry.first, entry.second);
+  }
+}
+
+void WarmPoolController::evaluateEndpoint(const Endpoint& endpoint,
+                                          EndpointState& state) {
+  const double intervalSeconds = evaluationInterval_.count() / 1000.0;
+  const double instantRate = state.arrivalsSinceTick / intervalSeconds;
+  state.arrivalsSinceTick = 0;
+  state.ratePerSecond = kRateSmoothing * instantRate +
+                        (1 - kRateSmoothing) * state.ratePerSecond;
+  if (state.ratePerSecond < 1e-3) {
+    // Fully decayed; without this an idle endpoint would keep one warm
+    // session forever through the ceil below
+    state.ratePerSecond = 0;
+  }
+
+  // Enough idle sessions to absorb the arrivals expected during one
+  // cold-connect window
+  const double coverSeconds = connectCoverWindow_.count() / 1000.0;
+  state.target = std::min(
+      maxWarmSessions_,
+      uint32_t(std::ceil(state.ratePerSecond * coverSeconds)));
+
+  const uint64_t have =
+      state.pool->getNumIdleSessions() + state.pendingConnects;
+  if (have >= state.target) {
+    return;
+  }
+  auto deficit = std::min(uint64_t(kMaxEstablishPerEvaluation),
+                          uint64_t(state.target) - have);
+  VLOG(4) << "warm pool deficit=" << deficit
+          << " target=" << state.target << " rate=" << state.ratePerSecond
+          << " for " << endpoint.getHostname() << ":" << endpoint.getPort();
+  for (uint64_t i = 0; i < deficit; i++) {
+    state.pendingConnects++;
+    claimOrConnect(endpoint);
+  }
+}
+
+void WarmPoolController::claimOrConnect(const Endpoint& endpoint) {
+  if (!serverIdleSessionController_) {
+    connector_->connectTo(endpoint);
+    return;
+  }
+  // Prefer moving an idle session from another worker over dialing
+  std::weak_ptr<char> alive = alive_;
+  serverIdleSessionController_->getIdleSession()
+      .via(evb_)
+      .thenValue([this, alive, endpoint](HTTPSessionBase* session) {
+        if (alive.expired()) {
+          if (session) {
+            session->dropConnection();
+          }
+          return;
+        }
+        if (endpoints_.find(endpoint) == endpoints_.end()) {
+          // Untracked while the claim was in flight
+          if (session) {
+            session->dropConnection();
+          }
+          return;
+        }
+        if (session) {
+          connector_->adoptIdleSession(endpoint, session);
+        } else {
+          connector_->connectTo(endpoint);
+        }
+      });
+}
+
+} // namespace proxygen
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <folly/io/async/AsyncTimeout.h>
+#include <folly/io/async/EventBase.h>
+#include <unordered_map>
+
+#include "proxygen/lib/http/connpool/Endpoint.h"
+#include "proxygen/lib/http/connpool/SessionPool.h"
+
+namespace proxygen {
+
+class ServerIdleSessionController;
+
+/**
+ * Maintains a warm level of idle upstream sessions per Endpoint so the
+ * first request to a cold endpoint does not pay the full connect+TLS
+ * handshake.  The target idle level is predictive: an EWMA of the
+ * request arrival rate, sized to cover the arrivals expected during one
+ * cold-connect window.
+ *
+ * The controller only decides *when* a session should be established;
+ * the owner's Connector actually dials (it has the codec factory, TLS
+ * contexts and fizz state the pool layer knows nothing about) and puts
+ * the resulting session into the endpoint's SessionPool as usual.
+ * Before dialing, an idle session is claimed from another worker via
+ * ServerIdleSessionController when one is available, so warm capacity is
+ * shared across threads instead of duplicated.
+ *
+ * Evaluation runs on a jittered timer and establishes at most a couple
+ * of sessions per endpoint per tick, so a fleet restarting in sync ramps
+ * its warm pools gradually instead of stampeding the upstream.
+ *
+ * Like SessionPool, this class is single-threaded: all methods must be
+ * called on the controller's EventBase thread.
+ */
+class WarmPoolController : private folly::AsyncTimeout {
+ public:
+  class Connector {
+   public:
+    virtual ~Connector() = default;
+
+    /**
+     * Establish a new session to the endpoint.  When the connect
+     * resolves, put the session into the endpoint's SessionPool and call
+     * onConnectOutcome(endpoint, true), or onConnectOutcome(endpoint,
+     * false) on failure.
+     */
+    virtual void connectTo(const Endpoint& endpoint) noexcept = 0;
+
+    /**
+     * Adopt an idle session claimed from another worker.  Its thread
+     * locals are already detached; reattach them to this thread, put it
+     * in the endpoint's SessionPool and call onConnectOutcome(endpoint,
+     * true).
+     */
+    virtual void adoptIdleSession(const Endpoint& endpoint,
+                                  HTTPSessionBase* session) noexcept = 0;
+  };
+
+  WarmPoolController(folly::EventBase* evb,
+                     Connector* connector,
+                     std::chrono::milliseconds evaluationInterval =
+                         std::chrono::milliseconds(1000),
+                     std::chrono::milliseconds connectCoverWindow =
+                         std::chrono::milliseconds(100),
+                     uint32_t maxWarmSessionsPerEndpoint = 8,
+                     ServerIdleSessionController* serverIdleSessionController =
+                         nullptr);
+  ~WarmPoolController() override;
+
+  /**
+   * Register the pool holding sessions for this endpoint.  The pool must
+   * outlive the registration.
+   */
+  void trackEndpoint(const Endpoint& endpoint, SessionPool* pool);
+  void untrackEndpoint(const Endpoint& endpoint);
+
+  /**
+   * Record a request arrival for the endpoint; drives the EWMA used for
+   * target sizing.
+   */
+  void recordRequest(const Endpoint& endpoint);
+
+  /**
+   * Called by the Connector when an establishment or adoption finishes,
+   * successfully or not.
+   */
+  void onConnectOutcome(const Endpoint& endpoint, bool success);
+
+  /**
+   * The current target idle-session level (0 for unknown endpoints).
+   */
+  uint32_t getTargetIdleSessions(const Endpoint& endpoint) const;
+
+  /**
+   * Start/stop the periodic evaluation timer.
+   */
+  void start();
+  void stop();
+
+  /**
+   * Run one evaluation pass immediately.  Normally driven by the
+   * internal jittered timer; exposed so owners (and tests) can tick
+   * manually.
+   */
+  void evaluate();
+
+ private:
+  struct EndpointState {
+    SessionPool* pool{nullptr};
+    // Smoothed arrivals per second
+    double ratePerSecond{0};
+    uint64_t arrivalsSinceTick{0};
+    uint32_t target{0};
+    uint32_t pendingConnects{0};
+  };
+
+  void timeoutExpired() noexcept override;
+  void scheduleNextEvaluation();
+  void evaluateEndpoint(const Endpoint& endpoint, EndpointState& state);
+  void claimOrConnect(const Endpoint& endpoint);
+
+  // EWMA smoothing factor for the arrival rate
+  static constexpr double kRateSmoothing = 0.3;
+  // Establish at most this many sessions per endpoint per evaluation;
+  // ramping over several ticks is part of the herd avoidance
+  static constexpr uint32_t kMaxEstablishPerEvaluation = 2;
+
+  folly::EventBase* const evb_;
+  Connector* const connector_;
+  const std::chrono::milliseconds evaluationInterval_;
+  const std::chrono::milliseconds connectCoverWindow_;
+  const uint32_t maxWarmSessions_;
+  ServerIdleSessionController* const serverIdleSessionController_;
+
+  std::unordered_map<Endpoint, EndpointState, EndpointHash, EndpointEqual>
+      endpoints_;
+
+  // Expired weak copies tell in-flight idle-session claims that the
+  // controller is gone
+  std::shared_ptr<char> alive_{std::make_shared<char>()};
+};
+
+} // namespace proxygen
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "proxygen/lib/http/connpool/ConnectTunnelPool.h"
+
+#include <folly/io/async/HHWheelTimer.h>
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/http/codec/test/MockHTTPCodec.h>
+#include <proxygen/lib/http/session/HTTPUpstreamSession.h>
+#include <proxygen/lib/test/TestAsyncTransport.h>
+#include <proxygen/lib/utils/Time.h>
+
+using namespace proxygen;
+using namespace std;
+using namespace testing;
+
+// SessionPoolTestFixture.h defines non-inline helpers, so this file
+// carries its own minimal fixture for driving outer gateway sessions.
+class ConnectTunnelPoolFixture
+    : public testing::Test
+    , public HTTPTransactionHandler {
+ protected:
+  /**
+   * An outer gateway session whose codec records the headers it is
+   * asked to generate and exposes the codec callback, so tests can feed
+   * the gateway's CONNECT response back in.
+   */
+  HTTPUpstreamSession* makeOuterSession(HTTPCodec::Callback*& cb) {
+    auto codec = std::make_unique<NiceMock<MockHTTPCodec>>();
+    EXPECT_CALL(*codec, getTransportDirection())
+        .WillRepeatedly(Return(TransportDirection::UPSTREAM));
+    EXPECT_CALL(*codec, createStream()).WillRepeatedly(InvokeWithoutArgs([&] {
+      return nextStreamId_ += 2;
+    }));
+    EXPECT_CALL(*codec, isReusable()).WillRepeatedly(Return(true));
+    EXPECT_CALL(*codec, supportsParallelRequests())
+        .WillRepeatedly(Return(true));
+    EXPECT_CALL(*codec, getProtocol())
+        .WillRepeatedly(Return(CodecProtocol::HTTP_2));
+    EXPECT_CALL(*codec, generateRstStream(_, _, _)).WillRepeatedly(Return(1));
+    EXPECT_CALL(*codec, setCallback(_)).WillRepeatedly(SaveArg<0>(&cb));
+    EXPECT_CALL(*codec, generateHeader(_, _, _, _, _, _))
+        .WillRepeatedly(Invoke([this](folly::IOBufQueue&,
+                                      HTTPCodec::StreamID stream,
+                                      const HTTPMessage& msg,
+                                      bool,
+                                      HTTPHeaderSize*,
+                                      const folly::Optional<HTTPHeaders>&) {
+          sentStreams_.push_back(stream);
+          sentMessages_.push_back(msg);
+        }));
+
+    auto sock = folly::AsyncTransport::UniquePtr(new TestAsyncTransport(&evb_));
+    wangle::TransportInfo tinfo;
+    tinfo.acceptTime = getCurrentTime();
+    return new HTTPUpstreamSession(timeouts_.get(),
+                                   std::move(sock),
+                                   local_,
+                                   peer_,
+                                   std::move(codec),
+                                   tinfo,
+                                   nullptr);
+  }
+
+  void establishTunnel(HTTPCodec::Callback* cb, HTTPCodec::StreamID stream) {
+    auto resp = std::make_unique<HTTPMessage>();
+    resp->setStatusCode(200);
+    cb->onMessageBegin(stream, resp.get());
+    cb->onHeadersComplete(stream, std::move(resp));
+  }
+
+  // HTTPTransactionHandler; tests only need a warm body
+  void setTransaction(HTTPTransaction* /*txn*/) noexcept override {
+  }
+  void detachTransaction() noexcept override {
+  }
+  void onHeadersComplete(
+      std::unique_ptr<HTTPMessage> /*msg*/) noexcept override {
+  }
+  void onBody(std::unique_ptr<folly::IOBuf> /*chain*/) noexcept override {
+  }
+  void onChunkHeader(size_t /*length*/) noexcept override {
+  }
+  void onChunkComplete() noexcept override {
+  }
+  void onTrailers(std::unique_ptr<HTTPHeaders> /*trailers*/) noexcept override {
+  }
+  void onEOM() noexcept override {
+  }
+  void onUpgrade(UpgradeProtocol /*protocol*/) noexcept override {
+  }
+  void onError(const HTTPException& /*error*/) noexcept override {
+  }
+  void onEgressPaused() noexcept override {
+  }
+  void onEgressResumed() noexcept override {
+  }
+
+  folly::EventBase evb_;
+  folly::HHWheelTimer::UniquePtr timeouts_{folly::HHWheelTimer::newTimer(
+      &evb_,
+      std::chrono::milliseconds(folly::HHWheelTimer::DEFAULT_TICK_INTERVAL),
+      folly::TimeoutManager::InternalEnum::INTERNAL,
+      std::chrono::milliseconds(100))};
+  folly::SocketAddress local_{"127.0.0.1", 80};
+  folly::SocketAddress peer_{"127.0.0.1", 12345};
+  HTTPCodec::StreamID nextStreamId_{1};
+  std::vector<HTTPCodec::StreamID> sentStreams_;
+  std::vector<HTTPMessage> sentMessages_;
+};
+
+TEST_F(ConnectTunnelPoolFixture, EstablishAndVend) {
+  ConnectTunnelPool pool(&evb_, timeouts_.get());
+  HTTPCodec::Callback* cb = nullptr;
+  auto* outer = makeOuterSession(cb);
+
+  auto* connectTxn = outer->newTransaction(this);
+  pool.addTunnel(connectTxn, "gateway.example.com:443");
+
+  // the pool sent the CONNECT itself
+  ASSERT_EQ(sentMessages_.size(), 1);
+  EXPECT_EQ(sentMessages_[0].getMethod(), HTTPMethod::CONNECT);
+  EXPECT_EQ(pool.getNumTunnels(), 1);
+
+  // not established yet: nothing to vend
+  EXPECT_EQ(pool.getNumEstablishedTunnels(), 0);
+  EXPECT_EQ(pool.getTransaction(this), nullptr);
+
+  // gateway answers 2xx; the inner H2 session comes up over the tunnel
+  establishTunnel(cb, sentStreams_[0]);
+  EXPECT_EQ(pool.getNumEstablishedTunnels(), 1);
+
+  auto* innerTxn = pool.getTransaction(this);
+  ASSERT_TRUE(innerTxn != nullptr);
+  innerTxn->sendAbort();
+
+  pool.drainAllTunnels();
+  outer->dropConnection();
+  evb_.loop();
+}
+
+TEST_F(ConnectTunnelPoolFixture, BalancesAcrossTunnels) {
+  ConnectTunnelPool pool(&evb_, timeouts_.get());
+  HTTPCodec::Callback* cb1 = nullptr;
+  HTTPCodec::Callback* cb2 = nullptr;
+  auto* outer1 = makeOuterSession(cb1);
+  auto* outer2 = makeOuterSession(cb2);
+
+  pool.addTunnel(outer1->newTransaction(this), "gateway.example.com:443");
+  pool.addTunnel(outer2->newTransaction(this), "gateway.example.com:443");
+  ASSERT_EQ(sentStreams_.size(), 2);
+  establishTunnel(cb1, sentStreams_[0]);
+  establishTunnel(cb2, sentStreams_[1]);
+  EXPECT_EQ(pool.getNumEstablishedTunnels(), 2);
+
+  // with one inner transaction outstanding, the next checkout lands on
+  // the other (less loaded) tunnel
+  auto* innerTxn1 = pool.getTransaction(this);
+  ASSERT_TRUE(innerTxn1 != nullptr);
+  auto* innerTxn2 = pool.getTransaction(this);
+  ASSERT_TRUE(innerTxn2 != nullptr);
+  EXPECT_NE(&innerTxn1->getTransport(), &innerTxn2->getTransport());
+
+  innerTxn1->sendAbort();
+  innerTxn2->sendAbort();
+  outer1->dropConnection();
+  outer2->dropConnection();
+  evb_.loop();
+}
+
+TEST_F(ConnectTunnelPoolFixture, RefusedTunnelDiscarded) {
+  ConnectTunnelPool pool(&evb_, timeouts_.get());
+  HTTPCodec::Callback* cb = nullptr;
+  auto* outer = makeOuterSession(cb);
+
+  pool.addTunnel(outer->newTransaction(this), "gateway.example.com:443");
+  ASSERT_EQ(sentStreams_.size(), 1);
+
+  auto resp = std::make_unique<HTTPMessage>();
+  resp->setStatusCode(503);
+  cb->onMessageBegin(sentStreams_[0], resp.get());
+  cb->onHeadersComplete(sentStreams_[0], std::move(resp));
+  evb_.loopOnce();
+
+  // the refused tunnel aborted its stream and left the pool
+  EXPECT_EQ(pool.getNumTunnels(), 0);
+  EXPECT_EQ(pool.getTransaction(this), nullptr);
+
+  outer->dropConnection();
+  evb_.loop();
+}
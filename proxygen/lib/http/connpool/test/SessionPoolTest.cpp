@@ -8,6 +8,7 @@
 
 #include "proxygen/lib/http/connpool/test/SessionPoolTestFixture.h"
 
+#include "proxygen/lib/http/connpool/HedgingController.h"
 #include "proxygen/lib/http/connpool/ServerIdleSessionController.h"
 #include "proxygen/lib/http/connpool/SessionHolder.h"
 #include "proxygen/lib/http/connpool/SessionPool.h"
@@ -39,6 +40,41 @@ TEST_F(SessionPoolFixture, ParallelPoolChangedMaxSessions) {
   evb_.loop();
 }
 
+TEST_F(SessionPoolFixture, ParallelPoolGoawayRetirement) {
+  SessionPool p(this, 2);
+  uint32_t retiredCallbacks = 0;
+  uint32_t remainingAtRetire = 0;
+  p.setSessionRetiredCallback([&](uint32_t remaining) {
+    ++retiredCallbacks;
+    remainingAtRetire = remaining;
+  });
+
+  HTTPCodec::Callback* cb = nullptr;
+  auto codec = makeParallelCodec();
+  EXPECT_CALL(*codec, setCallback(_)).WillRepeatedly(SaveArg<0>(&cb));
+  p.putSession(makeSession(std::move(codec)));
+  p.putSession(makeParallelSession());
+  EXPECT_EQ(p.getNumSessions(), 2);
+
+  // GOAWAY retires the session from the pool immediately: no new
+  // checkout can land on it, and the owner learns how much capacity
+  // remains so it can pre-replace the connection.
+  cb->onGoaway(0, ErrorCode::NO_ERROR);
+  EXPECT_EQ(retiredCallbacks, 1);
+  EXPECT_EQ(remainingAtRetire, 1);
+  EXPECT_EQ(p.getNumSessions(), 1);
+
+  // The next checkout lands on the remaining session, not the draining
+  // one.
+  auto txn = p.getTransaction(this);
+  ASSERT_TRUE(txn != nullptr);
+  txn->sendAbort();
+
+  // Clear the pool
+  p.setMaxIdleSessions(0);
+  evb_.loop();
+}
+
 TEST_F(SessionPoolFixture, SerialPoolBasic) {
   SessionPool p(this, 1);
   p.putSession(makeSerialSession());
@@ -230,6 +266,38 @@ TEST_F(SessionPoolFixture, ParallelPoolLists) {
   evb_.loop();
 }
 
+TEST_F(SessionPoolFixture, LoadAwareScheduling) {
+  // With load-aware scheduling, new transactions spread across
+  // multiplexed sessions at the concurrency knee instead of filling the
+  // first session to its advertised limit
+  SessionPool p(this, 2);
+  p.setLoadAwareScheduling(true, 2 /* concurrencyKnee */);
+
+  auto sess1 = makeParallelSession();
+  auto sess2 = makeParallelSession();
+  p.putSession(sess1);
+  p.putSession(sess2);
+
+  std::vector<HTTPTransaction*> txns;
+  for (int i = 0; i < 4; i++) {
+    txns.push_back(CHECK_NOTNULL(p.getTransaction(this)));
+  }
+  // Both sessions should sit at the knee, neither past it
+  EXPECT_EQ(sess1->getNumOutgoingStreams(), 2);
+  EXPECT_EQ(sess2->getNumOutgoingStreams(), 2);
+  ASSERT_EQ(activated_, 2);
+
+  // Past the knee with no idle session left, the pool still hands out a
+  // transaction rather than failing
+  txns.push_back(CHECK_NOTNULL(p.getTransaction(this)));
+  EXPECT_EQ(sess1->getNumOutgoingStreams() + sess2->getNumOutgoingStreams(), 5);
+
+  for (auto& txn : txns) {
+    txn->sendAbort();
+  }
+  evb_.loop();
+}
+
 TEST_F(SessionPoolFixture, OutstandingWrites) {
   auto codec = makeSerialCodec();
   EXPECT_CALL(*codec, generateHeader(_, _, _, _, _, _))
@@ -493,10 +561,13 @@ TEST_F(SessionPoolFixture, DrainOnShutdown) {
 
 class TestIdleController : public ServerIdleSessionController {
  public:
-  // expose this method as public for tests.
+  // expose these methods as public for tests.
   SessionPool* popBestIdlePool() {
     return ServerIdleSessionController::popBestIdlePool();
   }
+  SessionPool* claimIdlePoolHint() {
+    return ServerIdleSessionController::claimIdlePoolHint();
+  }
 };
 
 TEST_F(SessionPoolFixture, MoveIdleSessionBetweenThreadsTest) {
@@ -598,6 +669,31 @@ TEST_F(SessionPoolFixture, ServerIdleSessionControllerTest) {
   s3->drain();
 }
 
+TEST_F(SessionPoolFixture, IdlePoolHintClaim) {
+  TestIdleController ctrl;
+  SessionPool p1, p2;
+  auto s1 = makeParallelSession(), s2 = makeParallelSession();
+
+  EXPECT_EQ(ctrl.claimIdlePoolHint(), nullptr);
+
+  ctrl.addIdleSession(s1, &p1);
+  ctrl.addIdleSession(s2, &p2);
+  // claims are one-shot and do not touch the locked list
+  EXPECT_EQ(ctrl.claimIdlePoolHint(), &p1);
+  EXPECT_EQ(ctrl.claimIdlePoolHint(), &p2);
+  EXPECT_EQ(ctrl.claimIdlePoolHint(), nullptr);
+  EXPECT_EQ(ctrl.popBestIdlePool(), &p1);
+  EXPECT_EQ(ctrl.popBestIdlePool(), &p2);
+
+  // removing a pool's last idle session drops its hint too
+  ctrl.addIdleSession(s1, &p1);
+  ctrl.removeIdleSession(s1);
+  EXPECT_EQ(ctrl.claimIdlePoolHint(), nullptr);
+
+  s1->drain();
+  s2->drain();
+}
+
 TEST_F(SessionPoolFixture, WritePausedSessionNotMarkedAsIdle) {
   auto codec = makeParallelCodec();
   EXPECT_CALL(*codec, generateHeader(_, _, _, _, _, _))
@@ -716,6 +812,148 @@ TEST_F(SessionPoolFixture, ThreadIdleSessionControllerTrackSessionPoolChanges) {
   EXPECT_EQ(p2.getNumIdleSessions(), 1);
 }
 
+namespace {
+
+HTTPMessage makeHedgeableGet() {
+  HTTPMessage req;
+  req.setMethod(HTTPMethod::GET);
+  req.setURL("/read");
+  return req;
+}
+
+// Records everything the hedging controller forwards to us
+class RecordingHandler : public HTTPTransaction::Handler {
+ public:
+  void setTransaction(HTTPTransaction* txn) noexcept override {
+    txn_ = txn;
+  }
+  void detachTransaction() noexcept override {
+    detached_ = true;
+  }
+  void onHeadersComplete(std::unique_ptr<HTTPMessage> msg) noexcept override {
+    response_ = std::move(msg);
+  }
+  void onBody(std::unique_ptr<folly::IOBuf> /*chain*/) noexcept override {
+  }
+  void onChunkHeader(size_t /*length*/) noexcept override {
+  }
+  void onChunkComplete() noexcept override {
+  }
+  void onTrailers(std::unique_ptr<HTTPHeaders> /*trailers*/) noexcept override {
+  }
+  void onEOM() noexcept override {
+    eom_ = true;
+  }
+  void onUpgrade(UpgradeProtocol /*protocol*/) noexcept override {
+  }
+  void onError(const HTTPException& /*error*/) noexcept override {
+    errors_++;
+  }
+  void onEgressPaused() noexcept override {
+  }
+  void onEgressResumed() noexcept override {
+  }
+
+  HTTPTransaction* txn_{nullptr};
+  std::unique_ptr<HTTPMessage> response_;
+  bool eom_{false};
+  bool detached_{false};
+  uint32_t errors_{0};
+};
+
+} // namespace
+
+TEST_F(SessionPoolFixture, HedgingIsHedgeable) {
+  EXPECT_TRUE(HedgingController::isHedgeable(makeHedgeableGet()));
+
+  HTTPMessage post;
+  post.setMethod(HTTPMethod::POST);
+  EXPECT_FALSE(HedgingController::isHedgeable(post));
+}
+
+TEST_F(SessionPoolFixture, HedgingDelayAutoTunes) {
+  SessionPool p(this, 1);
+  HedgingController controller(&p,
+                               0.95,
+                               std::chrono::milliseconds(2),
+                               std::chrono::milliseconds(250));
+
+  // Cold controller hedges at the conservative maximum
+  EXPECT_EQ(controller.getHedgeDelay(), std::chrono::milliseconds(250));
+
+  for (uint32_t i = 0; i < 100; i++) {
+    controller.recordLatency(std::chrono::milliseconds(20));
+  }
+  // 20ms lands in the [16, 32) bucket; the delay is its upper bound
+  EXPECT_EQ(controller.getHedgeDelay(), std::chrono::milliseconds(32));
+
+  // A slower tail pulls the p95 delay up to the slow bucket
+  for (uint32_t i = 0; i < 100; i++) {
+    controller.recordLatency(std::chrono::milliseconds(100));
+  }
+  EXPECT_EQ(controller.getHedgeDelay(), std::chrono::milliseconds(128));
+}
+
+TEST_F(SessionPoolFixture, HedgingNoSessionFails) {
+  SessionPool p(this, 1);
+  HedgingController controller(&p);
+  RecordingHandler handler;
+
+  EXPECT_FALSE(controller.sendRequest(&handler, makeHedgeableGet()));
+  EXPECT_EQ(handler.errors_, 0);
+  EXPECT_FALSE(handler.detached_);
+}
+
+TEST_F(SessionPoolFixture, HedgingHedgeWinsRace) {
+  SessionPool p(this, 1);
+  HTTPCodec::Callback* cb = nullptr;
+  auto codec = makeParallelCodec();
+  EXPECT_CALL(*codec, setCallback(_)).WillRepeatedly(SaveArg<0>(&cb));
+  std::vector<HTTPCodec::StreamID> sentStreams;
+  EXPECT_CALL(*codec, generateHeader(_, _, _, _, _, _))
+      .WillRepeatedly(
+          Invoke([&sentStreams](folly::IOBufQueue&,
+                                HTTPCodec::StreamID stream,
+                                const HTTPMessage&,
+                                bool,
+                                HTTPHeaderSize*,
+                                const folly::Optional<HTTPHeaders>&) {
+            sentStreams.push_back(stream);
+          }));
+  p.putSession(makeSession(std::move(codec)));
+
+  // Zero max delay: the hedge fires on the next loop
+  HedgingController controller(&p,
+                               0.95,
+                               std::chrono::milliseconds(0),
+                               std::chrono::milliseconds(0));
+  RecordingHandler handler;
+  ASSERT_TRUE(controller.sendRequest(&handler, makeHedgeableGet()));
+  ASSERT_EQ(sentStreams.size(), 1);
+
+  evb_.loopOnce();
+  ASSERT_EQ(sentStreams.size(), 2);
+  EXPECT_EQ(controller.getHedgesLaunched(), 1);
+
+  // The hedge's response comes back first; the primary gets aborted
+  auto resp = std::make_unique<HTTPMessage>();
+  resp->setStatusCode(200);
+  cb->onMessageBegin(sentStreams[1], resp.get());
+  cb->onHeadersComplete(sentStreams[1], std::move(resp));
+  cb->onMessageComplete(sentStreams[1], false);
+
+  ASSERT_TRUE(handler.response_ != nullptr);
+  EXPECT_EQ(handler.response_->getStatusCode(), 200);
+  EXPECT_TRUE(handler.eom_);
+  EXPECT_TRUE(handler.detached_);
+  EXPECT_EQ(handler.errors_, 0);
+  EXPECT_EQ(controller.getHedgesWon(), 1);
+
+  // Clear the pool
+  p.setMaxIdleSessions(0);
+  evb_.loop();
+}
+
 // So we can have -v work
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "proxygen/lib/http/connpool/ShadowingController.h"
+
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventBaseManager.h>
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+
+namespace {
+
+class ShadowingControllerTest : public testing::Test {
+ public:
+  void SetUp() override {
+    folly::EventBaseManager::get()->setEventBase(&evb_, false);
+  }
+
+  static HTTPMessage makeRequest(const std::string& tenant = "") {
+    HTTPMessage req;
+    req.setMethod("GET");
+    req.setURL("/resource");
+    if (!tenant.empty()) {
+      req.getHeaders().set("X-Tenant", tenant);
+    }
+    return req;
+  }
+
+ protected:
+  folly::EventBase evb_;
+};
+
+} // namespace
+
+TEST_F(ShadowingControllerTest, GlobalRateCap) {
+  SessionPool pool(nullptr, 1);
+  ShadowingController::Budget budget;
+  budget.maxShadowsPerSecond = 2;
+  ShadowingController controller(&pool, budget);
+
+  auto req = makeRequest();
+  EXPECT_TRUE(controller.shouldShadow(req));
+  EXPECT_TRUE(controller.shouldShadow(req));
+  EXPECT_FALSE(controller.shouldShadow(req));
+  EXPECT_EQ(controller.getShadowsDroppedByBudget(), 1);
+}
+
+TEST_F(ShadowingControllerTest, PerTenantCap) {
+  SessionPool pool(nullptr, 1);
+  ShadowingController::Budget budget;
+  budget.maxPerTenantPerSecond = 1;
+  budget.tenantHeader = "X-Tenant";
+  ShadowingController controller(&pool, budget);
+
+  auto tenantA = makeRequest("a");
+  auto tenantB = makeRequest("b");
+  EXPECT_TRUE(controller.shouldShadow(tenantA));
+  // Tenant a is out of budget for this window, but b still has its own
+  EXPECT_FALSE(controller.shouldShadow(tenantA));
+  EXPECT_TRUE(controller.shouldShadow(tenantB));
+  EXPECT_EQ(controller.getShadowsDroppedByBudget(), 1);
+}
+
+TEST_F(ShadowingControllerTest, ZeroPercentShadowsNothing) {
+  SessionPool pool(nullptr, 1);
+  ShadowingController::Budget budget;
+  budget.samplePercent = 0.0;
+  ShadowingController controller(&pool, budget);
+
+  auto req = makeRequest();
+  EXPECT_FALSE(controller.maybeShadow(req));
+  EXPECT_EQ(controller.getShadowsSent(), 0);
+  EXPECT_EQ(controller.getShadowsDroppedByBudget(), 1);
+}
+
+TEST_F(ShadowingControllerTest, EmptyPoolDropsWithoutSideEffects) {
+  SessionPool pool(nullptr, 1);
+  ShadowingController controller(&pool, ShadowingController::Budget());
+
+  auto req = makeRequest();
+  EXPECT_FALSE(controller.maybeShadow(req));
+  EXPECT_EQ(controller.getShadowsSent(), 0);
+  EXPECT_EQ(controller.getShadowsDroppedNoSession(), 1);
+}
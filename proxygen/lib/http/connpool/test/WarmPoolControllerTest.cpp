@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "proxygen/lib/http/connpool/WarmPoolController.h"
+
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/EventBaseManager.h>
+#include <folly/portability/GTest.h>
+#include <map>
+
+using namespace proxygen;
+
+namespace {
+
+class CountingConnector : public WarmPoolController::Connector {
+ public:
+  void connectTo(const Endpoint& endpoint) noexcept override {
+    connects[endpoint.getHostname()]++;
+  }
+  void adoptIdleSession(const Endpoint& endpoint,
+                        HTTPSessionBase* /*session*/) noexcept override {
+    adoptions[endpoint.getHostname()]++;
+  }
+
+  std::map<std::string, uint32_t> connects;
+  std::map<std::string, uint32_t> adoptions;
+};
+
+class WarmPoolControllerTest : public testing::Test {
+ public:
+  void SetUp() override {
+    folly::EventBaseManager::get()->setEventBase(&evb_, false);
+  }
+
+ protected:
+  folly::EventBase evb_;
+  CountingConnector connector_;
+};
+
+} // namespace
+
+TEST_F(WarmPoolControllerTest, TargetTracksArrivalRateAndRampsCapped) {
+  SessionPool pool(nullptr, 8);
+  WarmPoolController controller(&evb_,
+                                &connector_,
+                                std::chrono::milliseconds(1000),
+                                std::chrono::milliseconds(100),
+                                /*maxWarmSessionsPerEndpoint=*/8);
+  Endpoint storage("storage.example.com", 443, true);
+  controller.trackEndpoint(storage, &pool);
+
+  // 25 req/s with a 100ms connect window wants about three warm
+  // sessions once the EWMA converges
+  for (int tick = 0; tick < 10; tick++) {
+    for (int i = 0; i < 25; i++) {
+      controller.recordRequest(storage);
+    }
+    controller.evaluate();
+  }
+  EXPECT_EQ(controller.getTargetIdleSessions(storage), 3);
+
+  // The pool has no idle sessions; establishment is capped per tick and
+  // pending connects count against the deficit
+  EXPECT_EQ(connector_.connects["storage.example.com"], 3);
+}
+
+TEST_F(WarmPoolControllerTest, ConnectOutcomeReleasesPendingSlot) {
+  SessionPool pool(nullptr, 8);
+  WarmPoolController controller(&evb_,
+                                &connector_,
+                                std::chrono::milliseconds(1000),
+                                std::chrono::milliseconds(100),
+                                8);
+  Endpoint storage("storage.example.com", 443, true);
+  controller.trackEndpoint(storage, &pool);
+
+  for (int i = 0; i < 100; i++) {
+    controller.recordRequest(storage);
+  }
+  controller.evaluate();
+  auto dialed = connector_.connects["storage.example.com"];
+  EXPECT_GT(dialed, 0);
+
+  // Failed connects free their slots, so the next tick retries
+  for (uint32_t i = 0; i < dialed; i++) {
+    controller.onConnectOutcome(storage, false);
+  }
+  controller.evaluate();
+  EXPECT_GT(connector_.connects["storage.example.com"], dialed);
+}
+
+TEST_F(WarmPoolControllerTest, IdleEndpointDecaysToZero) {
+  SessionPool pool(nullptr, 8);
+  WarmPoolController controller(&evb_,
+                                &connector_,
+                                std::chrono::milliseconds(1000),
+                                std::chrono::milliseconds(100),
+                                8);
+  Endpoint storage("storage.example.com", 443, true);
+  controller.trackEndpoint(storage, &pool);
+
+  for (int i = 0; i < 100; i++) {
+    controller.recordRequest(storage);
+  }
+  controller.evaluate();
+  EXPECT_GT(controller.getTargetIdleSessions(storage), 0);
+
+  // With no further traffic the EWMA decays and the target drops off
+  for (int tick = 0; tick < 30; tick++) {
+    controller.evaluate();
+  }
+  EXPECT_EQ(controller.getTargetIdleSessions(storage), 0);
+
+  controller.untrackEndpoint(storage);
+  controller.recordRequest(storage); // no-op for unknown endpoints
+  EXPECT_EQ(controller.getTargetIdleSessions(storage), 0);
+}
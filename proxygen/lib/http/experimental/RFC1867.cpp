@@ -9,6 +9,8 @@
 #include <proxygen/lib/http/experimental/RFC1867.h>
 #include <proxygen/lib/utils/Logging.h>
 
+#include <cstring>
+
 using folly::IOBuf;
 using folly::IOBufQueue;
 using folly::StringPiece;
@@ -61,7 +63,7 @@ std::unique_ptr<IOBuf> RFC1867Codec::onIngress(std::unique_ptr<IOBuf> data) {
   BoundaryResult br = BoundaryResult::NO;
 
   input_.append(std::move(data));
-  while (!input_.empty()) {
+  while (!input_.empty() && !paused_) {
     switch (state_) {
       case ParserState::START:
         // first time, must start with boundary without leading \n
@@ -139,9 +141,9 @@ std::unique_ptr<IOBuf> RFC1867Codec::onIngress(std::unique_ptr<IOBuf> data) {
 
       case ParserState::FIELD_DATA:
         result = readToBoundary(foundBoundary);
-        value_.append(result.move());
-        if (!value_.empty() && callback_) {
-          if (callback_->onFieldData(value_.move(), bytesProcessed_) < 0) {
+        if (!result.empty() && callback_) {
+          // Hand off the boundary-free slices without copying
+          if (callback_->onFieldData(result.move(), bytesProcessed_) < 0) {
             LOG(ERROR) << "Callback returned error";
             state_ = ParserState::ERROR;
             return nullptr;
@@ -166,7 +168,8 @@ std::unique_ptr<IOBuf> RFC1867Codec::onIngress(std::unique_ptr<IOBuf> data) {
         return nullptr;
     }
   }
-  return nullptr;
+  // Empty unless paused mid-parse; the caller re-feeds this after resuming
+  return input_.move();
 }
 
 void RFC1867Codec::onHeadersComplete(HTTPCodec::StreamID /*stream*/,
@@ -224,50 +227,70 @@ IOBufQueue RFC1867Codec::readToBoundary(bool& foundBoundary) {
   while (!input_.empty() && boundaryResult != BoundaryResult::PARTIAL) {
     const IOBuf* head = input_.front();
     uint64_t len = head->length();
-    const uint8_t* ptr = head->data();
+    const uint8_t* data = head->data();
+    uint64_t readlen = len;
+    boundaryResult = BoundaryResult::NO;
 
-    /* iterate through first character matches */
-    while (len > 0 && (ptr = (const uint8_t*)memchr(ptr, boundary_[0], len))) {
-      /* calculate length after match */
-      uint64_t readlen = (ptr - head->data());
-      len = head->length() - readlen;
-      boundaryResult =
-          isBoundary(*head, readlen, boundary_.data(), boundary_.length());
-      if (boundaryResult == BoundaryResult::YES) {
-        CHECK(readlen < head->length());
-        bool hasCr = false;
-        if (readlen == 0 && pendingCR_) {
-          pendingCR_.reset();
+    // A boundary fully contained in this buffer is found with memmem, which
+    // libc vectorizes (two-way algorithm), instead of probing every first
+    // character match byte by byte.
+    if (len >= boundary_.length()) {
+      auto match = static_cast<const uint8_t*>(
+          memmem(data, len, boundary_.data(), boundary_.length()));
+      if (match) {
+        boundaryResult = BoundaryResult::YES;
+        readlen = match - data;
+      }
+    }
+    if (boundaryResult == BoundaryResult::NO) {
+      // The boundary may still start in the tail of this buffer and continue
+      // into the next one; only the last boundary-1 bytes can begin such a
+      // match (buffers shorter than the boundary are scanned in full).
+      uint64_t tailStart =
+          len >= boundary_.length() ? len - boundary_.length() + 1 : 0;
+      const uint8_t* ptr = data + tailStart;
+      uint64_t remaining = len - tailStart;
+      while (remaining > 0 && (ptr = (const uint8_t*)memchr(
+                                   ptr, boundary_[0], remaining))) {
+        uint64_t offset = ptr - data;
+        boundaryResult =
+            isBoundary(*head, offset, boundary_.data(), boundary_.length());
+        if (boundaryResult != BoundaryResult::NO) {
+          readlen = offset;
+          break;
         }
-        if (readlen > 0) {
-          // If the last read char is a CR omit from result
-          Cursor c(head);
-          c.skip(readlen - 1);
-          uint8_t ch = c.read<uint8_t>();
-          if (ch == '\r') {
-            --readlen;
-            hasCr = true;
-          }
+        ptr++;
+        remaining = len - (ptr - data);
+      }
+    }
+
+    if (boundaryResult == BoundaryResult::YES) {
+      CHECK_LT(readlen, len);
+      bool hasCr = false;
+      if (readlen == 0 && pendingCR_) {
+        // The held-back CR was part of the CRLF preceding this boundary
+        pendingCR_.reset();
+      }
+      if (readlen > 0) {
+        // If the last char before the boundary is a CR, omit it from result
+        if (data[readlen - 1] == '\r') {
+          --readlen;
+          hasCr = true;
         }
         result.append(std::move(pendingCR_));
-        result.append(input_.split(readlen));
-        uint32_t trimLen = boundary_.length() + (hasCr ? 1 : 0);
-        input_.trimStart(trimLen);
-        bytesProcessed_ += readlen + trimLen;
-        foundBoundary = true;
-        return result;
-      } else if (boundaryResult == BoundaryResult::PARTIAL) {
-        break;
-      } else if (pendingCR_) {
-        // not a match, append pending CR to result
-        result.append(std::move(pendingCR_));
       }
-
-      /* next character */
-      ptr++;
-      len--;
+      result.append(input_.split(readlen));
+      uint32_t trimLen = boundary_.length() + (hasCr ? 1 : 0);
+      input_.trimStart(trimLen);
+      bytesProcessed_ += readlen + trimLen;
+      foundBoundary = true;
+      return result;
     }
-    uint64_t resultLen = ptr ? ptr - head->data() : head->length();
+
+    // NO: hand off the whole buffer; PARTIAL: hand off everything before the
+    // potential boundary and wait for more input.
+    uint64_t resultLen =
+        boundaryResult == BoundaryResult::PARTIAL ? readlen : len;
     // Put pendingCR_ in result if there was no partial match in head, or a
     // partial match starting after the first character
     if ((boundaryResult == BoundaryResult::NO || resultLen > 0) && pendingCR_) {
@@ -275,7 +298,7 @@ IOBufQueue RFC1867Codec::readToBoundary(bool& foundBoundary) {
     }
     // the boundary does not start through resultLen, append it
     // to result, except maybe the last char if it's a CR.
-    if (resultLen > 0 && head->data()[resultLen - 1] == '\r') {
+    if (resultLen > 0 && data[resultLen - 1] == '\r') {
       result.append(input_.split(resultLen - 1));
       CHECK(!pendingCR_);
       pendingCR_ = input_.split(1);
@@ -55,9 +55,25 @@ class RFC1867Codec : HTTPCodec::Callback {
   }
 
   // Pass the next piece of input data.  Returns unparsed data that requires
-  // more input to continue
+  // more input to continue, or that was left unconsumed because the parser
+  // is paused
   std::unique_ptr<folly::IOBuf> onIngress(std::unique_ptr<folly::IOBuf> data);
 
+  /**
+   * Pause or resume parsing.  While paused, onIngress() invokes no further
+   * callbacks and returns its unconsumed input; the caller re-feeds that
+   * data after resuming.  A callback that pauses its transaction's ingress
+   * (HTTPTransaction::pauseIngress()) should pause the codec too, so part
+   * data buffered ahead of a slow consumer stays bounded.
+   */
+  void setParserPaused(bool paused) {
+    paused_ = paused;
+  }
+
+  bool isParserPaused() const {
+    return paused_;
+  }
+
   // The end of input has been seen.  Validate the parser state and reset
   // for more parsing.
   void onIngressEOM();
@@ -113,10 +129,10 @@ class RFC1867Codec : HTTPCodec::Callback {
   HTTP1xCodec headerParser_{TransportDirection::DOWNSTREAM};
   std::string field_;
   folly::IOBufQueue input_{folly::IOBufQueue::cacheChainLength()};
-  folly::IOBufQueue value_;
   std::unique_ptr<folly::IOBuf> pendingCR_;
   uint64_t bytesProcessed_{0};
   bool parseError_{false};
+  bool paused_{false};
 };
 
 } // namespace proxygen
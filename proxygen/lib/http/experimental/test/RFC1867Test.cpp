@@ -236,6 +236,43 @@ TEST_F(RFC1867Test, TestHeadersChunkExtraCr) {
   testSimple(std::move(data), 3 + 5 + fileSize, numCRs - 1, 3);
 }
 
+TEST_F(RFC1867Test, TestPauseResume) {
+  size_t fileSize = 100;
+  auto data = makePost({{"foo", "bar"}}, {}, {{"file1", {"", fileSize}}});
+  size_t fileLength = 0;
+  EXPECT_CALL(callback_, onFieldStartImpl(_, _, _, _))
+      .Times(2)
+      .WillRepeatedly(Return(0));
+  EXPECT_CALL(callback_, onFieldData(_, _))
+      .WillRepeatedly(Invoke([&](std::shared_ptr<IOBuf> data, uint64_t) {
+        fileLength += data->computeChainDataLength();
+        // Exert backpressure after every delivered chunk
+        codec_.setParserPaused(true);
+        return 0;
+      }));
+  EXPECT_CALL(callback_, onFieldEnd(true, _)).Times(2).WillRepeatedly(Return());
+
+  IOBufQueue ibuf{IOBufQueue::cacheChainLength()};
+  ibuf.append(std::move(data));
+  unique_ptr<IOBuf> rem;
+  while (!ibuf.empty() || (rem && codec_.isParserPaused())) {
+    unique_ptr<IOBuf> chunk;
+    if (!ibuf.empty()) {
+      chunk = ibuf.split(std::min<size_t>(10, ibuf.chainLength()));
+    }
+    if (rem) {
+      if (chunk) {
+        rem->prependChain(std::move(chunk));
+      }
+      chunk = std::move(rem);
+    }
+    codec_.setParserPaused(false);
+    rem = codec_.onIngress(std::move(chunk));
+  }
+  codec_.onIngressEOM();
+  EXPECT_EQ(fileLength, 3 + fileSize);
+}
+
 class RFC1867CR
     : public testing::TestWithParam<string>
     , public RFC1867Base {
@@ -9,7 +9,31 @@
 #include <proxygen/lib/http/session/ByteEventTracker.h>
 
 #include <folly/io/async/DelayedDestruction.h>
+#include <folly/small_vector.h>
+#include <new>
 #include <string>
+#include <vector>
+
+namespace {
+// cap on recycled TransactionByteEvent allocations kept per worker
+constexpr size_t kByteEventFreeListMax = 256;
+
+// Recycled TransactionByteEvent storage, shared by every tracker on the
+// worker thread.  Trackers are only touched from their session's
+// EventBase thread, so no synchronization is needed, and the pool stays
+// warm across sessions instead of draining with each one.
+struct EventFreeList {
+  ~EventFreeList() {
+    for (auto storage : slots) {
+      operator delete(storage);
+    }
+  }
+
+  std::vector<void*> slots;
+};
+
+thread_local EventFreeList eventFreeList;
+} // namespace
 
 namespace proxygen {
 
@@ -18,9 +42,41 @@ ByteEventTracker::~ByteEventTracker() {
 }
 
 void ByteEventTracker::absorb(ByteEventTracker&& other) {
+  // both trackers live on the same worker, so the replaced tracker's
+  // events keep releasing into the shared worker freelist
   byteEvents_ = std::move(other.byteEvents_);
 }
 
+TransactionByteEvent* ByteEventTracker::allocTransactionByteEvent(
+    uint64_t byteNo, ByteEvent::EventType type, HTTPTransaction* txn) {
+  void* storage;
+  if (eventFreeList.slots.empty()) {
+    storage = operator new(sizeof(TransactionByteEvent));
+  } else {
+    storage = eventFreeList.slots.back();
+    eventFreeList.slots.pop_back();
+  }
+  auto event = new (storage) TransactionByteEvent(byteNo, type, txn);
+  event->pooled_ = true;
+  return event;
+}
+
+void ByteEventTracker::releaseByteEvent(ByteEvent* event) {
+  if (!event->pooled_) {
+    delete event;
+    return;
+  }
+  // pooled_ is only ever set on events allocated by
+  // allocTransactionByteEvent, so the cast below is safe
+  auto txnEvent = static_cast<TransactionByteEvent*>(event);
+  txnEvent->~TransactionByteEvent();
+  if (eventFreeList.slots.size() < kByteEventFreeListMax) {
+    eventFreeList.slots.push_back(txnEvent);
+  } else {
+    operator delete(txnEvent);
+  }
+}
+
 // The purpose of self is to represent shared ownership during
 // processByteEvents.  This allows the owner to release ownership of the tracker
 // from a callback without causing problems
@@ -30,10 +86,21 @@ bool ByteEventTracker::processByteEvents(std::shared_ptr<ByteEventTracker> self,
   DCHECK(bytesWritten >= bytesWritten_);
   bytesWritten_ = bytesWritten;
 
+  // Unlink the whole ready prefix in one walk before delivering any
+  // callbacks.  Callbacks then run against an unlinked batch, so one
+  // that absorbs this tracker cannot disturb the walk, and the shared
+  // Callback gets a single bulk notification per batch instead of one
+  // virtual call per event.  Events a callback adds at already-written
+  // offsets fire on the next call.
+  folly::small_vector<ByteEvent*, 8> batch;
   while (!byteEvents_.empty() &&
          (byteEvents_.front().byteOffset_ <= bytesWritten)) {
-    ByteEvent& event = byteEvents_.front();
-    int64_t latency;
+    byteEvents_.pop_front_and_dispose(
+        [&batch](ByteEvent* event) { batch.push_back(event); });
+  }
+
+  for (auto eventPtr : batch) {
+    ByteEvent& event = *eventPtr;
     auto txn = event.getTransaction();
 
     switch (event.eventType_) {
@@ -50,9 +117,8 @@ bool ByteEventTracker::processByteEvents(std::shared_ptr<ByteEventTracker> self,
         txn->onEgressTrackedByte();
         break;
       case ByteEvent::PING_REPLY_SENT:
-        latency = event.getLatency();
         if (callback_) {
-          callback_->onPingReplyLatency(latency);
+          callback_->onPingReplyLatency(event.getLatency());
         }
         break;
       case ByteEvent::SECOND_TO_LAST_PACKET:
@@ -63,16 +129,16 @@ bool ByteEventTracker::processByteEvents(std::shared_ptr<ByteEventTracker> self,
     // notify that the offset the ByteEvent is associated with has been written
     // to the socket
     onByteEventWrittenToSocket(event);
+  }
 
-    // deliver to the callback
-    if (callback_) {
-      callback_->onTxnByteEventWrittenToBuf(event);
-    }
+  if (callback_ && !batch.empty()) {
+    callback_->onTxnByteEventsWrittenToBuf(
+        folly::Range<ByteEvent* const*>(batch.data(), batch.size()));
+  }
 
-    VLOG(5) << " removing ByteEvent " << event;
-    // explicitly remove from the list, in case delete event triggers a
-    // callback that would absorb this ByteEventTracker.
-    byteEvents_.pop_front_and_dispose([](ByteEvent* event) { delete event; });
+  for (auto eventPtr : batch) {
+    VLOG(5) << " removing ByteEvent " << *eventPtr;
+    releaseByteEvent(eventPtr);
   }
 
   return self.use_count() == 1;
@@ -82,7 +148,8 @@ size_t ByteEventTracker::drainByteEvents() {
   size_t numEvents = 0;
   // everything is dead from here on, let's just drop all extra refs to txns
   while (!byteEvents_.empty()) {
-    byteEvents_.pop_front_and_dispose([](ByteEvent* event) { delete event; });
+    byteEvents_.pop_front_and_dispose(
+        [this](ByteEvent* event) { releaseByteEvent(event); });
     ++numEvents;
   }
   return numEvents;
@@ -91,17 +158,48 @@ size_t ByteEventTracker::drainByteEvents() {
 void ByteEventTracker::addLastByteEvent(HTTPTransaction* txn,
                                         uint64_t byteNo) noexcept {
   VLOG(5) << " adding last byte event for " << byteNo;
-  TransactionByteEvent* event =
-      new TransactionByteEvent(byteNo, ByteEvent::LAST_BYTE, txn);
-  byteEvents_.push_back(*event);
+  byteEvents_.push_back(
+      *allocTransactionByteEvent(byteNo, ByteEvent::LAST_BYTE, txn));
 }
 
 void ByteEventTracker::addTrackedByteEvent(HTTPTransaction* txn,
                                            uint64_t byteNo) noexcept {
   VLOG(5) << " adding tracked byte event for " << byteNo;
-  TransactionByteEvent* event =
-      new TransactionByteEvent(byteNo, ByteEvent::TRACKED_BYTE, txn);
-  byteEvents_.push_back(*event);
+  byteEvents_.push_back(
+      *allocTransactionByteEvent(byteNo, ByteEvent::TRACKED_BYTE, txn));
+}
+
+void ByteEventTracker::addTxnByteEvents(
+    HTTPTransaction* txn, folly::Range<const EventRequest*> events) noexcept {
+  // Fast path: requests at or past the current tail append in order.
+  auto req = events.begin();
+  while (req != events.end() &&
+         (byteEvents_.empty() ||
+          req->byteNo >= byteEvents_.back().byteOffset_)) {
+    VLOG(5) << " adding byte event type=" << req->eventType << " for "
+            << req->byteNo;
+    byteEvents_.push_back(
+        *allocTransactionByteEvent(req->byteNo, req->eventType, txn));
+    ++req;
+  }
+  if (req == events.end()) {
+    return;
+  }
+  // The remaining requests fall before the tail; place them with a single
+  // backward walk, consuming the batch in descending offset order so the
+  // walk never revisits a list node.
+  auto hint = byteEvents_.end();
+  for (auto it = events.end(); it != req;) {
+    --it;
+    while (hint != byteEvents_.begin() &&
+           std::prev(hint)->byteOffset_ > it->byteNo) {
+      --hint;
+    }
+    VLOG(5) << " adding byte event type=" << it->eventType << " for "
+            << it->byteNo;
+    hint = byteEvents_.insert(
+        hint, *allocTransactionByteEvent(it->byteNo, it->eventType, txn));
+  }
 }
 
 void ByteEventTracker::addPingByteEvent(size_t pingSize,
@@ -136,7 +234,7 @@ void ByteEventTracker::addPingByteEvent(size_t pingSize,
 void ByteEventTracker::addFirstBodyByteEvent(uint64_t offset,
                                              HTTPTransaction* txn) {
   byteEvents_.push_back(
-      *new TransactionByteEvent(offset, ByteEvent::FIRST_BYTE, txn));
+      *allocTransactionByteEvent(offset, ByteEvent::FIRST_BYTE, txn));
 }
 
 void ByteEventTracker::addFirstHeaderByteEvent(uint64_t offset,
@@ -144,7 +242,7 @@ void ByteEventTracker::addFirstHeaderByteEvent(uint64_t offset,
   // onWriteSuccess() is called after the entire header has been written.
   // It does not catch partial write case.
   byteEvents_.push_back(
-      *new TransactionByteEvent(offset, ByteEvent::FIRST_HEADER_BYTE, txn));
+      *allocTransactionByteEvent(offset, ByteEvent::FIRST_HEADER_BYTE, txn));
 }
 
 } // namespace proxygen
@@ -8,10 +8,12 @@
 
 #pragma once
 
+#include <folly/Range.h>
 #include <proxygen/lib/http/session/AckLatencyEvent.h>
 #include <proxygen/lib/http/session/HTTPTransaction.h>
 #include <proxygen/lib/http/session/TransactionByteEvents.h>
 #include <proxygen/lib/utils/Time.h>
+#include <vector>
 
 namespace proxygen {
 
@@ -34,6 +36,21 @@ class ByteEventTracker {
     virtual void onPingReplyLatency(int64_t latency) noexcept = 0;
     virtual void onTxnByteEventWrittenToBuf(
         const ByteEvent& event) noexcept = 0;
+
+    /**
+     * Bulk variant: one call per processByteEvents() batch, after the
+     * per-transaction callbacks for every event in the batch have run.
+     * The default fans out to onTxnByteEventWrittenToBuf() per event,
+     * so callbacks that only care about individual events need not
+     * override it.
+     */
+    virtual void onTxnByteEventsWrittenToBuf(
+        folly::Range<ByteEvent* const*> events) noexcept {
+      for (auto event : events) {
+        onTxnByteEventWrittenToBuf(*event);
+      }
+    }
+
     virtual void onDeleteTxnByteEvent() noexcept = 0;
   };
 
@@ -88,6 +105,23 @@ class ByteEventTracker {
   virtual void addTrackedByteEvent(HTTPTransaction* txn,
                                    uint64_t byteNo) noexcept;
 
+  struct EventRequest {
+    uint64_t byteNo;
+    ByteEvent::EventType eventType;
+  };
+
+  /**
+   * Adds a batch of byte events for one transaction in a single list walk.
+   *
+   * The requests must be sorted by ascending byteNo.  Offsets at or past
+   * the current list tail -- the common case, since sessions add events in
+   * write order -- append in O(1) each; any remaining events are placed
+   * with one backward walk shared by the whole batch.
+   */
+  virtual void addTxnByteEvents(HTTPTransaction* txn,
+                                folly::Range<const EventRequest*>
+                                    events) noexcept;
+
   /**
    * Disables socket timestamp tracking and drains any related events.
    *
@@ -130,6 +164,22 @@ class ByteEventTracker {
   }
 
  protected:
+  /**
+   * Allocates a TransactionByteEvent from the worker-local freelist
+   * shared by every tracker on the thread, falling back to the heap
+   * when the freelist is empty.  Events allocated here are marked
+   * pooled_ and must be released through releaseByteEvent().
+   */
+  TransactionByteEvent* allocTransactionByteEvent(uint64_t byteNo,
+                                                  ByteEvent::EventType type,
+                                                  HTTPTransaction* txn);
+
+  /**
+   * Disposes of an event removed from byteEvents_, returning pooled events
+   * to the worker's freelist and deleting the rest.
+   */
+  void releaseByteEvent(ByteEvent* event);
+
   // the last value of byteWritten passed to processByteEvents
   // should always increase
   uint64_t bytesWritten_ = 0;
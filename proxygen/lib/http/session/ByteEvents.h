@@ -33,6 +33,7 @@ class ByteEvent {
       : eventType_(eventType),
         timestampTx_(false),
         timestampAck_(false),
+        pooled_(false),
         byteOffset_(byteOffset) {
   }
   FOLLY_POP_WARNING
@@ -66,7 +67,10 @@ class ByteEvent {
   // be delivered to the handler.
   bool timestampTx_ : 1;  // packed w/ byteOffset_
   bool timestampAck_ : 1; // packed w/ byteOffset_
-  uint64_t byteOffset_ : (8 * sizeof(uint64_t) - 5);
+  // set by ByteEventTracker on events it carved from its freelist; such
+  // events are returned to the freelist instead of deleted
+  bool pooled_ : 1; // packed w/ byteOffset_
+  uint64_t byteOffset_ : (8 * sizeof(uint64_t) - 6);
 };
 
 std::ostream& operator<<(std::ostream& os, const ByteEvent& txn);
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <folly/Optional.h>
+#include <folly/container/EvictingCacheMap.h>
+
+#include <proxygen/lib/http/codec/compress/CompressionInfo.h>
+
+namespace proxygen {
+
+/**
+ * Per-worker accept-time cache of learned per-client-class settings.
+ *
+ * Clients cluster into a small number of classes -- browser builds,
+ * mobile SDKs, crawlers -- recognizable at accept time from the TLS
+ * fingerprint and SNI, and the classes differ in which settings serve
+ * them best: a class that historically sustains high delivery rates
+ * wants larger initial flow-control windows than one stuck on throttled
+ * links, and a class whose traffic packs the compression table wants a
+ * bigger table than one that barely exercises it.  The cache keys on an
+ * opaque class key (the acceptor composes it from the TLS fingerprint
+ * and SNI), folds per-session observations into per-class EWMAs at
+ * session teardown, and serves a settings profile back to the acceptor
+ * at accept time; classes are LRU-evicted past maxClasses.
+ *
+ * A profile is only served once a class has minSamples observations, so
+ * cold or evicted classes fall back to the static configuration.  The
+ * cache is per worker thread and not synchronized.
+ */
+class ClientCapabilityCache {
+ public:
+  struct Config {
+    size_t maxClasses{4096};
+    // The initial receive window is sized to the bytes the class's
+    // learned delivery rate moves over this horizon
+    std::chrono::milliseconds windowSizingHorizon{100};
+    size_t minInitialReceiveWindow{65535};
+    size_t maxInitialReceiveWindow{1 << 20};
+    // The advertised header table is the learned steady-state encoder
+    // occupancy with 2x headroom, within these bounds
+    uint32_t minHeaderTableSize{1024};
+    uint32_t maxHeaderTableSize{65536};
+    // Weight of a new observation in the per-class EWMAs
+    double observationWeight{0.25};
+    // Observations required before a class's profile is applied
+    uint32_t minSamples{3};
+  };
+
+  struct Profile {
+    size_t initialReceiveWindow{0};
+    uint32_t headerTableSize{0};
+  };
+
+  explicit ClientCapabilityCache(Config config = Config())
+      : config_(config), classes_(config.maxClasses) {
+  }
+
+  /**
+   * The learned profile for a class, or none while the class is still
+   * cold.  Looking a class up marks it recently used.
+   */
+  folly::Optional<Profile> getProfile(const std::string& key) {
+    auto it = classes_.find(key);
+    if (it == classes_.end() || it->second.samples < config_.minSamples) {
+      return folly::none;
+    }
+    const auto& cls = it->second;
+    Profile profile;
+    profile.initialReceiveWindow =
+        std::min(config_.maxInitialReceiveWindow,
+                 std::max(config_.minInitialReceiveWindow,
+                          static_cast<size_t>(
+                              cls.deliveryRate *
+                              config_.windowSizingHorizon.count() / 1000.0)));
+    profile.headerTableSize =
+        std::min(config_.maxHeaderTableSize,
+                 std::max(config_.minHeaderTableSize,
+                          static_cast<uint32_t>(cls.tableOccupancy * 2)));
+    return profile;
+  }
+
+  /**
+   * Folds one finished session into its class: the delivery rate the
+   * session sustained (egress bytes over connection lifetime) and the
+   * compression state its codec settled at.
+   */
+  void recordSession(const std::string& key,
+                     double deliveryRateBytesPerSec,
+                     const CompressionInfo& compression) {
+    auto it = classes_.find(key);
+    if (it == classes_.end()) {
+      classes_.set(key, ClientClass());
+      it = classes_.find(key);
+    }
+    auto& cls = it->second;
+    const double weight = config_.observationWeight;
+    if (cls.samples == 0) {
+      cls.deliveryRate = deliveryRateBytesPerSec;
+      cls.tableOccupancy = compression.egress.bytesStored_;
+    } else {
+      cls.deliveryRate =
+          (1 - weight) * cls.deliveryRate + weight * deliveryRateBytesPerSec;
+      cls.tableOccupancy = (1 - weight) * cls.tableOccupancy +
+                           weight * compression.egress.bytesStored_;
+    }
+    cls.samples++;
+  }
+
+  size_t getNumClasses() const {
+    return classes_.size();
+  }
+
+ private:
+  struct ClientClass {
+    double deliveryRate{0.0};   // egress bytes per second
+    double tableOccupancy{0.0}; // encoder dynamic table bytes stored
+    uint32_t samples{0};
+  };
+
+  const Config config_;
+  folly::EvictingCacheMap<std::string, ClientClass> classes_;
+};
+
+} // namespace proxygen
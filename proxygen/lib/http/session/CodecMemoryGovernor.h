@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace proxygen {
+
+/**
+ * Per-worker elastic budgeting for codec memory.
+ *
+ * Advertised SETTINGS_HEADER_TABLE_SIZE and initial flow-control windows
+ * are statically configured, which forces worst-case sizing: with tens
+ * of thousands of sessions the aggregate compression table memory is
+ * large, while at low occupancy the tables are smaller than the worker
+ * could afford.  The governor interpolates both between their configured
+ * bounds from a pressure value computed from the current session count
+ * and, optionally, the worker's RSS, so new sessions are admitted with
+ * budgets matching actual occupancy.
+ *
+ * Crossing the high watermark additionally arms a one-shot shrink pass
+ * (shouldShrinkExistingSessions) that the owner uses to re-advertise a
+ * smaller table to existing sessions via a SETTINGS update; the
+ * watermarks have hysteresis so an occupancy hovering near the threshold
+ * does not flap.
+ *
+ * The governor is per worker thread and not synchronized.
+ */
+class CodecMemoryGovernor {
+ public:
+  struct Config {
+    // Bounds for the header table size advertised to new sessions
+    uint32_t maxHeaderTableSize{4096};
+    uint32_t minHeaderTableSize{512};
+    // Bounds for the per-stream initial receive window
+    size_t maxInitialReceiveWindow{65536};
+    size_t minInitialReceiveWindow{16384};
+    // Session count at which pressure reaches 1.0
+    uint64_t sessionBudget{65536};
+    // Worker RSS at which pressure reaches 1.0; 0 disables the signal
+    uint64_t workerRssBudgetBytes{0};
+    // Pressure above which existing sessions are shrunk, and below
+    // which the governor re-expands
+    double shrinkThreshold{0.75};
+    double expandThreshold{0.5};
+  };
+
+  explicit CodecMemoryGovernor(Config config) : config_(config) {
+  }
+
+  /**
+   * Feeds the current occupancy; cheap enough to call on every accept.
+   * RSS is supplied by the caller (e.g. from periodic resource polling)
+   * and may be 0 when unknown.
+   */
+  void updateOccupancy(uint64_t sessionCount, uint64_t workerRssBytes = 0) {
+    double sessionPressure =
+        config_.sessionBudget > 0
+            ? std::min(1.0,
+                       static_cast<double>(sessionCount) /
+                           static_cast<double>(config_.sessionBudget))
+            : 0.0;
+    double rssPressure =
+        (config_.workerRssBudgetBytes > 0 && workerRssBytes > 0)
+            ? std::min(1.0,
+                       static_cast<double>(workerRssBytes) /
+                           static_cast<double>(config_.workerRssBudgetBytes))
+            : 0.0;
+    pressure_ = std::max(sessionPressure, rssPressure);
+    if (!underPressure_ && pressure_ >= config_.shrinkThreshold) {
+      underPressure_ = true;
+      shrinkPending_ = true;
+    } else if (underPressure_ && pressure_ <= config_.expandThreshold) {
+      underPressure_ = false;
+    }
+  }
+
+  double getPressure() const {
+    return pressure_;
+  }
+
+  bool underPressure() const {
+    return underPressure_;
+  }
+
+  // Header table size for a session admitted at current pressure
+  uint32_t getHeaderTableSize() const {
+    return interpolate(config_.maxHeaderTableSize, config_.minHeaderTableSize);
+  }
+
+  // Initial per-stream receive window at current pressure
+  size_t getInitialReceiveWindow() const {
+    return interpolate(config_.maxInitialReceiveWindow,
+                       config_.minInitialReceiveWindow);
+  }
+
+  /**
+   * True exactly once per high-watermark crossing; used to trigger a
+   * one-shot shrink pass over existing sessions.
+   */
+  bool shouldShrinkExistingSessions() {
+    bool pending = shrinkPending_;
+    shrinkPending_ = false;
+    return pending;
+  }
+
+  const Config& getConfig() const {
+    return config_;
+  }
+
+ private:
+  template <typename T>
+  T interpolate(T atNoPressure, T atFullPressure) const {
+    if (atNoPressure <= atFullPressure) {
+      return atNoPressure;
+    }
+    return atNoPressure -
+           static_cast<T>(static_cast<double>(atNoPressure - atFullPressure) *
+                          pressure_);
+  }
+
+  const Config config_;
+  double pressure_{0.0};
+  bool underPressure_{false};
+  bool shrinkPending_{false};
+};
+
+} // namespace proxygen
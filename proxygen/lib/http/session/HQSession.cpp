@@ -18,8 +18,10 @@
 #include <proxygen/lib/http/session/HTTPSessionController.h>
 #include <proxygen/lib/http/session/HTTPSessionStats.h>
 #include <proxygen/lib/http/session/HTTPTransaction.h>
+#include <proxygen/lib/utils/RotatingBloomFilter.h>
 
 #include <folly/CppAttributes.h>
+#include <folly/hash/SpookyHashV2.h>
 #include <folly/Format.h>
 #include <folly/ScopeGuard.h>
 #include <folly/io/IOBufQueue.h>
@@ -29,6 +31,7 @@
 #include <folly/io/async/EventBase.h>
 #include <folly/io/async/HHWheelTimer.h>
 #include <quic/QuicConstants.h>
+#include <quic/codec/QuicInteger.h>
 #include <quic/common/BufUtil.h>
 #include <quic/logging/QLoggerConstants.h>
 #include <wangle/acceptor/ConnectionManager.h>
@@ -397,6 +400,28 @@ void HQSession::onReplaySafe() noexcept {
   waitingForReplaySafety_.clear();
 }
 
+bool HQSession::recordEarlyDataRequest(const HTTPMessage& msg) {
+  DCHECK(earlyDataReplayFilter_);
+  // A replayed 0-RTT flight carries a byte-identical request, so the
+  // request line plus headers identify it well enough for a filter that
+  // only tolerates false positives.
+  folly::hash::SpookyHashV2 hasher;
+  hasher.Init(0, 0);
+  const auto& method = msg.getMethodString();
+  hasher.Update(method.data(), method.size());
+  const auto& url = msg.getURL();
+  hasher.Update(url.data(), url.size());
+  msg.getHeaders().forEach(
+      [&hasher](const std::string& name, const std::string& value) {
+        hasher.Update(name.data(), name.size());
+        hasher.Update(value.data(), value.size());
+      });
+  uint64_t hash1 = 0;
+  uint64_t hash2 = 0;
+  hasher.Final(&hash1, &hash2);
+  return earlyDataReplayFilter_->testAndSet(hash1 ^ hash2);
+}
+
 void HQSession::onConnectionEnd() noexcept {
   VLOG(4) << __func__ << " sess=" << *this;
   // The transport will not call onConnectionEnd after we call close(),
@@ -540,6 +565,106 @@ size_t HQSession::sendPushPriority(hq::PushId pushId, HTTPPriority priority) {
   return ret;
 }
 
+bool HQSession::setDatagramFlowCallback(const HTTPTransaction& txn,
+                                        DatagramFlowCallback* callback) {
+  if (!sock_) {
+    return false;
+  }
+  auto flowId = static_cast<uint64_t>(txn.getID()) / 4;
+  if (flowId >= kMaxDatagramFlowId) {
+    VLOG(3) << "Rejecting datagram flow registration flowId=" << flowId
+            << " sess=" << *this;
+    return false;
+  }
+  if (!datagramCallbackSet_) {
+    sock_->setDatagramCallback(this);
+    datagramCallbackSet_ = true;
+  }
+  if (datagramFlows_.size() <= flowId) {
+    datagramFlows_.resize(flowId + 1);
+  }
+  auto& flow = datagramFlows_[flowId];
+  if (!flow) {
+    if (!datagramFlowPool_.empty()) {
+      flow = std::move(datagramFlowPool_.back());
+      datagramFlowPool_.pop_back();
+    } else {
+      flow = std::make_unique<DatagramFlowContext>();
+    }
+  }
+  flow->callback = callback;
+  return true;
+}
+
+void HQSession::unsetDatagramFlowCallback(const HTTPTransaction& txn) {
+  releaseDatagramFlow(static_cast<uint64_t>(txn.getID()) / 4);
+}
+
+void HQSession::releaseDatagramFlow(uint64_t flowId) {
+  if (flowId >= datagramFlows_.size() || !datagramFlows_[flowId]) {
+    return;
+  }
+  datagramFlows_[flowId]->reset();
+  datagramFlowPool_.push_back(std::move(datagramFlows_[flowId]));
+}
+
+bool HQSession::sendDatagram(const HTTPTransaction& txn,
+                             std::unique_ptr<folly::IOBuf> payload) {
+  if (!sock_) {
+    return false;
+  }
+  auto flowId = static_cast<uint64_t>(txn.getID()) / 4;
+  // Prepend the quarter-stream-ID prefix so the peer can demultiplex
+  folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+  folly::io::QueueAppender appender(&queue, 8 /* max varint size */);
+  auto prefix = quic::encodeQuicInteger(
+      flowId, [&appender](auto val) { appender.writeBE(val); });
+  if (prefix.hasError()) {
+    return false;
+  }
+  queue.append(std::move(payload));
+  auto res = sock_->writeDatagram(queue.move());
+  if (res.hasError()) {
+    VLOG(3) << "writeDatagram failed error=" << static_cast<int>(res.error())
+            << " sess=" << *this;
+    return false;
+  }
+  if (flowId < datagramFlows_.size() && datagramFlows_[flowId]) {
+    datagramFlows_[flowId]->datagramsSent++;
+  }
+  return true;
+}
+
+void HQSession::onDatagramsAvailable() noexcept {
+  auto datagrams = sock_->readDatagrams();
+  if (datagrams.hasError()) {
+    LOG(ERROR) << "readDatagrams failed error="
+               << static_cast<int>(datagrams.error()) << " sess=" << *this;
+    return;
+  }
+  for (auto& datagram : *datagrams) {
+    folly::io::Cursor cursor(datagram.get());
+    auto flowId = quic::decodeQuicInteger(cursor);
+    if (!flowId) {
+      VLOG(4) << "Dropping datagram with malformed flow prefix sess=" << *this;
+      continue;
+    }
+    auto* flow = flowId->first < datagramFlows_.size()
+                     ? datagramFlows_[flowId->first].get()
+                     : nullptr;
+    if (!flow || !flow->callback) {
+      VLOG(4) << "Dropping datagram for unclaimed flowId=" << flowId->first
+              << " sess=" << *this;
+      continue;
+    }
+    // Hand the transport buffer straight to the callback after trimming
+    // the prefix; no copy on the receive path
+    datagram->trimStart(flowId->second);
+    flow->datagramsReceived++;
+    flow->callback->onDatagram(std::move(datagram));
+  }
+}
+
 size_t HQSession::HQStreamTransportBase::changePriority(
     HTTPTransaction* txn, HTTPPriority priority) noexcept {
   if (session_.direction_ == TransportDirection::DOWNSTREAM) {
@@ -1580,6 +1705,9 @@ void HQSession::onGoaway(uint64_t minUnseenId,
   }
   minPeerUnseenId_ = minUnseenId;
   setCloseReason(ConnectionCloseReason::GOAWAY);
+  if (infoCallback_) {
+    infoCallback_->onGoawayReceived(*this);
+  }
   // drains existing streams and prevents new streams to be created
   drainImpl();
 
@@ -1863,6 +1991,20 @@ void HQSession::handleSessionError(HQStreamBase* stream,
   dropConnectionAsync(std::make_pair(appError, appErrorMsg), proxygenError);
 }
 
+uint64_t HQSession::packetAlignedEgressBudget(uint64_t maxEgress,
+                                              double ratio) {
+  if (ratio <= 0 || ratio >= 1) {
+    return maxEgress;
+  }
+  // The exact short-header packet payload depends on the connection ID
+  // length and cipher overhead; using the full packet length only
+  // over-sizes the budget slightly, which is harmless
+  constexpr uint64_t packetLen = quic::kDefaultUDPSendPacketLen;
+  auto share = static_cast<uint64_t>(maxEgress * ratio);
+  auto aligned = ((share + packetLen - 1) / packetLen) * packetLen;
+  return std::min(maxEgress, std::max(aligned, packetLen));
+}
+
 uint64_t HQSession::writeRequestStreams(uint64_t maxEgress) noexcept {
   // requestStreamWriteImpl may call txn->onWriteReady
   txnEgressQueue_.nextEgress(nextEgressResults_);
@@ -1871,9 +2013,18 @@ uint64_t HQSession::writeRequestStreams(uint64_t maxEgress) noexcept {
     auto& ratio = it->second;
     auto hqStream =
         static_cast<HQStreamTransportBase*>(&it->first->getTransport());
-    // TODO: scale maxToSend by ratio?
-    auto sent = requestStreamWriteImpl(hqStream, maxEgress, ratio);
-    DCHECK_LE(sent, maxEgress);
+    // Cap each stream at its ratio share of the round, packet-aligned, so
+    // equal-priority (incremental) streams interleave fairly instead of
+    // the first one consuming the whole transport window.  Bytes a stream
+    // leaves unused roll over to the streams after it, and the last
+    // stream may take everything that remains; any stream still holding
+    // egress stays queued and gets the next onWriteReady round.
+    uint64_t streamBudget = maxEgress;
+    if (std::next(it) != nextEgressResults_.end()) {
+      streamBudget = packetAlignedEgressBudget(maxEgress, ratio);
+    }
+    auto sent = requestStreamWriteImpl(hqStream, streamBudget, ratio);
+    DCHECK_LE(sent, streamBudget);
     maxEgress -= sent;
 
     if (maxEgress == 0 && std::next(it) != nextEgressResults_.end()) {
@@ -2423,6 +2574,7 @@ void HQSession::detachStreamTransport(HQStreamTransportBase* hqStream) {
     if (sock_ && hqStream->hasIngressStreamId()) {
       clearStreamCallbacks(streamId);
     }
+    releaseDatagramFlow(static_cast<uint64_t>(streamId) / 4);
     eraseStream(streamId);
   } else {
     VLOG(4) << __func__ << " streamID=NA";
@@ -2545,6 +2697,26 @@ void HQSession::HQStreamTransportBase::onHeadersComplete(
   CHECK(codecStreamId_);
   CHECK_EQ(streamID, *codecStreamId_);
 
+  // A downstream request arriving before the handshake is replay-safe
+  // came in as 0-RTT early data; check it against the anti-replay filter
+  // before handler dispatch.
+  if (session_.earlyDataReplayFilter_ &&
+      session_.direction_ == TransportDirection::DOWNSTREAM &&
+      session_.sock_ && !session_.sock_->replaySafe() &&
+      session_.recordEarlyDataRequest(*msg)) {
+    if (session_.earlyDataReplayAction_ == EarlyDataReplayAction::Reject) {
+      VLOG(3) << "Rejecting replayed 0-RTT request txn=" << txn_;
+      HTTPException ex(HTTPException::Direction::INGRESS,
+                       "replayed 0-RTT request");
+      ex.setHttpStatusCode(425);
+      ex.setProxygenError(kErrorEarlyDataFailed);
+      session_.handleErrorDirectly(&txn_, ex);
+      return;
+    }
+    // RFC 8470: let the handler make the replay decision
+    msg->getHeaders().set("Early-Data", "1");
+  }
+
   //  setupOnHeadersComplete is only implemented
   //  in the HQDownstreamSession, which does not
   //  receive push promises. Will only be called once
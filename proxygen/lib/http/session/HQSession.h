@@ -33,6 +33,7 @@
 #include <proxygen/lib/http/session/HTTPTransaction.h>
 #include <proxygen/lib/http/session/ServerPushLifecycle.h>
 #include <proxygen/lib/utils/ConditionalGate.h>
+#include <proxygen/lib/utils/ThreadRecyclingAllocator.h>
 #include <quic/api/QuicSocket.h>
 #include <quic/common/BufUtil.h>
 
@@ -40,6 +41,7 @@ namespace proxygen {
 
 class HTTPSessionController;
 class HQSession;
+class RotatingBloomFilter;
 class VersionUtils;
 
 std::ostream& operator<<(std::ostream& os, const HQSession& session);
@@ -120,6 +122,7 @@ class HQSession
     , public quic::QuicSocket::ReadCallback
     , public quic::QuicSocket::WriteCallback
     , public quic::QuicSocket::DeliveryCallback
+    , public quic::QuicSocket::DatagramCallback
     , public HTTPSessionBase
     , public folly::EventBase::LoopCallback
     , public HQUnidirStreamDispatcher::Callback {
@@ -207,6 +210,25 @@ class HQSession
 
   void setSessionStats(HTTPSessionStats* stats) override;
 
+  enum class EarlyDataReplayAction : uint8_t {
+    Mark,   // set the RFC 8470 Early-Data header on suspected replays
+    Reject, // answer suspected replays with 425 before handler dispatch
+  };
+
+  /**
+   * Attach a (typically process-wide) anti-replay filter for requests
+   * received as 0-RTT early data.  Downstream requests that arrive
+   * before the handshake is replay-safe are hashed and checked against
+   * the filter; a hit is either marked or rejected with 425 according
+   * to the action.  Does not take ownership; the filter must outlive
+   * the session.
+   */
+  void setEarlyDataReplayFilter(RotatingBloomFilter* filter,
+                                EarlyDataReplayAction action) {
+    earlyDataReplayFilter_ = filter;
+    earlyDataReplayAction_ = action;
+  }
+
   void onNewBidirectionalStream(quic::StreamId id) noexcept override;
 
   void onNewUnidirectionalStream(quic::StreamId id) noexcept override;
@@ -377,6 +399,46 @@ class HQSession
     return sock_->setKnob(knobSpace, knobId, std::move(knobBlob));
   }
 
+  /**
+   * HTTP/3 datagram support.  Datagrams are demultiplexed on the
+   * quarter-stream-ID prefix (RFC 9297) and delivered to the callback
+   * registered for the owning transaction's flow.
+   */
+  class DatagramFlowCallback {
+   public:
+    virtual ~DatagramFlowCallback() = default;
+
+    /**
+     * One datagram payload with the flow prefix already consumed.  The
+     * buffer is the transport's receive buffer, handed over without
+     * copying.
+     */
+    virtual void onDatagram(std::unique_ptr<folly::IOBuf> payload) noexcept = 0;
+  };
+
+  /**
+   * Register to receive datagrams addressed to this transaction's flow.
+   * Returns false if the transport is gone or the flow ID is outside the
+   * supported range.  The registration is released automatically when
+   * the stream detaches.
+   */
+  bool setDatagramFlowCallback(const HTTPTransaction& txn,
+                               DatagramFlowCallback* callback);
+
+  void unsetDatagramFlowCallback(const HTTPTransaction& txn);
+
+  /**
+   * Send one unreliable datagram associated with this transaction; the
+   * quarter-stream-ID prefix is prepended here.  Returns false if the
+   * transport rejected the datagram (e.g. too large, or datagrams were
+   * not negotiated).
+   */
+  bool sendDatagram(const HTTPTransaction& txn,
+                    std::unique_ptr<folly::IOBuf> payload);
+
+  // quic::QuicSocket::DatagramCallback
+  void onDatagramsAvailable() noexcept override;
+
   /**
    * Sends a priority message on this session.  If the underlying protocol
    * doesn't support priority, this is a no-op.  A new stream identifier will
@@ -481,6 +543,17 @@ class HQSession
     return sock_.get();
   }
 
+  // QUIC keeps its own smoothed RTT; report that rather than sampling
+  folly::Optional<std::chrono::microseconds> getSessionRTT() const override {
+    if (sock_) {
+      auto srtt = sock_->getTransportInfo().srtt;
+      if (srtt.count() > 0) {
+        return srtt;
+      }
+    }
+    return folly::none;
+  }
+
   // Override HTTPSessionBase address getter functions
   const folly::SocketAddress& getLocalAddress() const noexcept override {
     return sock_ && sock_->good() ? sock_->getLocalAddress() : localAddr_;
@@ -760,6 +833,16 @@ class HQSession
   // for session logic.
   ServerPushLifecycleCallback* serverPushLifecycleCb_{nullptr};
 
+  /**
+   * Hashes the request line and headers of an early-data request and
+   * records it in earlyDataReplayFilter_.  Returns true if the filter
+   * had (possibly) already seen it, i.e. this looks like a replay.
+   */
+  bool recordEarlyDataRequest(const HTTPMessage& msg);
+
+  RotatingBloomFilter* earlyDataReplayFilter_{nullptr};
+  EarlyDataReplayAction earlyDataReplayAction_{EarlyDataReplayAction::Mark};
+
  private:
   std::unique_ptr<HTTPCodec> createStreamCodec(quic::StreamId streamId);
 
@@ -807,13 +890,13 @@ class HQSession
   void resumeReads(quic::StreamId id);
 
   // Resume all ingress transactions
-  void resumeReads();
+  void resumeReads() override;
 
   // Resuming the reads allows the read callback to be involved
   void pauseReads(quic::StreamId id);
 
   // Pause all ingress transactions
-  void pauseReads();
+  void pauseReads() override;
 
   void notifyEgressBodyBuffered(int64_t bytes);
 
@@ -858,6 +941,14 @@ class HQSession
                                   uint64_t maxEgress,
                                   double ratio);
 
+  /**
+   * Size one stream's egress budget for a write round: its scheduler
+   * ratio share of maxEgress, rounded up to whole QUIC packets so the
+   * stream's HTTP/3 frames fill its last packet instead of leaving it
+   * underfilled.  Always at least one packet, at most maxEgress.
+   */
+  static uint64_t packetAlignedEgressBudget(uint64_t maxEgress, double ratio);
+
   uint64_t writeControlStreams(uint64_t maxEgress);
   uint64_t controlStreamWriteImpl(HQControlStream* ctrlStream,
                                   uint64_t maxEgress);
@@ -1401,6 +1492,10 @@ class HQSession
 
     HTTPTransaction::Transport::Type getSessionType() const noexcept override;
 
+    folly::EventBase* getTransportEventBase() noexcept override {
+      return session_.getEventBase();
+    }
+
     virtual const HTTPCodec& getCodec() const noexcept override {
       return HQStreamBase::getCodec();
     }
@@ -2050,8 +2145,16 @@ class HQSession
   // To let the operator<< access DrainState which is private
   friend std::ostream& operator<<(std::ostream&, DrainState);
 
-  // Bidirectional transport streams
-  std::unordered_map<quic::StreamId, HQStreamTransport> streams_;
+  // Bidirectional transport streams; nodes are recycled through a
+  // per-thread free list instead of malloc on every stream
+  std::unordered_map<
+      quic::StreamId,
+      HQStreamTransport,
+      std::hash<quic::StreamId>,
+      std::equal_to<quic::StreamId>,
+      ThreadRecyclingAllocator<
+          std::pair<const quic::StreamId, HQStreamTransport>>>
+      streams_;
 
   // Creation time (for handshake time tracking)
   std::chrono::steady_clock::time_point createTime_;
@@ -2060,6 +2163,29 @@ class HQSession
   folly::F14FastMap<hq::PushId, quic::StreamId> pushIdToStreamId_;
   // Lookup maps for matching ingress push streams to push ids
   folly::F14FastMap<quic::StreamId, hq::PushId> streamIdToPushId_;
+
+  // Per-flow datagram receive state.  The table is indexed flat by flow
+  // ID (quarter stream ID), which stays small for the expected usage;
+  // contexts are recycled through datagramFlowPool_ instead of being
+  // reallocated per flow.
+  struct DatagramFlowContext {
+    DatagramFlowCallback* callback{nullptr};
+    uint64_t datagramsReceived{0};
+    uint64_t datagramsSent{0};
+
+    void reset() {
+      callback = nullptr;
+      datagramsReceived = 0;
+      datagramsSent = 0;
+    }
+  };
+
+  void releaseDatagramFlow(uint64_t flowId);
+
+  static constexpr uint64_t kMaxDatagramFlowId = 1024;
+  std::vector<std::unique_ptr<DatagramFlowContext>> datagramFlows_;
+  std::vector<std::unique_ptr<DatagramFlowContext>> datagramFlowPool_;
+  bool datagramCallbackSet_{false};
 }; // HQSession
 
 std::ostream& operator<<(std::ostream& os, HQSession::DrainState drainState);
@@ -8,6 +8,11 @@
 
 #include <proxygen/lib/http/session/HTTP2PriorityQueue.h>
 
+#include <folly/lang/Bits.h>
+#include <proxygen/lib/http/session/HTTPSessionStats.h>
+
+#include <numeric>
+
 using std::list;
 using std::unique_ptr;
 
@@ -45,6 +50,7 @@ HTTP2PriorityQueue::Node::~Node() {
   if (!txn_) {
     queue_.numVirtualNodes_--;
   }
+  clearEgressDeadline();
   queue_.nodes_.erase(id_);
 }
 
@@ -146,6 +152,18 @@ HTTP2PriorityQueue::Node* HTTP2PriorityQueue::Node::reparent(
   return this;
 }
 
+folly::Optional<TimePoint>
+HTTP2PriorityQueue::Node::getEffectiveEgressDeadline() const {
+  folly::Optional<TimePoint> deadline;
+  for (const Node* node = this; node; node = node->parent_) {
+    if (node->egressDeadline_ &&
+        (!deadline || *node->egressDeadline_ < *deadline)) {
+      deadline = node->egressDeadline_;
+    }
+  }
+  return deadline;
+}
+
 // Returns true if this is a descendant of node
 bool HTTP2PriorityQueue::Node::isDescendantOf(
     HTTP2PriorityQueue::Node* node) const {
@@ -455,6 +473,10 @@ HTTP2PriorityQueue::Handle HTTP2PriorityQueue::addTransaction(
   CHECK_NE(id, rootNodeId_);
   CHECK_NE(id, pri.streamDependency) << "Tried to create a loop in the tree";
   CHECK(!txn || !permanent);
+  if (urgencyMode_) {
+    // dependencies are ignored; every stream is a direct child of the root
+    pri = {rootNodeId_, false, pri.weight};
+  }
   if (largestId_ && id <= *largestId_) {
     Node* existingNode = find(id, depth);
     if (existingNode) {
@@ -518,6 +540,9 @@ HTTP2PriorityQueue::Handle HTTP2PriorityQueue::addTransaction(
     scheduleNodeExpiration(node.get());
   }
   auto result = parent->emplaceNode(std::move(node), pri.exclusive);
+  if (urgencyMode_) {
+    result->setUrgency(urgencyFromWeight(pri.weight));
+  }
   pendingWeightChange_ = true;
   return result;
 }
@@ -528,10 +553,16 @@ HTTP2PriorityQueue::Handle HTTP2PriorityQueue::updatePriority(
     uint64_t* depth) {
   Node* node = nodeFromBaseNode(handle);
   pendingWeightChange_ = true;
+  if (urgencyMode_) {
+    pri = {rootNodeId_, false, pri.weight};
+  }
   VLOG(4) << "Updating id=" << node->getID()
           << " with parent=" << pri.streamDependency
           << " and weight=" << ((uint16_t)pri.weight + 1);
   node->updateWeight(pri.weight);
+  if (urgencyMode_) {
+    setNodeUrgency(node, urgencyFromWeight(pri.weight));
+  }
   CHECK_NE(pri.streamDependency, node->getID())
       << "Tried to create a loop in the tree";
   if (pri.streamDependency == node->parentID() && !pri.exclusive) {
@@ -582,6 +613,9 @@ void HTTP2PriorityQueue::removeTransaction(HTTP2PriorityQueue::Handle handle) {
   }
   if (allowDanglingNodes() && numVirtualNodes_ < maxVirtualNodes_) {
     node->clearTransaction();
+    // the deadline belonged to the departing transaction; a dangling
+    // placeholder must not keep boosting its descendants
+    node->clearEgressDeadline();
     numVirtualNodes_++;
     scheduleNodeExpiration(node);
   } else {
@@ -591,21 +625,173 @@ void HTTP2PriorityQueue::removeTransaction(HTTP2PriorityQueue::Handle handle) {
 }
 
 void HTTP2PriorityQueue::signalPendingEgress(Handle handle) {
-  if (!handle->isEnqueued()) {
-    nodeFromBaseNode(handle)->signalPendingEgress();
+  if (handle->isEnqueued()) {
+    return;
+  }
+  Node* node = nodeFromBaseNode(handle);
+  node->enqueuedSince_ = getCurrentTime();
+  if (urgencyMode_) {
+    node->signalPendingEgressUrgent();
+    urgencyBuckets_[node->getUrgency()].push_back(*node);
     activeCount_++;
-    pendingWeightChange_ = true;
+    return;
   }
+  node->signalPendingEgress();
+  activeCount_++;
+  pendingWeightChange_ = true;
 }
 
 void HTTP2PriorityQueue::clearPendingEgress(Handle handle) {
   CHECK_GT(activeCount_, 0);
+  Node* node = nodeFromBaseNode(handle);
+  recordDequeue(node);
+  if (urgencyMode_) {
+    // clear does a CHECK on enqueued_
+    node->clearPendingEgressUrgent();
+    auto& bucket = urgencyBuckets_[node->getUrgency()];
+    bucket.erase(bucket.iterator_to(*node));
+    activeCount_--;
+    return;
+  }
   // clear does a CHECK on handle->isEnqueued()
-  nodeFromBaseNode(handle)->clearPendingEgress();
+  node->clearPendingEgress();
   activeCount_--;
   pendingWeightChange_ = true;
 }
 
+void HTTP2PriorityQueue::updateEgressDeadline(Handle handle,
+                                              TimePoint deadline) {
+  nodeFromBaseNode(handle)->setEgressDeadline(deadline);
+}
+
+void HTTP2PriorityQueue::clearEgressDeadline(Handle handle) {
+  nodeFromBaseNode(handle)->clearEgressDeadline();
+}
+
+uint8_t HTTP2PriorityQueue::urgencyFromWeight(uint8_t weight) {
+  // effective weight is 1-256; findLastSet(16) - 1 == 4 maps the default
+  // weight to the default urgency (3)
+  const uint32_t effectiveWeight = static_cast<uint32_t>(weight) + 1;
+  const uint32_t level =
+      std::min(uint32_t(kNumUrgencies - 1),
+               uint32_t(folly::findLastSet(effectiveWeight)) - 1);
+  return uint8_t(kNumUrgencies - 1 - level);
+}
+
+uint8_t HTTP2PriorityQueue::nodeBand(const Node* node) const {
+  if (urgencyMode_) {
+    return node->getUrgency();
+  }
+  // weight_ is the effective weight (wire weight + 1)
+  return urgencyFromWeight(uint8_t(node->getWeight() - 1));
+}
+
+void HTTP2PriorityQueue::recordDequeue(Node* node) {
+  auto& stats = bandStats_[nodeBand(node)];
+  stats.enqueuedMs += millisecondsSince(node->enqueuedSince_).count();
+  stats.dequeues++;
+}
+
+void HTTP2PriorityQueue::recordEgressBytes(HTTPCodec::StreamID id,
+                                           uint64_t bytes) {
+  Node* node = find(id);
+  if (!node || bytes == 0) {
+    return;
+  }
+  const auto band = nodeBand(node);
+  bandStats_[band].bytes += bytes;
+  totalAccountedBytes_ += bytes;
+  if (sessionStats_) {
+    sessionStats_->recordPriorityBandEgressBytes(band, bytes);
+  }
+}
+
+void HTTP2PriorityQueue::setNodeUrgency(Node* node, uint8_t urgency) {
+  urgency = std::min(urgency, uint8_t(kNumUrgencies - 1));
+  if (urgency == node->getUrgency()) {
+    return;
+  }
+  if (node->isEnqueued()) {
+    auto& oldBucket = urgencyBuckets_[node->getUrgency()];
+    oldBucket.erase(oldBucket.iterator_to(*node));
+    urgencyBuckets_[urgency].push_back(*node);
+  }
+  node->setUrgency(urgency);
+}
+
+void HTTP2PriorityQueue::updateUrgency(HTTPCodec::StreamID id,
+                                       uint8_t urgency) {
+  DCHECK(urgencyMode_);
+  Node* node = find(id);
+  if (node) {
+    setNodeUrgency(node, urgency);
+  }
+}
+
+void HTTP2PriorityQueue::nextEgressUrgency(NextEgressResult& result) {
+  size_t serveIdx = kNumUrgencies;
+  for (size_t i = 0; i < kNumUrgencies; i++) {
+    if (!urgencyBuckets_[i].empty()) {
+      serveIdx = i;
+      break;
+    }
+  }
+  if (serveIdx == kNumUrgencies) {
+    return;
+  }
+  if (minLowBandShare_ > 0 && totalAccountedBytes_ >= kStarvationCheckFloor) {
+    // Guarantee the least urgent band its minimum share: if it has fallen
+    // below, serve it ahead of the more urgent bands for this round
+    size_t lowIdx = serveIdx;
+    for (size_t i = kNumUrgencies; i-- > serveIdx + 1;) {
+      if (!urgencyBuckets_[i].empty()) {
+        lowIdx = i;
+        break;
+      }
+    }
+    if (lowIdx != serveIdx &&
+        bandStats_[lowIdx].bytes < minLowBandShare_ * totalAccountedBytes_) {
+      serveIdx = lowIdx;
+      bandStats_[lowIdx].starvationRounds++;
+      if (sessionStats_) {
+        sessionStats_->recordPriorityBandStarvation(uint8_t(lowIdx));
+      }
+    }
+  }
+  {
+    auto& bucket = urgencyBuckets_[serveIdx];
+    std::vector<Node*> nodes;
+    nodes.reserve(activeCount_);
+    for (auto& node : bucket) {
+      nodes.push_back(&node);
+    }
+    if (deadlineCount_ > 0 && nodes.size() > 1) {
+      // serve deadlined streams in the bucket earliest-deadline-first,
+      // keeping the round-robin order among deadline-free streams
+      std::stable_sort(nodes.begin(), nodes.end(), [](Node* a, Node* b) {
+        const auto& da = a->getEgressDeadline();
+        const auto& db = b->getEgressDeadline();
+        if (da.hasValue() != db.hasValue()) {
+          return da.hasValue();
+        }
+        return da.hasValue() && *da < *db;
+      });
+    }
+    const double share = 1.0 / nodes.size();
+    for (auto* node : nodes) {
+      result.emplace_back(node->getTransaction(), share);
+    }
+    if (result.size() > 1) {
+      // rotate so the stream served first doesn't stay first when the write
+      // window can't cover the whole bucket
+      Node& front = bucket.front();
+      bucket.pop_front();
+      bucket.push_back(front);
+    }
+    return;
+  }
+}
+
 void HTTP2PriorityQueue::iterateBFS(
     const std::function<bool(
         HTTP2PriorityQueue&, HTTPCodec::StreamID, HTTPTransaction*, double)>&
@@ -635,15 +821,24 @@ void HTTP2PriorityQueue::iterateBFS(
 }
 
 bool HTTP2PriorityQueue::nextEgressResult(HTTP2PriorityQueue& queue,
-                                          HTTPCodec::StreamID,
+                                          HTTPCodec::StreamID id,
                                           HTTPTransaction* txn,
                                           double r) {
   queue.nextEgressResults_->emplace_back(txn, r);
+  if (queue.nextEgressDeadlines_) {
+    Node* node = queue.find(id);
+    queue.nextEgressDeadlines_->emplace_back(
+        node ? node->getEffectiveEgressDeadline() : folly::none);
+  }
   return false;
 }
 
 void HTTP2PriorityQueue::nextEgress(
     HTTP2PriorityQueue::NextEgressResult& result, bool spdyMode) {
+  if (urgencyMode_) {
+    nextEgressUrgency(result);
+    return;
+  }
   struct WeightCmp {
     bool operator()(const std::pair<HTTPTransaction*, double>& t1,
                     const std::pair<HTTPTransaction*, double>& t2) {
@@ -653,6 +848,11 @@ void HTTP2PriorityQueue::nextEgress(
 
   result.reserve(activeCount_);
   nextEgressResults_ = &result;
+  std::vector<folly::Optional<TimePoint>> deadlines;
+  if (deadlineCount_ > 0) {
+    deadlines.reserve(activeCount_);
+    nextEgressDeadlines_ = &deadlines;
+  }
 
   updateEnqueuedWeight();
   Node::PendingList pendingNodes;
@@ -686,10 +886,40 @@ void HTTP2PriorityQueue::nextEgress(
     }
     std::swap(pendingNodes, pendingNodesTmp);
   } while (!stop && !pendingNodes.empty());
-  std::sort(result.begin(), result.end(), WeightCmp());
+  if (nextEgressDeadlines_) {
+    sortByWeightAndDeadline(result, deadlines);
+    nextEgressDeadlines_ = nullptr;
+  } else {
+    std::sort(result.begin(), result.end(), WeightCmp());
+  }
   nextEgressResults_ = nullptr;
 }
 
+void HTTP2PriorityQueue::sortByWeightAndDeadline(
+    NextEgressResult& result,
+    const std::vector<folly::Optional<TimePoint>>& deadlines) {
+  DCHECK_EQ(result.size(), deadlines.size());
+  std::vector<size_t> order(result.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    if (result[a].second != result[b].second) {
+      return result[a].second > result[b].second;
+    }
+    // earliest-deadline-first within a weight level; deadline-free
+    // streams sort last
+    if (deadlines[a].hasValue() != deadlines[b].hasValue()) {
+      return deadlines[a].hasValue();
+    }
+    return deadlines[a].hasValue() && *deadlines[a] < *deadlines[b];
+  });
+  NextEgressResult sorted;
+  sorted.reserve(result.size());
+  for (auto idx : order) {
+    sorted.emplace_back(result[idx]);
+  }
+  result.swap(sorted);
+}
+
 HTTP2PriorityQueue::Node* HTTP2PriorityQueue::find(HTTPCodec::StreamID id,
                                                    uint64_t* depth) {
   if (id == rootNodeId_) {
@@ -707,7 +937,8 @@ HTTP2PriorityQueue::Node* HTTP2PriorityQueue::find(HTTPCodec::StreamID id,
 
 void HTTP2PriorityQueue::updateEnqueuedWeight() {
 #ifndef NDEBUG
-  if (pendingWeightChange_) {
+  // urgency mode doesn't maintain the tree's enqueued weight aggregates
+  if (pendingWeightChange_ && !urgencyMode_) {
     root_.updateEnqueuedWeight(activeCount_ > 0);
     pendingWeightChange_ = false;
   }
@@ -12,14 +12,17 @@
 #include <folly/io/async/HHWheelTimer.h>
 #include <proxygen/lib/http/codec/HTTP2Framer.h>
 #include <proxygen/lib/http/codec/HTTPCodec.h>
+#include <proxygen/lib/utils/Time.h>
 #include <proxygen/lib/utils/WheelTimerInstance.h>
 
+#include <array>
 #include <deque>
 #include <list>
 #include <unordered_map>
 
 namespace proxygen {
 
+class HTTPSessionStats;
 class HTTPTransaction;
 
 class HTTP2PriorityQueueBase : public HTTPCodec::PriorityQueue {
@@ -58,6 +61,15 @@ class HTTP2PriorityQueueBase : public HTTPCodec::PriorityQueue {
   // Notify the queue when a transaction no longer has egress
   virtual void clearPendingEgress(Handle h) = 0;
 
+  // Optional egress deadline, used as an earliest-deadline-first tiebreak
+  // between streams of equal priority.  The default implementations ignore
+  // it for queues that don't support deadline scheduling
+  virtual void updateEgressDeadline(Handle /*h*/, TimePoint /*deadline*/) {
+  }
+
+  virtual void clearEgressDeadline(Handle /*h*/) {
+  }
+
   HTTPCodec::StreamID getRootId() {
     return rootNodeId_;
   }
@@ -73,6 +85,12 @@ class HTTP2PriorityQueue : public HTTP2PriorityQueueBase {
 
   static const size_t kNumBuckets = 100;
 
+  static const uint8_t kNumUrgencies = 8;
+
+  // The starvation guard stays quiet until this much egress has been
+  // accounted; shares are meaningless over a handful of packets
+  static const uint64_t kStarvationCheckFloor = 64 * 1024;
+
  public:
   HTTP2PriorityQueue(HTTPCodec::StreamID rootNodeId = 0)
       : HTTP2PriorityQueueBase(rootNodeId),
@@ -96,12 +114,92 @@ class HTTP2PriorityQueue : public HTTP2PriorityQueueBase {
     maxVirtualNodes_ = maxVirtualNodes;
   }
 
+  /**
+   * Switch the queue to RFC 9218 style urgency scheduling.  Every stream
+   * lives in one of eight urgency buckets with round-robin ordering inside
+   * each bucket, and nextEgress() serves the most urgent non-empty bucket in
+   * O(1) instead of walking the RFC 7540 dependency tree.  Stream
+   * dependencies are ignored; the wire weight is mapped onto an urgency so
+   * legacy PRIORITY frames still have a coarse effect.  Must be enabled
+   * while the queue is empty and cannot be turned off.
+   */
+  void enableUrgencyScheduling() {
+    CHECK(nodes_.empty());
+    CHECK_EQ(activeCount_, 0);
+    urgencyMode_ = true;
+  }
+
+  bool usingUrgencyScheduling() const {
+    return urgencyMode_;
+  }
+
+  // Move a stream to a new urgency bucket, e.g., on PRIORITY_UPDATE.  No-op
+  // for unknown streams
+  void updateUrgency(HTTPCodec::StreamID id, uint8_t urgency);
+
+  /**
+   * Per-band egress accounting.  A band is the urgency bucket in urgency
+   * mode; in dependency-tree mode streams are attributed to the band
+   * their weight maps to, so the counters mean the same thing under
+   * either scheduler.  Counters are plain per-session integers - one
+   * add per write batch and per dequeue - cheap enough to leave on.
+   */
+  struct BandEgressStats {
+    // achieved egress bytes
+    uint64_t bytes{0};
+    // cumulative time streams of this band spent with pending egress
+    uint64_t enqueuedMs{0};
+    // number of times a stream of this band drained its egress
+    uint64_t dequeues{0};
+    // rounds the starvation guard served this band out of order
+    uint64_t starvationRounds{0};
+  };
+
+  // Attribute bytes written for a stream to its band.  Unknown ids are
+  // ignored (e.g. the transaction detached mid-loop)
+  void recordEgressBytes(HTTPCodec::StreamID id, uint64_t bytes);
+
+  const BandEgressStats& getBandEgressStats(uint8_t band) const {
+    CHECK_LT(band, kNumUrgencies);
+    return bandStats_[band];
+  }
+
+  // Byte and starvation counters are also folded into the session stats
+  // sink when one is attached
+  void setSessionStats(HTTPSessionStats* stats) {
+    sessionStats_ = stats;
+  }
+
+  /**
+   * Starvation guard (urgency mode): when the least urgent non-empty
+   * band has received less than this share of accounted egress bytes,
+   * nextEgress() serves it ahead of more urgent bands for a round.
+   * Share is a fraction in [0, 1); 0 disables the guard.
+   */
+  void setMinimumLowBandShare(double share) {
+    CHECK_GE(share, 0);
+    CHECK_LT(share, 1);
+    minLowBandShare_ = share;
+  }
+
   // Notify the queue when a transaction has egress
   void signalPendingEgress(Handle h) override;
 
   // Notify the queue when a transaction no longer has egress
   void clearPendingEgress(Handle h) override;
 
+  /**
+   * Set the egress deadline for a stream.  Within a priority level,
+   * nextEgress() orders streams with earlier deadlines first
+   * (earliest-deadline-first); streams without a deadline sort after any
+   * stream that has one.  Deadlines are inherited: a stream competes with
+   * the earliest deadline found on itself or any of its ancestors, so
+   * urgent streams are not starved behind a deadline-free parent.
+   */
+  void updateEgressDeadline(Handle h, TimePoint deadline) override;
+
+  void clearEgressDeadline(Handle h) override;
+
   void addPriorityNode(HTTPCodec::StreamID id,
                        HTTPCodec::StreamID parent) override {
     addTransaction(id, {parent, false, 0}, nullptr, true);
@@ -210,6 +308,27 @@ class HTTP2PriorityQueue : public HTTP2PriorityQueueBase {
 
   void updateEnqueuedWeight();
 
+  // Coarse mapping from an RFC 7540 wire weight to an RFC 9218 urgency; each
+  // doubling of the effective weight raises the urgency level by one, so the
+  // default weight (16) lands on the default urgency (3)
+  static uint8_t urgencyFromWeight(uint8_t weight);
+
+  void setNodeUrgency(Node* node, uint8_t urgency);
+
+  void nextEgressUrgency(NextEgressResult& result);
+
+  // Band a node's egress is accounted under; see BandEgressStats
+  uint8_t nodeBand(const Node* node) const;
+
+  // Fold the node's time-in-queue into its band on dequeue
+  void recordDequeue(Node* node);
+
+  // Sort egress results by weight, breaking ties earliest-deadline-first.
+  // deadlines runs parallel to result
+  static void sortByWeightAndDeadline(
+      NextEgressResult& result,
+      const std::vector<folly::Optional<TimePoint>>& deadlines);
+
  private:
   typedef boost::intrusive::link_mode<boost::intrusive::auto_unlink> link_mode;
 
@@ -264,10 +383,54 @@ class HTTP2PriorityQueue : public HTTP2PriorityQueueBase {
 
     void clearPendingEgress();
 
+    // Urgency-mode enqueue bookkeeping: flip enqueued_ without touching the
+    // dependency tree aggregates.  The queue links nodes into its urgency
+    // buckets through enqueuedHook_, which the tree path does not use in
+    // that mode
+    void signalPendingEgressUrgent() {
+      enqueued_ = true;
+    }
+
+    void clearPendingEgressUrgent() {
+      CHECK(enqueued_);
+      enqueued_ = false;
+    }
+
+    uint8_t getUrgency() const {
+      return urgency_;
+    }
+
+    void setUrgency(uint8_t urgency) {
+      urgency_ = urgency;
+    }
+
     uint16_t getWeight() const {
       return weight_;
     }
 
+    void setEgressDeadline(TimePoint deadline) {
+      if (!egressDeadline_) {
+        queue_.deadlineCount_++;
+      }
+      egressDeadline_ = deadline;
+    }
+
+    void clearEgressDeadline() {
+      if (egressDeadline_) {
+        CHECK_GT(queue_.deadlineCount_, 0);
+        queue_.deadlineCount_--;
+        egressDeadline_.clear();
+      }
+    }
+
+    const folly::Optional<TimePoint>& getEgressDeadline() const {
+      return egressDeadline_;
+    }
+
+    // The earliest deadline on this node or any of its ancestors, i.e., the
+    // deadline this node competes with after inheritance
+    folly::Optional<TimePoint> getEffectiveEgressDeadline() const;
+
     // Set a new weight for this node
     void updateWeight(uint8_t weight);
 
@@ -357,6 +520,9 @@ class HTTP2PriorityQueue : public HTTP2PriorityQueueBase {
                                          Node* subtreeRoot);
 
    private:
+    // the queue links nodes into its urgency buckets via enqueuedHook_
+    friend class HTTP2PriorityQueue;
+
     Node* addChild(std::unique_ptr<Node> child);
 
     void addChildren(std::list<std::unique_ptr<Node>>&& children);
@@ -391,6 +557,11 @@ class HTTP2PriorityQueue : public HTTP2PriorityQueueBase {
     HTTPTransaction* txn_{nullptr};
     bool isPermanent_{false};
     bool enqueued_{false};
+    // urgency bucket index, only meaningful in urgency mode
+    uint8_t urgency_{3};
+    // when the node last gained pending egress, for band latency stats
+    TimePoint enqueuedSince_;
+    folly::Optional<TimePoint> egressDeadline_;
 #ifndef NDEBUG
     uint64_t totalEnqueuedWeightCheck_{0};
 #endif
@@ -416,9 +587,26 @@ class HTTP2PriorityQueue : public HTTP2PriorityQueueBase {
   uint32_t numVirtualNodes_{0};
   folly::Optional<HTTPCodec::StreamID> largestId_;
   bool pendingWeightChange_{false};
+  bool urgencyMode_{false};
+  // Number of nodes with an egress deadline set; the deadline-aware sort is
+  // bypassed entirely while this is zero
+  uint64_t deadlineCount_{0};
+  // Per-band egress accounting and the starvation guard's knobs
+  std::array<BandEgressStats, kNumUrgencies> bandStats_;
+  uint64_t totalAccountedBytes_{0};
+  double minLowBandShare_{0};
+  HTTPSessionStats* sessionStats_{nullptr};
+  // Per-urgency round-robin lists of enqueued nodes, only populated in
+  // urgency mode.  Nodes are linked through enqueuedHook_, which the
+  // dependency tree path does not use in that mode
+  std::array<folly::IntrusiveList<Node, &Node::enqueuedHook_>, kNumUrgencies>
+      urgencyBuckets_;
   WheelTimerInstance timeout_;
 
   NextEgressResult* nextEgressResults_{nullptr};
+  // Effective deadlines collected alongside nextEgressResults_, only
+  // populated when deadlineCount_ > 0
+  std::vector<folly::Optional<TimePoint>>* nextEgressDeadlines_{nullptr};
   static std::chrono::milliseconds kNodeLifetime_;
 };
 
@@ -8,6 +8,7 @@
 
 #include <proxygen/lib/http/session/HTTPDefaultSessionCodecFactory.h>
 
+#include <folly/String.h>
 #include <proxygen/lib/http/codec/HTTP1xCodec.h>
 #include <proxygen/lib/http/codec/HTTP2Codec.h>
 #include <proxygen/lib/http/codec/HTTP2Constants.h>
@@ -15,6 +16,32 @@
 
 namespace proxygen {
 
+namespace {
+
+// Per-thread pools of recycled HTTP/2 codecs, split by direction.
+// Bounded so a burst of teardowns doesn't pin memory forever.
+constexpr size_t kMaxPooledCodecsPerDirection = 64;
+
+thread_local std::vector<std::unique_ptr<HTTP2Codec>> pooledHTTP2Codecs[2];
+
+std::vector<std::unique_ptr<HTTP2Codec>>& codecPool(
+    TransportDirection direction) {
+  return pooledHTTP2Codecs[direction == TransportDirection::DOWNSTREAM ? 0
+                                                                       : 1];
+}
+
+std::unique_ptr<HTTPCodec> makeHTTP2Codec(TransportDirection direction) {
+  auto& pool = codecPool(direction);
+  if (!pool.empty()) {
+    auto codec = std::move(pool.back());
+    pool.pop_back();
+    return codec;
+  }
+  return std::make_unique<HTTP2Codec>(direction);
+}
+
+} // namespace
+
 HTTPDefaultSessionCodecFactory::HTTPDefaultSessionCodecFactory(
     const AcceptorConfiguration& accConfig)
     : accConfig_(accConfig) {
@@ -25,6 +52,41 @@ HTTPDefaultSessionCodecFactory::HTTPDefaultSessionCodecFactory(
   } else if (accConfig.plaintextProtocol == http2::kProtocolCleartextString) {
     alwaysUseHTTP2_ = true;
   }
+  plaintextUpgradeProtocols_ =
+      folly::join(',', accConfig.allowedPlaintextUpgradeProtocols);
+}
+
+HTTPDefaultSessionCodecFactory::NextProtocol
+HTTPDefaultSessionCodecFactory::classifyNextProtocol(
+    const std::string& nextProtocol) {
+  // Switching on the length first narrows the candidates so every token
+  // we recognize resolves with at most two full comparisons.
+  switch (nextProtocol.size()) {
+    case 0:
+      // No negotiated protocol: default to HTTP/1.x
+      return NextProtocol::HTTP_1_X;
+    case 2:
+      return nextProtocol == http2::kProtocolString ? NextProtocol::HTTP_2
+                                                    : NextProtocol::UNKNOWN;
+    case 5:
+      return (nextProtocol == http2::kProtocolDraftString ||
+              nextProtocol == http2::kProtocolExperimentalString)
+                 ? NextProtocol::HTTP_2
+                 : NextProtocol::UNKNOWN;
+    case 6:
+      return nextProtocol == "spdy/3" ? NextProtocol::SPDY_3
+                                      : NextProtocol::UNKNOWN;
+    case 8:
+      if (nextProtocol == "spdy/3.1") {
+        return NextProtocol::SPDY_3_1;
+      }
+      if (nextProtocol == "http/1.1" || nextProtocol == "http/1.0") {
+        return NextProtocol::HTTP_1_X;
+      }
+      return NextProtocol::UNKNOWN;
+    default:
+      return NextProtocol::UNKNOWN;
+  }
 }
 
 std::unique_ptr<HTTPCodec> HTTPDefaultSessionCodecFactory::getCodec(
@@ -34,27 +96,48 @@ std::unique_ptr<HTTPCodec> HTTPDefaultSessionCodecFactory::getCodec(
                                        alwaysUseSPDYVersion_.value(),
                                        accConfig_.spdyCompressionLevel);
   } else if (!isTLS && alwaysUseHTTP2_) {
-    return std::make_unique<HTTP2Codec>(direction);
-  } else if (nextProtocol.empty() ||
-             HTTP1xCodec::supportsNextProtocol(nextProtocol)) {
-    auto codec = std::make_unique<HTTP1xCodec>(direction,
-                                               accConfig_.forceHTTP1_0_to_1_1);
-    if (!isTLS) {
-      codec->setAllowedUpgradeProtocols(
-          accConfig_.allowedPlaintextUpgradeProtocols);
+    return makeHTTP2Codec(direction);
+  }
+
+  switch (classifyNextProtocol(nextProtocol)) {
+    case NextProtocol::HTTP_1_X: {
+      auto codec = std::make_unique<HTTP1xCodec>(
+          direction, accConfig_.forceHTTP1_0_to_1_1);
+      if (!isTLS && !plaintextUpgradeProtocols_.empty()) {
+        codec->setAllowedUpgradeProtocolsJoined(plaintextUpgradeProtocols_);
+      }
+      return codec;
     }
-    return codec;
-  } else if (auto version = SPDYCodec::getVersion(nextProtocol)) {
-    return std::make_unique<SPDYCodec>(
-        direction, *version, accConfig_.spdyCompressionLevel);
-  } else if (nextProtocol == http2::kProtocolString ||
-             nextProtocol == http2::kProtocolDraftString ||
-             nextProtocol == http2::kProtocolExperimentalString) {
-    return std::make_unique<HTTP2Codec>(direction);
-  } else {
-    VLOG(2) << "Client requested unrecognized next protocol " << nextProtocol;
+    case NextProtocol::SPDY_3:
+      return std::make_unique<SPDYCodec>(
+          direction, SPDYVersion::SPDY3, accConfig_.spdyCompressionLevel);
+    case NextProtocol::SPDY_3_1:
+      return std::make_unique<SPDYCodec>(
+          direction, SPDYVersion::SPDY3_1, accConfig_.spdyCompressionLevel);
+    case NextProtocol::HTTP_2:
+      return makeHTTP2Codec(direction);
+    case NextProtocol::UNKNOWN:
+      VLOG(2) << "Client requested unrecognized next protocol " << nextProtocol;
+      break;
   }
 
   return nullptr;
 }
+
+void HTTPDefaultSessionCodecFactory::recycleCodec(
+    std::unique_ptr<HTTPCodec> codec) {
+  if (!codec || !codec->reset()) {
+    // This codec type does not support instance reuse
+    return;
+  }
+  auto* http2Codec = dynamic_cast<HTTP2Codec*>(codec.get());
+  if (!http2Codec) {
+    return;
+  }
+  auto& pool = codecPool(http2Codec->getTransportDirection());
+  if (pool.size() < kMaxPooledCodecsPerDirection) {
+    codec.release();
+    pool.emplace_back(http2Codec);
+  }
+}
 } // namespace proxygen
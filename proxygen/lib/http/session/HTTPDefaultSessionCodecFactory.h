@@ -21,6 +21,25 @@ class HTTPDefaultSessionCodecFactory : public HTTPCodecFactory {
   ~HTTPDefaultSessionCodecFactory() override {
   }
 
+  /**
+   * Protocols this factory can instantiate from a negotiated next-protocol
+   * string.  HTTP_1_X also stands in for "no protocol negotiated".
+   */
+  enum class NextProtocol : uint8_t {
+    HTTP_1_X,
+    SPDY_3,
+    SPDY_3_1,
+    HTTP_2,
+    UNKNOWN,
+  };
+
+  /**
+   * Resolve an ALPN/NPN token with a single switch on its length plus at
+   * most two string comparisons, instead of walking every candidate
+   * protocol per accepted connection.
+   */
+  static NextProtocol classifyNextProtocol(const std::string& nextProtocol);
+
   /**
    * Get a codec instance
    */
@@ -28,10 +47,23 @@ class HTTPDefaultSessionCodecFactory : public HTTPCodecFactory {
                                       TransportDirection direction,
                                       bool isTLS) override;
 
+  /**
+   * Offer a codec back for reuse once its connection is done. If the
+   * codec supports HTTPCodec::reset() it is returned to a per-thread
+   * pool and a later getCodec() on the same thread hands it out again,
+   * skipping construction (HPACK tables, settings) on the accept path;
+   * otherwise it is simply destroyed. The caller must be done with the
+   * codec and must recycle it on the thread that uses this factory.
+   */
+  static void recycleCodec(std::unique_ptr<HTTPCodec> codec);
+
  protected:
   const AcceptorConfiguration& accConfig_;
   folly::Optional<SPDYVersion> alwaysUseSPDYVersion_{};
   folly::Optional<bool> alwaysUseHTTP2_{};
+  // allowedPlaintextUpgradeProtocols joined once at construction so
+  // plaintext HTTP/1.x codecs don't re-join the list per connection
+  std::string plaintextUpgradeProtocols_;
 };
 
 } // namespace proxygen
@@ -9,12 +9,75 @@
 #include <proxygen/lib/http/session/HTTPDirectResponseHandler.h>
 
 #include <folly/Conv.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
 #include <proxygen/lib/http/session/HTTPErrorPage.h>
 
 using folly::IOBuf;
 using std::string;
 using std::unique_ptr;
 
+namespace {
+
+// A response built once and replayed: the message's headers live in an
+// immutable shared block (see HTTPMessage::cloneShallow), so handing a
+// copy to sendHeaders costs no header construction, and the body is a
+// clone source.
+struct PrebuiltResponse {
+  proxygen::HTTPMessage msg;
+  std::unique_ptr<folly::IOBuf> body;
+};
+
+// Pre-built error responses keyed by (status, message, error page,
+// close).  Attack mitigation repeats a handful of combinations millions
+// of times per minute, so the map is effectively read-only after the
+// first occurrence of each.
+folly::Synchronized<
+    folly::F14FastMap<std::string, std::shared_ptr<const PrebuiltResponse>>>&
+prebuiltResponses() {
+  static folly::Synchronized<
+      folly::F14FastMap<std::string, std::shared_ptr<const PrebuiltResponse>>>
+      cache;
+  return cache;
+}
+
+PrebuiltResponse buildResponse(unsigned statusCode,
+                               const std::string& statusMessage,
+                               const proxygen::HTTPErrorPage* errorPage,
+                               bool forceConnectionClose,
+                               folly::StringPiece acceptEncoding = {}) {
+  using namespace proxygen;
+  PrebuiltResponse response;
+  response.msg.setHTTPVersion(1, 1);
+  response.msg.setStatusCode(statusCode);
+  if (!statusMessage.empty()) {
+    response.msg.setStatusMessage(statusMessage);
+  } else {
+    response.msg.setStatusMessage(HTTPMessage::getDefaultReason(statusCode));
+  }
+  if (forceConnectionClose) {
+    response.msg.getHeaders().add(HTTP_HEADER_CONNECTION, "close");
+  }
+  if (errorPage) {
+    HTTPErrorPage::Page page = errorPage->generateFor(
+        0, statusCode, statusMessage, nullptr, empty_string, acceptEncoding);
+    VLOG(4) << "sending error page with type " << page.contentType;
+    response.msg.getHeaders().add(HTTP_HEADER_CONTENT_TYPE, page.contentType);
+    if (!page.contentEncoding.empty()) {
+      response.msg.getHeaders().add(HTTP_HEADER_CONTENT_ENCODING,
+                                    page.contentEncoding);
+    }
+    response.body = std::move(page.content);
+  }
+  response.msg.getHeaders().add(
+      HTTP_HEADER_CONTENT_LENGTH,
+      folly::to<string>(
+          response.body ? response.body->computeChainDataLength() : 0));
+  return response;
+}
+
+} // namespace
+
 namespace proxygen {
 
 HTTPDirectResponseHandler::HTTPDirectResponseHandler(
@@ -42,35 +105,59 @@ void HTTPDirectResponseHandler::detachTransaction() noexcept {
 }
 
 void HTTPDirectResponseHandler::onHeadersComplete(
-    std::unique_ptr<HTTPMessage> /*msg*/) noexcept {
+    std::unique_ptr<HTTPMessage> msg) noexcept {
   VLOG(4) << "processing request";
   headersSent_ = true;
-  HTTPMessage response;
-  std::unique_ptr<folly::IOBuf> responseBody;
-  response.setHTTPVersion(1, 1);
-  response.setStatusCode(statusCode_);
-  if (!statusMessage_.empty()) {
-    response.setStatusMessage(statusMessage_);
-  } else {
-    response.setStatusMessage(HTTPMessage::getDefaultReason(statusCode_));
+  if (errorPage_ && !errorPage_->isStatic()) {
+    // dynamic error pages render per request; no pre-building possible,
+    // but generators with pre-compressed variants (HTTPStoreErrorPage)
+    // can serve the client's preferred content-coding
+    std::string acceptEncoding;
+    if (msg) {
+      acceptEncoding =
+          msg->getHeaders().getSingleOrEmpty(HTTP_HEADER_ACCEPT_ENCODING);
+    }
+    auto response = buildResponse(statusCode_,
+                                  statusMessage_,
+                                  errorPage_,
+                                  forceConnectionClose_,
+                                  acceptEncoding);
+    txn_->sendHeaders(response.msg);
+    if (response.body) {
+      txn_->sendBody(std::move(response.body));
+    }
+    return;
   }
-  if (forceConnectionClose_) {
-    response.getHeaders().add(HTTP_HEADER_CONNECTION, "close");
+  auto key = folly::to<string>(statusCode_,
+                               '|',
+                               statusMessage_,
+                               '|',
+                               reinterpret_cast<uintptr_t>(errorPage_),
+                               '|',
+                               forceConnectionClose_);
+  std::shared_ptr<const PrebuiltResponse> prebuilt;
+  {
+    auto cache = prebuiltResponses().rlock();
+    auto it = cache->find(key);
+    if (it != cache->end()) {
+      prebuilt = it->second;
+    }
   }
-  if (errorPage_) {
-    HTTPErrorPage::Page page = errorPage_->generate(
-        0, statusCode_, statusMessage_, nullptr, empty_string);
-    VLOG(4) << "sending error page with type " << page.contentType;
-    response.getHeaders().add(HTTP_HEADER_CONTENT_TYPE, page.contentType);
-    responseBody = std::move(page.content);
+  if (!prebuilt) {
+    auto built = std::make_shared<PrebuiltResponse>(buildResponse(
+        statusCode_, statusMessage_, errorPage_, forceConnectionClose_));
+    // freeze the headers into a shared block so every replayed copy
+    // shares them
+    built->msg = built->msg.cloneShallow();
+    prebuiltResponses().wlock()->emplace(std::move(key), built);
+    prebuilt = built;
   }
-  response.getHeaders().add(
-      HTTP_HEADER_CONTENT_LENGTH,
-      folly::to<string>(responseBody ? responseBody->computeChainDataLength()
-                                     : 0));
+  // The copy shares the frozen header block; the codec stamps Date at
+  // serialization time, so no per-occurrence patching is needed.
+  HTTPMessage response = prebuilt->msg;
   txn_->sendHeaders(response);
-  if (responseBody) {
-    txn_->sendBody(std::move(responseBody));
+  if (prebuilt->body) {
+    txn_->sendBody(prebuilt->body->clone());
   }
 }
 
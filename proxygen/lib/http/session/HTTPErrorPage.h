@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <folly/Range.h>
 #include <memory>
 #include <string>
 
@@ -25,15 +26,22 @@ class HTTPErrorPage {
  public:
   struct Page {
     Page(const std::string& pageContentType,
-         std::unique_ptr<folly::IOBuf> pageContent)
-        : contentType(pageContentType), content(std::move(pageContent)) {
+         std::unique_ptr<folly::IOBuf> pageContent,
+         const std::string& pageContentEncoding = std::string())
+        : contentType(pageContentType),
+          contentEncoding(pageContentEncoding),
+          content(std::move(pageContent)) {
     }
 
     Page(Page&& other) noexcept
-        : contentType(other.contentType), content(std::move(other.content)) {
+        : contentType(other.contentType),
+          contentEncoding(other.contentEncoding),
+          content(std::move(other.content)) {
     }
 
     const std::string contentType;
+    // content-coding of content; empty for identity
+    const std::string contentEncoding;
     std::unique_ptr<folly::IOBuf> content;
   };
 
@@ -45,6 +53,31 @@ class HTTPErrorPage {
                         const std::string& reason,
                         std::unique_ptr<folly::IOBuf> body,
                         const std::string& detailReason) const = 0;
+
+  /**
+   * Variant of generate() for callers that know the client's
+   * Accept-Encoding.  Generators with pre-compressed content may return
+   * it with the matching contentEncoding set; the default ignores the
+   * header and serves identity.
+   */
+  virtual Page generateFor(uint64_t requestID,
+                           unsigned httpStatusCode,
+                           const std::string& reason,
+                           std::unique_ptr<folly::IOBuf> body,
+                           const std::string& detailReason,
+                           folly::StringPiece /*acceptEncoding*/) const {
+    return generate(requestID, httpStatusCode, reason, std::move(body),
+                    detailReason);
+  }
+
+  /**
+   * True if generate() always returns the same content for a given
+   * status code, regardless of the request.  Static pages can have their
+   * responses pre-built and reused; see HTTPDirectResponseHandler.
+   */
+  virtual bool isStatic() const {
+    return false;
+  }
 };
 
 /**
@@ -62,6 +95,10 @@ class HTTPStaticErrorPage : public HTTPErrorPage {
                 std::unique_ptr<folly::IOBuf> body,
                 const std::string& detailReason) const override;
 
+  bool isStatic() const override {
+    return true;
+  }
+
  private:
   std::unique_ptr<folly::IOBuf> content_;
   std::string contentType_;
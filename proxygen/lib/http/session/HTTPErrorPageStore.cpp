@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/http/session/HTTPErrorPageStore.h>
+
+#include <folly/io/IOBuf.h>
+#include <proxygen/lib/http/RFC2616.h>
+#include <proxygen/lib/utils/ZlibStreamCompressor.h>
+#include <proxygen/lib/utils/ZstdStreamCompressor.h>
+
+namespace {
+
+constexpr int kGzipLevel = 6;
+constexpr int kZstdLevel = 8;
+
+// keep a compressed form only when it actually shrinks the page
+std::unique_ptr<folly::IOBuf> keepIfSmaller(
+    std::unique_ptr<folly::IOBuf> compressed, size_t identitySize) {
+  if (!compressed || compressed->computeChainDataLength() >= identitySize) {
+    return nullptr;
+  }
+  return compressed;
+}
+
+} // namespace
+
+namespace proxygen {
+
+HTTPErrorPageStore& HTTPErrorPageStore::getInstance() {
+  static HTTPErrorPageStore instance;
+  return instance;
+}
+
+void HTTPErrorPageStore::setPages(std::vector<PageContent> pages) {
+  auto next = std::make_shared<Snapshot>();
+  for (auto& page : pages) {
+    if (!page.content) {
+      continue;
+    }
+    auto rendered = std::make_shared<RenderedPage>();
+    rendered->contentType = std::move(page.contentType);
+    const auto identitySize = page.content->computeChainDataLength();
+
+    ZlibStreamCompressor gzip(CompressionType::GZIP, kGzipLevel);
+    rendered->gzip =
+        keepIfSmaller(gzip.compress(page.content.get(), true), identitySize);
+    if (gzip.hasError()) {
+      rendered->gzip.reset();
+    }
+    ZstdStreamCompressor zstd(kZstdLevel);
+    rendered->zstd =
+        keepIfSmaller(zstd.compress(page.content.get(), true), identitySize);
+    if (zstd.hasError()) {
+      rendered->zstd.reset();
+    }
+    rendered->identity = std::move(page.content);
+    next->pages[page.statusCode] = std::move(rendered);
+  }
+
+  std::lock_guard<std::mutex> guard(writeLock_);
+  auto current = snapshot_.load(std::memory_order_acquire);
+  next->version = (current ? current->version : 0) + 1;
+  snapshot_.store(std::move(next), std::memory_order_release);
+}
+
+std::shared_ptr<const HTTPErrorPageStore::RenderedPage>
+HTTPErrorPageStore::getPage(unsigned statusCode) const {
+  auto snapshot = snapshot_.load(std::memory_order_acquire);
+  if (!snapshot) {
+    return nullptr;
+  }
+  auto it = snapshot->pages.find(statusCode);
+  if (it == snapshot->pages.end()) {
+    it = snapshot->pages.find(0);
+    if (it == snapshot->pages.end()) {
+      return nullptr;
+    }
+  }
+  return it->second;
+}
+
+uint64_t HTTPErrorPageStore::getVersion() const {
+  auto snapshot = snapshot_.load(std::memory_order_acquire);
+  return snapshot ? snapshot->version : 0;
+}
+
+std::pair<folly::StringPiece, const folly::IOBuf*>
+HTTPErrorPageStore::selectVariant(const RenderedPage& page,
+                                  folly::StringPiece acceptEncoding) {
+  if (!acceptEncoding.empty() && (page.zstd || page.gzip)) {
+    RFC2616::TokenPairVec encodings;
+    RFC2616::parseQvalues(acceptEncoding, encodings);
+    bool acceptsGzip = false;
+    bool acceptsZstd = false;
+    for (const auto& encoding : encodings) {
+      if (encoding.second <= 0) {
+        continue;
+      }
+      auto token = encoding.first;
+      acceptsGzip |= token.compare(folly::StringPiece("gzip")) == 0;
+      acceptsZstd |= token.compare(folly::StringPiece("zstd")) == 0;
+    }
+    // prefer the smaller of the admissible pre-compressed forms
+    const folly::IOBuf* best = nullptr;
+    folly::StringPiece coding;
+    if (acceptsGzip && page.gzip) {
+      best = page.gzip.get();
+      coding = "gzip";
+    }
+    if (acceptsZstd && page.zstd &&
+        (!best || page.zstd->computeChainDataLength() <
+                      best->computeChainDataLength())) {
+      best = page.zstd.get();
+      coding = "zstd";
+    }
+    if (best) {
+      return {coding, best};
+    }
+  }
+  return {folly::StringPiece(), page.identity.get()};
+}
+
+HTTPErrorPage::Page HTTPStoreErrorPage::generate(
+    uint64_t /*requestID*/,
+    unsigned httpStatusCode,
+    const std::string& /*reason*/,
+    std::unique_ptr<folly::IOBuf> /*body*/,
+    const std::string& /*detailReason*/) const {
+  auto page = store_.getPage(httpStatusCode);
+  if (!page) {
+    return Page(std::string(), nullptr);
+  }
+  return Page(page->contentType, page->identity->clone());
+}
+
+HTTPErrorPage::Page HTTPStoreErrorPage::generateFor(
+    uint64_t /*requestID*/,
+    unsigned httpStatusCode,
+    const std::string& /*reason*/,
+    std::unique_ptr<folly::IOBuf> /*body*/,
+    const std::string& /*detailReason*/,
+    folly::StringPiece acceptEncoding) const {
+  auto page = store_.getPage(httpStatusCode);
+  if (!page) {
+    return Page(std::string(), nullptr);
+  }
+  auto variant = HTTPErrorPageStore::selectVariant(*page, acceptEncoding);
+  return Page(
+      page->contentType, variant.second->clone(), variant.first.str());
+}
+
+} // namespace proxygen
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/concurrency/AtomicSharedPtr.h>
+#include <folly/container/F14Map.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <proxygen/lib/http/session/HTTPErrorPage.h>
+
+namespace folly {
+class IOBuf;
+}
+
+namespace proxygen {
+
+/**
+ * Process-wide immutable store of pre-rendered error pages, shared by
+ * every acceptor by reference.
+ *
+ * Each page is rendered once per publish: the identity body plus
+ * pre-compressed gzip and zstd forms (kept only when actually smaller),
+ * so serving an error to an Accept-Encoding client is a buffer clone
+ * with no per-response compression.  Readers resolve against the
+ * current snapshot with a single atomic load; setPages() builds the
+ * replacement off to the side and publishes it with a pointer swap, so
+ * branded pages hot-reload without a restart and without pausing
+ * accepts.  In-flight responses keep the snapshot they resolved until
+ * their buffers are handed to the transport.
+ */
+class HTTPErrorPageStore {
+ public:
+  struct PageContent {
+    unsigned statusCode{0}; // 0 is the catch-all default page
+    std::string contentType;
+    std::unique_ptr<folly::IOBuf> content;
+  };
+
+  struct RenderedPage {
+    std::string contentType;
+    std::unique_ptr<folly::IOBuf> identity;
+    // null when compression did not shrink the page
+    std::unique_ptr<folly::IOBuf> gzip;
+    std::unique_ptr<folly::IOBuf> zstd;
+  };
+
+  static HTTPErrorPageStore& getInstance();
+
+  /**
+   * Replace the page set wholesale; pre-renders and pre-compresses off
+   * the hot path, then publishes atomically.  Safe to call while pages
+   * are being served.
+   */
+  void setPages(std::vector<PageContent> pages);
+
+  /**
+   * Page for a status code, falling back to the default (statusCode 0)
+   * entry; nullptr when neither exists.  The returned pointer keeps its
+   * snapshot alive across concurrent reloads.
+   */
+  std::shared_ptr<const RenderedPage> getPage(unsigned statusCode) const;
+
+  /**
+   * Monotonic snapshot version; bumps on every setPages().
+   */
+  uint64_t getVersion() const;
+
+  /**
+   * Pick the smallest variant the client's Accept-Encoding admits.
+   * Returns the content-coding name ("" for identity) and the shared
+   * buffer to clone.
+   */
+  static std::pair<folly::StringPiece, const folly::IOBuf*> selectVariant(
+      const RenderedPage& page, folly::StringPiece acceptEncoding);
+
+ private:
+  struct Snapshot {
+    uint64_t version{0};
+    folly::F14FastMap<unsigned, std::shared_ptr<const RenderedPage>> pages;
+  };
+
+  folly::atomic_shared_ptr<const Snapshot> snapshot_;
+  // serializes publishers only; readers never touch it
+  std::mutex writeLock_;
+};
+
+/**
+ * HTTPErrorPage adapter over the shared store: acceptors holding one of
+ * these serve whatever the store currently publishes, so a reload
+ * reaches every acceptor at once.  Deliberately not isStatic() --
+ * response caches keyed on the page would pin pre-reload content.
+ */
+class HTTPStoreErrorPage : public HTTPErrorPage {
+ public:
+  explicit HTTPStoreErrorPage(HTTPErrorPageStore& store =
+                                  HTTPErrorPageStore::getInstance())
+      : store_(store) {
+  }
+
+  Page generate(uint64_t requestID,
+                unsigned httpStatusCode,
+                const std::string& reason,
+                std::unique_ptr<folly::IOBuf> body,
+                const std::string& detailReason) const override;
+
+  Page generateFor(uint64_t requestID,
+                   unsigned httpStatusCode,
+                   const std::string& reason,
+                   std::unique_ptr<folly::IOBuf> body,
+                   const std::string& detailReason,
+                   folly::StringPiece acceptEncoding) const override;
+
+ private:
+  HTTPErrorPageStore& store_;
+};
+
+} // namespace proxygen
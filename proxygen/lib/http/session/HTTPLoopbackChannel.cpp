@@ -0,0 +1,428 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "proxygen/lib/http/session/HTTPLoopbackChannel.h"
+
+#include <proxygen/lib/http/codec/HTTP2Codec.h>
+
+namespace {
+// Body bytes handed to each transaction per onWriteReady call.  Delivery
+// is pointer-wise, so this only bounds how much one transaction can move
+// before the priority queue is consulted again.
+const uint32_t kLoopbackWriteSize = 64 * 1024;
+} // namespace
+
+namespace proxygen {
+
+std::unique_ptr<HTTPLoopbackChannel> HTTPLoopbackChannel::create(
+    folly::EventBase* evb,
+    folly::HHWheelTimer* timer,
+    HTTPTransaction::Handler* clientHandler,
+    HTTPTransaction::Handler* serverHandler,
+    Params params) {
+  std::unique_ptr<HTTPLoopbackChannel> channel(new HTTPLoopbackChannel(evb));
+  channel->client_.init(&channel->server_, timer, params, clientHandler);
+  channel->server_.init(&channel->client_, timer, params, serverHandler);
+  return channel;
+}
+
+HTTPLoopbackChannel::HTTPLoopbackChannel(folly::EventBase* evb)
+    : evb_(CHECK_NOTNULL(evb)),
+      client_(*this, TransportDirection::UPSTREAM),
+      server_(*this, TransportDirection::DOWNSTREAM) {
+}
+
+HTTPLoopbackChannel::~HTTPLoopbackChannel() {
+  if (isLoopCallbackScheduled()) {
+    cancelLoopCallback();
+  }
+  // Destroying a live channel aborts the exchange
+  client_.dropWithError(kErrorShutdown);
+  server_.dropWithError(kErrorShutdown);
+}
+
+void HTTPLoopbackChannel::scheduleLoop() {
+  if (!isLoopCallbackScheduled()) {
+    evb_->runInLoop(this);
+  }
+}
+
+void HTTPLoopbackChannel::runLoopCallback() noexcept {
+  // Ingress first: delivering queued events may open send windows or
+  // invoke handlers that generate the egress drained below.
+  client_.deliverPendingIngress();
+  server_.deliverPendingIngress();
+  client_.driveEgress();
+  server_.driveEgress();
+  if (isComplete() && completionCallback_) {
+    // The callback may destroy the channel; detach it first
+    auto callback = std::move(completionCallback_);
+    callback();
+  }
+}
+
+void HTTPLoopbackChannel::endDetached() {
+  if (isComplete() && completionCallback_) {
+    // Fire the completion callback from the loop callback so it never
+    // runs inside a handler's call stack
+    scheduleLoop();
+  }
+}
+
+// HTTPLoopbackChannel::End
+
+HTTPLoopbackChannel::End::End(HTTPLoopbackChannel& channel,
+                              TransportDirection direction)
+    : channel_(channel), direction_(direction) {
+}
+
+void HTTPLoopbackChannel::End::init(End* peer,
+                                    folly::HHWheelTimer* timer,
+                                    const Params& params,
+                                    HTTPTransaction::Handler* handler) {
+  peer_ = peer;
+  flowControlEnabled_ = params.useFlowControl;
+  txn_ = std::make_unique<HTTPTransaction>(direction_,
+                                           HTTPCodec::StreamID(1),
+                                           0 /* seqNo */,
+                                           *this,
+                                           egressQueue_,
+                                           timer,
+                                           params.transactionIdleTimeout,
+                                           params.stats,
+                                           params.useFlowControl,
+                                           params.receiveInitialWindowSize,
+                                           params.sendInitialWindowSize);
+  txn_->setHandler(CHECK_NOTNULL(handler));
+  handler->setTransaction(txn_.get());
+}
+
+void HTTPLoopbackChannel::End::deliverPendingIngress() {
+  while (txn_ && !pendingIngress_.empty()) {
+    auto event = std::move(pendingIngress_.front());
+    pendingIngress_.pop_front();
+    deliver(event);
+  }
+  if (!txn_) {
+    pendingIngress_.clear();
+  }
+}
+
+void HTTPLoopbackChannel::End::deliver(IngressEvent& event) {
+  switch (event.type) {
+    case IngressEvent::Type::HEADERS:
+      txn_->onIngressHeadersComplete(std::move(event.headers));
+      break;
+    case IngressEvent::Type::BODY:
+      txn_->onIngressBody(std::move(event.body), 0 /* padding */);
+      break;
+    case IngressEvent::Type::TRAILERS:
+      txn_->onIngressTrailers(std::move(event.trailers));
+      break;
+    case IngressEvent::Type::EOM:
+      txn_->onIngressEOM();
+      break;
+    case IngressEvent::Type::ABORT: {
+      HTTPException ex(
+          HTTPException::Direction::INGRESS_AND_EGRESS,
+          folly::to<std::string>("Loopback peer aborted, statusCode=",
+                                 getErrorCodeString(event.error)));
+      ex.setProxygenError(kErrorStreamAbort);
+      ex.setCodecStatusCode(event.error);
+      txn_->onError(ex);
+      break;
+    }
+    case IngressEvent::Type::WINDOW_UPDATE:
+      txn_->onIngressWindowUpdate(event.windowBytes);
+      break;
+  }
+}
+
+void HTTPLoopbackChannel::End::driveEgress() {
+  // Transactions dequeue themselves when they run out of deferred body,
+  // get egress paused, or exhaust their send window, so this drains to
+  // quiescence.
+  while (txn_ && !egressQueue_.empty()) {
+    HTTP2PriorityQueue::NextEgressResult nextEgressResults;
+    egressQueue_.nextEgress(nextEgressResults);
+    for (auto& txnPair : nextEgressResults) {
+      txnPair.first->onWriteReady(kLoopbackWriteSize, txnPair.second);
+    }
+  }
+}
+
+void HTTPLoopbackChannel::End::dropWithError(ProxygenError err) {
+  pendingIngress_.clear();
+  if (txn_) {
+    HTTPException ex(HTTPException::Direction::INGRESS_AND_EGRESS,
+                     folly::to<std::string>("Loopback channel dropped: ",
+                                            getErrorString(err)));
+    ex.setProxygenError(err);
+    txn_->onError(ex);
+  }
+}
+
+void HTTPLoopbackChannel::End::enqueueToPeer(IngressEvent event) {
+  if (!peer_ || !peer_->txn_) {
+    // Peer already finished; nothing to deliver to
+    return;
+  }
+  peer_->pendingIngress_.push_back(std::move(event));
+  channel_.scheduleLoop();
+}
+
+void HTTPLoopbackChannel::End::pauseIngress(HTTPTransaction*) noexcept {
+  // Nothing to stop reading from; the transaction buffers paused ingress
+  // itself, bounded by the peer's send window when flow control is on.
+}
+
+void HTTPLoopbackChannel::End::resumeIngress(HTTPTransaction*) noexcept {
+}
+
+void HTTPLoopbackChannel::End::transactionTimeout(
+    HTTPTransaction* txn) noexcept {
+  // Same as socket-backed sessions: let the transaction tell its
+  // handler, which decides whether to abort (propagated to the peer via
+  // sendAbort).
+  txn->onIngressTimeout();
+}
+
+void HTTPLoopbackChannel::End::sendHeaders(HTTPTransaction* /*txn*/,
+                                           const HTTPMessage& headers,
+                                           HTTPHeaderSize* size,
+                                           bool eom) noexcept {
+  if (size) {
+    // Nothing is encoded; report zero wire size
+    *size = HTTPHeaderSize();
+  }
+  IngressEvent event;
+  event.type = IngressEvent::Type::HEADERS;
+  event.headers = std::make_unique<HTTPMessage>(headers);
+  enqueueToPeer(std::move(event));
+  if (eom) {
+    IngressEvent eomEvent;
+    eomEvent.type = IngressEvent::Type::EOM;
+    enqueueToPeer(std::move(eomEvent));
+  }
+}
+
+size_t HTTPLoopbackChannel::End::sendBody(
+    HTTPTransaction* /*txn*/,
+    std::unique_ptr<folly::IOBuf> body,
+    bool eom,
+    bool /*trackLastByteFlushed*/) noexcept {
+  size_t bodyLen = body ? body->computeChainDataLength() : 0;
+  if (bodyLen > 0) {
+    IngressEvent event;
+    event.type = IngressEvent::Type::BODY;
+    event.body = std::move(body);
+    enqueueToPeer(std::move(event));
+  }
+  if (eom) {
+    IngressEvent eomEvent;
+    eomEvent.type = IngressEvent::Type::EOM;
+    enqueueToPeer(std::move(eomEvent));
+  }
+  return bodyLen;
+}
+
+size_t HTTPLoopbackChannel::End::sendChunkHeader(HTTPTransaction*,
+                                                 size_t) noexcept {
+  // Chunk framing has no wire representation here; body lengths are
+  // preserved by the IOBuf chains themselves
+  return 0;
+}
+
+size_t HTTPLoopbackChannel::End::sendChunkTerminator(
+    HTTPTransaction*) noexcept {
+  return 0;
+}
+
+size_t HTTPLoopbackChannel::End::sendEOM(HTTPTransaction* /*txn*/,
+                                         const HTTPHeaders* trailers) noexcept {
+  if (trailers) {
+    IngressEvent event;
+    event.type = IngressEvent::Type::TRAILERS;
+    event.trailers = std::make_unique<HTTPHeaders>(*trailers);
+    enqueueToPeer(std::move(event));
+  }
+  IngressEvent eomEvent;
+  eomEvent.type = IngressEvent::Type::EOM;
+  enqueueToPeer(std::move(eomEvent));
+  return 0;
+}
+
+size_t HTTPLoopbackChannel::End::sendAbort(HTTPTransaction* /*txn*/,
+                                           ErrorCode statusCode) noexcept {
+  IngressEvent event;
+  event.type = IngressEvent::Type::ABORT;
+  event.error = statusCode;
+  enqueueToPeer(std::move(event));
+  return 0;
+}
+
+size_t HTTPLoopbackChannel::End::sendPriority(
+    HTTPTransaction*, const http2::PriorityUpdate&) noexcept {
+  return 0;
+}
+
+size_t HTTPLoopbackChannel::End::changePriority(HTTPTransaction*,
+                                                HTTPPriority) noexcept {
+  return 0;
+}
+
+size_t HTTPLoopbackChannel::End::sendWindowUpdate(HTTPTransaction* /*txn*/,
+                                                  uint32_t bytes) noexcept {
+  IngressEvent event;
+  event.type = IngressEvent::Type::WINDOW_UPDATE;
+  event.windowBytes = bytes;
+  enqueueToPeer(std::move(event));
+  return 0;
+}
+
+void HTTPLoopbackChannel::End::notifyPendingEgress() noexcept {
+  channel_.scheduleLoop();
+}
+
+void HTTPLoopbackChannel::End::detach(HTTPTransaction* txn) noexcept {
+  CHECK_EQ(txn, txn_.get());
+  txn_.reset();
+  pendingIngress_.clear();
+  channel_.endDetached();
+}
+
+void HTTPLoopbackChannel::End::notifyIngressBodyProcessed(
+    uint32_t /*bytes*/) noexcept {
+  // No session-level flow control window to replenish
+}
+
+void HTTPLoopbackChannel::End::notifyEgressBodyBuffered(
+    int64_t /*bytes*/) noexcept {
+}
+
+const folly::SocketAddress& HTTPLoopbackChannel::End::getLocalAddress()
+    const noexcept {
+  static const folly::SocketAddress addr("127.0.0.1", 0);
+  return addr;
+}
+
+const folly::SocketAddress& HTTPLoopbackChannel::End::getPeerAddress()
+    const noexcept {
+  return getLocalAddress();
+}
+
+void HTTPLoopbackChannel::End::describe(std::ostream& os) const {
+  os << "[loopback channel, "
+     << (direction_ == TransportDirection::UPSTREAM ? "client" : "server")
+     << " end]";
+}
+
+const wangle::TransportInfo& HTTPLoopbackChannel::End::getSetupTransportInfo()
+    const noexcept {
+  return setupTransportInfo_;
+}
+
+bool HTTPLoopbackChannel::End::getCurrentTransportInfo(
+    wangle::TransportInfo* /*tinfo*/) {
+  return false;
+}
+
+void HTTPLoopbackChannel::End::getFlowControlInfo(
+    HTTPTransaction::FlowControlInfo* info) {
+  *info = HTTPTransaction::FlowControlInfo();
+  info->flowControlEnabled_ = flowControlEnabled_;
+}
+
+HTTPTransaction::Transport::Type HTTPLoopbackChannel::End::getSessionType()
+    const noexcept {
+  return Type::TCP;
+}
+
+const HTTPCodec& HTTPLoopbackChannel::End::getCodec() const noexcept {
+  // Metadata provider only (protocol, parallel-request support,
+  // compression info); it never parses or generates anything, so one
+  // instance per direction serves every channel.
+  static const HTTP2Codec upstreamCodec{TransportDirection::UPSTREAM};
+  static const HTTP2Codec downstreamCodec{TransportDirection::DOWNSTREAM};
+  return direction_ == TransportDirection::UPSTREAM ? upstreamCodec
+                                                    : downstreamCodec;
+}
+
+void HTTPLoopbackChannel::End::drain() {
+  draining_ = true;
+}
+
+bool HTTPLoopbackChannel::End::isDraining() const {
+  return draining_;
+}
+
+HTTPTransaction* HTTPLoopbackChannel::End::newPushedTransaction(
+    HTTPCodec::StreamID /*assocStreamId*/,
+    HTTPTransaction::PushHandler* /*handler*/,
+    ProxygenError* error) noexcept {
+  if (error) {
+    *error = kErrorPushNotSupported;
+  }
+  return nullptr;
+}
+
+HTTPTransaction* HTTPLoopbackChannel::End::newExTransaction(
+    HTTPTransaction::Handler* /*handler*/,
+    HTTPCodec::StreamID /*controlStream*/,
+    bool /*unidirectional*/) noexcept {
+  return nullptr;
+}
+
+std::string HTTPLoopbackChannel::End::getSecurityProtocol() const {
+  return "";
+}
+
+void HTTPLoopbackChannel::End::addWaitingForReplaySafety(
+    folly::AsyncTransport::ReplaySafetyCallback* /*callback*/) noexcept {
+}
+
+void HTTPLoopbackChannel::End::removeWaitingForReplaySafety(
+    folly::AsyncTransport::ReplaySafetyCallback* /*callback*/) noexcept {
+}
+
+bool HTTPLoopbackChannel::End::needToBlockForReplaySafety() const {
+  return false;
+}
+
+const folly::AsyncTransport* HTTPLoopbackChannel::End::getUnderlyingTransport()
+    const noexcept {
+  return nullptr;
+}
+
+bool HTTPLoopbackChannel::End::isReplaySafe() const {
+  return true;
+}
+
+void HTTPLoopbackChannel::End::setHTTP2PrioritiesEnabled(bool enabled) {
+  h2PrioritiesEnabled_ = enabled;
+}
+
+bool HTTPLoopbackChannel::End::getHTTP2PrioritiesEnabled() const {
+  return h2PrioritiesEnabled_;
+}
+
+HTTPSessionBase* HTTPLoopbackChannel::End::getHTTPSessionBase() {
+  return nullptr;
+}
+
+folly::Optional<const HTTPMessage::HTTP2Priority>
+HTTPLoopbackChannel::End::getHTTPPriority(uint8_t /*level*/) {
+  return folly::none;
+}
+
+folly::Optional<HTTPTransaction::ConnectionToken>
+HTTPLoopbackChannel::End::getConnectionToken() const noexcept {
+  return folly::none;
+}
+
+} // namespace proxygen
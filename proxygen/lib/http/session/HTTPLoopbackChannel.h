@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <deque>
+
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/HHWheelTimer.h>
+#include <proxygen/lib/http/session/HTTP2PriorityQueue.h>
+#include <proxygen/lib/http/session/HTTPTransaction.h>
+#include <wangle/acceptor/TransportInfo.h>
+
+namespace proxygen {
+
+/**
+ * An in-process transport for hairpin traffic: one request/response
+ * exchange between a client-side and a server-side HTTPTransaction in
+ * the same event base, with no codec in the path.  HTTPMessage objects
+ * cross as a single struct copy and IOBuf bodies move pointer-wise, so
+ * internal calls skip header serialization and re-parsing entirely.
+ *
+ * Both ends are real HTTPTransactions, so everything layered on the
+ * transaction API -- handlers, filters, flow control, idle timeouts,
+ * transaction stats -- works unchanged.  Each end implements
+ * HTTPTransaction::Transport; egress from one transaction is queued and
+ * delivered as ingress to the peer from a loop callback, mirroring the
+ * "writes happen at end of loop" behavior of socket-backed sessions and
+ * keeping handler callbacks off each other's stacks.
+ *
+ * One channel carries one exchange.  Create it with the two handlers,
+ * then drive the client transaction exactly like one obtained from an
+ * upstream session:
+ *
+ *   auto channel = HTTPLoopbackChannel::create(
+ *       evb, timer, &clientHandler, &serverHandler);
+ *   channel->getClientTransaction()->sendHeaders(request);
+ *   ...
+ *
+ * The channel must outlive its transactions; destroy it (on the event
+ * base thread) after both handlers have detached, or earlier to abort
+ * the exchange with kErrorShutdown.  Not supported: push promises, ex
+ * transactions, byte events and sendHeadersWithDelegate/BufferMeta
+ * egress -- none of which apply to in-process calls.
+ */
+class HTTPLoopbackChannel : private folly::EventBase::LoopCallback {
+ public:
+  struct Params {
+    bool useFlowControl{true};
+    uint32_t receiveInitialWindowSize{65536};
+    uint32_t sendInitialWindowSize{65536};
+    folly::Optional<std::chrono::milliseconds> transactionIdleTimeout;
+    HTTPSessionStats* stats{nullptr};
+  };
+
+  static std::unique_ptr<HTTPLoopbackChannel> create(
+      folly::EventBase* evb,
+      folly::HHWheelTimer* timer,
+      HTTPTransaction::Handler* clientHandler,
+      HTTPTransaction::Handler* serverHandler,
+      Params params = Params());
+
+  ~HTTPLoopbackChannel() override;
+
+  HTTPTransaction* getClientTransaction() {
+    return client_.getTransaction();
+  }
+
+  HTTPTransaction* getServerTransaction() {
+    return server_.getTransaction();
+  }
+
+  /**
+   * True once both transactions have detached; the channel is inert and
+   * safe to destroy.
+   */
+  bool isComplete() const {
+    return !client_.getTransaction() && !server_.getTransaction();
+  }
+
+  /**
+   * Invoked (from the loop callback) when the exchange completes.  The
+   * callback may destroy the channel.
+   */
+  void setCompletionCallback(folly::Function<void()> callback) {
+    completionCallback_ = std::move(callback);
+  }
+
+ private:
+  explicit HTTPLoopbackChannel(folly::EventBase* evb);
+
+  /**
+   * One direction of the channel: owns a transaction and queues the
+   * peer's egress for delivery as ingress.
+   */
+  class End : public HTTPTransaction::Transport {
+   public:
+    End(HTTPLoopbackChannel& channel, TransportDirection direction);
+    ~End() override = default;
+
+    void init(End* peer,
+              folly::HHWheelTimer* timer,
+              const Params& params,
+              HTTPTransaction::Handler* handler);
+
+    HTTPTransaction* getTransaction() const {
+      return txn_.get();
+    }
+
+    void deliverPendingIngress();
+    void driveEgress();
+    void dropWithError(ProxygenError err);
+
+    // HTTPTransaction::Transport methods
+    void pauseIngress(HTTPTransaction* txn) noexcept override;
+    void resumeIngress(HTTPTransaction* txn) noexcept override;
+    void transactionTimeout(HTTPTransaction* txn) noexcept override;
+    void sendHeaders(HTTPTransaction* txn,
+                     const HTTPMessage& headers,
+                     HTTPHeaderSize* size,
+                     bool eom) noexcept override;
+    size_t sendBody(HTTPTransaction*,
+                    const HTTPTransaction::BufferMeta&,
+                    bool /* eom */) noexcept override {
+      return 0;
+    }
+    size_t sendBody(HTTPTransaction* txn,
+                    std::unique_ptr<folly::IOBuf> body,
+                    bool eom,
+                    bool trackLastByteFlushed) noexcept override;
+    size_t sendChunkHeader(HTTPTransaction* txn,
+                           size_t length) noexcept override;
+    size_t sendChunkTerminator(HTTPTransaction* txn) noexcept override;
+    size_t sendEOM(HTTPTransaction* txn,
+                   const HTTPHeaders* trailers) noexcept override;
+    size_t sendAbort(HTTPTransaction* txn,
+                     ErrorCode statusCode) noexcept override;
+    size_t sendPriority(HTTPTransaction* txn,
+                        const http2::PriorityUpdate& pri) noexcept override;
+    size_t changePriority(HTTPTransaction* txn,
+                          HTTPPriority pri) noexcept override;
+    size_t sendWindowUpdate(HTTPTransaction* txn,
+                            uint32_t bytes) noexcept override;
+    void notifyPendingEgress() noexcept override;
+    void detach(HTTPTransaction* txn) noexcept override;
+    void notifyIngressBodyProcessed(uint32_t bytes) noexcept override;
+    void notifyEgressBodyBuffered(int64_t bytes) noexcept override;
+    const folly::SocketAddress& getLocalAddress() const noexcept override;
+    const folly::SocketAddress& getPeerAddress() const noexcept override;
+    void describe(std::ostream& os) const override;
+    const wangle::TransportInfo& getSetupTransportInfo()
+        const noexcept override;
+    bool getCurrentTransportInfo(wangle::TransportInfo* tinfo) override;
+    void getFlowControlInfo(HTTPTransaction::FlowControlInfo* info) override;
+    HTTPTransaction::Transport::Type getSessionType() const noexcept override;
+    const HTTPCodec& getCodec() const noexcept override;
+    void drain() override;
+    bool isDraining() const override;
+    HTTPTransaction* newPushedTransaction(
+        HTTPCodec::StreamID assocStreamId,
+        HTTPTransaction::PushHandler* handler,
+        ProxygenError* error) noexcept override;
+    HTTPTransaction* newExTransaction(HTTPTransaction::Handler* handler,
+                                      HTTPCodec::StreamID controlStream,
+                                      bool unidirectional) noexcept override;
+    std::string getSecurityProtocol() const override;
+    void addWaitingForReplaySafety(
+        folly::AsyncTransport::ReplaySafetyCallback* callback) noexcept
+        override;
+    void removeWaitingForReplaySafety(
+        folly::AsyncTransport::ReplaySafetyCallback* callback) noexcept
+        override;
+    bool needToBlockForReplaySafety() const override;
+    const folly::AsyncTransport* getUnderlyingTransport()
+        const noexcept override;
+    bool isReplaySafe() const override;
+    void setHTTP2PrioritiesEnabled(bool enabled) override;
+    bool getHTTP2PrioritiesEnabled() const override;
+    HTTPSessionBase* getHTTPSessionBase() override;
+    folly::Optional<const HTTPMessage::HTTP2Priority> getHTTPPriority(
+        uint8_t level) override;
+    folly::Optional<HTTPTransaction::ConnectionToken> getConnectionToken()
+        const noexcept override;
+
+   private:
+    struct IngressEvent {
+      enum class Type {
+        HEADERS,
+        BODY,
+        TRAILERS,
+        EOM,
+        ABORT,
+        WINDOW_UPDATE
+      };
+      Type type;
+      std::unique_ptr<HTTPMessage> headers;
+      std::unique_ptr<folly::IOBuf> body;
+      std::unique_ptr<HTTPHeaders> trailers;
+      ErrorCode error{ErrorCode::NO_ERROR};
+      uint32_t windowBytes{0};
+    };
+
+    void enqueueToPeer(IngressEvent event);
+    void deliver(IngressEvent& event);
+
+    HTTPLoopbackChannel& channel_;
+    TransportDirection direction_;
+    End* peer_{nullptr};
+    HTTP2PriorityQueue egressQueue_;
+    std::unique_ptr<HTTPTransaction> txn_;
+    std::deque<IngressEvent> pendingIngress_;
+    wangle::TransportInfo setupTransportInfo_;
+    bool flowControlEnabled_{false};
+    bool draining_{false};
+    bool h2PrioritiesEnabled_{false};
+  };
+
+  void scheduleLoop();
+  void runLoopCallback() noexcept override;
+  void endDetached();
+
+  folly::EventBase* evb_;
+  End client_;
+  End server_;
+  folly::Function<void()> completionCallback_;
+};
+
+} // namespace proxygen
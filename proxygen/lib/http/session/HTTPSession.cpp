@@ -8,11 +8,14 @@
 
 #include <proxygen/lib/http/session/HTTPSession.h>
 
+#include <array>
 #include <chrono>
+#include <cstdlib>
 #include <fizz/protocol/AsyncFizzBase.h>
 #include <folly/Conv.h>
 #include <folly/CppAttributes.h>
 #include <folly/Random.h>
+#include <folly/SingletonThreadLocal.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/async/AsyncSSLSocket.h>
 #include <folly/tracing/ScopedTraceSection.h>
@@ -21,6 +24,9 @@
 #include <proxygen/lib/http/codec/HTTPChecks.h>
 #include <proxygen/lib/http/session/HTTPSessionController.h>
 #include <proxygen/lib/http/session/HTTPSessionStats.h>
+#include <proxygen/lib/http/session/IngressPriorityScheduler.h>
+#include <proxygen/lib/utils/IOBufDefrag.h>
+#include <proxygen/lib/utils/Tracepoints.h>
 #include <wangle/acceptor/ConnectionManager.h>
 #include <wangle/acceptor/SocketOptions.h>
 
@@ -39,10 +45,63 @@ namespace {
 static const uint32_t kMinReadSize = 1460;
 static const uint32_t kWriteReadyMax = 65536;
 
+// Sessions on one IO thread draw socket read buffers from a shared pool of
+// recycled slabs instead of hitting the allocator on every read.  A slab
+// goes back to the pool of whichever thread frees the last IOBuf
+// referencing it, once the parser is done with the bytes.  The memory is
+// never zero-initialized; the transport overwrites it on read.
+constexpr size_t kReadSlabSize = 16 * 1024;
+
+struct ReadSlabPool {
+  std::array<void*, 64> slabs;
+  size_t size{0};
+
+  ~ReadSlabPool() {
+    while (size > 0) {
+      ::free(slabs[--size]);
+    }
+  }
+};
+
+ReadSlabPool& readSlabPool() {
+  struct PoolTag {};
+  return folly::SingletonThreadLocal<ReadSlabPool, PoolTag>::get();
+}
+
+void recycleReadSlab(void* buf, void* /*userData*/) {
+  auto& pool = readSlabPool();
+  if (pool.size < pool.slabs.size()) {
+    pool.slabs[pool.size++] = buf;
+    return;
+  }
+  ::free(buf);
+}
+
+std::unique_ptr<folly::IOBuf> allocateReadSlab() {
+  auto& pool = readSlabPool();
+  void* mem =
+      (pool.size > 0) ? pool.slabs[--pool.size] : ::malloc(kReadSlabSize);
+  return folly::IOBuf::takeOwnership(
+      mem, kReadSlabSize, size_t(0), recycleReadSlab);
+}
+
 // Lower = higher latency, better prioritization
 // Higher = lower latency, less prioritization
 static const uint32_t kMaxWritesPerLoop = 32;
 
+// Ingress batching: parse as soon as this many bytes are buffered, and
+// skip batching entirely when the average loop time exceeds the delay cap
+static const uint64_t kIngressBatchByteLimit = 64 * 1024;
+static constexpr std::chrono::milliseconds kIngressBatchMaxLoopDelay{5};
+
+// Parse budget for one processReadData() pass: once the codec has run
+// for this long, or created this many transactions, remaining ingress is
+// requeued for the next loop tick so other sessions get serviced.  The
+// budget is checked between buffers, so one oversized read slab can
+// still overshoot by its own parse time
+static constexpr std::chrono::microseconds kParseBudgetTime{1000};
+static const uint64_t kParseBudgetTxns = 64;
+
 static constexpr folly::StringPiece kClientLabel =
     "EXPORTER HTTP CERTIFICATE client";
 static constexpr folly::StringPiece kServerLabel =
@@ -102,7 +161,9 @@ HTTPSession::HTTPSession(const WheelTimerInstance& wheelTimer,
       inLoopCallback_(false),
       inResume_(false),
       pendingPause_(false),
-      writeBufSplit_(false) {
+      writeBufSplit_(false),
+      ingressBatchingEnabled_(false),
+      decryptInPlace_(false) {
   byteEventTracker_ = std::make_shared<ByteEventTracker>(this);
   initialReceiveWindow_ = receiveStreamWindowSize_ = receiveSessionWindowSize_ =
       codec_->getDefaultWindowSize();
@@ -128,6 +189,10 @@ HTTPSession::HTTPSession(const WheelTimerInstance& wheelTimer,
   if (!sock_->isReplaySafe()) {
     sock_->setReplaySafetyCallback(this);
   }
+  PROXYGEN_SDT(session_create,
+               this,
+               static_cast<uint8_t>(codec_->getTransportDirection()),
+               static_cast<uint8_t>(codec_->getProtocol()));
 }
 
 uint32_t HTTPSession::getCertAuthSettingVal() {
@@ -246,6 +311,20 @@ HTTPSession::~HTTPSession() {
     flowControlTimeout_.cancelTimeout();
   }
 
+  if (pacingTimeout_.isScheduled()) {
+    pacingTimeout_.cancelTimeout();
+  }
+
+  if (isolationGroup_) {
+    isolationGroup_->cancelWaits(this);
+    isolationGroup_->removeSession();
+  }
+
+  if (ingressScheduler_) {
+    ingressScheduler_->removeSession(*this);
+  }
+
+  PROXYGEN_SDT(session_destroy, this);
   runDestroyCallbacks();
 }
 
@@ -281,6 +360,7 @@ void HTTPSession::setByteEventTracker(
 
 void HTTPSession::setSessionStats(HTTPSessionStats* stats) {
   HTTPSessionBase::setSessionStats(stats);
+  txnEgressQueue_.setSessionStats(stats);
   if (byteEventTracker_) {
     byteEventTracker_->setTTLBAStats(stats);
   }
@@ -309,6 +389,10 @@ void HTTPSession::setEgressSettings(const SettingsList& inSettings) {
       settings->setSetting(setting.id, setting.value);
       if (setting.id == SettingsId::MAX_CONCURRENT_STREAMS) {
         maxConcurrentIncomingStreams_ = setting.value;
+      } else if (setting.id == SettingsId::NO_RFC7540_PRIORITIES &&
+                 setting.value != 0) {
+        // egress follows RFC 9218 urgencies; skip the dependency tree
+        txnEgressQueue_.enableUrgencyScheduling();
       }
     }
   }
@@ -331,6 +415,111 @@ void HTTPSession::setEgressBytesLimit(uint64_t bytesLimit) {
   egressBytesLimit_ = bytesLimit;
 }
 
+void HTTPSession::setEgressPacingRate(uint64_t bitsPerSecond,
+                                      uint64_t maxBurstBytes) {
+  egressPacingBytesPerSec_ = bitsPerSecond / 8;
+  if (egressPacingBytesPerSec_ == 0) {
+    pacingTimeout_.cancelTimeout();
+    egressPacingTokens_ = 0;
+    return;
+  }
+  // Default burst of ~10ms at the target rate, with a floor of a few
+  // packets so low rates still make forward progress per wakeup
+  egressPacingBurstBytes_ =
+      (maxBurstBytes > 0)
+          ? maxBurstBytes
+          : std::max<uint64_t>(egressPacingBytesPerSec_ / 100, 16384);
+  egressPacingTokens_ = egressPacingBurstBytes_;
+  egressPacingLastRefill_ = getCurrentTime();
+}
+
+void HTTPSession::setTLSRecordSizePolicy(uint32_t initialSize,
+                                         uint32_t maxSize,
+                                         uint64_t bulkThresholdBytes,
+                                         std::chrono::milliseconds idleReset) {
+  tlsRecordInitialSize_ = initialSize;
+  tlsRecordMaxSize_ = std::max(initialSize, maxSize);
+  tlsRecordBulkThreshold_ = bulkThresholdBytes;
+  tlsRecordIdleReset_ = idleReset;
+  tlsRecordSize_ = initialSize;
+  tlsRecordBytesSinceReset_ = 0;
+}
+
+void HTTPSession::enableWriteBufferAutoTuning(uint32_t minLimit,
+                                              uint32_t maxLimit) {
+  CHECK_LE(minLimit, maxLimit);
+  writeBufAutoTune_ = true;
+  writeBufAutoTuneMin_ = minLimit;
+  writeBufAutoTuneMax_ = maxLimit;
+}
+
+void HTTPSession::tuneWriteBufferLimit(uint64_t bytesWritten) {
+  const auto elapsed =
+      microsecondsBetween(getCurrentTime(), pendingWriteStart_);
+  if (elapsed.count() <= 0) {
+    // drained within clock resolution; no usable rate signal
+    return;
+  }
+  const uint64_t sampleRate = bytesWritten * 1000000 / elapsed.count();
+  if (sampleRate < writeDrainBytesPerSec_ || writeDrainBytesPerSec_ == 0) {
+    // adopt slowdowns immediately so a stalling peer sheds buffer fast
+    writeDrainBytesPerSec_ = sampleRate;
+  } else {
+    // grow toward faster samples gradually to ride out bursts
+    writeDrainBytesPerSec_ += (sampleRate - writeDrainBytesPerSec_) / 8;
+  }
+  auto rtt = transportInfo_.rtt;
+  if (rtt.count() <= 0) {
+    // no kernel RTT sample yet (or non-TCP transport); assume a WAN-ish
+    // round trip rather than collapsing the buffer
+    rtt = std::chrono::microseconds(20000);
+  }
+  // cover ~2 RTTs of drain at the smoothed rate
+  const uint64_t target = writeDrainBytesPerSec_ * 2 * rtt.count() / 1000000;
+  setWriteBufferLimit(static_cast<uint32_t>(
+      std::max<uint64_t>(writeBufAutoTuneMin_,
+                         std::min<uint64_t>(target, writeBufAutoTuneMax_))));
+}
+
+uint64_t HTTPSession::refillPacingTokens() {
+  const auto now = getCurrentTime();
+  const auto elapsedMs = millisecondsBetween(now, egressPacingLastRefill_);
+  if (elapsedMs.count() > 0) {
+    egressPacingTokens_ = std::min(
+        egressPacingBurstBytes_,
+        egressPacingTokens_ +
+            egressPacingBytesPerSec_ * elapsedMs.count() / 1000);
+    // advance by whole milliseconds so the sub-ms remainder accrues
+    // toward the next refill instead of being dropped
+    egressPacingLastRefill_ += elapsedMs;
+  }
+  return egressPacingTokens_;
+}
+
+void HTTPSession::consumePacingTokens(uint64_t bytes) {
+  if (egressPacingBytesPerSec_ > 0) {
+    egressPacingTokens_ -= std::min(egressPacingTokens_, bytes);
+  }
+}
+
+void HTTPSession::schedulePacingTimeout() {
+  if (pacingTimeout_.isScheduled()) {
+    return;
+  }
+  // Wake when roughly a full burst has accrued; the wheel cannot resolve
+  // below a millisecond
+  const uint64_t deficit = egressPacingBurstBytes_ - egressPacingTokens_;
+  const uint64_t delayMs =
+      std::max<uint64_t>(1, deficit * 1000 / egressPacingBytesPerSec_);
+  wheelTimer_.scheduleTimeout(&pacingTimeout_,
+                              std::chrono::milliseconds(delayMs));
+}
+
+void HTTPSession::pacingTimeoutExpired() noexcept {
+  VLOG(5) << *this << " pacing timeout expired, resuming writes";
+  scheduleWrite();
+}
+
 void HTTPSession::readTimeoutExpired() noexcept {
   VLOG(3) << "session-level timeout on " << *this;
 
@@ -453,6 +642,16 @@ bool HTTPSession::isDownstream() const {
 
 void HTTPSession::getReadBuffer(void** buf, size_t* bufSize) {
   FOLLY_SCOPED_TRACE_SECTION("HTTPSession - getReadBuffer");
+  // Make sure the chain tail is a pooled slab with room, so preallocate
+  // reuses its tailroom instead of hitting the allocator
+  const folly::IOBuf* chain = readBuf_.front();
+  // In decrypt-in-place mode insist on room for a full TLS record
+  // (slabs are sized to one) so the record layer never has to spill the
+  // tail of a record into its own buffer and copy it over later
+  const size_t minRoom = decryptInPlace_ ? kReadSlabSize : kMinReadSize;
+  if (!chain || chain->prev()->tailroom() < minRoom) {
+    readBuf_.append(allocateReadSlab());
+  }
   pair<void*, uint32_t> readSpace =
       readBuf_.preallocate(kMinReadSize, HTTPSessionBase::maxReadBufferSize_);
   *buf = readSpace.first;
@@ -481,11 +680,13 @@ void HTTPSession::readDataAvailable(size_t readSize) noexcept {
     infoCallback_->onRead(*this, readSize, HTTPCodec::NoStream);
   }
 
-  processReadData();
+  maybeBatchReadData();
 }
 
 bool HTTPSession::isBufferMovable() noexcept {
-  return true;
+  // In decrypt-in-place mode the transport must use getReadBuffer() and
+  // decrypt straight into the pooled parse-target slab
+  return !decryptInPlace_;
 }
 
 void HTTPSession::readBufferAvailable(std::unique_ptr<IOBuf> readBuf) noexcept {
@@ -512,14 +713,70 @@ void HTTPSession::readBufferAvailable(std::unique_ptr<IOBuf> readBuf) noexcept {
     infoCallback_->onRead(*this, readSize, HTTPCodec::NoStream);
   }
 
-  processReadData();
+  maybeBatchReadData();
+}
+
+void HTTPSession::maybeBatchReadData() {
+  if (ingressScheduler_) {
+    // Bulk session: parsing happens in the worker's end-of-iteration
+    // pass, after every latency-critical session's inline parses
+    ingressScheduler_->sessionReadReady(*this);
+    return;
+  }
+  if (!ingressBatchingEnabled_) {
+    processReadData();
+    return;
+  }
+  // Defer parsing to the end of this loop iteration so that further reads
+  // arriving in the same iteration get fed to the codec in one pass.
+  // Parse immediately once the batch byte budget is exhausted, and drop
+  // the budget to zero when the event loop is already running behind --
+  // batching saves parser entry/exit overhead, which never justifies
+  // adding queueing delay to a loaded loop.
+  auto* evb = sock_->getEventBase();
+  uint64_t budget = (evb->getAvgLoopTime() > kIngressBatchMaxLoopDelay)
+                        ? 0
+                        : kIngressBatchByteLimit;
+  if (readBuf_.chainLength() >= budget) {
+    ingressBatchCb_.cancelLoopCallback();
+    processReadData();
+    return;
+  }
+  if (!ingressBatchCb_.isLoopCallbackScheduled()) {
+    evb->runInLoop(&ingressBatchCb_, /*thisIteration=*/true);
+  }
 }
 
-void HTTPSession::processReadData() {
+void HTTPSession::flushPendingReadData() {
+  bool pending = ingressScheduler_ && ingressScheduler_->removeSession(*this);
+  if (ingressBatchCb_.isLoopCallbackScheduled()) {
+    ingressBatchCb_.cancelLoopCallback();
+    pending = true;
+  }
+  if (pending) {
+    // Teardown path: there will be no next tick for this session's
+    // reads, so drain without the parse budget
+    processReadData(/*enforceParseBudget=*/false);
+  }
+}
+
+void HTTPSession::processReadData(bool enforceParseBudget) {
   FOLLY_SCOPED_TRACE_SECTION("HTTPSession - processReadData");
+  if (!receivedFirstByte_ && !readBuf_.empty()) {
+    receivedFirstByte_ = true;
+    PROXYGEN_SDT(session_first_byte, this);
+  }
+
+  if (ingressBlockedOnGroup_) {
+    // The tenant's parse share is spent; the group wakes us and readBuf_
+    // keeps absorbing reads (bounded by maxReadBufferSize_) meanwhile
+    return;
+  }
 
   // Pass the ingress data through the codec to parse it. The codec
   // will invoke various methods of the HTTPSession as callbacks.
+  const auto parseStart = getCurrentTime();
+  const auto txnsAtStart = getNumTxnServed();
   while (!ingressError_ && readsUnpaused() && !readBuf_.empty()) {
     // Skip any 0 length buffers before invoking the codec. Since readBuf_ is
     // not empty, we are guaranteed to find a non-empty buffer.
@@ -536,12 +793,58 @@ void HTTPSession::processReadData() {
       break;
     }
     readBuf_.trimStart(bytesParsed);
+
+    // Weighted cross-tenant fairness rides the same between-buffers
+    // granularity as the per-session parse budget below: charge what the
+    // codec just consumed, and once the group's deficit runs dry park on
+    // the group instead of the next loop tick
+    if (isolationGroup_ && !isolationGroup_->chargeIngress(bytesParsed) &&
+        !ingressError_ && readsUnpaused() && !readBuf_.empty()) {
+      VLOG(4) << "Isolation group '" << isolationGroup_->getName()
+              << "' parse deficit exhausted, parking "
+              << readBuf_.chainLength() << " buffered ingress bytes " << *this;
+      ingressBlockedOnGroup_ = true;
+      isolationGroup_->waitForIngress(this);
+      return;
+    }
+
+    // Bulk sessions share a per-tick byte budget across the worker; when
+    // it runs dry, back to the scheduler's queue for the next iteration
+    if (ingressScheduler_ && enforceParseBudget &&
+        !ingressScheduler_->chargeBulk(bytesParsed) && !ingressError_ &&
+        readsUnpaused() && !readBuf_.empty()) {
+      VLOG(4) << "Bulk ingress byte budget spent this tick, deferring "
+              << readBuf_.chainLength() << " buffered ingress bytes "
+              << *this;
+      ingressScheduler_->sessionReadReady(*this);
+      return;
+    }
+
+    // A session arriving with megabytes of pipelined requests or a
+    // HEADERS flood must not monopolize the loop; once the parse budget
+    // is spent, yield and finish the rest next tick
+    if (enforceParseBudget && !readBuf_.empty() &&
+        (getNumTxnServed() - txnsAtStart >= kParseBudgetTxns ||
+         getCurrentTime() - parseStart >= kParseBudgetTime)) {
+      VLOG(4) << "Parse budget exhausted, deferring "
+              << readBuf_.chainLength() << " buffered ingress bytes to the "
+              << "next loop tick " << *this;
+      if (ingressScheduler_) {
+        ingressScheduler_->sessionReadReady(*this);
+      } else if (!ingressBatchCb_.isLoopCallbackScheduled()) {
+        sock_->getEventBase()->runInLoop(&ingressBatchCb_,
+                                         /*thisIteration=*/false);
+      }
+      return;
+    }
   }
 }
 
 void HTTPSession::readEOF() noexcept {
   DestructorGuard guard(this);
   VLOG(4) << "EOF on " << *this;
+  // Hand any batched ingress to the codec before tearing down reads
+  flushPendingReadData();
   // for SSL only: error without any bytes from the client might happen
   // due to client-side issues with the SSL cert. Note that it can also
   // happen if the client sends a SPDY frame header but no body.
@@ -561,6 +864,7 @@ void HTTPSession::readEOF() noexcept {
 void HTTPSession::readErr(const AsyncSocketException& ex) noexcept {
   DestructorGuard guard(this);
   VLOG(4) << "read error on " << *this << ": " << ex.what();
+  flushPendingReadData();
 
   auto sslEx = dynamic_cast<const folly::SSLException*>(&ex);
   if (infoCallback_ && sslEx) {
@@ -707,6 +1011,20 @@ void HTTPSession::onMessageBegin(HTTPCodec::StreamID streamID,
     infoCallback_->onRequestBegin(*this);
   }
 
+  if (isolationGroup_ && isolationGroup_->atTransactionQuota()) {
+    // The tenant, not just this session, is at its concurrency limit;
+    // refuse the stream so the client retries elsewhere
+    VLOG(3) << "Refusing stream=" << streamID << ", isolation group '"
+            << isolationGroup_->getName()
+            << "' is at its transaction quota " << *this;
+    isolationGroup_->recordTransactionRefused();
+    HTTPException ex(HTTPException::Direction::INGRESS_AND_EGRESS,
+                     "isolation group transaction quota exceeded");
+    ex.setCodecStatusCode(ErrorCode::REFUSED_STREAM);
+    onError(streamID, ex, true);
+    return;
+  }
+
   http2::PriorityUpdate messagePriority = getMessagePriority(msg);
   txn = createTransaction(streamID,
                           HTTPCodec::NoStream,
@@ -731,6 +1049,12 @@ void HTTPSession::onMessageBegin(HTTPCodec::StreamID streamID,
       return;
     }
 
+    if (egressReorderLimit_ > 0) {
+      // Concurrent dispatch is allowed; out-of-order egress is parked in
+      // parkedEgress_ and replayed in request order (see flushParkedEgress)
+      return;
+    }
+
     // There must be at least two transactions (we just checked). The previous
     // txns haven't completed yet. Pause reads until they complete
     DCHECK_GE(transactions_.size(), 2);
@@ -1137,6 +1461,10 @@ void HTTPSession::onGoaway(uint64_t lastGoodStreamID,
 
   setCloseReason(ConnectionCloseReason::GOAWAY);
 
+  if (infoCallback_) {
+    infoCallback_->onGoawayReceived(*this);
+  }
+
   // Drain active transactions and prevent new transactions
   drain();
 
@@ -1223,11 +1551,12 @@ void HTTPSession::onPingRequest(uint64_t data) {
     bytesScheduledBeforePing = bytesScheduled_;
   }
 
-  if (byteEventTracker_) {
+  if (byteEventTracker_ && pingSize > 0) {
     // addPingByteEvent has logic to shift all ByteEvents after
     // 'bytesScheduledBeforePing'.  In the case where we're putting it at the
     // end, there will be no events with an offset as high - so it will be a
-    // no-op.
+    // no-op.  pingSize is 0 when the codec deferred the reply for
+    // coalescing; it is written with the next flush instead.
     byteEventTracker_->addPingByteEvent(
         pingSize, timestamp, bytesScheduledBeforePing);
   }
@@ -1240,6 +1569,11 @@ void HTTPSession::onPingReply(uint64_t data) {
   if (pingProber_) {
     pingProber_->onPingReply(data);
   }
+  if (timedPing_ && timedPing_->first == data) {
+    addRTTSample(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - timedPing_->second));
+    timedPing_.reset();
+  }
   if (infoCallback_) {
     infoCallback_->onPingReplyReceived();
   }
@@ -1275,7 +1609,8 @@ void HTTPSession::onSettings(const SettingsList& settings) {
       }
     }
   }
-  if (codec_->generateSettingsAck(writeBuf_) > 0) {
+  if (codec_->generateSettingsAck(writeBuf_) > 0 ||
+      codec_->hasDeferredFrames()) {
     scheduleWrite();
   }
   if (infoCallback_) {
@@ -1555,6 +1890,18 @@ void HTTPSession::sendHeaders(HTTPTransaction* txn,
                               HTTPHeaderSize* size,
                               bool includeEOM) noexcept {
   CHECK(started_);
+  if (shouldParkEgress(txn)) {
+    auto& parked = getParkedEgress(txn);
+    parked.messages.emplace_back(std::make_unique<HTTPMessage>(headers));
+    if (size) {
+      *size = HTTPHeaderSize();
+    }
+    if (includeEOM) {
+      parked.eom = true;
+      onEgressMessageFinished(txn);
+    }
+    return;
+  }
   unique_ptr<IOBuf> goawayBuf;
   if (shouldShutdown()) {
     // For HTTP/1.1, add Connection: close
@@ -1631,12 +1978,39 @@ void HTTPSession::commonEom(HTTPTransaction* txn,
                                         sessionByteOffset(),
                                         piggybacked);
   onEgressMessageFinished(txn);
+  if (egressReorderLimit_ > 0 && isDownstream() &&
+      !codec_->supportsParallelRequests() && txn->getID() == egressFrontier_) {
+    // The response at the egress frontier is complete; successors that
+    // finished out of order may be waiting in parkedEgress_
+    egressFrontier_++;
+    flushParkedEgress();
+  }
 }
 
 size_t HTTPSession::sendBody(HTTPTransaction* txn,
                              std::unique_ptr<folly::IOBuf> body,
                              bool includeEOM,
                              bool trackLastByteFlushed) noexcept {
+  if (shouldParkEgress(txn)) {
+    size_t bodyLen = body ? body->computeChainDataLength() : 0;
+    auto& parked = getParkedEgress(txn);
+    parked.body.append(std::move(body));
+    parkedEgressBytes_ += bodyLen;
+    if (parkedEgressBytes_ > egressReorderLimit_ && !parked.egressPaused) {
+      // Soft cap: accept the buffer that crossed the line, but stop this
+      // transaction from generating more until its turn to egress comes
+      VLOG(4) << *this << " parked egress bytes " << parkedEgressBytes_
+              << " over limit " << egressReorderLimit_
+              << ", pausing egress on streamID=" << txn->getID();
+      parked.egressPaused = true;
+      txn->pauseEgress();
+    }
+    if (includeEOM) {
+      parked.eom = true;
+      onEgressMessageFinished(txn);
+    }
+    return bodyLen;
+  }
   uint64_t offset = sessionByteOffset();
   size_t bodyLen = body ? body->computeChainDataLength() : 0;
   size_t encodedSize = codec_->generateBody(writeBuf_,
@@ -1646,12 +2020,22 @@ size_t HTTPSession::sendBody(HTTPTransaction* txn,
                                             includeEOM);
   CHECK(inLoopCallback_);
   bodyBytesPerWriteBuf_ += bodyLen;
-  if (encodedSize > 0 && !txn->testAndSetFirstByteSent() && byteEventTracker_) {
-    byteEventTracker_->addFirstBodyByteEvent(offset + 1, txn);
-  }
-
-  if (trackLastByteFlushed && encodedSize > 0 && byteEventTracker_) {
-    byteEventTracker_->addTrackedByteEvent(txn, offset + encodedSize);
+  if (encodedSize > 0 && byteEventTracker_) {
+    // batch the first-byte and tracked-byte events into one tracker insert
+    ByteEventTracker::EventRequest events[2];
+    size_t numEvents = 0;
+    if (!txn->testAndSetFirstByteSent()) {
+      events[numEvents++] = {offset + 1, ByteEvent::FIRST_BYTE};
+    }
+    if (trackLastByteFlushed) {
+      events[numEvents++] = {offset + encodedSize, ByteEvent::TRACKED_BYTE};
+    }
+    if (numEvents > 0) {
+      byteEventTracker_->addTxnByteEvents(
+          txn,
+          folly::Range<const ByteEventTracker::EventRequest*>(events,
+                                                              numEvents));
+    }
   }
 
   if (includeEOM) {
@@ -1663,6 +2047,11 @@ size_t HTTPSession::sendBody(HTTPTransaction* txn,
 
 size_t HTTPSession::sendChunkHeader(HTTPTransaction* txn,
                                     size_t length) noexcept {
+  if (shouldParkEgress(txn)) {
+    // The handler's chunk boundaries are not preserved for parked egress;
+    // generateBody re-frames the accumulated body at replay time
+    return 0;
+  }
   size_t encodedSize =
       codec_->generateChunkHeader(writeBuf_, txn->getID(), length);
   scheduleWrite();
@@ -1670,6 +2059,9 @@ size_t HTTPSession::sendChunkHeader(HTTPTransaction* txn,
 }
 
 size_t HTTPSession::sendChunkTerminator(HTTPTransaction* txn) noexcept {
+  if (shouldParkEgress(txn)) {
+    return 0;
+  }
   size_t encodedSize = codec_->generateChunkTerminator(writeBuf_, txn->getID());
   scheduleWrite();
   return encodedSize;
@@ -1734,6 +2126,16 @@ size_t HTTPSession::sendEOM(HTTPTransaction* txn,
   VLOG(4) << *this << " sending EOM for streamID=" << txn->getID()
           << " trailers=" << (trailers ? "yes" : "no");
 
+  if (shouldParkEgress(txn)) {
+    auto& parked = getParkedEgress(txn);
+    if (trailers) {
+      parked.trailers = std::make_unique<HTTPHeaders>(*trailers);
+    }
+    parked.eom = true;
+    onEgressMessageFinished(txn);
+    return 0;
+  }
+
   size_t encodedSize = 0;
   if (trailers) {
     encodedSize = codec_->generateTrailers(writeBuf_, txn->getID(), *trailers);
@@ -1757,6 +2159,9 @@ size_t HTTPSession::sendAbort(HTTPTransaction* txn,
   // Schedule a network write to send out whatever egress we might
   // have queued up.
   VLOG(4) << *this << " sending abort for streamID=" << txn->getID();
+  // An aborted response never gets replayed; for HTTP/1.1 the RST below
+  // tears the whole pipeline down anyway
+  dropParkedEgress(txn->getID());
   // drain this transaction's writeBuf instead of flushing it
   // then enqueue the abort directly into the Session buffer,
   // hence with max priority.
@@ -1779,8 +2184,12 @@ size_t HTTPSession::sendPriority(HTTPTransaction* txn,
   return sendPriorityImpl(txn->getID(), pri);
 }
 
-size_t HTTPSession::changePriority(HTTPTransaction* /*txn*/,
-                                   HTTPPriority /*pri*/) noexcept {
+size_t HTTPSession::changePriority(HTTPTransaction* txn,
+                                   HTTPPriority pri) noexcept {
+  if (txnEgressQueue_.usingUrgencyScheduling()) {
+    txnEgressQueue_.updateUrgency(txn->getID(), pri.urgency);
+  }
+  // no wire format for PRIORITY_UPDATE here; the change is local only
   return 0;
 }
 
@@ -1807,6 +2216,53 @@ void HTTPSession::setControlMessageRateLimitParams(
   }
 }
 
+void HTTPSession::setIngressRateLimiter(IngressRateLimiter& limiter,
+                                        const IngressRateLimitConfig& config) {
+  CHECK(!ingressRateLimitFilter_) << "ingress rate limiter already installed";
+  auto filter =
+      std::make_unique<IngressRateLimitFilter>(limiter, config, this);
+  ingressRateLimitFilter_ = filter.get();
+  codec_.addFilters(std::move(filter));
+}
+
+void HTTPSession::setIsolationGroup(IsolationGroup* group) {
+  CHECK(!isolationGroup_) << "isolation group already set";
+  CHECK(group);
+  isolationGroup_ = group;
+  isolationGroup_->addSession();
+}
+
+void HTTPSession::setBulkIngressScheduler(IngressPriorityScheduler* scheduler) {
+  CHECK(!ingressScheduler_) << "ingress scheduler already set";
+  CHECK(scheduler);
+  ingressScheduler_ = scheduler;
+}
+
+void HTTPSession::groupIngressUnblocked() noexcept {
+  VLOG(5) << *this << " isolation group '" << isolationGroup_->getName()
+          << "' parse deficit replenished, resuming ingress";
+  DestructorGuard dg(this);
+  ingressBlockedOnGroup_ = false;
+  processReadData();
+}
+
+void HTTPSession::groupEgressUnblocked() noexcept {
+  VLOG(5) << *this << " isolation group '" << isolationGroup_->getName()
+          << "' egress deficit replenished, resuming writes";
+  egressBlockedOnGroup_ = false;
+  scheduleWrite();
+}
+
+void HTTPSession::pauseIngressForRateLimit() noexcept {
+  VLOG(4) << *this << " pausing reads, ingress rate limited";
+  pauseReads();
+}
+
+void HTTPSession::resumeIngressForRateLimit() noexcept {
+  VLOG(4) << *this << " resuming reads, ingress tokens refilled";
+  resumeReads();
+}
+
 /**
  * Send a CERTIFICATE_REQUEST frame. If the underlying protocol doesn't
  * support secondary authentication, this is a no-op and 0 is returned.
@@ -1856,6 +2312,9 @@ void HTTPSession::decrementTransactionCount(HTTPTransaction* txn,
     if (egressEOM && txn->testAndClearIsCountedTowardsStreamLimit()) {
       DCHECK_NE(incomingStreams_, 0);
       incomingStreams_--;
+      if (isolationGroup_) {
+        isolationGroup_->endTransaction();
+      }
     }
   }
 }
@@ -1869,7 +2328,10 @@ bool HTTPSession::maybeResumePausedPipelinedTransaction(size_t oldStreamCount,
                                                         uint32_t txnSeqn) {
   if (!codec_->supportsParallelRequests() && !transactions_.empty()) {
     auto pipelineStreamCount = getPipelineStreamCount();
-    if (pipelineStreamCount < oldStreamCount && pipelineStreamCount == 1) {
+    // With egress reordering, pipelined transactions are never paused, and
+    // the successor may have detached already (its response parked)
+    if (pipelineStreamCount < oldStreamCount && pipelineStreamCount == 1 &&
+        egressReorderLimit_ == 0) {
       // For H1, StreamID = txnSeqn + 1
       auto curStreamId = txnSeqn + 1;
       auto txnIt = transactions_.find(curStreamId + 1);
@@ -1887,9 +2349,86 @@ bool HTTPSession::maybeResumePausedPipelinedTransaction(size_t oldStreamCount,
   return false;
 }
 
+HTTPSession::ParkedEgress& HTTPSession::getParkedEgress(HTTPTransaction* txn) {
+  auto res = parkedEgress_.emplace(txn->getID(), ParkedEgress());
+  if (res.second) {
+    VLOG(4) << *this << " parking out-of-order egress for streamID="
+            << txn->getID() << ", frontier=" << egressFrontier_;
+    res.first->second.parkedSince = getCurrentTime();
+  }
+  return res.first->second;
+}
+
+void HTTPSession::flushParkedEgress() {
+  size_t flushed = 0;
+  while (true) {
+    auto it = parkedEgress_.find(egressFrontier_);
+    if (it == parkedEgress_.end()) {
+      break;
+    }
+    auto streamID = it->first;
+    auto& parked = it->second;
+    uint64_t parkedBytes = parked.body.chainLength();
+    VLOG(4) << *this << " replaying parked egress for streamID=" << streamID
+            << ", bytes=" << parkedBytes;
+    const bool wasReusable = codec_->isReusable();
+    for (auto& msg : parked.messages) {
+      codec_->generateHeader(writeBuf_, streamID, *msg, false, nullptr);
+      onHeadersSent(*msg, wasReusable);
+    }
+    if (parkedBytes > 0) {
+      // generateBody re-frames the body as one chunk if the response was
+      // chunked; the handler's original chunk boundaries are not kept
+      codec_->generateBody(writeBuf_,
+                           streamID,
+                           parked.body.move(),
+                           HTTPCodec::NoPadding,
+                           false);
+    }
+    CHECK_GE(parkedEgressBytes_, parkedBytes);
+    parkedEgressBytes_ -= parkedBytes;
+    if (sessionStats_) {
+      sessionStats_->recordParkedEgressFlushed(
+          parkedBytes, millisecondsSince(parked.parkedSince));
+    }
+    flushed++;
+    if (!parked.eom) {
+      // Partial response: its transaction is now at the head of the
+      // pipeline and egresses directly from here on
+      auto livetxn = findTransaction(streamID);
+      bool resume = parked.egressPaused;
+      parkedEgress_.erase(it);
+      if (livetxn && resume) {
+        livetxn->resumeEgress();
+      }
+      break;
+    }
+    if (parked.trailers) {
+      codec_->generateTrailers(writeBuf_, streamID, *parked.trailers);
+    }
+    codec_->generateEOM(writeBuf_, streamID);
+    parkedEgress_.erase(it);
+    egressFrontier_++;
+  }
+  if (flushed > 0) {
+    scheduleWrite();
+  }
+}
+
+void HTTPSession::dropParkedEgress(HTTPCodec::StreamID streamID) {
+  auto it = parkedEgress_.find(streamID);
+  if (it == parkedEgress_.end()) {
+    return;
+  }
+  CHECK_GE(parkedEgressBytes_, it->second.body.chainLength());
+  parkedEgressBytes_ -= it->second.body.chainLength();
+  parkedEgress_.erase(it);
+}
+
 void HTTPSession::detach(HTTPTransaction* txn) noexcept {
   DestructorGuard guard(this);
   HTTPCodec::StreamID streamID = txn->getID();
+  PROXYGEN_SDT(txn_detach, this, streamID);
   auto txnSeqn = txn->getSequenceNumber();
   auto it = transactions_.find(txn->getID());
   DCHECK(it != transactions_.end());
@@ -1907,6 +2446,11 @@ void HTTPSession::detach(HTTPTransaction* txn) noexcept {
   CHECK_GT(liveTransactions_, 0);
   liveTransactions_--;
 
+  // Capture the access log record while the transaction is still alive;
+  // this covers every transaction, including codec-level errors that
+  // never reached a handler.
+  logTransactionToAccessLog(*txn);
+
   if (txn->isPushed()) {
     auto assocTxn = findTransaction(*txn->getAssocTxnId());
     if (assocTxn) {
@@ -1929,13 +2473,16 @@ void HTTPSession::detach(HTTPTransaction* txn) noexcept {
     lastTxn_ = nullptr;
   }
   DCHECK(transactionIds_.count(it->first));
+  if (txnRing_) {
+    txnRing_->erase(it->first);
+  }
   transactionIds_.erase(it->first);
   transactions_.erase(it);
 
   if (transactions_.empty()) {
     HTTPSessionBase::setLatestActive();
     if (pingProber_) {
-      pingProber_->cancelProbes();
+      pingProber_->onStreamsActive(false);
     }
     if (infoCallback_) {
       infoCallback_->onDeactivateConnection(*this);
@@ -1981,7 +2528,7 @@ void HTTPSession::detach(HTTPTransaction* txn) noexcept {
 size_t HTTPSession::sendWindowUpdate(HTTPTransaction* txn,
                                      uint32_t bytes) noexcept {
   size_t sent = codec_->generateWindowUpdate(writeBuf_, txn->getID(), bytes);
-  if (sent) {
+  if (sent || codec_->hasDeferredFrames()) {
     scheduleWrite();
   }
   return sent;
@@ -1997,6 +2544,15 @@ void HTTPSession::notifyIngressBodyProcessed(uint32_t bytes) noexcept {
   }
 }
 
+void HTTPSession::notifyDeferredWorkPending(HTTPTransaction* txn) noexcept {
+  if (!txn->deferredWorkHook_.is_linked()) {
+    deferredWorkTransactions_.push_back(*txn);
+  }
+  if (!isLoopCallbackScheduled()) {
+    sock_->getEventBase()->runInLoop(this);
+  }
+}
+
 void HTTPSession::notifyEgressBodyBuffered(int64_t bytes) noexcept {
   if (HTTPSessionBase::notifyEgressBodyBuffered(bytes, true) &&
       !inLoopCallback_ && !isLoopCallbackScheduled()) {
@@ -2037,6 +2593,10 @@ bool HTTPSession::getCurrentTransportInfo(TransportInfo* tinfo) {
     if (tinfo->tcpinfo.tcpi_rtt > 0) {
       transportInfo_.tcpinfo.tcpi_rtt = tinfo->tcpinfo.tcpi_rtt;
       transportInfo_.rtt = std::chrono::microseconds(tinfo->tcpinfo.tcpi_rtt);
+      if (rttProbeInterval_.count() > 0) {
+        // a free sample for the smoothed estimate, no PING needed
+        addRTTSample(transportInfo_.rtt);
+      }
     }
     transportInfo_.rtx = tinfo->rtx;
 #elif defined(__APPLE__)
@@ -2075,9 +2635,19 @@ unique_ptr<IOBuf> HTTPSession::getNextToSend(bool* cork,
     return nullptr;
   }
 
+  // Fold any control frames the codec deferred for coalescing (window
+  // updates, settings/ping acks) into the front of this flush
+  codec_->generateDeferredFrames(writeBuf_);
+
   // We always tack on at least one body packet to the current write buf
   // This ensures that a short HTTPS response will go out in a single SSL record
+  // Beyond that, keep draining ready transactions until the chain reaches the
+  // session write buffer limit, so each loop iteration issues one large
+  // writeChain instead of one small write per priority batch
+  const uint64_t coalescingTarget =
+      std::min<uint64_t>(getWriteBufferLimit(), kWriteReadyMax);
   while (!txnEgressQueue_.empty()) {
+    const uint64_t lenBeforePass = writeBuf_.chainLength();
     uint32_t toSend = kWriteReadyMax;
     if (connFlowControl_) {
       if (connFlowControl_->getAvailableSend() == 0) {
@@ -2122,17 +2692,83 @@ unique_ptr<IOBuf> HTTPSession::getNextToSend(bool* cork,
 
       VLOG(4) << *this << " egressing txnID=" << txnPair.first->getID()
               << " allowed=" << txnAllowed;
+      const auto txnId = txnPair.first->getID();
+      const uint64_t lenBeforeTxn = writeBuf_.chainLength();
       txnPair.first->onWriteReady(txnAllowed, txnPair.second);
+      // attribute the bytes this stream actually produced to its
+      // priority band
+      txnEgressQueue_.recordEgressBytes(txnId,
+                                        writeBuf_.chainLength() - lenBeforeTxn);
     }
     nextEgressResults_.clear();
     // it can be empty because of HTTPTransaction rate limiting.  We should
     // change rate limiting to clearPendingEgress while waiting.
-    if (!writeBuf_.empty()) {
+    if (writeBuf_.chainLength() >= coalescingTarget ||
+        writeBuf_.chainLength() == lenBeforePass) {
+      // full enough, or the last pass made no progress (rate limited txns)
       break;
     }
   }
   *timestampTx = false;
   *timestampAck = false;
+
+  // Cap this write at the pacing budget before looking at timestamp
+  // splits.  With no tokens accrued, skip the write entirely; the pacing
+  // timeout reschedules the write loop as the bucket refills.
+  uint64_t maxToWrite = writeBuf_.chainLength();
+  if (egressPacingBytesPerSec_ > 0 && maxToWrite > 0) {
+    const uint64_t allowed = refillPacingTokens();
+    if (allowed < maxToWrite) {
+      schedulePacingTimeout();
+      if (allowed == 0) {
+        VLOG(4) << *this << " pacing delayed egress of " << maxToWrite
+                << " bytes";
+        return nullptr;
+      }
+      maxToWrite = allowed;
+    }
+  }
+
+  // Cap at the tenant group's weighted egress share.  Like pacing, a
+  // dry deficit skips the write entirely and the group reschedules the
+  // write loop as rounds replenish it.
+  if (isolationGroup_ && maxToWrite > 0) {
+    if (egressBlockedOnGroup_) {
+      // already parked on the group from an earlier pass
+      return nullptr;
+    }
+    const uint64_t allowed = isolationGroup_->egressAllowance(maxToWrite);
+    if (allowed < maxToWrite) {
+      egressBlockedOnGroup_ = true;
+      isolationGroup_->waitForEgress(this);
+      if (allowed == 0) {
+        VLOG(4) << *this << " isolation group '" << isolationGroup_->getName()
+                << "' delayed egress of " << maxToWrite << " bytes";
+        return nullptr;
+      }
+      maxToWrite = allowed;
+    }
+  }
+
+  // Cap cold-connection writes at the adaptive record budget so the first
+  // responses ship in small, latency-optimal TLS records; once the budget
+  // has grown to the max this is a no-op (the TLS layer fragments at 16KB
+  // regardless).  See setTLSRecordSizePolicy.
+  if (tlsRecordSize_ > 0 && tlsRecordSize_ < tlsRecordMaxSize_) {
+    const auto now = getCurrentTime();
+    if (tlsRecordIdleReset_.count() > 0 &&
+        tlsRecordLastWrite_ != TimePoint() &&
+        millisecondsBetween(now, tlsRecordLastWrite_) >= tlsRecordIdleReset_) {
+      // idle long enough that the congestion window has likely collapsed;
+      // start the record ramp over
+      tlsRecordSize_ = tlsRecordInitialSize_;
+      tlsRecordBytesSinceReset_ = 0;
+    }
+    if (maxToWrite > tlsRecordSize_) {
+      maxToWrite = tlsRecordSize_;
+    }
+  }
+
   if (byteEventTracker_) {
     uint64_t needed = byteEventTracker_->preSend(
         cork, timestampTx, timestampAck, bytesWritten_);
@@ -2141,22 +2777,46 @@ unique_ptr<IOBuf> HTTPSession::getNextToSend(bool* cork,
               << " writeBuf_.chainLength(): " << writeBuf_.chainLength()
               << " txnEgressQueue_.empty(): " << txnEgressQueue_.empty();
 
-      if (needed < writeBuf_.chainLength()) {
+      if (needed > maxToWrite) {
+        // the pacing cap stops short of the byte to be timestamped; a
+        // later write will carry the timestamp flags
+        *timestampTx = false;
+        *timestampAck = false;
+      } else if (needed < writeBuf_.chainLength()) {
         // split the next SOM / EOM chunk
         VLOG(5) << *this << " splitting " << needed << " bytes out of a "
                 << writeBuf_.chainLength() << " bytes IOBuf";
-        *cork = true;
         if (sessionStats_) {
           sessionStats_->recordPresendIOSplit();
         }
-        writeBufSplit_ = true;
-        return writeBuf_.split(needed);
+        maxToWrite = needed;
       } else {
         CHECK_EQ(needed, writeBuf_.chainLength());
       }
     }
   }
 
+  consumePacingTokens(maxToWrite);
+  if (isolationGroup_) {
+    isolationGroup_->consumeEgress(maxToWrite);
+  }
+  if (tlsRecordSize_ > 0 && maxToWrite > 0) {
+    tlsRecordLastWrite_ = getCurrentTime();
+    tlsRecordBytesSinceReset_ += maxToWrite;
+    if (tlsRecordBytesSinceReset_ >= tlsRecordBulkThreshold_) {
+      // the connection has proven bulk throughput; stop splitting
+      tlsRecordSize_ = tlsRecordMaxSize_;
+    } else if (maxToWrite >= tlsRecordSize_) {
+      // a flush that filled the budget means more data was waiting: ramp
+      tlsRecordSize_ = std::min(tlsRecordSize_ * 2, tlsRecordMaxSize_);
+    }
+  }
+  if (maxToWrite < writeBuf_.chainLength()) {
+    *cork = true;
+    writeBufSplit_ = true;
+    return writeBuf_.split(maxToWrite);
+  }
+
   // cork if there are txns with pending egress and room to send them
   *cork = !txnEgressQueue_.empty() && !isConnWindowFull();
   return writeBuf_.move();
@@ -2178,6 +2838,7 @@ void HTTPSession::runLoopCallback() noexcept {
         txn->checkIfEgressRateLimitedByUpstream();
       });
     }
+    flushPendingSessionStats();
     checkForShutdown();
   });
   VLOG(5) << *this << " in loop callback";
@@ -2208,6 +2869,24 @@ void HTTPSession::runLoopCallback() noexcept {
       return;
     }
 
+    if (egressIovecBudget_ > 0 &&
+        writeBuf->countChainElements() > egressIovecBudget_) {
+      // The gather list outgrew the iovec budget - collapse runs of
+      // small buffers into slabs, keeping large ones zero-copy
+      IOBufDefragStats defragStats;
+      writeBuf = defragmentIOBufChain(
+          std::move(writeBuf), egressSmallBufferThreshold_, &defragStats);
+      if (sessionStats_) {
+        sessionStats_->recordEgressChainDefragmented(defragStats.buffersIn,
+                                                     defragStats.buffersOut,
+                                                     defragStats.bytesCopied);
+      }
+      VLOG(5) << *this << " defragmented egress chain "
+              << defragStats.buffersIn << " -> " << defragStats.buffersOut
+              << " buffers, copied " << defragStats.bytesCopied << " of "
+              << len << " bytes";
+    }
+
     if (isPrioritySampled()) {
       invokeOnAllTransactions([this](HTTPTransaction* txn) {
         txn->updateSessionBytesSheduled(bodyBytesPerWriteBuf_);
@@ -2221,6 +2900,9 @@ void HTTPSession::runLoopCallback() noexcept {
     flags |= (timestampAck) ? folly::WriteFlags::EOR : folly::WriteFlags::NONE;
     CHECK(!pendingWrite_.hasValue());
     pendingWrite_.emplace(len, DestructorGuard(this));
+    if (writeBufAutoTune_) {
+      pendingWriteStart_ = getCurrentTime();
+    }
 
     if (!writeTimeout_.isScheduled()) {
       // Any performance concern here?
@@ -2242,7 +2924,11 @@ void HTTPSession::runLoopCallback() noexcept {
     // writeChain can result in a writeError and trigger the shutdown code path
   }
   if (numActiveWrites_ == 0 && !writesShutdown() && hasMoreWrites() &&
-      (!connFlowControl_ || connFlowControl_->getAvailableSend())) {
+      (!connFlowControl_ || connFlowControl_->getAvailableSend()) &&
+      !pacingTimeout_.isScheduled() && !egressBlockedOnGroup_) {
+    // when paced out of tokens, the pacing timeout owns the reschedule;
+    // same for an isolation group wait -- spinning the loop callback
+    // here would just burn the cpu waiting
     scheduleWrite();
   }
 
@@ -2254,6 +2940,14 @@ void HTTPSession::runLoopCallback() noexcept {
       sock_->setReadCB(this);
     }
   }
+
+  // Per-transaction deferred work runs last, with the transactions
+  // still warm from the processing above
+  while (!deferredWorkTransactions_.empty()) {
+    auto& txn = deferredWorkTransactions_.front();
+    deferredWorkTransactions_.pop_front();
+    txn.runDeferredWork();
+  }
   // checkForShutdown is now in ScopeGuard
 }
 
@@ -2331,6 +3025,7 @@ void HTTPSession::shutdownTransport(bool shutdownReads,
     if (!hasMoreWrites() &&
         (transactions_.empty() || codec_->closeOnEgressComplete())) {
       writes_ = SocketState::SHUTDOWN;
+      pacingTimeout_.cancelTimeout();
       if (byteEventTracker_) {
         byteEventTracker_->drainByteEvents();
       }
@@ -2366,6 +3061,7 @@ void HTTPSession::shutdownTransport(bool shutdownReads,
     }
     // Once reads are shutdown the parser should stop processing
     codec_->setParserPaused(true);
+    ingressBatchCb_.cancelLoopCallback();
   }
 
   if (notifyIngressShutdown || notifyEgressShutdown) {
@@ -2411,6 +3107,7 @@ void HTTPSession::shutdownTransportWithReset(ProxygenError errorCode,
     }
     VLOG(4) << *this << " cancel write timer";
     writeTimeout_.cancelTimeout();
+    pacingTimeout_.cancelTimeout();
     resetSocketOnShutdown_ = true;
   }
 
@@ -2438,6 +3135,45 @@ void HTTPSession::shutdownTransportWithReset(ProxygenError errorCode,
   checkForShutdown();
 }
 
+folly::AsyncTransport::UniquePtr HTTPSession::extractTunnelTransport() noexcept {
+  // Only a serial-protocol session carrying a single transaction can
+  // collapse into a raw tunnel; with pipelining or multiplexing the
+  // socket still carries framing for other streams.
+  if (!sock_ || codec_->supportsParallelRequests() ||
+      transactions_.size() != 1 || readsShutdown() || writesShutdown()) {
+    return nullptr;
+  }
+  // The response establishing the tunnel must already be on the wire,
+  // and no unparsed ingress may be stranded here, or the peers would
+  // miss bytes that only this session has seen.
+  if (!writeBuf_.empty() || pendingWrite_.hasValue() || numActiveWrites_ > 0 ||
+      !readBuf_.empty()) {
+    return nullptr;
+  }
+  DestructorGuard guard(this);
+  VLOG(4) << *this << " extracting transport for tunnel";
+  shutdownRead();
+  writes_ = SocketState::SHUTDOWN;
+  writeTimeout_.cancelTimeout();
+  pacingTimeout_.cancelTimeout();
+  auto sock = std::move(sock_);
+  if (auto* asyncSocket = sock->getUnderlyingTransport<AsyncSocket>()) {
+    asyncSocket->setBufferCallback(nullptr);
+  }
+  // Detach the transaction without generating any egress; the caller
+  // owns the byte stream from here on.
+  errorOnAllTransactions(kErrorEOF, "transport extracted for tunnel");
+  if (byteEventTracker_) {
+    byteEventTracker_->drainByteEvents();
+  }
+  if (isLoopCallbackScheduled()) {
+    cancelLoopCallback();
+  }
+  shutdownTransportCb_.reset();
+  checkForShutdown();
+  return sock;
+}
+
 void HTTPSession::shutdownRead() {
   VLOG(10) << *this << " shutting down reads";
   sock_->setReadCB(nullptr);
@@ -2463,15 +3199,18 @@ void HTTPSession::checkForShutdown() {
   //   * There are no transactions remaining on the session.
   if (writesShutdown() && transactions_.empty() && !isLoopCallbackScheduled()) {
     VLOG(4) << "destroying " << *this;
-    shutdownRead();
-    auto asyncSocket = sock_->getUnderlyingTransport<folly::AsyncSocket>();
-    if (asyncSocket) {
-      asyncSocket->setBufferCallback(nullptr);
-    }
-    if (resetSocketOnShutdown_) {
-      sock_->closeWithReset();
-    } else {
-      sock_->closeNow();
+    // sock_ is gone already if it was extracted for a tunnel
+    if (sock_) {
+      shutdownRead();
+      auto asyncSocket = sock_->getUnderlyingTransport<folly::AsyncSocket>();
+      if (asyncSocket) {
+        asyncSocket->setBufferCallback(nullptr);
+      }
+      if (resetSocketOnShutdown_) {
+        sock_->closeWithReset();
+      } else {
+        sock_->closeNow();
+      }
     }
     destroy();
   }
@@ -2522,6 +3261,11 @@ size_t HTTPSession::sendPing() {
 size_t HTTPSession::sendPing(uint64_t data) {
   const size_t bytes = codec_->generatePingRequest(writeBuf_, data);
   if (bytes) {
+    // Clock the reply for RTT sampling; one timed PING at a time is
+    // enough and every ping the session sends is fair game
+    if (rttProbeInterval_.count() > 0 && !timedPing_) {
+      timedPing_.emplace(data, std::chrono::steady_clock::now());
+    }
     scheduleWrite();
   }
   return bytes;
@@ -2553,10 +3297,56 @@ HTTPSession::PingProber::PingProber(HTTPSession& session,
   } // else session will start them when a stream is created
 }
 
+void HTTPSession::enableIdleLivenessProbes(std::chrono::seconds initialInterval,
+                                           std::chrono::seconds maxInterval,
+                                           std::chrono::seconds timeout) {
+  if (isHTTP2CodecProtocol(codec_->getProtocol())) {
+    pingProber_ =
+        std::make_unique<PingProber>(*this, initialInterval, maxInterval,
+                                     timeout);
+  }
+}
+
+HTTPSession::PingProber::PingProber(HTTPSession& session,
+                                    std::chrono::seconds initialInterval,
+                                    std::chrono::seconds maxInterval,
+                                    std::chrono::seconds timeout)
+    : session_(session),
+      interval_(initialInterval),
+      timeout_(timeout),
+      maxInterval_(maxInterval),
+      currentInterval_(initialInterval),
+      idleMode_(true) {
+  if (session_.getNumStreams() == 0) {
+    startProbes();
+  } // else probing starts when the session goes idle
+}
+
 void HTTPSession::PingProber::startProbes() {
   refreshTimeout(/*onIngress=*/false);
 }
 
+void HTTPSession::PingProber::onStreamsActive(bool active) {
+  if (!idleMode_) {
+    // Classic mode watches the peer while requests are in flight
+    if (active) {
+      startProbes();
+    } else {
+      cancelProbes();
+    }
+    return;
+  }
+  // Idle-liveness mode probes the gaps between requests; stream
+  // activity is itself proof of life, so restart the backoff from the
+  // initial interval
+  currentInterval_ = interval_;
+  if (active) {
+    cancelProbes();
+  } else {
+    startProbes();
+  }
+}
+
 void HTTPSession::PingProber::cancelProbes() {
   if (pingVal_) {
     VLOG(4) << "Canceling active probe sess=" << session_;
@@ -2566,6 +3356,25 @@ void HTTPSession::PingProber::cancelProbes() {
 }
 
 void HTTPSession::PingProber::refreshTimeout(bool onIngress) {
+  if (idleMode_) {
+    // Ingress is proof of life: restart the backoff, and push the next
+    // probe out only if one is pending (streams may be active, in which
+    // case nothing is scheduled and that's correct)
+    if (onIngress) {
+      currentInterval_ = interval_;
+      if (!isScheduled()) {
+        return;
+      }
+    }
+    if (pingVal_) {
+      // probe in flight; its ack or timeout drives what happens next
+      return;
+    }
+    VLOG(4) << "Scheduling next liveness probe in " << currentInterval_.count()
+            << "s for sess=" << session_;
+    session_.getEventBase()->timer().scheduleTimeout(this, currentInterval_);
+    return;
+  }
   if (!pingVal_ && (!onIngress || extendIntervalOnIngress_)) {
     VLOG(4) << "Scheduling next ping probe for sess=" << session_;
     session_.getEventBase()->timer().scheduleTimeout(this, interval_);
@@ -2575,6 +3384,11 @@ void HTTPSession::PingProber::refreshTimeout(bool onIngress) {
 void HTTPSession::PingProber::timeoutExpired() noexcept {
   if (pingVal_) {
     VLOG(3) << "Ping probe timed out, dropping connection sess=" << session_;
+    if (idleMode_ && session_.sessionStats_) {
+      // A dead reap, as opposed to an idle connection that was still
+      // answering probes when its idle timeout closed it
+      session_.sessionStats_->recordDeadSessionReaped();
+    }
     session_.dropConnection("Ping probe timed out");
   } else {
     pingVal_ = folly::Random::rand64();
@@ -2595,9 +3409,67 @@ void HTTPSession::PingProber::onPingReply(uint64_t pingVal) {
   }
   VLOG(4) << "Received expected ping, rescheduling";
   pingVal_.reset();
+  if (idleMode_) {
+    // Still alive, just idle; back the probe rate off exponentially
+    if (session_.sessionStats_) {
+      session_.sessionStats_->recordLivenessProbeAcked();
+    }
+    currentInterval_ = std::min(currentInterval_ * 2, maxInterval_);
+  }
   refreshTimeout(/*onIngress=*/false);
 }
 
+void HTTPSession::enableRTTSampling(
+    std::chrono::milliseconds minProbeInterval) {
+  CHECK_GT(minProbeInterval.count(), 0);
+  rttProbeInterval_ = minProbeInterval;
+}
+
+void HTTPSession::addRTTSample(std::chrono::microseconds sample) {
+  if (sample.count() <= 0) {
+    return;
+  }
+  // TCP-style smoothing: 7/8 history, 1/8 new sample
+  srtt_ = srtt_.count() > 0 ? (srtt_ * 7 + sample) / 8 : sample;
+  lastRTTSample_ = std::chrono::steady_clock::now();
+  if (sessionStats_) {
+    sessionStats_->recordSessionRTT(sample);
+  }
+}
+
+void HTTPSession::maybeSendRTTProbe() {
+  if (rttProbeInterval_.count() == 0 ||
+      !isHTTP2CodecProtocol(codec_->getProtocol())) {
+    return;
+  }
+  auto now = std::chrono::steady_clock::now();
+  if (timedPing_) {
+    // A lost reply (or one swallowed before sampling was enabled) must
+    // not wedge sampling forever; declare the probe lost after a grace
+    // period and try again
+    if (now - timedPing_->second >
+        rttProbeInterval_ + std::chrono::seconds(1)) {
+      timedPing_.reset();
+    }
+    return;
+  }
+  if (srtt_.count() > 0 && now - lastRTTSample_ < rttProbeInterval_) {
+    return;
+  }
+  sendPing(folly::Random::rand64());
+}
+
+folly::Optional<std::chrono::microseconds> HTTPSession::getSessionRTT() const {
+  if (srtt_.count() > 0) {
+    return srtt_;
+  }
+  // Fall back to the kernel's estimate from accept time, if we have one
+  if (transportInfo_.rtt.count() > 0) {
+    return transportInfo_.rtt;
+  }
+  return folly::none;
+}
+
 HTTPCodec::StreamID HTTPSession::sendPriority(http2::PriorityUpdate pri) {
   if (!codec_->supportsParallelRequests()) {
     // For HTTP/1.1, don't call createStream()
@@ -2632,6 +3504,15 @@ HTTPTransaction* HTTPSession::findTransaction(HTTPCodec::StreamID streamID) {
   if (lastTxn_ && streamID == lastTxn_->getID()) {
     return lastTxn_;
   }
+  if (txnRing_) {
+    if (auto* txn = txnRing_->find(streamID)) {
+      DCHECK(transactionIds_.count(streamID));
+      lastTxn_ = txn;
+      return txn;
+    }
+    // fall through: stragglers that fell behind the ring's window are
+    // still in the map
+  }
   auto it = transactions_.find(streamID);
   if (it == transactions_.end()) {
     DCHECK(transactionIds_.count(streamID) == 0);
@@ -2663,7 +3544,7 @@ HTTPTransaction* HTTPSession::createTransaction(
 
   if (transactions_.empty()) {
     if (pingProber_) {
-      pingProber_->startProbes();
+      pingProber_->onStreamsActive(true);
     }
     if (infoCallback_) {
       infoCallback_->onActivateConnection(*this);
@@ -2691,22 +3572,33 @@ HTTPTransaction* HTTPSession::createTransaction(
                             priority,
                             assocStreamID,
                             exAttributes,
-                            setIngressTimeoutAfterEom_));
+                            setIngressTimeoutAfterEom_,
+                            getBatchedStatCounters()));
 
   CHECK(matchPair.second) << "Emplacement failed, despite earlier "
                              "existence check.";
   transactionIds_.emplace(streamID);
 
   HTTPTransaction* txn = &matchPair.first->second;
+  if (!txnRing_ && codec_->supportsParallelRequests()) {
+    txnRing_ = std::make_unique<TransactionRing>();
+  }
+  if (txnRing_) {
+    txnRing_->insert(streamID, txn);
+  }
 
   if (isPrioritySampled()) {
     txn->setPrioritySampled(true /* sampled */);
   }
 
   if (getNumTxnServed() > 0) {
-    auto stats = txn->getSessionStats();
-    if (stats != nullptr) {
-      stats->recordSessionReused();
+    if (auto* counters = getBatchedStatCounters()) {
+      ++counters->sessionsReused;
+    } else {
+      auto stats = txn->getSessionStats();
+      if (stats != nullptr) {
+        stats->recordSessionReused();
+      }
     }
   }
 
@@ -2715,6 +3607,9 @@ HTTPTransaction* HTTPSession::createTransaction(
 
   ++liveTransactions_;
   incrementSeqNo();
+  if (windowUpdateStrategyFactory_) {
+    txn->setWindowUpdateStrategy(windowUpdateStrategyFactory_());
+  }
   txn->setReceiveWindow(receiveStreamWindowSize_);
 
   if (isUpstream() && !txn->isPushed()) {
@@ -2739,6 +3634,9 @@ void HTTPSession::incrementIncomingStreams(HTTPTransaction* txn) {
   DCHECK(txn);
   incomingStreams_++;
   txn->setIsCountedTowardsStreamLimit();
+  if (isolationGroup_) {
+    isolationGroup_->beginTransaction();
+  }
 }
 
 void HTTPSession::writeSuccess() noexcept {
@@ -2751,11 +3649,20 @@ void HTTPSession::writeSuccess() noexcept {
   VLOG(10) << "Cancel write timer on last successful write";
   writeTimeout_.cancelTimeout();
   pendingWrite_.reset();
+  if (writeBufAutoTune_) {
+    tuneWriteBufferLimit(bytesWritten);
+  }
 
   if (infoCallback_) {
     infoCallback_->onWrite(*this, bytesWritten);
   }
 
+  PROXYGEN_SDT(session_egress_flush, this, bytesWritten);
+
+  // The session just proved it is writing anyway; a stale RTT estimate
+  // can refresh itself here without waking anything up
+  maybeSendRTTProbe();
+
   VLOG(5) << "total bytesWritten_: " << bytesWritten_;
 
   // processByteEvents will return true if it has been replaced with another
@@ -2965,7 +3872,9 @@ void HTTPSession::onConnectionSendWindowOpen() {
 void HTTPSession::onConnectionSendWindowClosed() {
   if (!txnEgressQueue_.empty()) {
     VLOG(4) << *this << " session stalled by flow control";
-    if (sessionStats_) {
+    if (auto* counters = getBatchedStatCounters()) {
+      ++counters->sessionsStalled;
+    } else if (sessionStats_) {
       sessionStats_->recordSessionStalled();
     }
   }
@@ -3051,13 +3960,26 @@ void HTTPSession::onTxnByteEventWrittenToBuf(const ByteEvent& event) noexcept {
   }
 }
 
+void HTTPSession::onTxnByteEventsWrittenToBuf(
+    folly::Range<ByteEvent* const*> events) noexcept {
+  // hoist the common early-out so a batch costs one check, not one
+  // virtual call per event
+  if (!sock_->isEorTrackingEnabled()) {
+    return;
+  }
+  for (auto event : events) {
+    onTxnByteEventWrittenToBuf(*event);
+  }
+}
+
 bool HTTPSession::isDetachable(bool checkSocket) const {
   if (checkSocket && sock_ && !sock_->isDetachable()) {
     return false;
   }
   return transactions_.size() == 0 && getNumIncomingStreams() == 0 &&
          !writesPaused() && !flowControlTimeout_.isScheduled() &&
-         !writeTimeout_.isScheduled() && !drainTimeout_.isScheduled();
+         !writeTimeout_.isScheduled() && !drainTimeout_.isScheduled() &&
+         !pacingTimeout_.isScheduled();
 }
 
 void HTTPSession::invokeOnAllTransactions(
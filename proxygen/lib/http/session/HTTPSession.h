@@ -22,6 +22,7 @@
 #include <proxygen/lib/http/HTTPConstants.h>
 #include <proxygen/lib/http/HTTPHeaderSize.h>
 #include <proxygen/lib/http/codec/ControlMessageRateLimitFilter.h>
+#include <proxygen/lib/http/codec/IngressRateLimitFilter.h>
 #include <proxygen/lib/http/codec/FlowControlFilter.h>
 #include <proxygen/lib/http/codec/HTTPCodec.h>
 #include <proxygen/lib/http/codec/HTTPCodecFilter.h>
@@ -29,8 +30,12 @@
 #include <proxygen/lib/http/session/HTTPEvent.h>
 #include <proxygen/lib/http/session/HTTPSessionBase.h>
 #include <proxygen/lib/http/session/HTTPTransaction.h>
+#include <proxygen/lib/http/session/IsolationGroup.h>
 #include <proxygen/lib/http/session/SecondaryAuthManagerBase.h>
+#include <proxygen/lib/utils/ThreadRecyclingAllocator.h>
 #include <proxygen/lib/utils/WheelTimerInstance.h>
+#include <array>
+#include <map>
 #include <queue>
 #include <set>
 #include <vector>
@@ -39,6 +44,7 @@ namespace proxygen {
 
 class HTTPSessionController;
 class HTTPSessionStats;
+class IngressPriorityScheduler;
 
 #define PROXYGEN_HTTP_SESSION_USES_BASE 1
 constexpr uint32_t kDefaultMaxConcurrentOutgoingStreamsRemote = 100000;
@@ -55,7 +61,9 @@ class HTTPSession
     , private folly::EventBase::LoopCallback
     , private folly::AsyncTransport::ReadCallback
     , private folly::AsyncTransport::ReplaySafetyCallback
-    , private folly::AsyncTransport::WriteCallback {
+    , private folly::AsyncTransport::WriteCallback
+    , private IngressRateLimitFilter::ReadThrottler
+    , private IsolationGroup::Participant {
  public:
   using UniquePtr = std::unique_ptr<HTTPSession, Destructor>;
 
@@ -156,6 +164,10 @@ class HTTPSession
 
   HTTPTransaction::Transport::Type getSessionType() const noexcept override;
 
+  folly::EventBase* getTransportEventBase() noexcept override {
+    return getEventBase();
+  }
+
   /**
    * Set the maximum number of transactions the remote can open at once.
    */
@@ -167,6 +179,121 @@ class HTTPSession
    */
   void setEgressBytesLimit(uint64_t bytesLimit);
 
+  /**
+   * Pace this session's writes to the transport at the given rate.  The
+   * write loop releases at most a token-bucket burst per write, so a large
+   * response egresses as spaced bursts instead of one transport-buffer
+   * sized dump that queues in downstream middleboxes.  maxBurstBytes of
+   * zero derives the burst from the rate (roughly 10ms worth, with a
+   * floor).  A rate of zero (the default) disables pacing.  Must be
+   * called from the session's event loop thread.
+   */
+  void setEgressPacingRate(uint64_t bitsPerSecond, uint64_t maxBurstBytes = 0);
+
+  /**
+   * Allow pipelined HTTP/1.1 requests to be dispatched concurrently
+   * instead of pausing ingress until the head response completes.
+   * Egress from a transaction that is not at the head of the pipeline
+   * is parked in the session and replayed in request order once every
+   * earlier response has been generated.  At most maxBytes of parked
+   * response body may accumulate; a transaction that crosses the cap
+   * has its egress paused until its turn comes.  Zero (the default)
+   * keeps the historical behavior of serializing dispatch.  Only
+   * meaningful for downstream sessions on serial codecs.
+   */
+  void setEgressReorderLimit(uint64_t maxBytes) {
+    egressReorderLimit_ = maxBytes;
+  }
+
+  /**
+   * Install a WindowUpdateStrategy on every transaction this session
+   * creates (see WindowUpdateStrategy.h); the factory is invoked once
+   * per transaction.  nullptr (the default) keeps the historical eager
+   * window release.  Existing transactions are unaffected.
+   */
+  void setWindowUpdateStrategyFactory(
+      std::function<std::unique_ptr<WindowUpdateStrategy>()> factory) {
+    windowUpdateStrategyFactory_ = std::move(factory);
+  }
+
+  /**
+   * Cap on gather-list length per socket write.  An egress chain with
+   * more buffers than this gets a defragmentation pass before
+   * writeChain: runs of buffers under smallBufferThreshold are copied
+   * into 4KB/16KB slabs, larger buffers stay zero-copy (see
+   * proxygen/lib/utils/IOBufDefrag.h).  Keeps writev well under
+   * IOV_MAX, where the kernel truncates the list and forces a second
+   * syscall plus partial-write bookkeeping.  Zero disables the pass.
+   */
+  void setEgressIovecBudget(
+      size_t budget,
+      size_t smallBufferThreshold = kDefaultSmallBufferThreshold) {
+    egressIovecBudget_ = budget;
+    egressSmallBufferThreshold_ = smallBufferThreshold;
+  }
+
+  static constexpr size_t kDefaultEgressIovecBudget = 512;
+  static constexpr size_t kDefaultSmallBufferThreshold = 4096;
+
+  /**
+   * Adapt the size of egress writes to the connection's maturity, so a
+   * TLS transport emits latency-optimal records early and full-size
+   * records once the connection is provably moving bulk data.  Writes
+   * are capped at initialSize (roughly one MTU of ciphertext) to begin
+   * with; the cap doubles on every flush that fills it and jumps to
+   * maxSize outright once bulkThresholdBytes have been written since the
+   * last reset.  After idleReset without a write the cap drops back to
+   * initialSize, since the congestion window has likely collapsed too.
+   * At maxSize the cap is a no-op -- the TLS layer fragments at 16KB
+   * anyway.  An initialSize of zero (the default) disables adaptation.
+   */
+  /**
+   * Auto-tune the write buffer limit from the socket's measured drain
+   * rate instead of the static setWriteBufferLimit() default.  Each
+   * write completion yields a throughput sample; the limit is sized to
+   * cover roughly two RTTs of drain at the smoothed rate, clamped to
+   * [minLimit, maxLimit].  Slowdowns are adopted immediately so a
+   * stalling peer sheds buffer fast, while speedups grow the limit
+   * gradually.  Fast clients stop getting throttled by a low static
+   * limit and slow clients stop pinning megabytes of egress.  Must be
+   * called before the session starts writing.
+   */
+  void enableWriteBufferAutoTuning(uint32_t minLimit, uint32_t maxLimit);
+
+  void setTLSRecordSizePolicy(uint32_t initialSize,
+                              uint32_t maxSize,
+                              uint64_t bulkThresholdBytes,
+                              std::chrono::milliseconds idleReset);
+
+  /**
+   * When enabled, ingress arriving in a single event loop iteration is
+   * accumulated into readBuf_ and handed to the codec in one pass at the
+   * end of the iteration, instead of paying parser entry/exit per socket
+   * read.  Batching is skipped whenever the buffered bytes exceed the
+   * batch budget or the event loop is already running behind, so it never
+   * adds more than one loop iteration of latency.
+   */
+  void setIngressBatchingEnabled(bool enabled) {
+    ingressBatchingEnabled_ = enabled;
+  }
+
+  /**
+   * When enabled, the session reports its read buffers as non-movable,
+   * so a TLS transport decrypts directly into the pooled read slab
+   * handed out by getReadBuffer() instead of decrypting into its own
+   * buffers and delivering (or copying) them here.  The codec already
+   * parses exact-sized views of the slab, so decrypted bytes travel
+   * from the record layer into the parser without an intermediate copy.
+   * Header bytes the codec pins keep a reference to their slab only;
+   * parsed-past slabs are trimmed off the read buffer and recycled
+   * independently.  Leave disabled on plain-TCP transports, where the
+   * buffer-movable path is already zero-copy.  Must be set before reads
+   * start.
+   */
+  void setDecryptInPlaceEnabled(bool enabled) {
+    decryptInPlace_ = enabled;
+  }
+
   /**
    * If set to true, HTTPSession will abort the push streams when receiving
    * a STREAM_RST on the associated stream.
@@ -269,6 +396,40 @@ class HTTPSession
       std::chrono::milliseconds directErrorHandlingIntervalDuration =
           kDefaultDirectErrorHandlingDuration);
 
+  /**
+   * Install a hierarchical token-bucket ingress limiter, nesting this
+   * session's buckets under the given per-worker scope.  Supersedes the
+   * interval-based control message limits above; DELAY_READ overflow
+   * throttles this session's reads.  May only be called once, on the
+   * session's worker thread, and the scope must outlive the session.
+   */
+  void setIngressRateLimiter(IngressRateLimiter& limiter,
+                             const IngressRateLimitConfig& config);
+
+  /**
+   * Tag this session with a tenant isolation group (see
+   * IsolationGroupSet).  Parsed ingress and written egress are charged
+   * against the group's weighted deficits, and incoming streams count
+   * toward the group's transaction quota.  Must be set at accept time,
+   * before any ingress is parsed, on the session's worker thread; the
+   * group must outlive the session.
+   */
+  void setIsolationGroup(IsolationGroup* group);
+
+  IsolationGroup* getIsolationGroup() const {
+    return isolationGroup_;
+  }
+
+  /**
+   * Classify this session as bulk ingress on the worker's two-tier
+   * scheduler: its reads are parsed in the scheduler's end-of-iteration
+   * pass, after every latency-critical session's reads, capped by the
+   * per-tick bulk byte budget.  Must be set at accept time, before any
+   * ingress arrives, on the session's worker thread; the scheduler must
+   * outlive the session.
+   */
+  void setBulkIngressScheduler(IngressPriorityScheduler* scheduler);
+
   /**
    * Get the SecondaryAuthManager attached to this session.
    */
@@ -315,6 +476,38 @@ class HTTPSession
                         bool extendIntervalOnIngress,
                         bool immediate = false) override;
 
+  /**
+   * The inverse of enablePingProbes(): probe the connection while it is
+   * idle (no streams), so dead peers are reaped instead of holding
+   * session memory until the next write fails.  The probe interval
+   * starts at initialInterval and doubles after every acked probe up to
+   * maxInterval, so long-idle-but-alive connections converge to one
+   * cheap PING per maxInterval; any ingress or new stream resets the
+   * backoff.  An unacked probe (after timeout) drops the connection and
+   * records a dead reap in the session stats, distinguishing it from
+   * plain idle timeouts.  Probes share the worker's wheel timer; no
+   * per-session timer is created.  HTTP/2 only, like enablePingProbes().
+   */
+  void enableIdleLivenessProbes(std::chrono::seconds initialInterval,
+                                std::chrono::seconds maxInterval,
+                                std::chrono::seconds timeout);
+
+  /**
+   * Maintain a smoothed RTT estimate for the session, exposed via
+   * getSessionRTT() and recorded into the session stats.  Samples come
+   * free wherever possible: every PING this session already sends
+   * (liveness probes included) is clocked against its reply, and the
+   * kernel's TCP_INFO rtt is folded in whenever transport info is
+   * refreshed.  A dedicated PING is only issued when the estimate is
+   * cold or older than minProbeInterval, piggybacked on a write the
+   * session performed anyway, so an active session never spends more
+   * than one extra frame per interval and an idle one spends none.
+   * Probing requires HTTP/2; TCP_INFO samples work on any protocol.
+   */
+  void enableRTTSampling(std::chrono::milliseconds minProbeInterval);
+
+  folly::Optional<std::chrono::microseconds> getSessionRTT() const override;
+
  protected:
   /**
    * HTTPSession is an abstract base class and cannot be instantiated
@@ -426,13 +619,39 @@ class HTTPSession
   void readTimeoutExpired() noexcept;
   void writeTimeoutExpired() noexcept;
   void flowControlTimeoutExpired() noexcept;
+  void pacingTimeoutExpired() noexcept;
+
+  /**
+   * Token-bucket helpers for egress pacing.  refillPacingTokens() accrues
+   * tokens from the wall time elapsed since the last refill (capped at
+   * the burst size) and returns the current balance;
+   * consumePacingTokens() charges a completed write against it.
+   */
+  uint64_t refillPacingTokens();
+  void consumePacingTokens(uint64_t bytes);
+
+  /**
+   * Fold a completed write into the drain-rate estimate and resize the
+   * write buffer limit accordingly; see enableWriteBufferAutoTuning().
+   */
+  void tuneWriteBufferLimit(uint64_t bytesWritten);
+  void schedulePacingTimeout();
 
   // AsyncTransport::ReadCallback methods
   void getReadBuffer(void** buf, size_t* bufSize) override;
   void readDataAvailable(size_t readSize) noexcept override;
   bool isBufferMovable() noexcept override;
   void readBufferAvailable(std::unique_ptr<folly::IOBuf>) noexcept override;
-  void processReadData();
+  /**
+   * Feed buffered ingress to the codec.  One pass is bounded by a parse
+   * budget (time in the codec / transactions created) so a session with
+   * megabytes of pipelined requests cannot monopolize the loop; when the
+   * budget runs out the remainder is requeued for the next tick.
+   * Teardown paths pass enforceParseBudget=false to drain fully.
+   */
+  void processReadData(bool enforceParseBudget = true);
+  void maybeBatchReadData();
+  void flushPendingReadData();
   void readEOF() noexcept override;
   void readErr(const folly::AsyncSocketException&) noexcept override;
 
@@ -510,13 +729,14 @@ class HTTPSession
                    ErrorCode statusCode) noexcept override;
   size_t sendPriority(HTTPTransaction* txn,
                       const http2::PriorityUpdate& pri) noexcept override;
-  size_t changePriority(HTTPTransaction* /*txn*/,
-                        HTTPPriority /* pri */) noexcept override;
+  size_t changePriority(HTTPTransaction* txn,
+                        HTTPPriority pri) noexcept override;
   void detach(HTTPTransaction* txn) noexcept override;
   size_t sendWindowUpdate(HTTPTransaction* txn,
                           uint32_t bytes) noexcept override;
   void notifyPendingEgress() noexcept override;
   void notifyIngressBodyProcessed(uint32_t bytes) noexcept override;
+  void notifyDeferredWorkPending(HTTPTransaction* txn) noexcept override;
   void notifyEgressBodyBuffered(int64_t bytes) noexcept override;
   HTTPTransaction* newPushedTransaction(
       HTTPCodec::StreamID assocStreamId,
@@ -540,6 +760,12 @@ class HTTPSession
     return sock_.get();
   }
 
+  /**
+   * Hands the socket off for codec-free tunneling after a CONNECT or
+   * upgrade; see HTTPTransaction::Transport::extractTunnelTransport().
+   */
+  folly::AsyncTransport::UniquePtr extractTunnelTransport() noexcept override;
+
   /**
    * Drains the current transactions and prevents new transactions from being
    * created on this session. If this is an upstream session and the
@@ -647,7 +873,7 @@ class HTTPSession
   void onWriteCompleted();
 
   /** Stop reading from the transport until resumeReads() is called */
-  void pauseReads();
+  void pauseReads() override;
 
   /**
    * Send a session layer abort and shutdown the transport for reads and
@@ -666,7 +892,7 @@ class HTTPSession
    * @note If any codec callbacks arrived while reads were paused,
    * they will be processed before network reads resume.
    */
-  void resumeReads();
+  void resumeReads() override;
 
   /** Check whether the session has any writes in progress or upcoming */
   bool hasMoreWrites() const;
@@ -702,6 +928,15 @@ class HTTPSession
   void pauseReadsImpl();
   void resumeReadsImpl();
 
+  // IngressRateLimitFilter::ReadThrottler, for DELAY_READ overflow
+  void pauseIngressForRateLimit() noexcept override;
+  void resumeIngressForRateLimit() noexcept override;
+
+  // IsolationGroup::Participant, fired when the group's deficit
+  // replenishes after this session parked on it
+  void groupIngressUnblocked() noexcept override;
+  void groupEgressUnblocked() noexcept override;
+
   void rescheduleLoopCallbacks() {
     if (!isLoopCallbackScheduled()) {
       sock_->getEventBase()->runInLoop(this);
@@ -720,6 +955,7 @@ class HTTPSession
     if (shutdownTransportCb_) {
       shutdownTransportCb_->cancelLoopCallback();
     }
+    ingressBatchCb_.cancelLoopCallback();
   }
 
   // protected members
@@ -745,9 +981,83 @@ class HTTPSession
   /** Chain of ingress IOBufs */
   folly::IOBufQueue readBuf_{folly::IOBufQueue::cacheChainLength()};
 
-  folly::F14NodeMap<HTTPCodec::StreamID, HTTPTransaction> transactions_;
+  // node map so transactions are stable in memory; nodes are recycled
+  // through a per-thread free list instead of malloc on every request
+  folly::F14NodeMap<
+      HTTPCodec::StreamID,
+      HTTPTransaction,
+      folly::f14::DefaultHasher<HTTPCodec::StreamID>,
+      folly::f14::DefaultKeyEqual<HTTPCodec::StreamID>,
+      ThreadRecyclingAllocator<
+          std::pair<const HTTPCodec::StreamID, HTTPTransaction>>>
+      transactions_;
   folly::F14FastSet<HTTPCodec::StreamID> transactionIds_;
 
+  /**
+   * Lookup accelerator for frame demux.  Transactions stay owned by
+   * transactions_ (a node map, so pointers are stable); the ring caches
+   * pointers for a sliding window of stream IDs so findTransaction is a
+   * single array load for the sequentially allocated IDs that dominate
+   * HTTP/2 traffic.  The ring is direct-mapped on the raw ID, which keeps
+   * odd (client) and even (pushed) streams from aliasing.  Streams that
+   * fall behind the window when it advances ("stragglers") are simply
+   * served by the map probe instead.
+   */
+  class TransactionRing {
+   public:
+    HTTPTransaction* find(HTTPCodec::StreamID id) const {
+      if (id < base_ || id - base_ >= kSize) {
+        return nullptr;
+      }
+      auto* txn = slots_[id & kMask];
+      DCHECK(!txn || txn->getID() == id);
+      return txn;
+    }
+
+    void insert(HTTPCodec::StreamID id, HTTPTransaction* txn) {
+      if (id < base_) {
+        // the window already advanced past this ID; leave it to the map
+        return;
+      }
+      if (id - base_ >= kSize) {
+        advanceTo(id);
+      }
+      slots_[id & kMask] = txn;
+    }
+
+    void erase(HTTPCodec::StreamID id) {
+      if (id >= base_ && id - base_ < kSize) {
+        slots_[id & kMask] = nullptr;
+      }
+    }
+
+   private:
+    void advanceTo(HTTPCodec::StreamID id) {
+      auto newBase = id - kSize + 1;
+      if (newBase - base_ >= kSize) {
+        slots_.fill(nullptr);
+      } else {
+        // evict the vacated slots so they cannot alias the new window
+        for (auto vacated = base_; vacated < newBase; vacated++) {
+          slots_[vacated & kMask] = nullptr;
+        }
+      }
+      base_ = newBase;
+    }
+
+    // 256 raw IDs cover 128 concurrent same-parity streams, comfortably
+    // above the default concurrency limit
+    static constexpr size_t kSize = 256;
+    static constexpr size_t kMask = kSize - 1;
+
+    HTTPCodec::StreamID base_{0};
+    std::array<HTTPTransaction*, kSize> slots_{};
+  };
+
+  // Allocated lazily for codecs that multiplex; HTTP/1.x sessions are
+  // served by the lastTxn_ fast path and never pay for the ring.
+  std::unique_ptr<TransactionRing> txnRing_;
+
   /**
    * Track all current known control streams we have within this session. A
    *stream is considered as a control stream, after some ExStream is associated
@@ -764,6 +1074,27 @@ class HTTPSession
 
   ControlMessageRateLimitFilter* controlMessageRateLimitFilter_{nullptr};
 
+  IngressRateLimitFilter* ingressRateLimitFilter_{nullptr};
+
+  /**
+   * Tenant isolation group this session was tagged with at accept, see
+   * setIsolationGroup().  The blocked flags remember that the session
+   * is parked on the group's wait list so it neither re-registers nor
+   * busy-spins its loop callback while the deficit is dry.
+   */
+  IsolationGroup* isolationGroup_{nullptr};
+  bool ingressBlockedOnGroup_{false};
+  bool egressBlockedOnGroup_{false};
+
+  /**
+   * Worker-level two-tier read scheduler this session was registered
+   * with as bulk; nullptr (the default) means latency-critical, parsed
+   * inline.  See setBulkIngressScheduler().  The scheduler drives
+   * processReadData() and charges parsed bytes via chargeBulk().
+   */
+  friend class IngressPriorityScheduler;
+  IngressPriorityScheduler* ingressScheduler_{nullptr};
+
   /**
    * Number of writes submitted to the transport for which we haven't yet
    * received completion or failure callbacks.
@@ -830,6 +1161,8 @@ class HTTPSession
   // ByteEventTracker::Callback functions
   void onPingReplyLatency(int64_t latency) noexcept override;
   void onTxnByteEventWrittenToBuf(const ByteEvent& event) noexcept override;
+  void onTxnByteEventsWrittenToBuf(
+      folly::Range<ByteEvent* const*> events) noexcept override;
   void onDeleteTxnByteEvent() noexcept override;
 
   /**
@@ -898,6 +1231,38 @@ class HTTPSession
   bool maybeResumePausedPipelinedTransaction(size_t oldStreamCount,
                                              uint32_t txnSeqn);
 
+  /**
+   * Serialized egress from a pipelined transaction that completed out of
+   * order, waiting for its predecessors' responses to be generated.  See
+   * setEgressReorderLimit().  Entries can outlive their transaction --
+   * a fully buffered response detaches before it is replayed.
+   */
+  struct ParkedEgress {
+    // Usually one message; 1xx responses park ahead of the final one
+    std::vector<std::unique_ptr<HTTPMessage>> messages;
+    folly::IOBufQueue body{folly::IOBufQueue::cacheChainLength()};
+    std::unique_ptr<HTTPHeaders> trailers;
+    bool eom{false};
+    bool egressPaused{false};
+    TimePoint parkedSince;
+  };
+
+  // True if egress from this transaction must be parked because an
+  // earlier pipelined response hasn't finished yet
+  bool shouldParkEgress(const HTTPTransaction* txn) const {
+    return egressReorderLimit_ > 0 && isDownstream() &&
+           !codec_->supportsParallelRequests() &&
+           txn->getID() != egressFrontier_;
+  }
+
+  ParkedEgress& getParkedEgress(HTTPTransaction* txn);
+
+  // Replays parked egress through the codec, in stream ID order, for as
+  // long as the stream at the egress frontier has a parked entry
+  void flushParkedEgress();
+
+  void dropParkedEgress(HTTPCodec::StreamID streamID);
+
   void incrementOutgoingStreams(HTTPTransaction* txn);
   void incrementIncomingStreams(HTTPTransaction* txn);
 
@@ -913,6 +1278,10 @@ class HTTPSession
 
   size_t sendPing(uint64_t data);
 
+  // RTT sampling, see enableRTTSampling()
+  void addRTTSample(std::chrono::microseconds sample);
+  void maybeSendRTTProbe();
+
   // private members
 
   std::list<ReplaySafetyCallback*> waitingForReplaySafety_;
@@ -980,6 +1349,69 @@ class HTTPSession
    */
   uint64_t egressBytesLimit_{0};
 
+  /**
+   * Egress pacing token bucket, see setEgressPacingRate().  A rate of
+   * zero disables pacing.  The token balance never exceeds the burst
+   * size, and the refill timestamp advances in whole milliseconds so
+   * sub-ms remainders are carried rather than dropped.
+   */
+  uint64_t egressPacingBytesPerSec_{0};
+  uint64_t egressPacingBurstBytes_{0};
+  uint64_t egressPacingTokens_{0};
+  TimePoint egressPacingLastRefill_;
+
+  /**
+   * Pipelined egress reordering state, see setEgressReorderLimit().
+   * egressFrontier_ is the stream currently allowed to egress through
+   * the codec; for HTTP/1.1 it starts at the first ingress stream ID
+   * and advances by one each time a response EOM is generated.
+   */
+  uint64_t egressReorderLimit_{0};
+  uint64_t parkedEgressBytes_{0};
+  HTTPCodec::StreamID egressFrontier_{1};
+  std::map<HTTPCodec::StreamID, ParkedEgress> parkedEgress_;
+
+  /**
+   * Window release policy applied to new transactions; see
+   * setWindowUpdateStrategyFactory().
+   */
+  std::function<std::unique_ptr<WindowUpdateStrategy>()>
+      windowUpdateStrategyFactory_;
+
+  /**
+   * Transactions with queued deferred work, drained when the loop
+   * callback completes; see HTTPTransaction::deferWork().
+   */
+  folly::IntrusiveList<HTTPTransaction, &HTTPTransaction::deferredWorkHook_>
+      deferredWorkTransactions_;
+
+  // Pre-write defrag knobs, see setEgressIovecBudget()
+  size_t egressIovecBudget_{kDefaultEgressIovecBudget};
+  size_t egressSmallBufferThreshold_{kDefaultSmallBufferThreshold};
+
+  /**
+   * Write buffer auto-tuning state; see enableWriteBufferAutoTuning().
+   * writeDrainBytesPerSec_ is a smoothed estimate of how fast the socket
+   * drains our writes, sampled between writeChain and writeSuccess.
+   */
+  bool writeBufAutoTune_{false};
+  uint32_t writeBufAutoTuneMin_{0};
+  uint32_t writeBufAutoTuneMax_{0};
+  uint64_t writeDrainBytesPerSec_{0};
+  TimePoint pendingWriteStart_;
+
+  /**
+   * Adaptive TLS record sizing, see setTLSRecordSizePolicy().  A current
+   * size of zero means adaptation is disabled.
+   */
+  uint32_t tlsRecordSize_{0};
+  uint32_t tlsRecordInitialSize_{0};
+  uint32_t tlsRecordMaxSize_{0};
+  uint64_t tlsRecordBulkThreshold_{0};
+  uint64_t tlsRecordBytesSinceReset_{0};
+  std::chrono::milliseconds tlsRecordIdleReset_{0};
+  TimePoint tlsRecordLastWrite_;
+
   // Flow control settings
   size_t initialReceiveWindow_{0};
   size_t receiveStreamWindowSize_{0};
@@ -1009,6 +1441,21 @@ class HTTPSession
   };
   std::unique_ptr<ShutdownTransportCallback> shutdownTransportCb_;
 
+  class IngressBatchCallback : public folly::EventBase::LoopCallback {
+   public:
+    explicit IngressBatchCallback(HTTPSession* session) : session_(session) {
+    }
+
+    void runLoopCallback() noexcept override {
+      DestructorGuard dg(session_);
+      session_->processReadData();
+    }
+
+   private:
+    HTTPSession* session_;
+  };
+  IngressBatchCallback ingressBatchCb_{this};
+
   class FlowControlTimeout : public folly::HHWheelTimer::Callback {
    public:
     explicit FlowControlTimeout(HTTPSession* session) : session_(session) {
@@ -1034,6 +1481,22 @@ class HTTPSession
   };
   FlowControlTimeout flowControlTimeout_;
 
+  class PacingTimeout : public folly::HHWheelTimer::Callback {
+   public:
+    explicit PacingTimeout(HTTPSession* session) : session_(session) {
+    }
+    ~PacingTimeout() override {
+    }
+
+    void timeoutExpired() noexcept override {
+      session_->pacingTimeoutExpired();
+    }
+
+   private:
+    HTTPSession* session_;
+  };
+  PacingTimeout pacingTimeout_{this};
+
   class DrainTimeout : public folly::HHWheelTimer::Callback {
    public:
     explicit DrainTimeout(HTTPSession* session) : session_(session) {
@@ -1058,10 +1521,20 @@ class HTTPSession
                bool extendIntervalOnIngress,
                bool immediate);
 
+    // Idle-liveness mode, see enableIdleLivenessProbes()
+    PingProber(HTTPSession& session,
+               std::chrono::seconds initialInterval,
+               std::chrono::seconds maxInterval,
+               std::chrono::seconds timeout);
+
     void startProbes();
 
     void cancelProbes();
 
+    // The session flipped between having streams and being idle; which
+    // of the two states gets probed depends on the mode
+    void onStreamsActive(bool active);
+
     void refreshTimeout(bool onIngress);
 
     void timeoutExpired() noexcept override;
@@ -1075,11 +1548,26 @@ class HTTPSession
     HTTPSession& session_;
     std::chrono::seconds interval_;
     std::chrono::seconds timeout_;
+    // Idle-liveness mode only: the current backed-off interval and its cap
+    std::chrono::seconds maxInterval_{0};
+    std::chrono::seconds currentInterval_{0};
     folly::Optional<uint64_t> pingVal_;
     bool extendIntervalOnIngress_{true};
+    bool idleMode_{false};
   };
   std::unique_ptr<PingProber> pingProber_;
 
+  /**
+   * RTT sampling state, see enableRTTSampling().  timedPing_ holds the
+   * payload and send time of the in-flight PING being clocked; only one
+   * is timed at once.  srtt_ == 0 means no sample yet.
+   */
+  std::chrono::microseconds srtt_{0};
+  std::chrono::steady_clock::time_point lastRTTSample_;
+  std::chrono::milliseconds rttProbeInterval_{0};
+  folly::Optional<std::pair<uint64_t, std::chrono::steady_clock::time_point>>
+      timedPing_;
+
   // secondary authentication manager
   std::unique_ptr<SecondaryAuthManagerBase> secondAuthManager_;
 
@@ -1102,8 +1590,13 @@ class HTTPSession
   bool inResume_ : 1;
   bool pendingPause_ : 1;
   bool writeBufSplit_ : 1;
+  bool ingressBatchingEnabled_ : 1;
+  bool decryptInPlace_ : 1;
 
   bool abortPushesOnRST_{false};
+
+  // Fires the session_first_byte tracepoint exactly once
+  bool receivedFirstByte_{false};
 };
 
 } // namespace proxygen
@@ -8,10 +8,14 @@
 
 #include <proxygen/lib/http/session/HTTPSessionAcceptor.h>
 
+#include <algorithm>
+#include <folly/Conv.h>
 #include <proxygen/lib/http/codec/HTTP1xCodec.h>
 #include <proxygen/lib/http/codec/HTTP2Codec.h>
 #include <proxygen/lib/http/session/HTTPDefaultSessionCodecFactory.h>
 #include <proxygen/lib/http/session/HTTPDirectResponseHandler.h>
+#include <proxygen/lib/services/RequestWorkerThread.h>
+#include <proxygen/lib/utils/Tracepoints.h>
 
 using folly::SocketAddress;
 using std::string;
@@ -35,6 +39,7 @@ HTTPSessionAcceptor::HTTPSessionAcceptor(
     codecFactory_ =
         std::make_shared<HTTPDefaultSessionCodecFactory>(accConfig_);
   }
+  h2SettingsBufferCache_ = std::make_shared<HTTP2SettingsBufferCache>();
 }
 
 HTTPSessionAcceptor::~HTTPSessionAcceptor() {
@@ -49,17 +54,38 @@ const HTTPErrorPage* HTTPSessionAcceptor::getErrorPage(
   return errorPage;
 }
 
+bool HTTPSessionAcceptor::shouldShedRequest() const {
+  if (!loopLatencyShedEnabled_) {
+    return false;
+  }
+  // Acceptors run on their worker's event base, but not every acceptor
+  // runs under a RequestWorkerThread (e.g. tests); those never shed
+  auto* worker = dynamic_cast<RequestWorkerThread*>(
+      WorkerThread::getCurrentWorkerThread());
+  return worker != nullptr && worker->isOverloaded();
+}
+
 void HTTPSessionAcceptor::onNewConnection(folly::AsyncTransport::UniquePtr sock,
                                           const SocketAddress* peerAddress,
                                           const string& nextProtocol,
                                           wangle::SecureTransportType,
                                           const wangle::TransportInfo& tinfo) {
 
+  // Pick up any config snapshot the control plane published since the
+  // last accept; everything below reads accConfig_
+  refreshAcceptorConfig();
+
+  const bool shedding = shouldShedRequest();
+  if (shedding && idleDropsPerShedEvent_ > 0) {
+    // Longest-idle sessions are the cheapest load to return: dropping
+    // them frees memory and kernel state without failing any request
+    dropIdleConnections(idleDropsPerShedEvent_);
+  }
+
+  // we assume if security protocol isn't empty, then it's TLS
+  const bool isTLS = !sock->getSecurityProtocol().empty();
   unique_ptr<HTTPCodec> codec = codecFactory_->getCodec(
-      nextProtocol,
-      TransportDirection::DOWNSTREAM,
-      // we assume if security protocol isn't empty, then it's TLS
-      !sock->getSecurityProtocol().empty());
+      nextProtocol, TransportDirection::DOWNSTREAM, isTLS);
 
   if (!codec) {
     VLOG(2) << "codecFactory_ failed to provide codec";
@@ -70,6 +96,11 @@ void HTTPSessionAcceptor::onNewConnection(folly::AsyncTransport::UniquePtr sock,
   if (egressSettings && setEnableConnectProtocol_) {
     egressSettings->setSetting(SettingsId::ENABLE_CONNECT_PROTOCOL, 1);
   }
+  if (auto* h2Codec = dynamic_cast<HTTP2Codec*>(codec.get())) {
+    // Every connection here advertises the same settings; the first one
+    // serializes the SETTINGS frame and the rest clone its bytes
+    h2Codec->setSettingsBufferCache(h2SettingsBufferCache_);
+  }
 
   auto controller = getController();
   SocketAddress localAddress;
@@ -108,20 +139,145 @@ void HTTPSessionAcceptor::onNewConnection(folly::AsyncTransport::UniquePtr sock,
   }
   session->setEgressSettings(accConfig_.egressSettings);
 
+  auto initialReceiveWindow = accConfig_.initialReceiveWindow;
+  if (codecMemoryGovernor_) {
+    codecMemoryGovernor_->updateOccupancy(
+        downstreamConnectionManager_
+            ? downstreamConnectionManager_->getNumConnections()
+            : 0);
+    // Admit the session with budgets matching current occupancy rather
+    // than the static worst-case configuration
+    session->setEgressSettings({{SettingsId::HEADER_TABLE_SIZE,
+                                 codecMemoryGovernor_->getHeaderTableSize()}});
+    initialReceiveWindow = std::min(
+        initialReceiveWindow, codecMemoryGovernor_->getInitialReceiveWindow());
+    if (codecMemoryGovernor_->shouldShrinkExistingSessions()) {
+      shrinkExistingSessionTables(codecMemoryGovernor_->getHeaderTableSize());
+    }
+  }
+
+  if (clientCapabilityCache_) {
+    auto clientClassKey = getClientClassKey(nextProtocol, tinfo);
+    if (auto profile = clientCapabilityCache_->getProfile(clientClassKey)) {
+      // Learned per-class settings; the governor's memory budget, when
+      // one is installed, still caps both
+      auto headerTableSize = profile->headerTableSize;
+      if (codecMemoryGovernor_) {
+        headerTableSize = std::min(headerTableSize,
+                                   codecMemoryGovernor_->getHeaderTableSize());
+      }
+      session->setEgressSettings(
+          {{SettingsId::HEADER_TABLE_SIZE, headerTableSize}});
+      initialReceiveWindow = profile->initialReceiveWindow;
+      if (codecMemoryGovernor_) {
+        initialReceiveWindow =
+            std::min(initialReceiveWindow,
+                     codecMemoryGovernor_->getInitialReceiveWindow());
+      }
+    }
+    if (sessionInfoCb == this) {
+      // Learning rides the acceptor's own InfoCallback; with a custom
+      // callback installed the session just consumes cached profiles
+      observedSessions_[session] = ClientObservation{
+          std::move(clientClassKey), 0, std::chrono::steady_clock::now()};
+    }
+  }
+
   // set HTTP2 priorities flag on session object
   auto HTTP2PrioritiesEnabled = getHttp2PrioritiesEnabled();
   session->setHTTP2PrioritiesEnabled(HTTP2PrioritiesEnabled);
 
   // set flow control parameters
-  session->setFlowControl(accConfig_.initialReceiveWindow,
+  session->setFlowControl(initialReceiveWindow,
                           accConfig_.receiveStreamWindowSize,
                           accConfig_.receiveSessionWindowSize);
   if (accConfig_.writeBufferLimit > 0) {
     session->setWriteBufferLimit(accConfig_.writeBufferLimit);
   }
+  if (isTLS && accConfig_.tlsRecordInitialSize > 0) {
+    session->setTLSRecordSizePolicy(accConfig_.tlsRecordInitialSize,
+                                    accConfig_.tlsRecordMaxSize,
+                                    accConfig_.tlsRecordBulkThreshold,
+                                    accConfig_.tlsRecordIdleReset);
+  }
   session->setSessionStats(downstreamSessionStats_);
+  if (auto* isolationGroup = getIsolationGroup(*peerAddress, tinfo)) {
+    session->setIsolationGroup(isolationGroup);
+  }
+  if (ingressPriorityScheduler_ && isBulkIngress(nextProtocol, tinfo)) {
+    session->setBulkIngressScheduler(ingressPriorityScheduler_);
+  }
   Acceptor::addConnection(session);
+  PROXYGEN_SDT(session_accept, session);
   session->startNow();
+  if (shedding) {
+    // The session still speaks the protocol -- its requests get direct
+    // 503s from the controller -- but it closes once those are flushed
+    // rather than parking more load on an already hot worker
+    session->drain();
+  }
+}
+
+std::string HTTPSessionAcceptor::getClientClassKey(
+    const std::string& nextProtocol, const wangle::TransportInfo& tinfo) {
+  return folly::to<std::string>(
+      tinfo.sslVersion,
+      '/',
+      tinfo.sslCipher ? *tinfo.sslCipher : std::string(),
+      '/',
+      tinfo.sslServerName ? *tinfo.sslServerName : std::string(),
+      '/',
+      nextProtocol);
+}
+
+void HTTPSessionAcceptor::onWrite(const HTTPSessionBase& sess,
+                                  size_t bytesWritten) {
+  if (!observedSessions_.empty()) {
+    auto it = observedSessions_.find(&sess);
+    if (it != observedSessions_.end()) {
+      it->second.bytesWritten += bytesWritten;
+    }
+  }
+}
+
+void HTTPSessionAcceptor::onDestroy(const HTTPSessionBase& sess) {
+  auto it = observedSessions_.find(&sess);
+  if (it == observedSessions_.end()) {
+    return;
+  }
+  if (clientCapabilityCache_) {
+    const auto lifetime = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - it->second.acceptTime);
+    if (lifetime.count() > 0 && it->second.bytesWritten > 0) {
+      const double rate =
+          it->second.bytesWritten * 1000.0 / double(lifetime.count());
+      clientCapabilityCache_->recordSession(
+          it->second.classKey, rate, sess.getCodecCompressionInfo());
+    }
+  }
+  observedSessions_.erase(it);
+}
+
+void HTTPSessionAcceptor::shrinkExistingSessionTables(
+    uint32_t headerTableSize) {
+  auto* cm = downstreamConnectionManager_.get();
+  if (!cm) {
+    return;
+  }
+  VLOG(3) << "shrinking header tables on existing sessions to "
+          << headerTableSize << " bytes under codec memory pressure";
+  cm->iterateConns([&](wangle::ManagedConnection* conn) {
+    auto* session = dynamic_cast<HTTPSessionBase*>(conn);
+    if (!session) {
+      return;
+    }
+    // Re-advertise the smaller table; the peer must shrink its encoder
+    // table toward us, bounding this worker's decoder memory.  Sessions
+    // whose protocol has no SETTINGS ignore this.
+    session->setEgressSettings(
+        {{SettingsId::HEADER_TABLE_SIZE, headerTableSize}});
+    session->sendSettings();
+  });
 }
 
 size_t HTTPSessionAcceptor::dropIdleConnections(size_t num) {
@@ -130,4 +286,94 @@ size_t HTTPSessionAcceptor::dropIdleConnections(size_t num) {
   return downstreamConnectionManager_->dropIdleConnections(num);
 }
 
+void HTTPSessionAcceptor::startGradualDrain(
+    std::chrono::milliseconds window,
+    size_t maxConcurrent,
+    folly::Function<void(size_t)> progressCb) {
+  // spreading the window over a fixed number of ticks keeps the timer
+  // traffic independent of connection count
+  constexpr size_t kDrainTicks = 10;
+  gradualDrainProgressCb_ = std::move(progressCb);
+  gradualDrainMaxConcurrent_ = maxConcurrent;
+  const size_t total = downstreamConnectionManager_
+                           ? downstreamConnectionManager_->getNumConnections()
+                           : 0;
+  if (total == 0) {
+    if (gradualDrainProgressCb_) {
+      gradualDrainProgressCb_(0);
+    }
+    return;
+  }
+  if (window.count() <= 0) {
+    // degenerate window: behave like a plain full drain, but still
+    // report progress until the last session closes
+    gradualDrainPerTick_ = total;
+    gradualDrainTickInterval_ = std::chrono::milliseconds(100);
+  } else {
+    gradualDrainPerTick_ = (total + kDrainTicks - 1) / kDrainTicks;
+    gradualDrainTickInterval_ =
+        std::max(window / kDrainTicks, std::chrono::milliseconds(1));
+  }
+  if (!gradualDrainTimeout_) {
+    gradualDrainTimeout_ = folly::AsyncTimeout::make(
+        *getEventBase(), [this]() noexcept { gradualDrainTick(); });
+  }
+  gradualDrainTick();
+}
+
+void HTTPSessionAcceptor::gradualDrainTick() {
+  auto* cm = downstreamConnectionManager_.get();
+  if (!cm) {
+    if (gradualDrainProgressCb_) {
+      gradualDrainProgressCb_(0);
+    }
+    return;
+  }
+  // No session pointers are held across ticks; each tick re-surveys the
+  // manager so sessions closing in between cannot dangle.
+  size_t draining = 0;
+  std::vector<std::pair<std::chrono::milliseconds, HTTPSessionBase*>>
+      candidates;
+  cm->iterateConns([&](wangle::ManagedConnection* conn) {
+    auto* session = dynamic_cast<HTTPSessionBase*>(conn);
+    if (!session) {
+      // non-HTTP connection: left to the regular shutdown path
+      return;
+    }
+    if (session->isDraining()) {
+      draining++;
+    } else {
+      candidates.emplace_back(session->getIdleTime(), session);
+    }
+  });
+  size_t toDrain = std::min(gradualDrainPerTick_, candidates.size());
+  if (gradualDrainMaxConcurrent_ > 0) {
+    toDrain = std::min(toDrain,
+                       gradualDrainMaxConcurrent_ -
+                           std::min(draining, gradualDrainMaxConcurrent_));
+  }
+  if (toDrain > 0) {
+    if (toDrain < candidates.size()) {
+      // longest idle first: those close immediately and free memory now
+      std::partial_sort(candidates.begin(),
+                        candidates.begin() + toDrain,
+                        candidates.end(),
+                        [](const auto& a, const auto& b) {
+                          return a.first > b.first;
+                        });
+    }
+    for (size_t i = 0; i < toDrain; i++) {
+      // sends GOAWAY and closes outright if the session is already idle
+      candidates[i].second->closeWhenIdle();
+    }
+  }
+  const size_t remaining = cm->getNumConnections();
+  if (gradualDrainProgressCb_) {
+    gradualDrainProgressCb_(remaining);
+  }
+  if (remaining > 0) {
+    gradualDrainTimeout_->scheduleTimeout(gradualDrainTickInterval_);
+  }
+}
+
 } // namespace proxygen
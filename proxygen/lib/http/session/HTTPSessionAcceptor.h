@@ -8,9 +8,14 @@
 
 #pragma once
 
+#include <unordered_map>
+
 #include <folly/io/async/AsyncSSLSocket.h>
+#include <folly/io/async/AsyncTimeout.h>
 #include <proxygen/lib/http/codec/HTTPCodecFactory.h>
 #include <proxygen/lib/http/codec/SPDYCodec.h>
+#include <proxygen/lib/http/session/ClientCapabilityCache.h>
+#include <proxygen/lib/http/session/CodecMemoryGovernor.h>
 #include <proxygen/lib/http/session/HTTPDownstreamSession.h>
 #include <proxygen/lib/http/session/HTTPErrorPage.h>
 #include <proxygen/lib/http/session/SimpleController.h>
@@ -19,6 +24,7 @@
 namespace proxygen {
 
 class HTTPSessionStats;
+struct HTTP2SettingsBufferCache;
 
 /**
  * Specialization of Acceptor that serves as an abstract base for
@@ -90,6 +96,85 @@ class HTTPSessionAcceptor
     sessionInfoCb_ = cb;
   }
 
+  /**
+   * Configure loop-latency load shedding.  When the RequestWorkerThread
+   * this acceptor runs on reports itself overloaded (see
+   * RequestWorkerThread::setLoopLatencyShedThreshold()), each new
+   * connection first drops up to idleDropsPerShedEvent of the
+   * longest-idle sessions -- they hold memory and kernel state but serve
+   * nobody -- and both the new session's requests and new requests on
+   * existing sessions are answered with a direct 503 by the controller
+   * instead of being handed to the application.  Disabled by default.
+   */
+  void setLoopLatencyShedding(bool enabled, size_t idleDropsPerShedEvent = 1) {
+    loopLatencyShedEnabled_ = enabled;
+    idleDropsPerShedEvent_ = idleDropsPerShedEvent;
+  }
+
+  /**
+   * True when shedding is enabled and this acceptor's worker is past its
+   * loop-latency shed threshold.  Controllers consult this per request
+   * to short-circuit handler creation with a 503.
+   */
+  bool shouldShedRequest() const;
+
+  /**
+   * Install the worker's two-tier ingress read scheduler.  Sessions this
+   * acceptor classifies as bulk (the accConfig bulkIngress flag, or an
+   * isBulkIngress() override) get their reads parsed in the scheduler's
+   * end-of-iteration pass behind the worker's latency-critical sessions,
+   * capped by the scheduler's per-tick byte budget.  The scheduler is
+   * per worker and may be shared by every acceptor on the same event
+   * base; it must outlive the sessions accepted here.
+   */
+  void setIngressPriorityScheduler(IngressPriorityScheduler* scheduler) {
+    ingressPriorityScheduler_ = scheduler;
+  }
+
+  /**
+   * Install a per-worker codec memory governor.  New sessions are
+   * admitted with the governor's current header table size and initial
+   * receive window instead of the static accConfig values, and crossing
+   * the governor's pressure watermark shrinks existing sessions' tables
+   * via a SETTINGS update.  The governor may be shared by every acceptor
+   * on the same event base; it must outlive them.
+   */
+  void setCodecMemoryGovernor(CodecMemoryGovernor* governor) {
+    codecMemoryGovernor_ = governor;
+  }
+
+  /**
+   * Install a per-worker client capability cache.  New sessions whose
+   * class (see getClientClassKey()) has a learned profile are admitted
+   * with that profile's header table size and initial receive window
+   * instead of the static accConfig values; when a codec memory
+   * governor is also installed its budget still caps both.  Sessions
+   * report back into the cache at teardown, but only while this
+   * acceptor is the session InfoCallback -- installing a callback via
+   * setSessionInfoCallback() disables learning.  The cache may be
+   * shared by every acceptor on the same event base; it must outlive
+   * them.
+   */
+  void setClientCapabilityCache(ClientCapabilityCache* cache) {
+    clientCapabilityCache_ = cache;
+  }
+
+  /**
+   * Drain this acceptor's sessions gradually instead of all at once.
+   * Sessions are drained in order of idleness (longest idle first, since
+   * they close quickest and free memory immediately), spread over the
+   * given window, with at most maxConcurrent sessions actively draining
+   * at any time (0 = no cap).  progressCb, if set, is invoked after each
+   * scheduling tick with the number of sessions still connected; the
+   * final invocation is with 0, so orchestration can track completion
+   * instead of sleeping a fixed timeout.  Must be called on this
+   * acceptor's EventBase thread.  New connections should be stopped
+   * first or they will be swept into later ticks.
+   */
+  void startGradualDrain(std::chrono::milliseconds window,
+                         size_t maxConcurrent = 0,
+                         folly::Function<void(size_t)> progressCb = nullptr);
+
   virtual bool getHttp2PrioritiesEnabled() {
     return accConfig_.HTTP2PrioritiesEnabled;
   }
@@ -109,6 +194,42 @@ class HTTPSessionAcceptor
     return &simpleController_;
   }
 
+  /**
+   * Invoked at accept to tag the new session with a tenant isolation
+   * group (see IsolationGroupSet).  Child classes map the connection to
+   * a tenant however they key tenancy -- SNI via tinfo.sslServerName,
+   * the listener's local address, etc.  Return nullptr (the default)
+   * to leave the session ungrouped.
+   */
+  virtual IsolationGroup* getIsolationGroup(
+      const folly::SocketAddress& /*peerAddress*/,
+      const wangle::TransportInfo& /*tinfo*/) {
+    return nullptr;
+  }
+
+  /**
+   * Invoked at accept to classify the new session for the worker's
+   * ingress scheduler.  The default classifies per listener via the
+   * accConfig bulkIngress flag; child classes can refine it per
+   * connection from the negotiated protocol or SNI (tinfo.sslServerName).
+   * Only consulted when an IngressPriorityScheduler is installed.
+   */
+  virtual bool isBulkIngress(const std::string& /*nextProtocol*/,
+                             const wangle::TransportInfo& /*tinfo*/) {
+    return accConfig_.bulkIngress;
+  }
+
+  /**
+   * Invoked at accept to classify the new connection for the client
+   * capability cache.  The default composes the TLS fingerprint
+   * material available in tinfo (version and cipher) with the SNI and
+   * the negotiated protocol; child classes with richer fingerprinting
+   * (e.g. a JA3 hash computed at the TLS layer) should override it.
+   * Only consulted when a ClientCapabilityCache is installed.
+   */
+  virtual std::string getClientClassKey(const std::string& nextProtocol,
+                                        const wangle::TransportInfo& tinfo);
+
   HTTPSessionStats* downstreamSessionStats_{nullptr};
 
   bool setEnableConnectProtocol_{false};
@@ -138,10 +259,47 @@ class HTTPSessionAcceptor
 
   std::shared_ptr<HTTPCodecFactory> codecFactory_{};
 
+  // One serialized SETTINGS frame shared by every HTTP/2 connection this
+  // acceptor accepts; see HTTP2SettingsBufferCache
+  std::shared_ptr<HTTP2SettingsBufferCache> h2SettingsBufferCache_;
+
   SimpleController simpleController_;
 
   HTTPSession::InfoCallback* sessionInfoCb_{nullptr};
 
+  // Worker-level two-tier read scheduler, see setIngressPriorityScheduler()
+  IngressPriorityScheduler* ingressPriorityScheduler_{nullptr};
+
+  // Elastic codec memory budgets, see setCodecMemoryGovernor()
+  void shrinkExistingSessionTables(uint32_t headerTableSize);
+  CodecMemoryGovernor* codecMemoryGovernor_{nullptr};
+
+  // Learned per-client-class settings, see setClientCapabilityCache().
+  // Sessions under observation accumulate egress bytes via onWrite()
+  // and report into the cache at onDestroy().
+  struct ClientObservation {
+    std::string classKey;
+    uint64_t bytesWritten{0};
+    std::chrono::steady_clock::time_point acceptTime;
+  };
+  void onWrite(const HTTPSessionBase& sess, size_t bytesWritten) override;
+  void onDestroy(const HTTPSessionBase& sess) override;
+  ClientCapabilityCache* clientCapabilityCache_{nullptr};
+  std::unordered_map<const HTTPSessionBase*, ClientObservation>
+      observedSessions_;
+
+  // Loop-latency load shedding, see setLoopLatencyShedding()
+  bool loopLatencyShedEnabled_{false};
+  size_t idleDropsPerShedEvent_{1};
+
+  // Gradual drain state, see startGradualDrain()
+  void gradualDrainTick();
+  std::unique_ptr<folly::AsyncTimeout> gradualDrainTimeout_;
+  folly::Function<void(size_t)> gradualDrainProgressCb_;
+  std::chrono::milliseconds gradualDrainTickInterval_{0};
+  size_t gradualDrainPerTick_{0};
+  size_t gradualDrainMaxConcurrent_{0};
+
   /**
    * 0.0.0.0:0, a valid address to use if getsockname() or getpeername() fails
    */
@@ -12,6 +12,9 @@
 #include <proxygen/lib/http/session/ByteEventTracker.h>
 #include <proxygen/lib/http/session/HTTPSessionController.h>
 #include <proxygen/lib/http/session/HTTPSessionStats.h>
+#include <proxygen/lib/utils/BinaryAccessLog.h>
+
+#include <cstring>
 
 using folly::SocketAddress;
 using wangle::TransportInfo;
@@ -50,6 +53,13 @@ HTTPSessionBase::HTTPSessionBase(const SocketAddress& localAddr,
   setController(controller);
 }
 
+uint64_t HTTPSessionBase::getMemoryFootprint() const {
+  const auto compression = codec_->getCompressionInfo();
+  return sizeof(*this) + pendingWriteSize_ + pendingReadSize_ +
+         compression.egress.bytesStored_ + compression.ingress.bytesStored_ +
+         uint64_t(getNumStreams()) * sizeof(HTTPTransaction);
+}
+
 void HTTPSessionBase::runDestroyCallbacks() {
   if (infoCallback_) {
     infoCallback_->onDestroy(*this);
@@ -194,6 +204,42 @@ void HTTPSessionBase::informSessionControllerTransportReady() {
   }
 }
 
+void HTTPSessionBase::logTransactionToAccessLog(
+    const HTTPTransaction& txn) noexcept {
+  if (!accessLog_) {
+    return;
+  }
+  auto toNs = [](TimePoint tp) -> uint64_t {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               tp.time_since_epoch())
+        .count();
+  };
+  const auto& timings = txn.getTimings();
+  AccessLogRecord record;
+  record.startNs = toNs(timings.get(HTTPTransaction::Timings::Created));
+  if (timings.reached(
+          HTTPTransaction::Timings::EgressHeadersFirstByteFlushed)) {
+    record.firstByteNs = toNs(
+        timings.get(HTTPTransaction::Timings::EgressHeadersFirstByteFlushed));
+  }
+  if (timings.reached(HTTPTransaction::Timings::EgressLastByteFlushed)) {
+    record.lastByteNs =
+        toNs(timings.get(HTTPTransaction::Timings::EgressLastByteFlushed));
+  }
+  record.streamId = txn.getID();
+  record.egressBodyBytes = txn.getEgressBodyBytesSent();
+  record.ingressBodyBytes = txn.getIngressBodyBytesReceived();
+  record.status = txn.getLastResponseStatus();
+  record.aborted = txn.isAborted() ? 1 : 0;
+  if (transportInfo_.sslServerName) {
+    const auto& sni = *transportInfo_.sslServerName;
+    record.sniLength =
+        uint8_t(std::min(sni.size(), AccessLogRecord::kSniLength));
+    memcpy(record.sni, sni.data(), record.sniLength);
+  }
+  accessLog_->log(record);
+}
+
 void HTTPSessionBase::handleLastByteEvents(ByteEventTracker* byteEventTracker,
                                            HTTPTransaction* txn,
                                            size_t encodedSize,
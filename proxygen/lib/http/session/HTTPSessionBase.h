@@ -19,6 +19,7 @@
 #include <wangle/acceptor/TransportInfo.h>
 
 namespace proxygen {
+class BinaryAccessLog;
 class HTTPSessionController;
 class HTTPSessionStats;
 class HTTPTransaction;
@@ -112,6 +113,16 @@ class HTTPSessionBase : public wangle::ManagedConnection {
     }
     virtual void onSettingsAck(const HTTPSessionBase&) {
     }
+    /**
+     * The peer sent GOAWAY: the session is draining and will accept no
+     * new transactions.  Fired before the affected transactions are
+     * errored out, so a pool holding this session can retire it and
+     * start a replacement immediately instead of discovering the drain
+     * on the next checkout.  May fire more than once per session
+     * (HTTP/3 peers send a second GOAWAY while draining).
+     */
+    virtual void onGoawayReceived(const HTTPSessionBase&) {
+    }
   };
 
   HTTPSessionBase(const folly::SocketAddress& localAddr,
@@ -124,6 +135,9 @@ class HTTPSessionBase : public wangle::ManagedConnection {
                   HTTPCodec::StreamID rootNodeId);
 
   virtual ~HTTPSessionBase() {
+    // Derived class members (including the transactions) are gone by the
+    // time this runs, so any counters they bumped get their final flush.
+    flushPendingSessionStats();
   }
 
   /**
@@ -166,6 +180,36 @@ class HTTPSessionBase : public wangle::ManagedConnection {
     sessionStats_ = stats;
   }
 
+  /**
+   * Route the per-transaction hot-path records (transaction
+   * opened/closed/stalled, session reused/stalled) through a flat
+   * counter block bumped with plain increments and flushed to the
+   * HTTPSessionStats sink once per event loop tick and at session
+   * teardown, instead of a virtual call plus time-series update per
+   * event.  Call before the session serves its first transaction.
+   */
+  void enableBatchedSessionStats() {
+    batchedSessionStats_ = true;
+  }
+
+  /**
+   * The session's pending counter block, or nullptr when batching is
+   * disabled.
+   */
+  HTTPSessionStatCounters* getBatchedStatCounters() {
+    return batchedSessionStats_ ? &pendingStatCounters_ : nullptr;
+  }
+
+  /**
+   * Attach a binary access log.  Does not take ownership; the log must
+   * outlive the session.  A record is written for every transaction as
+   * it detaches, including transactions that failed at the codec level
+   * and never reached a handler.
+   */
+  void setBinaryAccessLog(BinaryAccessLog* accessLog) {
+    accessLog_ = accessLog;
+  }
+
   virtual HTTPTransaction::Transport::Type getType() const noexcept = 0;
 
   virtual folly::AsyncTransport* getTransport() = 0;
@@ -232,6 +276,20 @@ class HTTPSessionBase : public wangle::ManagedConnection {
     return codec_->getProtocol();
   }
 
+  CompressionInfo getCodecCompressionInfo() const {
+    return codec_->getCompressionInfo();
+  }
+
+  /**
+   * Smoothed estimate of the round-trip time to the peer, if the session
+   * has one.  QUIC sessions report the transport's srtt; TCP sessions
+   * return an estimate once enableRTTSampling() has produced a sample
+   * (PING-clocked or from TCP_INFO).
+   */
+  virtual folly::Optional<std::chrono::microseconds> getSessionRTT() const {
+    return folly::none;
+  }
+
   /**
    * Set flow control properties on the session.
    *
@@ -515,6 +573,26 @@ class HTTPSessionBase : public wangle::ManagedConnection {
     setIngressTimeoutAfterEom_ = setIngressTimeoutAfterEom;
   }
 
+  /**
+   * Estimated bytes of memory attributable to this session: the session
+   * object itself, buffered ingress and egress, compression table state,
+   * and per-transaction overhead.  An estimate for accounting and
+   * enforcement (see HTTPSessionMemoryLedger), not an exact malloc count.
+   */
+  virtual uint64_t getMemoryFootprint() const;
+
+  /**
+   * Stop/restart reading from the transport for the whole session.  The
+   * default implementations are no-ops; sessions that buffer ingress
+   * override them.  Used by worker-level memory enforcement to stop
+   * slow-read peers from growing buffers.
+   */
+  virtual void pauseReads() {
+  }
+
+  virtual void resumeReads() {
+  }
+
  protected:
   bool notifyEgressBodyBuffered(int64_t bytes, bool update);
 
@@ -601,8 +679,35 @@ class HTTPSessionBase : public wangle::ManagedConnection {
    */
   void informSessionControllerTransportReady();
 
+  /**
+   * Writes an AccessLogRecord for the given transaction to accessLog_,
+   * if one is attached.  Called with the transaction still alive, just
+   * before it is destroyed.
+   */
+  void logTransactionToAccessLog(const HTTPTransaction& txn) noexcept;
+
+  /**
+   * Delivers any pending batched counters to sessionStats_ and clears
+   * them.  Called once per event loop tick by the session's write loop
+   * callback and from the destructor; a no-op when nothing accumulated.
+   */
+  void flushPendingSessionStats() {
+    if (pendingStatCounters_.any()) {
+      if (sessionStats_) {
+        sessionStats_->recordPendingStatCounters(pendingStatCounters_);
+      }
+      pendingStatCounters_.clear();
+    }
+  }
+
   HTTPSessionStats* sessionStats_{nullptr};
 
+  HTTPSessionStatCounters pendingStatCounters_;
+
+  bool batchedSessionStats_{false};
+
+  BinaryAccessLog* accessLog_{nullptr};
+
   InfoCallback* infoCallback_{nullptr}; // maybe can move to protected
 
   wangle::TransportInfo transportInfo_;
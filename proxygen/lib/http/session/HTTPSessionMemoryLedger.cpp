@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/http/session/HTTPSessionMemoryLedger.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+// HEADER_TABLE_SIZE advertised while under memory pressure.  Small enough
+// to bound decoder state per session, large enough to keep some
+// compression for well-behaved peers.
+constexpr uint32_t kShrunkHeaderTableSize = 1024;
+} // namespace
+
+namespace proxygen {
+
+void HTTPSessionMemoryLedger::addSession(HTTPSessionBase* session) {
+  sessions_.insert(session);
+  if (level_ >= Enforcement::PAUSE_READS) {
+    session->pauseReads();
+  }
+  if (level_ >= Enforcement::SHRINK_HEADER_TABLES) {
+    session->setEgressSettings(
+        {{SettingsId::HEADER_TABLE_SIZE, kShrunkHeaderTableSize}});
+    session->sendSettings();
+  }
+}
+
+void HTTPSessionMemoryLedger::removeSession(HTTPSessionBase* session) {
+  sessions_.erase(session);
+}
+
+uint64_t HTTPSessionMemoryLedger::getTotalFootprint() const {
+  uint64_t total = 0;
+  for (const auto* session : sessions_) {
+    total += session->getMemoryFootprint();
+  }
+  return total;
+}
+
+HTTPSessionMemoryLedger::Enforcement HTTPSessionMemoryLedger::enforce() {
+  uint64_t total = getTotalFootprint();
+  bool aborted = false;
+
+  if (budgets_.abortSessionsBytes > 0 && total > budgets_.abortSessionsBytes) {
+    // Rank by footprint and drop the costliest sessions first
+    std::vector<std::pair<uint64_t, HTTPSessionBase*>> ranked;
+    ranked.reserve(sessions_.size());
+    for (auto* session : sessions_) {
+      ranked.emplace_back(session->getMemoryFootprint(), session);
+    }
+    std::sort(ranked.begin(), ranked.end(), std::greater<>());
+    for (const auto& entry : ranked) {
+      if (total <= budgets_.abortSessionsBytes) {
+        break;
+      }
+      auto* session = entry.second;
+      LOG(WARNING) << "Aborting session using " << entry.first
+                   << " bytes, worker total " << total << " over budget "
+                   << budgets_.abortSessionsBytes;
+      total -= std::min(total, entry.first);
+      // Erase first; dropConnection may destroy the session inline
+      sessions_.erase(session);
+      session->dropConnection("Worker memory budget exceeded");
+      aborted = true;
+    }
+  }
+
+  publishedFootprint_.store(total, std::memory_order_relaxed);
+
+  Enforcement newLevel = Enforcement::NONE;
+  if (budgets_.shrinkHeaderTablesBytes > 0 &&
+      total > budgets_.shrinkHeaderTablesBytes) {
+    newLevel = Enforcement::SHRINK_HEADER_TABLES;
+  } else if (budgets_.pauseReadsBytes > 0 &&
+             total > budgets_.pauseReadsBytes) {
+    newLevel = Enforcement::PAUSE_READS;
+  }
+
+  if (newLevel >= Enforcement::PAUSE_READS &&
+      level_ < Enforcement::PAUSE_READS) {
+    for (auto* session : sessions_) {
+      session->pauseReads();
+    }
+  } else if (newLevel < Enforcement::PAUSE_READS &&
+             level_ >= Enforcement::PAUSE_READS) {
+    for (auto* session : sessions_) {
+      session->resumeReads();
+    }
+  }
+  if (newLevel >= Enforcement::SHRINK_HEADER_TABLES &&
+      level_ < Enforcement::SHRINK_HEADER_TABLES) {
+    // The smaller table takes effect once the peer acks the setting; we
+    // deliberately don't grow it back on de-escalation, the next
+    // SETTINGS the session sends for other reasons may restore it
+    for (auto* session : sessions_) {
+      session->setEgressSettings(
+          {{SettingsId::HEADER_TABLE_SIZE, kShrunkHeaderTableSize}});
+      session->sendSettings();
+    }
+  }
+  level_ = newLevel;
+  return aborted ? Enforcement::ABORT_SESSIONS : newLevel;
+}
+
+} // namespace proxygen
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <proxygen/lib/http/session/HTTPSessionBase.h>
+
+#include <atomic>
+#include <unordered_set>
+
+namespace proxygen {
+
+/**
+ * Per-worker accounting of session memory with progressive enforcement.
+ *
+ * Sessions register after creation and unregister before destruction
+ * (typically driven from InfoCallback::onCreate/onDestroy).  enforce()
+ * sums each session's estimated footprint (see
+ * HTTPSessionBase::getMemoryFootprint) and applies escalating responses
+ * as the configured budgets are crossed:
+ *
+ *   1. pauseReadsBytes: stop reading from all registered sessions'
+ *      transports until usage drops below the budget again.
+ *
+ *   2. shrinkHeaderTablesBytes: advertise a small HEADER_TABLE_SIZE so
+ *      peers' encoders release this worker's decoder table memory.
+ *
+ *   3. abortSessionsBytes: drop the costliest sessions until usage is
+ *      back under this budget.
+ *
+ * Call enforce() periodically, e.g. from a timer on the worker's event
+ * base.  The ledger performs no locking; use it only from the thread that
+ * owns the registered sessions.
+ */
+class HTTPSessionMemoryLedger {
+ public:
+  struct Budgets {
+    // A value of 0 disables the corresponding response
+    uint64_t pauseReadsBytes{0};
+    uint64_t shrinkHeaderTablesBytes{0};
+    uint64_t abortSessionsBytes{0};
+  };
+
+  // Ordered by severity; enforce() reports the strongest response applied
+  enum class Enforcement : uint8_t {
+    NONE = 0,
+    PAUSE_READS,
+    SHRINK_HEADER_TABLES,
+    ABORT_SESSIONS
+  };
+
+  explicit HTTPSessionMemoryLedger(Budgets budgets) : budgets_(budgets) {
+  }
+
+  /**
+   * Register a session.  If enforcement is already active, the new
+   * session is subjected to it immediately.
+   */
+  void addSession(HTTPSessionBase* session);
+
+  /**
+   * Unregister a session.  Must be called before the session is
+   * destroyed; the ledger holds raw pointers.
+   */
+  void removeSession(HTTPSessionBase* session);
+
+  /**
+   * Sum of the registered sessions' estimated footprints.
+   */
+  uint64_t getTotalFootprint() const;
+
+  Enforcement getCurrentEnforcement() const {
+    return level_;
+  }
+
+  size_t getNumSessions() const {
+    return sessions_.size();
+  }
+
+  /**
+   * Re-evaluate the budgets and escalate or relax enforcement
+   * accordingly.  Returns the strongest response applied in this call.
+   */
+  Enforcement enforce();
+
+  /**
+   * Footprint as of the last enforce() call, published for cross-thread
+   * observers (e.g. sampled into ResourceStats on its refresh cycle).
+   * The ledger itself remains usable only from its owning thread.
+   */
+  uint64_t getPublishedFootprint() const {
+    return publishedFootprint_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  std::unordered_set<HTTPSessionBase*> sessions_;
+  Budgets budgets_;
+  Enforcement level_{Enforcement::NONE};
+  std::atomic<uint64_t> publishedFootprint_{0};
+};
+
+} // namespace proxygen
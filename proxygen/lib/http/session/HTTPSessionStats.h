@@ -14,6 +14,31 @@
 
 namespace proxygen {
 
+/**
+ * Flat counters for the per-transaction hot-path records.  Sessions that
+ * enable batched stats (HTTPSessionBase::enableBatchedSessionStats())
+ * bump these with plain increments as transactions come and go and flush
+ * them to the HTTPSessionStats sink once per event loop tick and at
+ * teardown, instead of paying a virtual call plus a time-series update
+ * per event.
+ */
+struct HTTPSessionStatCounters {
+  uint32_t txnsOpened{0};
+  uint32_t txnsClosed{0};
+  uint32_t sessionsReused{0};
+  uint32_t txnsStalled{0};
+  uint32_t sessionsStalled{0};
+
+  bool any() const {
+    return (txnsOpened | txnsClosed | sessionsReused | txnsStalled |
+            sessionsStalled) != 0;
+  }
+
+  void clear() {
+    *this = HTTPSessionStatCounters();
+  }
+};
+
 // This may be retired with a byte events refactor
 class HTTPSessionStats : public TTLBAStats {
  public:
@@ -28,6 +53,88 @@ class HTTPSessionStats : public TTLBAStats {
   }
   virtual void recordTransactionStalled() noexcept = 0;
   virtual void recordSessionStalled() noexcept = 0;
+
+  /**
+   * Accepts a batch of hot-path counters accumulated over one event loop
+   * tick.  The default replays the batch through the per-event records,
+   * so existing sinks see identical totals; sinks backed by time-series
+   * counters should override this and apply each count with a single
+   * update.
+   */
+  virtual void recordPendingStatCounters(
+      const HTTPSessionStatCounters& counters) noexcept {
+    for (uint32_t i = 0; i < counters.txnsOpened; i++) {
+      recordTransactionOpened();
+    }
+    for (uint32_t i = 0; i < counters.txnsClosed; i++) {
+      recordTransactionClosed();
+    }
+    for (uint32_t i = 0; i < counters.sessionsReused; i++) {
+      recordSessionReused();
+    }
+    for (uint32_t i = 0; i < counters.txnsStalled; i++) {
+      recordTransactionStalled();
+    }
+    for (uint32_t i = 0; i < counters.sessionsStalled; i++) {
+      recordSessionStalled();
+    }
+  }
+
+  /**
+   * Egress bytes achieved by a priority band (urgency bucket, or the
+   * band a stream's weight maps to), reported from the egress
+   * scheduler.  Default no-op so existing sinks are unaffected.
+   */
+  virtual void recordPriorityBandEgressBytes(uint8_t /*band*/,
+                                             uint64_t /*bytes*/) noexcept {
+  }
+
+  /**
+   * The scheduler's starvation guard served the given (lowest) band out
+   * of order because it had fallen under its minimum share.
+   */
+  virtual void recordPriorityBandStarvation(uint8_t /*band*/) noexcept {
+  }
+
+  /**
+   * A pipelined HTTP/1.1 response that completed out of order was parked
+   * in the session and has now been replayed in request order.  Reports
+   * the parked body bytes and how long they waited; see
+   * HTTPSession::setEgressReorderLimit().
+   */
+  virtual void recordParkedEgressFlushed(
+      uint64_t /*bytes*/, std::chrono::milliseconds /*parkedFor*/) noexcept {
+  }
+
+  /**
+   * The pre-write defragmentation pass coalesced an egress chain that
+   * exceeded the session's iovec budget: buffersIn/buffersOut are the
+   * chain's buffer counts before and after, bytesCopied how much was
+   * memcpy'd into slabs.  See HTTPSession::setEgressIovecBudget().
+   */
+  virtual void recordEgressChainDefragmented(
+      uint64_t /*buffersIn*/,
+      uint64_t /*buffersOut*/,
+      uint64_t /*bytesCopied*/) noexcept {
+  }
+
+  /**
+   * Idle-liveness probing, see HTTPSession::enableIdleLivenessProbes().
+   * An acked probe means the connection is idle but alive; a dead reap
+   * means the probe went unanswered and the session was only holding
+   * memory for a peer that is gone.
+   */
+  virtual void recordLivenessProbeAcked() noexcept {
+  }
+  virtual void recordDeadSessionReaped() noexcept {
+  }
+
+  /**
+   * One raw session RTT sample, PING-clocked or from TCP_INFO; see
+   * HTTPSession::enableRTTSampling().
+   */
+  virtual void recordSessionRTT(std::chrono::microseconds /*rtt*/) noexcept {
+  }
 };
 
 } // namespace proxygen
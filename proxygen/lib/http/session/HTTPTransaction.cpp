@@ -16,6 +16,8 @@
 #include <proxygen/lib/http/HTTPHeaderSize.h>
 #include <proxygen/lib/http/RFC2616.h>
 #include <proxygen/lib/http/session/HTTPSessionStats.h>
+#include <proxygen/lib/http/session/IngressBufferPolicy.h>
+#include <proxygen/lib/utils/Tracepoints.h>
 #include <sstream>
 
 using folly::IOBuf;
@@ -46,13 +48,15 @@ HTTPTransaction::HTTPTransaction(
     http2::PriorityUpdate priority,
     folly::Optional<HTTPCodec::StreamID> assocId,
     folly::Optional<HTTPCodec::ExAttributes> exAttributes,
-    bool setIngressTimeoutAfterEom)
+    bool setIngressTimeoutAfterEom,
+    HTTPSessionStatCounters* statCounters)
     : deferredEgressBody_(folly::IOBufQueue::cacheChainLength()),
       direction_(direction),
       id_(id),
       seqNo_(seqNo),
       transport_(transport),
       stats_(stats),
+      statCounters_(statCounters),
       recvWindow_(receiveInitialWindowSize),
       sendWindow_(sendInitialWindowSize),
       egressQueue_(egressQueue),
@@ -81,6 +85,9 @@ HTTPTransaction::HTTPTransaction(
       idleTimeout_(defaultIdleTimeout),
       timer_(timer),
       setIngressTimeoutAfterEom_(setIngressTimeoutAfterEom) {
+  stampTiming(Timings::Created);
+  requestContext_ = folly::RequestContext::saveContext();
+  PROXYGEN_SDT(txn_create, this, id_, static_cast<uint8_t>(direction_));
   if (assocStreamId_) {
     if (isUpstream()) {
       egressState_ = HTTPTransactionEgressSM::State::SendingDone;
@@ -101,10 +108,21 @@ HTTPTransaction::HTTPTransaction(
   }
 
   updateReadTimeout();
-  if (stats_) {
+  if (statCounters_) {
+    ++statCounters_->txnsOpened;
+  } else if (stats_) {
     stats_->recordTransactionOpened();
   }
 
+  if (UNLIKELY(AllocationTracker::isEnabled())) {
+    AllocationTracker::recordAllocation(AllocationTracker::SESSION,
+                                        sizeof(HTTPTransaction));
+    if (AllocationTracker::shouldSampleTransaction()) {
+      allocationBaseline_ = std::make_unique<AllocationTracker::Snapshot>(
+          AllocationTracker::getThreadSnapshot());
+    }
+  }
+
   if (direction_ == TransportDirection::DOWNSTREAM || !isPushed()) {
     queueHandle_ =
         egressQueue_.addTransaction(id_, priority, this, false, &insertDepth_);
@@ -143,7 +161,18 @@ HTTPTransaction::~HTTPTransaction() {
     cancelTimeout();
   }
 
-  if (stats_) {
+  releaseIngressBufferAccounting();
+
+  if (pipeSink_) {
+    pipeSink_->pipeSource_ = nullptr;
+  }
+  if (pipeSource_) {
+    pipeSource_->pipeSink_ = nullptr;
+  }
+
+  if (statCounters_) {
+    ++statCounters_->txnsClosed;
+  } else if (stats_) {
     stats_->recordTransactionClosed();
   }
   if (isEnqueued()) {
@@ -169,6 +198,7 @@ void HTTPTransaction::reset(bool useFlowControl,
 void HTTPTransaction::onIngressHeadersComplete(
     std::unique_ptr<HTTPMessage> msg) {
   DestructorGuard g(this);
+  stampTiming(Timings::IngressHeadersComplete);
   msg->setSeqNo(seqNo_);
   if (isUpstream() && !isPushed() && msg->isResponse()) {
     lastResponseStatus_ = msg->getStatusCode();
@@ -224,6 +254,7 @@ void HTTPTransaction::processIngressHeadersComplete(
   }
   refreshTimeout();
   if (handler_ && !isIngressComplete()) {
+    folly::RequestContextScopeGuard rctx(requestContext_);
     handler_->onHeadersComplete(std::move(msg));
   }
 }
@@ -286,8 +317,15 @@ void HTTPTransaction::onIngressBody(unique_ptr<IOBuf> chain, uint16_t padding) {
     recvToAck_ += padding;
   }
   if (mustQueueIngress()) {
+    if (shouldSpillIngressBody() && spillIngressBody(*chain, len)) {
+      return;
+    }
     checkCreateDeferredIngress();
     deferredIngress_->emplace(id_, HTTPEvent::Type::BODY, std::move(chain));
+    deferredIngressBytes_ += len;
+    if (ingressBufferPolicy_) {
+      ingressBufferPolicy_->recordBuffered(len);
+    }
     VLOG(4) << "Queued ingress event of type " << HTTPEvent::Type::BODY
             << " size=" << len << " " << *this;
   } else {
@@ -296,6 +334,70 @@ void HTTPTransaction::onIngressBody(unique_ptr<IOBuf> chain, uint16_t padding) {
   }
 }
 
+bool HTTPTransaction::shouldSpillIngressBody() const {
+  if (!ingressBufferPolicy_ || !ingressBufferPolicy_->spillEnabled() ||
+      deferredChunkEvents_) {
+    return false;
+  }
+  if (ingressSpill_) {
+    // Keep appending until the spill drains, or body would be reordered
+    return true;
+  }
+  return deferredIngressBytes_ >
+             ingressBufferPolicy_->getPerTransactionLimit() ||
+         ingressBufferPolicy_->overWorkerLimit();
+}
+
+bool HTTPTransaction::spillIngressBody(const folly::IOBuf& chain, size_t len) {
+  if (!ingressSpill_) {
+    auto spill = std::make_unique<IngressBodySpill>();
+    if (!spill->valid()) {
+      return false;
+    }
+    ingressSpill_ = std::move(spill);
+    spillPrefixEvents_ = deferredIngress_ ? deferredIngress_->size() : 0;
+  }
+  if (!ingressSpill_->append(chain)) {
+    return false;
+  }
+  VLOG(4) << "Spilled deferred ingress body size=" << len << " " << *this;
+  // The bytes are off the heap, so settle their accounting now and
+  // reopen the window; that is what lets an upload burst stream on while
+  // the handler is stalled
+  CHECK(recvWindow_.free(len));
+  transport_.notifyIngressBodyProcessed(len);
+  if (useFlowControl_ && !isIngressEOMSeen()) {
+    releaseIngressWindow(len);
+  }
+  return true;
+}
+
+void HTTPTransaction::processSpilledBody(std::unique_ptr<IOBuf> data,
+                                         size_t len) {
+  DestructorGuard g(this);
+  if (aborted_) {
+    return;
+  }
+  refreshTimeout();
+  if ((handler_ || pipeSink_) && !isIngressComplete()) {
+    if (pipeSink_) {
+      pipeSink_->sendBody(std::move(data));
+    } else {
+      handler_->onBodyWithOffset(ingressBodyOffset_, std::move(data));
+    }
+  }
+  ingressBodyOffset_ += len;
+}
+
+void HTTPTransaction::releaseIngressBufferAccounting() {
+  if (ingressBufferPolicy_ && deferredIngressBytes_ > 0) {
+    ingressBufferPolicy_->recordDrained(deferredIngressBytes_);
+  }
+  deferredIngressBytes_ = 0;
+  spillPrefixEvents_ = 0;
+  ingressSpill_.reset();
+}
+
 void HTTPTransaction::processIngressBody(unique_ptr<IOBuf> chain, size_t len) {
   FOLLY_SCOPED_TRACE_SECTION("HTTPTransaction - processIngressBody");
   DestructorGuard g(this);
@@ -305,29 +407,145 @@ void HTTPTransaction::processIngressBody(unique_ptr<IOBuf> chain, size_t len) {
   refreshTimeout();
   transport_.notifyIngressBodyProcessed(len);
   auto chainLen = chain->computeChainDataLength();
-  if (handler_) {
+  folly::RequestContextScopeGuard rctx(requestContext_);
+  if (handler_ || pipeSink_) {
     if (!isIngressComplete()) {
-      handler_->onBodyWithOffset(ingressBodyOffset_, std::move(chain));
+      if (pipeSink_) {
+        // Spliced: hand the chain straight to the sink's egress
+        pipeSink_->sendBody(std::move(chain));
+      } else if (ingressAggregation_) {
+        aggregateIngressBody(std::move(chain), chainLen);
+      } else {
+        handler_->onBodyWithOffset(ingressBodyOffset_, std::move(chain));
+      }
     }
 
     if (useFlowControl_ && !isIngressEOMSeen()) {
-      recvToAck_ += len;
-      if (recvToAck_ > 0) {
-        uint32_t divisor = 2;
-        if (transport_.isDraining()) {
-          // only send window updates for draining transports when window is
-          // closed
-          divisor = 1;
-        }
-        if (uint32_t(recvToAck_) >= (recvWindow_.getCapacity() / divisor)) {
-          flushWindowUpdate();
-        }
-      }
+      releaseIngressWindow(len);
     } // else don't care about window updates
   }
   ingressBodyOffset_ += chainLen;
 }
 
+void HTTPTransaction::releaseIngressWindow(uint32_t len) {
+  if (windowUpdateStrategy_) {
+    len = windowUpdateStrategy_->onIngressBytesProcessed(len);
+    if (len == 0) {
+      // Withheld until consumption is confirmed; see
+      // onIngressBodyConsumed()
+      return;
+    }
+  }
+  recvToAck_ += len;
+  maybeFlushWindowUpdate();
+}
+
+void HTTPTransaction::onIngressBodyConsumed(uint32_t bytes) {
+  if (!windowUpdateStrategy_ || !useFlowControl_ || isIngressEOMSeen()) {
+    return;
+  }
+  const auto released = windowUpdateStrategy_->onIngressBytesConsumed(bytes);
+  if (released == 0) {
+    return;
+  }
+  recvToAck_ += released;
+  maybeFlushWindowUpdate();
+}
+
+void HTTPTransaction::Transport::notifyDeferredWorkPending(
+    HTTPTransaction* txn) noexcept {
+  auto evb = getTransportEventBase();
+  if (!evb) {
+    txn->runDeferredWork();
+    return;
+  }
+  evb->runInLoop(
+      [dg = DestructorGuard(txn), txn] { txn->runDeferredWork(); });
+}
+
+void HTTPTransaction::deferWork(folly::Function<void()> fn) {
+  DCHECK(fn);
+  deferredWork_.emplace_back(std::move(fn));
+  if (deferredWork_.size() == 1) {
+    transport_.notifyDeferredWorkPending(this);
+  }
+}
+
+void HTTPTransaction::runDeferredWork() {
+  DestructorGuard g(this);
+  // Move the batch out so work queued by a running item re-notifies the
+  // transport and lands in a later drain
+  auto work = std::move(deferredWork_);
+  deferredWork_.clear();
+  for (auto& fn : work) {
+    fn();
+  }
+}
+
+void HTTPTransaction::maybeFlushWindowUpdate() {
+  if (recvToAck_ <= 0) {
+    return;
+  }
+  // only send window updates for draining transports when window is
+  // closed
+  const bool draining = transport_.isDraining();
+  if (windowUpdateStrategy_) {
+    if (windowUpdateStrategy_->shouldSendWindowUpdate(
+            recvWindow_, uint32_t(recvToAck_), draining)) {
+      flushWindowUpdate();
+    }
+    return;
+  }
+  const uint32_t divisor = draining ? 1 : 2;
+  if (uint32_t(recvToAck_) >= (recvWindow_.getCapacity() / divisor)) {
+    flushWindowUpdate();
+  }
+}
+
+void HTTPTransaction::setIngressDeliveryPolicy(
+    uint64_t maxBytes, std::chrono::milliseconds maxDelay) {
+  if (maxBytes == 0) {
+    flushAggregatedIngress();
+    ingressAggregation_.reset();
+    return;
+  }
+  if (!ingressAggregation_) {
+    ingressAggregation_ = std::make_unique<IngressAggregation>(*this);
+  }
+  ingressAggregation_->maxBytes = maxBytes;
+  ingressAggregation_->maxDelay = maxDelay;
+}
+
+void HTTPTransaction::aggregateIngressBody(std::unique_ptr<IOBuf> chain,
+                                           size_t len) {
+  auto& agg = *ingressAggregation_;
+  if (agg.body.empty()) {
+    agg.firstBodyOffset = ingressBodyOffset_;
+    if (agg.maxDelay.count() > 0 && timer_) {
+      timer_->scheduleTimeout(&agg.flushCallback, agg.maxDelay);
+    }
+  }
+  agg.body.append(std::move(chain));
+  VLOG(4) << "Aggregated ingress body size=" << len
+          << " buffered=" << agg.body.chainLength() << " " << *this;
+  if (agg.body.chainLength() >= agg.maxBytes) {
+    flushAggregatedIngress();
+  }
+}
+
+void HTTPTransaction::flushAggregatedIngress() {
+  if (!ingressAggregation_ || ingressAggregation_->body.empty()) {
+    return;
+  }
+  DestructorGuard g(this);
+  ingressAggregation_->flushCallback.cancelTimeout();
+  auto data = ingressAggregation_->body.move();
+  if (handler_ && !aborted_ && !isIngressComplete()) {
+    handler_->onBodyWithOffset(ingressAggregation_->firstBodyOffset,
+                               std::move(data));
+  }
+}
+
 void HTTPTransaction::onIngressChunkHeader(size_t length) {
   if (!validateIngressStateTransition(
           HTTPTransactionIngressSM::Event::onChunkHeader)) {
@@ -336,6 +554,7 @@ void HTTPTransaction::onIngressChunkHeader(size_t length) {
   if (mustQueueIngress()) {
     checkCreateDeferredIngress();
     deferredIngress_->emplace(id_, HTTPEvent::Type::CHUNK_HEADER, length);
+    deferredChunkEvents_ = true;
     VLOG(4) << "Queued ingress event of type " << HTTPEvent::Type::CHUNK_HEADER
             << " size=" << length << " " << *this;
   } else {
@@ -402,6 +621,8 @@ void HTTPTransaction::processIngressTrailers(unique_ptr<HTTPHeaders> trailers) {
     return;
   }
   refreshTimeout();
+  // Trailers follow the body; deliver anything still aggregated first
+  flushAggregatedIngress();
   if (handler_ && !isIngressComplete()) {
     handler_->onTrailers(std::move(trailers));
   }
@@ -455,6 +676,7 @@ void HTTPTransaction::onIngressEOM() {
   if (!validateIngressStateTransition(HTTPTransactionIngressSM::Event::onEOM)) {
     return;
   }
+  stampTiming(Timings::IngressEOM);
   // We need to update the read timeout here.  We're not likely to be
   // expecting any more ingress, and the timer should be cancelled
   // immediately.  If we are expecting more, this will reset the timer.
@@ -475,14 +697,24 @@ void HTTPTransaction::processIngressEOM() {
     return;
   }
   VLOG(4) << "ingress EOM on " << *this;
+  // The handler must see the full body before onEOM
+  flushAggregatedIngress();
   const bool wasComplete = isIngressComplete();
   if (!validateIngressStateTransition(
           HTTPTransactionIngressSM::Event::eomFlushed)) {
     return;
   }
-  if (handler_) {
+  if (handler_ || pipeSink_) {
     if (!wasComplete) {
-      handler_->onEOM();
+      if (pipeSink_) {
+        // Forward EOM to the spliced sink and unlink the pipe
+        auto* sink = pipeSink_;
+        pipeTo(nullptr);
+        sink->sendEOM();
+      } else {
+        folly::RequestContextScopeGuard rctx(requestContext_);
+        handler_->onEOM();
+      }
     }
   } else {
     markEgressComplete();
@@ -516,6 +748,7 @@ void HTTPTransaction::markIngressComplete() {
   VLOG(4) << "Marking ingress complete on " << *this;
   ingressState_ = HTTPTransactionIngressSM::State::ReceivingDone;
   deferredIngress_.reset();
+  releaseIngressBufferAccounting();
   cancelTimeout();
 }
 
@@ -538,7 +771,9 @@ bool HTTPTransaction::validateIngressStateTransition(
     HTTPTransactionIngressSM::Event event) {
   DestructorGuard g(this);
 
-  if (!HTTPTransactionIngressSM::transit(ingressState_, event)) {
+  // tryTransit over transit: the exception below already reports the
+  // state and event, and this runs for every ingress callback
+  if (!HTTPTransactionIngressSM::tryTransit(ingressState_, event)) {
     std::stringstream ss;
     ss << "Invalid ingress state transition, state=" << ingressState_
        << ", event=" << event << ", streamID=" << id_;
@@ -627,6 +862,7 @@ void HTTPTransaction::onError(const HTTPException& error) {
   }
   if (notify && handler_) {
     // mark egress complete may result in handler detaching
+    folly::RequestContextScopeGuard rctx(requestContext_);
     handler_->onError(error);
   }
 }
@@ -719,6 +955,7 @@ void HTTPTransaction::onEgressTimeout() {
 
 void HTTPTransaction::onEgressHeaderFirstByte() {
   DestructorGuard g(this);
+  stampTiming(Timings::EgressHeadersFirstByteFlushed);
   if (transportCallback_) {
     transportCallback_->firstHeaderByteFlushed();
   }
@@ -726,6 +963,7 @@ void HTTPTransaction::onEgressHeaderFirstByte() {
 
 void HTTPTransaction::onEgressBodyFirstByte() {
   DestructorGuard g(this);
+  stampTiming(Timings::EgressBodyFirstByteFlushed);
   if (transportCallback_) {
     transportCallback_->firstByteFlushed();
   }
@@ -733,6 +971,7 @@ void HTTPTransaction::onEgressBodyFirstByte() {
 
 void HTTPTransaction::onEgressBodyLastByte() {
   DestructorGuard g(this);
+  stampTiming(Timings::EgressLastByteFlushed);
   if (transportCallback_) {
     transportCallback_->lastByteFlushed();
   }
@@ -747,11 +986,25 @@ void HTTPTransaction::onEgressTrackedByte() {
 
 void HTTPTransaction::onEgressLastByteAck(std::chrono::milliseconds latency) {
   DestructorGuard g(this);
+  stampTiming(Timings::EgressLastByteAcked);
   if (transportCallback_) {
     transportCallback_->lastByteAcked(latency);
   }
 }
 
+void HTTPTransaction::sampleTimingsTo(TraceEvent& event) const {
+  const auto created = timings_.get(Timings::Created);
+  auto addDelta = [&](Timings::Event timingEvent, TraceFieldType field) {
+    if (timings_.reached(timingEvent)) {
+      event.addMeta(
+          field,
+          millisecondsBetween(timings_.get(timingEvent), created).count());
+    }
+  };
+  addDelta(Timings::EgressHeadersFirstByteFlushed, TraceFieldType::TTFB);
+  addDelta(Timings::EgressLastByteFlushed, TraceFieldType::TTLB);
+}
+
 void HTTPTransaction::onLastEgressHeaderByteAcked() {
   FOLLY_SCOPED_TRACE_SECTION("HTTPTransaction - onLastEgressHeaderByteAcked");
   egressHeadersDelivered_ = true;
@@ -845,6 +1098,26 @@ void HTTPTransaction::sendHeadersWithOptionalEOM(const HTTPMessage& headers,
   flushWindowUpdate();
 }
 
+void HTTPTransaction::sendEarlyHints(const HTTPHeaders& headers) {
+  CHECK(HTTPTransactionEgressSM::transit(
+      egressState_, HTTPTransactionEgressSM::Event::sendEarlyHints));
+  CHECK(isDownstream()) << "Early hints are a response-side feature";
+  DCHECK(!isEgressComplete());
+  // Interim response: lastResponseStatus_, content-length accounting
+  // and the 1xx bookkeeping that feeds delegation checks stay untouched
+  // so the final sendHeaders() proceeds as if no hints were sent.
+  HTTPMessage hints;
+  hints.setHTTPVersion(1, 1);
+  hints.setStatusCode(103);
+  hints.setStatusMessage("Early Hints");
+  hints.getHeaders() = headers;
+  HTTPHeaderSize size;
+  transport_.sendHeaders(this, hints, &size, false /* eom */);
+  if (transportCallback_) {
+    transportCallback_->headerBytesGenerated(size);
+  }
+}
+
 bool HTTPTransaction::delegatedTransactionChecks(
     const HTTPMessage& headers) noexcept {
   if (!delegatedTransactionChecks()) {
@@ -934,12 +1207,22 @@ void HTTPTransaction::sendBody(std::unique_ptr<folly::IOBuf> body) {
                                                            // sendChunkHeader
 
   CHECK_EQ(0, deferredBufferMeta_.length);
-  CHECK(HTTPTransactionEgressSM::transit(
+  // tryTransit: one table access per chunk, CHECK reports the failure
+  CHECK(HTTPTransactionEgressSM::tryTransit(
       egressState_, HTTPTransactionEgressSM::Event::sendBody));
 
+  if (body && egressBodyTransforms_) {
+    // everything downstream (digest, length accounting, byte tracking)
+    // sees the transformed bytes, i.e. what goes on the wire
+    body = egressBodyTransforms_->transform(std::move(body));
+  }
   if (body) {
     size_t bodyLen = body->computeChainDataLength();
     actualResponseLength_ = actualResponseLength_.value() + bodyLen;
+    if (egressDigest_) {
+      // hash while the chunk is already in cache from the length walk
+      egressDigest_->update(*body);
+    }
 
     if (chunking) {
       // Note, this check doesn't account for cases where sendBody is called
@@ -960,9 +1243,33 @@ void HTTPTransaction::sendBody(std::unique_ptr<folly::IOBuf> body) {
   notifyTransportPendingEgress();
 }
 
+void HTTPTransaction::sendBodyFromAnyThread(
+    std::unique_ptr<folly::IOBuf> body) {
+  crossThreadBody_.insertHead(std::move(body));
+  if (crossThreadBodyDrainScheduled_.exchange(true,
+                                              std::memory_order_acq_rel)) {
+    // a drain is already pending and will pick up this chunk
+    return;
+  }
+  auto evb = transport_.getTransportEventBase();
+  CHECK(evb) << "transport does not support cross-thread egress";
+  evb->runInEventBaseThread([this] { drainCrossThreadBody(); });
+}
+
+void HTTPTransaction::drainCrossThreadBody() {
+  DestructorGuard guard(this);
+  // clear the flag before sweeping: producers that see it set are guaranteed
+  // their chunk was inserted before the sweep below takes the list
+  crossThreadBodyDrainScheduled_.store(false, std::memory_order_release);
+  crossThreadBody_.sweep(
+      [this](std::unique_ptr<folly::IOBuf>&& chunk) {
+        sendBody(std::move(chunk));
+      });
+}
+
 void HTTPTransaction::addBufferMeta() noexcept {
   DestructorGuard guard(this);
-  CHECK(HTTPTransactionEgressSM::transit(
+  CHECK(HTTPTransactionEgressSM::tryTransit(
       egressState_, HTTPTransactionEgressSM::Event::sendBody));
   CHECK(!deferredBufferMeta_.length);
   CHECK(!actualResponseLength_ || !*actualResponseLength_);
@@ -982,6 +1289,7 @@ void HTTPTransaction::addBufferMeta() noexcept {
 bool HTTPTransaction::onWriteReady(const uint32_t maxEgress, double ratio) {
   DestructorGuard g(this);
   DCHECK(isEnqueued());
+  stampTiming(Timings::FirstEgressWrite);
   if (prioritySample_) {
     updateRelativeWeight(ratio);
   }
@@ -1089,34 +1397,35 @@ size_t HTTPTransaction::sendDeferredBufferMeta(uint32_t maxEgress) {
   if (isPrioritySampled()) {
     updateTransactionBytesSent(bufferMeta.length);
   }
-  if (egressLimitBytesPerMs_ > 0) {
-    numLimitedBytesEgressed_ += nbytes;
+  if (egressLimitBytesPerMs() > 0) {
+    coldState_->numLimitedBytesEgressed += nbytes;
   }
   return nbytes;
 }
 
 bool HTTPTransaction::maybeDelayForRateLimit() {
-  if (egressLimitBytesPerMs_ <= 0) {
+  if (egressLimitBytesPerMs() <= 0) {
     // No rate limiting
     return false;
   }
 
-  if (numLimitedBytesEgressed_ == 0) {
+  if (coldState_->numLimitedBytesEgressed == 0) {
     // If we haven't egressed any bytes yet, don't delay.
     return false;
   }
 
   int64_t limitedDurationMs =
-      (int64_t)millisecondsBetween(getCurrentTime(), startRateLimit_).count();
+      (int64_t)millisecondsBetween(getCurrentTime(), coldState_->startRateLimit)
+          .count();
 
   // Algebra!  Try to figure out the next time send where we'll
   // be allowed to send at least 1 full packet's worth.  The
   // formula we're using is:
   //   (bytesSoFar + packetSize) / (timeSoFar + delay) == targetRateLimit
   std::chrono::milliseconds requiredDelay(
-      (((int64_t)numLimitedBytesEgressed_ + kApproximateMTU) -
-       ((int64_t)egressLimitBytesPerMs_ * limitedDurationMs)) /
-      (int64_t)egressLimitBytesPerMs_);
+      (((int64_t)coldState_->numLimitedBytesEgressed + kApproximateMTU) -
+       ((int64_t)coldState_->egressLimitBytesPerMs * limitedDurationMs)) /
+      (int64_t)coldState_->egressLimitBytesPerMs);
 
   if (requiredDelay.count() <= 0) {
     // No delay required
@@ -1135,7 +1444,7 @@ bool HTTPTransaction::maybeDelayForRateLimit() {
   egressRateLimited_ = true;
 
   if (timer_) {
-    timer_->scheduleTimeout(&rateLimitCallback_, requiredDelay);
+    timer_->scheduleTimeout(&coldState_->rateLimitCallback, requiredDelay);
   }
 
   notifyTransportPendingEgress();
@@ -1205,14 +1514,49 @@ size_t HTTPTransaction::sendBodyNow(std::unique_ptr<folly::IOBuf> body,
   if (isPrioritySampled()) {
     updateTransactionBytesSent(bodyLen);
   }
-  if (egressLimitBytesPerMs_ > 0) {
-    numLimitedBytesEgressed_ += nbytes;
+  if (egressLimitBytesPerMs() > 0) {
+    coldState_->numLimitedBytesEgressed += nbytes;
   }
   return nbytes;
 }
 
+void HTTPTransaction::enableEgressBodyDigest(DigestAlgorithm algorithm) {
+  CHECK(!egressDigest_) << "egress digest already enabled";
+  CHECK(!actualResponseLength_ || *actualResponseLength_ == 0)
+      << "enableEgressBodyDigest must precede the first sendBody";
+  egressDigest_ = std::make_unique<BodyDigestContext>(algorithm);
+}
+
+void HTTPTransaction::setEgressBodyTransformPipeline(
+    std::unique_ptr<HTTPBodyTransformPipeline> pipeline) {
+  CHECK(!egressBodyTransforms_) << "egress transform pipeline already set";
+  CHECK(!actualResponseLength_ || *actualResponseLength_ == 0)
+      << "setEgressBodyTransformPipeline must precede the first sendBody";
+  egressBodyTransforms_ = std::move(pipeline);
+}
+
 void HTTPTransaction::sendEOM() {
   DestructorGuard g(this);
+  if (egressBodyTransforms_) {
+    // flush before the digest runs so the tail bytes are hashed too;
+    // taking the pipeline first lets sendBody() append them unmodified
+    auto pipeline = std::move(egressBodyTransforms_);
+    auto tail = pipeline->finish();
+    if (tail && !tail->empty()) {
+      sendBody(std::move(tail));
+    }
+  }
+  if (egressDigest_) {
+    auto digest = egressDigest_->finish();
+    egressDigest_.reset();
+    if (trailers_) {
+      trailers_->add("Digest", digest);
+    } else {
+      HTTPHeaders trailers;
+      trailers.add("Digest", digest);
+      sendTrailers(trailers);
+    }
+  }
   CHECK(HTTPTransactionEgressSM::transit(
       egressState_, HTTPTransactionEgressSM::Event::sendEOM))
       << ", " << *this;
@@ -1285,6 +1629,22 @@ HTTPTransaction::getConnectionToken() const noexcept {
   return transport_.getConnectionToken();
 }
 
+void HTTPTransaction::pipeTo(HTTPTransaction* sink) {
+  if (pipeSink_) {
+    pipeSink_->pipeSource_ = nullptr;
+  }
+  pipeSink_ = sink;
+  if (pipeSink_) {
+    CHECK(!pipeSink_->pipeSource_) << "sink already has a pipe source";
+    pipeSink_->pipeSource_ = this;
+    VLOG(4) << "piping ingress of " << *this << " to " << *pipeSink_;
+    // Pick up the sink's current backpressure state
+    if (pipeSink_->handlerEgressPaused_) {
+      pauseIngress();
+    }
+  }
+}
+
 void HTTPTransaction::pauseIngress() {
   VLOG(4) << "pauseIngress request " << *this;
   DestructorGuard g(this);
@@ -1294,6 +1654,8 @@ void HTTPTransaction::pauseIngress() {
   }
   ingressPaused_ = true;
   cancelTimeout();
+  // Don't sit on aggregated body across a pause of unknown duration
+  flushAggregatedIngress();
   transport_.pauseIngress(this);
 }
 
@@ -1322,7 +1684,28 @@ void HTTPTransaction::resumeIngress() {
   // Note: we recheck the ingressPaused_ state because a callback
   // invoked by the resumeIngress() call above could have re-paused
   // the transaction.
-  while (!ingressPaused_ && deferredIngress_ && !deferredIngress_->empty()) {
+  constexpr uint64_t kSpillReadSize = 65536;
+  while (!ingressPaused_) {
+    // Once the pre-spill prefix of the queue has been delivered, the
+    // spill file holds the next bytes in order
+    if (ingressSpill_ && spillPrefixEvents_ == 0) {
+      if (ingressSpill_->empty()) {
+        ingressSpill_.reset();
+      } else {
+        auto data = ingressSpill_->read(kSpillReadSize);
+        if (!data) {
+          LOG(ERROR) << "Failed to read back spilled ingress body " << *this;
+          sendAbort(ErrorCode::INTERNAL_ERROR);
+          break;
+        }
+        auto len = data->computeChainDataLength();
+        processSpilledBody(std::move(data), len);
+        continue;
+      }
+    }
+    if (!deferredIngress_ || deferredIngress_->empty()) {
+      break;
+    }
     HTTPEvent& callback(deferredIngress_->front());
     VLOG(5) << "Processing deferred ingress callback of type "
             << callback.getEvent() << " " << *this;
@@ -1337,6 +1720,11 @@ void HTTPTransaction::resumeIngress() {
         unique_ptr<IOBuf> data = callback.getBody();
         auto len = data->computeChainDataLength();
         CHECK(recvWindow_.free(len));
+        DCHECK_GE(deferredIngressBytes_, len);
+        deferredIngressBytes_ -= len;
+        if (ingressBufferPolicy_) {
+          ingressBufferPolicy_->recordDrained(len);
+        }
         processIngressBody(std::move(data), len);
       } break;
       case HTTPEvent::Type::CHUNK_HEADER:
@@ -1357,6 +1745,9 @@ void HTTPTransaction::resumeIngress() {
     }
     if (deferredIngress_) {
       deferredIngress_->pop();
+      if (spillPrefixEvents_ > 0) {
+        spillPrefixEvents_--;
+      }
     }
   }
   updateReadTimeout();
@@ -1386,12 +1777,17 @@ void HTTPTransaction::resumeEgress() {
 }
 
 void HTTPTransaction::setEgressRateLimit(uint64_t bitsPerSecond) {
-  egressLimitBytesPerMs_ = bitsPerSecond / 8000;
-  if (bitsPerSecond > 0 && egressLimitBytesPerMs_ == 0) {
+  if (bitsPerSecond == 0 && !coldState_) {
+    // Clearing a limit that was never set; don't allocate cold state for it
+    return;
+  }
+  auto& cold = coldState();
+  cold.egressLimitBytesPerMs = bitsPerSecond / 8000;
+  if (bitsPerSecond > 0 && cold.egressLimitBytesPerMs == 0) {
     VLOG(4) << "ratelim: Limit too low (" << bitsPerSecond << "), ignoring";
   }
-  startRateLimit_ = getCurrentTime();
-  numLimitedBytesEgressed_ = 0;
+  cold.startRateLimit = getCurrentTime();
+  cold.numLimitedBytesEgressed = 0;
 }
 
 void HTTPTransaction::notifyTransportPendingEgress() {
@@ -1429,7 +1825,9 @@ void HTTPTransaction::updateHandlerPauseState() {
   // i.e. when availWindow == 0
   if (useFlowControl_ && availWindow < 0 && !flowControlPaused_) {
     VLOG(4) << "transaction stalled by flow control txn=" << *this;
-    if (stats_) {
+    if (statCounters_) {
+      ++statCounters_->txnsStalled;
+    } else if (stats_) {
       stats_->recordTransactionStalled();
     }
   }
@@ -1442,15 +1840,25 @@ void HTTPTransaction::updateHandlerPauseState() {
     VLOG(4) << "Not resuming handler, buffer full, txn=" << *this;
   }
 
-  if (handler_ && handlerShouldBePaused != handlerEgressPaused_) {
+  if ((handler_ || pipeSource_) && handlerShouldBePaused != handlerEgressPaused_) {
     if (handlerShouldBePaused) {
       handlerEgressPaused_ = true;
       VLOG(4) << "egress paused txn=" << *this;
-      handler_->onEgressPaused();
+      if (pipeSource_) {
+        pipeSource_->pauseIngress();
+      }
+      if (handler_) {
+        handler_->onEgressPaused();
+      }
     } else {
       handlerEgressPaused_ = false;
       VLOG(4) << "egress resumed txn=" << *this;
-      handler_->onEgressResumed();
+      if (pipeSource_) {
+        pipeSource_->resumeIngress();
+      }
+      if (handler_) {
+        handler_->onEgressResumed();
+      }
     }
   }
 }
@@ -1497,7 +1905,7 @@ bool HTTPTransaction::onPushedTransaction(HTTPTransaction* pushTxn) {
     VLOG(4) << "Failed to create a handler for push transaction";
     return false;
   }
-  pushedTransactions_.insert(pushTxn->getID());
+  coldState().pushedTransactions.insert(pushTxn->getID());
   return true;
 }
 
@@ -1518,7 +1926,7 @@ bool HTTPTransaction::onExTransaction(HTTPTransaction* exTxn) {
     LOG(ERROR) << "Failed to create a handler for ExTransaction";
     return false;
   }
-  exTransactions_.insert(exTxn->getID());
+  coldState().exTransactions.insert(exTxn->getID());
   return true;
 }
 
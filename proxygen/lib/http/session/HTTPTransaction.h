@@ -9,12 +9,18 @@
 #pragma once
 
 #include "proxygen/lib/http/HTTPMessage.h"
+#include <array>
+#include <chrono>
 #include <climits>
+#include <folly/AtomicLinkedList.h>
+#include <folly/IntrusiveList.h>
 #include <folly/Optional.h>
 #include <folly/SocketAddress.h>
+#include <folly/small_vector.h>
 #include <folly/io/async/AsyncTransport.h>
 #include <folly/io/async/DelayedDestructionBase.h>
 #include <folly/io/async/HHWheelTimer.h>
+#include <folly/io/async/Request.h>
 #include <folly/lang/Assume.h>
 #include <iosfwd>
 #include <proxygen/lib/http/HTTPConstants.h>
@@ -22,12 +28,16 @@
 #include <proxygen/lib/http/HTTPMessage.h>
 #include <proxygen/lib/http/ProxygenErrorEnum.h>
 #include <proxygen/lib/http/Window.h>
+#include <proxygen/lib/http/WindowUpdateStrategy.h>
+#include <proxygen/lib/http/HTTPBodyTransformPipeline.h>
 #include <proxygen/lib/http/codec/HTTPCodec.h>
+#include <proxygen/lib/utils/AllocationTracker.h>
 #include <proxygen/lib/http/session/ByteEvents.h>
 #include <proxygen/lib/http/session/HTTP2PriorityQueue.h>
 #include <proxygen/lib/http/session/HTTPEvent.h>
 #include <proxygen/lib/http/session/HTTPTransactionEgressSM.h>
 #include <proxygen/lib/http/session/HTTPTransactionIngressSM.h>
+#include <proxygen/lib/utils/BodyDigest.h>
 #include <proxygen/lib/utils/Time.h>
 #include <proxygen/lib/utils/TraceEvent.h>
 #include <proxygen/lib/utils/TraceEventObserver.h>
@@ -142,6 +152,8 @@ class TransactionInfo {
 
 class HTTPSessionStats;
 class HTTPTransaction;
+class IngressBufferPolicy;
+class IngressBodySpill;
 class HTTPTransactionHandler : public TraceEventObserver {
  public:
   /**
@@ -503,6 +515,15 @@ class HTTPTransaction
 
     virtual void notifyIngressBodyProcessed(uint32_t bytes) noexcept = 0;
 
+    /**
+     * The transaction queued its first deferred work item since the
+     * last drain (see HTTPTransaction::deferWork).  HTTPSession
+     * overrides this to batch-drain the queues when its loop callback
+     * completes; the default runs the queue through the transport
+     * event base, or inline when the transport has none.
+     */
+    virtual void notifyDeferredWorkPending(HTTPTransaction* txn) noexcept;
+
     virtual void notifyEgressBodyBuffered(int64_t bytes) noexcept = 0;
 
     virtual const folly::SocketAddress& getLocalAddress() const noexcept = 0;
@@ -521,6 +542,15 @@ class HTTPTransaction
     virtual HTTPTransaction::Transport::Type getSessionType()
         const noexcept = 0;
 
+    /**
+     * Event base the transaction runs on, used to hand egress generated on
+     * other threads back to this thread.  Returns nullptr if the transport
+     * does not support cross-thread egress.
+     */
+    virtual folly::EventBase* getTransportEventBase() noexcept {
+      return nullptr;
+    }
+
     virtual const HTTPCodec& getCodec() const noexcept = 0;
 
     /*
@@ -554,6 +584,20 @@ class HTTPTransaction
     virtual const folly::AsyncTransport* getUnderlyingTransport()
         const noexcept = 0;
 
+    /**
+     * Hand the session's raw transport to the caller so an established
+     * CONNECT or upgrade tunnel can relay bytes with no codec involved
+     * (see proxygen/lib/utils/SocketTunnel.h).  Only succeeds for
+     * serial-protocol sessions carrying this single transaction with
+     * nothing buffered in either direction; on success the transaction
+     * errors out with kErrorEOF and the session tears itself down
+     * without touching the socket.  Returns nullptr when the session
+     * cannot be collapsed, leaving it fully usable.
+     */
+    virtual folly::AsyncTransport::UniquePtr extractTunnelTransport() noexcept {
+      return nullptr;
+    }
+
     /**
      * Returns true if the underlying transport has completed full handshake.
      */
@@ -611,7 +655,8 @@ class HTTPTransaction
       folly::Optional<HTTPCodec::StreamID> assocStreamId = HTTPCodec::NoStream,
       folly::Optional<HTTPCodec::ExAttributes> exAttributes =
           HTTPCodec::NoExAttributes,
-      bool setIngressTimeoutAfterEom = false);
+      bool setIngressTimeoutAfterEom = false,
+      HTTPSessionStatCounters* statCounters = nullptr);
 
   ~HTTPTransaction() override;
 
@@ -628,6 +673,22 @@ class HTTPTransaction
     return seqNo_;
   }
 
+  /**
+   * folly::RequestContext associated with this transaction, captured at
+   * construction and applied around handler ingress/error callbacks so
+   * thread-local request data (and profiler sample attribution) follows
+   * the transaction rather than whatever ran last on the event base.
+   * Routing layers that tag requests should replace it once the route
+   * is known, before the body arrives.
+   */
+  const std::shared_ptr<folly::RequestContext>& getRequestContext() const {
+    return requestContext_;
+  }
+
+  void setRequestContext(std::shared_ptr<folly::RequestContext> ctx) {
+    requestContext_ = std::move(ctx);
+  }
+
   const Transport& getTransport() const {
     return transport_;
   }
@@ -636,6 +697,15 @@ class HTTPTransaction
     return transport_;
   }
 
+  /**
+   * Collapse the session into a raw tunnel transport; see
+   * Transport::extractTunnelTransport().  On success this transaction
+   * receives onError(kErrorEOF) before the call returns.
+   */
+  folly::AsyncTransport::UniquePtr extractTunnelTransport() noexcept {
+    return transport_.extractTunnelTransport();
+  }
+
   virtual void setHandler(Handler* handler) {
     handler_ = handler;
     if (handler_) {
@@ -753,6 +823,88 @@ class HTTPTransaction
     return maxDeferredIngress_;
   }
 
+  /**
+   * Attach the worker's ingress buffering policy.  The policy bounds how
+   * much deferred ingress body this transaction (and, in aggregate, the
+   * worker) holds in memory while the handler has ingress paused, and
+   * optionally spills the excess to a temp-file-backed buffer.  The
+   * policy must outlive the transaction.
+   */
+  void setIngressBufferPolicy(IngressBufferPolicy* policy) {
+    ingressBufferPolicy_ = policy;
+  }
+
+  /**
+   * Install a policy for releasing the receive window (see
+   * WindowUpdateStrategy.h).  nullptr (the default) is the historical
+   * eager release.  With a consumption-clocked strategy, the owner must
+   * call onIngressBodyConsumed() as bytes are confirmed absorbed or the
+   * window stays shut.
+   */
+  void setWindowUpdateStrategy(std::unique_ptr<WindowUpdateStrategy> strategy) {
+    windowUpdateStrategy_ = std::move(strategy);
+  }
+
+  /**
+   * Report bytes confirmed consumed downstream of the handler (e.g.
+   * from an egress-side ByteEventTracker delivery callback in a proxy).
+   * Feeds the installed WindowUpdateStrategy; a no-op for strategies
+   * that release on delivery.
+   */
+  void onIngressBodyConsumed(uint32_t bytes);
+
+  /**
+   * Queue a small follow-up (stats, logging, cleanup) to run after the
+   * session finishes its current loop callback, while the transaction
+   * is still cache-hot.  The queue is pooled with the transaction -
+   * kDeferredWorkInline items fit with no allocation - and drains in
+   * FIFO order; work queued by a running item lands in a later drain.
+   * Work still queued when the transaction is destroyed is dropped, so
+   * callbacks must not be required for correctness.
+   */
+  void deferWork(folly::Function<void()> fn);
+
+  /**
+   * Drain the deferred work queue; invoked by the transport at the end
+   * of its loop callback.
+   */
+  void runDeferredWork();
+
+  /**
+   * Inline capacity of the deferred work queue; queueing more than this
+   * many items between drains falls back to the heap.
+   */
+  static constexpr size_t kDeferredWorkInline = 6;
+
+  /**
+   * Links transactions with queued deferred work into the session's
+   * drain list; public for the intrusive list member pointer, like
+   * ByteEvent::listHook.
+   */
+  folly::IntrusiveListHook deferredWorkHook_;
+
+  /**
+   * Deferred ingress body bytes currently held in memory.
+   */
+  uint64_t getDeferredIngressBodyBytes() const {
+    return deferredIngressBytes_;
+  }
+
+  /**
+   * Aggregate ingress body before delivering it to the handler.  With
+   * maxBytes > 0, arriving body is buffered until maxBytes accumulate
+   * or maxDelay elapses (rounded up to the wheel timer's millisecond
+   * ticks), then handed to the handler in a single onBody callback;
+   * EOM, trailers, and pauseIngress() flush whatever is buffered
+   * immediately.  For handlers whose per-callback cost dominates on
+   * small reads; streaming handlers should leave this off (the default
+   * delivers each read as it arrives).  Flow control is unaffected:
+   * buffered bytes count as processed, as on the spill path.  maxBytes
+   * of 0 flushes and disables aggregation.
+   */
+  void setIngressDeliveryPolicy(uint64_t maxBytes,
+                                std::chrono::milliseconds maxDelay);
+
   /**
    * Invoked by the session when the ingress headers are complete
    */
@@ -916,6 +1068,82 @@ class HTTPTransaction
     transportCallback_ = cb;
   }
 
+  /**
+   * Compact, always-on record of when this transaction reached key
+   * lifecycle points.  Stamps are steady-clock time points stored in a
+   * fixed array, so recording one is a single store with no allocation.
+   * A default-constructed (epoch) time point means the event has not
+   * happened yet.
+   */
+  struct Timings {
+    enum Event : uint8_t {
+      Created = 0,
+      IngressHeadersComplete,
+      IngressEOM,
+      FirstEgressWrite,
+      EgressHeadersFirstByteFlushed,
+      EgressBodyFirstByteFlushed,
+      EgressLastByteFlushed,
+      EgressLastByteAcked,
+      NUM_EVENTS
+    };
+
+    TimePoint get(Event event) const {
+      return stamps[event];
+    }
+
+    bool reached(Event event) const {
+      return stamps[event] != TimePoint();
+    }
+
+    std::array<TimePoint, NUM_EVENTS> stamps{};
+  };
+
+  const Timings& getTimings() const {
+    return timings_;
+  }
+
+  /**
+   * Allocation counters recorded on this transaction's thread since the
+   * transaction was created.  Only present on sampled transactions while
+   * AllocationTracker is enabled.  The counters cover everything the
+   * thread allocated in the window, so treat them as attribution
+   * estimates rather than exact per-transaction figures.
+   */
+  folly::Optional<AllocationTracker::Snapshot> getAllocationSnapshot() const {
+    if (!allocationBaseline_) {
+      return folly::none;
+    }
+    return AllocationTracker::getThreadSnapshot().delta(*allocationBaseline_);
+  }
+
+  /**
+   * The last response status sent (downstream) or received (upstream) on
+   * this transaction; 0 if no response headers were seen.
+   */
+  uint16_t getLastResponseStatus() const {
+    return lastResponseStatus_;
+  }
+
+  bool isAborted() const {
+    return aborted_;
+  }
+
+  uint64_t getIngressBodyBytesReceived() const {
+    return ingressBodyOffset_;
+  }
+
+  uint64_t getEgressBodyBytesSent() const {
+    return actualResponseLength_.value_or(0);
+  }
+
+  /**
+   * Copy time-to-first-byte and time-to-last-byte (milliseconds since the
+   * transaction was created) into a trace event.  Only fields whose events
+   * have already occurred are added.
+   */
+  void sampleTimingsTo(TraceEvent& event) const;
+
   /**
    * @return true if ingress has started on this transaction.
    */
@@ -1014,6 +1242,19 @@ class HTTPTransaction
   virtual void sendHeadersWithEOM(const HTTPMessage& headers);
   virtual void sendHeadersWithOptionalEOM(const HTTPMessage& headers, bool eom);
 
+  /**
+   * Send a 103 Early Hints interim response carrying the given headers
+   * (typically Link: preload hints).  Legal only on a downstream
+   * transaction before sendHeaders(); the egress state machine stays in
+   * its initial state and none of the final-response bookkeeping
+   * (status, content-length accounting) is touched, so the final
+   * response is sent exactly as if no hints had gone out.  May be
+   * called more than once.
+   *
+   * @param headers  Hint headers for the interim response
+   */
+  virtual void sendEarlyHints(const HTTPHeaders& headers);
+
   /**
    * Experimental API
    *
@@ -1037,6 +1278,22 @@ class HTTPTransaction
    */
   virtual void sendBody(std::unique_ptr<folly::IOBuf> body);
 
+  /**
+   * Experimental API
+   *
+   * Thread-safe variant of sendBody for producers running off the
+   * transaction's event base (e.g. CPU worker threads).  Chunks are pushed
+   * onto a lock-free MPSC list and handed to sendBody() on the event base;
+   * at most one event base notification is scheduled per batch regardless of
+   * how many chunks are enqueued before the drain runs.
+   *
+   * The caller must guarantee the transaction stays alive until the drain
+   * has run (e.g. by not sending EOM from another thread and keeping the
+   * handler attached), and must stop enqueuing once it has requested EOM.
+   * Only usable when the transport exposes an event base.
+   */
+  void sendBodyFromAnyThread(std::unique_ptr<folly::IOBuf> body);
+
   /**
    * Write any protocol framing required for the subsequent call(s)
    * to sendBody(). This method does not actually write the message out on
@@ -1082,6 +1339,37 @@ class HTTPTransaction
     trailers_.reset(new HTTPHeaders(trailers));
   }
 
+  /**
+   * Compute a digest of the egress body incrementally, hashing each
+   * chunk as it passes through sendBody() so multi-MB bodies are walked
+   * once instead of re-traversed by the handler.  At sendEOM() the
+   * result is emitted as an RFC 3230 "Digest" trailer (merged into the
+   * handler's trailers when it sent some).
+   *
+   * Must be called before the first sendBody().  Delegated bodies
+   * (addBufferMeta) never pass through the transaction and are not
+   * supported; the trailer only reaches the peer where the codec
+   * supports trailers.
+   */
+  void enableEgressBodyDigest(DigestAlgorithm algorithm);
+
+  /**
+   * Install a transform pipeline (compression, encryption framing,
+   * chunk signing, ...) applied to each sendBody() chunk before it is
+   * buffered for egress, replacing per-filter copies with at most one;
+   * see HTTPBodyTransformPipeline.  At sendEOM() the pipeline is
+   * flushed and any tail bytes (compression trailer, final signature)
+   * are appended to the body.
+   *
+   * Must be called before the first sendBody().  The transformed bytes
+   * are what the digest, byte-tracking and Content-Length checks see.
+   * Delegated bodies (addBufferMeta) never pass through the transaction
+   * and are not transformed, and with chunked framing the declared
+   * chunk lengths must already account for any expansion.
+   */
+  void setEgressBodyTransformPipeline(
+      std::unique_ptr<HTTPBodyTransformPipeline> pipeline);
+
   /**
    * Finalize the egress message; depending on the protocol used
    * by the Transport, this may involve sending an explicit "end
@@ -1132,6 +1420,21 @@ class HTTPTransaction
     return ingressPaused_;
   }
 
+  /**
+   * Splice this transaction's ingress body into the egress of 'sink'.
+   * Once linked, ingress body and EOM bypass the Handler's onBody/onEOM
+   * callbacks and go straight to sink->sendBody()/sendEOM(), and the flow
+   * control windows are linked: when the sink's egress buffer or send
+   * window fills, this transaction's ingress is paused, resuming when it
+   * drains.  All other callbacks (headers, trailers, errors) still reach
+   * the Handler, which stays responsible for lifetime and error handling
+   * of both transactions.  Both transactions must run on the same
+   * EventBase, and the sink's egress headers should be sent before
+   * linking.  Pass nullptr to unlink; the pipe also unlinks itself once
+   * ingress EOM has been forwarded or either transaction is destroyed.
+   */
+  void pipeTo(HTTPTransaction* sink);
+
   /**
    * Pause egress generation. HTTPTransaction may call its Handler's
    * onEgressPaused() method if there is a state change as a result of
@@ -1210,7 +1513,7 @@ class HTTPTransaction
     }
     auto txn = transport_.newPushedTransaction(id_, handler, error);
     if (txn) {
-      pushedTransactions_.insert(txn->getID());
+      coldState().pushedTransactions.insert(txn->getID());
     }
     return txn;
   }
@@ -1231,7 +1534,7 @@ class HTTPTransaction
     }
     auto txn = transport_.newExTransaction(handler, id_, unidirectional);
     if (txn) {
-      exTransactions_.insert(txn->getID());
+      coldState().exTransactions.insert(txn->getID());
     }
     return txn;
   }
@@ -1320,14 +1623,16 @@ class HTTPTransaction
    * Get a set of server-pushed transactions associated with this transaction.
    */
   const std::set<HTTPCodec::StreamID>& getPushedTransactions() const {
-    return pushedTransactions_;
+    static const std::set<HTTPCodec::StreamID> kEmptyTransactionSet;
+    return coldState_ ? coldState_->pushedTransactions : kEmptyTransactionSet;
   }
 
   /**
    * Get a set of exTransactions associated with this transaction.
    */
   std::set<HTTPCodec::StreamID> getExTransactions() const {
-    return exTransactions_;
+    return coldState_ ? coldState_->exTransactions
+                      : std::set<HTTPCodec::StreamID>();
   }
 
   /**
@@ -1335,22 +1640,37 @@ class HTTPTransaction
    * associated with this txn.
    */
   void removePushedTransaction(HTTPCodec::StreamID pushStreamId) {
-    pushedTransactions_.erase(pushStreamId);
+    if (coldState_) {
+      coldState_->pushedTransactions.erase(pushStreamId);
+    }
   }
 
   /**
    * Remove the exTxn ID from the control stream txn.
    */
   void removeExTransaction(HTTPCodec::StreamID exStreamId) {
-    exTransactions_.erase(exStreamId);
+    if (coldState_) {
+      coldState_->exTransactions.erase(exStreamId);
+    }
   }
 
   /**
-   * Schedule or refresh the idle timeout for this transaction
+   * Schedule or refresh the idle timeout for this transaction.
+   *
+   * Refreshing is lazy: while a timeout is already scheduled, activity
+   * only stamps lastActivity_ -- a single store -- instead of
+   * unlinking/relinking the wheel entry per ingress/egress event.
+   * timeoutExpired() consults the stamp and re-arms for the remaining
+   * interval if there was activity since the timer was scheduled.
    */
   void refreshTimeout() {
     if (timer_ && hasIdleTimeout()) {
-      timer_->scheduleTimeout(this, idleTimeout_.value());
+      if (isScheduled()) {
+        lastActivity_ = std::chrono::steady_clock::now();
+      } else {
+        lastActivity_.reset();
+        timer_->scheduleTimeout(this, idleTimeout_.value());
+      }
     }
   }
 
@@ -1410,6 +1730,17 @@ class HTTPTransaction
    * until the ingress message is complete or terminated by error.
    */
   void timeoutExpired() noexcept override {
+    if (lastActivity_ && hasIdleTimeout()) {
+      // Activity since the timer was armed: not actually idle.  Re-arm
+      // for the remainder of the interval measured from the last stamp.
+      auto idleFor = std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - *lastActivity_);
+      lastActivity_.reset();
+      if (idleFor < idleTimeout_.value() && timer_) {
+        timer_->scheduleTimeout(this, idleTimeout_.value() - idleFor);
+        return;
+      }
+    }
     transport_.transactionTimeout(this);
   }
 
@@ -1432,6 +1763,25 @@ class HTTPTransaction
    */
   void onPriorityUpdate(const http2::PriorityUpdate& priority);
 
+  /**
+   * Set a deadline by which this transaction's egress should be flushed,
+   * e.g., the playout time of a video segment.  Within a priority level
+   * the session's egress scheduler serves streams with earlier deadlines
+   * first; streams depending on this one inherit the deadline.  Purely a
+   * scheduling hint - nothing happens when the deadline passes.
+   */
+  void setEgressDeadline(TimePoint deadline) {
+    if (queueHandle_) {
+      egressQueue_.updateEgressDeadline(queueHandle_, deadline);
+    }
+  }
+
+  void clearEgressDeadline() {
+    if (queueHandle_) {
+      egressQueue_.clearEgressDeadline(queueHandle_);
+    }
+  }
+
   /**
    * Add a callback waiting for this transaction to have a transport with
    * replay protection.
@@ -1520,6 +1870,11 @@ class HTTPTransaction
   bool delegatedTransactionChecks(const HTTPMessage& headers) noexcept;
   bool delegatedTransactionChecks() noexcept;
 
+  /**
+   * Runs on the event base; sweeps crossThreadBody_ into sendBody()
+   */
+  void drainCrossThreadBody();
+
   void addBufferMeta() noexcept;
 
   void onDelayedDestroy(bool delayed) override;
@@ -1545,6 +1900,32 @@ class HTTPTransaction
    */
   void checkCreateDeferredIngress();
 
+  /**
+   * Whether the next deferred body chain should go to the spill file
+   * rather than the in-memory queue.
+   */
+  bool shouldSpillIngressBody() const;
+
+  /**
+   * Move the chain's bytes to the spill file, freeing their flow control
+   * window so the sender can keep streaming.  Returns false on an I/O
+   * error, in which case the caller falls back to in-memory queueing.
+   */
+  bool spillIngressBody(const folly::IOBuf& chain, size_t len);
+
+  /**
+   * Deliver body bytes read back from the spill file.  Unlike
+   * processIngressBody, the window and transport accounting for these
+   * bytes was settled when they were spilled.
+   */
+  void processSpilledBody(std::unique_ptr<folly::IOBuf> data, size_t len);
+
+  /**
+   * Return this transaction's deferred ingress body accounting to the
+   * worker's policy and drop any spill file.  Idempotent.
+   */
+  void releaseIngressBufferAccounting();
+
   /**
    * Implementation of sending an abort for this transaction.
    */
@@ -1616,10 +1997,50 @@ class HTTPTransaction
    */
   void flushWindowUpdate();
 
+  /**
+   * Run len freed receive-window bytes through the installed
+   * WindowUpdateStrategy (or release them directly without one) and
+   * flush a window update if the policy says enough are pending.
+   */
+  void releaseIngressWindow(uint32_t len);
+
+  /**
+   * Flush a window update if the strategy (or the historical
+   * half-capacity rule) deems recvToAck_ large enough.
+   */
+  void maybeFlushWindowUpdate();
+
   bool updateContentLengthRemaining(size_t len);
 
   void rateLimitTimeoutExpired();
 
+  /**
+   * Append an arriving body chain to the aggregation buffer, flushing if
+   * the policy's byte threshold is reached.
+   */
+  void aggregateIngressBody(std::unique_ptr<folly::IOBuf> chain, size_t len);
+
+  /**
+   * Deliver any aggregated ingress body to the handler now.
+   */
+  void flushAggregatedIngress();
+
+  class IngressAggregationCallback : public folly::HHWheelTimer::Callback {
+   public:
+    explicit IngressAggregationCallback(HTTPTransaction& txn) : txn_(txn) {
+    }
+
+    void timeoutExpired() noexcept override {
+      txn_.flushAggregatedIngress();
+    }
+    void callbackCanceled() noexcept override {
+      // no op
+    }
+
+   private:
+    HTTPTransaction& txn_;
+  };
+
   class RateLimitCallback : public folly::HHWheelTimer::Callback {
    public:
     explicit RateLimitCallback(HTTPTransaction& txn) : txn_(txn) {
@@ -1636,7 +2057,45 @@ class HTTPTransaction
     HTTPTransaction& txn_;
   };
 
-  RateLimitCallback rateLimitCallback_{*this};
+  /**
+   * Rarely-touched state (server push bookkeeping, ex-transaction sets,
+   * egress rate limiting), split out of the hot object so priority queue
+   * scans and the egress path don't drag these cache lines along for the
+   * common transaction that never uses them.  Allocated on first use,
+   * like deferredIngress_ and prioritySample_.
+   */
+  struct ColdState {
+    explicit ColdState(HTTPTransaction& txn) : rateLimitCallback(txn) {
+    }
+
+    /**
+     * Set of all push transaction IDs associated with this transaction.
+     */
+    std::set<HTTPCodec::StreamID> pushedTransactions;
+
+    /**
+     * Set of all exTransaction IDs associated with this transaction.
+     */
+    std::set<HTTPCodec::StreamID> exTransactions;
+
+    RateLimitCallback rateLimitCallback;
+    uint64_t egressLimitBytesPerMs{0};
+    proxygen::TimePoint startRateLimit;
+    uint64_t numLimitedBytesEgressed{0};
+  };
+
+  ColdState& coldState() {
+    if (!coldState_) {
+      coldState_ = std::make_unique<ColdState>(*this);
+    }
+    return *coldState_;
+  }
+
+  uint64_t egressLimitBytesPerMs() const {
+    return coldState_ ? coldState_->egressLimitBytesPerMs : 0;
+  }
+
+  std::unique_ptr<ColdState> coldState_;
 
   /**
    * Queue to hold any events that we receive from the Transaction
@@ -1644,12 +2103,60 @@ class HTTPTransaction
    */
   std::unique_ptr<std::queue<HTTPEvent>> deferredIngress_;
 
+  /**
+   * Worker-shared bound on deferred ingress memory, or nullptr for the
+   * historical unbounded behavior.
+   */
+  IngressBufferPolicy* ingressBufferPolicy_{nullptr};
+
+  /**
+   * Temp-file overflow for deferred ingress body, created lazily when
+   * the policy's caps are exceeded.  While it exists, every deferred
+   * body chain is appended to it so delivery order is preserved; the
+   * first spillPrefixEvents_ entries of deferredIngress_ predate the
+   * spill and are delivered ahead of it.
+   */
+  std::unique_ptr<IngressBodySpill> ingressSpill_;
+  uint64_t spillPrefixEvents_{0};
+
+  /**
+   * Aggregated ingress delivery state, allocated when the handler opts
+   * in via setIngressDeliveryPolicy().  The flush callback's destructor
+   * cancels any pending timeout.
+   */
+  struct IngressAggregation {
+    explicit IngressAggregation(HTTPTransaction& txn) : flushCallback(txn) {
+    }
+
+    folly::IOBufQueue body{folly::IOBufQueue::cacheChainLength()};
+    uint64_t firstBodyOffset{0};
+    uint64_t maxBytes{0};
+    std::chrono::milliseconds maxDelay{0};
+    IngressAggregationCallback flushCallback;
+  };
+  std::unique_ptr<IngressAggregation> ingressAggregation_;
+
+  // Deferred ingress body bytes currently held in memory
+  uint64_t deferredIngressBytes_{0};
+
+  // Chunk framing events are interleaved with body in deferredIngress_,
+  // so a chunked message cannot spill without reordering
+  bool deferredChunkEvents_{false};
+
   /**
    * Queue to hold any body bytes to be sent out
    * while egress to the remote is supposed to be paused.
    */
   folly::IOBufQueue deferredEgressBody_{folly::IOBufQueue::cacheChainLength()};
 
+  /**
+   * Body chunks published by other threads via sendBodyFromAnyThread(),
+   * drained into sendBody() on the event base.  The scheduled flag
+   * guarantees a single pending drain per batch.
+   */
+  folly::AtomicLinkedList<std::unique_ptr<folly::IOBuf>> crossThreadBody_;
+  std::atomic<bool> crossThreadBodyDrainScheduled_{false};
+
   /**
    * BufferMeta queued at this HTTPTransaction to be sent to Transport.
    */
@@ -1673,6 +2180,13 @@ class HTTPTransaction
 
   HTTPSessionStats* stats_{nullptr};
 
+  /**
+   * When the session batches stats (see
+   * HTTPSessionBase::enableBatchedSessionStats()), hot-path records go
+   * through plain increments on this block instead of stats_.
+   */
+  HTTPSessionStatCounters* statCounters_{nullptr};
+
   CompressionInfo tableInfo_;
 
   /**
@@ -1681,6 +2195,16 @@ class HTTPTransaction
    */
   Window recvWindow_;
 
+  /**
+   * Policy for releasing recvWindow_ back to the peer; nullptr is the
+   * historical eager release.
+   */
+  std::unique_ptr<WindowUpdateStrategy> windowUpdateStrategy_;
+
+  // Deferred work queue, see deferWork()
+  folly::small_vector<folly::Function<void()>, kDeferredWorkInline>
+      deferredWork_;
+
   /**
    * The send window and associated data. This keeps track of how many
    * bytes we are allowed to send and have outstanding.
@@ -1694,6 +2218,18 @@ class HTTPTransaction
    */
   std::unique_ptr<HTTPHeaders> trailers_;
 
+  /**
+   * Running digest over the egress body, finalized into a Digest trailer
+   * at sendEOM; see enableEgressBodyDigest().
+   */
+  std::unique_ptr<BodyDigestContext> egressDigest_;
+
+  /**
+   * Transform pipeline applied to each sendBody() chunk before it is
+   * buffered; see setEgressBodyTransformPipeline().
+   */
+  std::unique_ptr<HTTPBodyTransformPipeline> egressBodyTransforms_;
+
   struct Chunk {
     explicit Chunk(size_t inLength) : length(inLength), headerSent(false) {
     }
@@ -1722,16 +2258,6 @@ class HTTPTransaction
    */
   folly::Optional<HTTPCodec::ExAttributes> exAttributes_;
 
-  /**
-   * Set of all push transactions IDs associated with this transaction.
-   */
-  std::set<HTTPCodec::StreamID> pushedTransactions_;
-
-  /**
-   * Set of all exTransaction IDs associated with this transaction.
-   */
-  std::set<HTTPCodec::StreamID> exTransactions_;
-
   /**
    * Priority of this transaction
    */
@@ -1754,6 +2280,13 @@ class HTTPTransaction
   uint64_t egressCalls_{0};
 
   uint64_t pendingByteEvents_{0};
+
+  // Splice peers, see pipeTo().  pipeSink_ receives this transaction's
+  // ingress body/EOM; pipeSource_ points back from the sink so egress
+  // backpressure can pause the source's ingress.
+  HTTPTransaction* pipeSink_{nullptr};
+  HTTPTransaction* pipeSource_{nullptr};
+
   folly::Optional<uint64_t> expectedIngressContentLength_;
   folly::Optional<uint64_t> expectedIngressContentLengthRemaining_;
   folly::Optional<uint64_t> expectedResponseLength_;
@@ -1799,17 +2332,34 @@ class HTTPTransaction
   // Maximum size of egress buffer before invoking onEgressPaused
   static uint64_t egressBufferLimit_;
 
-  uint64_t egressLimitBytesPerMs_{0};
-  proxygen::TimePoint startRateLimit_;
-  uint64_t numLimitedBytesEgressed_{0};
-
   folly::Optional<std::chrono::milliseconds> idleTimeout_;
 
+  // Set by refreshTimeout() while a timeout is already scheduled; see
+  // the comment there for the lazy re-arm protocol
+  folly::Optional<std::chrono::steady_clock::time_point> lastActivity_;
+
   folly::HHWheelTimer* timer_;
 
+  // See getRequestContext()
+  std::shared_ptr<folly::RequestContext> requestContext_;
+
   class PrioritySample;
   std::unique_ptr<PrioritySample> prioritySample_;
 
+  // First occurrence wins: onWriteReady and friends fire many times per
+  // transaction but the record keeps the initial stamp.
+  void stampTiming(Timings::Event event) {
+    if (timings_.stamps[event] == TimePoint()) {
+      timings_.stamps[event] = getCurrentTime();
+    }
+  }
+
+  Timings timings_;
+
+  // Thread counters at construction time for sampled transactions; see
+  // getAllocationSnapshot()
+  std::unique_ptr<AllocationTracker::Snapshot> allocationBaseline_;
+
   // Keeps track for body offset processed so far.
   uint64_t ingressBodyOffset_{0};
 
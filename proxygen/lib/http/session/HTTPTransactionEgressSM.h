@@ -32,6 +32,7 @@ class HTTPTransactionEgressSMData {
 
   enum class Event : uint8_t {
     // API accessible transitions
+    sendEarlyHints,
     sendHeaders,
     sendBody,
     sendChunkHeader,
@@ -49,11 +50,65 @@ class HTTPTransactionEgressSMData {
     return State::Start;
   }
 
-  static std::pair<State, bool> find(State s, Event e);
+  static std::pair<State, bool> find(State s, Event e) {
+    return kTransitions.find(s, e);
+  }
 
   static const std::string getName() {
     return "HTTPTransactionEgress";
   }
+
+ private:
+  //             +--> ChunkHeaderSent -> ChunkBodySent
+  //             |      ^                    v
+  //             |      |   ChunkTerminatorSent -> TrailersSent
+  //             |      |__________|        |          |
+  //             |                          |          v
+  // Start -> HeadersSent                   +----> EOMQueued --> SendingDone
+  //             |                                     ^
+  //             +------------> RegularBodySent -------+
+  static constexpr DenseTransitionTable<State,
+                                        Event,
+                                        static_cast<std::size_t>(
+                                            State::NumStates),
+                                        static_cast<std::size_t>(
+                                            Event::NumEvents)>
+      kTransitions{
+          // Interim responses (103 Early Hints) precede the final
+          // headers and leave the final-response path undisturbed
+          {{{State::Start, Event::sendEarlyHints}, State::Start},
+
+           {{State::Start, Event::sendHeaders}, State::HeadersSent},
+
+           // For HTTP sending 100 response, then a regular response
+           {{State::HeadersSent, Event::sendHeaders}, State::HeadersSent},
+
+           {{State::HeadersSent, Event::sendBody}, State::RegularBodySent},
+           {{State::HeadersSent, Event::sendTrailers}, State::TrailersSent},
+           {{State::HeadersSent, Event::sendChunkHeader},
+            State::ChunkHeaderSent},
+           {{State::HeadersSent, Event::sendEOM}, State::EOMQueued},
+
+           {{State::RegularBodySent, Event::sendBody}, State::RegularBodySent},
+           {{State::RegularBodySent, Event::sendTrailers},
+            State::TrailersSent},
+           {{State::RegularBodySent, Event::sendEOM}, State::EOMQueued},
+
+           {{State::ChunkHeaderSent, Event::sendBody}, State::ChunkBodySent},
+
+           {{State::ChunkBodySent, Event::sendBody}, State::ChunkBodySent},
+           {{State::ChunkBodySent, Event::sendChunkTerminator},
+            State::ChunkTerminatorSent},
+
+           {{State::ChunkTerminatorSent, Event::sendChunkHeader},
+            State::ChunkHeaderSent},
+           {{State::ChunkTerminatorSent, Event::sendTrailers},
+            State::TrailersSent},
+           {{State::ChunkTerminatorSent, Event::sendEOM}, State::EOMQueued},
+
+           {{State::TrailersSent, Event::sendEOM}, State::EOMQueued},
+
+           {{State::EOMQueued, Event::eomFlushed}, State::SendingDone}}};
 };
 
 std::ostream& operator<<(std::ostream& os,
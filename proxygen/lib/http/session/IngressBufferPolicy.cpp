@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/http/session/IngressBufferPolicy.h>
+
+#include <folly/FileUtil.h>
+#include <glog/logging.h>
+
+namespace proxygen {
+
+IngressBodySpill::IngressBodySpill() {
+  try {
+    file_ = folly::File::temporary();
+  } catch (const std::exception& ex) {
+    LOG(ERROR) << "Failed to create ingress spill file: " << ex.what();
+  }
+}
+
+bool IngressBodySpill::append(const folly::IOBuf& chain) {
+  if (!valid()) {
+    return false;
+  }
+  uint64_t offset = writeOffset_;
+  const folly::IOBuf* buf = &chain;
+  do {
+    if (buf->length() > 0) {
+      auto written = folly::pwriteFull(
+          file_.fd(), buf->data(), buf->length(), offset);
+      if (written < 0 || uint64_t(written) != buf->length()) {
+        PLOG(ERROR) << "Short write to ingress spill file";
+        return false;
+      }
+      offset += buf->length();
+    }
+    buf = buf->next();
+  } while (buf != &chain);
+  writeOffset_ = offset;
+  return true;
+}
+
+std::unique_ptr<folly::IOBuf> IngressBodySpill::read(uint64_t maxLen) {
+  if (!valid() || empty()) {
+    return nullptr;
+  }
+  auto len = std::min(maxLen, bytesBuffered());
+  auto buf = folly::IOBuf::create(len);
+  auto bytesRead =
+      folly::preadFull(file_.fd(), buf->writableData(), len, readOffset_);
+  if (bytesRead < 0 || uint64_t(bytesRead) != len) {
+    PLOG(ERROR) << "Short read from ingress spill file";
+    return nullptr;
+  }
+  buf->append(len);
+  readOffset_ += len;
+  return buf;
+}
+
+} // namespace proxygen
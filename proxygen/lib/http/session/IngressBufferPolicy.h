@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <folly/File.h>
+#include <folly/io/IOBuf.h>
+
+namespace proxygen {
+
+/**
+ * Bounds on how much deferred ingress body a transaction may hold in
+ * memory while its handler has ingress paused.  One instance is meant
+ * to be shared by every transaction on a worker thread, giving an
+ * aggregate cap in addition to the per-transaction one; it is not
+ * thread-safe and must not be shared across threads.
+ *
+ * The caps do not drop data.  While a transaction's deferred bytes stay
+ * unacked the stream's flow control window bounds the sender, and a
+ * transaction that exceeds a cap with spilling enabled moves further
+ * body bytes to a temp-file-backed buffer instead of the heap, reopening
+ * the window so upload bursts can be absorbed without growing memory.
+ */
+class IngressBufferPolicy {
+ public:
+  IngressBufferPolicy(uint64_t perTransactionLimitBytes,
+                      uint64_t perWorkerLimitBytes,
+                      bool enableSpill = false)
+      : perTransactionLimit_(perTransactionLimitBytes),
+        perWorkerLimit_(perWorkerLimitBytes),
+        spillEnabled_(enableSpill) {
+  }
+
+  uint64_t getPerTransactionLimit() const {
+    return perTransactionLimit_;
+  }
+
+  bool spillEnabled() const {
+    return spillEnabled_;
+  }
+
+  void recordBuffered(uint64_t bytes) {
+    workerBuffered_ += bytes;
+  }
+
+  void recordDrained(uint64_t bytes) {
+    DCHECK_GE(workerBuffered_, bytes);
+    workerBuffered_ -= bytes;
+  }
+
+  uint64_t getWorkerBufferedBytes() const {
+    return workerBuffered_;
+  }
+
+  bool overWorkerLimit() const {
+    return workerBuffered_ > perWorkerLimit_;
+  }
+
+ private:
+  const uint64_t perTransactionLimit_;
+  const uint64_t perWorkerLimit_;
+  const bool spillEnabled_;
+
+  // Deferred ingress body bytes held in memory across all transactions
+  // on this worker
+  uint64_t workerBuffered_{0};
+};
+
+/**
+ * A FIFO of ingress body bytes backed by an unlinked temp file, used by
+ * HTTPTransaction when IngressBufferPolicy caps are exceeded.  Bytes go
+ * in as IOBuf chains and come back out as freshly allocated IOBufs in
+ * the same order.  I/O errors are reported by return value; the caller
+ * decides whether to fall back to memory or abort.
+ */
+class IngressBodySpill {
+ public:
+  IngressBodySpill();
+
+  bool valid() const {
+    return file_.fd() >= 0;
+  }
+
+  /**
+   * Append the chain's bytes to the spill.  Returns false and leaves the
+   * spill unchanged on an I/O error.
+   */
+  bool append(const folly::IOBuf& chain);
+
+  /**
+   * Read and consume up to maxLen buffered bytes, or nullptr on error or
+   * when empty.
+   */
+  std::unique_ptr<folly::IOBuf> read(uint64_t maxLen);
+
+  uint64_t bytesBuffered() const {
+    return writeOffset_ - readOffset_;
+  }
+
+  bool empty() const {
+    return readOffset_ == writeOffset_;
+  }
+
+ private:
+  folly::File file_;
+  uint64_t writeOffset_{0};
+  uint64_t readOffset_{0};
+};
+
+} // namespace proxygen
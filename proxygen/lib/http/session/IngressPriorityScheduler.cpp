@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/http/session/IngressPriorityScheduler.h>
+
+#include <algorithm>
+#include <proxygen/lib/http/session/HTTPSession.h>
+
+namespace proxygen {
+
+IngressPriorityScheduler::IngressPriorityScheduler(folly::EventBase* evb,
+                                                   uint64_t bulkBytesPerTick)
+    : evb_(evb), bulkBytesPerTick_(bulkBytesPerTick) {
+  CHECK(evb_);
+  CHECK_GT(bulkBytesPerTick_, 0u);
+}
+
+IngressPriorityScheduler::~IngressPriorityScheduler() {
+  CHECK(ready_.empty()) << "destroying scheduler with queued sessions";
+}
+
+void IngressPriorityScheduler::sessionReadReady(HTTPSession& session) {
+  evb_->dcheckIsInEventBaseThread();
+  if (std::find(ready_.begin(), ready_.end(), &session) != ready_.end()) {
+    return;
+  }
+  ready_.push_back(&session);
+  if (!isLoopCallbackScheduled() && !draining_) {
+    // thisIteration: a quiet loop should not add a full tick of latency.
+    // The callback still runs after this iteration's IO events, so the
+    // critical sessions' inline parses all come first.
+    evb_->runInLoop(this, /*thisIteration=*/true);
+  }
+}
+
+bool IngressPriorityScheduler::removeSession(HTTPSession& session) {
+  auto it = std::find(ready_.begin(), ready_.end(), &session);
+  if (it == ready_.end()) {
+    return false;
+  }
+  ready_.erase(it);
+  return true;
+}
+
+bool IngressPriorityScheduler::chargeBulk(size_t bytes) {
+  tickBudget_ -= int64_t(bytes);
+  return tickBudget_ > 0;
+}
+
+void IngressPriorityScheduler::runLoopCallback() noexcept {
+  tickBudget_ = int64_t(bulkBytesPerTick_);
+  draining_ = true;
+  while (!ready_.empty() && tickBudget_ > 0) {
+    auto* session = ready_.front();
+    ready_.pop_front();
+    // parsing can tear the session down; sessions removed mid-pass take
+    // themselves out of ready_ via removeSession()
+    HTTPSession::DestructorGuard dg(session);
+    session->processReadData();
+  }
+  draining_ = false;
+  if (!ready_.empty() && !isLoopCallbackScheduled()) {
+    // budget spent with sessions still waiting; fresh budget next tick
+    evb_->runInLoop(this, /*thisIteration=*/false);
+  }
+}
+
+} // namespace proxygen
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <folly/io/async/EventBase.h>
+
+namespace proxygen {
+
+class HTTPSession;
+
+/**
+ * Two-tier ingress read scheduling for the sessions sharing one worker
+ * event base.
+ *
+ * Latency-critical sessions (the default, nothing to register) keep
+ * parsing their reads inline as they arrive.  Sessions registered here
+ * as bulk -- uploads, replication, anything where per-read latency is
+ * irrelevant -- defer parsing to a single end-of-iteration pass instead.
+ * Event-base loop callbacks run after the iteration's IO events, so
+ * every critical read that arrived in the tick is drained before the
+ * first bulk byte is parsed, and the bulk pass stops once the per-tick
+ * byte budget is spent; leftovers carry into the next iteration.  This
+ * keeps an upload burst from adding queueing delay to API sessions on
+ * the same loop.
+ *
+ * One instance per worker.  All methods must run on its event base, and
+ * the scheduler must outlive the sessions registered with it.
+ */
+class IngressPriorityScheduler : private folly::EventBase::LoopCallback {
+ public:
+  IngressPriorityScheduler(folly::EventBase* evb, uint64_t bulkBytesPerTick);
+  ~IngressPriorityScheduler() override;
+
+  /**
+   * A bulk session has unparsed ingress buffered; queues it for the
+   * end-of-iteration pass.  No-op when already queued.
+   */
+  void sessionReadReady(HTTPSession& session);
+
+  /**
+   * Drop the session from the queue (teardown, or its buffer was
+   * drained through another path).  Returns true if it was queued.
+   */
+  bool removeSession(HTTPSession& session);
+
+  /**
+   * Charge parsed bulk bytes against this tick's budget.  Returns false
+   * once the budget is spent; the session should then stop parsing and
+   * re-register via sessionReadReady() to continue next iteration.
+   */
+  bool chargeBulk(size_t bytes);
+
+  uint64_t getBulkBytesPerTick() const {
+    return bulkBytesPerTick_;
+  }
+
+ private:
+  void runLoopCallback() noexcept override;
+
+  folly::EventBase* evb_{nullptr};
+  uint64_t bulkBytesPerTick_;
+  int64_t tickBudget_{0};
+  // true while the drain pass runs: re-registrations must go to the
+  // NEXT iteration or the pass would never terminate
+  bool draining_{false};
+  std::deque<HTTPSession*> ready_;
+};
+
+} // namespace proxygen
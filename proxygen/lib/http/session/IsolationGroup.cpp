@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/http/session/IsolationGroup.h>
+
+#include <algorithm>
+
+#include <glog/logging.h>
+
+namespace proxygen {
+
+IsolationGroup::IsolationGroup(IsolationGroupSet& set,
+                               std::string name,
+                               const IsolationGroupConfig& config)
+    : set_(set), name_(std::move(name)), config_(config) {
+  lastReplenish_ = set_.now();
+  // Start with one round banked so a fresh group can serve its first
+  // burst without waiting out a round
+  ingressDeficit_ = set_.ingressQuantum(*this);
+  egressDeficit_ = set_.egressQuantum(*this);
+}
+
+void IsolationGroup::removeSession() {
+  DCHECK_GT(activeSessions_, 0);
+  if (activeSessions_ > 0) {
+    activeSessions_--;
+  }
+}
+
+void IsolationGroup::endTransaction() {
+  DCHECK_GT(activeTransactions_, 0);
+  if (activeTransactions_ > 0) {
+    activeTransactions_--;
+  }
+}
+
+void IsolationGroup::replenish(TimePoint now) {
+  const auto elapsed = millisecondsBetween(now, lastReplenish_);
+  const int64_t rounds = elapsed.count() / set_.roundInterval_.count();
+  if (rounds <= 0) {
+    return;
+  }
+  // Advance by whole rounds only; the remainder stays on the clock
+  lastReplenish_ += rounds * set_.roundInterval_;
+  const int64_t ingressCap =
+      set_.ingressQuantum(*this) * IsolationGroupSet::kMaxRoundsBanked;
+  const int64_t egressCap =
+      set_.egressQuantum(*this) * IsolationGroupSet::kMaxRoundsBanked;
+  ingressDeficit_ = std::min(
+      ingressDeficit_ + rounds * set_.ingressQuantum(*this), ingressCap);
+  egressDeficit_ =
+      std::min(egressDeficit_ + rounds * set_.egressQuantum(*this), egressCap);
+}
+
+void IsolationGroup::replenishAndWake(TimePoint now) {
+  replenish(now);
+  while (!ingressWaiters_.empty() && ingressDeficit_ > 0) {
+    auto* participant = ingressWaiters_.front();
+    ingressWaiters_.pop_front();
+    participant->groupIngressUnblocked();
+  }
+  while (!egressWaiters_.empty() && egressDeficit_ > 0) {
+    auto* participant = egressWaiters_.front();
+    egressWaiters_.pop_front();
+    participant->groupEgressUnblocked();
+  }
+}
+
+bool IsolationGroup::chargeIngress(uint64_t bytes) {
+  ingressBytesParsed_ += bytes;
+  if (set_.ingressBytesPerRound_ == 0) {
+    return true;
+  }
+  replenish(set_.now());
+  ingressDeficit_ -= static_cast<int64_t>(bytes);
+  if (ingressDeficit_ <= 0) {
+    ingressStalls_++;
+    return false;
+  }
+  return true;
+}
+
+uint64_t IsolationGroup::egressAllowance(uint64_t wanted) {
+  if (set_.egressBytesPerRound_ == 0) {
+    return wanted;
+  }
+  replenish(set_.now());
+  if (egressDeficit_ <= 0) {
+    egressStalls_++;
+    return 0;
+  }
+  return std::min<uint64_t>(wanted, static_cast<uint64_t>(egressDeficit_));
+}
+
+void IsolationGroup::consumeEgress(uint64_t bytes) {
+  egressBytesSent_ += bytes;
+  if (set_.egressBytesPerRound_ == 0) {
+    return;
+  }
+  egressDeficit_ -= static_cast<int64_t>(bytes);
+}
+
+void IsolationGroup::waitForIngress(Participant* participant) {
+  ingressWaiters_.push_back(participant);
+  set_.onWaiterAdded();
+}
+
+void IsolationGroup::waitForEgress(Participant* participant) {
+  egressWaiters_.push_back(participant);
+  set_.onWaiterAdded();
+}
+
+void IsolationGroup::cancelWaits(Participant* participant) {
+  ingressWaiters_.remove(participant);
+  egressWaiters_.remove(participant);
+}
+
+IsolationGroupUtilization IsolationGroup::getUtilization() const {
+  IsolationGroupUtilization util;
+  util.name = name_;
+  util.weight = config_.weight;
+  util.activeSessions = activeSessions_;
+  util.activeTransactions = activeTransactions_;
+  util.ingressBytesParsed = ingressBytesParsed_;
+  util.egressBytesSent = egressBytesSent_;
+  util.ingressStalls = ingressStalls_;
+  util.egressStalls = egressStalls_;
+  util.transactionsRefused = transactionsRefused_;
+  return util;
+}
+
+IsolationGroupSet::IsolationGroupSet(folly::TimeoutManager* timeoutManager,
+                                     uint64_t ingressBytesPerRound,
+                                     uint64_t egressBytesPerRound,
+                                     std::chrono::milliseconds roundInterval,
+                                     Clock* clock)
+    : folly::AsyncTimeout(timeoutManager),
+      clock_(clock),
+      ingressBytesPerRound_(ingressBytesPerRound),
+      egressBytesPerRound_(egressBytesPerRound),
+      roundInterval_(roundInterval) {
+  DCHECK_GT(roundInterval_.count(), 0);
+}
+
+IsolationGroupSet::~IsolationGroupSet() {
+  for (const auto& group : groups_) {
+    CHECK(group->ingressWaiters_.empty() && group->egressWaiters_.empty())
+        << "IsolationGroupSet destroyed with parked sessions in group '"
+        << group->name_ << "'";
+  }
+}
+
+IsolationGroup* IsolationGroupSet::addGroup(const std::string& name,
+                                            const IsolationGroupConfig& config) {
+  DCHECK_GT(config.weight, 0);
+  auto it = groupsByName_.find(name);
+  if (it != groupsByName_.end()) {
+    totalWeight_ += config.weight;
+    totalWeight_ -= it->second->config_.weight;
+    it->second->config_ = config;
+    return it->second;
+  }
+  totalWeight_ += config.weight;
+  groups_.push_back(std::unique_ptr<IsolationGroup>(
+      new IsolationGroup(*this, name, config)));
+  auto* group = groups_.back().get();
+  groupsByName_.emplace(name, group);
+  return group;
+}
+
+IsolationGroup* IsolationGroupSet::getGroup(const std::string& name) const {
+  auto it = groupsByName_.find(name);
+  return (it != groupsByName_.end()) ? it->second : nullptr;
+}
+
+std::vector<IsolationGroupUtilization> IsolationGroupSet::getUtilization()
+    const {
+  std::vector<IsolationGroupUtilization> result;
+  result.reserve(groups_.size());
+  for (const auto& group : groups_) {
+    result.push_back(group->getUtilization());
+  }
+  return result;
+}
+
+int64_t IsolationGroupSet::ingressQuantum(const IsolationGroup& group) const {
+  DCHECK_GT(totalWeight_, 0);
+  return static_cast<int64_t>(ingressBytesPerRound_ * group.config_.weight /
+                              totalWeight_);
+}
+
+int64_t IsolationGroupSet::egressQuantum(const IsolationGroup& group) const {
+  DCHECK_GT(totalWeight_, 0);
+  return static_cast<int64_t>(egressBytesPerRound_ * group.config_.weight /
+                              totalWeight_);
+}
+
+void IsolationGroupSet::onWaiterAdded() {
+  if (!isScheduled()) {
+    scheduleTimeout(roundInterval_);
+  }
+}
+
+void IsolationGroupSet::timeoutExpired() noexcept {
+  const auto current = now();
+  const size_t numGroups = groups_.size();
+  for (size_t i = 0; i < numGroups; i++) {
+    groups_[(rrCursor_ + i) % numGroups]->replenishAndWake(current);
+  }
+  if (numGroups > 0) {
+    rrCursor_ = (rrCursor_ + 1) % numGroups;
+  }
+  // Woken sessions may have stalled again immediately, or deficits may
+  // still be negative from earlier overdraft; keep ticking while anyone
+  // is parked
+  for (const auto& group : groups_) {
+    if (!group->ingressWaiters_.empty() || !group->egressWaiters_.empty()) {
+      scheduleTimeout(roundInterval_);
+      return;
+    }
+  }
+}
+
+TimePoint IsolationGroupSet::now() {
+  return clock_ ? clock_->now() : getCurrentTime();
+}
+
+} // namespace proxygen
@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <folly/io/async/AsyncTimeout.h>
+#include <folly/io/async/TimeoutManager.h>
+#include <proxygen/lib/utils/Time.h>
+
+namespace proxygen {
+
+class IsolationGroupSet;
+
+struct IsolationGroupConfig {
+  // Relative share of the worker's parse and egress budgets
+  uint32_t weight{1};
+  // Concurrent incoming transactions allowed across all of the group's
+  // sessions on this worker; 0 = unlimited
+  uint32_t maxConcurrentTransactions{0};
+};
+
+/**
+ * Point-in-time utilization of one group, see
+ * IsolationGroupSet::getUtilization().
+ */
+struct IsolationGroupUtilization {
+  std::string name;
+  uint32_t weight{0};
+  uint32_t activeSessions{0};
+  uint32_t activeTransactions{0};
+  uint64_t ingressBytesParsed{0};
+  uint64_t egressBytesSent{0};
+  uint64_t ingressStalls{0};
+  uint64_t egressStalls{0};
+  uint64_t transactionsRefused{0};
+};
+
+/**
+ * One tenant's share of a worker.  Sessions are tagged with a group at
+ * accept time (HTTPSession::setIsolationGroup()) and then charge their
+ * parse and egress bytes against the group's deficit counters; when a
+ * counter runs dry the session parks itself on the group and the group
+ * wakes it as the deficit replenishes.  All methods run on the owning
+ * worker's thread.
+ */
+class IsolationGroup {
+ public:
+  /**
+   * Implemented by HTTPSession; notified (once per wait) when the
+   * corresponding deficit is worth retrying.  By the time a callback
+   * fires the deficit is positive, but it is shared with the group's
+   * other sessions, so the callback re-attempts its charge itself.
+   */
+  class Participant {
+   public:
+    virtual ~Participant() = default;
+    virtual void groupIngressUnblocked() noexcept = 0;
+    virtual void groupEgressUnblocked() noexcept = 0;
+  };
+
+  const std::string& getName() const {
+    return name_;
+  }
+
+  // Session membership, for utilization reporting
+  void addSession() {
+    activeSessions_++;
+  }
+  void removeSession();
+
+  /**
+   * Charge parsed ingress against the group's deficit.  Returns false
+   * once the deficit is exhausted; the caller should stop feeding its
+   * codec and wait for the group.  The charge is applied either way --
+   * it is taken after the codec has run, so the last buffer of a round
+   * overdraws the deficit and the debt is repaid out of later rounds,
+   * the same between-buffers granularity the per-session parse budget
+   * uses.
+   */
+  bool chargeIngress(uint64_t bytes);
+
+  /**
+   * How much of wanted the group's egress deficit can cover right now,
+   * possibly 0.  Callers consume what they actually wrote via
+   * consumeEgress(), which may overdraw if the write grew after the
+   * allowance was taken.
+   */
+  uint64_t egressAllowance(uint64_t wanted);
+  void consumeEgress(uint64_t bytes);
+
+  // Transaction-count quota
+  bool atTransactionQuota() const {
+    return config_.maxConcurrentTransactions > 0 &&
+           activeTransactions_ >= config_.maxConcurrentTransactions;
+  }
+  void beginTransaction() {
+    activeTransactions_++;
+  }
+  void endTransaction();
+  void recordTransactionRefused() {
+    transactionsRefused_++;
+  }
+
+  /**
+   * Park a session until the deficit replenishes.  Waiters are woken in
+   * FIFO order, with the group rotation described on IsolationGroupSet
+   * deciding which group's waiters go first.  Adding the same
+   * participant twice is the caller's bug; sessions guard with their
+   * blocked flags.
+   */
+  void waitForIngress(Participant* participant);
+  void waitForEgress(Participant* participant);
+
+  /**
+   * Remove a participant from both wait lists, e.g. at session teardown.
+   */
+  void cancelWaits(Participant* participant);
+
+  IsolationGroupUtilization getUtilization() const;
+
+ private:
+  friend class IsolationGroupSet;
+
+  IsolationGroup(IsolationGroupSet& set,
+                 std::string name,
+                 const IsolationGroupConfig& config);
+
+  // Lazily apply the rounds that elapsed since the last charge, so
+  // steady-state traffic never waits on the shared tick
+  void replenish(TimePoint now);
+  // One explicit DRR round from the shared tick, then FIFO wakeups
+  void replenishAndWake(TimePoint now);
+
+  IsolationGroupSet& set_;
+  const std::string name_;
+  IsolationGroupConfig config_;
+
+  // Deficits are signed: the last buffer or write of a round may
+  // overdraw, and the debt carries into the next round
+  int64_t ingressDeficit_{0};
+  int64_t egressDeficit_{0};
+  TimePoint lastReplenish_;
+
+  std::list<Participant*> ingressWaiters_;
+  std::list<Participant*> egressWaiters_;
+
+  uint32_t activeSessions_{0};
+  uint32_t activeTransactions_{0};
+  uint64_t ingressBytesParsed_{0};
+  uint64_t egressBytesSent_{0};
+  uint64_t ingressStalls_{0};
+  uint64_t egressStalls_{0};
+  uint64_t transactionsRefused_{0};
+};
+
+/**
+ * Per-worker set of isolation groups with deficit round-robin
+ * scheduling.  Each round, every group earns a quantum of parse bytes
+ * and egress bytes proportional to its weight; unconsumed quanta bank
+ * up to kMaxRoundsBanked rounds so an idle tenant keeps some burst.
+ * Deficits replenish lazily from timestamps on the charge path, so a
+ * group that never stalls costs no timers; one shared tick (the same
+ * arrangement TokenBucketRateLimiter uses) serves all parked sessions,
+ * visiting groups in rotating order so no group's waiters always drain
+ * first.
+ *
+ * A budget of 0 disables that dimension: groups then only meter for
+ * utilization reporting and transaction quotas.
+ *
+ * Single-threaded: one set per worker, used only on its
+ * TimeoutManager's thread.  Groups live as long as the set; sessions
+ * must cancel their waits before detaching.
+ */
+class IsolationGroupSet : private folly::AsyncTimeout {
+ public:
+  /**
+   * Clock interface, injectable for tests (same shape as
+   * TokenBucketRateLimiter::Clock).
+   */
+  class Clock {
+   public:
+    virtual ~Clock() {
+    }
+    virtual TimePoint now() = 0;
+  };
+
+  // Unused quanta bank for this many rounds before capping
+  static constexpr int64_t kMaxRoundsBanked = 2;
+
+  /**
+   * @param timeoutManager       Event base driving the shared wakeup tick.
+   * @param ingressBytesPerRound Parse bytes shared by all groups each
+   *                             round, split by weight; 0 = unlimited.
+   * @param egressBytesPerRound  Egress bytes per round, ditto.
+   * @param roundInterval        Length of one DRR round.
+   * @param clock                Optional clock override for tests.
+   */
+  IsolationGroupSet(
+      folly::TimeoutManager* timeoutManager,
+      uint64_t ingressBytesPerRound,
+      uint64_t egressBytesPerRound,
+      std::chrono::milliseconds roundInterval = std::chrono::milliseconds(10),
+      Clock* clock = nullptr);
+
+  ~IsolationGroupSet() override;
+
+  /**
+   * Create or look up a group.  An existing group keeps its counters
+   * but adopts the new config; quanta shift automatically as the total
+   * weight changes.
+   */
+  IsolationGroup* addGroup(const std::string& name,
+                           const IsolationGroupConfig& config);
+
+  IsolationGroup* getGroup(const std::string& name) const;
+
+  std::vector<IsolationGroupUtilization> getUtilization() const;
+
+  size_t getNumGroups() const {
+    return groups_.size();
+  }
+
+ private:
+  friend class IsolationGroup;
+
+  // Weight-proportional per-round quanta for one group
+  int64_t ingressQuantum(const IsolationGroup& group) const;
+  int64_t egressQuantum(const IsolationGroup& group) const;
+
+  void onWaiterAdded();
+  void timeoutExpired() noexcept override;
+  TimePoint now();
+
+  Clock* const clock_;
+  const uint64_t ingressBytesPerRound_;
+  const uint64_t egressBytesPerRound_;
+  const std::chrono::milliseconds roundInterval_;
+
+  std::vector<std::unique_ptr<IsolationGroup>> groups_;
+  std::unordered_map<std::string, IsolationGroup*> groupsByName_;
+  uint64_t totalWeight_{0};
+  // Start of the next wakeup pass, rotated so every group gets to be
+  // first in line
+  size_t rrCursor_{0};
+};
+
+} // namespace proxygen
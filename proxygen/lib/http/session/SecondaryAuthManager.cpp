@@ -8,11 +8,30 @@
 
 #include <proxygen/lib/http/session/SecondaryAuthManager.h>
 
+#include <array>
 #include <fizz/extensions/exportedauth/ExportedAuthenticator.h>
+#include <folly/String.h>
+#include <folly/Synchronized.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBufQueue.h>
+#include <folly/ssl/OpenSSLHash.h>
 using folly::io::QueueAppender;
 
+namespace {
+
+// Process-wide memo of leaf certificate digests, keyed by the raw
+// certificate bytes.  Client certificates repeat across sessions, so the
+// map is read-mostly: a write happens only the first time the process sees
+// a given certificate.
+folly::Synchronized<folly::F14FastMap<std::string, std::string>>&
+certDigestCache() {
+  static folly::Synchronized<folly::F14FastMap<std::string, std::string>>
+      cache;
+  return cache;
+}
+
+} // namespace
+
 namespace proxygen {
 
 SecondaryAuthManager::SecondaryAuthManager(
@@ -109,34 +128,64 @@ SecondaryAuthManager::verifyContext(
           std::move(authenticator));
   folly::io::Cursor cursor(certRequestContext.get());
   uint16_t requestId = cursor.readBE<uint16_t>();
-  if (outstandingRequests_.find(requestId) == outstandingRequests_.end()) {
+  auto it = outstandingRequests_.find(requestId);
+  if (it == outstandingRequests_.end()) {
     VLOG(4) << "No previous CERTIFICATE_REQUEST matches the the CERTIFICATE "
                "with Request-ID="
             << requestId;
     return folly::none;
   }
-  auto authRequest = std::move(outstandingRequests_[requestId]);
+  auto authRequest = std::move(it->second);
   return authRequest;
 }
 
 folly::Optional<uint16_t> SecondaryAuthManager::getCertId(uint16_t requestId) {
-  if (requestCertMap_.find(requestId) == requestCertMap_.end()) {
+  auto it = requestCertMap_.find(requestId);
+  if (it == requestCertMap_.end()) {
     return folly::none;
   } else {
-    folly::Optional<uint16_t> certId = requestCertMap_[requestId];
+    folly::Optional<uint16_t> certId = it->second;
     return certId;
   }
 }
 
 folly::Optional<std::vector<fizz::CertificateEntry>>
 SecondaryAuthManager::getPeerCert(uint16_t certId) {
-  folly::Optional<std::vector<fizz::CertificateEntry>> certChain;
-  if (receivedCerts_.find(certId) == receivedCerts_.end()) {
+  auto it = receivedCerts_.find(certId);
+  if (it == receivedCerts_.end()) {
     return folly::none;
   } else {
-    certChain = std::move(receivedCerts_[certId]);
+    folly::Optional<std::vector<fizz::CertificateEntry>> certChain =
+        std::move(it->second);
     return certChain;
   }
 }
 
+folly::Optional<std::string> SecondaryAuthManager::getPeerCertDigest(
+    uint16_t certId) {
+  auto it = receivedCerts_.find(certId);
+  if (it == receivedCerts_.end() || it->second.empty() ||
+      !it->second.front().cert_data) {
+    return folly::none;
+  }
+  auto certData = it->second.front().cert_data->coalesce();
+  std::string key(reinterpret_cast<const char*>(certData.data()),
+                  certData.size());
+  {
+    auto cache = certDigestCache().rlock();
+    auto cached = cache->find(key);
+    if (cached != cache->end()) {
+      return cached->second;
+    }
+  }
+  std::array<uint8_t, 32> digest;
+  folly::ssl::OpenSSLHash::sha256(
+      folly::MutableByteRange(digest.data(), digest.size()),
+      *it->second.front().cert_data);
+  auto hexDigest =
+      folly::hexlify(folly::ByteRange(digest.data(), digest.size()));
+  certDigestCache().wlock()->emplace(std::move(key), hexDigest);
+  return hexDigest;
+}
+
 } // namespace proxygen
@@ -9,6 +9,7 @@
 #pragma once
 
 #include <fizz/protocol/Certificate.h>
+#include <folly/container/F14Map.h>
 #include <proxygen/lib/http/session/SecondaryAuthManagerBase.h>
 
 namespace proxygen {
@@ -48,6 +49,16 @@ class SecondaryAuthManager : public SecondaryAuthManagerBase {
   folly::Optional<std::vector<fizz::CertificateEntry>> getPeerCert(
       uint16_t certId);
 
+  /**
+   * Hex-encoded SHA-256 digest of the leaf certificate the peer presented
+   * for certId.  Digests are memoized in a process-wide read-mostly cache
+   * keyed by the raw certificate bytes, so repeated exchanges with the
+   * same client certificate (the common case for client-cert-heavy
+   * tenants) never recompute the hash.  Must be called before getPeerCert,
+   * which moves the chain out of the manager.
+   */
+  folly::Optional<std::string> getPeerCertDigest(uint16_t certId);
+
  private:
   uint16_t requestIdCounter_{0};
   uint16_t certIdCounter_{0};
@@ -63,18 +74,20 @@ class SecondaryAuthManager : public SecondaryAuthManagerBase {
 
   // Locally cached authenticator requests, used for authenticator validation
   // and the CERTIFICATE_NEEDED frame.
-  std::map<uint16_t, std::unique_ptr<folly::IOBuf>> outstandingRequests_;
+  folly::F14FastMap<uint16_t, std::unique_ptr<folly::IOBuf>>
+      outstandingRequests_;
 
   // Secondary certificate possessed by the local endpoint.
   std::unique_ptr<fizz::SelfCert> cert_;
 
   // Caching the Request-ID:Cert-ID mapping which guides the use of
   // USE_CERTIFICATE frame.
-  std::map<uint16_t, uint16_t> requestCertMap_;
+  folly::F14FastMap<uint16_t, uint16_t> requestCertMap_;
 
   // Locally cached certificates which authenticates the secondary identity of
   // the peer.
-  std::map<uint16_t, std::vector<fizz::CertificateEntry>> receivedCerts_;
+  folly::F14FastMap<uint16_t, std::vector<fizz::CertificateEntry>>
+      receivedCerts_;
 };
 
 } // namespace proxygen
@@ -21,6 +21,12 @@ SimpleController::SimpleController(HTTPSessionAcceptor* acceptor)
 HTTPTransactionHandler* SimpleController::getRequestHandler(
     HTTPTransaction& txn, HTTPMessage* msg) {
   CHECK(acceptor_) << "Requires an acceptor, or override this method";
+  if (acceptor_->shouldShedRequest()) {
+    // Overloaded worker: a canned 503 is far cheaper than the application
+    // handler and tells the client to retry elsewhere
+    return createErrorHandler(
+        503, "Service Unavailable", acceptor_->getDefaultErrorPage());
+  }
   return acceptor_->newHandler(txn, msg);
 }
 
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/init/Init.h>
+#include <folly/portability/GFlags.h>
+
+#include "proxygen/lib/http/session/experimental/replay/SessionReplaySimulator.h"
+
+DEFINE_string(input, "", "File containing the session trace");
+DEFINE_int32(rtt, 50, "Simulated RTT, ms");
+DEFINE_int32(bandwidth_mbps, 100, "Simulated link bandwidth, Mbit/s");
+DEFINE_int32(tick, 10, "Link model tick, ms");
+
+using namespace proxygen::replay;
+
+int main(int argc, char* argv[]) {
+  folly::init(&argc, &argv, true);
+
+  if (FLAGS_input.empty()) {
+    LOG(ERROR) << "Must supply a trace filename";
+    return 1;
+  }
+
+  ReplayParams params;
+  params.rtt = std::chrono::milliseconds(FLAGS_rtt);
+  params.bandwidthBytesPerSec = uint64_t(FLAGS_bandwidth_mbps) * 1000000 / 8;
+  params.linkTick = std::chrono::milliseconds(FLAGS_tick);
+
+  SessionReplaySimulator sim(params);
+  if (!sim.readTraceFromFile(FLAGS_input)) {
+    return 1;
+  }
+  auto report = sim.run();
+
+  for (const auto& stream : report.streams) {
+    std::cout << "stream=" << stream.first
+              << " bytes=" << stream.second.bytes
+              << " first_byte_ms=" << stream.second.firstByte.count()
+              << " last_byte_ms=" << stream.second.lastByte.count()
+              << std::endl;
+  }
+  std::cout << "egress_bytes=" << report.egressBytes
+            << " priority_conformance=" << report.priorityConformance
+            << " cpu_ms=" << report.cpu.count() / 1000.0 << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,523 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "proxygen/lib/http/session/experimental/replay/SessionReplaySimulator.h"
+
+#include <folly/Conv.h>
+#include <folly/Function.h>
+#include <folly/String.h>
+#include <fstream>
+#include <sys/resource.h>
+
+#include <proxygen/lib/http/codec/HTTP2Codec.h>
+#include <proxygen/lib/test/TestAsyncTransport.h>
+
+using folly::IOBuf;
+
+namespace {
+
+std::unique_ptr<IOBuf> makeBuf(uint32_t size) {
+  auto out = IOBuf::create(size);
+  memset(out->writableData(), 'x', size);
+  out->append(size);
+  return out;
+}
+
+std::chrono::microseconds cpuNow() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  auto toUsec = [](const struct timeval& tv) {
+    return std::chrono::microseconds(int64_t(tv.tv_sec) * 1000000 +
+                                     tv.tv_usec);
+  };
+  return toUsec(usage.ru_utime) + toUsec(usage.ru_stime);
+}
+
+// Trace urgencies (0 most urgent) map onto the h2 weight scale
+uint8_t urgencyToWeight(uint8_t urgency) {
+  return 255 - std::min<uint8_t>(urgency, 7) * 32;
+}
+
+} // namespace
+
+namespace proxygen { namespace replay {
+
+/**
+ * Serves every replayed request with the response size the trace asked
+ * for; the interesting part of the replay is how the session schedules
+ * these competing responses, not what is in them.
+ */
+class SessionReplaySimulator::ReplayHandler : public HTTPTransactionHandler {
+ public:
+  ReplayHandler(ReplayController& controller, uint32_t responseBytes)
+      : controller_(controller), responseBytes_(responseBytes) {
+  }
+
+  void setTransaction(HTTPTransaction* txn) noexcept override {
+    txn_ = txn;
+  }
+
+  void detachTransaction() noexcept override;
+
+  void onHeadersComplete(std::unique_ptr<HTTPMessage>) noexcept override {
+  }
+
+  void onBody(std::unique_ptr<IOBuf>) noexcept override {
+  }
+
+  void onTrailers(std::unique_ptr<HTTPHeaders>) noexcept override {
+  }
+
+  void onEOM() noexcept override {
+    HTTPMessage resp;
+    resp.setHTTPVersion(1, 1);
+    resp.setStatusCode(200);
+    resp.setStatusMessage("OK");
+    resp.getHeaders().add(HTTP_HEADER_CONTENT_LENGTH,
+                          folly::to<std::string>(responseBytes_));
+    txn_->sendHeaders(resp);
+    if (responseBytes_ > 0) {
+      txn_->sendBody(makeBuf(responseBytes_));
+    }
+    txn_->sendEOM();
+  }
+
+  void onUpgrade(UpgradeProtocol) noexcept override {
+  }
+
+  void onError(const HTTPException& error) noexcept override {
+    LOG(ERROR) << "replay transaction error: " << error.what();
+  }
+
+  void onEgressPaused() noexcept override {
+  }
+
+  void onEgressResumed() noexcept override {
+  }
+
+ private:
+  ReplayController& controller_;
+  HTTPTransaction* txn_{nullptr};
+  uint32_t responseBytes_;
+};
+
+class SessionReplaySimulator::ReplayController : public HTTPSessionController {
+ public:
+  ReplayController(
+      const std::map<uint32_t, std::pair<uint8_t, uint32_t>>& requests,
+      folly::Function<void()> onSessionGone)
+      : requests_(requests), onSessionGone_(std::move(onSessionGone)) {
+  }
+
+  HTTPTransactionHandler* getRequestHandler(HTTPTransaction& txn,
+                                            HTTPMessage*) override {
+    auto it = requests_.find(txn.getID());
+    const uint32_t bytes = (it == requests_.end()) ? 0 : it->second.second;
+    return new ReplayHandler(*this, bytes);
+  }
+
+  HTTPTransactionHandler* getParseErrorHandler(
+      HTTPTransaction*,
+      const HTTPException&,
+      const folly::SocketAddress&) override {
+    return nullptr;
+  }
+
+  HTTPTransactionHandler* getTransactionTimeoutHandler(
+      HTTPTransaction*, const folly::SocketAddress&) override {
+    return nullptr;
+  }
+
+  void attachSession(HTTPSessionBase* session) override {
+    session_ = session;
+  }
+
+  void detachSession(const HTTPSessionBase*) override {
+    session_ = nullptr;
+    if (onSessionGone_) {
+      onSessionGone_();
+    }
+  }
+
+  // A handler finished its response; once all of them have, drain the
+  // session so the replay terminates
+  void handlerDone() {
+    if (++handlersDone_ == requests_.size() && session_) {
+      session_->closeWhenIdle();
+    }
+  }
+
+ private:
+  const std::map<uint32_t, std::pair<uint8_t, uint32_t>>& requests_;
+  folly::Function<void()> onSessionGone_;
+  HTTPSessionBase* session_{nullptr};
+  size_t handlersDone_{0};
+};
+
+void SessionReplaySimulator::ReplayHandler::detachTransaction() noexcept {
+  controller_.handlerDone();
+  delete this;
+}
+
+/**
+ * Tick-granularity token-bucket link: each tick adds bandwidth * tick
+ * of credit, and once the session has written past the available
+ * credit, writes are paused until credit catches up.  The bucket holds
+ * at most one bandwidth-delay product, so idle periods do not bank an
+ * unbounded burst.  Every drained write is copied out with its drain
+ * time; the post-run audit works from those copies, after the session
+ * and its transport are gone.
+ */
+class SessionReplaySimulator::LinkModel : public folly::AsyncTimeout {
+ public:
+  LinkModel(folly::EventBase* eventBase, const ReplayParams& params)
+      : folly::AsyncTimeout(eventBase), params_(params) {
+  }
+
+  void start(TestAsyncTransport* transport) {
+    transport_ = transport;
+    creditBytes_ = tickBytes();
+    scheduleTimeout(params_.linkTick);
+  }
+
+  void stop() {
+    collect();
+    cancelTimeout();
+    transport_ = nullptr;
+  }
+
+  // Pull any new write events into the drained record
+  void collect() {
+    if (!transport_) {
+      return;
+    }
+    auto now = getCurrentTime();
+    auto* events = transport_->getWriteEvents();
+    while (nextEvent_ < events->size()) {
+      const auto& event = (*events)[nextEvent_++];
+      folly::IOBufQueue chain{folly::IOBufQueue::cacheChainLength()};
+      for (size_t i = 0; i < event->getCount(); i++) {
+        const auto& iov = event->getIoVec()[i];
+        chain.append(IOBuf::copyBuffer(iov.iov_base, iov.iov_len));
+        consumedBytes_ += iov.iov_len;
+      }
+      drained_.emplace_back(now, chain.move());
+    }
+  }
+
+  void timeoutExpired() noexcept override {
+    const uint64_t burstCap =
+        std::max<uint64_t>(tickBytes(),
+                           params_.bandwidthBytesPerSec *
+                               params_.rtt.count() / 1000);
+    creditBytes_ =
+        std::min(creditBytes_ + tickBytes(), consumedBytes_ + burstCap);
+    collect();
+    if (consumedBytes_ > creditBytes_) {
+      if (!paused_) {
+        transport_->pauseWrites();
+        paused_ = true;
+      }
+    } else if (paused_) {
+      transport_->resumeWrites();
+      paused_ = false;
+    }
+    scheduleTimeout(params_.linkTick);
+  }
+
+  const std::vector<std::pair<TimePoint, std::unique_ptr<IOBuf>>>& drained()
+      const {
+    return drained_;
+  }
+
+  uint64_t consumedBytes() const {
+    return consumedBytes_;
+  }
+
+ private:
+  uint64_t tickBytes() const {
+    return params_.bandwidthBytesPerSec * params_.linkTick.count() / 1000;
+  }
+
+  const ReplayParams& params_;
+  TestAsyncTransport* transport_{nullptr};
+  size_t nextEvent_{0};
+  uint64_t creditBytes_{0};
+  uint64_t consumedBytes_{0};
+  bool paused_{false};
+  std::vector<std::pair<TimePoint, std::unique_ptr<IOBuf>>> drained_;
+};
+
+/**
+ * Re-parses the drained egress with an upstream codec to attribute
+ * bytes and times to streams, exactly as the recorded client would
+ * have seen them.
+ */
+class SessionReplaySimulator::EgressAuditCallback : public HTTPCodec::Callback {
+ public:
+  struct BodyChunk {
+    uint32_t stream;
+    uint64_t bytes;
+    TimePoint time;
+  };
+
+  void onMessageBegin(HTTPCodec::StreamID, HTTPMessage*) override {
+  }
+
+  void onHeadersComplete(HTTPCodec::StreamID stream,
+                         std::unique_ptr<HTTPMessage>) override {
+    auto& times = streamTimes_[uint32_t(stream)];
+    if (times.first == TimePoint()) {
+      times.first = now;
+    }
+    times.second = now;
+  }
+
+  void onBody(HTTPCodec::StreamID stream,
+              std::unique_ptr<IOBuf> chain,
+              uint16_t) override {
+    const auto bytes = chain->computeChainDataLength();
+    chunks_.push_back({uint32_t(stream), bytes, now});
+    streamTimes_[uint32_t(stream)].second = now;
+  }
+
+  void onTrailersComplete(HTTPCodec::StreamID,
+                          std::unique_ptr<HTTPHeaders>) override {
+  }
+
+  void onMessageComplete(HTTPCodec::StreamID, bool) override {
+  }
+
+  void onError(HTTPCodec::StreamID stream,
+               const HTTPException& error,
+               bool) override {
+    LOG(ERROR) << "audit parse error on stream=" << stream << ": "
+               << error.what();
+  }
+
+  TimePoint now;
+  std::vector<BodyChunk> chunks_;
+  // stream -> (response headers egressed, last egress activity)
+  std::map<uint32_t, std::pair<TimePoint, TimePoint>> streamTimes_;
+};
+
+SessionReplaySimulator::SessionReplaySimulator(ReplayParams params)
+    : params_(params) {
+}
+
+SessionReplaySimulator::~SessionReplaySimulator() {
+}
+
+bool SessionReplaySimulator::readTraceFromFile(const std::string& filename) {
+  std::ifstream input(filename);
+  if (!input.good()) {
+    LOG(ERROR) << "cannot open trace file " << filename;
+    return false;
+  }
+  std::string line;
+  size_t lineNo = 0;
+  while (std::getline(input, line)) {
+    lineNo++;
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::vector<folly::StringPiece> fields;
+    folly::split(' ', line, fields, /*ignoreEmpty=*/true);
+    if (fields.size() < 3) {
+      LOG(ERROR) << "short trace line " << lineNo;
+      return false;
+    }
+    TraceEvent event;
+    try {
+      event.time = std::chrono::milliseconds(folly::to<int64_t>(fields[0]));
+      event.stream = folly::to<uint32_t>(fields[1]);
+      if (fields[2] == "headers" && fields.size() >= 5) {
+        event.type = TraceEvent::Type::Headers;
+        event.urgency = folly::to<uint8_t>(fields[3]);
+        event.responseBytes = folly::to<uint32_t>(fields[4]);
+        if (fields.size() >= 6) {
+          event.path = fields[5].str();
+        }
+        requests_[event.stream] = {event.urgency, event.responseBytes};
+      } else if (fields[2] == "body" && fields.size() >= 4) {
+        event.type = TraceEvent::Type::Body;
+        event.bodyBytes = folly::to<uint32_t>(fields[3]);
+      } else if (fields[2] == "eom") {
+        event.type = TraceEvent::Type::EOM;
+      } else {
+        LOG(ERROR) << "bad trace event '" << fields[2] << "' line " << lineNo;
+        return false;
+      }
+    } catch (const folly::ConversionError& ex) {
+      LOG(ERROR) << "bad trace line " << lineNo << ": " << ex.what();
+      return false;
+    }
+    if (!trace_.empty() && event.time < trace_.back().time) {
+      LOG(ERROR) << "trace not sorted by time at line " << lineNo;
+      return false;
+    }
+    trace_.push_back(std::move(event));
+  }
+  return !trace_.empty();
+}
+
+void SessionReplaySimulator::buildIngress(TestAsyncTransport* transport) {
+  HTTP2Codec clientCodec(TransportDirection::UPSTREAM);
+  folly::IOBufQueue output{folly::IOBufQueue::cacheChainLength()};
+  clientCodec.generateConnectionPreface(output);
+  clientCodec.generateSettings(output);
+
+  // The first event carries the handshake plus half an RTT of
+  // client->server propagation; later delays come from the trace
+  auto flushAt = params_.rtt / 2 + trace_.front().time;
+  auto prevTime = trace_.front().time;
+  for (const auto& event : trace_) {
+    if (event.time != prevTime) {
+      transport->addMovableReadEvent(output.move(), flushAt);
+      flushAt = event.time - prevTime;
+      prevTime = event.time;
+    }
+    switch (event.type) {
+      case TraceEvent::Type::Headers: {
+        HTTPMessage req;
+        req.setHTTPVersion(1, 1);
+        req.setMethod(HTTPMethod::GET);
+        req.setURL(event.path);
+        req.getHeaders().add(HTTP_HEADER_HOST, "replay");
+        req.setHTTP2Priority(HTTPMessage::HTTP2Priority(
+            0, false, urgencyToWeight(event.urgency)));
+        clientCodec.generateHeader(output, event.stream, req, false);
+        break;
+      }
+      case TraceEvent::Type::Body:
+        clientCodec.generateBody(output,
+                                 event.stream,
+                                 makeBuf(event.bodyBytes),
+                                 folly::none,
+                                 false);
+        break;
+      case TraceEvent::Type::EOM:
+        clientCodec.generateEOM(output, event.stream);
+        break;
+    }
+  }
+  transport->addMovableReadEvent(output.move(), flushAt);
+}
+
+ReplayReport SessionReplaySimulator::run() {
+  CHECK(!trace_.empty()) << "no trace loaded";
+  auto transport = new TestAsyncTransport(&eventBase_);
+  buildIngress(transport);
+
+  link_ = std::make_unique<LinkModel>(&eventBase_, params_);
+  controller_ = std::make_unique<ReplayController>(requests_, [this] {
+    // session teardown: take the last write events before the
+    // transport disappears, then end the replay
+    link_->stop();
+    eventBase_.terminateLoopSoon();
+  });
+
+  folly::HHWheelTimer::UniquePtr timer{folly::HHWheelTimer::newTimer(
+      &eventBase_,
+      std::chrono::milliseconds(folly::HHWheelTimer::DEFAULT_TICK_INTERVAL),
+      folly::AsyncTimeout::InternalEnum::NORMAL,
+      std::chrono::milliseconds(60000))};
+
+  folly::SocketAddress localAddr("127.0.0.1", 80);
+  folly::SocketAddress peerAddr("127.0.0.1", 12345);
+  wangle::TransportInfo tinfo;
+  auto session = new HTTPDownstreamSession(
+      timer.get(),
+      folly::AsyncTransport::UniquePtr(transport),
+      localAddr,
+      peerAddr,
+      controller_.get(),
+      std::make_unique<HTTP2Codec>(TransportDirection::DOWNSTREAM),
+      tinfo,
+      nullptr);
+  // Windows sized to the BDP stand in for a client acking every RTT
+  const uint32_t window = std::max<uint32_t>(
+      65535, params_.bandwidthBytesPerSec * params_.rtt.count() / 1000);
+  session->setFlowControl(window, window, window);
+
+  // Watchdog: a trace that never completes should fail the run, not
+  // hang it
+  eventBase_.runAfterDelay(
+      [this] {
+        LOG(ERROR) << "replay did not complete, terminating";
+        link_->stop();
+        eventBase_.terminateLoopSoon();
+      },
+      trace_.back().time.count() + 60000);
+
+  const auto cpuBefore = cpuNow();
+  const auto start = getCurrentTime();
+  session->startNow();
+  transport->startReadEvents();
+  link_->start(transport);
+  eventBase_.loop();
+  const auto cpuAfter = cpuNow();
+
+  auto report = auditEgress(start, nullptr);
+  report.cpu = cpuAfter - cpuBefore;
+  return report;
+}
+
+ReplayReport SessionReplaySimulator::auditEgress(TimePoint start,
+                                                 TestAsyncTransport*) {
+  EgressAuditCallback audit;
+  HTTP2Codec auditCodec(TransportDirection::UPSTREAM);
+  auditCodec.setCallback(&audit);
+  for (const auto& drained : link_->drained()) {
+    audit.now = drained.first;
+    auditCodec.onIngress(*drained.second);
+  }
+
+  ReplayReport report;
+  report.egressBytes = link_->consumedBytes();
+
+  for (const auto& times : audit.streamTimes_) {
+    auto& stream = report.streams[times.first];
+    stream.firstByte = millisecondsBetween(times.second.first, start);
+    stream.lastByte = millisecondsBetween(times.second.second, start);
+  }
+
+  uint64_t totalBodyBytes = 0;
+  uint64_t conformingBytes = 0;
+  for (const auto& chunk : audit.chunks_) {
+    report.streams[chunk.stream].bytes += chunk.bytes;
+    totalBodyBytes += chunk.bytes;
+    auto it = requests_.find(chunk.stream);
+    const uint8_t urgency = (it == requests_.end()) ? 7 : it->second.first;
+    bool conforming = true;
+    for (const auto& other : audit.streamTimes_) {
+      if (other.first == chunk.stream) {
+        continue;
+      }
+      auto otherReq = requests_.find(other.first);
+      if (otherReq == requests_.end() || otherReq->second.first >= urgency) {
+        continue;
+      }
+      // a more urgent stream had its response outstanding at this time
+      if (other.second.first <= chunk.time &&
+          chunk.time < other.second.second) {
+        conforming = false;
+        break;
+      }
+    }
+    if (conforming) {
+      conformingBytes += chunk.bytes;
+    }
+  }
+  if (totalBodyBytes > 0) {
+    report.priorityConformance = double(conformingBytes) / totalBodyBytes;
+  }
+  return report;
+}
+
+}} // namespace proxygen::replay
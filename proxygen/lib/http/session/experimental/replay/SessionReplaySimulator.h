@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <folly/io/async/EventBase.h>
+#include <folly/io/async/HHWheelTimer.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <proxygen/lib/http/session/HTTPDownstreamSession.h>
+#include <proxygen/lib/http/session/HTTPSessionController.h>
+#include <proxygen/lib/utils/Time.h>
+
+class TestAsyncTransport;
+
+namespace proxygen { namespace replay {
+
+/**
+ * Deterministic replay of a recorded multi-stream HTTP/2 session
+ * through a real HTTPDownstreamSession, for macro regression coverage
+ * of session-layer scheduling.  The codec-level analogue is the
+ * compression simulator under codec/compress/experimental/simulator.
+ *
+ * The input is a frame-level trace distilled from a HAR or pcap
+ * capture, one ingress event per line:
+ *
+ *   <time_ms> <stream_id> headers <urgency 0-7> <response_bytes> [path]
+ *   <time_ms> <stream_id> body <bytes>
+ *   <time_ms> <stream_id> eom
+ *
+ * Events must be sorted by time.  The simulator serializes them with an
+ * upstream HTTP2Codec into timed read events on a TestAsyncTransport,
+ * responds to each request with response_bytes of body, and drains the
+ * session's egress through a token-bucket link model at the configured
+ * bandwidth.  RTT is applied as a one-way propagation delay on ingress,
+ * and the session's flow-control windows are sized to the
+ * bandwidth-delay product, which models a client that acks every RTT;
+ * per-frame WINDOW_UPDATE replay is deliberately out of scope.
+ *
+ * The report grades the egress schedule rather than just throughput:
+ * per-stream first/last response byte times, the fraction of response
+ * bytes that went to the most urgent stream with pending egress
+ * (priority conformance), and CPU consumed per replayed session.
+ */
+
+struct ReplayParams {
+  std::chrono::milliseconds rtt{50};
+  uint64_t bandwidthBytesPerSec{12500000}; // 100 Mbit/s
+  std::chrono::milliseconds linkTick{10};
+};
+
+struct TraceEvent {
+  enum class Type { Headers, Body, EOM };
+  std::chrono::milliseconds time{0};
+  uint32_t stream{0};
+  Type type{Type::Headers};
+  uint8_t urgency{3};         // Headers only
+  uint32_t responseBytes{0};  // Headers only
+  uint32_t bodyBytes{0};      // Body only
+  std::string path{"/"};
+};
+
+struct StreamReport {
+  std::chrono::milliseconds firstByte{0};
+  std::chrono::milliseconds lastByte{0};
+  uint64_t bytes{0};
+};
+
+struct ReplayReport {
+  uint64_t egressBytes{0};
+  // Fraction of egress body bytes sent while no more-urgent stream had
+  // a response outstanding; 1.0 is a perfectly conforming schedule
+  double priorityConformance{1.0};
+  std::chrono::microseconds cpu{0};
+  std::map<uint32_t, StreamReport> streams;
+};
+
+class SessionReplaySimulator {
+ public:
+  explicit SessionReplaySimulator(ReplayParams params);
+  ~SessionReplaySimulator();
+
+  bool readTraceFromFile(const std::string& filename);
+
+  ReplayReport run();
+
+ private:
+  class ReplayController;
+  class ReplayHandler;
+  class LinkModel;
+  class EgressAuditCallback;
+
+  void buildIngress(TestAsyncTransport* transport);
+  ReplayReport auditEgress(TimePoint start, TestAsyncTransport* transport);
+
+  ReplayParams params_;
+  folly::EventBase eventBase_;
+  std::vector<TraceEvent> trace_;
+  // stream -> (urgency, response size), from the trace's headers events
+  std::map<uint32_t, std::pair<uint8_t, uint32_t>> requests_;
+  std::unique_ptr<ReplayController> controller_;
+  std::unique_ptr<LinkModel> link_;
+};
+
+}} // namespace proxygen::replay
@@ -23,6 +23,8 @@ class MockByteEventTrackerCallback : public ByteEventTracker::Callback {
   GMOCK_METHOD1_(, noexcept, , onPingReplyLatency, void(int64_t));
   GMOCK_METHOD1_(
       , noexcept, , onTxnByteEventWrittenToBuf, void(const ByteEvent&));
+  GMOCK_METHOD1_(, noexcept, , onTxnByteEventsWrittenToBuf,
+                 void(folly::Range<ByteEvent* const*>));
   GMOCK_METHOD0_(, noexcept, , onDeleteTxnByteEvent, void());
 };
 
@@ -30,6 +32,13 @@ class ByteEventTrackerTest : public Test {
  public:
   void SetUp() override {
     txn_.setTransportCallback(&transportCallback_);
+    // keep the base bulk -> per-event fan-out so tests can expect
+    // individual onTxnByteEventWrittenToBuf calls
+    ON_CALL(callback_, onTxnByteEventsWrittenToBuf(_))
+        .WillByDefault(Invoke([this](folly::Range<ByteEvent* const*> events) {
+          callback_.ByteEventTracker::Callback::onTxnByteEventsWrittenToBuf(
+              events);
+        }));
   }
 
  protected:
@@ -71,3 +80,47 @@ TEST_F(ByteEventTrackerTest, Ttlb) {
   EXPECT_CALL(transport_, detach(_));
   byteEventTracker_->processByteEvents(byteEventTracker_, 10);
 }
+
+TEST_F(ByteEventTrackerTest, BatchedByteEvents) {
+  // seed the list so part of the batch lands before the current tail
+  byteEventTracker_->addLastByteEvent(&txn_, 30);
+  ByteEventTracker::EventRequest batch[] = {
+      {10, ByteEvent::FIRST_HEADER_BYTE},
+      {20, ByteEvent::FIRST_BYTE},
+      {40, ByteEvent::TRACKED_BYTE}};
+  byteEventTracker_->addTxnByteEvents(
+      &txn_, folly::Range<const ByteEventTracker::EventRequest*>(batch, 3));
+  // entirely past the tail: exercises the O(1) append path
+  ByteEventTracker::EventRequest tail[] = {{50, ByteEvent::TRACKED_BYTE},
+                                           {60, ByteEvent::TRACKED_BYTE}};
+  byteEventTracker_->addTxnByteEvents(
+      &txn_, folly::Range<const ByteEventTracker::EventRequest*>(tail, 2));
+
+  EXPECT_CALL(transportCallback_, headerBytesGenerated(_));
+  txn_.sendAbort(); // put it in a state for detach
+  EXPECT_CALL(transportCallback_, firstHeaderByteFlushed());
+  EXPECT_CALL(transportCallback_, firstByteFlushed());
+  EXPECT_CALL(transportCallback_, lastByteFlushed());
+  EXPECT_CALL(transportCallback_, trackedByteFlushed()).Times(3);
+  std::vector<uint64_t> offsets;
+  EXPECT_CALL(callback_, onTxnByteEventWrittenToBuf(_))
+      .WillRepeatedly(Invoke([&offsets](const ByteEvent& event) {
+        offsets.push_back(event.getByteOffset());
+      }));
+  EXPECT_CALL(transport_, detach(_));
+  byteEventTracker_->processByteEvents(byteEventTracker_, 60);
+  EXPECT_THAT(offsets, ElementsAre(10, 20, 30, 40, 50, 60));
+}
+
+TEST_F(ByteEventTrackerTest, BulkNotifyOncePerBatch) {
+  byteEventTracker_->addLastByteEvent(&txn_, 10);
+  byteEventTracker_->addTrackedByteEvent(&txn_, 20);
+  EXPECT_CALL(transportCallback_, headerBytesGenerated(_));
+  txn_.sendAbort(); // put it in a state for detach
+  EXPECT_CALL(transportCallback_, lastByteFlushed());
+  EXPECT_CALL(transportCallback_, trackedByteFlushed());
+  // both ready events arrive in a single bulk callback
+  EXPECT_CALL(callback_, onTxnByteEventsWrittenToBuf(SizeIs(2)));
+  EXPECT_CALL(transport_, detach(_));
+  byteEventTracker_->processByteEvents(byteEventTracker_, 20);
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/http/session/ClientCapabilityCache.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+
+namespace {
+
+CompressionInfo compressionWithEgressStored(uint32_t bytesStored) {
+  CompressionInfo info;
+  info.egress.bytesStored_ = bytesStored;
+  return info;
+}
+
+} // namespace
+
+TEST(ClientCapabilityCacheTest, ColdClassServesNoProfile) {
+  ClientCapabilityCache cache;
+  EXPECT_FALSE(cache.getProfile("chrome/tls13"));
+
+  // below minSamples the class stays cold
+  cache.recordSession("chrome/tls13", 1e6, compressionWithEgressStored(2000));
+  cache.recordSession("chrome/tls13", 1e6, compressionWithEgressStored(2000));
+  EXPECT_FALSE(cache.getProfile("chrome/tls13"));
+
+  cache.recordSession("chrome/tls13", 1e6, compressionWithEgressStored(2000));
+  EXPECT_TRUE(cache.getProfile("chrome/tls13").has_value());
+}
+
+TEST(ClientCapabilityCacheTest, LearnsWindowAndTableSize) {
+  ClientCapabilityCache cache;
+  // 2 MB/s steady delivery, encoder table settling at 3000 bytes
+  for (int i = 0; i < 3; i++) {
+    cache.recordSession("chrome/tls13", 2e6, compressionWithEgressStored(3000));
+  }
+  auto profile = cache.getProfile("chrome/tls13");
+  ASSERT_TRUE(profile.has_value());
+  // window covers 100ms at the learned rate
+  EXPECT_EQ(profile->initialReceiveWindow, 200000);
+  // table sized to steady-state occupancy with 2x headroom
+  EXPECT_EQ(profile->headerTableSize, 6000);
+}
+
+TEST(ClientCapabilityCacheTest, ClampsProfileToConfiguredBounds) {
+  ClientCapabilityCache cache;
+  // a trickle-rate class with an oversized table appetite
+  for (int i = 0; i < 3; i++) {
+    cache.recordSession("bot/tls10", 100.0, compressionWithEgressStored(50000));
+  }
+  auto profile = cache.getProfile("bot/tls10");
+  ASSERT_TRUE(profile.has_value());
+  EXPECT_EQ(profile->initialReceiveWindow, 65535);
+  EXPECT_EQ(profile->headerTableSize, 65536);
+}
+
+TEST(ClientCapabilityCacheTest, ObservationsFoldAsEwma) {
+  ClientCapabilityCache::Config config;
+  config.minSamples = 1;
+  ClientCapabilityCache cache{config};
+  cache.recordSession("app/tls13", 1e6, compressionWithEgressStored(1000));
+  // one fast outlier moves the estimate by its weight, not to itself
+  cache.recordSession("app/tls13", 9e6, compressionWithEgressStored(1000));
+  auto profile = cache.getProfile("app/tls13");
+  ASSERT_TRUE(profile.has_value());
+  // 0.75 * 1MB/s + 0.25 * 9MB/s = 3MB/s -> 300000 over 100ms
+  EXPECT_EQ(profile->initialReceiveWindow, 300000);
+}
+
+TEST(ClientCapabilityCacheTest, EvictsLeastRecentClassPastCapacity) {
+  ClientCapabilityCache::Config config;
+  config.maxClasses = 2;
+  config.minSamples = 1;
+  ClientCapabilityCache cache{config};
+  cache.recordSession("a", 1e6, compressionWithEgressStored(1000));
+  cache.recordSession("b", 1e6, compressionWithEgressStored(1000));
+  EXPECT_EQ(cache.getNumClasses(), 2);
+
+  // touching "a" keeps it warm; inserting "c" evicts "b"
+  EXPECT_TRUE(cache.getProfile("a").has_value());
+  cache.recordSession("c", 1e6, compressionWithEgressStored(1000));
+  EXPECT_EQ(cache.getNumClasses(), 2);
+  EXPECT_TRUE(cache.getProfile("a").has_value());
+  EXPECT_FALSE(cache.getProfile("b"));
+  EXPECT_TRUE(cache.getProfile("c").has_value());
+}
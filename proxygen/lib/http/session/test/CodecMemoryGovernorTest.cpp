@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/http/session/CodecMemoryGovernor.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+
+namespace {
+
+CodecMemoryGovernor::Config testConfig() {
+  CodecMemoryGovernor::Config config;
+  config.maxHeaderTableSize = 4096;
+  config.minHeaderTableSize = 1024;
+  config.maxInitialReceiveWindow = 65536;
+  config.minInitialReceiveWindow = 16384;
+  config.sessionBudget = 1000;
+  return config;
+}
+
+} // namespace
+
+TEST(CodecMemoryGovernorTest, FullBudgetAtLowOccupancy) {
+  CodecMemoryGovernor governor{testConfig()};
+  governor.updateOccupancy(0);
+  EXPECT_DOUBLE_EQ(governor.getPressure(), 0.0);
+  EXPECT_EQ(governor.getHeaderTableSize(), 4096);
+  EXPECT_EQ(governor.getInitialReceiveWindow(), 65536);
+  EXPECT_FALSE(governor.underPressure());
+  EXPECT_FALSE(governor.shouldShrinkExistingSessions());
+}
+
+TEST(CodecMemoryGovernorTest, ScalesDownWithSessionCount) {
+  CodecMemoryGovernor governor{testConfig()};
+  governor.updateOccupancy(500);
+  EXPECT_DOUBLE_EQ(governor.getPressure(), 0.5);
+  EXPECT_EQ(governor.getHeaderTableSize(), 4096 - (4096 - 1024) / 2);
+  EXPECT_EQ(governor.getInitialReceiveWindow(), 65536 - (65536 - 16384) / 2);
+
+  governor.updateOccupancy(2000);
+  EXPECT_DOUBLE_EQ(governor.getPressure(), 1.0);
+  EXPECT_EQ(governor.getHeaderTableSize(), 1024);
+  EXPECT_EQ(governor.getInitialReceiveWindow(), 16384);
+}
+
+TEST(CodecMemoryGovernorTest, RssPressureDominatesWhenHigher) {
+  auto config = testConfig();
+  config.workerRssBudgetBytes = 1000;
+  CodecMemoryGovernor governor{config};
+
+  governor.updateOccupancy(100, 900);
+  EXPECT_DOUBLE_EQ(governor.getPressure(), 0.9);
+
+  // RSS signal disabled when unknown
+  governor.updateOccupancy(100, 0);
+  EXPECT_DOUBLE_EQ(governor.getPressure(), 0.1);
+}
+
+TEST(CodecMemoryGovernorTest, ShrinkWatermarkWithHysteresis) {
+  CodecMemoryGovernor governor{testConfig()};
+
+  governor.updateOccupancy(800);
+  EXPECT_TRUE(governor.underPressure());
+  // One-shot: a single shrink pass per crossing
+  EXPECT_TRUE(governor.shouldShrinkExistingSessions());
+  EXPECT_FALSE(governor.shouldShrinkExistingSessions());
+
+  // Hovering between thresholds does not re-arm
+  governor.updateOccupancy(600);
+  EXPECT_TRUE(governor.underPressure());
+  EXPECT_FALSE(governor.shouldShrinkExistingSessions());
+
+  // Dropping below the expand threshold clears pressure; the next
+  // crossing arms a new shrink pass
+  governor.updateOccupancy(400);
+  EXPECT_FALSE(governor.underPressure());
+  governor.updateOccupancy(800);
+  EXPECT_TRUE(governor.shouldShrinkExistingSessions());
+}
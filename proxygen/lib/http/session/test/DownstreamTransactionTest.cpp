@@ -11,6 +11,7 @@
 #include <proxygen/lib/http/codec/SPDYConstants.h>
 #include <proxygen/lib/http/codec/test/MockHTTPCodec.h>
 #include <proxygen/lib/http/codec/test/TestUtils.h>
+#include <proxygen/lib/http/session/IngressBufferPolicy.h>
 #include <proxygen/lib/http/session/test/HTTPSessionMocks.h>
 #include <proxygen/lib/http/session/test/HTTPTransactionMocks.h>
 #include <proxygen/lib/test/TestAsyncTransport.h>
@@ -99,6 +100,86 @@ class DownstreamTransactionTest : public testing::Test {
   uint32_t sent_{0};
 };
 
+TEST_F(DownstreamTransactionTest, EarlyHints) {
+  HTTPTransaction txn(TransportDirection::DOWNSTREAM,
+                      HTTPCodec::StreamID(1),
+                      1,
+                      transport_,
+                      txnEgressQueue_,
+                      transactionTimeouts_.get(),
+                      std::chrono::milliseconds(500));
+  HTTPHeaders hints;
+  hints.add("link", "</style.css>; rel=preload; as=style");
+
+  EXPECT_CALL(handler_, setTransaction(&txn));
+  EXPECT_CALL(handler_, detachTransaction());
+  EXPECT_CALL(transport_, detach(&txn));
+  std::vector<uint16_t> sentStatus;
+  EXPECT_CALL(transport_, sendHeaders(&txn, _, _, _))
+      .WillRepeatedly(
+          Invoke([&](Unused, const HTTPMessage& headers, Unused, Unused) {
+            sentStatus.push_back(headers.getStatusCode());
+            if (headers.getStatusCode() == 103) {
+              EXPECT_EQ("</style.css>; rel=preload; as=style",
+                        headers.getHeaders().getSingleOrEmpty("link"));
+            }
+          }));
+  EXPECT_CALL(handler_, onHeadersComplete(_));
+  EXPECT_CALL(handler_, onEOM()).WillOnce(InvokeWithoutArgs([&] {
+    // the hints go out before the final response and leave the egress
+    // state machine ready for it
+    txn.sendEarlyHints(hints);
+    auto response = makeResponse(200);
+    txn.sendHeadersWithEOM(*response.get());
+  }));
+
+  txn.setHandler(&handler_);
+  txn.onIngressHeadersComplete(makeGetRequest());
+  txn.onIngressEOM();
+  eventBase_.loop();
+
+  ASSERT_EQ(sentStatus.size(), 2);
+  EXPECT_EQ(sentStatus[0], 103);
+  EXPECT_EQ(sentStatus[1], 200);
+}
+
+TEST_F(DownstreamTransactionTest, RequestContextPropagation) {
+  folly::RequestContextScopeGuard rctxGuard;
+  auto createCtx = folly::RequestContext::saveContext();
+  HTTPTransaction txn(TransportDirection::DOWNSTREAM,
+                      HTTPCodec::StreamID(1),
+                      1,
+                      transport_,
+                      txnEgressQueue_,
+                      transactionTimeouts_.get(),
+                      std::chrono::milliseconds(500));
+  // captured at construction
+  EXPECT_EQ(txn.getRequestContext(), createCtx);
+
+  // a routing layer re-tags the transaction; handler callbacks then run
+  // under the route's context, not whatever ran last on the event base
+  auto routeCtx = std::make_shared<folly::RequestContext>();
+  txn.setRequestContext(routeCtx);
+
+  EXPECT_CALL(handler_, setTransaction(&txn));
+  EXPECT_CALL(handler_, detachTransaction());
+  EXPECT_CALL(transport_, detach(&txn));
+  EXPECT_CALL(transport_, sendHeaders(&txn, _, _, _));
+  EXPECT_CALL(handler_, onHeadersComplete(_)).WillOnce(InvokeWithoutArgs([&] {
+    EXPECT_EQ(folly::RequestContext::saveContext(), routeCtx);
+  }));
+  EXPECT_CALL(handler_, onEOM()).WillOnce(InvokeWithoutArgs([&] {
+    EXPECT_EQ(folly::RequestContext::saveContext(), routeCtx);
+    auto response = makeResponse(200);
+    txn.sendHeadersWithEOM(*response.get());
+  }));
+
+  txn.setHandler(&handler_);
+  txn.onIngressHeadersComplete(makeGetRequest());
+  txn.onIngressEOM();
+  eventBase_.loop();
+}
+
 /**
  * Test that the the transaction properly forwards callbacks to the
  * handler and that it interacts with its transport as expected.
@@ -118,6 +199,277 @@ TEST_F(DownstreamTransactionTest, SimpleCallbackForwarding) {
   eventBase_.loop();
 }
 
+/**
+ * Test that the always-on timing record picks up the lifecycle points a
+ * request/response flow hits, and that sampleTimingsTo() only emits trace
+ * fields for events that actually happened.
+ */
+TEST_F(DownstreamTransactionTest, TimingsRecord) {
+  HTTPTransaction txn(TransportDirection::DOWNSTREAM,
+                      HTTPCodec::StreamID(1),
+                      1,
+                      transport_,
+                      txnEgressQueue_,
+                      transactionTimeouts_.get(),
+                      std::chrono::milliseconds(500));
+  setupRequestResponseFlow(&txn, 100);
+
+  const auto& timings = txn.getTimings();
+  EXPECT_TRUE(timings.reached(HTTPTransaction::Timings::Created));
+  EXPECT_FALSE(
+      timings.reached(HTTPTransaction::Timings::IngressHeadersComplete));
+
+  txn.onIngressHeadersComplete(makeGetRequest());
+  eventBase_.loop();
+
+  EXPECT_TRUE(timings.reached(HTTPTransaction::Timings::IngressHeadersComplete));
+  EXPECT_TRUE(timings.reached(HTTPTransaction::Timings::IngressEOM));
+  EXPECT_TRUE(timings.reached(HTTPTransaction::Timings::FirstEgressWrite));
+  EXPECT_LE(timings.get(HTTPTransaction::Timings::Created),
+            timings.get(HTTPTransaction::Timings::IngressHeadersComplete));
+  EXPECT_LE(timings.get(HTTPTransaction::Timings::IngressHeadersComplete),
+            timings.get(HTTPTransaction::Timings::FirstEgressWrite));
+
+  // the byte events come from the session; fake the first-header flush but
+  // leave the last-byte flush unreported
+  txn.onEgressHeaderFirstByte();
+  EXPECT_TRUE(
+      timings.reached(HTTPTransaction::Timings::EgressHeadersFirstByteFlushed));
+  EXPECT_FALSE(
+      timings.reached(HTTPTransaction::Timings::EgressLastByteFlushed));
+
+  TraceEvent traceEvent((TraceEventType::TotalRequest));
+  txn.sampleTimingsTo(traceEvent);
+  EXPECT_TRUE(traceEvent.hasTraceField(TraceFieldType::TTFB));
+  EXPECT_FALSE(traceEvent.hasTraceField(TraceFieldType::TTLB));
+  EXPECT_GE(traceEvent.getTraceFieldDataAs<int64_t>(TraceFieldType::TTFB), 0);
+}
+
+/**
+ * Test that deferWork() notifies the transport once per batch, drains in
+ * FIFO order, and that work queued by a running item re-notifies and
+ * waits for the next drain.
+ */
+TEST_F(DownstreamTransactionTest, DeferredWork) {
+  HTTPTransaction txn(TransportDirection::DOWNSTREAM,
+                      HTTPCodec::StreamID(1),
+                      1,
+                      transport_,
+                      txnEgressQueue_,
+                      transactionTimeouts_.get(),
+                      std::chrono::milliseconds(500));
+  setupRequestResponseFlow(&txn, 100);
+
+  std::vector<int> order;
+  EXPECT_CALL(transport_, notifyDeferredWorkPending(&txn)).Times(2);
+  txn.deferWork([&] { order.push_back(1); });
+  txn.deferWork([&] {
+    order.push_back(2);
+    txn.deferWork([&] { order.push_back(3); });
+  });
+
+  txn.runDeferredWork();
+  EXPECT_EQ((std::vector<int>{1, 2}), order);
+  txn.runDeferredWork();
+  EXPECT_EQ((std::vector<int>{1, 2, 3}), order);
+
+  txn.onIngressHeadersComplete(makeGetRequest());
+  eventBase_.loop();
+}
+
+/**
+ * Test that when a worker's ingress buffer policy caps are exceeded,
+ * deferred body spills to a temp file and is delivered back in order on
+ * resume, returning the in-memory accounting to the policy.
+ */
+TEST_F(DownstreamTransactionTest, IngressSpillUnderBufferPolicy) {
+  IngressBufferPolicy policy(/*perTransactionLimitBytes=*/4096,
+                             /*perWorkerLimitBytes=*/64 * 1024,
+                             /*enableSpill=*/true);
+  HTTPTransaction txn(TransportDirection::DOWNSTREAM,
+                      HTTPCodec::StreamID(1),
+                      1,
+                      transport_,
+                      txnEgressQueue_,
+                      transactionTimeouts_.get(),
+                      std::chrono::milliseconds(500));
+  txn.setIngressBufferPolicy(&policy);
+
+  EXPECT_CALL(handler_, setTransaction(&txn));
+  EXPECT_CALL(handler_, onHeadersComplete(_))
+      .WillOnce(InvokeWithoutArgs([&] { txn.pauseIngress(); }));
+  EXPECT_CALL(handler_, onBodyWithOffset(_, _))
+      .WillRepeatedly(Invoke([&](uint64_t offset,
+                                 std::shared_ptr<folly::IOBuf> body) {
+        // offsets must stay contiguous across the memory/spill boundary
+        EXPECT_EQ(offset, received_);
+        received_ += body->computeChainDataLength();
+      }));
+  EXPECT_CALL(handler_, onEOM()).WillOnce(InvokeWithoutArgs([&] {
+    CHECK_EQ(received_, 4 * 4096);
+    txn.sendAbort();
+  }));
+  EXPECT_CALL(transport_, sendAbort(&txn, _));
+  EXPECT_CALL(handler_, detachTransaction());
+  EXPECT_CALL(transport_, detach(&txn));
+  txn.setHandler(&handler_);
+
+  txn.onIngressHeadersComplete(makeGetRequest());
+  // The first two chains fit under the per-transaction cap and queue in
+  // memory; the rest spill to disk
+  for (int i = 0; i < 4; i++) {
+    txn.onIngressBody(makeBuf(4096), 0);
+  }
+  txn.onIngressEOM();
+  EXPECT_EQ(txn.getDeferredIngressBodyBytes(), 2 * 4096);
+  EXPECT_EQ(policy.getWorkerBufferedBytes(), 2 * 4096);
+  EXPECT_EQ(received_, 0);
+
+  txn.resumeIngress();
+  eventBase_.loop();
+
+  EXPECT_EQ(received_, 4 * 4096);
+  EXPECT_EQ(txn.getDeferredIngressBodyBytes(), 0);
+  EXPECT_EQ(policy.getWorkerBufferedBytes(), 0);
+}
+
+/**
+ * Test that setIngressDeliveryPolicy() batches small ingress reads into
+ * aggregated onBody deliveries at the byte threshold, with EOM flushing
+ * the remainder ahead of onEOM.
+ */
+TEST_F(DownstreamTransactionTest, AggregatedIngressDelivery) {
+  HTTPTransaction txn(TransportDirection::DOWNSTREAM,
+                      HTTPCodec::StreamID(1),
+                      1,
+                      transport_,
+                      txnEgressQueue_,
+                      transactionTimeouts_.get(),
+                      std::chrono::milliseconds(500));
+  txn.setIngressDeliveryPolicy(4096, std::chrono::milliseconds(0));
+
+  uint32_t bodyCallbacks = 0;
+  EXPECT_CALL(handler_, setTransaction(&txn));
+  EXPECT_CALL(handler_, onHeadersComplete(_));
+  EXPECT_CALL(handler_, onBodyWithOffset(_, _))
+      .WillRepeatedly(
+          Invoke([&](uint64_t offset, std::shared_ptr<folly::IOBuf> body) {
+            // offsets stay contiguous across aggregated deliveries
+            EXPECT_EQ(offset, received_);
+            received_ += body->computeChainDataLength();
+            bodyCallbacks++;
+          }));
+  EXPECT_CALL(handler_, onEOM()).WillOnce(InvokeWithoutArgs([&] {
+    CHECK_EQ(received_, 10 * 1024);
+    txn.sendAbort();
+  }));
+  EXPECT_CALL(transport_, sendAbort(&txn, _));
+  EXPECT_CALL(handler_, detachTransaction());
+  EXPECT_CALL(transport_, detach(&txn));
+  txn.setHandler(&handler_);
+
+  txn.onIngressHeadersComplete(makeGetRequest());
+  // Ten 1KiB reads against a 4KiB threshold: two aggregated deliveries,
+  // 2KiB left buffered
+  for (int i = 0; i < 10; i++) {
+    txn.onIngressBody(makeBuf(1024), 0);
+  }
+  EXPECT_EQ(received_, 8 * 1024);
+  EXPECT_EQ(bodyCallbacks, 2);
+  // EOM flushes the remainder before onEOM
+  txn.onIngressEOM();
+  EXPECT_EQ(received_, 10 * 1024);
+  EXPECT_EQ(bodyCallbacks, 3);
+  eventBase_.loop();
+}
+
+/**
+ * Test that body held under the byte threshold is flushed when the
+ * policy's delay elapses.
+ */
+TEST_F(DownstreamTransactionTest, AggregatedIngressDelayFlush) {
+  HTTPTransaction txn(TransportDirection::DOWNSTREAM,
+                      HTTPCodec::StreamID(1),
+                      1,
+                      transport_,
+                      txnEgressQueue_,
+                      transactionTimeouts_.get(),
+                      std::chrono::milliseconds(500));
+  txn.setIngressDeliveryPolicy(1 << 20, std::chrono::milliseconds(10));
+
+  EXPECT_CALL(handler_, setTransaction(&txn));
+  EXPECT_CALL(handler_, onHeadersComplete(_));
+  EXPECT_CALL(handler_, onBodyWithOffset(0, _))
+      .WillOnce(Invoke([&](uint64_t, std::shared_ptr<folly::IOBuf> body) {
+        received_ += body->computeChainDataLength();
+        txn.sendAbort();
+      }));
+  EXPECT_CALL(transport_, sendAbort(&txn, _));
+  EXPECT_CALL(handler_, detachTransaction());
+  EXPECT_CALL(transport_, detach(&txn));
+  txn.setHandler(&handler_);
+
+  txn.onIngressHeadersComplete(makeGetRequest());
+  txn.onIngressBody(makeBuf(512), 0);
+  // Below the byte threshold, nothing delivered until the timer fires
+  EXPECT_EQ(received_, 0);
+  eventBase_.loop();
+  EXPECT_EQ(received_, 512);
+}
+
+/**
+ * Test that pipeTo() splices ingress body/EOM of one transaction into the
+ * egress of another without delivering onBody/onEOM to the source handler.
+ */
+TEST_F(DownstreamTransactionTest, PipeTo) {
+  HTTPTransaction source(TransportDirection::DOWNSTREAM,
+                         HTTPCodec::StreamID(1),
+                         1,
+                         transport_,
+                         txnEgressQueue_,
+                         transactionTimeouts_.get(),
+                         std::chrono::milliseconds(500));
+  HTTPTransaction sink(TransportDirection::DOWNSTREAM,
+                       HTTPCodec::StreamID(2),
+                       2,
+                       transport_,
+                       txnEgressQueue_,
+                       transactionTimeouts_.get(),
+                       std::chrono::milliseconds(500));
+  StrictMock<MockHTTPHandler> sinkHandler;
+
+  EXPECT_CALL(handler_, setTransaction(&source));
+  EXPECT_CALL(sinkHandler, setTransaction(&sink));
+  source.setHandler(&handler_);
+  sink.setHandler(&sinkHandler);
+
+  EXPECT_CALL(handler_, onHeadersComplete(_));
+  source.onIngressHeadersComplete(makeGetRequest());
+
+  EXPECT_CALL(transport_, sendHeaders(&sink, _, _, _));
+  auto response = makeResponse(200);
+  sink.sendHeaders(*response.get());
+
+  source.pipeTo(&sink);
+
+  // Body and EOM bypass the source handler entirely; the source handler
+  // mock is strict, so any onBody/onEOM would fail the test
+  const uint32_t bodySize = 100;
+  EXPECT_CALL(transport_, notifyPendingEgress()).Times(AtLeast(1));
+  source.onIngressBody(makeBuf(bodySize), 0);
+  source.onIngressEOM();
+
+  EXPECT_CALL(transport_, sendBody(&sink, _, _, _))
+      .WillOnce(Invoke(
+          [=](Unused, std::shared_ptr<folly::IOBuf> body, Unused, Unused) {
+            auto len = body->computeChainDataLength();
+            EXPECT_EQ(len, bodySize);
+            return len;
+          }));
+  EXPECT_CALL(transport_, sendEOM(&sink, _));
+  sink.onWriteReady(2 * bodySize, 1);
+}
+
 /**
  * Testing that we're sending a window update for simple requests
  */
@@ -256,6 +608,37 @@ TEST_F(DownstreamTransactionTest, NoWindowUpdateAfterDoneSending) {
   EXPECT_EQ(transactionTimeouts_->count(), 0);
 }
 
+/**
+ * Test that refreshing an already-scheduled idle timeout does not touch
+ * the wheel, and that expiry re-arms for the remaining interval when
+ * there was activity since the timer was scheduled.
+ */
+TEST_F(DownstreamTransactionTest, LazyIdleTimeoutRefresh) {
+  HTTPTransaction txn(TransportDirection::DOWNSTREAM,
+                      HTTPCodec::StreamID(1),
+                      1,
+                      transport_,
+                      txnEgressQueue_,
+                      transactionTimeouts_.get(),
+                      std::chrono::milliseconds(100));
+  txn.refreshTimeout();
+  EXPECT_EQ(transactionTimeouts_->count(), 1);
+  // while scheduled, refresh is a timestamp store, not a reschedule
+  txn.refreshTimeout();
+  EXPECT_EQ(transactionTimeouts_->count(), 1);
+
+  std::chrono::steady_clock::time_point firedAt;
+  EXPECT_CALL(transport_, transactionTimeout(&txn))
+      .WillOnce(InvokeWithoutArgs(
+          [&] { firedAt = std::chrono::steady_clock::now(); }));
+  const auto start = std::chrono::steady_clock::now();
+  // activity just before the original deadline: the first expiry must
+  // re-arm for the remainder instead of timing the transaction out
+  eventBase_.runAfterDelay([&] { txn.refreshTimeout(); }, 60);
+  eventBase_.loop();
+  EXPECT_GE(firedAt - start, std::chrono::milliseconds(140));
+}
+
 /**
  * Testing window increase using window update; we're actually using this in
  * production to avoid bumping the window using the SETTINGS frame
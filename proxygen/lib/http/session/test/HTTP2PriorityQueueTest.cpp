@@ -120,6 +120,14 @@ class QueueTest : public testing::Test {
         std::bind(&QueueTest::visitNode, this, _1, _2, _3, _4), stopFn, true);
   }
 
+  void setDeadline(HTTPCodec::StreamID id, TimePoint deadline) {
+    q_.updateEgressDeadline(handles_[id], deadline);
+  }
+
+  void clearDeadline(HTTPCodec::StreamID id) {
+    q_.clearEgressDeadline(handles_[id]);
+  }
+
   void nextEgress(bool spdyMode = false) {
     HTTP2PriorityQueue::NextEgressResult nextEgressResults;
     q_.nextEgress(nextEgressResults, spdyMode);
@@ -718,6 +726,175 @@ TEST_F(QueueTest, AddOrUpdate) {
   EXPECT_EQ(nodes_, IDList({{0, 20}, {3, 80}}));
 }
 
+TEST_F(QueueTest, UrgencyModeBasic) {
+  q_.enableUrgencyScheduling();
+  // weight 255 maps to urgency 0, the default weight 15 to urgency 3 and
+  // weight 0 to urgency 7
+  addTransaction(1, {kRootNodeId, false, 15});
+  addTransaction(3, {kRootNodeId, false, 255});
+  addTransaction(5, {kRootNodeId, false, 255});
+  addTransaction(7, {kRootNodeId, false, 0});
+
+  // Only the most urgent non-empty bucket egresses, shared equally
+  nextEgress();
+  EXPECT_EQ(nodes_, IDList({{3, 50}, {5, 50}}));
+
+  signalEgress(3, false);
+  signalEgress(5, false);
+  nextEgress();
+  EXPECT_EQ(nodes_, IDList({{1, 100}}));
+
+  signalEgress(1, false);
+  nextEgress();
+  EXPECT_EQ(nodes_, IDList({{7, 100}}));
+
+  removeTransaction(7);
+  EXPECT_TRUE(q_.empty());
+}
+
+TEST_F(QueueTest, UrgencyModeRoundRobin) {
+  q_.enableUrgencyScheduling();
+  addTransaction(1, {kRootNodeId, false, 255});
+  addTransaction(3, {kRootNodeId, false, 255});
+
+  // successive calls rotate the bucket
+  nextEgress();
+  EXPECT_EQ(nodes_, IDList({{1, 50}, {3, 50}}));
+  nextEgress();
+  EXPECT_EQ(nodes_, IDList({{3, 50}, {1, 50}}));
+  nextEgress();
+  EXPECT_EQ(nodes_, IDList({{1, 50}, {3, 50}}));
+}
+
+TEST_F(QueueTest, UrgencyModeUpdate) {
+  q_.enableUrgencyScheduling();
+  addTransaction(1, {kRootNodeId, false, 15});
+  addTransaction(3, {kRootNodeId, false, 15});
+  nextEgress();
+  EXPECT_EQ(nodes_, IDList({{1, 50}, {3, 50}}));
+
+  // promoting stream 3 to urgency 0 starves stream 1
+  q_.updateUrgency(3, 0);
+  nextEgress();
+  EXPECT_EQ(nodes_, IDList({{3, 100}}));
+
+  // dependency-style updates map the weight onto an urgency and ignore the
+  // requested parent
+  updatePriority(3, {1, false, 15});
+  nextEgress();
+  EXPECT_EQ(nodes_, IDList({{1, 50}, {3, 50}}));
+}
+
+TEST_F(QueueTest, EgressDeadlineTiebreak) {
+  addTransaction(1, {kRootNodeId, false, 15});
+  addTransaction(3, {kRootNodeId, false, 15});
+  addTransaction(5, {kRootNodeId, false, 15});
+
+  // Equal weights; deadlines break the tie, deadline-free streams go last
+  auto now = getCurrentTime();
+  setDeadline(3, now + std::chrono::milliseconds(100));
+  setDeadline(5, now + std::chrono::milliseconds(10));
+  nextEgress();
+  EXPECT_EQ(nodes_, IDList({{5, 33}, {3, 33}, {1, 33}}));
+
+  // Clearing stream 5's deadline lets stream 3 go first
+  clearDeadline(5);
+  nextEgress();
+  EXPECT_EQ(nodes_.front(), std::make_pair(HTTPCodec::StreamID(3), uint8_t(33)));
+}
+
+TEST_F(QueueTest, EgressDeadlineInheritance) {
+  addTransaction(1, {kRootNodeId, false, 15});
+  addTransaction(3, {1, false, 15});
+  addTransaction(5, {kRootNodeId, false, 15});
+  addTransaction(7, {5, false, 15});
+
+  // A deadline on stream 5 is inherited by its dependent stream 7
+  auto now = getCurrentTime();
+  setDeadline(5, now + std::chrono::milliseconds(100));
+  signalEgress(1, false);
+  signalEgress(5, false);
+  nextEgress();
+  EXPECT_EQ(nodes_, IDList({{7, 50}, {3, 50}}));
+
+  // An earlier deadline of its own puts stream 3 ahead
+  setDeadline(3, now + std::chrono::milliseconds(10));
+  nextEgress();
+  EXPECT_EQ(nodes_, IDList({{3, 50}, {7, 50}}));
+}
+
+TEST_F(QueueTest, UrgencyModeDeadline) {
+  q_.enableUrgencyScheduling();
+  addTransaction(1, {kRootNodeId, false, 255});
+  addTransaction(3, {kRootNodeId, false, 255});
+
+  // A deadline pins stream 3 to the front of its bucket across rotations
+  setDeadline(3, getCurrentTime() + std::chrono::milliseconds(10));
+  nextEgress();
+  EXPECT_EQ(nodes_, IDList({{3, 50}, {1, 50}}));
+  nextEgress();
+  EXPECT_EQ(nodes_, IDList({{3, 50}, {1, 50}}));
+
+  // Without it, round-robin order resumes
+  clearDeadline(3);
+  nextEgress();
+  EXPECT_EQ(nodes_, IDList({{1, 50}, {3, 50}}));
+}
+
+TEST_F(QueueTest, BandEgressAccounting) {
+  q_.enableUrgencyScheduling();
+  addTransaction(1, {kRootNodeId, false, 255}); // band 0
+  addTransaction(3, {kRootNodeId, false, 15});  // band 3
+
+  q_.recordEgressBytes(1, 1000);
+  q_.recordEgressBytes(3, 500);
+  q_.recordEgressBytes(3, 250);
+  EXPECT_EQ(q_.getBandEgressStats(0).bytes, 1000);
+  EXPECT_EQ(q_.getBandEgressStats(3).bytes, 750);
+
+  // Unknown streams and empty writes are ignored
+  q_.recordEgressBytes(99, 1000);
+  q_.recordEgressBytes(1, 0);
+  EXPECT_EQ(q_.getBandEgressStats(0).bytes, 1000);
+
+  signalEgress(1, false);
+  EXPECT_EQ(q_.getBandEgressStats(0).dequeues, 1);
+}
+
+TEST_F(QueueTest, BandEgressAccountingTreeMode) {
+  // In tree mode bytes are attributed to the band the stream's weight
+  // would map to under urgency scheduling
+  addTransaction(1, {kRootNodeId, false, 255});
+  addTransaction(3, {kRootNodeId, false, 15});
+  q_.recordEgressBytes(1, 100);
+  q_.recordEgressBytes(3, 100);
+  EXPECT_EQ(q_.getBandEgressStats(0).bytes, 100);
+  EXPECT_EQ(q_.getBandEgressStats(3).bytes, 100);
+}
+
+TEST_F(QueueTest, UrgencyModeStarvationGuard) {
+  q_.enableUrgencyScheduling();
+  q_.setMinimumLowBandShare(0.1);
+  addTransaction(1, {kRootNodeId, false, 255}); // band 0
+  addTransaction(3, {kRootNodeId, false, 0});   // band 7
+
+  // Below the accounting floor the guard stays out of the way
+  q_.recordEgressBytes(1, 1024);
+  nextEgress();
+  EXPECT_EQ(nodes_, IDList({{1, 100}}));
+
+  // Once band 0 has monopolized enough bytes, the lowest band gets a turn
+  q_.recordEgressBytes(1, 128 * 1024);
+  nextEgress();
+  EXPECT_EQ(nodes_, IDList({{3, 100}}));
+  EXPECT_EQ(q_.getBandEgressStats(7).starvationRounds, 1);
+
+  // Giving band 7 its share restores normal ordering
+  q_.recordEgressBytes(3, 32 * 1024);
+  nextEgress();
+  EXPECT_EQ(nodes_, IDList({{1, 100}}));
+}
+
 class DanglingQueueTestBase {
  public:
   DanglingQueueTestBase() {
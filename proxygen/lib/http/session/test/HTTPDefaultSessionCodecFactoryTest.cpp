@@ -100,6 +100,51 @@ TEST(HTTPDefaultSessionCodecFactoryTest, GetCodecUpgradeProtocols) {
   EXPECT_TRUE(downstreamCodec->getAllowedUpgradeProtocols().empty());
 }
 
+TEST(HTTPDefaultSessionCodecFactoryTest, GetCodecJoinedUpgradeProtocols) {
+  AcceptorConfiguration conf;
+  conf.allowedPlaintextUpgradeProtocols = {"spdy/3",
+                                           http2::kProtocolCleartextString};
+  HTTPDefaultSessionCodecFactory factory(conf);
+
+  // The list is joined once at factory construction; every plaintext
+  // codec gets the same comma-separated string.
+  auto codec =
+      factory.getCodec("http/1.1", TransportDirection::DOWNSTREAM, false);
+  HTTP1xCodec* downstreamCodec = dynamic_cast<HTTP1xCodec*>(codec.get());
+  EXPECT_NE(downstreamCodec, nullptr);
+  EXPECT_EQ(downstreamCodec->getAllowedUpgradeProtocols(), "spdy/3,h2c");
+}
+
+TEST(HTTPDefaultSessionCodecFactoryTest, ClassifyNextProtocol) {
+  using NextProtocol = HTTPDefaultSessionCodecFactory::NextProtocol;
+  EXPECT_EQ(HTTPDefaultSessionCodecFactory::classifyNextProtocol(""),
+            NextProtocol::HTTP_1_X);
+  EXPECT_EQ(HTTPDefaultSessionCodecFactory::classifyNextProtocol("http/1.0"),
+            NextProtocol::HTTP_1_X);
+  EXPECT_EQ(HTTPDefaultSessionCodecFactory::classifyNextProtocol("http/1.1"),
+            NextProtocol::HTTP_1_X);
+  EXPECT_EQ(HTTPDefaultSessionCodecFactory::classifyNextProtocol("spdy/3"),
+            NextProtocol::SPDY_3);
+  EXPECT_EQ(HTTPDefaultSessionCodecFactory::classifyNextProtocol("spdy/3.1"),
+            NextProtocol::SPDY_3_1);
+  EXPECT_EQ(HTTPDefaultSessionCodecFactory::classifyNextProtocol("h2"),
+            NextProtocol::HTTP_2);
+  EXPECT_EQ(HTTPDefaultSessionCodecFactory::classifyNextProtocol("h2-14"),
+            NextProtocol::HTTP_2);
+  EXPECT_EQ(HTTPDefaultSessionCodecFactory::classifyNextProtocol("h2-fb"),
+            NextProtocol::HTTP_2);
+  EXPECT_EQ(
+      HTTPDefaultSessionCodecFactory::classifyNextProtocol("not/supported"),
+      NextProtocol::UNKNOWN);
+  // same length as "h2", "spdy/3" and "http/1.1" but different tokens
+  EXPECT_EQ(HTTPDefaultSessionCodecFactory::classifyNextProtocol("h3"),
+            NextProtocol::UNKNOWN);
+  EXPECT_EQ(HTTPDefaultSessionCodecFactory::classifyNextProtocol("spdy/9"),
+            NextProtocol::UNKNOWN);
+  EXPECT_EQ(HTTPDefaultSessionCodecFactory::classifyNextProtocol("http/9.9"),
+            NextProtocol::UNKNOWN);
+}
+
 TEST(HTTPDefaultSessionCodecFactoryTest, GetCodec) {
   AcceptorConfiguration conf;
   HTTPDefaultSessionCodecFactory factory(conf);
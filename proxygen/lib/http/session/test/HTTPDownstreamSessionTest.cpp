@@ -23,6 +23,8 @@
 #include <proxygen/lib/http/session/HTTPDirectResponseHandler.h>
 #include <proxygen/lib/http/session/HTTPDownstreamSession.h>
 #include <proxygen/lib/http/session/HTTPSession.h>
+#include <proxygen/lib/http/session/HTTPSessionMemoryLedger.h>
+#include <proxygen/lib/http/session/IngressPriorityScheduler.h>
 #include <proxygen/lib/http/session/test/HTTPSessionMocks.h>
 #include <proxygen/lib/http/session/test/HTTPSessionTest.h>
 #include <proxygen/lib/http/session/test/HTTPTransactionMocks.h>
@@ -643,6 +645,47 @@ TEST_F(HTTPDownstreamSessionTest, Http10NoHeadersEof) {
   flushRequestsAndLoop(true, milliseconds(0));
 }
 
+TEST_F(HTTPDownstreamSessionTest, BulkIngressDeferredAndServed) {
+  // A bulk-classified session parses in the scheduler's end-of-iteration
+  // pass instead of inline; requests are still fully served
+  IngressPriorityScheduler scheduler(&eventBase_, 64 * 1024);
+  httpSession_->setBulkIngressScheduler(&scheduler);
+
+  InSequence enforceOrder;
+  auto handler1 = addSimpleNiceHandler();
+  handler1->expectHeaders();
+  handler1->expectEOM([&handler1] { handler1->sendReplyWithBody(200, 100); });
+  handler1->expectDetachTransaction();
+  auto handler2 = addSimpleNiceHandler();
+  handler2->expectHeaders();
+  handler2->expectEOM([&handler2] { handler2->sendReplyWithBody(200, 100); });
+  handler2->expectDetachTransaction();
+
+  sendRequest();
+  sendRequest();
+  flushRequestsAndLoop();
+  expectResponses(2);
+  gracefulShutdown();
+}
+
+TEST_F(HTTPDownstreamSessionTest, BulkIngressByteBudgetCarries) {
+  // A per-tick budget smaller than the request forces the parse to span
+  // several iterations; leftovers carry and the request still completes
+  IngressPriorityScheduler scheduler(&eventBase_, 16);
+  httpSession_->setBulkIngressScheduler(&scheduler);
+
+  InSequence enforceOrder;
+  auto handler = addSimpleNiceHandler();
+  handler->expectHeaders();
+  handler->expectEOM([&handler] { handler->sendReplyWithBody(200, 100); });
+  handler->expectDetachTransaction();
+
+  sendRequest();
+  flushRequestsAndLoop();
+  expectResponse();
+  gracefulShutdown();
+}
+
 TEST_F(HTTPDownstreamSessionTest, SingleBytes) {
   InSequence enforceOrder;
 
@@ -673,6 +716,32 @@ TEST_F(HTTPDownstreamSessionTest, SingleBytes) {
   eventBase_.loop();
 }
 
+TEST_F(HTTPDownstreamSessionTest, SingleBytesIngressBatching) {
+  // Same as SingleBytes, but with the reads of one loop iteration batched
+  // into a single codec pass; the parsed message must come out identical
+  InSequence enforceOrder;
+  httpSession_->setIngressBatchingEnabled(true);
+
+  auto handler = addSimpleNiceHandler();
+  handler->expectHeaders([&](std::shared_ptr<HTTPMessage> msg) {
+    const HTTPHeaders& hdrs = msg->getHeaders();
+    EXPECT_EQ(2, hdrs.size());
+    EXPECT_TRUE(hdrs.exists("host"));
+    EXPECT_TRUE(hdrs.exists("connection"));
+    EXPECT_EQ("/somepath.php?param=foo", msg->getURL());
+  });
+  onEOMTerminateHandlerExpectShutdown(*handler);
+
+  addSingleByteReads(
+      "GET /somepath.php?param=foo HTTP/1.1\r\n"
+      "Host: example.com\r\n"
+      "Connection: close\r\n"
+      "\r\n");
+  transport_->addReadEOF(milliseconds(0));
+  transport_->startReadEvents();
+  eventBase_.loop();
+}
+
 TEST_F(HTTPDownstreamSessionTest, SingleBytesWithBody) {
   InSequence enforceOrder;
 
@@ -1237,6 +1306,101 @@ TEST_F(HTTPDownstreamSessionTest, HttpWithAckTimingPipeline) {
   gracefulShutdown();
 }
 
+TEST_F(HTTPDownstreamSessionTest, ParseBudgetPipelineBurst) {
+  // More pipelined requests in one flush than one processReadData pass's
+  // parse budget allows; the tail is requeued across loop ticks and every
+  // request still gets served in order
+  constexpr uint32_t kRequests = 80;
+  InSequence enforceOrder;
+  std::vector<std::unique_ptr<testing::StrictMock<MockHTTPHandler>>> handlers;
+  handlers.reserve(kRequests);
+  for (uint32_t i = 0; i < kRequests; i++) {
+    auto handler = addSimpleStrictHandler();
+    handler->expectHeaders();
+    handler->expectEOM(
+        [h = handler.get()] { h->sendReplyWithBody(200, 10); });
+    handler->expectDetachTransaction();
+    handlers.emplace_back(std::move(handler));
+    sendRequest();
+  }
+  flushRequestsAndLoop();
+  expectResponses(kRequests);
+  gracefulShutdown();
+}
+
+TEST_F(HTTPDownstreamSessionTest, EgressReorderPipeline) {
+  // With an egress reorder limit set, pipelined requests are dispatched
+  // concurrently; the second handler's response is parked in the session
+  // until the first response is generated, and the wire order is still
+  // request order
+  httpSession_->setEgressReorderLimit(65536);
+  {
+    InSequence enforceOrder;
+    auto handler1 = addSimpleStrictHandler();
+    handler1->expectHeaders();
+    handler1->expectEOM([this, &handler1] {
+      // respond after the second handler has already finished
+      eventBase_.runAfterDelay(
+          [&handler1] { handler1->sendReplyWithBody(200, 100); },
+          10);
+    });
+    auto handler2 = addSimpleStrictHandler();
+    handler2->expectHeaders();
+    handler2->expectEOM([&handler2] { handler2->sendReplyWithBody(201, 50); });
+    handler2->expectDetachTransaction();
+    handler1->expectDetachTransaction();
+    sendRequest();
+    sendRequest();
+    flushRequestsAndLoop();
+
+    EXPECT_CALL(callbacks_, onHeadersComplete(_, _))
+        .WillOnce(
+            Invoke([](HTTPCodec::StreamID, std::shared_ptr<HTTPMessage> msg) {
+              EXPECT_EQ(msg->getStatusCode(), 200);
+            }));
+    EXPECT_CALL(callbacks_, onHeadersComplete(_, _))
+        .WillOnce(
+            Invoke([](HTTPCodec::StreamID, std::shared_ptr<HTTPMessage> msg) {
+              EXPECT_EQ(msg->getStatusCode(), 201);
+            }));
+    clientCodec_->setCallback(&callbacks_);
+    parseOutput(*clientCodec_);
+  }
+  gracefulShutdown();
+}
+
+TEST_F(HTTPDownstreamSessionTest, EgressReorderPipelineCap) {
+  // A parked response that crosses the reorder limit has its egress
+  // paused; it resumes once its predecessor's response lets the parked
+  // bytes flush
+  httpSession_->setEgressReorderLimit(10);
+  auto handler1 = addSimpleStrictHandler();
+  auto handler2 = addSimpleStrictHandler();
+  {
+    InSequence enforceOrder;
+    handler1->expectHeaders();
+    handler1->expectEOM([this, &handler1] {
+      eventBase_.runAfterDelay(
+          [&handler1] { handler1->sendReplyWithBody(200, 100); },
+          10);
+    });
+    handler2->expectHeaders();
+    handler2->expectEOM([&handler2] {
+      handler2->sendHeaders(200, 100);
+      handler2->sendBody(100);
+    });
+    handler2->expectEgressPaused();
+    handler2->expectEgressResumed([&handler2] { handler2->sendEOM(); });
+  }
+  handler1->expectDetachTransaction();
+  handler2->expectDetachTransaction();
+  sendRequest();
+  sendRequest();
+  flushRequestsAndLoop();
+  expectResponses(2);
+  gracefulShutdown();
+}
+
 TEST_F(HTTPDownstreamSessionTest, HttpWithAckTimingPipelineError) {
   HTTPDirectResponseHandler* errorHandler =
       new HTTPDirectResponseHandler(400, "Bad Request");
@@ -1325,6 +1489,30 @@ TEST_F(HTTPDownstreamSessionTest, HttpWithAckTimingConnError) {
   handler1->txn_->decrementPendingByteEvents();
 }
 
+TEST_F(HTTP2DownstreamSessionTest, MemoryLedger) {
+  HTTPSessionMemoryLedger::Budgets budgets;
+  budgets.pauseReadsBytes = 1;
+  HTTPSessionMemoryLedger ledger(budgets);
+  ledger.addSession(httpSession_);
+  EXPECT_EQ(ledger.getNumSessions(), 1);
+  EXPECT_GT(ledger.getTotalFootprint(), 0);
+
+  // Over the pause budget but no abort budget configured: reads pause
+  // but the session stays
+  EXPECT_EQ(ledger.enforce(),
+            HTTPSessionMemoryLedger::Enforcement::PAUSE_READS);
+  EXPECT_EQ(ledger.getNumSessions(), 1);
+
+  // With a 1-byte abort budget the session's own footprint exceeds it,
+  // so enforcement drops it as the costliest session
+  HTTPSessionMemoryLedger killer({1, 1, 1});
+  killer.addSession(httpSession_);
+  expectDetachSession();
+  EXPECT_EQ(killer.enforce(),
+            HTTPSessionMemoryLedger::Enforcement::ABORT_SESSIONS);
+  EXPECT_EQ(killer.getNumSessions(), 0);
+}
+
 TEST_F(HTTP2DownstreamSessionTest, TestPing) {
   // send a request with a PING, should get the PING first
   auto handler = addSimpleStrictHandler();
@@ -2031,6 +2219,92 @@ TEST_F(HTTPDownstreamSessionTest, HttpRateLimitNormal) {
   cleanup();
 }
 
+TEST_F(HTTPDownstreamSessionTest, HttpSessionPacingNormal) {
+  // Pace the whole session instead of one transaction
+  uint32_t pacingRate_kbps = 640;
+  httpSession_->setEgressPacingRate(pacingRate_kbps * 1024);
+
+  sendRequest();
+
+  InSequence handlerSequence;
+
+  auto handler1 = addSimpleNiceHandler();
+  handler1->expectHeaders();
+  // Send a somewhat big response that we know will get paced
+  handler1->expectEOM([&handler1] {
+    // At 640kbps, this should take slightly over 800ms
+    uint32_t rspLengthBytes = 100000;
+    handler1->sendHeaders(200, rspLengthBytes);
+    handler1->sendBody(rspLengthBytes);
+    handler1->txn_->sendEOM();
+  });
+  handler1->expectDetachTransaction();
+
+  // Keep the session around even after the event base loop completes so we can
+  // read the counters on a valid object.
+  HTTPSession::DestructorGuard g(httpSession_);
+  flushRequestsAndLoop();
+
+  proxygen::TimePoint timeFirstWrite =
+      transport_->getWriteEvents()->front()->getTime();
+  proxygen::TimePoint timeLastWrite =
+      transport_->getWriteEvents()->back()->getTime();
+  int64_t writeDuration =
+      (int64_t)millisecondsBetween(timeLastWrite, timeFirstWrite).count();
+  EXPECT_GE(writeDuration, 800);
+
+  cleanup();
+}
+
+TEST_F(HTTPDownstreamSessionTest, TlsRecordSizeRamp) {
+  // The acceptor only applies the policy to TLS sessions; set it directly
+  // here to exercise the ramp itself
+  httpSession_->setTLSRecordSizePolicy(
+      1400, 16384, 8192, std::chrono::seconds(1));
+
+  sendRequest();
+
+  InSequence handlerSequence;
+  auto handler1 = addSimpleNiceHandler();
+  handler1->expectHeaders();
+  handler1->expectEOM([&handler1] {
+    uint32_t rspLengthBytes = 60000;
+    handler1->sendHeaders(200, rspLengthBytes);
+    handler1->sendBody(rspLengthBytes);
+    handler1->txn_->sendEOM();
+  });
+  handler1->expectDetachTransaction();
+
+  HTTPSession::DestructorGuard g(httpSession_);
+  flushRequestsAndLoop();
+
+  auto eventLength = [](const auto& event) {
+    size_t len = 0;
+    for (size_t i = 0; i < event->getCount(); i++) {
+      len += event->getIoVec()[i].iov_len;
+    }
+    return len;
+  };
+  const auto& writeEvents = *transport_->getWriteEvents();
+  ASSERT_GE(writeEvents.size(), 3);
+  // the first writes fit the initial record budget, doubling as the
+  // connection proves itself; once past the bulk threshold the cap lifts
+  EXPECT_LE(eventLength(writeEvents[0]), 1400);
+  EXPECT_LE(eventLength(writeEvents[1]), 2800);
+  size_t total = 0;
+  size_t maxWrite = 0;
+  for (const auto& event : writeEvents) {
+    auto len = eventLength(event);
+    total += len;
+    maxWrite = std::max(maxWrite, len);
+  }
+  EXPECT_GE(total, 60000);
+  // the ramp unlocked writes larger than the initial budget
+  EXPECT_GT(maxWrite, 1400);
+
+  cleanup();
+}
+
 TEST_F(SPDY3DownstreamSessionTest, SpdyRateLimitNormal) {
   // The rate-limiting code grabs the event base from the EventBaseManager,
   // so we need to set it.
@@ -4134,6 +4408,37 @@ TEST_F(HTTP2DownstreamSessionTest, TestTransactionNotStallByFlowControl) {
   gracefulShutdown();
 }
 
+TEST_F(HTTP2DownstreamSessionTest, TestBatchedSessionStats) {
+  StrictMock<MockHTTPSessionStats> stats;
+
+  httpSession_->setSessionStats(&stats);
+  httpSession_->enableBatchedSessionStats();
+
+  sendRequest();
+  sendRequest();
+
+  // With batching enabled the hot-path records accumulate in a flat
+  // counter block.  The mock sink does not override the batch record, so
+  // the default implementation replays the counts through the per-event
+  // records at flush time - same totals, delivered at tick boundaries.
+  EXPECT_CALL(stats, recordTransactionOpened()).Times(2);
+  EXPECT_CALL(stats, recordSessionReused());
+  EXPECT_CALL(stats, recordTransactionClosed()).Times(2);
+
+  InSequence handlerSequence;
+  auto handler1 = addSimpleStrictHandler();
+  handler1->expectHeaders();
+  handler1->expectEOM([&] { handler1->sendReplyWithBody(200, 100); });
+  auto handler2 = addSimpleStrictHandler();
+  handler2->expectHeaders();
+  handler2->expectEOM([&] { handler2->sendReplyWithBody(200, 100); });
+  handler1->expectDetachTransaction();
+  handler2->expectDetachTransaction();
+
+  flushRequestsAndLoop();
+  gracefulShutdown();
+}
+
 TEST_F(HTTP2DownstreamSessionTest, TestSetEgressSettings) {
   SettingsList settings = {{SettingsId::HEADER_TABLE_SIZE, 5555},
                            {SettingsId::MAX_FRAME_SIZE, 16384},
@@ -4249,6 +4554,27 @@ TEST_F(HTTP2DownstreamSessionTest, PingProbes) {
   flushRequestsAndLoopN(1);
 }
 
+TEST_F(HTTP2DownstreamSessionTest, RTTSampleFromPingReply) {
+  // With sampling enabled, the probe the prober sends anyway gets
+  // clocked against its reply and seeds the session RTT estimate
+  httpSession_->enableRTTSampling(std::chrono::milliseconds(100));
+  EXPECT_FALSE(httpSession_->getSessionRTT().has_value());
+  httpSession_->enablePingProbes(std::chrono::seconds(1),
+                                 std::chrono::seconds(1),
+                                 /*extendIntervalOnIngress=*/true,
+                                 /*immediate=*/true);
+  eventBase_.loopOnce();
+  uint64_t pingVal = 0;
+  EXPECT_CALL(callbacks_, onPingRequest(_)).WillOnce(SaveArg<0>(&pingVal));
+  parseOutput(*clientCodec_);
+  clientCodec_->generatePingReply(requests_, pingVal);
+  flushRequestsAndLoopN(1);
+  EXPECT_TRUE(httpSession_->getSessionRTT().has_value());
+  httpSession_->closeWhenIdle();
+  expectDetachSession();
+  flushRequestsAndLoopN(1);
+}
+
 TEST_F(HTTP2DownstreamSessionTest, PingProbeTimeout) {
   // Send an immediate ping probe, but don't reply.  Connection is dropped.
   httpSession_->enablePingProbes(std::chrono::seconds(1),
@@ -4334,3 +4660,39 @@ TEST_F(HTTP2DownstreamSessionTest, CancelPingProbesOnRequest) {
   EXPECT_EQ(httpSession_->getConnectionCloseReason(),
             ConnectionCloseReason::TIMEOUT);
 }
+
+TEST_F(HTTP2DownstreamSessionTest, IdleLivenessProbeReapsDead) {
+  // Idle session, nobody answers the probe: reaped after the initial
+  // interval plus the ack timeout
+  httpSession_->enableIdleLivenessProbes(std::chrono::seconds(1),
+                                         std::chrono::seconds(8),
+                                         std::chrono::seconds(1));
+  proxygen::TimePoint start = getCurrentTime();
+  expectDetachSession();
+  flushRequestsAndLoop();
+  EXPECT_CALL(callbacks_, onPingRequest(_));
+  parseOutput(*clientCodec_);
+  auto duration = millisecondsBetween(getCurrentTime(), start);
+  EXPECT_GE(duration.count(), 2000);
+}
+
+TEST_F(HTTP2DownstreamSessionTest, IdleLivenessProbeAckBacksOff) {
+  // Answer the first probe; the connection survives and the next probe
+  // backs off to 2s, so closing at 1.5s sees exactly one probe
+  httpSession_->enableIdleLivenessProbes(std::chrono::seconds(1),
+                                         std::chrono::seconds(8),
+                                         std::chrono::seconds(1));
+  eventBase_.runAfterDelay(
+      [this] {
+        uint64_t pingVal = 0;
+        EXPECT_CALL(callbacks_, onPingRequest(_))
+            .WillOnce(SaveArg<0>(&pingVal));
+        parseOutput(*clientCodec_);
+        clientCodec_->generatePingReply(requests_, pingVal);
+        flushRequests();
+      },
+      1250);
+  eventBase_.runAfterDelay([this] { httpSession_->closeWhenIdle(); }, 1500);
+  expectDetachSession();
+  flushRequestsAndLoop();
+}
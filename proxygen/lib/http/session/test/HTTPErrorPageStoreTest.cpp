@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/http/session/HTTPErrorPageStore.h>
+
+#include <folly/io/IOBuf.h>
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+
+namespace {
+
+HTTPErrorPageStore::PageContent makePage(unsigned statusCode,
+                                         size_t bodyBytes) {
+  HTTPErrorPageStore::PageContent page;
+  page.statusCode = statusCode;
+  page.contentType = "text/html; charset=utf-8";
+  // repetitive enough that both gzip and zstd shrink it
+  page.content = folly::IOBuf::create(bodyBytes);
+  memset(page.content->writableData(), 'e', bodyBytes);
+  page.content->append(bodyBytes);
+  return page;
+}
+
+} // namespace
+
+TEST(HTTPErrorPageStoreTest, LookupWithDefaultFallback) {
+  HTTPErrorPageStore store;
+  EXPECT_EQ(store.getPage(503), nullptr);
+  EXPECT_EQ(store.getVersion(), 0);
+
+  std::vector<HTTPErrorPageStore::PageContent> pages;
+  pages.push_back(makePage(0, 512));
+  pages.push_back(makePage(503, 1024));
+  store.setPages(std::move(pages));
+  EXPECT_EQ(store.getVersion(), 1);
+
+  auto overloaded = store.getPage(503);
+  ASSERT_NE(overloaded, nullptr);
+  EXPECT_EQ(overloaded->identity->computeChainDataLength(), 1024);
+  // unknown status falls back to the catch-all page
+  auto fallback = store.getPage(404);
+  ASSERT_NE(fallback, nullptr);
+  EXPECT_EQ(fallback->identity->computeChainDataLength(), 512);
+  // acceptors share the rendered page by reference
+  EXPECT_EQ(store.getPage(503).get(), overloaded.get());
+}
+
+TEST(HTTPErrorPageStoreTest, PrecompressedVariantSelection) {
+  HTTPErrorPageStore store;
+  std::vector<HTTPErrorPageStore::PageContent> pages;
+  pages.push_back(makePage(503, 4096));
+  store.setPages(std::move(pages));
+
+  auto page = store.getPage(503);
+  ASSERT_NE(page, nullptr);
+  ASSERT_NE(page->gzip, nullptr);
+  ASSERT_NE(page->zstd, nullptr);
+  EXPECT_LT(page->gzip->computeChainDataLength(), 4096);
+  EXPECT_LT(page->zstd->computeChainDataLength(), 4096);
+
+  auto gzip = HTTPErrorPageStore::selectVariant(*page, "gzip, deflate");
+  EXPECT_EQ(gzip.first, "gzip");
+  EXPECT_EQ(gzip.second, page->gzip.get());
+
+  // smallest admissible form wins when the client takes several
+  auto both = HTTPErrorPageStore::selectVariant(*page, "gzip, zstd");
+  EXPECT_TRUE(both.first == "gzip" || both.first == "zstd");
+
+  auto identity = HTTPErrorPageStore::selectVariant(*page, "");
+  EXPECT_EQ(identity.first, "");
+  EXPECT_EQ(identity.second, page->identity.get());
+  EXPECT_EQ(HTTPErrorPageStore::selectVariant(*page, "br").second,
+            page->identity.get());
+  // a q-value of zero declines the coding
+  EXPECT_EQ(HTTPErrorPageStore::selectVariant(*page, "gzip;q=0").second,
+            page->identity.get());
+}
+
+TEST(HTTPErrorPageStoreTest, HotReloadKeepsServedSnapshots) {
+  HTTPErrorPageStore store;
+  std::vector<HTTPErrorPageStore::PageContent> pages;
+  pages.push_back(makePage(500, 256));
+  store.setPages(std::move(pages));
+
+  auto held = store.getPage(500);
+  ASSERT_NE(held, nullptr);
+
+  std::vector<HTTPErrorPageStore::PageContent> reload;
+  reload.push_back(makePage(500, 2048));
+  store.setPages(std::move(reload));
+  EXPECT_EQ(store.getVersion(), 2);
+
+  // the in-flight response keeps pre-reload content; new lookups see
+  // the reloaded page
+  EXPECT_EQ(held->identity->computeChainDataLength(), 256);
+  EXPECT_EQ(store.getPage(500)->identity->computeChainDataLength(), 2048);
+}
+
+TEST(HTTPErrorPageStoreTest, StoreErrorPageAdapter) {
+  HTTPErrorPageStore store;
+  std::vector<HTTPErrorPageStore::PageContent> pages;
+  pages.push_back(makePage(503, 4096));
+  store.setPages(std::move(pages));
+
+  HTTPStoreErrorPage errorPage(store);
+  EXPECT_FALSE(errorPage.isStatic());
+
+  auto identity = errorPage.generate(0, 503, "", nullptr, "");
+  EXPECT_EQ(identity.contentEncoding, "");
+  EXPECT_EQ(identity.content->computeChainDataLength(), 4096);
+
+  auto compressed = errorPage.generateFor(0, 503, "", nullptr, "", "gzip");
+  EXPECT_EQ(compressed.contentEncoding, "gzip");
+  EXPECT_LT(compressed.content->computeChainDataLength(), 4096);
+}
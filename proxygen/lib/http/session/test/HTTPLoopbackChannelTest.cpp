@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/io/async/EventBase.h>
+#include <proxygen/lib/http/session/HTTPLoopbackChannel.h>
+#include <proxygen/lib/http/session/test/HTTPSessionMocks.h>
+
+using namespace proxygen;
+using namespace testing;
+
+class HTTPLoopbackChannelTest : public testing::Test {
+ public:
+  void SetUp() override {
+    clientHandler_.expectTransaction();
+    serverHandler_.expectTransaction();
+    channel_ = HTTPLoopbackChannel::create(&eventBase_,
+                                           transactionTimeouts_.get(),
+                                           &clientHandler_,
+                                           &serverHandler_);
+  }
+
+  HTTPMessage makeGetRequest() {
+    HTTPMessage req;
+    req.setMethod(HTTPMethod::GET);
+    req.setHTTPVersion(1, 1);
+    req.setURL("/loopback");
+    req.getHeaders().add("X-Internal-Call", "1");
+    return req;
+  }
+
+ protected:
+  folly::EventBase eventBase_;
+  folly::HHWheelTimer::UniquePtr transactionTimeouts_{
+      folly::HHWheelTimer::newTimer(
+          &eventBase_,
+          std::chrono::milliseconds(folly::HHWheelTimer::DEFAULT_TICK_INTERVAL),
+          folly::AsyncTimeout::InternalEnum::NORMAL,
+          std::chrono::milliseconds(500))};
+  StrictMock<MockHTTPHandler> clientHandler_;
+  StrictMock<MockHTTPHandler> serverHandler_;
+  std::unique_ptr<HTTPLoopbackChannel> channel_;
+};
+
+// A full request/response exchange: the server sees the request headers
+// without any codec round trip, the request body arrives in the same
+// buffer the client sent, and both transactions detach cleanly.
+TEST_F(HTTPLoopbackChannelTest, FullExchange) {
+  auto body = folly::IOBuf::copyBuffer(std::string(1000, 'a'));
+  const uint8_t* bodyData = body->data();
+
+  serverHandler_.expectHeaders([&](std::shared_ptr<HTTPMessage> msg) {
+    EXPECT_EQ(msg->getURL(), "/loopback");
+    EXPECT_EQ(msg->getHeaders().getSingleOrEmpty("X-Internal-Call"), "1");
+  });
+  serverHandler_.expectBody(
+      [&](uint64_t, std::shared_ptr<folly::IOBuf> chain) {
+        // Zero-copy: the server reads the client's buffer
+        EXPECT_EQ(chain->data(), bodyData);
+        EXPECT_EQ(chain->computeChainDataLength(), 1000);
+      });
+  serverHandler_.expectEOM([&] {
+    serverHandler_.sendReplyWithBody(200, 100);
+  });
+  serverHandler_.expectDetachTransaction();
+
+  clientHandler_.expectHeaders([&](std::shared_ptr<HTTPMessage> msg) {
+    EXPECT_EQ(msg->getStatusCode(), 200);
+  });
+  clientHandler_.expectBody(
+      [&](uint64_t, std::shared_ptr<folly::IOBuf> chain) {
+        EXPECT_EQ(chain->computeChainDataLength(), 100);
+      });
+  clientHandler_.expectEOM();
+  clientHandler_.expectDetachTransaction();
+
+  bool completed = false;
+  channel_->setCompletionCallback([&] { completed = true; });
+
+  auto clientTxn = channel_->getClientTransaction();
+  clientTxn->sendHeaders(makeGetRequest());
+  clientTxn->sendBody(std::move(body));
+  clientTxn->sendEOM();
+  eventBase_.loop();
+
+  EXPECT_TRUE(channel_->isComplete());
+  EXPECT_TRUE(completed);
+}
+
+// A server-side abort surfaces on the client as a stream abort error.
+TEST_F(HTTPLoopbackChannelTest, AbortPropagatesToPeer) {
+  serverHandler_.expectHeaders([&] { serverHandler_.terminate(); });
+  serverHandler_.expectDetachTransaction();
+
+  clientHandler_.expectError([&](const HTTPException& ex) {
+    EXPECT_EQ(ex.getProxygenError(), kErrorStreamAbort);
+    ASSERT_TRUE(ex.hasCodecStatusCode());
+    EXPECT_EQ(ex.getCodecStatusCode(), ErrorCode::INTERNAL_ERROR);
+  });
+  clientHandler_.expectDetachTransaction();
+
+  channel_->getClientTransaction()->sendHeaders(makeGetRequest());
+  eventBase_.loop();
+
+  EXPECT_TRUE(channel_->isComplete());
+}
+
+// Destroying a live channel aborts the exchange with kErrorShutdown.
+TEST_F(HTTPLoopbackChannelTest, DestroyAbortsLiveExchange) {
+  serverHandler_.expectHeaders();
+  serverHandler_.expectError([&](const HTTPException& ex) {
+    EXPECT_EQ(ex.getProxygenError(), kErrorShutdown);
+  });
+  serverHandler_.expectDetachTransaction();
+
+  clientHandler_.expectError([&](const HTTPException& ex) {
+    EXPECT_EQ(ex.getProxygenError(), kErrorShutdown);
+  });
+  clientHandler_.expectDetachTransaction();
+
+  channel_->getClientTransaction()->sendHeaders(makeGetRequest());
+  eventBase_.loop();
+
+  channel_.reset();
+}
@@ -169,6 +169,41 @@ TEST_F(HTTPSessionAcceptorTestNPNJunk, Npn) {
   EXPECT_EQ(acceptor_->sessionCreationErrors_, 1);
 }
 
+// Verify the acceptor rebinds to published config snapshots on the
+// accept path, and that unchanged versions don't rebind
+TEST_F(HTTPSessionAcceptorTestNPN, DynamicConfigRebind) {
+  acceptor_->expectedProto_ = "http/1.1";
+
+  AcceptorConfiguration tuned(*config_);
+  tuned.transactionIdleTimeout = std::chrono::milliseconds(1234);
+  tuned.receiveSessionWindowSize = 1 << 20;
+  auto source = std::make_shared<DynamicAcceptorConfig>(std::move(tuned));
+  acceptor_->setDynamicConfig(source);
+
+  // First accept binds the source's initial snapshot
+  AsyncSocket::UniquePtr sock(new AsyncSocket(&eventBase_));
+  SocketAddress clientAddress;
+  wangle::TransportInfo tinfo;
+  acceptor_->connectionReady(
+      std::move(sock), clientAddress, "", SecureTransportType::NONE, tinfo);
+  EXPECT_EQ(acceptor_->sessionsCreated_, 1);
+  EXPECT_EQ(acceptor_->getConfig().transactionIdleTimeout,
+            std::chrono::milliseconds(1234));
+  EXPECT_EQ(acceptor_->getConfig().receiveSessionWindowSize, 1 << 20);
+
+  // Publish a retuned snapshot; the next accept picks it up
+  AcceptorConfiguration retuned(*source->getSnapshot());
+  retuned.transactionIdleTimeout = std::chrono::milliseconds(250);
+  source->update(std::move(retuned));
+
+  AsyncSocket::UniquePtr sock2(new AsyncSocket(&eventBase_));
+  acceptor_->connectionReady(
+      std::move(sock2), clientAddress, "", SecureTransportType::NONE, tinfo);
+  EXPECT_EQ(acceptor_->sessionsCreated_, 2);
+  EXPECT_EQ(acceptor_->getConfig().transactionIdleTimeout,
+            std::chrono::milliseconds(250));
+}
+
 TEST_F(HTTPSessionAcceptorTestNPN, AcceptorConfigCapture) {
   newAcceptor();
   config_.reset();
@@ -189,3 +189,15 @@ TEST_F(IngressStateMachineFixture, WeirdIngressTransitions) {
   follow(HTTPTransactionIngressSM::Event::onTrailers);
   follow(HTTPTransactionIngressSM::Event::onEOM);
 }
+
+TEST(StateMachineTryTransit, AppliesOnSuccessOnlyTouchesStateOnSuccess) {
+  auto state = HTTPTransactionEgressSM::getNewInstance();
+  // Invalid from Start: state must be left untouched
+  EXPECT_FALSE(HTTPTransactionEgressSM::tryTransit(
+      state, HTTPTransactionEgressSM::Event::sendBody));
+  EXPECT_EQ(state, HTTPTransactionEgressSM::State::Start);
+  // Valid: the single call both checks and applies
+  EXPECT_TRUE(HTTPTransactionEgressSM::tryTransit(
+      state, HTTPTransactionEgressSM::Event::sendHeaders));
+  EXPECT_EQ(state, HTTPTransactionEgressSM::State::HeadersSent);
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/http/session/IsolationGroup.h>
+
+#include <folly/io/async/EventBase.h>
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+using std::chrono::milliseconds;
+
+namespace {
+
+class ManualClock : public IsolationGroupSet::Clock {
+ public:
+  TimePoint now() override {
+    return now_;
+  }
+
+  void advance(milliseconds ms) {
+    now_ += ms;
+  }
+
+ private:
+  TimePoint now_{getCurrentTime()};
+};
+
+class TestParticipant : public IsolationGroup::Participant {
+ public:
+  void groupIngressUnblocked() noexcept override {
+    ++ingressFired;
+  }
+
+  void groupEgressUnblocked() noexcept override {
+    ++egressFired;
+  }
+
+  uint32_t ingressFired{0};
+  uint32_t egressFired{0};
+};
+
+} // namespace
+
+class IsolationGroupTest : public testing::Test {
+ protected:
+  folly::EventBase evb_;
+  ManualClock clock_;
+  // 1000 parse bytes and 4000 egress bytes per 10ms round
+  IsolationGroupSet set_{&evb_, 1000, 4000, milliseconds(10), &clock_};
+};
+
+TEST_F(IsolationGroupTest, WeightedQuanta) {
+  IsolationGroupConfig heavyConfig;
+  heavyConfig.weight = 3;
+  auto* heavy = set_.addGroup("heavy", heavyConfig);
+  auto* light = set_.addGroup("light", IsolationGroupConfig());
+
+  // Adding "light" rebalanced the shares; drain the initial bank and
+  // replenish one fresh round at 3:1
+  EXPECT_FALSE(heavy->chargeIngress(10000));
+  EXPECT_FALSE(light->chargeIngress(10000));
+  clock_.advance(milliseconds(10000));
+  heavy->chargeIngress(0);
+  light->chargeIngress(0);
+
+  // Banked deficit caps at kMaxRoundsBanked rounds of the group's
+  // weighted quantum: 750/round vs 250/round
+  EXPECT_TRUE(heavy->chargeIngress(1400));
+  EXPECT_FALSE(heavy->chargeIngress(100));
+  EXPECT_TRUE(light->chargeIngress(400));
+  EXPECT_FALSE(light->chargeIngress(100));
+}
+
+TEST_F(IsolationGroupTest, EgressAllowance) {
+  auto* group = set_.addGroup("tenant", IsolationGroupConfig());
+
+  // Sole group: the whole 4000/round budget, one round banked at start
+  EXPECT_EQ(group->egressAllowance(10000), 4000);
+  group->consumeEgress(4000);
+  EXPECT_EQ(group->egressAllowance(10000), 0);
+
+  clock_.advance(milliseconds(10));
+  EXPECT_EQ(group->egressAllowance(1500), 1500);
+  group->consumeEgress(1500);
+
+  auto util = group->getUtilization();
+  EXPECT_EQ(util.egressBytesSent, 5500);
+  EXPECT_EQ(util.egressStalls, 1);
+}
+
+TEST_F(IsolationGroupTest, OverdraftCarriesIntoNextRound) {
+  auto* group = set_.addGroup("tenant", IsolationGroupConfig());
+
+  // Charge well past the deficit, as the last buffer of a round can
+  EXPECT_FALSE(group->chargeIngress(2500));
+  // One round (1000) does not clear the 1500 debt...
+  clock_.advance(milliseconds(10));
+  EXPECT_FALSE(group->chargeIngress(0));
+  // ...but a second one does
+  clock_.advance(milliseconds(10));
+  EXPECT_TRUE(group->chargeIngress(0));
+}
+
+TEST_F(IsolationGroupTest, TransactionQuota) {
+  IsolationGroupConfig config;
+  config.maxConcurrentTransactions = 2;
+  auto* group = set_.addGroup("tenant", config);
+
+  EXPECT_FALSE(group->atTransactionQuota());
+  group->beginTransaction();
+  group->beginTransaction();
+  EXPECT_TRUE(group->atTransactionQuota());
+  group->recordTransactionRefused();
+  group->endTransaction();
+  EXPECT_FALSE(group->atTransactionQuota());
+
+  auto util = group->getUtilization();
+  EXPECT_EQ(util.activeTransactions, 1);
+  EXPECT_EQ(util.transactionsRefused, 1);
+}
+
+TEST_F(IsolationGroupTest, ParkedSessionsWakeOnReplenish) {
+  auto* group = set_.addGroup("tenant", IsolationGroupConfig());
+  TestParticipant participant;
+
+  EXPECT_FALSE(group->chargeIngress(1000));
+  EXPECT_EQ(group->egressAllowance(5000), 4000);
+  group->consumeEgress(5000); // the write grew past the allowance
+  group->waitForIngress(&participant);
+  group->waitForEgress(&participant);
+
+  // One round clears both deficits (1000 and -1000 + 4000), so the
+  // shared tick wakes both waits and stops ticking
+  clock_.advance(milliseconds(10));
+  evb_.loop();
+  EXPECT_EQ(participant.ingressFired, 1);
+  EXPECT_EQ(participant.egressFired, 1);
+
+  auto util = group->getUtilization();
+  EXPECT_EQ(util.ingressStalls, 1);
+  EXPECT_EQ(util.egressStalls, 0);
+}
+
+TEST_F(IsolationGroupTest, CancelWaits) {
+  auto* group = set_.addGroup("tenant", IsolationGroupConfig());
+  TestParticipant participant;
+
+  EXPECT_FALSE(group->chargeIngress(5000));
+  group->waitForIngress(&participant);
+  group->cancelWaits(&participant);
+
+  clock_.advance(milliseconds(100));
+  evb_.loop();
+  EXPECT_EQ(participant.ingressFired, 0);
+}
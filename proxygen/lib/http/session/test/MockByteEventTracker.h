@@ -41,6 +41,29 @@ class MockByteEventTracker : public ByteEventTracker {
                  void(uint64_t, ByteEvent::EventType, HTTPTransaction*));
   MOCK_METHOD4(preSend, uint64_t(bool*, bool*, bool*, uint64_t));
 
+  // Fan batch inserts out to the per-event mocks so existing expectations
+  // on addFirstBodyByteEvent/addTrackedByteEvent/etc. still match.
+  void addTxnByteEvents(
+      HTTPTransaction* txn,
+      folly::Range<const EventRequest*> events) noexcept override {
+    for (const auto& req : events) {
+      switch (req.eventType) {
+        case ByteEvent::FIRST_HEADER_BYTE:
+          addFirstHeaderByteEvent(req.byteNo, txn);
+          break;
+        case ByteEvent::FIRST_BYTE:
+          addFirstBodyByteEvent(req.byteNo, txn);
+          break;
+        case ByteEvent::LAST_BYTE:
+          addLastByteEvent(txn, req.byteNo);
+          break;
+        default:
+          addTrackedByteEvent(txn, req.byteNo);
+          break;
+      }
+    }
+  }
+
   // passthru to callback implementation functions
   void onTxnByteEventWrittenToBuf(const ByteEvent& event) {
     callback_->onTxnByteEventWrittenToBuf(event);
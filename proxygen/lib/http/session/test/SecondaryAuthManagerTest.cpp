@@ -113,6 +113,12 @@ TEST(SecondaryAuthManagerTest, Authenticator) {
   auto cachedCertId = authManager.getCertId(requestId);
   EXPECT_TRUE(cachedCertId.has_value());
   EXPECT_EQ(*cachedCertId, certId);
+  // The leaf digest is stable and served from the process-wide cache on
+  // repeated lookups.
+  auto digest = authManager.getPeerCertDigest(certId);
+  EXPECT_TRUE(digest.has_value());
+  EXPECT_EQ(digest->size(), 64);
+  EXPECT_EQ(authManager.getPeerCertDigest(certId), digest);
   auto peerCert = authManager.getPeerCert(certId);
   EXPECT_TRUE(peerCert.has_value());
   EXPECT_EQ((*peerCert).size(), 1);
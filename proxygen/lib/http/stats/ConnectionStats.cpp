@@ -29,7 +29,27 @@ TLConnectionStats::TLConnectionStats(const std::string& prefix)
                      95,
                      99),
       currConns_(prefix + "_conn"),
-      newConns_(prefix + "_new_conn", SUM, RATE) {
+      newConns_(prefix + "_new_conn", SUM, RATE),
+      tlsResumptionHit_(prefix + "_tls_resumption_hit", SUM, RATE),
+      tlsResumptionMiss_(prefix + "_tls_resumption_miss", SUM, RATE),
+      tlsZeroRttAccepted_(prefix + "_tls_0rtt_accepted", SUM, RATE),
+      tlsZeroRttRejected_(prefix + "_tls_0rtt_rejected", SUM, RATE),
+      tlsHandshakeCpuUsec_(prefix + "_tls_handshake_cpu_usec",
+                           100,
+                           0,
+                           20000,
+                           facebook::fb303::AVG,
+                           50,
+                           95,
+                           99),
+      tlsCipherAes128Gcm_(prefix + "_tls_cipher_aes128gcm", SUM, RATE),
+      tlsCipherAes256Gcm_(prefix + "_tls_cipher_aes256gcm", SUM, RATE),
+      tlsCipherChaCha20_(prefix + "_tls_cipher_chacha20", SUM, RATE),
+      tlsCipherOther_(prefix + "_tls_cipher_other", SUM, RATE),
+      tlsGroupX25519_(prefix + "_tls_group_x25519", SUM, RATE),
+      tlsGroupSecp256r1_(prefix + "_tls_group_secp256r1", SUM, RATE),
+      tlsGroupOther_(prefix + "_tls_group_other", SUM, RATE),
+      tlsTicketRotations_(prefix + "_tls_ticket_rotations", SUM, RATE) {
 }
 
 void TLConnectionStats::recordConnectionOpen() {
@@ -72,4 +92,52 @@ void TLConnectionStats::addIngressBodyBytes(size_t bytes) {
   ingressBodyBytes_.add(bytes);
 }
 
+void TLConnectionStats::recordTLSResumption(bool hit) {
+  if (hit) {
+    tlsResumptionHit_.add(1);
+  } else {
+    tlsResumptionMiss_.add(1);
+  }
+}
+
+void TLConnectionStats::recordTLSZeroRtt(bool accepted) {
+  if (accepted) {
+    tlsZeroRttAccepted_.add(1);
+  } else {
+    tlsZeroRttRejected_.add(1);
+  }
+}
+
+void TLConnectionStats::recordTLSHandshakeCpuTime(size_t usec) {
+  tlsHandshakeCpuUsec_.add(usec);
+}
+
+void TLConnectionStats::recordTLSCipher(folly::StringPiece cipher) {
+  // Accept both IANA (TLS_AES_128_GCM_SHA256) and OpenSSL
+  // (ECDHE-RSA-AES128-GCM-SHA256) spellings
+  if (cipher.contains("AES_128_GCM") || cipher.contains("AES128-GCM")) {
+    tlsCipherAes128Gcm_.add(1);
+  } else if (cipher.contains("AES_256_GCM") || cipher.contains("AES256-GCM")) {
+    tlsCipherAes256Gcm_.add(1);
+  } else if (cipher.contains("CHACHA20")) {
+    tlsCipherChaCha20_.add(1);
+  } else {
+    tlsCipherOther_.add(1);
+  }
+}
+
+void TLConnectionStats::recordTLSNamedGroup(folly::StringPiece group) {
+  if (group == "x25519" || group == "X25519") {
+    tlsGroupX25519_.add(1);
+  } else if (group == "secp256r1" || group == "P-256" || group == "prime256v1") {
+    tlsGroupSecp256r1_.add(1);
+  } else {
+    tlsGroupOther_.add(1);
+  }
+}
+
+void TLConnectionStats::recordTLSTicketRotation() {
+  tlsTicketRotations_.add(1);
+}
+
 } // namespace proxygen
@@ -9,6 +9,7 @@
 #pragma once
 
 #include <folly/Optional.h>
+#include <folly/Range.h>
 
 #include <proxygen/lib/http/stats/TLResponseCodeStats.h>
 #include <proxygen/lib/stats/BaseStats.h>
@@ -40,6 +41,35 @@ class ConnectionStats {
   virtual void addEgressBodyBytes(size_t bytes) = 0;
 
   virtual void addIngressBodyBytes(size_t bytes) = 0;
+
+  /**
+   * Session ticket / PSK resumption outcome for a completed handshake.
+   */
+  virtual void recordTLSResumption(bool hit) = 0;
+
+  /**
+   * Outcome of an attempted 0-RTT (early data) handshake.
+   */
+  virtual void recordTLSZeroRtt(bool accepted) = 0;
+
+  /**
+   * CPU time spent in the handshake, in microseconds.
+   */
+  virtual void recordTLSHandshakeCpuTime(size_t usec) = 0;
+
+  /**
+   * Negotiated cipher suite and key exchange group, by name (IANA or
+   * OpenSSL spelling); implementations may bucket uncommon values.
+   */
+  virtual void recordTLSCipher(folly::StringPiece cipher) = 0;
+
+  virtual void recordTLSNamedGroup(folly::StringPiece group) = 0;
+
+  /**
+   * A fresh session ticket encryption key was published to the key
+   * ring; see TLSTicketKeyRing.
+   */
+  virtual void recordTLSTicketRotation() = 0;
 };
 
 /**
@@ -69,6 +99,18 @@ class TLConnectionStats : public ConnectionStats {
 
   void addIngressBodyBytes(size_t bytes) override;
 
+  void recordTLSResumption(bool hit) override;
+
+  void recordTLSZeroRtt(bool accepted) override;
+
+  void recordTLSHandshakeCpuTime(size_t usec) override;
+
+  void recordTLSCipher(folly::StringPiece cipher) override;
+
+  void recordTLSNamedGroup(folly::StringPiece group) override;
+
+  void recordTLSTicketRotation() override;
+
  private:
   BaseStats::TLTimeseriesMinuteAndAllTime req_;
   BaseStats::TLTimeseriesMinuteAndAllTime resp_;
@@ -81,6 +123,23 @@ class TLConnectionStats : public ConnectionStats {
 
   BaseStats::TLCounter currConns_;
   BaseStats::TLTimeseries newConns_;
+
+  // Handshake economics.  Cipher/group distributions use fixed buckets
+  // for the suites we actually deploy, with an "other" catch-all, the
+  // same way TLResponseCodeStats buckets status codes
+  BaseStats::TLTimeseries tlsResumptionHit_;
+  BaseStats::TLTimeseries tlsResumptionMiss_;
+  BaseStats::TLTimeseries tlsZeroRttAccepted_;
+  BaseStats::TLTimeseries tlsZeroRttRejected_;
+  BaseStats::TLHistogram tlsHandshakeCpuUsec_;
+  BaseStats::TLTimeseries tlsCipherAes128Gcm_;
+  BaseStats::TLTimeseries tlsCipherAes256Gcm_;
+  BaseStats::TLTimeseries tlsCipherChaCha20_;
+  BaseStats::TLTimeseries tlsCipherOther_;
+  BaseStats::TLTimeseries tlsGroupX25519_;
+  BaseStats::TLTimeseries tlsGroupSecp256r1_;
+  BaseStats::TLTimeseries tlsGroupOther_;
+  BaseStats::TLTimeseries tlsTicketRotations_;
 };
 
 } // namespace proxygen
@@ -29,6 +29,12 @@ TLHeaderCodecStats::TLHeaderCodecStats(const string& prefix) {
   decodes_.reserve(kCompressionTypes.size());
   decodeErrors_.reserve(kCompressionTypes.size());
   decodeTooLarge_.reserve(kCompressionTypes.size());
+  staticHits_.reserve(kCompressionTypes.size());
+  dynamicHits_.reserve(kCompressionTypes.size());
+  literals_.reserve(kCompressionTypes.size());
+  evictions_.reserve(kCompressionTypes.size());
+  evictionWaste_.reserve(kCompressionTypes.size());
+  tableOccupancy_.reserve(kCompressionTypes.size());
   for (auto comprType : kCompressionTypes) {
     encodeCompr_.emplace_back(std::make_unique<BaseStats::TLHistogram>(
         prefix + "_" + comprType + "_encode_compr",
@@ -76,6 +82,21 @@ TLHeaderCodecStats::TLHeaderCodecStats(const string& prefix) {
                                SUM);
     decodeTooLarge_.emplace_back(prefix + "_" + comprType + "_decode_too_large",
                                  SUM);
+    staticHits_.emplace_back(prefix + "_" + comprType + "_static_hits", SUM);
+    dynamicHits_.emplace_back(prefix + "_" + comprType + "_dynamic_hits", SUM);
+    literals_.emplace_back(prefix + "_" + comprType + "_literals", SUM);
+    evictions_.emplace_back(prefix + "_" + comprType + "_evictions", SUM);
+    evictionWaste_.emplace_back(
+        prefix + "_" + comprType + "_eviction_waste_bytes", SUM);
+    tableOccupancy_.emplace_back(std::make_unique<BaseStats::TLHistogram>(
+        prefix + "_" + comprType + "_table_occupancy_pct",
+        5,
+        0,
+        100,
+        AVG,
+        10,
+        50,
+        90));
   }
 }
 
@@ -113,4 +134,16 @@ void TLHeaderCodecStats::recordDecodeTooLarge(HeaderCodec::Type type) {
   decodeTooLarge_[i].add(1);
 }
 
+void TLHeaderCodecStats::recordTableEfficiency(
+    HeaderCodec::Type type, const HeaderCodec::TableEfficiency& sample) {
+  uint32_t i = (uint32_t)type;
+  CHECK(i < staticHits_.size());
+  staticHits_[i].add(sample.staticHits);
+  dynamicHits_[i].add(sample.dynamicHits);
+  literals_[i].add(sample.literals);
+  evictions_[i].add(sample.evictions);
+  evictionWaste_[i].add(sample.evictedBytesNeverReused);
+  tableOccupancy_[i]->add(sample.tableOccupancyPct);
+}
+
 } // namespace proxygen
@@ -27,6 +27,9 @@ class TLHeaderCodecStats : public HeaderCodec::Stats {
   void recordDecode(HeaderCodec::Type type, HTTPHeaderSize& size) override;
   void recordDecodeError(HeaderCodec::Type type) override;
   void recordDecodeTooLarge(HeaderCodec::Type type) override;
+  void recordTableEfficiency(
+      HeaderCodec::Type type,
+      const HeaderCodec::TableEfficiency& sample) override;
 
  private:
   std::vector<std::unique_ptr<BaseStats::TLHistogram>> encodeCompr_;
@@ -37,6 +40,14 @@ class TLHeaderCodecStats : public HeaderCodec::Stats {
   std::vector<BaseStats::TLTimeseries> decodes_;
   std::vector<BaseStats::TLTimeseries> decodeErrors_;
   std::vector<BaseStats::TLTimeseries> decodeTooLarge_;
+
+  // Table-efficiency instrumentation; see HeaderCodec::TableEfficiency
+  std::vector<BaseStats::TLTimeseries> staticHits_;
+  std::vector<BaseStats::TLTimeseries> dynamicHits_;
+  std::vector<BaseStats::TLTimeseries> literals_;
+  std::vector<BaseStats::TLTimeseries> evictions_;
+  std::vector<BaseStats::TLTimeseries> evictionWaste_;
+  std::vector<std::unique_ptr<BaseStats::TLHistogram>> tableOccupancy_;
 };
 
 } // namespace proxygen
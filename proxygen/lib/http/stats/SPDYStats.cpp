@@ -81,6 +81,30 @@ TLSPDYStats::TLSPDYStats(const std::string& prefix)
 void TLSPDYStats::incrementSpdyConn(int64_t amount) {
   openConn_.incrementValue(amount);
 }
+void TLSPDYStats::recordPendingCounters(const SPDYStatCounters& counters) {
+  // one time-series touch per nonzero counter for the whole batch
+  auto add = [](BaseStats::TLTimeseries& timeseries, uint32_t count) {
+    if (count > 0) {
+      timeseries.add(count);
+    }
+  };
+  add(ingressSynStream_, counters.ingressSynStream);
+  add(ingressSynReply_, counters.ingressSynReply);
+  add(ingressData_, counters.ingressData);
+  add(ingressSettings_, counters.ingressSettings);
+  add(ingressPingRequest_, counters.ingressPingRequest);
+  add(ingressPingReply_, counters.ingressPingReply);
+  add(ingressWindowUpdate_, counters.ingressWindowUpdate);
+  add(ingressPriority_, counters.ingressPriority);
+  add(egressSynStream_, counters.egressSynStream);
+  add(egressSynReply_, counters.egressSynReply);
+  add(egressData_, counters.egressData);
+  add(egressSettings_, counters.egressSettings);
+  add(egressPingRequest_, counters.egressPingRequest);
+  add(egressPingReply_, counters.egressPingReply);
+  add(egressWindowUpdate_, counters.egressWindowUpdate);
+  add(egressPriority_, counters.egressPriority);
+}
 void TLSPDYStats::recordIngressSynStream() {
   ingressSynStream_.add(1);
 }
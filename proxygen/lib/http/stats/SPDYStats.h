@@ -14,6 +14,47 @@
 
 namespace proxygen {
 
+/**
+ * Flat counters for the dense per-frame records (data, headers, window
+ * updates, pings, ...).  SPDYStatsFilter bumps these with plain
+ * increments as frames are parsed or generated and flushes them to the
+ * SPDYStats sink once per ingress read event, instead of paying a
+ * thread-local time-series update per frame.  The parameterized, rare
+ * records (rst/goaway with status codes) are not batched.
+ */
+struct SPDYStatCounters {
+  uint32_t ingressSynStream{0};
+  uint32_t ingressSynReply{0};
+  uint32_t ingressData{0};
+  uint32_t ingressSettings{0};
+  uint32_t ingressPingRequest{0};
+  uint32_t ingressPingReply{0};
+  uint32_t ingressWindowUpdate{0};
+  uint32_t ingressPriority{0};
+
+  uint32_t egressSynStream{0};
+  uint32_t egressSynReply{0};
+  uint32_t egressData{0};
+  uint32_t egressSettings{0};
+  uint32_t egressPingRequest{0};
+  uint32_t egressPingReply{0};
+  uint32_t egressWindowUpdate{0};
+  uint32_t egressPriority{0};
+
+  bool any() const {
+    return (ingressSynStream | ingressSynReply | ingressData |
+            ingressSettings | ingressPingRequest | ingressPingReply |
+            ingressWindowUpdate | ingressPriority | egressSynStream |
+            egressSynReply | egressData | egressSettings |
+            egressPingRequest | egressPingReply | egressWindowUpdate |
+            egressPriority) != 0;
+  }
+
+  void clear() {
+    *this = SPDYStatCounters();
+  }
+};
+
 /**
  * A stats interface for tracking lifetime events on SPDY connections
  */
@@ -23,6 +64,64 @@ class SPDYStats {
 
   virtual void incrementSpdyConn(int64_t amount) = 0;
 
+  /**
+   * Accepts a batch of per-frame counters accumulated over one ingress
+   * read event.  The default replays the batch through the per-frame
+   * records, so existing sinks see identical totals; sinks backed by
+   * time-series counters should override this and apply each count with
+   * a single update.
+   */
+  virtual void recordPendingCounters(const SPDYStatCounters& counters) {
+    for (uint32_t i = 0; i < counters.ingressSynStream; i++) {
+      recordIngressSynStream();
+    }
+    for (uint32_t i = 0; i < counters.ingressSynReply; i++) {
+      recordIngressSynReply();
+    }
+    for (uint32_t i = 0; i < counters.ingressData; i++) {
+      recordIngressData();
+    }
+    for (uint32_t i = 0; i < counters.ingressSettings; i++) {
+      recordIngressSettings();
+    }
+    for (uint32_t i = 0; i < counters.ingressPingRequest; i++) {
+      recordIngressPingRequest();
+    }
+    for (uint32_t i = 0; i < counters.ingressPingReply; i++) {
+      recordIngressPingReply();
+    }
+    for (uint32_t i = 0; i < counters.ingressWindowUpdate; i++) {
+      recordIngressWindowUpdate();
+    }
+    for (uint32_t i = 0; i < counters.ingressPriority; i++) {
+      recordIngressPriority();
+    }
+    for (uint32_t i = 0; i < counters.egressSynStream; i++) {
+      recordEgressSynStream();
+    }
+    for (uint32_t i = 0; i < counters.egressSynReply; i++) {
+      recordEgressSynReply();
+    }
+    for (uint32_t i = 0; i < counters.egressData; i++) {
+      recordEgressData();
+    }
+    for (uint32_t i = 0; i < counters.egressSettings; i++) {
+      recordEgressSettings();
+    }
+    for (uint32_t i = 0; i < counters.egressPingRequest; i++) {
+      recordEgressPingRequest();
+    }
+    for (uint32_t i = 0; i < counters.egressPingReply; i++) {
+      recordEgressPingReply();
+    }
+    for (uint32_t i = 0; i < counters.egressWindowUpdate; i++) {
+      recordEgressWindowUpdate();
+    }
+    for (uint32_t i = 0; i < counters.egressPriority; i++) {
+      recordEgressPriority();
+    }
+  }
+
   virtual void recordIngressSynStream() = 0;
   virtual void recordIngressSynReply() = 0;
   virtual void recordIngressData() = 0;
@@ -60,6 +159,8 @@ class TLSPDYStats : public SPDYStats {
 
   void incrementSpdyConn(int64_t amount) override;
 
+  void recordPendingCounters(const SPDYStatCounters& counters) override;
+
   void recordIngressSynStream() override;
   void recordIngressSynReply() override;
   void recordIngressData() override;
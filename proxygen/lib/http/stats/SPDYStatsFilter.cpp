@@ -18,16 +18,37 @@ SPDYStatsFilter::SPDYStatsFilter(SPDYStats* counters, CodecProtocol protocol)
 }
 
 SPDYStatsFilter::~SPDYStatsFilter() {
+  flushPendingCounters();
   counters_->incrementSpdyConn(-1);
 }
 
+void SPDYStatsFilter::flushPendingCounters() {
+  if (pending_.any()) {
+    counters_->recordPendingCounters(pending_);
+    pending_.clear();
+  }
+}
+
+size_t SPDYStatsFilter::onIngress(const folly::IOBuf& buf) {
+  auto bytesParsed = call_->onIngress(buf);
+  // one stats touch for everything the read event produced, ingress and
+  // egress alike
+  flushPendingCounters();
+  return bytesParsed;
+}
+
+void SPDYStatsFilter::onIngressEOF() {
+  call_->onIngressEOF();
+  flushPendingCounters();
+}
+
 void SPDYStatsFilter::onHeadersComplete(StreamID stream,
                                         std::unique_ptr<HTTPMessage> msg) {
   if (call_->getTransportDirection() == TransportDirection::DOWNSTREAM ||
       (stream % 2 == 0 && msg->isRequest())) {
-    counters_->recordIngressSynStream();
+    pending_.ingressSynStream++;
   } else {
-    counters_->recordIngressSynReply();
+    pending_.ingressSynReply++;
   }
   callback_->onHeadersComplete(stream, std::move(msg));
 }
@@ -35,7 +56,7 @@ void SPDYStatsFilter::onHeadersComplete(StreamID stream,
 void SPDYStatsFilter::onBody(StreamID stream,
                              std::unique_ptr<folly::IOBuf> chain,
                              uint16_t padding) {
-  counters_->recordIngressData();
+  pending_.ingressData++;
   callback_->onBody(stream, std::move(chain), padding);
 }
 
@@ -59,39 +80,39 @@ void SPDYStatsFilter::onGoaway(uint64_t lastGoodStreamID,
 }
 
 void SPDYStatsFilter::onPingRequest(uint64_t data) {
-  counters_->recordIngressPingRequest();
+  pending_.ingressPingRequest++;
   callback_->onPingRequest(data);
 }
 
 void SPDYStatsFilter::onPingReply(uint64_t data) {
-  counters_->recordIngressPingReply();
+  pending_.ingressPingReply++;
   callback_->onPingReply(data);
 }
 
 void SPDYStatsFilter::onWindowUpdate(StreamID stream, uint32_t amount) {
-  counters_->recordIngressWindowUpdate();
+  pending_.ingressWindowUpdate++;
   callback_->onWindowUpdate(stream, amount);
 }
 
 void SPDYStatsFilter::onSettings(const SettingsList& settings) {
-  counters_->recordIngressSettings();
+  pending_.ingressSettings++;
   callback_->onSettings(settings);
 }
 
 void SPDYStatsFilter::onSettingsAck() {
-  counters_->recordIngressSettings();
+  pending_.ingressSettings++;
   callback_->onSettingsAck();
 }
 
 void SPDYStatsFilter::onPriority(StreamID stream,
                                  const HTTPMessage::HTTP2Priority& pri) {
-  counters_->recordIngressPriority();
+  pending_.ingressPriority++;
   callback_->onPriority(stream, pri);
 }
 
 void SPDYStatsFilter::onPriority(StreamID stream,
                                  const HTTPPriority& priority) {
-  counters_->recordIngressPriority();
+  pending_.ingressPriority++;
   callback_->onPriority(stream, priority);
 }
 
@@ -103,9 +124,9 @@ void SPDYStatsFilter::generateHeader(
     HTTPHeaderSize* size,
     const folly::Optional<HTTPHeaders>& extraHeaders) {
   if (call_->getTransportDirection() == TransportDirection::UPSTREAM) {
-    counters_->recordEgressSynStream();
+    pending_.egressSynStream++;
   } else {
-    counters_->recordEgressSynReply();
+    pending_.egressSynReply++;
   }
   return call_->generateHeader(writeBuf, stream, msg, eom, size, extraHeaders);
 }
@@ -116,7 +137,7 @@ void SPDYStatsFilter::generatePushPromise(folly::IOBufQueue& writeBuf,
                                           StreamID assocStream,
                                           bool eom,
                                           HTTPHeaderSize* size) {
-  counters_->recordEgressSynStream();
+  pending_.egressSynStream++;
   return call_->generatePushPromise(
       writeBuf, stream, msg, assocStream, eom, size);
 }
@@ -126,7 +147,7 @@ size_t SPDYStatsFilter::generateBody(folly::IOBufQueue& writeBuf,
                                      std::unique_ptr<folly::IOBuf> chain,
                                      folly::Optional<uint8_t> padding,
                                      bool eom) {
-  counters_->recordEgressData();
+  pending_.egressData++;
   return call_->generateBody(writeBuf, stream, std::move(chain), padding, eom);
 }
 
@@ -155,25 +176,25 @@ size_t SPDYStatsFilter::generateGoaway(
 
 size_t SPDYStatsFilter::generatePingRequest(folly::IOBufQueue& writeBuf,
                                             folly::Optional<uint64_t> data) {
-  counters_->recordEgressPingRequest();
+  pending_.egressPingRequest++;
   return call_->generatePingRequest(writeBuf, data);
 }
 
 size_t SPDYStatsFilter::generatePingReply(folly::IOBufQueue& writeBuf,
                                           uint64_t data) {
-  counters_->recordEgressPingReply();
+  pending_.egressPingReply++;
   return call_->generatePingReply(writeBuf, data);
 }
 
 size_t SPDYStatsFilter::generateSettings(folly::IOBufQueue& buf) {
-  counters_->recordEgressSettings();
+  pending_.egressSettings++;
   return call_->generateSettings(buf);
 }
 
 size_t SPDYStatsFilter::generateWindowUpdate(folly::IOBufQueue& writeBuf,
                                              StreamID stream,
                                              uint32_t delta) {
-  counters_->recordEgressWindowUpdate();
+  pending_.egressWindowUpdate++;
   return call_->generateWindowUpdate(writeBuf, stream, delta);
 }
 
@@ -181,21 +202,21 @@ size_t SPDYStatsFilter::generatePriority(
     folly::IOBufQueue& writeBuf,
     StreamID stream,
     const HTTPMessage::HTTP2Priority& pri) {
-  counters_->recordEgressPriority();
+  pending_.egressPriority++;
   return call_->generatePriority(writeBuf, stream, pri);
 }
 
 size_t SPDYStatsFilter::generatePriority(folly::IOBufQueue& writeBuf,
                                          StreamID streamId,
                                          HTTPPriority pri) {
-  counters_->recordEgressPriority();
+  pending_.egressPriority++;
   return call_->generatePriority(writeBuf, streamId, pri);
 }
 
 size_t SPDYStatsFilter::generatePushPriority(folly::IOBufQueue& writeBuf,
                                              StreamID pushId,
                                              HTTPPriority pri) {
-  counters_->recordEgressPriority();
+  pending_.egressPriority++;
   return call_->generatePushPriority(writeBuf, pushId, pri);
 }
 
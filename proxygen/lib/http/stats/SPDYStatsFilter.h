@@ -10,21 +10,36 @@
 
 #include <proxygen/lib/http/codec/CodecProtocol.h>
 #include <proxygen/lib/http/codec/HTTPCodecFilter.h>
+#include <proxygen/lib/http/stats/SPDYStats.h>
 
 namespace proxygen {
 
-class SPDYStats;
-
+/**
+ * Accumulates the dense per-frame counts in plain per-codec integers and
+ * flushes them to the SPDYStats sink once per ingress read event (and at
+ * ingress EOF / destruction), so a frame-dense read costs one stats
+ * touch instead of one per frame.  Egress counts ride along with the
+ * next ingress flush.  Rst/goaway records carry status codes and stay
+ * unbatched.
+ */
 class SPDYStatsFilter : public PassThroughHTTPCodecFilter {
  public:
   explicit SPDYStatsFilter(SPDYStats* counters, CodecProtocol protocol);
   ~SPDYStatsFilter() override;
 
   void setCounters(SPDYStats* counters) {
+    if (counters_ != counters) {
+      // pending counts belong to the sink they were accumulated for
+      flushPendingCounters();
+    }
     counters_ = counters;
   }
   // ingress
 
+  size_t onIngress(const folly::IOBuf& buf) override;
+
+  void onIngressEOF() override;
+
   bool isHTTP2() const {
     return isHTTP2CodecProtocol(protocol_);
   }
@@ -116,8 +131,11 @@ class SPDYStatsFilter : public PassThroughHTTPCodecFilter {
                               HTTPPriority pri) override;
 
  private:
+  void flushPendingCounters();
+
   SPDYStats* counters_;
   CodecProtocol protocol_;
+  SPDYStatCounters pending_;
 };
 
 } // namespace proxygen
@@ -75,7 +75,15 @@ TLHTTPSessionStats::TLHTTPSessionStats(const std::string& prefix)
                       50,
                       75,
                       95,
-                      99) {
+                      99),
+      sessionRTTms(prefix + "_session_rtt_ms",
+                   1,
+                   0,
+                   1000,
+                   facebook::fb303::AVG,
+                   50,
+                   95,
+                   99) {
 }
 
 void TLHTTPSessionStats::recordTransactionOpened() noexcept {
@@ -156,4 +164,30 @@ void TLHTTPSessionStats::recordSessionStalled() noexcept {
   txnsSessionStalled.add(1);
 }
 
+void TLHTTPSessionStats::recordSessionRTT(
+    std::chrono::microseconds rtt) noexcept {
+  sessionRTTms.add(
+      std::chrono::duration_cast<std::chrono::milliseconds>(rtt).count());
+}
+
+void TLHTTPSessionStats::recordPendingStatCounters(
+    const HTTPSessionStatCounters& counters) noexcept {
+  if (counters.txnsOpened != counters.txnsClosed) {
+    txnsOpen.incrementValue(int64_t(counters.txnsOpened) -
+                            int64_t(counters.txnsClosed));
+  }
+  if (counters.txnsOpened) {
+    txnsOpened.add(counters.txnsOpened);
+  }
+  if (counters.sessionsReused) {
+    txnsFromSessionReuse.add(counters.sessionsReused);
+  }
+  if (counters.txnsStalled) {
+    txnsTransactionStalled.add(counters.txnsStalled);
+  }
+  if (counters.sessionsStalled) {
+    txnsSessionStalled.add(counters.sessionsStalled);
+  }
+}
+
 } // namespace proxygen
@@ -37,6 +37,9 @@ class TLHTTPSessionStats : public HTTPSessionStats {
   void recordSessionIdleTime(std::chrono::seconds) noexcept override;
   void recordTransactionStalled() noexcept override;
   void recordSessionStalled() noexcept override;
+  void recordPendingStatCounters(
+      const HTTPSessionStatCounters& counters) noexcept override;
+  void recordSessionRTT(std::chrono::microseconds rtt) noexcept override;
 
   BaseStats::TLCounter txnsOpen;
   BaseStats::TLTimeseries txnsOpened;
@@ -58,6 +61,7 @@ class TLHTTPSessionStats : public HTTPSessionStats {
   BaseStats::TLTimeseries ttbtxExceedLimit;
   BaseStats::TLHistogram txnsPerSession;
   BaseStats::TLHistogram sessionIdleTime;
+  BaseStats::TLHistogram sessionRTTms;
 };
 
 } // namespace proxygen
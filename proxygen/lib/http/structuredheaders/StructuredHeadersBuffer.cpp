@@ -8,8 +8,8 @@
 
 #include "StructuredHeadersBuffer.h"
 
-#include <boost/lexical_cast.hpp>
 #include <cctype>
+#include <folly/Conv.h>
 #include <glog/logging.h>
 
 #include "StructuredHeadersUtilities.h" // @manual=:utils
@@ -43,8 +43,10 @@ DecodeError StructuredHeadersBuffer::parseItem(StructuredHeaderItem& result) {
 DecodeError StructuredHeadersBuffer::parseNumber(StructuredHeaderItem& result) {
   auto type = StructuredHeaderItem::Type::INT64;
 
+  // The digits are consumed in place and converted from a view of the
+  // buffer; no temporary string is built
   bool positive = true;
-  std::string input;
+  auto start = content_.begin();
 
   if (isEmpty()) {
     return handleDecodeError(DecodeError::UNEXPECTED_END_OF_BUFFER);
@@ -53,7 +55,6 @@ DecodeError StructuredHeadersBuffer::parseNumber(StructuredHeaderItem& result) {
   if (peek() == '-') {
     advanceCursor();
     positive = false;
-    input.push_back('-');
   }
 
   if (isEmpty()) {
@@ -67,17 +68,15 @@ DecodeError StructuredHeadersBuffer::parseNumber(StructuredHeaderItem& result) {
   while (!isEmpty()) {
     char current = peek();
     if (std::isdigit(current)) {
-      input.push_back(current);
       advanceCursor();
     } else if (type == StructuredHeaderItem::Type::INT64 && current == '.') {
       type = StructuredHeaderItem::Type::DOUBLE;
-      input.push_back(current);
       advanceCursor();
     } else {
       break;
     }
 
-    int numDigits = input.length() - (positive ? 0 : 1);
+    int numDigits = (content_.begin() - start) - (positive ? 0 : 1);
     if (type == StructuredHeaderItem::Type::INT64 &&
         numDigits > StructuredHeaders::kMaxValidIntegerLength) {
       return handleDecodeError(DecodeError::VALUE_TOO_LONG);
@@ -87,6 +86,7 @@ DecodeError StructuredHeadersBuffer::parseNumber(StructuredHeaderItem& result) {
     }
   }
 
+  folly::StringPiece input(start, content_.begin());
   if (type == StructuredHeaderItem::Type::INT64) {
     return parseInteger(input, result);
   } else if (input.back() == '.') {
@@ -179,6 +179,19 @@ DecodeError StructuredHeadersBuffer::parseIdentifier(
 
 DecodeError StructuredHeadersBuffer::parseIdentifier(std::string& result) {
 
+  folly::StringPiece identifier;
+  auto err = parseIdentifier(identifier);
+  if (err != DecodeError::OK) {
+    return err;
+  }
+
+  result.append(identifier.data(), identifier.size());
+  return DecodeError::OK;
+}
+
+DecodeError StructuredHeadersBuffer::parseIdentifier(
+    folly::StringPiece& result) {
+
   if (isEmpty()) {
     return handleDecodeError(DecodeError::UNEXPECTED_END_OF_BUFFER);
   }
@@ -187,40 +200,36 @@ DecodeError StructuredHeadersBuffer::parseIdentifier(std::string& result) {
     return handleDecodeError(DecodeError::INVALID_CHARACTER);
   }
 
-  while (!isEmpty()) {
-    char current = peek();
-    if (!isValidIdentifierChar(current)) {
-      break;
-    } else {
-      advanceCursor();
-      result.push_back(current);
-    }
+  auto start = content_.begin();
+  while (!isEmpty() && isValidIdentifierChar(peek())) {
+    advanceCursor();
   }
 
+  result = folly::StringPiece(start, content_.begin());
   return DecodeError::OK;
 }
 
 DecodeError StructuredHeadersBuffer::parseInteger(
-    const std::string& input, StructuredHeaderItem& result) {
+    folly::StringPiece input, StructuredHeaderItem& result) {
 
-  try {
-    result.value = boost::lexical_cast<int64_t>(input);
-    result.tag = StructuredHeaderItem::Type::INT64;
-  } catch (boost::bad_lexical_cast&) {
+  auto value = folly::tryTo<int64_t>(input);
+  if (!value.hasValue()) {
     return handleDecodeError(DecodeError::UNPARSEABLE_NUMERIC_TYPE);
   }
+  result.value = value.value();
+  result.tag = StructuredHeaderItem::Type::INT64;
   return DecodeError::OK;
 }
 
-DecodeError StructuredHeadersBuffer::parseFloat(const std::string& input,
+DecodeError StructuredHeadersBuffer::parseFloat(folly::StringPiece input,
                                                 StructuredHeaderItem& result) {
 
-  try {
-    result.value = boost::lexical_cast<double>(input);
-    result.tag = StructuredHeaderItem::Type::DOUBLE;
-  } catch (boost::bad_lexical_cast&) {
+  auto value = folly::tryTo<double>(input);
+  if (!value.hasValue()) {
     return handleDecodeError(DecodeError::UNPARSEABLE_NUMERIC_TYPE);
   }
+  result.value = value.value();
+  result.tag = StructuredHeaderItem::Type::DOUBLE;
   return DecodeError::OK;
 }
 
@@ -36,6 +36,12 @@ class StructuredHeadersBuffer {
 
   StructuredHeaders::DecodeError parseIdentifier(std::string& result);
 
+  /*
+   * Non-allocating variant: the result is a view into the buffer's
+   * underlying storage and is valid for as long as that storage is.
+   */
+  StructuredHeaders::DecodeError parseIdentifier(folly::StringPiece& result);
+
   StructuredHeaders::DecodeError parseItem(StructuredHeaderItem& result);
 
   DecodeError removeSymbol(const std::string& symbol, bool strict);
@@ -55,11 +61,10 @@ class StructuredHeadersBuffer {
 
   DecodeError parseString(StructuredHeaderItem& result);
 
-  DecodeError parseInteger(const std::string& input,
+  DecodeError parseInteger(folly::StringPiece input,
                            StructuredHeaderItem& result);
 
-  DecodeError parseFloat(const std::string& input,
-                         StructuredHeaderItem& result);
+  DecodeError parseFloat(folly::StringPiece input, StructuredHeaderItem& result);
 
   char peek();
 
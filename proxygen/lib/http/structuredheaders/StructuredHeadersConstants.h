@@ -78,7 +78,8 @@ enum class DecodeError : uint8_t {
   UNDECODEABLE_BINARY_CONTENT = 3,
   UNEXPECTED_END_OF_BUFFER = 4,
   UNPARSEABLE_NUMERIC_TYPE = 5,
-  DUPLICATE_KEY = 6
+  DUPLICATE_KEY = 6,
+  TYPE_MISMATCH = 7
 };
 
 enum class EncodeError : uint8_t {
@@ -97,7 +98,8 @@ static const std::map<DecodeError, std::string> decodeErrorDescription{
     {DecodeError::UNDECODEABLE_BINARY_CONTENT, "Undecodable binary content"},
     {DecodeError::UNEXPECTED_END_OF_BUFFER, "Unexpected end of buffer"},
     {DecodeError::UNPARSEABLE_NUMERIC_TYPE, "Unparseable numeric type"},
-    {DecodeError::DUPLICATE_KEY, "Duplicate key found"}};
+    {DecodeError::DUPLICATE_KEY, "Duplicate key found"},
+    {DecodeError::TYPE_MISMATCH, "Item type does not match schema"}};
 
 static const std::map<EncodeError, std::string> encodeErrorDescription{
     {EncodeError::OK, "No error"},
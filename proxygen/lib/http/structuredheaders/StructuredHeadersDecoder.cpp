@@ -60,6 +60,74 @@ DecodeError StructuredHeadersDecoder::decodeDictionary(Dictionary& result) {
   return decodeMap(result, MapType::DICTIONARY);
 }
 
+DecodeError StructuredHeadersDecoder::decodeKnownDictionary(
+    folly::Range<DictionaryField*> fields, size_t* numUnknownKeys) {
+
+  if (numUnknownKeys) {
+    *numUnknownKeys = 0;
+  }
+
+  buf_.removeOptionalWhitespace();
+
+  while (!buf_.isEmpty()) {
+
+    buf_.removeOptionalWhitespace();
+
+    folly::StringPiece thisKey;
+    auto err = buf_.parseIdentifier(thisKey);
+    if (err != DecodeError::OK) {
+      return err;
+    }
+
+    DictionaryField* field = nullptr;
+    for (auto& candidate : fields) {
+      if (candidate.key == thisKey) {
+        field = &candidate;
+        break;
+      }
+    }
+    if (field && field->present) {
+      return buf_.handleDecodeError(DecodeError::DUPLICATE_KEY);
+    }
+
+    StructuredHeaderItem discarded;
+    auto& value = field ? field->value : discarded;
+    err = buf_.removeSymbol("=", false /* strict */);
+    if (err != DecodeError::OK) {
+      value.tag = StructuredHeaderItem::Type::BOOLEAN;
+      value.value = true;
+    } else {
+      err = buf_.parseItem(value);
+      if (err != DecodeError::OK) {
+        return err;
+      }
+    }
+
+    if (field) {
+      if (field->type != StructuredHeaderItem::Type::NONE &&
+          value.tag != field->type) {
+        return buf_.handleDecodeError(DecodeError::TYPE_MISMATCH);
+      }
+      field->present = true;
+    } else if (numUnknownKeys) {
+      ++*numUnknownKeys;
+    }
+
+    if (buf_.isEmpty()) {
+      return DecodeError::OK;
+    }
+
+    buf_.removeOptionalWhitespace();
+
+    err = buf_.removeSymbol(",", true);
+    if (err != DecodeError::OK) {
+      return err;
+    }
+  }
+
+  return buf_.handleDecodeError(DecodeError::UNEXPECTED_END_OF_BUFFER);
+}
+
 DecodeError StructuredHeadersDecoder::decodeParameterisedList(
     ParameterisedList& result) {
 
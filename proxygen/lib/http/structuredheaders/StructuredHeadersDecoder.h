@@ -22,6 +22,18 @@ class StructuredHeadersDecoder {
   explicit StructuredHeadersDecoder(folly::StringPiece s) : buf_(s) {
   }
 
+  /**
+   * One known dictionary member for decodeKnownDictionary: the key and
+   * expected value type go in, the decoded value and a presence flag come
+   * out.  An expected type of NONE accepts any item type.
+   */
+  struct DictionaryField {
+    folly::StringPiece key;
+    StructuredHeaderItem::Type type{StructuredHeaderItem::Type::NONE};
+    StructuredHeaderItem value;
+    bool present{false};
+  };
+
   StructuredHeaders::DecodeError decodeItem(StructuredHeaderItem& result);
 
   StructuredHeaders::DecodeError decodeList(
@@ -29,6 +41,18 @@ class StructuredHeadersDecoder {
 
   StructuredHeaders::DecodeError decodeDictionary(Dictionary& result);
 
+  /**
+   * Decode a dictionary whose possible keys are known in advance (e.g.
+   * the Priority header's "u=3, i") into the given fields, without
+   * building a map or copying keys.  Keys match case-sensitively, per the
+   * structured headers grammar.  A member whose parsed type contradicts
+   * its field's expected type fails with TYPE_MISMATCH.  Members not
+   * named by any field are parsed and discarded, counted in
+   * numUnknownKeys if provided; duplicates among them are not detected.
+   */
+  StructuredHeaders::DecodeError decodeKnownDictionary(
+      folly::Range<DictionaryField*> fields, size_t* numUnknownKeys = nullptr);
+
   StructuredHeaders::DecodeError decodeParameterisedList(
       ParameterisedList& result);
 
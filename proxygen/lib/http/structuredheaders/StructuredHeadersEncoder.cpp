@@ -233,4 +233,10 @@ std::string StructuredHeadersEncoder::get() {
   return std::move(output_);
 }
 
+void StructuredHeadersEncoder::clear() {
+  outputStream_.flush();
+  outputStream_.clear();
+  output_.clear();
+}
+
 } // namespace proxygen
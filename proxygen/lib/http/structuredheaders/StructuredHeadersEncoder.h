@@ -40,6 +40,10 @@ class StructuredHeadersEncoder {
 
   std::string get();
 
+  // Discards any buffered output so the encoder (and its underlying
+  // string buffer) can be reused for another encode
+  void clear();
+
  private:
   EncodeError encodeBinaryContent(const std::string& input);
 
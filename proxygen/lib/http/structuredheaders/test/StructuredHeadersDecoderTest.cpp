@@ -262,6 +262,53 @@ TEST_F(StructuredHeadersDecoderTest, PriorityWithoutIncrementalHasComma) {
   EXPECT_NE(ret, StructuredHeaders::DecodeError::OK);
 }
 
+TEST_F(StructuredHeadersDecoderTest, KnownDictionary) {
+  std::string priority = "u=3, i";
+  StructuredHeadersDecoder decoder(priority);
+  StructuredHeadersDecoder::DictionaryField fields[2] = {
+      {"u", StructuredHeaderItem::Type::INT64, {}, false},
+      {"i", StructuredHeaderItem::Type::BOOLEAN, {}, false}};
+  size_t numUnknownKeys = 0;
+  auto ret = decoder.decodeKnownDictionary({fields, 2}, &numUnknownKeys);
+  EXPECT_EQ(ret, StructuredHeaders::DecodeError::OK);
+  EXPECT_EQ(0, numUnknownKeys);
+  EXPECT_TRUE(fields[0].present);
+  EXPECT_EQ(fields[0].value, (int64_t)3);
+  EXPECT_TRUE(fields[1].present);
+  EXPECT_EQ(fields[1].value, true);
+}
+
+TEST_F(StructuredHeadersDecoderTest, KnownDictionaryUnknownKey) {
+  std::string input = "u=3, x=\"z\"";
+  StructuredHeadersDecoder decoder(input);
+  StructuredHeadersDecoder::DictionaryField fields[1] = {
+      {"u", StructuredHeaderItem::Type::INT64, {}, false}};
+  size_t numUnknownKeys = 0;
+  auto ret = decoder.decodeKnownDictionary({fields, 1}, &numUnknownKeys);
+  EXPECT_EQ(ret, StructuredHeaders::DecodeError::OK);
+  EXPECT_EQ(1, numUnknownKeys);
+  EXPECT_TRUE(fields[0].present);
+  EXPECT_EQ(fields[0].value, (int64_t)3);
+}
+
+TEST_F(StructuredHeadersDecoderTest, KnownDictionaryTypeMismatch) {
+  std::string input = "u=3.5";
+  StructuredHeadersDecoder decoder(input);
+  StructuredHeadersDecoder::DictionaryField fields[1] = {
+      {"u", StructuredHeaderItem::Type::INT64, {}, false}};
+  auto ret = decoder.decodeKnownDictionary({fields, 1});
+  EXPECT_EQ(ret, StructuredHeaders::DecodeError::TYPE_MISMATCH);
+}
+
+TEST_F(StructuredHeadersDecoderTest, KnownDictionaryDuplicateKey) {
+  std::string input = "u=3, u=4";
+  StructuredHeadersDecoder decoder(input);
+  StructuredHeadersDecoder::DictionaryField fields[1] = {
+      {"u", StructuredHeaderItem::Type::INT64, {}, false}};
+  auto ret = decoder.decodeKnownDictionary({fields, 1});
+  EXPECT_EQ(ret, StructuredHeaders::DecodeError::DUPLICATE_KEY);
+}
+
 TEST_F(StructuredHeadersDecoderTest, SpaceOnlyNoCrash) {
   StructuredHeaders::Dictionary dict;
   std::array<char, 1> input = {' '};
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/http/DnsResolutionCache.h>
+
+#include <atomic>
+#include <folly/portability/GTest.h>
+#include <thread>
+
+using namespace proxygen;
+
+namespace {
+
+class DnsResolutionCacheTest : public testing::Test {
+ protected:
+  void installResolver(DnsResolutionCache& cache,
+                       std::vector<folly::SocketAddress> addresses,
+                       std::string errorMsg = std::string()) {
+    cache.setResolverForTesting(
+        [this, addresses = std::move(addresses), errorMsg = std::move(errorMsg)](
+            const std::string&, uint16_t, std::string& error) {
+          resolutions_++;
+          error = errorMsg;
+          return addresses;
+        });
+  }
+
+  // run one cold lookup to completion so the entry is populated
+  void primeEntry(DnsResolutionCache& cache,
+                  const std::string& hostname,
+                  uint16_t port) {
+    cache.resolve(&eventBase_,
+                  hostname,
+                  port,
+                  [this](std::vector<folly::SocketAddress>,
+                         const std::string&) {
+                    eventBase_.terminateLoopSoon();
+                  });
+    eventBase_.loopForever();
+  }
+
+  void waitForResolutions(uint32_t count) {
+    for (int i = 0; i < 200 && resolutions_ < count; i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_GE(resolutions_.load(), count);
+  }
+
+  folly::EventBase eventBase_;
+  std::atomic<uint32_t> resolutions_{0};
+};
+
+} // namespace
+
+TEST_F(DnsResolutionCacheTest, FreshHitServesSynchronously) {
+  DnsResolutionCache cache;
+  installResolver(cache, {folly::SocketAddress("10.0.0.1", 80)});
+  primeEntry(cache, "backend", 80);
+  EXPECT_EQ(resolutions_, 1);
+
+  bool served = false;
+  cache.resolve(&eventBase_,
+                "backend",
+                80,
+                [&](std::vector<folly::SocketAddress> addresses,
+                    const std::string& errorMsg) {
+                  EXPECT_EQ(addresses.size(), 1);
+                  EXPECT_TRUE(errorMsg.empty());
+                  served = true;
+                });
+  // hit answered before resolve() returned, with no new resolution
+  EXPECT_TRUE(served);
+  EXPECT_EQ(resolutions_, 1);
+}
+
+TEST_F(DnsResolutionCacheTest, StaleServedWhileRevalidating) {
+  DnsResolutionCache::Params params;
+  params.ttl = std::chrono::milliseconds(0); // everything expires at once
+  DnsResolutionCache cache(params);
+  installResolver(cache, {folly::SocketAddress("10.0.0.2", 80)});
+  primeEntry(cache, "backend", 80);
+  EXPECT_EQ(resolutions_, 1);
+
+  // expired but inside the serve-stale window: answered synchronously,
+  // refresh happens behind it
+  bool served = false;
+  cache.resolve(&eventBase_,
+                "backend",
+                80,
+                [&](std::vector<folly::SocketAddress> addresses,
+                    const std::string&) {
+                  EXPECT_EQ(addresses.size(), 1);
+                  served = true;
+                });
+  EXPECT_TRUE(served);
+  waitForResolutions(2);
+}
+
+TEST_F(DnsResolutionCacheTest, NegativeCaching) {
+  DnsResolutionCache cache;
+  installResolver(cache, {}, "no such host");
+  primeEntry(cache, "dead", 80);
+  EXPECT_EQ(resolutions_, 1);
+
+  bool served = false;
+  cache.resolve(&eventBase_,
+                "dead",
+                80,
+                [&](std::vector<folly::SocketAddress> addresses,
+                    const std::string& errorMsg) {
+                  EXPECT_TRUE(addresses.empty());
+                  EXPECT_EQ(errorMsg, "no such host");
+                  served = true;
+                });
+  // the failure answers from memory; no resolution storm
+  EXPECT_TRUE(served);
+  EXPECT_EQ(resolutions_, 1);
+}
+
+TEST_F(DnsResolutionCacheTest, ColdMissFeedsAllWaiters) {
+  DnsResolutionCache cache;
+  installResolver(cache, {folly::SocketAddress("10.0.0.3", 443)});
+
+  int delivered = 0;
+  auto onResult = [&](std::vector<folly::SocketAddress> addresses,
+                      const std::string&) {
+    EXPECT_EQ(addresses.size(), 1);
+    if (++delivered == 2) {
+      eventBase_.terminateLoopSoon();
+    }
+  };
+  // two concurrent lookups for the same name share one resolution
+  cache.resolve(&eventBase_, "backend", 443, onResult);
+  cache.resolve(&eventBase_, "backend", 443, onResult);
+  eventBase_.loopForever();
+
+  EXPECT_EQ(delivered, 2);
+  EXPECT_EQ(resolutions_, 1);
+}
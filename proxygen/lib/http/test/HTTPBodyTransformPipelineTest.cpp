@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/http/HTTPBodyTransformPipeline.h>
+
+#include <cstring>
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+using folly::IOBuf;
+
+namespace {
+
+std::string toString(const IOBuf& chain) {
+  std::string out;
+  for (auto range : chain) {
+    out.append(reinterpret_cast<const char*>(range.data()), range.size());
+  }
+  return out;
+}
+
+class PassThroughStage : public HTTPBodyTransformPipeline::Stage {
+ public:
+  bool isPassThrough() const noexcept override {
+    return true;
+  }
+};
+
+// rot13-style rewrite: same byte count, runs wherever the body lives
+class XorStage : public HTTPBodyTransformPipeline::Stage {
+ public:
+  bool isInPlace() const noexcept override {
+    return true;
+  }
+  void transformInPlace(uint8_t* data, size_t len) override {
+    for (size_t i = 0; i < len; i++) {
+      data[i] ^= 0x20;
+    }
+  }
+};
+
+// writes each input byte twice: the simplest expanding transform
+class DoublingStage : public HTTPBodyTransformPipeline::Stage {
+ public:
+  size_t maxTransformedSize(size_t inputLen) const noexcept override {
+    return inputLen * 2;
+  }
+  size_t transform(const uint8_t* input,
+                   size_t inputLen,
+                   uint8_t* output,
+                   size_t outputCapacity) override {
+    CHECK_GE(outputCapacity, inputLen * 2);
+    for (size_t i = 0; i < inputLen; i++) {
+      output[2 * i] = input[i];
+      output[2 * i + 1] = input[i];
+    }
+    return inputLen * 2;
+  }
+};
+
+// appends a fixed trailer; reshapes the shared slab when stacked after
+// another expanding stage
+class SignStage : public HTTPBodyTransformPipeline::Stage {
+ public:
+  size_t maxTransformedSize(size_t inputLen) const noexcept override {
+    return inputLen + 4;
+  }
+  size_t reshape(uint8_t* data, size_t len, size_t capacity) override {
+    CHECK_GE(capacity, len + 4);
+    memcpy(data + len, "SIG!", 4);
+    return len + 4;
+  }
+};
+
+// holds everything until finish(), like a compressor's internal block
+class BufferingStage : public HTTPBodyTransformPipeline::Stage {
+ public:
+  size_t transform(const uint8_t* input,
+                   size_t inputLen,
+                   uint8_t* /*output*/,
+                   size_t /*outputCapacity*/) override {
+    held_.append(reinterpret_cast<const char*>(input), inputLen);
+    return 0;
+  }
+  std::unique_ptr<IOBuf> finish() override {
+    return IOBuf::copyBuffer(held_);
+  }
+
+ private:
+  std::string held_;
+};
+
+} // namespace
+
+TEST(HTTPBodyTransformPipeline, PassThroughForwardsChainUntouched) {
+  HTTPBodyTransformPipeline pipeline;
+  pipeline.addStage(std::make_unique<PassThroughStage>());
+  auto body = IOBuf::copyBuffer("hello");
+  auto* original = body.get();
+  auto out = pipeline.transform(std::move(body));
+  EXPECT_EQ(out.get(), original);
+  EXPECT_EQ(toString(*out), "hello");
+}
+
+TEST(HTTPBodyTransformPipeline, InPlaceStagesRewriteWithoutCopy) {
+  HTTPBodyTransformPipeline pipeline;
+  pipeline.addStage(std::make_unique<XorStage>());
+  pipeline.addStage(std::make_unique<XorStage>());
+  pipeline.addStage(std::make_unique<PassThroughStage>());
+  auto body = IOBuf::copyBuffer("hello");
+  auto* data = body->data();
+  auto out = pipeline.transform(std::move(body));
+  // both rewrites ran on the original buffer and cancelled out
+  EXPECT_EQ(out->data(), data);
+  EXPECT_EQ(toString(*out), "hello");
+}
+
+TEST(HTTPBodyTransformPipeline, ExpandingStagesShareOneSlab) {
+  HTTPBodyTransformPipeline pipeline;
+  pipeline.addStage(std::make_unique<XorStage>());
+  pipeline.addStage(std::make_unique<DoublingStage>());
+  pipeline.addStage(std::make_unique<SignStage>());
+
+  // a two-buffer chain still lands in one contiguous slab
+  auto body = IOBuf::copyBuffer("Hi");
+  body->prependChain(IOBuf::copyBuffer("Yo"));
+  auto out = pipeline.transform(std::move(body));
+  EXPECT_FALSE(out->isChained());
+  EXPECT_EQ(toString(*out), "hhIIyyOOSIG!");
+}
+
+TEST(HTTPBodyTransformPipeline, FinishCascadesThroughLaterStages) {
+  HTTPBodyTransformPipeline pipeline;
+  pipeline.addStage(std::make_unique<BufferingStage>());
+  pipeline.addStage(std::make_unique<DoublingStage>());
+
+  auto out = pipeline.transform(IOBuf::copyBuffer("ab"));
+  EXPECT_TRUE(!out || out->empty());
+  // the buffered bytes surface at EOM and still pass the doubling stage
+  auto tail = pipeline.finish();
+  ASSERT_TRUE(tail);
+  EXPECT_EQ(toString(*tail), "aabb");
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/io/async/AsyncServerSocket.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/http/HTTPConnector.h>
+#include <proxygen/lib/http/session/HTTPUpstreamSession.h>
+
+using namespace proxygen;
+using namespace folly;
+
+namespace {
+
+class RacingConnectorCallback : public HTTPConnector::Callback {
+ public:
+  explicit RacingConnectorCallback(EventBase& evb) : evb_(evb) {
+  }
+
+  void connectSuccess(HTTPUpstreamSession* session) override {
+    session_ = session;
+    evb_.terminateLoopSoon();
+  }
+
+  void connectError(const AsyncSocketException& ex) override {
+    error_ = ex;
+    evb_.terminateLoopSoon();
+  }
+
+  void connectTiming(
+      const HTTPConnector::ConnectTiming& timing) noexcept override {
+    timing_ = timing;
+    gotTiming_ = true;
+  }
+
+  EventBase& evb_;
+  HTTPUpstreamSession* session_{nullptr};
+  folly::Optional<AsyncSocketException> error_;
+  HTTPConnector::ConnectTiming timing_;
+  bool gotTiming_{false};
+};
+
+} // namespace
+
+class HTTPConnectorTest : public testing::Test {
+ public:
+  void SetUp() override {
+    timer_ = HHWheelTimer::newTimer(
+        &evb_,
+        std::chrono::milliseconds(HHWheelTimer::DEFAULT_TICK_INTERVAL),
+        AsyncTimeout::InternalEnum::NORMAL,
+        std::chrono::milliseconds(5000));
+  }
+
+ protected:
+  EventBase evb_;
+  HHWheelTimer::UniquePtr timer_;
+};
+
+TEST_F(HTTPConnectorTest, RacingConnectSuccess) {
+  AsyncServerSocket::UniquePtr server(new AsyncServerSocket(&evb_));
+  server->bind(0);
+  server->listen(10);
+  server->startAccepting();
+  SocketAddress address;
+  server->getAddress(&address);
+
+  RacingConnectorCallback cb(evb_);
+  HTTPConnector connector(&cb, timer_.get());
+  connector.setPlaintextProtocol("http/1.1");
+  connector.connectWithRacing(
+      &evb_, "localhost", address.getPort(), std::chrono::milliseconds(5000));
+  EXPECT_TRUE(connector.isBusy());
+  evb_.loopForever();
+
+  ASSERT_NE(cb.session_, nullptr);
+  EXPECT_TRUE(cb.gotTiming_);
+  EXPECT_EQ(cb.timing_.tls.count(), 0);
+  EXPECT_FALSE(connector.isBusy());
+  cb.session_->dropConnection();
+}
+
+TEST_F(HTTPConnectorTest, RacingConnectResolutionFailure) {
+  RacingConnectorCallback cb(evb_);
+  HTTPConnector connector(&cb, timer_.get());
+  // Guaranteed not to resolve, per RFC 2606
+  connector.connectWithRacing(&evb_, "host.invalid", 80);
+  evb_.loopForever();
+
+  EXPECT_EQ(cb.session_, nullptr);
+  ASSERT_TRUE(cb.error_.hasValue());
+  EXPECT_FALSE(connector.isBusy());
+}
+
+TEST_F(HTTPConnectorTest, RacingConnectReset) {
+  RacingConnectorCallback cb(evb_);
+  HTTPConnector connector(&cb, timer_.get());
+  connector.connectWithRacing(&evb_, "localhost", 80);
+  // Resetting mid-resolution must suppress all callbacks
+  connector.reset();
+  EXPECT_FALSE(connector.isBusy());
+  evb_.loop();
+
+  EXPECT_EQ(cb.session_, nullptr);
+  EXPECT_FALSE(cb.error_.hasValue());
+}
@@ -58,6 +58,36 @@ TEST(HTTPMessage, TestParseCookiesMultipleCookies) {
   EXPECT_EQ(msg.getCookie("Name"), "");
 }
 
+TEST(HTTPMessage, TestGetCookieFast) {
+  HTTPMessage msg;
+
+  msg.getHeaders().add("Cookie",
+                       "id=1256679245; data=0:1234567; same=Always; Name");
+  msg.getHeaders().add("Cookie", "id2=99; same=Never");
+  EXPECT_EQ(msg.getCookieFast("id"), "1256679245");
+  EXPECT_EQ(msg.getCookieFast("id2"), "99");
+  EXPECT_EQ(msg.getCookieFast("data"), "0:1234567");
+  // duplicates resolve to the first occurrence, like getCookie()
+  EXPECT_EQ(msg.getCookieFast("same"), "Always");
+  EXPECT_EQ(msg.getCookieFast("Name"), "");
+  EXPECT_EQ(msg.getCookieFast("absent"), "");
+
+  // the index allows zero-copy iteration in name order
+  const auto& index = msg.getCookieIndex();
+  EXPECT_EQ(index.size(), 6);
+  EXPECT_TRUE(std::is_sorted(
+      index.begin(), index.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+      }));
+
+  // editing the Cookie header plus unparseCookies() rebuilds the index
+  msg.getHeaders().set("Cookie", "only=one");
+  msg.unparseCookies();
+  EXPECT_EQ(msg.getCookieFast("only"), "one");
+  EXPECT_EQ(msg.getCookieFast("id"), "");
+  EXPECT_EQ(msg.getCookieIndex().size(), 1);
+}
+
 TEST(HTTPMessage, TestParseQueryParamsSimple) {
   HTTPMessage msg;
   string url =
@@ -86,6 +116,26 @@ TEST(HTTPMessage, TestParseQueryParamsSimple) {
   EXPECT_EQ(param, "123456");
 }
 
+TEST(HTTPMessage, TestQueryParamNoCopy) {
+  HTTPMessage msg;
+  string url =
+      "/test?seq=123456&userid=1256679245&dup=1&dup=2&helloWorld"
+      "&second=was+it+clear+%28already%29%3F";
+
+  msg.setURL(url);
+  EXPECT_EQ(msg.getQueryParamNoCopy("seq"), "123456");
+  EXPECT_EQ(msg.getQueryParamNoCopy("userid"), "1256679245");
+  // duplicates resolve to the last occurrence, like getQueryParam()
+  EXPECT_EQ(msg.getQueryParamNoCopy("dup"), "2");
+  EXPECT_EQ(msg.getQueryParamNoCopy("helloWorld"), "");
+  EXPECT_EQ(msg.getQueryParamNoCopy("absent"), "");
+
+  // changing the URL invalidates and rebuilds the index
+  msg.setQueryParam("foo", "bar");
+  EXPECT_EQ(msg.getQueryParamNoCopy("foo"), "bar");
+  EXPECT_EQ(msg.getQueryParamNoCopy("seq"), "123456");
+}
+
 TEST(HTTPMessage, TestParseQueryParamsComplex) {
   HTTPMessage msg;
   std::vector<std::vector<std::string>> input = {
@@ -490,6 +540,91 @@ TEST(HTTPHeaders, InitializerListStringPiece) {
   EXPECT_EQ("value", hdrs.getSingleOrEmpty(HTTP_HEADER_CONNECTION));
 }
 
+TEST(HTTPHeaders, AddBatch) {
+  HTTPHeaders hdrs;
+  std::vector<std::pair<HTTPHeaders::HTTPHeaderName, folly::StringPiece>>
+      batch{{"x-custom", "y"},
+            {HTTP_HEADER_CONNECTION, "close"},
+            {HTTP_HEADER_SERVER, "proxygen"}};
+
+  hdrs.reserve(batch.size());
+  hdrs.addBatch({batch.data(), batch.size()});
+
+  EXPECT_EQ(3, hdrs.size());
+  EXPECT_EQ("y", hdrs.getSingleOrEmpty("x-custom"));
+  EXPECT_EQ("close", hdrs.getSingleOrEmpty(HTTP_HEADER_CONNECTION));
+  EXPECT_EQ("proxygen", hdrs.getSingleOrEmpty(HTTP_HEADER_SERVER));
+}
+
+TEST(HTTPHeaders, RawView) {
+  HTTPHeaders hdrs;
+  hdrs.add(HTTP_HEADER_HOST, "example.com");
+  hdrs.add("x-custom", "y");
+  hdrs.add(HTTP_HEADER_CONNECTION, "close");
+
+  auto codes = hdrs.codeRange();
+  ASSERT_EQ(3, codes.size());
+  EXPECT_EQ(HTTP_HEADER_HOST, codes[0]);
+  EXPECT_EQ(HTTP_HEADER_OTHER, codes[1]);
+  EXPECT_EQ(HTTP_HEADER_CONNECTION, codes[2]);
+  EXPECT_EQ("x-custom", *hdrs.nameRange()[1]);
+  EXPECT_EQ("close", hdrs.valueRange()[2]);
+
+  // Deleted headers stay in the view as HTTP_HEADER_NONE slots
+  hdrs.remove(HTTP_HEADER_HOST);
+  codes = hdrs.codeRange();
+  ASSERT_EQ(3, codes.size());
+  EXPECT_EQ(HTTP_HEADER_NONE, codes[0]);
+  EXPECT_EQ(2, hdrs.size());
+}
+
+TEST(HTTPHeaders, InternedName) {
+  auto host = HTTPHeaders::internName("Host");
+  EXPECT_EQ(HTTP_HEADER_HOST, host.code());
+
+  auto custom = HTTPHeaders::internName("X-Custom-Hdr");
+  EXPECT_EQ(HTTP_HEADER_OTHER, custom.code());
+  EXPECT_EQ("X-Custom-Hdr", custom.name());
+  // Re-resolving yields the same canonical string
+  EXPECT_EQ(&custom.name(), &HTTPHeaders::internName("X-Custom-Hdr").name());
+
+  HTTPHeaders hdrs;
+  hdrs.add(HTTP_HEADER_HOST, "example.com");
+  hdrs.add("x-custom-hdr", "a");
+
+  EXPECT_TRUE(hdrs.exists(host));
+  EXPECT_EQ("example.com", hdrs.getSingleOrEmpty(host));
+  // Handle lookups are case-insensitive like their string counterparts
+  EXPECT_TRUE(hdrs.exists(custom));
+  EXPECT_EQ("a", hdrs.getSingleOrEmpty(custom));
+
+  hdrs.add(custom, "b");
+  EXPECT_EQ(2, hdrs.getNumberOfValues("x-custom-hdr"));
+  EXPECT_EQ("a, b", hdrs.combine(custom));
+
+  hdrs.remove("x-custom-hdr");
+  EXPECT_FALSE(hdrs.exists(custom));
+}
+
+TEST(HTTPHeaders, InternedNameCopies) {
+  // Uncommon names survive the copy/move/strip paths regardless of
+  // whether they came from the pool
+  HTTPHeaders hdrs;
+  hdrs.add("x-interned", "1");
+  hdrs.add(HTTP_HEADER_CONNECTION, "x-interned");
+
+  HTTPHeaders copied(hdrs);
+  EXPECT_EQ("1", copied.getSingleOrEmpty("x-interned"));
+
+  HTTPHeaders stripped;
+  copied.stripPerHopHeaders(stripped);
+  EXPECT_FALSE(copied.exists("x-interned"));
+  EXPECT_EQ("1", stripped.getSingleOrEmpty("x-interned"));
+
+  HTTPHeaders moved(std::move(stripped));
+  EXPECT_EQ("1", moved.getSingleOrEmpty("x-interned"));
+}
+
 void testRemoveQueryParam(const string& url,
                           const string& queryParam,
                           const string& expectedUrl,
@@ -612,6 +747,43 @@ TEST(HTTPMessage, TestMoveCopy) {
   m2 = std::move(m1);
 }
 
+TEST(HTTPMessage, TestCloneShallow) {
+  HTTPMessage req;
+  req.setMethod("GET");
+  req.setURL("/mirror");
+  req.getHeaders().add(HTTP_HEADER_HOST, "www.facebook.com");
+  req.getHeaders().add("X-Request-Id", "12345");
+
+  HTTPMessage clone = req.cloneShallow();
+
+  // Both messages read the shared block
+  const HTTPMessage& creq = req;
+  const HTTPMessage& cclone = clone;
+  EXPECT_EQ(creq.getHeaders().size(), 2);
+  EXPECT_EQ(cclone.getHeaders().size(), 2);
+  EXPECT_EQ(cclone.getHeaders().getSingleOrEmpty("X-Request-Id"), "12345");
+
+  // Mutating the clone detaches it without touching the source
+  clone.getHeaders().set("X-Request-Id", "67890");
+  EXPECT_EQ(creq.getHeaders().getSingleOrEmpty("X-Request-Id"), "12345");
+  EXPECT_EQ(cclone.getHeaders().getSingleOrEmpty("X-Request-Id"), "67890");
+
+  // ...and vice versa
+  req.getHeaders().add("X-Extra", "1");
+  EXPECT_EQ(creq.getHeaders().size(), 3);
+  EXPECT_EQ(cclone.getHeaders().size(), 2);
+
+  // Plain copies of a still-shared message stay cheap and correct
+  HTTPMessage shared = req.cloneShallow();
+  HTTPMessage copy(shared);
+  EXPECT_EQ(copy.getHeaders().getSingleOrEmpty("X-Extra"), "1");
+
+  // extractHeaders materializes a private copy first
+  auto extracted = std::move(shared.extractHeaders());
+  EXPECT_EQ(extracted.size(), 3);
+  EXPECT_EQ(creq.getHeaders().size(), 3);
+}
+
 namespace {
 const size_t kInitialVectorReserve = 16;
 }
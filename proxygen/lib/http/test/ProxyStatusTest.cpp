@@ -116,6 +116,36 @@ TEST(ProxyStatusTest, TestProxy) {
   EXPECT_EQ(parameterisedList[0].parameterMap["e_proxy"], std::string("proxy"));
 }
 
+TEST(ProxyStatusTest, TestPresetParameters) {
+  ProxyStatus proxy_status{StatusType::connection_timeout};
+  proxy_status.setProxy("proxy");
+  proxy_status.setUpstreamIP("upstreamIP");
+
+  auto str = proxy_status.toString();
+  StructuredHeadersDecoder decoder(str);
+  StructuredHeaders::ParameterisedList parameterisedList;
+  decoder.decodeParameterisedList(parameterisedList);
+
+  EXPECT_EQ(parameterisedList.size(), 1);
+  EXPECT_EQ(parameterisedList[0].identifier, "connection_timeout");
+  EXPECT_EQ(parameterisedList[0].parameterMap.size(), 2);
+  EXPECT_EQ(parameterisedList[0].parameterMap["e_proxy"], std::string("proxy"));
+  EXPECT_EQ(parameterisedList[0].parameterMap["e_upip"],
+            std::string("upstreamIP"));
+
+  // Repeated serializations reuse the pooled encoder buffer and are
+  // byte-identical
+  EXPECT_EQ(str, proxy_status.toString());
+}
+
+TEST(ProxyStatusTest, TestPresetParametersEmptyStatus) {
+  ProxyStatus proxy_status{};
+  proxy_status.setProxy("proxy");
+
+  // Preset fragments are only appended to a serializable status
+  EXPECT_STREQ(proxy_status.toString().c_str(), "");
+}
+
 TEST(ProxyStatusTest, TestSerialization) {
   ProxyStatus proxy_status{StatusType::proxy_internal_error};
   EXPECT_FALSE(proxy_status.hasUpstreamIP());
@@ -13,6 +13,7 @@
 using namespace proxygen;
 
 using RFC2616::parseByteRangeSpec;
+using RFC2616::parseRangeRequest;
 using std::string;
 
 TEST(QvalueTest, Basic) {
@@ -252,3 +253,75 @@ TEST(ByteRangeSpecTest, Invalids) {
   EXPECT_FALSE(parseByteRangeSpec(sp, dummy, dummy, dummy))
       << "Spec StringPiece ends before first byte in initial byte range";
 }
+
+TEST(RangeRequestTest, Valids) {
+  std::vector<RFC2616::ByteRange> ranges;
+
+  ASSERT_TRUE(parseRangeRequest("bytes=0-99", 1000, ranges));
+  ASSERT_EQ(1, ranges.size());
+  EXPECT_EQ(std::make_pair(uint64_t(0), uint64_t(99)), ranges[0]);
+
+  ASSERT_TRUE(parseRangeRequest("bytes=500-", 1000, ranges));
+  ASSERT_EQ(1, ranges.size());
+  EXPECT_EQ(std::make_pair(uint64_t(500), uint64_t(999)), ranges[0]);
+
+  ASSERT_TRUE(parseRangeRequest("bytes=-100", 1000, ranges));
+  ASSERT_EQ(1, ranges.size());
+  EXPECT_EQ(std::make_pair(uint64_t(900), uint64_t(999)), ranges[0]);
+
+  // suffix longer than the instance means the whole instance
+  ASSERT_TRUE(parseRangeRequest("bytes=-5000", 1000, ranges));
+  ASSERT_EQ(1, ranges.size());
+  EXPECT_EQ(std::make_pair(uint64_t(0), uint64_t(999)), ranges[0]);
+
+  // last byte is clamped to the instance
+  ASSERT_TRUE(parseRangeRequest("bytes=500-5000", 1000, ranges));
+  ASSERT_EQ(1, ranges.size());
+  EXPECT_EQ(std::make_pair(uint64_t(500), uint64_t(999)), ranges[0]);
+
+  ASSERT_TRUE(parseRangeRequest("bytes=0-0, -1, 500-599", 1000, ranges));
+  ASSERT_EQ(3, ranges.size());
+  EXPECT_EQ(std::make_pair(uint64_t(0), uint64_t(0)), ranges[0]);
+  EXPECT_EQ(std::make_pair(uint64_t(999), uint64_t(999)), ranges[1]);
+  EXPECT_EQ(std::make_pair(uint64_t(500), uint64_t(599)), ranges[2]);
+}
+
+TEST(RangeRequestTest, Unsatisfiable) {
+  std::vector<RFC2616::ByteRange> ranges;
+
+  // well formed but past the end: true with no ranges, i.e. a 416
+  EXPECT_TRUE(parseRangeRequest("bytes=1000-", 1000, ranges));
+  EXPECT_EQ(0, ranges.size());
+  EXPECT_TRUE(parseRangeRequest("bytes=2000-3000", 1000, ranges));
+  EXPECT_EQ(0, ranges.size());
+  EXPECT_TRUE(parseRangeRequest("bytes=-0", 1000, ranges));
+  EXPECT_EQ(0, ranges.size());
+  EXPECT_TRUE(parseRangeRequest("bytes=-100", 0, ranges));
+  EXPECT_EQ(0, ranges.size());
+
+  // satisfiable specs still count when mixed with unsatisfiable ones
+  ASSERT_TRUE(parseRangeRequest("bytes=2000-3000, 0-99", 1000, ranges));
+  ASSERT_EQ(1, ranges.size());
+  EXPECT_EQ(std::make_pair(uint64_t(0), uint64_t(99)), ranges[0]);
+}
+
+TEST(RangeRequestTest, Invalids) {
+  std::vector<RFC2616::ByteRange> ranges;
+
+  EXPECT_FALSE(parseRangeRequest("0-99", 1000, ranges))
+      << "Value must start with 'bytes='";
+  EXPECT_FALSE(parseRangeRequest("items=0-99", 1000, ranges))
+      << "Only the bytes unit is supported";
+  EXPECT_FALSE(parseRangeRequest("bytes=99", 1000, ranges))
+      << "Spec missing '-' separator";
+  EXPECT_FALSE(parseRangeRequest("bytes=-", 1000, ranges))
+      << "Spec missing both bytes";
+  EXPECT_FALSE(parseRangeRequest("bytes=x-99", 1000, ranges))
+      << "Spec has invalid first byte";
+  EXPECT_FALSE(parseRangeRequest("bytes=0-x", 1000, ranges))
+      << "Spec has invalid last byte";
+  EXPECT_FALSE(parseRangeRequest("bytes=99-0", 1000, ranges))
+      << "Spec first byte is past last byte";
+  EXPECT_FALSE(parseRangeRequest("bytes=0-99, oops", 1000, ranges))
+      << "One bad spec spoils the set";
+}
@@ -7,6 +7,7 @@
  */
 
 #include <proxygen/lib/http/Window.h>
+#include <proxygen/lib/http/WindowUpdateStrategy.h>
 
 #include <folly/portability/GTest.h>
 
@@ -121,3 +122,41 @@ TEST(WindowTest, NewCapacityOverflow) {
   ASSERT_EQ(w.getSize(), std::numeric_limits<int32_t>::max());
   ASSERT_FALSE(w.setCapacity(std::numeric_limits<int32_t>::max() - 9));
 }
+
+TEST(WindowUpdateStrategyTest, Eager) {
+  Window w(100);
+  EagerWindowUpdateStrategy s;
+  ASSERT_EQ(s.onIngressBytesProcessed(30), 30);
+  ASSERT_EQ(s.onIngressBytesConsumed(30), 0);
+  ASSERT_FALSE(s.shouldSendWindowUpdate(w, 49, false));
+  ASSERT_TRUE(s.shouldSendWindowUpdate(w, 50, false));
+  // Draining waits for the full capacity
+  ASSERT_FALSE(s.shouldSendWindowUpdate(w, 99, true));
+  ASSERT_TRUE(s.shouldSendWindowUpdate(w, 100, true));
+}
+
+TEST(WindowUpdateStrategyTest, AckClocked) {
+  Window w(100);
+  AckClockedWindowUpdateStrategy s;
+  // Bytes handed to the handler are withheld until consumption confirms
+  ASSERT_EQ(s.onIngressBytesProcessed(40), 0);
+  ASSERT_EQ(s.onIngressBytesProcessed(20), 0);
+  ASSERT_EQ(s.onIngressBytesConsumed(40), 40);
+  // Release never exceeds what was processed
+  ASSERT_EQ(s.onIngressBytesConsumed(30), 20);
+  ASSERT_EQ(s.onIngressBytesConsumed(10), 0);
+  ASSERT_FALSE(s.shouldSendWindowUpdate(w, 49, false));
+  ASSERT_TRUE(s.shouldSendWindowUpdate(w, 50, false));
+}
+
+TEST(WindowUpdateStrategyTest, Quantum) {
+  Window w(100);
+  QuantumWindowUpdateStrategy s(10);
+  ASSERT_EQ(s.onIngressBytesProcessed(5), 5);
+  ASSERT_EQ(s.onIngressBytesConsumed(5), 0);
+  ASSERT_FALSE(s.shouldSendWindowUpdate(w, 9, false));
+  ASSERT_TRUE(s.shouldSendWindowUpdate(w, 10, false));
+  // Draining falls back to full capacity regardless of the quantum
+  ASSERT_FALSE(s.shouldSendWindowUpdate(w, 99, true));
+  ASSERT_TRUE(s.shouldSendWindowUpdate(w, 100, true));
+}
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "proxygen/lib/pools/generators/FileServerListCache.h"
+
+#include <sstream>
+
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/ScopeGuard.h>
+#include <folly/SocketAddress.h>
+#include <folly/dynamic.h>
+#include <folly/json.h>
+#include <folly/system/ThreadName.h>
+#include <proxygen/lib/utils/Exception.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+using folly::dynamic;
+using folly::parseJson;
+using folly::SocketAddress;
+using std::string;
+
+namespace proxygen {
+
+std::shared_ptr<FileServerListCache> FileServerListCache::get(
+    const string& fileName, const FileType fileType, const string& poolName) {
+  static std::mutex registryLock;
+  static std::map<string, std::weak_ptr<FileServerListCache>> registry;
+
+  auto key = folly::to<string>(
+      fileName, '\0', static_cast<int>(fileType), '\0', poolName);
+  std::lock_guard<std::mutex> g(registryLock);
+  auto& entry = registry[key];
+  auto cache = entry.lock();
+  if (!cache) {
+    cache = std::shared_ptr<FileServerListCache>(
+        new FileServerListCache(fileName, fileType, poolName));
+    entry = cache;
+  }
+  return cache;
+}
+
+FileServerListCache::FileServerListCache(string fileName,
+                                         const FileType fileType,
+                                         string poolName)
+    : fileName_(std::move(fileName)),
+      fileType_(fileType),
+      poolName_(std::move(poolName)) {
+}
+
+FileServerListCache::~FileServerListCache() {
+  stopWatcher();
+}
+
+FileServerListCache::FileVersion FileServerListCache::statFile(
+    const string& fileName) {
+  struct stat st;
+  if (stat(fileName.c_str(), &st) != 0) {
+    folly::throw_exception<Exception>("Error reading file %s", fileName);
+  }
+  FileVersion version;
+  version.mtime = st.st_mtime;
+  version.size = st.st_size;
+  version.inode = st.st_ino;
+  return version;
+}
+
+FileServerListCache::Snapshot FileServerListCache::parse() const {
+  VLOG(4) << "Parsing server list from File " << fileName_;
+
+  string content;
+  if (!folly::readFile(fileName_.c_str(), content)) {
+    folly::throw_exception<Exception>("Error reading file %s", fileName_);
+  }
+
+  auto servers = std::make_shared<ServerList>();
+
+  if (fileType_ == FileType::PLAIN_TEXT) {
+    std::stringstream sstream(content);
+    string line;
+    while (std::getline(sstream, line)) {
+      SocketAddress address;
+      address.setFromHostPort(line);
+      servers->emplace_back(address.getAddressStr(), address);
+    }
+  } else if (fileType_ == FileType::JSON) {
+    dynamic parsedJson = parseJson(content);
+    dynamic poolMembers = parsedJson.getDefault(poolName_, -1);
+    // If we cannot parse out an arrray out of that.
+    if (!poolMembers.isArray()) {
+      throw std::invalid_argument("Cannot find a valid pool " + poolName_ +
+                                  " in file " + fileName_);
+    }
+    // Now we have an array.
+    for (const auto& e : poolMembers) {
+      SocketAddress address;
+      address.setFromHostPort(e.asString());
+      servers->emplace_back(address.getAddressStr(), address);
+    }
+  } else {
+    // Unsupported FileType yet.
+    LOG(FATAL) << "Unsupported FileServerListGenerator::FileType!";
+  }
+
+  VLOG(4) << "Found " << servers->size() << " usable servers from File "
+          << fileName_;
+  return servers;
+}
+
+FileServerListCache::Snapshot FileServerListCache::getSnapshot() {
+  auto version = statFile(fileName_);
+
+  std::unique_lock<std::mutex> lk(lock_);
+  while (true) {
+    if (snapshot_ && version == cachedVersion_) {
+      return snapshot_;
+    }
+    if (!parsing_) {
+      break;
+    }
+    // Singleflight: wait for the in-progress parse rather than starting
+    // another; it almost always covers the version we just stat()ed
+    parseCv_.wait(lk);
+  }
+  parsing_ = true;
+  lk.unlock();
+
+  Snapshot fresh;
+  std::exception_ptr error;
+  try {
+    fresh = parse();
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  lk.lock();
+  parsing_ = false;
+  if (!error) {
+    snapshot_ = fresh;
+    cachedVersion_ = version;
+  }
+  parseCv_.notify_all();
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  return fresh;
+}
+
+uint64_t FileServerListCache::subscribe(SubscriptionCallback cb) {
+  std::lock_guard<std::mutex> g(subscribersLock_);
+  auto token = nextToken_++;
+  subscribers_.emplace(token,
+                       std::make_shared<SubscriptionCallback>(std::move(cb)));
+  if (!watcherThread_.joinable()) {
+    startWatcher();
+  }
+  return token;
+}
+
+void FileServerListCache::unsubscribe(uint64_t token) {
+  std::lock_guard<std::mutex> g(subscribersLock_);
+  subscribers_.erase(token);
+}
+
+void FileServerListCache::startWatcher() {
+#ifdef __linux__
+  if (pipe(wakeupPipe_) != 0) {
+    PLOG(WARNING) << "Failed to create wakeup pipe; server list refresh "
+                     "disabled for "
+                  << fileName_;
+    return;
+  }
+  watcherThread_ = std::thread([this] { watchLoop(); });
+#endif
+}
+
+void FileServerListCache::stopWatcher() {
+  if (watcherThread_.joinable()) {
+    folly::writeNoInt(wakeupPipe_[1], "x", 1);
+    watcherThread_.join();
+  }
+  for (auto& fd : wakeupPipe_) {
+    if (fd >= 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+}
+
+void FileServerListCache::watchLoop() {
+#ifdef __linux__
+  folly::setThreadName("srvlist-watch");
+
+  int inotifyFd = inotify_init1(IN_CLOEXEC);
+  if (inotifyFd < 0) {
+    PLOG(WARNING) << "inotify_init1 failed; server list refresh disabled for "
+                  << fileName_;
+    return;
+  }
+  SCOPE_EXIT {
+    close(inotifyFd);
+  };
+
+  // Watch the parent directory: config pushes typically rename() a new
+  // file over the old one, which a watch on the file itself would lose
+  auto slash = fileName_.rfind('/');
+  auto dir = slash == string::npos ? string(".") : fileName_.substr(0, slash);
+  if (dir.empty()) {
+    dir = "/";
+  }
+  auto base = slash == string::npos ? fileName_ : fileName_.substr(slash + 1);
+  if (inotify_add_watch(
+          inotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) <
+      0) {
+    PLOG(WARNING) << "Failed to watch " << dir
+                  << "; server list refresh disabled for " << fileName_;
+    return;
+  }
+
+  while (true) {
+    struct pollfd fds[2] = {{inotifyFd, POLLIN, 0},
+                            {wakeupPipe_[0], POLLIN, 0}};
+    if (poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      PLOG(WARNING) << "poll failed; server list refresh disabled for "
+                    << fileName_;
+      return;
+    }
+    if (fds[1].revents != 0) {
+      // stopWatcher() woke us up
+      return;
+    }
+
+    alignas(struct inotify_event) char buf[4096];
+    auto len = folly::readNoInt(inotifyFd, buf, sizeof(buf));
+    if (len <= 0) {
+      continue;
+    }
+    bool matched = false;
+    for (char* p = buf; p < buf + len;) {
+      auto* event = reinterpret_cast<struct inotify_event*>(p);
+      if (event->len > 0 && base == event->name) {
+        matched = true;
+      }
+      p += sizeof(struct inotify_event) + event->len;
+    }
+    if (matched) {
+      pushSnapshot();
+    }
+  }
+#endif
+}
+
+void FileServerListCache::pushSnapshot() {
+  Snapshot fresh;
+  try {
+    fresh = getSnapshot();
+  } catch (const std::exception& ex) {
+    LOG(WARNING) << "Failed to refresh server list from " << fileName_ << ": "
+                 << ex.what();
+    return;
+  }
+
+  // Copy the callbacks out so a subscriber can unsubscribe() without
+  // deadlocking against a push in progress
+  std::vector<std::shared_ptr<SubscriptionCallback>> callbacks;
+  {
+    std::lock_guard<std::mutex> g(subscribersLock_);
+    callbacks.reserve(subscribers_.size());
+    for (auto& subscriber : subscribers_) {
+      callbacks.push_back(subscriber.second);
+    }
+  }
+  for (auto& cb : callbacks) {
+    (*cb)(fresh);
+  }
+}
+
+} // namespace proxygen
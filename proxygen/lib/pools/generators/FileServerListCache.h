@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <folly/Function.h>
+
+#include "proxygen/lib/pools/generators/FileServerListGenerator.h"
+
+namespace proxygen {
+
+/**
+ * Process-wide cache of parsed server list files, shared by every
+ * FileServerListGenerator pointed at the same (file, pool).  Parsing a
+ * multi-megabyte list once per worker adds up; this collapses it:
+ *
+ *  - Snapshots are immutable and shared; a listServers call that hits
+ *    the cache costs a stat() and a copy of the list, not a parse.
+ *  - The file is only re-read when its identity (mtime/size/inode)
+ *    changed since the last parse.
+ *  - Concurrent callers that do need a parse share a single one
+ *    (singleflight) instead of parsing per caller.
+ *  - On Linux, subscribers are pushed fresh snapshots from an inotify
+ *    watcher when the file is rewritten or replaced, so consumers (e.g.
+ *    feeding a PoolHealthChecker) need not poll.
+ */
+class FileServerListCache {
+ public:
+  using FileType = FileServerListGenerator::FileType;
+  using ServerList = std::vector<ServerListGenerator::ServerConfig>;
+  using Snapshot = std::shared_ptr<const ServerList>;
+  using SubscriptionCallback = folly::Function<void(Snapshot)>;
+
+  /**
+   * The shared cache for (fileName, fileType, poolName); created on
+   * first use, dropped when the last generator using it goes away.
+   */
+  static std::shared_ptr<FileServerListCache> get(const std::string& fileName,
+                                                  FileType fileType,
+                                                  const std::string& poolName);
+
+  ~FileServerListCache();
+
+  /**
+   * The current snapshot, re-reading and re-parsing the file only when
+   * it changed since the last parse.  Throws Exception on read errors
+   * and std::invalid_argument on a missing/invalid pool, matching the
+   * errors FileServerListGenerator reports.
+   */
+  Snapshot getSnapshot();
+
+  /**
+   * Invoke cb with every new snapshot picked up by the inotify watcher
+   * (Linux only; on other platforms subscriptions never fire).  cb runs
+   * on the watcher thread and must not block it.  Returns a token for
+   * unsubscribe().
+   */
+  uint64_t subscribe(SubscriptionCallback cb);
+  void unsubscribe(uint64_t token);
+
+ private:
+  FileServerListCache(std::string fileName,
+                      FileType fileType,
+                      std::string poolName);
+
+  // Forbidden copy constructor and assignment operator
+  FileServerListCache(FileServerListCache const&) = delete;
+  FileServerListCache& operator=(FileServerListCache const&) = delete;
+
+  /**
+   * What we remember about the file backing a snapshot; catches both
+   * in-place rewrites and the rename()-over pushes that keep the name
+   * but change the inode.
+   */
+  struct FileVersion {
+    time_t mtime{0};
+    off_t size{0};
+    ino_t inode{0};
+
+    bool operator==(const FileVersion& other) const {
+      return mtime == other.mtime && size == other.size &&
+             inode == other.inode;
+    }
+  };
+
+  static FileVersion statFile(const std::string& fileName);
+  Snapshot parse() const;
+
+  void startWatcher();
+  void stopWatcher();
+  void watchLoop();
+  void pushSnapshot();
+
+  const std::string fileName_;
+  const FileType fileType_;
+  const std::string poolName_;
+
+  std::mutex lock_;
+  std::condition_variable parseCv_;
+  bool parsing_{false};
+  Snapshot snapshot_;
+  FileVersion cachedVersion_;
+
+  std::mutex subscribersLock_;
+  std::map<uint64_t, std::shared_ptr<SubscriptionCallback>> subscribers_;
+  uint64_t nextToken_{1};
+  std::thread watcherThread_;
+  int wakeupPipe_[2]{-1, -1};
+};
+
+} // namespace proxygen
@@ -7,85 +7,31 @@
  */
 
 #include "proxygen/lib/pools/generators/FileServerListGenerator.h"
-#include <folly/FileUtil.h>
-#include <folly/SocketAddress.h>
-#include <folly/dynamic.h>
-#include <folly/json.h>
-#include <sstream>
+#include "proxygen/lib/pools/generators/FileServerListCache.h"
 
-using folly::dynamic;
-using folly::parseJson;
-using folly::SocketAddress;
 using std::string;
 using std::chrono::milliseconds;
 
 namespace proxygen {
 
-void FileServerListGenerator::FileGenerator::readFile(std::string& filePath,
-                                                      std::string& content) {
-  if (!folly::readFile(filePath.c_str(), content)) {
-    folly::throw_exception<Exception>("Error reading file %s", filePath);
-  }
-}
 void FileServerListGenerator::FileGenerator::cancelServerListRequest(){};
 
 void FileServerListGenerator::FileGenerator::run(milliseconds /*timeout*/) {
-  // Read the file
-
   VLOG(4) << "Looking up server list from File Handle " << params_->fileName;
 
-  std::string content;
+  // The cache stats the file and only re-parses when it changed;
+  // concurrent callers share one parse
+  FileServerListCache::Snapshot snapshot;
   try {
-    readFile(params_->fileName, content);
-  } catch (const std::exception& ex) {
-    callback_->serverListError(std::make_exception_ptr(ex));
+    snapshot = cache_->getSnapshot();
+  } catch (const std::exception&) {
+    callback_->serverListError(std::current_exception());
     delete this;
     return;
   }
 
-  // process the content and get the server list
-  std::vector<ServerConfig> servers;
-
-  if (params_->fileType == FileType::PLAIN_TEXT) {
-    std::stringstream sstream(content);
-    string line;
-    while (std::getline(sstream, line)) {
-      SocketAddress address;
-      address.setFromHostPort(line);
-      servers.push_back(ServerConfig(address.getAddressStr(), address));
-    }
-  } else if (params_->fileType == FileType::JSON) {
-    try {
-      dynamic parsedJson = parseJson(content);
-      dynamic poolMembers = parsedJson.getDefault(params_->poolName, -1);
-      // If we cannot parse out an arrray out of that.
-      if (!poolMembers.isArray()) {
-        callback_->serverListError(std::make_exception_ptr(
-            std::invalid_argument("Cannot find a valid pool " +
-                                  params_->poolName + " in file " +
-                                  params_->fileName)));
-        delete this;
-        return;
-      }
-      // Now we have an array.
-      for (const auto& e : poolMembers) {
-        SocketAddress address;
-        address.setFromHostPort(e.asString());
-        servers.emplace_back(ServerConfig(address.getAddressStr(), address));
-      }
-    } catch (const std::exception& ex) {
-      callback_->serverListError(std::make_exception_ptr(ex));
-      delete this;
-      return;
-    }
-  } else {
-    // Unsupported FileType yet.
-    LOG(FATAL) << "Unsupported FileServerListGenerator::FileType!";
-  }
-
-  VLOG(4) << "Found " << servers.size() << " usable servers from File "
-          << params_->fileName;
-  callback_->serverListAvailable(std::move(servers));
+  // The callback owns a mutable copy; the parse itself is shared
+  callback_->serverListAvailable(*snapshot);
   delete this;
 }
 
@@ -103,11 +49,12 @@ FileServerListGenerator::FileServerListGenerator(const string& fileName,
         "FileServerListGenerator cannot accept an empty poolName parameter "
         "when FileType is JSON.");
   }
+  cache_ = FileServerListCache::get(fileName, fileType, poolName);
 }
 
 void FileServerListGenerator::listServers(Callback* callback,
                                           milliseconds timeout) {
-  auto gen = new FileGenerator(&params_, callback);
+  auto gen = new FileGenerator(&params_, cache_.get(), callback);
   callback->resetGenerator(gen);
   gen->run(timeout);
 }
@@ -9,14 +9,21 @@
 #pragma once
 
 #include "proxygen/lib/pools/generators/ServerListGenerator.h"
+#include <memory>
 #include <proxygen/lib/utils/Exception.h>
 #include <sys/stat.h>
 
 namespace proxygen {
 
+class FileServerListCache;
+
 /*
  * A ServerListGenerator implementation that gets the server list from
  * a file.
+ *
+ * Parsed lists are served from a process-wide cache shared by every
+ * generator reading the same file (see FileServerListCache); the file
+ * is only re-parsed when it changes on disk.
  */
 class FileServerListGenerator : public ServerListGenerator {
  public:
@@ -32,6 +39,15 @@ class FileServerListGenerator : public ServerListGenerator {
   void listServers(Callback* callback,
                    std::chrono::milliseconds timeout) override;
 
+  /**
+   * The cache backing this generator.  Use FileServerListCache::subscribe
+   * on it to be pushed fresh lists when the file changes (e.g. to feed a
+   * PoolHealthChecker) instead of polling listServers.
+   */
+  std::shared_ptr<FileServerListCache> getCache() const {
+    return cache_;
+  }
+
  protected:
   struct Params {
     explicit Params(const std::string& file,
@@ -46,21 +62,24 @@ class FileServerListGenerator : public ServerListGenerator {
 
   class FileGenerator : public ServerListGenerator::Generator {
    public:
-    FileGenerator(Params* params, Callback* callback)
-        : params_(params), callback_(callback) {
+    FileGenerator(Params* params,
+                  FileServerListCache* cache,
+                  Callback* callback)
+        : params_(params), cache_(cache), callback_(callback) {
     }
     virtual ~FileGenerator() override {
     }
-    virtual void readFile(std::string& filePath, std::string& content);
     virtual void run(std::chrono::milliseconds ms);
     virtual void cancelServerListRequest() override;
 
    protected:
     Params* params_;
+    FileServerListCache* cache_;
     Callback* callback_;
   };
 
   Params params_;
+  std::shared_ptr<FileServerListCache> cache_;
 
  private:
   // Forbidden copy constructor and assignment operator
@@ -22,6 +22,39 @@
 
 namespace proxygen {
 
+/**
+ * Kernel TCP tuning for one listener.  The options are applied once to
+ * the bound listening socket; Linux copies them into every socket it
+ * accepts, so a tuned listener costs zero setsockopt calls per
+ * connection.  Zero / empty fields leave the kernel defaults alone.
+ */
+struct TCPTuningProfile {
+  /**
+   * TCP_NOTSENT_LOWAT: cap on unsent bytes queued in the kernel before
+   * the socket stops polling writable.  Keeps latency-sensitive frames
+   * from queueing behind bulk data.  0 = kernel default.
+   */
+  uint32_t notsentLowatBytes{0};
+
+  /**
+   * SO_BUSY_POLL: microseconds to busy-poll the device queue on a
+   * blocking read before sleeping.  0 = disabled.
+   */
+  uint32_t busyPollUs{0};
+
+  /**
+   * TCP_CONGESTION: congestion control algorithm (e.g. "bbr", "cubic").
+   * Must be available in the kernel (/proc/sys/net/ipv4/tcp_allowed_
+   * congestion_control).  Empty = system default.
+   */
+  std::string congestionControl;
+
+  bool empty() const {
+    return notsentLowatBytes == 0 && busyPollUs == 0 &&
+           congestionControl.empty();
+  }
+};
+
 /**
  * Configuration for a single Acceptor.
  *
@@ -100,6 +133,32 @@ struct AcceptorConfiguration : public wangle::ServerSocketConfig {
    * Determines if HTTP2 ping is enabled on connection
    **/
   bool HTTP2PingEnabled{false};
+
+  /**
+   * Adaptive TLS record sizing for sessions accepted here, see
+   * HTTPSession::setTLSRecordSizePolicy().  An initial size of zero
+   * (the default) disables it.
+   */
+  uint32_t tlsRecordInitialSize{0};
+  uint32_t tlsRecordMaxSize{16384};
+  uint64_t tlsRecordBulkThreshold{65536};
+  std::chrono::milliseconds tlsRecordIdleReset{1000};
+
+  /**
+   * Kernel TCP tuning for the listener backing this acceptor; accepted
+   * sockets inherit it.  Defaults to no tuning.
+   */
+  TCPTuningProfile tcpTuning;
+
+  /**
+   * Classify sessions accepted here as bulk ingress (uploads,
+   * replication): their reads are parsed in the worker's
+   * end-of-iteration pass behind every latency-critical session's
+   * reads, capped by a per-tick byte budget.  Only takes effect when an
+   * IngressPriorityScheduler is installed on the acceptor; see
+   * HTTPSessionAcceptor::setIngressPriorityScheduler().
+   */
+  bool bulkIngress{false};
 };
 
 } // namespace proxygen
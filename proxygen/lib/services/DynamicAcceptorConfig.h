@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include <folly/concurrency/AtomicSharedPtr.h>
+#include <proxygen/lib/services/AcceptorConfiguration.h>
+
+namespace proxygen {
+
+/**
+ * Hot-reloadable AcceptorConfiguration, distributed RCU-style.
+ *
+ * The control plane publishes immutable, versioned snapshots via
+ * update(); acceptors check the version with one atomic load on the
+ * accept path and rebind only when it changed, so retuning timeouts or
+ * flow-control windows during an incident takes effect on new sessions
+ * without a restart.  Sessions keep whatever snapshot they were
+ * accepted under; nothing already running is reconfigured.
+ *
+ * Note this only covers fields the acceptor reads at accept time.  The
+ * socket-level parts of the base ServerSocketConfig (bind address,
+ * socket options, TLS contexts) are consumed by wangle::Acceptor at
+ * init and still require a rebind to change.
+ */
+class DynamicAcceptorConfig {
+ public:
+  using Snapshot = std::shared_ptr<const AcceptorConfiguration>;
+
+  explicit DynamicAcceptorConfig(AcceptorConfiguration initial)
+      : current_(
+            std::make_shared<const AcceptorConfiguration>(std::move(initial))) {
+  }
+
+  /**
+   * Current snapshot; safe to call from any thread.  The returned
+   * config is immutable and remains valid for as long as the caller
+   * holds the pointer, even across subsequent update() calls.
+   */
+  Snapshot getSnapshot() const {
+    return current_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Version of the most recently published snapshot; starts at 1.
+   * Acceptors compare this against the version they last bound to make
+   * the unchanged case a single atomic load.
+   */
+  uint64_t getVersion() const {
+    return version_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Publish a new snapshot and return its version.  The snapshot is
+   * stored before the version is bumped, so a reader that observes the
+   * new version always loads the new (or a newer) config.
+   */
+  uint64_t update(AcceptorConfiguration next) {
+    current_.store(std::make_shared<const AcceptorConfiguration>(
+                       std::move(next)),
+                   std::memory_order_release);
+    return version_.fetch_add(1, std::memory_order_release) + 1;
+  }
+
+ private:
+  folly::atomic_shared_ptr<const AcceptorConfiguration> current_;
+  std::atomic<uint64_t> version_{1};
+};
+
+} // namespace proxygen
@@ -11,6 +11,7 @@
 #include <folly/io/async/AsyncServerSocket.h>
 #include <memory>
 #include <proxygen/lib/services/AcceptorConfiguration.h>
+#include <proxygen/lib/services/DynamicAcceptorConfig.h>
 #include <proxygen/lib/utils/AsyncTimeoutSet.h>
 #include <proxygen/lib/utils/WheelTimerInstance.h>
 #include <wangle/acceptor/Acceptor.h>
@@ -35,6 +36,17 @@ class HTTPAcceptor : public wangle::Acceptor {
   const AcceptorConfiguration& getConfig() const {
     return accConfig_;
   }
+
+  /**
+   * Attach a hot-reloadable config source.  When set, the acceptor
+   * rebinds accConfig_ to the latest published snapshot on the accept
+   * path (see refreshAcceptorConfig()), so control-plane updates reach
+   * new sessions without a restart.  The source must outlive the
+   * acceptor; typically one source is shared by every acceptor of a VIP.
+   */
+  void setDynamicConfig(std::shared_ptr<DynamicAcceptorConfig> dynamicConfig) {
+    dynamicConfig_ = std::move(dynamicConfig);
+  }
   const wangle::ServerSocketConfig& getServerSocketConfig() {
     return Acceptor::getConfig();
   }
@@ -47,7 +59,31 @@ class HTTPAcceptor : public wangle::Acceptor {
   }
 
  protected:
+  /**
+   * Rebind accConfig_ to the newest snapshot if the dynamic source has
+   * published one since we last looked.  The unchanged case is a single
+   * atomic version load; acceptors run on their worker's event base, so
+   * the rebind itself is single-threaded.  New sessions created after
+   * the rebind see the new settings; existing sessions are untouched.
+   */
+  void refreshAcceptorConfig() {
+    if (!dynamicConfig_) {
+      return;
+    }
+    auto version = dynamicConfig_->getVersion();
+    if (version == boundConfigVersion_) {
+      return;
+    }
+    accConfig_ = *dynamicConfig_->getSnapshot();
+    boundConfigVersion_ = version;
+    if (timer_) {
+      timer_->setDefaultTimeout(accConfig_.transactionIdleTimeout);
+    }
+  }
+
   AcceptorConfiguration accConfig_;
+  std::shared_ptr<DynamicAcceptorConfig> dynamicConfig_;
+  uint64_t boundConfigVersion_{0};
   std::unique_ptr<WheelTimerInstance> timer_;
 
   virtual std::unique_ptr<WheelTimerInstance> createTransactionTimeoutSet(
@@ -8,9 +8,27 @@
 
 #include <proxygen/lib/services/RequestWorkerThread.h>
 
+#include <algorithm>
+#include <utility>
+
+#include <folly/Indestructible.h>
+#include <folly/Synchronized.h>
 #include <folly/io/async/EventBaseManager.h>
 #include <proxygen/lib/services/ServiceWorker.h>
 
+namespace {
+
+// All live RequestWorkerThreads, for least-loaded placement
+folly::Synchronized<std::vector<proxygen::RequestWorkerThread*>>&
+workerRegistry() {
+  static folly::Indestructible<
+      folly::Synchronized<std::vector<proxygen::RequestWorkerThread*>>>
+      registry;
+  return *registry;
+}
+
+} // namespace
+
 namespace proxygen {
 
 static const uint32_t requestIdBits = 56;
@@ -22,15 +40,55 @@ RequestWorkerThread::RequestWorkerThread(FinishCallback& callback,
     : WorkerThread(folly::EventBaseManager::get(), evbName),
       nextRequestId_(static_cast<uint64_t>(threadId) << requestIdBits),
       callback_(callback) {
+  workerRegistry().wlock()->push_back(this);
 }
 
 RequestWorkerThread::~RequestWorkerThread() {
+  auto registry = workerRegistry().wlock();
+  registry->erase(std::remove(registry->begin(), registry->end(), this),
+                  registry->end());
+  registry.unlock();
   // It is important to reset the underlying event base in advance of this
   // class' destruction as it may be that there are functions awaiting
   // execution that possess a reference to this class.
   resetEventBase();
 }
 
+RequestWorkerThread* RequestWorkerThread::getLeastLoadedWorker() {
+  auto registry = workerRegistry().rlock();
+  // Overloaded workers rank after every cool one; among equals the
+  // smallest load wins.  When every worker is hot this degrades back to
+  // plain least-loaded placement rather than refusing the connection.
+  auto it = std::min_element(registry->begin(),
+                             registry->end(),
+                             [](const RequestWorkerThread* a,
+                                const RequestWorkerThread* b) {
+                               return std::make_pair(a->isOverloaded(),
+                                                     a->getLoad()) <
+                                      std::make_pair(b->isOverloaded(),
+                                                     b->getLoad());
+                             });
+  return (it == registry->end()) ? nullptr : *it;
+}
+
+uint64_t RequestWorkerThread::getGlobalConnectionCount() {
+  auto registry = workerRegistry().rlock();
+  uint64_t total = 0;
+  for (auto* worker : *registry) {
+    total += worker->getConnectionCount();
+  }
+  return total;
+}
+
+uint64_t RequestWorkerThread::getGlobalPendingAcceptCount() {
+  auto registry = workerRegistry().rlock();
+  uint64_t total = 0;
+  for (auto* worker : *registry) {
+    total += worker->getPendingAcceptCount();
+  }
+  return total;
+}
+
 uint8_t RequestWorkerThread::getWorkerId() const {
   return static_cast<uint8_t>(nextRequestId_ >> requestIdBits);
 }
@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <map>
 #include <proxygen/lib/services/WorkerThread.h>
@@ -65,6 +67,98 @@ class RequestWorkerThread : public WorkerThread {
     return self;
   }
 
+  /**
+   * Per-worker load accounting.  Acceptors bump the counter for every
+   * connection (or other load unit) they place on this worker and drop it
+   * when the connection goes away; both ends may run on any thread.
+   */
+  void incrementLoad(uint64_t amount = 1) {
+    load_.fetch_add(amount, std::memory_order_relaxed);
+  }
+
+  void decrementLoad(uint64_t amount = 1) {
+    load_.fetch_sub(amount, std::memory_order_relaxed);
+  }
+
+  uint64_t getLoad() const {
+    return load_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Return the live worker with the smallest load, or nullptr if none are
+   * running.  Sessions stay pinned to their EventBase for their lifetime --
+   * transports, wheel timers and codec state are all thread-bound -- so
+   * imbalance is corrected here, at placement time, by steering each new
+   * connection to the least loaded worker instead of round-robin.
+   *
+   * Workers past their loop-latency shed threshold are passed over while
+   * any cool worker remains, so accepts effectively pause on hot workers.
+   */
+  static RequestWorkerThread* getLeastLoadedWorker();
+
+  /**
+   * Loop-latency overload signal for the acceptor layer.  The watchdog in
+   * WorkerThread publishes the smoothed loop latency of this worker (see
+   * setLoopLatencySampleInterval()); once it exceeds this threshold the
+   * worker reports itself overloaded and acceptors configured to shed
+   * will do so.  A zero threshold (the default) disables the signal.
+   * Both ends may run on any thread.
+   */
+  void setLoopLatencyShedThreshold(std::chrono::microseconds threshold) {
+    loopLatencyShedThresholdUsec_.store(threshold.count(),
+                                        std::memory_order_relaxed);
+  }
+
+  bool isOverloaded() const {
+    auto threshold =
+        loopLatencyShedThresholdUsec_.load(std::memory_order_relaxed);
+    return threshold > 0 &&
+           getAvgLoopLatencyUsec() > static_cast<uint64_t>(threshold);
+  }
+
+  /**
+   * Sharded connection accounting.  Each worker's acceptors bump only the
+   * counters of their own worker -- normally from the worker thread, so
+   * every counter stays in its owner's cache line instead of ping-ponging
+   * a process-wide atomic across all IO threads during accept storms.
+   * Connection-limit enforcement reads the lazily-aggregated global view,
+   * which sums the shards on demand and may therefore trail the true
+   * count by in-flight updates; limits here are approximate by design.
+   */
+  void incrementConnectionCount() {
+    connectionCount_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void decrementConnectionCount() {
+    connectionCount_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  uint64_t getConnectionCount() const {
+    return connectionCount_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Accepted sockets handed to this worker but not yet set up as sessions
+   * (e.g. mid TLS handshake).
+   */
+  void incrementPendingAcceptCount() {
+    pendingAcceptCount_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void decrementPendingAcceptCount() {
+    pendingAcceptCount_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  uint64_t getPendingAcceptCount() const {
+    return pendingAcceptCount_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Sum the per-worker shards over all live workers.
+   */
+  static uint64_t getGlobalConnectionCount();
+  static uint64_t getGlobalPendingAcceptCount();
+
   /**
    * Track the ServiceWorker objects in-use by this worker.
    */
@@ -113,6 +207,17 @@ class RequestWorkerThread : public WorkerThread {
   // the thread id, so is unique across the process.
   uint64_t nextRequestId_;
 
+  // Approximate number of load units currently assigned to this worker
+  std::atomic<uint64_t> load_{0};
+
+  // Sharded connection accounting, see incrementConnectionCount()
+  std::atomic<uint64_t> connectionCount_{0};
+  std::atomic<uint64_t> pendingAcceptCount_{0};
+
+  // Loop latency past which this worker reports itself overloaded, or 0
+  // for no overload signal.  See setLoopLatencyShedThreshold().
+  std::atomic<int64_t> loopLatencyShedThresholdUsec_{0};
+
   // The ServiceWorkers executing in this worker
   std::map<Service*, ServiceWorker*> serviceWorkers_;
 
@@ -10,12 +10,21 @@
 
 #include "folly/io/async/EventBase.h"
 
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
 #include <folly/Portability.h>
 #include <folly/String.h>
 #include <folly/io/async/EventBaseManager.h>
 #include <glog/logging.h>
 #include <signal.h>
 
+#ifdef __linux__
+#include <array>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #if defined(__linux__) && !FOLLY_MOBILE && \
     __has_include(<folly/experimental/io/IoUringBackend.h>)
 #include <folly/experimental/io/IoUringBackend.h>
@@ -59,10 +68,118 @@ std::unique_ptr<folly::EventBaseBackendBase> getEventBaseBackend() {
 } // namespace
 #endif
 
+#ifdef __linux__
+namespace {
+
+std::string numaNodeCpuListPath(int node) {
+  return folly::to<std::string>(
+      "/sys/devices/system/node/node", node, "/cpulist");
+}
+
+// Parse a sysfs cpulist like "0-15,32-47" into a cpu_set_t
+bool parseCpuList(const std::string& cpuList, cpu_set_t& cpuSet) {
+  CPU_ZERO(&cpuSet);
+  std::vector<folly::StringPiece> ranges;
+  folly::split(',', folly::trimWhitespace(cpuList), ranges);
+  for (auto range : ranges) {
+    auto dash = range.find('-');
+    try {
+      if (dash == std::string::npos) {
+        CPU_SET(folly::to<int>(range), &cpuSet);
+      } else {
+        const int first = folly::to<int>(range.subpiece(0, dash));
+        const int last = folly::to<int>(range.subpiece(dash + 1));
+        for (int cpu = first; cpu <= last; cpu++) {
+          CPU_SET(cpu, &cpuSet);
+        }
+      }
+    } catch (const std::exception&) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+#endif
+
 namespace proxygen {
 
 thread_local WorkerThread* WorkerThread::currentWorker_ = nullptr;
 
+std::vector<int> WorkerThread::getNumaNodes() {
+  std::vector<int> nodes;
+#ifdef __linux__
+  std::string cpuList;
+  for (int node = 0; folly::readFile(numaNodeCpuListPath(node).c_str(), cpuList);
+       node++) {
+    nodes.push_back(node);
+  }
+#endif
+  return nodes;
+}
+
+bool WorkerThread::bindCurrentThreadToNumaNode(int node) {
+#ifdef __linux__
+  std::string cpuList;
+  if (!folly::readFile(numaNodeCpuListPath(node).c_str(), cpuList)) {
+    return false;
+  }
+  cpu_set_t cpuSet;
+  if (!parseCpuList(cpuList, cpuSet) || CPU_COUNT(&cpuSet) == 0) {
+    return false;
+  }
+  if (pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) != 0) {
+    PLOG(WARNING) << "Failed to pin thread to CPUs of NUMA node " << node;
+    return false;
+  }
+  // Prefer node-local memory so the buffers this thread touches first are
+  // allocated on its own node; unlike MPOL_BIND this falls back to remote
+  // nodes under memory pressure instead of failing allocations.  The raw
+  // syscall avoids a libnuma dependency.
+  constexpr int kMpolPreferred = 1; // MPOL_PREFERRED from linux/mempolicy.h
+  constexpr size_t kBitsPerWord = sizeof(unsigned long) * 8;
+  std::array<unsigned long, 16> nodeMask{};
+  if (static_cast<size_t>(node) >= nodeMask.size() * kBitsPerWord) {
+    return false;
+  }
+  nodeMask[node / kBitsPerWord] = 1UL << (node % kBitsPerWord);
+  if (syscall(SYS_set_mempolicy,
+              kMpolPreferred,
+              nodeMask.data(),
+              nodeMask.size() * kBitsPerWord) != 0) {
+    PLOG(WARNING) << "Failed to set memory policy for NUMA node " << node;
+    return false;
+  }
+  return true;
+#else
+  (void)node;
+  return false;
+#endif
+}
+
+std::unique_ptr<folly::EventBaseBackendBase> WorkerThread::createIoUringBackend(
+    size_t capacity) {
+#if defined(__linux__) && !FOLLY_MOBILE && \
+    __has_include(<folly/experimental/io/IoUringBackend.h>)
+  if (capacity > 0) {
+    try {
+      folly::PollIoBackend::Options options;
+      options.setCapacity(capacity)
+          .setMaxSubmit(static_cast<size_t>(FLAGS_pwt_io_uring_max_submit))
+          .setMaxGet(static_cast<size_t>(FLAGS_pwt_io_uring_max_get))
+          .setUseRegisteredFds(FLAGS_pwt_io_uring_use_registered_fds);
+      return std::make_unique<folly::IoUringBackend>(options);
+    } catch (const std::exception& ex) {
+      LOG(WARNING) << "Failure creating io_uring backend: " << ex.what();
+    }
+  }
+#else
+  (void)capacity;
+#endif
+  return nullptr;
+}
+
 WorkerThread::WorkerThread(folly::EventBaseManager* eventBaseManager,
                            const std::string& evbName)
     : eventBaseManager_(eventBaseManager),
@@ -165,6 +282,12 @@ void WorkerThread::setup() {
   PCHECK(pthread_sigmask(SIG_BLOCK, &ss, nullptr) == 0);
 #endif
 
+  // Bind to the requested NUMA node before anything is allocated, so
+  // first-touch puts this worker's memory on its own node
+  if (numaNode_ >= 0 && !bindCurrentThreadToNumaNode(numaNode_)) {
+    LOG(WARNING) << "Failed to bind worker thread to NUMA node " << numaNode_;
+  }
+
   // Update the currentWorker_ thread-local pointer
   CHECK(nullptr == currentWorker_);
   currentWorker_ = this;
@@ -186,6 +309,23 @@ void WorkerThread::resetEventBase() {
   eventBase_.reset();
 }
 
+void WorkerThread::scheduleLoopLatencySample() {
+  // Scheduled as an internal event so the watchdog does not hold the loop
+  // open once stopWhenIdle() starts draining the remaining external events
+  eventBase_->runAfterDelay(
+      [this] {
+        if (state_ != State::RUNNING) {
+          return;
+        }
+        avgLoopLatencyUsec_.store(
+            static_cast<uint64_t>(eventBase_->getAvgLoopTime()),
+            std::memory_order_relaxed);
+        scheduleLoopLatencySample();
+      },
+      static_cast<uint32_t>(loopLatencySampleInterval_.count()),
+      folly::TimeoutManager::InternalEnum::INTERNAL);
+}
+
 void WorkerThread::runLoop() {
   // Update state_
   CHECK(state_ == State::STARTING);
@@ -193,6 +333,10 @@ void WorkerThread::runLoop() {
 
   VLOG(1) << "WorkerThread " << this << " starting";
 
+  if (loopLatencySampleInterval_.count() > 0) {
+    scheduleLoopLatencySample();
+  }
+
   // Call loopForever().  This will only return after stopWhenIdle() or
   // forceStop() has been called.
   eventBase_->loopForever();
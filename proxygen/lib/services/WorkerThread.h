@@ -9,11 +9,13 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <folly/Portability.h>
 #include <folly/io/async/EventBase.h>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 namespace folly {
 class EventBaseManager;
@@ -111,6 +113,60 @@ class WorkerThread {
     return currentWorker_;
   }
 
+  /**
+   * Request that this worker be bound to the given NUMA node before its
+   * loop starts.  The worker's thread is pinned to the node's CPUs and its
+   * allocations are preferentially served from the node's local memory, so
+   * the IO buffers it touches first stay node-local.  Must be called
+   * before start().
+   */
+  void setNumaNode(int node) {
+    CHECK(state_ == State::IDLE);
+    numaNode_ = node;
+  }
+
+  /**
+   * Enable the loop-latency watchdog: every interval, the worker samples
+   * the EventBase's smoothed loop time and publishes it for readers on
+   * other threads.  An interval of zero (the default) disables sampling.
+   * Must be called before start().
+   */
+  void setLoopLatencySampleInterval(std::chrono::milliseconds interval) {
+    CHECK(state_ == State::IDLE);
+    loopLatencySampleInterval_ = interval;
+  }
+
+  /**
+   * Smoothed event-loop latency in microseconds as of the last watchdog
+   * sample, or 0 if sampling is disabled or no sample has been taken yet.
+   * May be read from any thread.
+   */
+  uint64_t getAvgLoopLatencyUsec() const {
+    return avgLoopLatencyUsec_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * The NUMA nodes of this machine in ascending order, discovered via
+   * sysfs.  Empty on platforms that expose no topology.
+   */
+  static std::vector<int> getNumaNodes();
+
+  /**
+   * Pin the calling thread to the CPUs of the given NUMA node and prefer
+   * node-local memory for its future allocations (first touch).  Returns
+   * false if the topology could not be read or binding failed.
+   */
+  static bool bindCurrentThreadToNumaNode(int node);
+
+  /**
+   * Create an io_uring EventBase backend with the given submission queue
+   * capacity.  Returns nullptr when io_uring is unsupported on this
+   * platform or build, when capacity is 0, or when ring setup fails;
+   * callers should fall back to EventBase::getDefaultBackend().
+   */
+  static std::unique_ptr<folly::EventBaseBackendBase> createIoUringBackend(
+      size_t capacity);
+
  protected:
   virtual void setup();
   virtual void cleanup();
@@ -137,7 +193,18 @@ class WorkerThread {
 
   void runLoop();
 
+  /**
+   * Schedule the next watchdog sample on the event base.  Runs in the
+   * worker thread; reschedules itself while the loop is running.
+   */
+  void scheduleLoopLatencySample();
+
   State state_{State::IDLE};
+  // NUMA node to bind to during setup(), or -1 for no binding
+  int numaNode_{-1};
+  // Loop-latency watchdog, see setLoopLatencySampleInterval()
+  std::chrono::milliseconds loopLatencySampleInterval_{0};
+  std::atomic<uint64_t> avgLoopLatencyUsec_{0};
   std::thread thread_;
   std::mutex joinLock_;
   folly::EventBaseManager* eventBaseManager_{nullptr};
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include <folly/io/async/EventBaseManager.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/services/WorkerThread.h>
+
+using namespace proxygen;
+
+TEST(WorkerThreadTest, NumaTopology) {
+  auto nodes = WorkerThread::getNumaNodes();
+#ifdef __linux__
+  // every Linux machine exposes at least node0
+  ASSERT_FALSE(nodes.empty());
+  EXPECT_TRUE(std::is_sorted(nodes.begin(), nodes.end()));
+#else
+  EXPECT_TRUE(nodes.empty());
+#endif
+}
+
+TEST(WorkerThreadTest, LoopLatencyWatchdog) {
+  folly::EventBaseManager ebm;
+  WorkerThread worker(&ebm);
+  worker.setLoopLatencySampleInterval(std::chrono::milliseconds(1));
+  worker.start();
+
+  // Give the loop something to chew on so the smoothed loop time is nonzero
+  for (int i = 0; i < 20; i++) {
+    worker.getEventBase()->runInEventBaseThread(
+        [] { std::this_thread::sleep_for(std::chrono::milliseconds(2)); });
+  }
+
+  // The watchdog publishes asynchronously; poll until a sample lands
+  uint64_t sampled = 0;
+  for (int i = 0; i < 200 && sampled == 0; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    sampled = worker.getAvgLoopLatencyUsec();
+  }
+  EXPECT_GT(sampled, 0);
+
+  worker.stopWhenIdle();
+  worker.wait();
+}
+
+TEST(WorkerThreadTest, NumaBoundWorker) {
+  auto nodes = WorkerThread::getNumaNodes();
+  if (nodes.empty()) {
+    // platform without NUMA topology
+    return;
+  }
+
+  // Binding is best-effort (it can fail in restricted environments); the
+  // worker must come up and serve its loop either way
+  folly::EventBaseManager ebm;
+  WorkerThread worker(&ebm);
+  worker.setNumaNode(nodes.front());
+  worker.start();
+
+  bool ran = false;
+  worker.getEventBase()->runInEventBaseThreadAndWait([&] { ran = true; });
+  EXPECT_TRUE(ran);
+
+  worker.stopWhenIdle();
+  worker.wait();
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/ssl/SNIRoutingCache.h>
+
+#include <folly/String.h>
+
+namespace proxygen {
+
+namespace {
+
+std::string normalizeName(folly::StringPiece name) {
+  std::string lowered = name.str();
+  folly::toLowerAscii(lowered);
+  // a trailing dot in the client hello denotes the same name
+  if (!lowered.empty() && lowered.back() == '.') {
+    lowered.pop_back();
+  }
+  return lowered;
+}
+
+} // namespace
+
+void SNIRoutingCache::setMappings(
+    const std::vector<std::pair<std::string, ContextPtr>>& mappings) {
+  auto snapshot = std::make_shared<Snapshot>();
+  snapshot->exact.reserve(mappings.size());
+  for (const auto& mapping : mappings) {
+    auto name = normalizeName(mapping.first);
+    if (name.size() > 2 && name[0] == '*' && name[1] == '.') {
+      snapshot->wildcard[name.substr(2)] = mapping.second;
+    } else {
+      snapshot->exact[std::move(name)] = mapping.second;
+    }
+  }
+  auto locked = snapshot_.wlock();
+  snapshot->version = version_.load(std::memory_order_relaxed) + 1;
+  *locked = std::move(snapshot);
+  // publish the version only after the snapshot is in place so a reader
+  // that sees the new version finds at least that snapshot
+  version_.store((*locked)->version, std::memory_order_release);
+}
+
+SNIRoutingCache::ContextPtr SNIRoutingCache::lookup(
+    folly::StringPiece sni) const {
+  if (sni.empty()) {
+    return nullptr;
+  }
+  const auto name = normalizeName(sni);
+  const auto version = version_.load(std::memory_order_acquire);
+  auto& workerCache = *workerCache_;
+  if (workerCache.version == version) {
+    auto cached = workerCache.resolved.find(name);
+    if (cached != workerCache.resolved.end()) {
+      return cached->second;
+    }
+  } else {
+    workerCache.resolved.clear();
+    workerCache.version = version;
+  }
+
+  std::shared_ptr<const Snapshot> snapshot = snapshot_.copy();
+  if (!snapshot) {
+    return nullptr;
+  }
+  auto context = resolve(*snapshot, name);
+  // negative results are cached too: a flood of handshakes for an
+  // unknown name should not keep hitting the shared snapshot
+  if (snapshot->version == workerCache.version) {
+    workerCache.resolved.emplace(name, context);
+  }
+  return context;
+}
+
+SNIRoutingCache::ContextPtr SNIRoutingCache::resolve(
+    const Snapshot& snapshot, const std::string& name) const {
+  auto exact = snapshot.exact.find(name);
+  if (exact != snapshot.exact.end()) {
+    return exact->second;
+  }
+  // "*.suffix" matches exactly one extra label: strip the leftmost label
+  // and probe the suffix table
+  auto firstDot = name.find('.');
+  if (firstDot != std::string::npos && firstDot + 1 < name.size()) {
+    auto wildcard = snapshot.wildcard.find(name.substr(firstDot + 1));
+    if (wildcard != snapshot.wildcard.end()) {
+      return wildcard->second;
+    }
+  }
+  return nullptr;
+}
+
+} // namespace proxygen
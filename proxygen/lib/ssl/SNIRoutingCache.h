@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <folly/ThreadLocal.h>
+#include <folly/io/async/SSLContext.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace proxygen {
+
+/**
+ * Read-mostly SNI -> SSL context routing table for multi-tenant TLS
+ * termination.
+ *
+ * Lookups resolve against an immutable snapshot; a reload builds the
+ * replacement off to the side and publishes it with a pointer swap, so
+ * accepts are never paused and in-flight handshakes keep the snapshot
+ * they started with until their reference drops.  Wildcard entries
+ * ("*.example.com") are pre-split at build time into a suffix table,
+ * making a cold lookup at most two hash probes.  Each worker thread
+ * additionally memoizes the name -> context resolutions it has made
+ * against the current snapshot version, so on a stable config the
+ * per-handshake cost is a single thread-local probe with no shared
+ * state touched.
+ */
+class SNIRoutingCache {
+ public:
+  using ContextPtr = std::shared_ptr<folly::SSLContext>;
+
+  /**
+   * Atomically replace the routing table.  Names match case
+   * insensitively.  A leading "*." matches exactly one additional label:
+   * "*.example.com" covers "a.example.com" but not "a.b.example.com" or
+   * "example.com" itself; add an exact entry for the apex if needed.
+   * Duplicate names keep the last context given.  Safe to call while
+   * lookups are in flight; concurrent reloads serialize on publication.
+   */
+  void setMappings(
+      const std::vector<std::pair<std::string, ContextPtr>>& mappings);
+
+  /**
+   * Resolve an SNI name to its context, preferring an exact match over a
+   * wildcard one.  Returns nullptr if nothing matches.
+   */
+  ContextPtr lookup(folly::StringPiece sni) const;
+
+  /**
+   * Monotonic snapshot version; bumps on every setMappings().
+   */
+  uint64_t getVersion() const {
+    return version_.load(std::memory_order_acquire);
+  }
+
+ private:
+  struct Snapshot {
+    uint64_t version{0};
+    std::unordered_map<std::string, ContextPtr> exact;
+    // keyed by the label suffix after "*." of wildcard entries
+    std::unordered_map<std::string, ContextPtr> wildcard;
+  };
+
+  // Per-worker memo of resolutions made against one snapshot version;
+  // invalidated wholesale when the version moves.  Bounded by the number
+  // of distinct names the worker actually serves.
+  struct WorkerCache {
+    uint64_t version{0};
+    std::unordered_map<std::string, ContextPtr> resolved;
+  };
+
+  ContextPtr resolve(const Snapshot& snapshot, const std::string& name) const;
+
+  folly::Synchronized<std::shared_ptr<const Snapshot>> snapshot_;
+  std::atomic<uint64_t> version_{0};
+  folly::ThreadLocal<WorkerCache> workerCache_;
+};
+
+} // namespace proxygen
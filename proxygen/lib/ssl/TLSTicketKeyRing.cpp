@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/ssl/TLSTicketKeyRing.h>
+
+#include <folly/io/async/AsyncTimeout.h>
+#include <openssl/crypto.h>
+
+#include <proxygen/lib/http/stats/ConnectionStats.h>
+
+namespace proxygen {
+
+struct TLSTicketKeyRing::Ring {
+  ~Ring() {
+    // best-effort scrub of retired keying material
+    for (auto& key : keys) {
+      if (!key.secret.empty()) {
+        OPENSSL_cleanse(&key.secret[0], key.secret.size());
+      }
+    }
+  }
+
+  uint64_t version{0};
+  std::vector<TLSTicketKey> keys;
+};
+
+class TLSTicketKeyRing::Rotator : public folly::AsyncTimeout {
+ public:
+  Rotator(folly::EventBase* eventBase,
+          TLSTicketKeyRing& ring,
+          std::chrono::milliseconds interval,
+          folly::Function<TLSTicketKey()> keyGen)
+      : folly::AsyncTimeout(eventBase),
+        ring_(ring),
+        interval_(interval),
+        keyGen_(std::move(keyGen)) {
+    scheduleTimeout(interval_);
+  }
+
+  void timeoutExpired() noexcept override {
+    ring_.rotate(keyGen_());
+    scheduleTimeout(interval_);
+  }
+
+ private:
+  TLSTicketKeyRing& ring_;
+  std::chrono::milliseconds interval_;
+  folly::Function<TLSTicketKey()> keyGen_;
+};
+
+TLSTicketKeyRing::TLSTicketKeyRing(size_t maxKeys, ConnectionStats* stats)
+    : maxKeys_(maxKeys), stats_(stats) {
+  CHECK_GT(maxKeys_, 0);
+}
+
+TLSTicketKeyRing::~TLSTicketKeyRing() {
+}
+
+void TLSTicketKeyRing::setKeys(std::vector<TLSTicketKey> keys) {
+  std::lock_guard<std::mutex> guard(writeLock_);
+  publish(std::move(keys));
+}
+
+void TLSTicketKeyRing::rotate(TLSTicketKey newKey) {
+  {
+    std::lock_guard<std::mutex> guard(writeLock_);
+    std::vector<TLSTicketKey> keys;
+    keys.push_back(std::move(newKey));
+    auto current = ring_.load(std::memory_order_acquire);
+    if (current) {
+      keys.insert(keys.end(), current->keys.begin(), current->keys.end());
+    }
+    publish(std::move(keys));
+  }
+  if (stats_) {
+    stats_->recordTLSTicketRotation();
+  }
+}
+
+std::shared_ptr<const TLSTicketKey> TLSTicketKeyRing::getEncryptionKey()
+    const {
+  auto ring = ring_.load(std::memory_order_acquire);
+  if (!ring || ring->keys.empty()) {
+    return nullptr;
+  }
+  // alias the snapshot so the key outlives any concurrent rotation
+  return std::shared_ptr<const TLSTicketKey>(ring, &ring->keys.front());
+}
+
+std::shared_ptr<const TLSTicketKey> TLSTicketKeyRing::findDecryptionKey(
+    folly::StringPiece name) const {
+  auto ring = ring_.load(std::memory_order_acquire);
+  if (!ring) {
+    return nullptr;
+  }
+  for (const auto& key : ring->keys) {
+    if (name == key.name) {
+      return std::shared_ptr<const TLSTicketKey>(ring, &key);
+    }
+  }
+  return nullptr;
+}
+
+uint64_t TLSTicketKeyRing::getVersion() const {
+  auto ring = ring_.load(std::memory_order_acquire);
+  return ring ? ring->version : 0;
+}
+
+void TLSTicketKeyRing::scheduleRotations(
+    folly::EventBase* eventBase,
+    std::chrono::milliseconds interval,
+    folly::Function<TLSTicketKey()> keyGen) {
+  rotator_ =
+      std::make_unique<Rotator>(eventBase, *this, interval, std::move(keyGen));
+}
+
+void TLSTicketKeyRing::cancelRotations() {
+  rotator_.reset();
+}
+
+void TLSTicketKeyRing::publish(std::vector<TLSTicketKey> keys) {
+  // caller holds writeLock_
+  if (keys.size() > maxKeys_) {
+    keys.resize(maxKeys_);
+  }
+  auto current = ring_.load(std::memory_order_acquire);
+  auto next = std::make_shared<Ring>();
+  next->version = (current ? current->version : 0) + 1;
+  next->keys = std::move(keys);
+  ring_.store(std::move(next), std::memory_order_release);
+}
+
+} // namespace proxygen
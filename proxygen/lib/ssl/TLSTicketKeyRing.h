@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <folly/Function.h>
+#include <folly/Range.h>
+#include <folly/concurrency/AtomicSharedPtr.h>
+#include <folly/io/async/EventBase.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace proxygen {
+
+class ConnectionStats;
+
+/**
+ * One session ticket key: the opaque key_name that goes on the wire and
+ * the keying material the ticket cipher/HMAC keys are derived from.
+ */
+struct TLSTicketKey {
+  std::string name;
+  std::string secret;
+};
+
+/**
+ * Lock-free session ticket key ring for multi-tenant TLS termination.
+ *
+ * The ring is an immutable, versioned key array published RCU-style:
+ * handshake threads pick up the current ring with a single atomic
+ * shared_ptr load and never take a lock.  The first key encrypts new
+ * tickets; decryption scans the (short) array for the key_name the
+ * client presented, so tickets issued under the previous few keys keep
+ * resuming across rotations.  Writers -- config pushes via setKeys()
+ * and timer-driven rotate() -- build the replacement ring off to the
+ * side and serialize only against each other; in-flight handshakes
+ * keep the snapshot they loaded until their reference drops.
+ *
+ * Rotations are counted through ConnectionStats (resumption hit/miss
+ * is already recorded there by the handshake layer), so a rotation
+ * that outruns the ticket lifetime shows up as a miss-rate step next
+ * to the rotation that caused it.
+ */
+class TLSTicketKeyRing {
+ public:
+  /**
+   * @param maxKeys  Ring capacity: one encryption key plus maxKeys - 1
+   *                 decrypt-only predecessors.
+   */
+  explicit TLSTicketKeyRing(size_t maxKeys = 3,
+                            ConnectionStats* stats = nullptr);
+  ~TLSTicketKeyRing();
+
+  /**
+   * Replace the ring wholesale; keys[0] becomes the encryption key.
+   * Keys beyond maxKeys are dropped.  Safe to call concurrently with
+   * reads and with rotate().
+   */
+  void setKeys(std::vector<TLSTicketKey> keys);
+
+  /**
+   * Push a fresh encryption key; the oldest key falls off once the
+   * ring is full.
+   */
+  void rotate(TLSTicketKey newKey);
+
+  /**
+   * Current encryption key, or nullptr if no keys have been set.  The
+   * returned pointer keeps its ring snapshot alive, so it stays valid
+   * across concurrent rotations.
+   */
+  std::shared_ptr<const TLSTicketKey> getEncryptionKey() const;
+
+  /**
+   * Find the key a presented ticket was encrypted under, or nullptr if
+   * it has aged off the ring (forcing a full handshake).
+   */
+  std::shared_ptr<const TLSTicketKey> findDecryptionKey(
+      folly::StringPiece name) const;
+
+  /**
+   * Monotonic ring version; bumps on every setKeys() / rotate().
+   */
+  uint64_t getVersion() const;
+
+  /**
+   * Rotate every interval with a key from keyGen, without touching the
+   * handshake path.  Must be called from the EventBase thread, as must
+   * cancelRotations(); keyGen runs there too.
+   */
+  void scheduleRotations(folly::EventBase* eventBase,
+                         std::chrono::milliseconds interval,
+                         folly::Function<TLSTicketKey()> keyGen);
+
+  void cancelRotations();
+
+ private:
+  struct Ring;
+  class Rotator;
+
+  void publish(std::vector<TLSTicketKey> keys);
+
+  const size_t maxKeys_;
+  ConnectionStats* stats_{nullptr};
+  folly::atomic_shared_ptr<const Ring> ring_;
+  // serializes writers only; readers never touch it
+  std::mutex writeLock_;
+  std::unique_ptr<Rotator> rotator_;
+};
+
+} // namespace proxygen
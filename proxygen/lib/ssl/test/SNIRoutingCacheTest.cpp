@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/ssl/SNIRoutingCache.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+
+namespace {
+
+SNIRoutingCache::ContextPtr makeContext() {
+  return std::make_shared<folly::SSLContext>();
+}
+
+} // namespace
+
+TEST(SNIRoutingCacheTest, ExactAndWildcardMatching) {
+  SNIRoutingCache cache;
+  auto apex = makeContext();
+  auto exact = makeContext();
+  auto wild = makeContext();
+  cache.setMappings({{"example.com", apex},
+                     {"www.example.com", exact},
+                     {"*.example.com", wild}});
+
+  // exact match wins over the covering wildcard
+  EXPECT_EQ(cache.lookup("www.example.com"), exact);
+  EXPECT_EQ(cache.lookup("example.com"), apex);
+  // wildcard covers exactly one extra label
+  EXPECT_EQ(cache.lookup("a.example.com"), wild);
+  EXPECT_EQ(cache.lookup("a.b.example.com"), nullptr);
+  EXPECT_EQ(cache.lookup("other.net"), nullptr);
+  EXPECT_EQ(cache.lookup(""), nullptr);
+}
+
+TEST(SNIRoutingCacheTest, CaseAndTrailingDotInsensitive) {
+  SNIRoutingCache cache;
+  auto ctx = makeContext();
+  cache.setMappings({{"Secure.Example.COM", ctx}});
+
+  EXPECT_EQ(cache.lookup("secure.example.com"), ctx);
+  EXPECT_EQ(cache.lookup("SECURE.EXAMPLE.COM"), ctx);
+  EXPECT_EQ(cache.lookup("secure.example.com."), ctx);
+}
+
+TEST(SNIRoutingCacheTest, HotReloadInvalidatesWorkerCache) {
+  SNIRoutingCache cache;
+  auto oldCtx = makeContext();
+  cache.setMappings({{"tenant.example.com", oldCtx}});
+  EXPECT_EQ(cache.getVersion(), 1);
+
+  // prime the per-worker memo, including a negative entry
+  EXPECT_EQ(cache.lookup("tenant.example.com"), oldCtx);
+  EXPECT_EQ(cache.lookup("new.example.com"), nullptr);
+
+  auto newCtx = makeContext();
+  cache.setMappings(
+      {{"tenant.example.com", newCtx}, {"new.example.com", newCtx}});
+  EXPECT_EQ(cache.getVersion(), 2);
+
+  EXPECT_EQ(cache.lookup("tenant.example.com"), newCtx);
+  EXPECT_EQ(cache.lookup("new.example.com"), newCtx);
+}
+
+TEST(SNIRoutingCacheTest, EmptyCache) {
+  SNIRoutingCache cache;
+  EXPECT_EQ(cache.lookup("example.com"), nullptr);
+  EXPECT_EQ(cache.getVersion(), 0);
+}
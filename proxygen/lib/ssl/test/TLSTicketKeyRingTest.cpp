@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/ssl/TLSTicketKeyRing.h>
+
+#include <folly/Conv.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/http/stats/ConnectionStats.h>
+
+using namespace proxygen;
+
+namespace {
+
+TLSTicketKey makeKey(const std::string& name) {
+  return TLSTicketKey{name, "secret-" + name};
+}
+
+// Counts rotations; everything else is noise for these tests
+class FakeConnectionStats : public ConnectionStats {
+ public:
+  void recordConnectionOpen() override {
+  }
+  void recordConnectionClose() override {
+  }
+  void recordRequest() override {
+  }
+  void recordResponse(folly::Optional<uint16_t>) override {
+  }
+  void recordDuration(size_t) override {
+  }
+  void addEgressBytes(size_t) override {
+  }
+  void addIngressBytes(size_t) override {
+  }
+  void addEgressBodyBytes(size_t) override {
+  }
+  void addIngressBodyBytes(size_t) override {
+  }
+  void recordTLSResumption(bool) override {
+  }
+  void recordTLSZeroRtt(bool) override {
+  }
+  void recordTLSHandshakeCpuTime(size_t) override {
+  }
+  void recordTLSCipher(folly::StringPiece) override {
+  }
+  void recordTLSNamedGroup(folly::StringPiece) override {
+  }
+  void recordTLSTicketRotation() override {
+    rotations++;
+  }
+
+  uint32_t rotations{0};
+};
+
+} // namespace
+
+TEST(TLSTicketKeyRingTest, EncryptsWithNewestDecryptsWithRecent) {
+  TLSTicketKeyRing ring;
+  EXPECT_EQ(ring.getEncryptionKey(), nullptr);
+  EXPECT_EQ(ring.getVersion(), 0);
+
+  ring.setKeys({makeKey("current"), makeKey("previous")});
+  EXPECT_EQ(ring.getVersion(), 1);
+  ASSERT_NE(ring.getEncryptionKey(), nullptr);
+  EXPECT_EQ(ring.getEncryptionKey()->name, "current");
+  EXPECT_NE(ring.findDecryptionKey("previous"), nullptr);
+  EXPECT_EQ(ring.findDecryptionKey("aged-off"), nullptr);
+}
+
+TEST(TLSTicketKeyRingTest, RotationTrimsOldest) {
+  FakeConnectionStats stats;
+  TLSTicketKeyRing ring(3, &stats);
+  ring.setKeys({makeKey("k1")});
+
+  ring.rotate(makeKey("k2"));
+  ring.rotate(makeKey("k3"));
+  ring.rotate(makeKey("k4"));
+  EXPECT_EQ(stats.rotations, 3);
+  EXPECT_EQ(ring.getVersion(), 4);
+
+  EXPECT_EQ(ring.getEncryptionKey()->name, "k4");
+  EXPECT_NE(ring.findDecryptionKey("k3"), nullptr);
+  EXPECT_NE(ring.findDecryptionKey("k2"), nullptr);
+  // k1 fell off the ring; tickets it issued take a full handshake
+  EXPECT_EQ(ring.findDecryptionKey("k1"), nullptr);
+}
+
+TEST(TLSTicketKeyRingTest, SnapshotSurvivesRotation) {
+  TLSTicketKeyRing ring;
+  ring.setKeys({makeKey("old")});
+
+  auto held = ring.getEncryptionKey();
+  ring.rotate(makeKey("new"));
+
+  // an in-flight handshake keeps the snapshot it loaded
+  EXPECT_EQ(held->name, "old");
+  EXPECT_EQ(held->secret, "secret-old");
+  EXPECT_EQ(ring.getEncryptionKey()->name, "new");
+}
+
+TEST(TLSTicketKeyRingTest, TimerDrivenRotation) {
+  folly::EventBase eventBase;
+  TLSTicketKeyRing ring;
+  ring.setKeys({makeKey("seed")});
+
+  uint32_t generated = 0;
+  ring.scheduleRotations(&eventBase, std::chrono::milliseconds(1), [&] {
+    return makeKey(folly::to<std::string>("gen", ++generated));
+  });
+  eventBase.runAfterDelay(
+      [&] {
+        ring.cancelRotations();
+        eventBase.terminateLoopSoon();
+      },
+      20);
+  eventBase.loop();
+
+  EXPECT_GE(generated, 1);
+  EXPECT_EQ(ring.getEncryptionKey()->name,
+            folly::to<std::string>("gen", generated));
+}
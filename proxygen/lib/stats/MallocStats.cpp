@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "proxygen/lib/stats/MallocStats.h"
+
+#include <folly/Conv.h>
+#include <folly/memory/MallctlHelper.h>
+#include <folly/memory/Malloc.h>
+
+namespace proxygen {
+
+MallocStats collectMallocStats() {
+  MallocStats stats;
+  if (!folly::usingJEMalloc()) {
+    return stats;
+  }
+  try {
+    // stats.* values are cached by jemalloc and only refreshed when the
+    // epoch is advanced
+    folly::mallctlWrite<uint64_t>("epoch", 1);
+
+    size_t allocated = 0;
+    size_t active = 0;
+    size_t resident = 0;
+    folly::mallctlRead("stats.allocated", &allocated);
+    folly::mallctlRead("stats.active", &active);
+    folly::mallctlRead("stats.resident", &resident);
+    stats.allocatedBytes = allocated;
+    stats.activeBytes = active;
+    stats.residentBytes = resident;
+    stats.collected = true;
+
+    unsigned narenas = 0;
+    size_t pageSize = 0;
+    folly::mallctlRead("arenas.narenas", &narenas);
+    folly::mallctlRead("arenas.page", &pageSize);
+    stats.arenaAllocatedBytes.reserve(narenas);
+    stats.arenaResidentBytes.reserve(narenas);
+    for (unsigned i = 0; i < narenas; i++) {
+      size_t small = 0;
+      size_t large = 0;
+      size_t pactive = 0;
+      size_t pdirty = 0;
+      auto prefix = folly::to<std::string>("stats.arenas.", i, ".");
+      try {
+        folly::mallctlRead((prefix + "small.allocated").c_str(), &small);
+        folly::mallctlRead((prefix + "large.allocated").c_str(), &large);
+        folly::mallctlRead((prefix + "pactive").c_str(), &pactive);
+        folly::mallctlRead((prefix + "pdirty").c_str(), &pdirty);
+      } catch (const std::runtime_error&) {
+        // uninitialized arena: report it as empty so indexes stay stable
+      }
+      stats.arenaAllocatedBytes.push_back(small + large);
+      stats.arenaResidentBytes.push_back((pactive + pdirty) * pageSize);
+    }
+  } catch (const std::runtime_error&) {
+    // jemalloc built without stats support; report what we have (nothing
+    // if the process-wide reads were what failed)
+    stats.arenaAllocatedBytes.clear();
+    stats.arenaResidentBytes.clear();
+  }
+  return stats;
+}
+
+} // namespace proxygen
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace proxygen {
+
+/**
+ * Point-in-time snapshot of allocator state, read from jemalloc's stats
+ * interface.  Process RSS lags the allocator and hides per-arena
+ * imbalance; these numbers come straight from the allocator's own
+ * accounting.  'collected' stays false when the process is not running
+ * on jemalloc (or jemalloc was built without stats), in which case
+ * every field is zero.
+ *
+ * The per-arena vectors are indexed by arena.  jemalloc spreads threads
+ * across arenas, so with narenas sized to the worker count (and workers
+ * being the only allocating threads) the arena breakdown approximates a
+ * per-worker one.
+ */
+struct MallocStats {
+  bool collected{false};
+
+  // Bytes in live allocations, bytes in pages backing them, and bytes
+  // physically resident.  allocated <= active <= resident.
+  uint64_t allocatedBytes{0};
+  uint64_t activeBytes{0};
+  uint64_t residentBytes{0};
+
+  std::vector<uint64_t> arenaAllocatedBytes;
+  std::vector<uint64_t> arenaResidentBytes;
+
+  /**
+   * Fraction of active pages not covered by live allocations (0-1.0);
+   * the allocator-internal fragmentation RSS can never show.
+   */
+  double getFragmentationRatio() const {
+    if (activeBytes == 0) {
+      return 0.0;
+    }
+    return 1.0 - static_cast<double>(allocatedBytes) / activeBytes;
+  }
+};
+
+/**
+ * Samples the current MallocStats.  Cheap enough to call on every stats
+ * refresh cycle; advances jemalloc's epoch so the numbers are current.
+ */
+MallocStats collectMallocStats();
+
+} // namespace proxygen
@@ -12,6 +12,7 @@
 #include <stdint.h>
 #include <vector>
 
+#include "proxygen/lib/stats/MallocStats.h"
 #include "proxygen/lib/stats/PeriodicStatsDataBase.h"
 
 namespace proxygen {
@@ -70,6 +71,37 @@ struct ResourceData : public PeriodicStatsDataBase {
     return softIrqCpuCoreRatioUtils_.size();
   }
 
+  /**
+   * Gets the cpu ratio utilization (0, 1.0 over the last update interval)
+   * for each NUMA node, indexed by node id.  Empty if the deployment does
+   * not collect per-node data.
+   */
+  const std::vector<double>& getNumaNodeCpuRatioUtils() const {
+    return numaNodeCpuRatioUtils_;
+  }
+
+  /**
+   * Gets the used memory in bytes for each NUMA node, indexed by node id.
+   */
+  const std::vector<uint64_t>& getNumaNodeUsedMemBytes() const {
+    return numaNodeUsedMemBytes_;
+  }
+
+  /**
+   * Gets the total memory in bytes for each NUMA node, indexed by node id.
+   */
+  const std::vector<uint64_t>& getNumaNodeTotalMemBytes() const {
+    return numaNodeTotalMemBytes_;
+  }
+
+  /**
+   * Gets the number of NUMA nodes as inferred by the length of the
+   * per node utilization data already queried.
+   */
+  uint64_t getNumNumaNodes() const {
+    return numaNodeCpuRatioUtils_.size();
+  }
+
   /**
    * Returns the percentage that maps to the specified ratio in the range
    * [0.0, 1.0].
@@ -244,6 +276,18 @@ struct ResourceData : public PeriodicStatsDataBase {
     totalMemBytes_ = totalMemBytes;
   }
 
+  /**
+   * Sets the per NUMA node utilization data; all vectors are indexed by
+   * node id.
+   */
+  void setNumaNodeStats(std::vector<double>&& cpuRatioUtils,
+                        std::vector<uint64_t>&& usedMemBytes,
+                        std::vector<uint64_t>&& totalMemBytes) {
+    numaNodeCpuRatioUtils_ = std::move(cpuRatioUtils);
+    numaNodeUsedMemBytes_ = std::move(usedMemBytes);
+    numaNodeTotalMemBytes_ = std::move(totalMemBytes);
+  }
+
   /**
    * Sets the structure fields describing TCP memory state.
    */
@@ -257,6 +301,88 @@ struct ResourceData : public PeriodicStatsDataBase {
     maxTcpMemLimit_ = maxThreshold;
   }
 
+  /**
+   * Gets per-subsystem allocation counts/bytes, indexed by
+   * AllocationTracker::Subsystem.  Empty unless allocation tracking was
+   * enabled when this data was collected.
+   */
+  const std::vector<uint64_t>& getSubsystemAllocations() const {
+    return subsystemAllocations_;
+  }
+
+  const std::vector<uint64_t>& getSubsystemAllocBytes() const {
+    return subsystemAllocBytes_;
+  }
+
+  /**
+   * Sets the per-subsystem allocation summary; both vectors are indexed
+   * by AllocationTracker::Subsystem.
+   */
+  void setAllocationStats(std::vector<uint64_t>&& allocations,
+                          std::vector<uint64_t>&& allocBytes) {
+    subsystemAllocations_ = std::move(allocations);
+    subsystemAllocBytes_ = std::move(allocBytes);
+  }
+
+  /**
+   * Gets the allocator stats sampled for this data point.  Check
+   * MallocStats::collected (or mallocStatsCollected()) before drawing
+   * conclusions; the fields are zero when jemalloc is not in use.
+   */
+  const MallocStats& getMallocStats() const {
+    return mallocStats_;
+  }
+
+  bool mallocStatsCollected() const {
+    return mallocStats_.collected;
+  }
+
+  /**
+   * Gets the high watermarks of allocator allocated/resident bytes
+   * observed across refresh cycles; see
+   * ResourceStats::resetMallocWatermarks() for the tracking window.
+   */
+  uint64_t getMallocAllocatedHwmBytes() const {
+    return mallocAllocatedHwmBytes_;
+  }
+
+  uint64_t getMallocResidentHwmBytes() const {
+    return mallocResidentHwmBytes_;
+  }
+
+  /**
+   * Sets the allocator stats along with the high watermarks the sampler
+   * is carrying across refresh cycles.
+   */
+  void setMallocStats(MallocStats&& stats,
+                      uint64_t allocatedHwmBytes,
+                      uint64_t residentHwmBytes) {
+    mallocStats_ = std::move(stats);
+    mallocAllocatedHwmBytes_ = allocatedHwmBytes;
+    mallocResidentHwmBytes_ = residentHwmBytes;
+  }
+
+  /**
+   * Gets the per-worker session memory footprints sampled from the
+   * registered ledgers, in registration order.  Empty unless workers
+   * registered with ResourceStats::registerWorkerMemoryFn().
+   */
+  const std::vector<uint64_t>& getWorkerSessionMemBytes() const {
+    return workerSessionMemBytes_;
+  }
+
+  uint64_t getTotalSessionMemBytes() const {
+    uint64_t total = 0;
+    for (auto bytes : workerSessionMemBytes_) {
+      total += bytes;
+    }
+    return total;
+  }
+
+  void setWorkerSessionMemBytes(std::vector<uint64_t>&& bytes) {
+    workerSessionMemBytes_ = std::move(bytes);
+  }
+
   /**
    * Sets the structure fields describing UDP memory state.
    */
@@ -283,6 +409,9 @@ struct ResourceData : public PeriodicStatsDataBase {
   double cpuRatioUtil_{0};
   double cpuSoftIrqRatioUtil_{0};
   std::vector<double> softIrqCpuCoreRatioUtils_;
+  std::vector<double> numaNodeCpuRatioUtils_;
+  std::vector<uint64_t> numaNodeUsedMemBytes_;
+  std::vector<uint64_t> numaNodeTotalMemBytes_;
   uint64_t usedMemBytes_{0};
   uint64_t totalMemBytes_{0};
   uint64_t tcpMemoryPages_{0};
@@ -293,6 +422,12 @@ struct ResourceData : public PeriodicStatsDataBase {
   uint64_t maxUdpMemLimit_{0};
   uint64_t pressureUdpMemLimit_{0};
   uint64_t minUdpMemLimit_{0};
+  std::vector<uint64_t> subsystemAllocations_;
+  std::vector<uint64_t> subsystemAllocBytes_;
+  MallocStats mallocStats_;
+  uint64_t mallocAllocatedHwmBytes_{0};
+  uint64_t mallocResidentHwmBytes_{0};
+  std::vector<uint64_t> workerSessionMemBytes_;
 };
 
 /**
@@ -8,6 +8,22 @@
 
 #include "proxygen/lib/stats/ResourceStats.h"
 
+#include "proxygen/lib/stats/MallocStats.h"
+#include <proxygen/lib/utils/AllocationTracker.h>
+
+namespace {
+
+// Raise 'hwm' to at least 'value'.  Only the refresh thread raises, but
+// resetMallocWatermarks() may race a store of zero in between.
+void raiseWatermark(std::atomic<uint64_t>& hwm, uint64_t value) {
+  auto current = hwm.load(std::memory_order_relaxed);
+  while (value > current &&
+         !hwm.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+
+} // namespace
+
 namespace proxygen {
 
 ResourceStats::ResourceStats(std::unique_ptr<Resources> resources)
@@ -23,7 +39,53 @@ ResourceStats::~ResourceStats() {
 }
 
 ResourceData* ResourceStats::getNewData() const {
-  return new ResourceData(resources_->getCurrentData());
+  auto* data = new ResourceData(resources_->getCurrentData());
+  if (AllocationTracker::isEnabled()) {
+    auto summary = AllocationTracker::getGlobalSummary();
+    data->setAllocationStats(
+        {summary.allocations.begin(), summary.allocations.end()},
+        {summary.bytes.begin(), summary.bytes.end()});
+  }
+  auto mallocStats = collectMallocStats();
+  if (mallocStats.collected) {
+    raiseWatermark(mallocAllocatedHwm_, mallocStats.allocatedBytes);
+    raiseWatermark(mallocResidentHwm_, mallocStats.residentBytes);
+    data->setMallocStats(std::move(mallocStats),
+                         mallocAllocatedHwm_.load(std::memory_order_relaxed),
+                         mallocResidentHwm_.load(std::memory_order_relaxed));
+  }
+  auto workerMemoryFns = workerMemoryFns_.rlock();
+  if (!workerMemoryFns->empty()) {
+    std::vector<uint64_t> workerBytes;
+    workerBytes.reserve(workerMemoryFns->size());
+    for (const auto& entry : *workerMemoryFns) {
+      workerBytes.push_back(entry.second());
+    }
+    data->setWorkerSessionMemBytes(std::move(workerBytes));
+  }
+  return data;
+}
+
+size_t ResourceStats::registerWorkerMemoryFn(
+    folly::Function<uint64_t() const> fn) {
+  auto id = nextWorkerMemoryFnId_.fetch_add(1);
+  workerMemoryFns_.wlock()->emplace_back(id, std::move(fn));
+  return id;
+}
+
+void ResourceStats::unregisterWorkerMemoryFn(size_t id) {
+  auto workerMemoryFns = workerMemoryFns_.wlock();
+  for (auto it = workerMemoryFns->begin(); it != workerMemoryFns->end(); it++) {
+    if (it->first == id) {
+      workerMemoryFns->erase(it);
+      return;
+    }
+  }
+}
+
+void ResourceStats::resetMallocWatermarks() {
+  mallocAllocatedHwm_.store(0, std::memory_order_relaxed);
+  mallocResidentHwm_.store(0, std::memory_order_relaxed);
 }
 
 } // namespace proxygen
@@ -11,6 +11,10 @@
 #include "proxygen/lib/stats/PeriodicStats.h"
 #include "proxygen/lib/stats/ResourceData.h"
 
+#include <atomic>
+#include <folly/Function.h>
+#include <folly/Synchronized.h>
+
 namespace proxygen {
 
 /**
@@ -30,6 +34,26 @@ class ResourceStats : public PeriodicStats<ResourceData> {
   explicit ResourceStats(std::unique_ptr<Resources> resources);
   ~ResourceStats();
 
+  /**
+   * Registers a callback reporting one worker's session memory
+   * footprint (e.g. HTTPSessionMemoryLedger::getPublishedFootprint),
+   * sampled on every refresh cycle into
+   * ResourceData::getWorkerSessionMemBytes().  The callback runs on the
+   * refresh thread and must be safe to invoke from there.  Returns an
+   * id for unregisterWorkerMemoryFn(); a worker must unregister before
+   * whatever the callback captures goes away.
+   */
+  size_t registerWorkerMemoryFn(folly::Function<uint64_t() const> fn);
+  void unregisterWorkerMemoryFn(size_t id);
+
+  /**
+   * Resets the allocator high watermarks so subsequent data points
+   * start a new tracking window; without a reset the watermarks are the
+   * peaks observed across all refresh cycles so far.  Typically called
+   * by whatever exports the watermarks after each scrape.
+   */
+  void resetMallocWatermarks();
+
  protected:
   /**
    * Override getNewData so that we can return an instance of ResourceData.
@@ -41,6 +65,17 @@ class ResourceStats : public PeriodicStats<ResourceData> {
    * of the entity that actually queries various metrics.
    */
   std::unique_ptr<Resources> resources_;
+
+ private:
+  using WorkerMemoryFn = std::pair<size_t, folly::Function<uint64_t() const>>;
+
+  // High watermarks carried across refresh cycles (getNewData is const);
+  // written by the refresh thread, reset by exporters.
+  mutable std::atomic<uint64_t> mallocAllocatedHwm_{0};
+  mutable std::atomic<uint64_t> mallocResidentHwm_{0};
+
+  folly::Synchronized<std::vector<WorkerMemoryFn>> workerMemoryFns_;
+  std::atomic<size_t> nextWorkerMemoryFnId_{0};
 };
 
 } // namespace proxygen
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include <folly/concurrency/CacheLocality.h>
+#include <folly/lang/Align.h>
+
+namespace proxygen {
+
+/**
+ * ShardedCounter:
+ *
+ * A counter for hot paths too contended for a single shared atomic.
+ * Increments write to one of N cache-line-private slots selected by the
+ * caller's cpu (via folly::AccessSpreader), so concurrent writers on
+ * different cores do not bounce a cache line between them.
+ *
+ * Reads fold the slots together and are comparatively expensive.  The
+ * intended consumer is the PeriodicStats function-scheduler thread: a
+ * PeriodicStats subclass calls collectAndReset() from getNewData() once
+ * per refresh interval and folds the delta into the snapshot it is
+ * building (see PeriodicStatsDataBase), so readers see counter values
+ * with snapshot consistency and the hot path never takes a lock.
+ *
+ * The fold is not atomic across slots; a collect racing concurrent
+ * increments may attribute an increment to the next interval.  Interval
+ * deltas are approximate, the running total is not.
+ */
+class ShardedCounter {
+ public:
+  /**
+   * numShards of zero, the default, sizes the counter to the number of
+   * cpus in the system.  Fewer shards trade contention for footprint;
+   * each shard occupies a full cache line.
+   */
+  explicit ShardedCounter(size_t numShards = 0)
+      : slots_(numShards > 0 ? numShards
+                             : folly::CacheLocality::system().numCpus) {
+  }
+
+  void add(int64_t amount = 1) {
+    auto& slot = slots_[folly::AccessSpreader<>::cachedCurrent(slots_.size())];
+    slot.value.fetch_add(amount, std::memory_order_relaxed);
+  }
+
+  void sub(int64_t amount = 1) {
+    add(-amount);
+  }
+
+  /**
+   * Sum of all slots; leaves the counter running.
+   */
+  int64_t collect() const {
+    int64_t total = 0;
+    for (const auto& slot : slots_) {
+      total += slot.value.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+  /**
+   * Drains every slot and returns the delta accumulated since the last
+   * drain; this is the aggregation entry point for the refresh thread.
+   */
+  int64_t collectAndReset() {
+    int64_t total = 0;
+    for (auto& slot : slots_) {
+      total += slot.value.exchange(0, std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+  size_t getNumShards() const {
+    return slots_.size();
+  }
+
+ private:
+  struct alignas(folly::hardware_destructive_interference_size) Slot {
+    std::atomic<int64_t> value{0};
+  };
+
+  std::vector<Slot> slots_;
+};
+
+} // namespace proxygen
@@ -79,3 +79,39 @@ TEST_F(ResourceStatsTest, GetCurrentDataOnRefresh) {
   EXPECT_CALL(*resourceStatsUT_->getMockResources(), getCurrentData());
   periodicStatsUTHelper_->waitForRefresh({});
 }
+
+// Verifies registered worker memory callbacks are sampled on refresh, in
+// registration order, and dropped once unregistered.
+TEST_F(ResourceStatsTest, SamplesWorkerMemoryFnsOnRefresh) {
+  // Regenerate the data each call so every refresh carries a new update
+  // time and getCurrentData() picks it up.
+  auto& params = testRDParams;
+  EXPECT_CALL(*resourceStatsUT_->getMockResources(), getCurrentData())
+      .WillRepeatedly(testing::Invoke(
+          [&params]() { return MockResources::getTestResourceData(params); }));
+
+  auto idA = resourceStatsUT_->registerWorkerMemoryFn([]() { return 100; });
+  resourceStatsUT_->registerWorkerMemoryFn([]() { return 250; });
+
+  PeriodicStatsTestHelper<ResourceData>::WaitForRefreshParams refreshParams;
+  refreshParams.refreshPeriod = std::chrono::milliseconds(50);
+  periodicStatsUTHelper_->waitForRefresh(refreshParams);
+
+  {
+    const auto& data = resourceStatsUT_->getCurrentData();
+    ASSERT_EQ(data.getWorkerSessionMemBytes().size(), 2);
+    EXPECT_EQ(data.getWorkerSessionMemBytes()[0], 100);
+    EXPECT_EQ(data.getWorkerSessionMemBytes()[1], 250);
+    EXPECT_EQ(data.getTotalSessionMemBytes(), 350);
+  }
+
+  resourceStatsUT_->unregisterWorkerMemoryFn(idA);
+  // Wait out two refreshes: one may already have sampled the old list
+  refreshParams.startRefresh = false;
+  periodicStatsUTHelper_->waitForRefresh(refreshParams);
+  periodicStatsUTHelper_->waitForRefresh(refreshParams);
+
+  const auto& data = resourceStatsUT_->getCurrentData();
+  ASSERT_EQ(data.getWorkerSessionMemBytes().size(), 1);
+  EXPECT_EQ(data.getWorkerSessionMemBytes()[0], 250);
+}
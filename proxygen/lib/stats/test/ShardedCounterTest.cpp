@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "proxygen/lib/stats/ShardedCounter.h"
+
+#include <folly/portability/GTest.h>
+#include <thread>
+#include <vector>
+
+using namespace proxygen;
+
+TEST(ShardedCounter, BasicAddSubCollect) {
+  ShardedCounter counter;
+  EXPECT_EQ(counter.collect(), 0);
+  counter.add();
+  counter.add(41);
+  EXPECT_EQ(counter.collect(), 42);
+  counter.sub(2);
+  EXPECT_EQ(counter.collect(), 40);
+}
+
+TEST(ShardedCounter, CollectAndResetDrains) {
+  ShardedCounter counter;
+  counter.add(7);
+  EXPECT_EQ(counter.collectAndReset(), 7);
+  EXPECT_EQ(counter.collect(), 0);
+  counter.add(3);
+  EXPECT_EQ(counter.collectAndReset(), 3);
+}
+
+TEST(ShardedCounter, ConcurrentIncrements) {
+  ShardedCounter counter;
+  constexpr int kThreads = 8;
+  constexpr int kIncrementsPerThread = 10000;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&counter] {
+      for (int j = 0; j < kIncrementsPerThread; ++j) {
+        counter.add();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(counter.collect(), kThreads * kIncrementsPerThread);
+}
+
+TEST(ShardedCounter, ExplicitShardCount) {
+  ShardedCounter counter(2);
+  EXPECT_EQ(counter.getNumShards(), 2);
+  counter.add(5);
+  EXPECT_EQ(counter.collect(), 5);
+}
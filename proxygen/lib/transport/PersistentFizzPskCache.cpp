@@ -17,6 +17,9 @@ dynamic toDynamic(const proxygen::PersistentCachedPsk& cached) {
   dynamic d = dynamic::object;
   d["psk"] = cached.serialized;
   d["uses"] = cached.uses;
+  if (!cached.warmHeaderState.empty()) {
+    d["warmHeaderState"] = cached.warmHeaderState;
+  }
   return d;
 }
 
@@ -25,6 +28,10 @@ proxygen::PersistentCachedPsk convertTo(const dynamic& d) {
   proxygen::PersistentCachedPsk psk;
   psk.serialized = d["psk"].asString();
   psk.uses = folly::to<size_t>(d["uses"].asInt());
+  // absent in blobs written before warm header state existed
+  if (auto* state = d.get_ptr("warmHeaderState")) {
+    psk.warmHeaderState = state->asString();
+  }
   return psk;
 }
 } // namespace folly
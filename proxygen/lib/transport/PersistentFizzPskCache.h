@@ -14,11 +14,17 @@
 #include <fizz/protocol/OpenSSLFactory.h>
 #include <wangle/client/persistence/FilePersistentCache.h>
 
+#include <thread>
+#include <vector>
+
 namespace proxygen {
 
 struct PersistentCachedPsk {
   std::string serialized;
   size_t uses{0};
+  // Opaque warm header-compression state exported by HPACKCodec; rides
+  // with the PSK so resumption to another box starts with a warm table
+  std::string warmHeaderState;
 };
 
 class PersistentFizzPskCache : public fizz::client::PskCache {
@@ -47,6 +53,28 @@ class PersistentFizzPskCache : public fizz::client::PskCache {
     return folly::none;
   }
 
+  /**
+   * Attach warm header-compression state (see
+   * HPACKCodec::exportWarmTableState) to the cached PSK for this
+   * identity.  No-op when no PSK is cached: state without a ticket to
+   * resume from is useless.
+   */
+  void putWarmHeaderState(const std::string& identity, std::string state) {
+    auto serialized = cache_.get(identity);
+    if (serialized) {
+      serialized->warmHeaderState = std::move(state);
+      cache_.put(identity, *serialized);
+    }
+  }
+
+  folly::Optional<std::string> getWarmHeaderState(const std::string& identity) {
+    auto serialized = cache_.get(identity);
+    if (serialized && !serialized->warmHeaderState.empty()) {
+      return serialized->warmHeaderState;
+    }
+    return folly::none;
+  }
+
   folly::Optional<fizz::client::CachedPsk> getPsk(
       const std::string& identity) override {
     auto serialized = cache_.get(identity);
@@ -88,6 +116,77 @@ class PersistentFizzPskCache : public fizz::client::PskCache {
 
   std::unique_ptr<fizz::Factory> factory_;
 };
+
+/**
+ * Shards PSKs across several file-backed caches by identity hash.  Each
+ * shard is an independent FilePersistentCache with its own lock and
+ * write-behind syncer thread, so resumption storms fan out over numShards
+ * locks and flush queues instead of serializing on one.  Shard files are
+ * named "<filename>.<index>"; shard count must stay stable across
+ * restarts or previously cached PSKs will miss.  Shards are warm-loaded
+ * in parallel at construction time.
+ */
+class ShardedPersistentFizzPskCache : public fizz::client::PskCache {
+ public:
+  ~ShardedPersistentFizzPskCache() override = default;
+
+  ShardedPersistentFizzPskCache(const std::string& filename,
+                                size_t numShards,
+                                wangle::PersistentCacheConfig config) {
+    CHECK_GT(numShards, 0u);
+    shards_.resize(numShards);
+    std::vector<std::thread> loaders;
+    loaders.reserve(numShards);
+    for (size_t i = 0; i < numShards; i++) {
+      loaders.emplace_back([this, i, &filename, &config] {
+        shards_[i] = std::make_unique<PersistentFizzPskCache>(
+            folly::to<std::string>(filename, ".", i), config);
+      });
+    }
+    for (auto& loader : loaders) {
+      loader.join();
+    }
+  }
+
+  void setMaxPskUses(size_t maxUses) {
+    for (auto& shard : shards_) {
+      shard->setMaxPskUses(maxUses);
+    }
+  }
+
+  folly::Optional<size_t> getPskUses(const std::string& identity) {
+    return shard(identity).getPskUses(identity);
+  }
+
+  void putWarmHeaderState(const std::string& identity, std::string state) {
+    shard(identity).putWarmHeaderState(identity, std::move(state));
+  }
+
+  folly::Optional<std::string> getWarmHeaderState(const std::string& identity) {
+    return shard(identity).getWarmHeaderState(identity);
+  }
+
+  folly::Optional<fizz::client::CachedPsk> getPsk(
+      const std::string& identity) override {
+    return shard(identity).getPsk(identity);
+  }
+
+  void putPsk(const std::string& identity,
+              fizz::client::CachedPsk psk) override {
+    shard(identity).putPsk(identity, std::move(psk));
+  }
+
+  void removePsk(const std::string& identity) override {
+    shard(identity).removePsk(identity);
+  }
+
+ private:
+  PersistentFizzPskCache& shard(const std::string& identity) {
+    return *shards_[std::hash<std::string>{}(identity) % shards_.size()];
+  }
+
+  std::vector<std::unique_ptr<PersistentFizzPskCache>> shards_;
+};
 } // namespace proxygen
 
 namespace folly {
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/transport/QuicTokenCache.h>
+
+namespace proxygen {
+
+SynchronizedLruQuicTokenCache::SynchronizedLruQuicTokenCache(uint64_t mapMax)
+    : cache_(EvictingTokenMap(mapMax)) {
+}
+
+folly::Optional<std::string> SynchronizedLruQuicTokenCache::getToken(
+    const std::string& identity) {
+  auto cacheMap = cache_.wlock();
+  auto result = cacheMap->find(identity);
+  if (result != cacheMap->end()) {
+    return result->second;
+  }
+  return folly::none;
+}
+
+void SynchronizedLruQuicTokenCache::putToken(const std::string& identity,
+                                             std::string token) {
+  auto cacheMap = cache_.wlock();
+  cacheMap->set(identity, std::move(token));
+}
+
+void SynchronizedLruQuicTokenCache::removeToken(const std::string& identity) {
+  auto cacheMap = cache_.wlock();
+  cacheMap->erase(identity);
+}
+
+} // namespace proxygen
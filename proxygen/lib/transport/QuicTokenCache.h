@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <folly/Optional.h>
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <string>
+
+namespace proxygen {
+
+/**
+ * Cache of QUIC NEW_TOKEN address-validation tokens, keyed by server
+ * identity (SNI, like the PSK caches).  Presenting a cached token on
+ * the next connect lets the server validate the client address without
+ * a Retry round trip, so together with a cached PSK a reconnect is
+ * consistently 0-RTT instead of only when the server happens to skip
+ * validation.  Tokens are single-origin secrets; implementations must
+ * be safe to share across connectors and threads.
+ */
+class QuicTokenCache {
+ public:
+  virtual ~QuicTokenCache() = default;
+
+  virtual folly::Optional<std::string> getToken(
+      const std::string& identity) = 0;
+
+  virtual void putToken(const std::string& identity, std::string token) = 0;
+
+  virtual void removeToken(const std::string& identity) = 0;
+};
+
+class SynchronizedLruQuicTokenCache : public QuicTokenCache {
+ public:
+  explicit SynchronizedLruQuicTokenCache(uint64_t mapMax);
+
+  ~SynchronizedLruQuicTokenCache() override = default;
+
+  folly::Optional<std::string> getToken(const std::string& identity) override;
+
+  void putToken(const std::string& identity, std::string token) override;
+
+  void removeToken(const std::string& identity) override;
+
+ private:
+  using EvictingTokenMap = folly::EvictingCacheMap<std::string, std::string>;
+  folly::Synchronized<EvictingTokenMap> cache_;
+};
+
+} // namespace proxygen
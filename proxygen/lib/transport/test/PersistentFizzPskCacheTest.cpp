@@ -290,4 +290,40 @@ TEST_F(PersistentFizzPskCacheTest, TestGetPskUses) {
   cache_->getPsk("facebook.com");
   EXPECT_EQ(folly::none, cache_->getPskUses("facebook.com"));
 }
+
+TEST_F(PersistentFizzPskCacheTest, TestShardedInsertAndReload) {
+  constexpr size_t kShards = 4;
+  auto prefix = file_ + ".sharded";
+  auto createSharded = [&] {
+    return std::make_unique<ShardedPersistentFizzPskCache>(
+        prefix,
+        kShards,
+        wangle::PersistentCacheConfig::Builder()
+            .setCapacity(50)
+            .setSyncInterval(std::chrono::seconds(1))
+            .build());
+  };
+
+  auto sharded = createSharded();
+  sharded->putPsk("facebook.com", psk1_);
+  sharded->putPsk("something.com", psk2_);
+  expectMatch(*sharded->getPsk("facebook.com"), psk1_);
+  expectMatch(*sharded->getPsk("something.com"), psk2_);
+  EXPECT_FALSE(sharded->getPsk("somethingelse.com").has_value());
+
+  sharded->removePsk("facebook.com");
+  EXPECT_FALSE(sharded->getPsk("facebook.com").has_value());
+  sharded->putPsk("facebook.com", psk1_);
+
+  // Flush on destruction, then warm-load the shards again
+  sharded.reset();
+  sharded = createSharded();
+  expectMatch(*sharded->getPsk("facebook.com"), psk1_);
+  expectMatch(*sharded->getPsk("something.com"), psk2_);
+
+  sharded.reset();
+  for (size_t i = 0; i < kShards; i++) {
+    unlink(folly::to<std::string>(prefix, ".", i).c_str());
+  }
+}
 }} // namespace proxygen::test
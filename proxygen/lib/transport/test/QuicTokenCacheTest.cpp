@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/transport/QuicTokenCache.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace testing;
+
+namespace proxygen { namespace test {
+
+TEST(QuicTokenCacheTest, PutGetRemove) {
+  SynchronizedLruQuicTokenCache cache(10);
+  EXPECT_FALSE(cache.getToken("example.com").hasValue());
+
+  cache.putToken("example.com", "token1");
+  auto token = cache.getToken("example.com");
+  ASSERT_TRUE(token.hasValue());
+  EXPECT_EQ(*token, "token1");
+
+  cache.putToken("example.com", "token2");
+  token = cache.getToken("example.com");
+  ASSERT_TRUE(token.hasValue());
+  EXPECT_EQ(*token, "token2");
+
+  cache.removeToken("example.com");
+  EXPECT_FALSE(cache.getToken("example.com").hasValue());
+}
+
+TEST(QuicTokenCacheTest, LruEviction) {
+  SynchronizedLruQuicTokenCache cache(2);
+  cache.putToken("a.com", "tokenA");
+  cache.putToken("b.com", "tokenB");
+  // Touch a.com so b.com is least recently used.
+  EXPECT_TRUE(cache.getToken("a.com").hasValue());
+  cache.putToken("c.com", "tokenC");
+  EXPECT_TRUE(cache.getToken("a.com").hasValue());
+  EXPECT_FALSE(cache.getToken("b.com").hasValue());
+  EXPECT_TRUE(cache.getToken("c.com").hasValue());
+}
+
+}} // namespace proxygen::test
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/utils/AllocationTracker.h>
+
+#include <algorithm>
+
+namespace proxygen {
+
+std::atomic<bool> AllocationTracker::enabled_{false};
+std::atomic<uint32_t> AllocationTracker::sampleRate_{
+    AllocationTracker::kDefaultSampleRate};
+folly::ThreadLocal<AllocationTracker::Snapshot, AllocationTracker::Tag>
+    AllocationTracker::threadSnapshot_;
+
+void AllocationTracker::enable(uint32_t sampleRate) {
+  sampleRate_.store(std::max(sampleRate, 1u), std::memory_order_relaxed);
+  // Reset counters from any previous tracking window
+  for (auto& snapshot : threadSnapshot_.accessAllThreads()) {
+    snapshot = Snapshot();
+  }
+  enabled_.store(true, std::memory_order_relaxed);
+}
+
+void AllocationTracker::disable() {
+  enabled_.store(false, std::memory_order_relaxed);
+}
+
+bool AllocationTracker::shouldSampleTransaction() {
+  static thread_local uint32_t sinceLastSample = 0;
+  if (++sinceLastSample >= sampleRate_.load(std::memory_order_relaxed)) {
+    sinceLastSample = 0;
+    return true;
+  }
+  return false;
+}
+
+AllocationTracker::Snapshot AllocationTracker::getGlobalSummary() {
+  Snapshot summary;
+  for (const auto& snapshot : threadSnapshot_.accessAllThreads()) {
+    summary += snapshot;
+  }
+  return summary;
+}
+
+} // namespace proxygen
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <folly/Likely.h>
+#include <folly/ThreadLocal.h>
+
+namespace proxygen {
+
+/**
+ * Opt-in allocation accounting for the request path.
+ *
+ * When enabled, hooks at the major allocation sites (header storage
+ * growth, ingress message creation, header compression output,
+ * transaction and handler creation) bump thread-local counters
+ * categorized by subsystem.  The mode is off by default and each hook is
+ * a single predicted branch, so instrumented binaries pay nothing until
+ * tracking is turned on.
+ *
+ * Per-transaction deltas are exposed through
+ * HTTPTransaction::getAllocationSnapshot() on sampled transactions;
+ * process-wide aggregates through getGlobalSummary() and, when a
+ * ResourceStats instance is polling, through ResourceData.
+ */
+class AllocationTracker {
+ public:
+  enum Subsystem : uint8_t {
+    CODEC = 0,
+    COMPRESS,
+    SESSION,
+    MESSAGE,
+    HANDLER,
+    NUM_SUBSYSTEMS
+  };
+
+  struct Snapshot {
+    std::array<uint64_t, NUM_SUBSYSTEMS> allocations{};
+    std::array<uint64_t, NUM_SUBSYSTEMS> bytes{};
+
+    Snapshot& operator+=(const Snapshot& other) {
+      for (size_t i = 0; i < NUM_SUBSYSTEMS; i++) {
+        allocations[i] += other.allocations[i];
+        bytes[i] += other.bytes[i];
+      }
+      return *this;
+    }
+
+    // Counters accumulated since the given (earlier) snapshot
+    Snapshot delta(const Snapshot& since) const {
+      Snapshot result;
+      for (size_t i = 0; i < NUM_SUBSYSTEMS; i++) {
+        result.allocations[i] = allocations[i] - since.allocations[i];
+        result.bytes[i] = bytes[i] - since.bytes[i];
+      }
+      return result;
+    }
+  };
+
+  static constexpr uint32_t kDefaultSampleRate = 1000;
+
+  /**
+   * Turns tracking on; roughly one transaction in sampleRate carries a
+   * per-transaction snapshot.
+   */
+  static void enable(uint32_t sampleRate = kDefaultSampleRate);
+  static void disable();
+
+  static bool isEnabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Called at allocation sites.  No-op while tracking is disabled.
+   */
+  static void recordAllocation(Subsystem subsystem, size_t bytes) {
+    if (LIKELY(!isEnabled())) {
+      return;
+    }
+    auto& snapshot = *threadSnapshot_;
+    snapshot.allocations[subsystem]++;
+    snapshot.bytes[subsystem] += bytes;
+  }
+
+  /**
+   * True for roughly one call in the configured sample rate; used to
+   * select the transactions that carry per-transaction snapshots.
+   */
+  static bool shouldSampleTransaction();
+
+  // This thread's counters since enable()
+  static Snapshot getThreadSnapshot() {
+    return *threadSnapshot_;
+  }
+
+  // Sum across all threads that have recorded since enable()
+  static Snapshot getGlobalSummary();
+
+ private:
+  class Tag;
+
+  static std::atomic<bool> enabled_;
+  static std::atomic<uint32_t> sampleRate_;
+  static folly::ThreadLocal<Snapshot, Tag> threadSnapshot_;
+};
+
+} // namespace proxygen
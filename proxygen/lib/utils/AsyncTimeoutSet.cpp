@@ -29,8 +29,10 @@ AsyncTimeoutSet::TimeoutClock& getTimeoutClock() {
 }
 
 AsyncTimeoutSet::Callback::~Callback() {
-  if (isScheduled()) {
-    cancelTimeout();
+  // A lazily cancelled callback is still linked in the set's list, so we
+  // must unlink eagerly here even when isScheduled() is already false.
+  if (timeoutSet_ != nullptr) {
+    cancelTimeoutImpl();
   }
 }
 
@@ -48,7 +50,25 @@ void AsyncTimeoutSet::Callback::setScheduled(AsyncTimeoutSet* timeoutSet,
                 timeoutSet_->getInterval();
 }
 
+void AsyncTimeoutSet::Callback::markCancelled() {
+  cancelled_ = true;
+  context_.reset();
+  assert(timeoutSet_->liveCount_ > 0);
+  --timeoutSet_->liveCount_;
+  if (timeoutSet_->liveCount_ == 0 && !timeoutSet_->inTimeoutExpired_) {
+    // Nothing left to fire.  Disarm the underlying timeout now rather than
+    // waking up later just to reap dead entries; the entries themselves
+    // stay linked until they are rescheduled, destroyed, or swept.
+    timeoutSet_->folly::AsyncTimeout::cancelTimeout();
+  }
+}
+
 void AsyncTimeoutSet::Callback::cancelTimeoutImpl() {
+  if (!cancelled_) {
+    assert(timeoutSet_->liveCount_ > 0);
+    --timeoutSet_->liveCount_;
+  }
+
   if (next_ == nullptr) {
     assert(timeoutSet_->tail_ == this);
     timeoutSet_->tail_ = prev_;
@@ -70,6 +90,7 @@ void AsyncTimeoutSet::Callback::cancelTimeoutImpl() {
   prev_ = nullptr;
   next_ = nullptr;
   expiration_ = {};
+  cancelled_ = false;
 }
 
 AsyncTimeoutSet::AsyncTimeoutSet(folly::TimeoutManager* timeoutManager,
@@ -116,39 +137,50 @@ void AsyncTimeoutSet::destroy() {
   // callbacks remaining.  Otherwise they need to implement their own code to
   // take care of cleaning up the callbacks that will never be invoked.
 
-  // cancel from tail to head, to avoid extra calls to headChanged
+  // Unlink from tail to head, to avoid extra calls to headChanged.  This
+  // must use the eager path: lazily cancelled callbacks are still linked.
   while (tail_ != nullptr) {
-    tail_->cancelTimeout();
+    tail_->cancelTimeoutImpl();
   }
 
   DelayedDestruction::destroy();
 }
 
 void AsyncTimeoutSet::scheduleTimeout(Callback* callback) {
-  // Cancel the callback if it happens to be scheduled already.
-  callback->cancelTimeout();
+  // Unlink the callback if it happens to be linked already, whether live
+  // or lazily cancelled.
+  if (callback->timeoutSet_ != nullptr) {
+    callback->cancelTimeoutImpl();
+  }
   assert(callback->prev_ == nullptr);
   assert(callback->next_ == nullptr);
 
   callback->context_ = folly::RequestContext::saveContext();
 
+  bool wasIdle = (liveCount_ == 0);
   Callback* old_tail = tail_;
   if (head_ == nullptr) {
-    // We don't have any timeouts scheduled already.  We have to schedule
-    // ourself.
     assert(tail_ == nullptr);
-    assert(!isScheduled());
-    if (!inTimeoutExpired_) {
-      this->folly::AsyncTimeout::scheduleTimeout(interval_.count());
-    }
     head_ = callback;
     tail_ = callback;
   } else {
-    assert(inTimeoutExpired_ || isScheduled());
     assert(tail_->next_ == nullptr);
     tail_->next_ = callback;
     tail_ = callback;
   }
+  ++liveCount_;
+
+  if (wasIdle) {
+    // The underlying timeout is disarmed whenever no live callbacks
+    // remain, so we have to arm it for this callback.  Any lazily
+    // cancelled entries still linked ahead of us are reaped when it
+    // fires.
+    if (!inTimeoutExpired_) {
+      this->folly::AsyncTimeout::scheduleTimeout(interval_.count());
+    }
+  } else {
+    assert(inTimeoutExpired_ || isScheduled());
+  }
 
   // callback->prev_ = tail_;
   callback->setScheduled(this, old_tail);
@@ -162,9 +194,13 @@ void AsyncTimeoutSet::headChanged() {
     return;
   }
 
-  if (!head_) {
+  if (head_ == nullptr || liveCount_ == 0) {
     this->folly::AsyncTimeout::cancelTimeout();
   } else {
+    // head_ may be a lazily cancelled entry with an earlier expiration
+    // than the first live callback.  That just means we wake up early,
+    // reap it in timeoutExpired(), and reschedule; not worth walking the
+    // list here.
     milliseconds delta =
         head_->getTimeRemaining(timeoutClock_.millisecondsSinceEpoch());
     this->folly::AsyncTimeout::scheduleTimeout(delta.count());
@@ -205,6 +241,14 @@ void AsyncTimeoutSet::timeoutExpired() noexcept {
   auto now = timeoutClock_.millisecondsSinceEpoch();
 
   while (head_ != nullptr) {
+    if (head_->cancelled_) {
+      // Reap entries cancelled since the last sweep without invoking
+      // them.  This is where lazy cancellation pays its deferred
+      // unlinking cost, off the cancel hot path.
+      head_->cancelTimeoutImpl();
+      continue;
+    }
+
     milliseconds delta = head_->getTimeRemaining(now);
     if (delta > milliseconds(0)) {
       if (delta < atMostEveryN_) {
@@ -214,10 +258,10 @@ void AsyncTimeoutSet::timeoutExpired() noexcept {
       break;
     }
 
-    // Remember the callback to invoke, since calling cancelTimeout()
-    // on it will modify head_.
+    // Remember the callback to invoke, since unlinking it will modify
+    // head_.
     Callback* cb = head_;
-    head_->cancelTimeout();
+    head_->cancelTimeoutImpl();
     folly::RequestContextScopeGuard rctxScopeGuard(cb->context_);
     cb->timeoutExpired();
   }
@@ -66,21 +66,27 @@ class AsyncTimeoutSet
     /**
      * Cancel the timeout, if it is running.
      *
+     * Cancellation is lazy: the callback is only marked dead and stays
+     * linked in the set's list until the expiry sweep (or a reschedule)
+     * reaps it, so cancelling never performs list surgery on the hot
+     * path.  timeoutExpired() will not be invoked for a cancelled
+     * callback.
+     *
      * If the timeout is not scheduled, cancelTimeout() does nothing.
      */
     void cancelTimeout() {
-      if (timeoutSet_ == nullptr) {
+      if (!isScheduled()) {
         // We're not scheduled, so there's nothing to do.
         return;
       }
-      cancelTimeoutImpl();
+      markCancelled();
     }
 
     /**
      * Return true if this timeout is currently scheduled, and false otherwise.
      */
     bool isScheduled() const {
-      return timeoutSet_ != nullptr;
+      return timeoutSet_ != nullptr && !cancelled_;
     }
 
    private:
@@ -94,6 +100,10 @@ class AsyncTimeoutSet
     }
 
     void setScheduled(AsyncTimeoutSet* timeoutSet, Callback* prev);
+    // Lazy cancel: mark dead without unlinking
+    void markCancelled();
+    // Eager cancel: unlink now.  Used when the node itself must leave
+    // the list (destruction, rescheduling) and by the expiry sweep.
     void cancelTimeoutImpl();
 
     std::shared_ptr<folly::RequestContext> context_;
@@ -102,6 +112,7 @@ class AsyncTimeoutSet
     Callback* prev_{nullptr};
     Callback* next_{nullptr};
     std::chrono::milliseconds expiration_{0};
+    bool cancelled_{false};
 
     // Give AsyncTimeoutSet direct access to our members so it can take care
     // of scheduling/cancelling.
@@ -184,13 +195,19 @@ class AsyncTimeoutSet
   }
 
   /**
-   * Get a pointer to the next Callback scheduled to be invoked (may be null).
+   * Get a pointer to the next live Callback scheduled to be invoked (may
+   * be null).  Lazily cancelled callbacks still linked in the list are
+   * skipped.
    */
   Callback* front() {
-    return head_;
+    auto cb = head_;
+    while (cb != nullptr && cb->cancelled_) {
+      cb = cb->next_;
+    }
+    return cb;
   }
   const Callback* front() const {
-    return head_;
+    return const_cast<AsyncTimeoutSet*>(this)->front();
   }
 
  protected:
@@ -216,6 +233,10 @@ class AsyncTimeoutSet
   TimeoutClock& timeoutClock_;
   Callback* head_;
   Callback* tail_;
+  // Number of linked callbacks that have not been lazily cancelled.  The
+  // underlying AsyncTimeout is armed iff this is non-zero (outside of
+  // timeoutExpired(), which fixes up scheduling before it returns).
+  size_t liveCount_{0};
   std::chrono::milliseconds interval_;
   std::chrono::milliseconds atMostEveryN_;
   bool inTimeoutExpired_{false};
@@ -8,27 +8,267 @@
 
 #include <proxygen/lib/utils/Base64.h>
 
+#include <array>
+#include <cstring>
+
+#include <folly/io/IOBuf.h>
 #include <glog/logging.h>
 
-#include <folly/Range.h>
-#include <folly/portability/OpenSSL.h>
-#include <openssl/buffer.h>
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
 
 namespace {
-struct BIODeleter {
- public:
-  void operator()(BIO* bio) const {
-    BIO_free_all(bio);
-  };
+
+constexpr char kStdAlphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+constexpr char kUrlAlphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+constexpr uint8_t kInvalid = 0xff;
+
+struct DecodeTable {
+  std::array<uint8_t, 256> value{};
 };
 
+constexpr DecodeTable makeDecodeTable() {
+  DecodeTable table{};
+  for (size_t i = 0; i < table.value.size(); i++) {
+    table.value[i] = kInvalid;
+  }
+  for (uint8_t i = 0; i < 64; i++) {
+    table.value[static_cast<uint8_t>(kStdAlphabet[i])] = i;
+  }
+  return table;
+}
+
+constexpr DecodeTable kDecodeTable = makeDecodeTable();
+
+inline void encodeTriple(const uint8_t* in, char* out, const char* alphabet) {
+  const uint32_t v = (uint32_t(in[0]) << 16) | (uint32_t(in[1]) << 8) | in[2];
+  out[0] = alphabet[v >> 18];
+  out[1] = alphabet[(v >> 12) & 0x3f];
+  out[2] = alphabet[(v >> 6) & 0x3f];
+  out[3] = alphabet[v & 0x3f];
+}
+
+// Decode one 4-char quantum with no padding; returns false on any
+// invalid byte
+inline bool decodeQuantum(const uint8_t* in, uint8_t* out) {
+  const uint8_t a = kDecodeTable.value[in[0]];
+  const uint8_t b = kDecodeTable.value[in[1]];
+  const uint8_t c = kDecodeTable.value[in[2]];
+  const uint8_t d = kDecodeTable.value[in[3]];
+  if (a == kInvalid || b == kInvalid || c == kInvalid || d == kInvalid) {
+    return false;
+  }
+  const uint32_t v =
+      (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c) << 6) | d;
+  out[0] = v >> 16;
+  out[1] = (v >> 8) & 0xff;
+  out[2] = v & 0xff;
+  return true;
+}
+
+#if defined(__SSSE3__)
+
+/**
+ * Vectorized bulk paths using the Mula/Lemire nibble-lookup algorithm,
+ * adapted to SSSE3 since that is the baseline the rest of the tree
+ * assumes (see CodecUtil.cpp).  Each encode iteration turns 12 input
+ * bytes into 16 output chars; each decode iteration turns 16 chars into
+ * 12 bytes.  The scalar loops remain the authority: the vector decode
+ * bails to them on the first block containing anything but plain
+ * alphabet bytes (invalid chars, '=' padding).
+ */
+
+// chars 0-63 -> ASCII, applied as an offset added to the 6-bit value.
+// LUT index 0 covers 0-25 ('A'..), 1 covers 26-51 ('a'..), 2-11 cover
+// 52-61 ('0'..), 12 is 62 and 13 is 63 (alphabet-specific).
+inline __m128i encodeTranslate(__m128i in, char c62, char c63) {
+  // clang-format off
+  const __m128i lut = _mm_setr_epi8(
+      65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4,
+      static_cast<char>(c62 - 62), static_cast<char>(c63 - 63), 0, 0);
+  // clang-format on
+  __m128i indices = _mm_subs_epu8(in, _mm_set1_epi8(51));
+  const __m128i mask = _mm_cmpgt_epi8(in, _mm_set1_epi8(25));
+  indices = _mm_sub_epi8(indices, mask);
+  return _mm_add_epi8(in, _mm_shuffle_epi8(lut, indices));
+}
+
+// Encode 12 bytes of src into 16 chars at out.  The load reads 16
+// bytes, so the caller must guarantee 4 readable bytes past the 12.
+inline void encodeBlock(const uint8_t* src, char* out, char c62, char c63) {
+  __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+  // spread each 3-byte group into a 4-byte lane as [b1 b0 b2 b1]
+  in = _mm_shuffle_epi8(
+      in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+  const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+  const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+  const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+  const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+  in = _mm_or_si128(t1, t3);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                   encodeTranslate(in, c62, c63));
+}
+
+// Decode 16 chars of src into 12 bytes at out; returns false (writing
+// nothing) if the block contains any byte outside the standard
+// alphabet, including '=' padding
+inline bool decodeBlock(const uint8_t* src, uint8_t* out) {
+  // clang-format off
+  const __m128i lutLo = _mm_setr_epi8(
+      0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+      0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+  const __m128i lutHi = _mm_setr_epi8(
+      0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+      0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m128i lutRoll = _mm_setr_epi8(
+      0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  // clang-format on
+
+  __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+  const __m128i loNibbles = _mm_and_si128(in, _mm_set1_epi8(0x0f));
+  const __m128i hiNibbles =
+      _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0f));
+  const __m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+  const __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+  if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi),
+                                       _mm_setzero_si128())) != 0xffff) {
+    return false;
+  }
+  const __m128i eq2F = _mm_cmpeq_epi8(in, _mm_set1_epi8(0x2f));
+  const __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(eq2F, hiNibbles));
+  in = _mm_add_epi8(in, roll);
+  // pack four 6-bit values per dword into a 24-bit triple
+  const __m128i mergedABBC = _mm_maddubs_epi16(in, _mm_set1_epi32(0x01400140));
+  const __m128i merged = _mm_madd_epi16(mergedABBC, _mm_set1_epi32(0x00011000));
+  const __m128i packed = _mm_shuffle_epi8(
+      merged,
+      _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+  // store exactly 12 bytes; a full 16-byte store could run past the
+  // output buffer on the final blocks
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(out), packed);
+  const uint32_t last4 =
+      static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(packed, 8)));
+  memcpy(out + 8, &last4, 4);
+  return true;
+}
+
+#endif // __SSSE3__
+
+void encodeTail(const uint8_t* src,
+                size_t remainder,
+                char* out,
+                const char* alphabet,
+                bool pad) {
+  const uint32_t v = (uint32_t(src[0]) << 16) |
+                     (remainder == 2 ? (uint32_t(src[1]) << 8) : 0);
+  *out++ = alphabet[v >> 18];
+  *out++ = alphabet[(v >> 12) & 0x3f];
+  if (remainder == 2) {
+    *out++ = alphabet[(v >> 6) & 0x3f];
+  } else if (pad) {
+    *out++ = '=';
+  }
+  if (pad) {
+    *out = '=';
+  }
+}
+
+size_t encodedLength(size_t len, bool pad) {
+  const size_t remainder = len % 3;
+  return (len / 3) * 4 + (remainder ? (pad ? 4 : remainder + 1) : 0);
+}
+
+std::string encodeImpl(folly::ByteRange buffer,
+                       const char* alphabet,
+                       bool pad) {
+  std::string result(encodedLength(buffer.size(), pad), '\0');
+  if (buffer.empty()) {
+    return result;
+  }
+  const uint8_t* src = buffer.data();
+  char* out = &result[0];
+  size_t i = 0;
+#if defined(__SSSE3__)
+  // the block load reads 16 bytes while consuming 12, so stop while
+  // there is slack at the end of the input
+  while (buffer.size() - i >= 16) {
+    encodeBlock(src + i, out, alphabet[62], alphabet[63]);
+    i += 12;
+    out += 16;
+  }
+#endif
+  for (; i + 3 <= buffer.size(); i += 3, out += 4) {
+    encodeTriple(src + i, out, alphabet);
+  }
+  const size_t remainder = buffer.size() - i;
+  if (remainder) {
+    encodeTail(src + i, remainder, out, alphabet, pad);
+  }
+  return result;
+}
+
+std::string encodeChain(const folly::IOBuf& data,
+                        const char* alphabet,
+                        bool pad) {
+  // fast path: unchained buffers encode straight off the range
+  if (!data.isChained()) {
+    return encodeImpl(folly::ByteRange(data.data(), data.length()),
+                      alphabet,
+                      pad);
+  }
+  const size_t len = data.computeChainDataLength();
+  std::string result(encodedLength(len, pad), '\0');
+  char* out = &result[0];
+  // carry partial triples across buffer boundaries instead of
+  // flattening the chain
+  uint8_t carry[3];
+  size_t carryLen = 0;
+  for (const auto range : data) {
+    const uint8_t* src = range.data();
+    size_t avail = range.size();
+    if (carryLen > 0) {
+      while (carryLen < 3 && avail > 0) {
+        carry[carryLen++] = *src++;
+        avail--;
+      }
+      if (carryLen < 3) {
+        continue;
+      }
+      encodeTriple(carry, out, alphabet);
+      out += 4;
+      carryLen = 0;
+    }
+    size_t i = 0;
+#if defined(__SSSE3__)
+    while (avail >= 16 && avail - i >= 16) {
+      encodeBlock(src + i, out, alphabet[62], alphabet[63]);
+      i += 12;
+      out += 16;
+    }
+#endif
+    for (; i + 3 <= avail; i += 3, out += 4) {
+      encodeTriple(src + i, out, alphabet);
+    }
+    while (i < avail) {
+      carry[carryLen++] = src[i++];
+    }
+  }
+  if (carryLen > 0) {
+    encodeTail(carry, carryLen, out, alphabet, pad);
+  }
+  return result;
+}
+
 } // namespace
 
 namespace proxygen {
 
 // Decodes a base64url encoded string
 std::string Base64::urlDecode(const std::string& urlB64message) {
-  std::unique_ptr<BIO, BIODeleter> bio, b64;
   uint8_t padding = (4 - urlB64message.length() % 4) % 4;
   if (padding == 3) {
     return std::string();
@@ -54,76 +294,67 @@ std::string Base64::urlDecode(const std::string& urlB64message) {
 }
 
 std::string Base64::decode(const std::string& b64message, int padding) {
-  if (b64message.length() % 4 != 0 || padding >= 3) {
+  if (b64message.length() % 4 != 0 || padding >= 3 || padding < 0 ||
+      b64message.empty()) {
     return std::string();
   }
 
-  std::unique_ptr<BIO, BIODeleter> bio, b64;
-  size_t decodeLen = b64message.length() * 3 / 4 - padding;
+  const size_t decodeLen = b64message.length() * 3 / 4 - padding;
   std::string result(decodeLen, '\0');
-
-  bio.reset(BIO_new_mem_buf((void*)b64message.data(), -1));
-  if (!bio) {
-    return std::string();
+  const uint8_t* src = reinterpret_cast<const uint8_t*>(b64message.data());
+  uint8_t* out = reinterpret_cast<uint8_t*>(&result[0]);
+  // the final quantum may carry '=' padding; it is handled after the
+  // bulk loops
+  const size_t bulk = b64message.length() - 4;
+  size_t i = 0;
+  size_t o = 0;
+#if defined(__SSSE3__)
+  while (i + 16 <= bulk && decodeBlock(src + i, out + o)) {
+    i += 16;
+    o += 12;
   }
-  b64.reset(BIO_new(BIO_f_base64()));
-  if (!b64) {
-    return std::string();
+#endif
+  for (; i < bulk; i += 4, o += 3) {
+    if (!decodeQuantum(src + i, out + o)) {
+      return std::string();
+    }
   }
-  bio.reset(BIO_push(b64.release(), bio.release()));
 
-  // Do not use newlines to flush buffer
-  BIO_set_flags(bio.get(), BIO_FLAGS_BASE64_NO_NL);
-  BIO_read(bio.get(), (char*)result.data(), b64message.length());
-  DCHECK_LE(result.length(), decodeLen);
-  if (result.length() < decodeLen) {
-    return std::string();
+  uint32_t v = 0;
+  for (int j = 0; j < 4; j++) {
+    const uint8_t c = src[i + j];
+    if (c == '=' && j >= 4 - padding) {
+      v <<= 6;
+      continue;
+    }
+    const uint8_t d = kDecodeTable.value[c];
+    if (d == kInvalid) {
+      return std::string();
+    }
+    v = (v << 6) | d;
   }
+  const uint8_t tail[3] = {static_cast<uint8_t>(v >> 16),
+                           static_cast<uint8_t>((v >> 8) & 0xff),
+                           static_cast<uint8_t>(v & 0xff)};
+  memcpy(out + o, tail, 3 - padding);
   return result;
 }
 
 std::string Base64::encode(folly::ByteRange buffer) {
-  std::unique_ptr<BIO, BIODeleter> bio, b64;
-  BUF_MEM* bufferPtr;
-
-  b64.reset(BIO_new(BIO_f_base64()));
-  if (!b64) {
-    throw std::bad_alloc();
-  }
-  bio.reset(BIO_new(BIO_s_mem()));
-  if (!bio) {
-    throw std::bad_alloc();
-  }
-  bio.reset(BIO_push(b64.release(), bio.release()));
-
-  // Ignore newlines - write everything in one line
-  BIO_set_flags(bio.get(), BIO_FLAGS_BASE64_NO_NL);
-  BIO_write(bio.get(), buffer.data(), buffer.size());
-  (void)BIO_flush(bio.get());
-  BIO_get_mem_ptr(bio.get(), &bufferPtr);
-
-  std::string result(bufferPtr->data, bufferPtr->length);
-  return result;
+  return encodeImpl(buffer, kStdAlphabet, true /* pad */);
 }
 
 // Encodes a binary safe base 64 string
 std::string Base64::urlEncode(folly::ByteRange buffer) {
-  std::string result = encode(buffer);
-  folly::StringPiece sp(result.data(), result.length());
-  uint8_t padding = 0;
-  std::transform(sp.begin(), sp.end(), result.begin(), [&padding](char c) {
-    if (c == '+') {
-      return '-';
-    } else if (c == '/') {
-      return '_';
-    } else if (c == '=') {
-      padding++;
-    }
-    return c;
-  });
-  DCHECK_LE(padding, result.length());
-  result.resize(result.length() - padding);
-  return result;
+  return encodeImpl(buffer, kUrlAlphabet, false /* pad */);
+}
+
+std::string Base64::encode(const folly::IOBuf& data) {
+  return encodeChain(data, kStdAlphabet, true /* pad */);
+}
+
+std::string Base64::urlEncode(const folly::IOBuf& data) {
+  return encodeChain(data, kUrlAlphabet, false /* pad */);
 }
 
 } // namespace proxygen
@@ -11,10 +11,14 @@
 #include <folly/Range.h>
 #include <string>
 
+namespace folly {
+class IOBuf;
+}
+
 namespace proxygen {
 
-// This is a wrapper around openssl base64 encoding.  It is a temporary wrapper
-// around openssl, until a more optimized version lands in folly
+// Table-driven base64 codec with a vectorized bulk path on platforms
+// that support it; see Base64.cpp
 
 class Base64 {
  public:
@@ -22,6 +26,13 @@ class Base64 {
   static std::string urlDecode(const std::string& b64message);
   static std::string encode(folly::ByteRange buffer);
   static std::string urlEncode(folly::ByteRange buffer);
+
+  /**
+   * Encode an IOBuf chain without flattening it; partial triples are
+   * carried across buffer boundaries.
+   */
+  static std::string encode(const folly::IOBuf& data);
+  static std::string urlEncode(const folly::IOBuf& data);
 };
 
 } // namespace proxygen
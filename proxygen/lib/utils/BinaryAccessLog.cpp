@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/utils/BinaryAccessLog.h>
+
+#include <proxygen/lib/utils/Exception.h>
+
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/portability/Fcntl.h>
+#include <folly/portability/SysMman.h>
+#include <folly/portability/Unistd.h>
+
+#include <cstring>
+
+namespace {
+
+size_t roundUpToPowerOfTwo(size_t n) {
+  size_t result = 2;
+  while (result < n) {
+    result <<= 1;
+  }
+  return result;
+}
+
+} // namespace
+
+namespace proxygen {
+
+AccessLogRingBuffer::AccessLogRingBuffer(size_t capacity)
+    : records_(roundUpToPowerOfTwo(capacity)),
+      mask_(records_.size() - 1) {
+}
+
+bool AccessLogRingBuffer::tryWrite(const AccessLogRecord& record) {
+  const auto head = head_.load(std::memory_order_relaxed);
+  const auto tail = tail_.load(std::memory_order_acquire);
+  if (head - tail > mask_) {
+    return false;
+  }
+  records_[head & mask_] = record;
+  head_.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+size_t AccessLogRingBuffer::drainTo(std::vector<AccessLogRecord>& out) {
+  auto tail = tail_.load(std::memory_order_relaxed);
+  const auto head = head_.load(std::memory_order_acquire);
+  size_t drained = 0;
+  while (tail != head) {
+    out.push_back(records_[tail & mask_]);
+    tail++;
+    drained++;
+  }
+  tail_.store(tail, std::memory_order_release);
+  return drained;
+}
+
+BinaryAccessLog::BinaryAccessLog(std::string pathPrefix,
+                                 size_t segmentBytes,
+                                 size_t perThreadCapacity,
+                                 std::chrono::milliseconds spillInterval)
+    : pathPrefix_(std::move(pathPrefix)),
+      segmentBytes_(segmentBytes),
+      perThreadCapacity_(perThreadCapacity),
+      spillInterval_(spillInterval) {
+  CHECK_GT(segmentBytes_,
+           sizeof(SegmentHeader) + sizeof(AccessLogRecord));
+  openSegment();
+  spillThread_ = std::thread([this] { spillLoop(); });
+}
+
+BinaryAccessLog::~BinaryAccessLog() {
+  {
+    std::lock_guard<std::mutex> g(stopMutex_);
+    stop_ = true;
+  }
+  stopCondition_.notify_one();
+  spillThread_.join();
+  // The rotation thread performs a final drain before exiting, so
+  // anything logged before this destructor ran is on disk.
+  closeSegment();
+}
+
+AccessLogRingBuffer& BinaryAccessLog::threadLocalRing() {
+  auto& cached = *ring_;
+  if (!cached) {
+    auto ring = std::make_unique<AccessLogRingBuffer>(perThreadCapacity_);
+    cached = ring.get();
+    std::lock_guard<std::mutex> g(ringsMutex_);
+    rings_.push_back(std::move(ring));
+  }
+  return *cached;
+}
+
+void BinaryAccessLog::log(const AccessLogRecord& record) {
+  if (!threadLocalRing().tryWrite(record)) {
+    droppedRecords_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void BinaryAccessLog::spillLoop() {
+  std::unique_lock<std::mutex> lock(stopMutex_);
+  while (!stop_) {
+    stopCondition_.wait_for(lock, spillInterval_);
+    lock.unlock();
+    drainAllRings();
+    lock.lock();
+  }
+  lock.unlock();
+  drainAllRings();
+}
+
+void BinaryAccessLog::drainAllRings() {
+  std::vector<AccessLogRingBuffer*> rings;
+  {
+    std::lock_guard<std::mutex> g(ringsMutex_);
+    rings.reserve(rings_.size());
+    for (auto& ring : rings_) {
+      rings.push_back(ring.get());
+    }
+  }
+  std::vector<AccessLogRecord> spill;
+  for (auto* ring : rings) {
+    ring->drainTo(spill);
+  }
+  if (!spill.empty()) {
+    append(spill);
+  }
+}
+
+void BinaryAccessLog::append(const std::vector<AccessLogRecord>& records) {
+  for (const auto& record : records) {
+    if (writeOffset_ + sizeof(AccessLogRecord) > segmentBytes_) {
+      closeSegment();
+      segmentIndex_++;
+      openSegment();
+    }
+    memcpy(mapping_ + writeOffset_, &record, sizeof(record));
+    writeOffset_ += sizeof(record);
+    // Commit the record before it becomes visible through recordCount so
+    // a crashed process never exposes a half-written record.
+    reinterpret_cast<SegmentHeader*>(mapping_)->recordCount++;
+  }
+}
+
+void BinaryAccessLog::openSegment() {
+  auto path = folly::to<std::string>(pathPrefix_, ".", segmentIndex_);
+  file_ = folly::File(path.c_str(), O_RDWR | O_CREAT | O_TRUNC);
+  PCHECK(ftruncate(file_.fd(), segmentBytes_) == 0);
+  void* mapping = mmap(nullptr,
+                       segmentBytes_,
+                       PROT_READ | PROT_WRITE,
+                       MAP_SHARED,
+                       file_.fd(),
+                       0);
+  PCHECK(mapping != MAP_FAILED);
+  mapping_ = static_cast<char*>(mapping);
+  SegmentHeader header{SegmentHeader::kMagic,
+                       SegmentHeader::kVersion,
+                       sizeof(AccessLogRecord),
+                       0};
+  memcpy(mapping_, &header, sizeof(header));
+  writeOffset_ = sizeof(header);
+}
+
+void BinaryAccessLog::closeSegment() {
+  if (!mapping_) {
+    return;
+  }
+  PCHECK(msync(mapping_, writeOffset_, MS_SYNC) == 0);
+  PCHECK(munmap(mapping_, segmentBytes_) == 0);
+  mapping_ = nullptr;
+  // Trim the unused tail so readers see exactly the committed records.
+  PCHECK(ftruncate(file_.fd(), writeOffset_) == 0);
+  file_.close();
+}
+
+std::vector<AccessLogRecord> BinaryAccessLog::decodeFile(
+    const std::string& path) {
+  std::string contents;
+  if (!folly::readFile(path.c_str(), contents)) {
+    folly::throw_exception<Exception>(
+        folly::to<std::string>("cannot read access log: ", path));
+  }
+  if (contents.size() < sizeof(SegmentHeader)) {
+    folly::throw_exception<Exception>("truncated access log header");
+  }
+  SegmentHeader header;
+  memcpy(&header, contents.data(), sizeof(header));
+  if (header.magic != SegmentHeader::kMagic ||
+      header.version != SegmentHeader::kVersion ||
+      header.recordSize != sizeof(AccessLogRecord)) {
+    folly::throw_exception<Exception>("bad access log header");
+  }
+  const size_t available =
+      (contents.size() - sizeof(header)) / sizeof(AccessLogRecord);
+  if (header.recordCount > available) {
+    folly::throw_exception<Exception>("truncated access log record");
+  }
+  std::vector<AccessLogRecord> records(header.recordCount);
+  memcpy(records.data(),
+         contents.data() + sizeof(header),
+         header.recordCount * sizeof(AccessLogRecord));
+  return records;
+}
+
+std::string BinaryAccessLog::formatRecord(const AccessLogRecord& record) {
+  auto usSince = [&](uint64_t eventNs) -> int64_t {
+    return eventNs == 0 ? -1 : int64_t(eventNs - record.startNs) / 1000;
+  };
+  return folly::to<std::string>(
+      "start_ns=", record.startNs,
+      " stream=", record.streamId,
+      " sni=", folly::StringPiece(record.sni, record.sniLength),
+      " status=", record.status,
+      " bytes_out=", record.egressBodyBytes,
+      " bytes_in=", record.ingressBodyBytes,
+      " ttfb_us=", usSince(record.firstByteNs),
+      " ttlb_us=", usSince(record.lastByteNs),
+      " aborted=", int(record.aborted));
+}
+
+void BinaryAccessLog::convertFile(const std::string& path,
+                                  std::ostream& out) {
+  for (const auto& record : decodeFile(path)) {
+    out << formatRecord(record) << "\n";
+  }
+}
+
+} // namespace proxygen
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <folly/File.h>
+#include <folly/ThreadLocal.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace proxygen {
+
+/**
+ * Fixed-size binary access log record, one per transaction.  Filled from
+ * HTTPTransaction::Timings and the session's setup TransportInfo when a
+ * transaction detaches, so it covers codec-level errors that never reach
+ * a handler.  Timestamps are steady-clock nanoseconds since epoch; zero
+ * means the event never happened.
+ */
+struct AccessLogRecord {
+  static constexpr size_t kSniLength = 64;
+
+  uint64_t startNs{0};       // transaction created
+  uint64_t firstByteNs{0};   // first egress header byte flushed
+  uint64_t lastByteNs{0};    // last egress byte flushed
+  uint64_t streamId{0};
+  uint64_t egressBodyBytes{0};
+  uint64_t ingressBodyBytes{0};
+  uint16_t status{0};        // 0 when no response headers were sent
+  uint8_t aborted{0};
+  uint8_t sniLength{0};
+  uint32_t pad{0};
+  char sni[kSniLength]{};    // not NUL-terminated; sniLength bytes valid
+};
+
+/**
+ * Single-producer single-consumer ring of access log records.  The
+ * producer is the worker thread calling tryWrite(); the consumer is the
+ * rotation thread calling drainTo().  Both sides are lock-free.
+ */
+class AccessLogRingBuffer {
+ public:
+  // Capacity is rounded up to a power of two, minimum 2.
+  explicit AccessLogRingBuffer(size_t capacity);
+
+  // Producer thread only.  Returns false (record dropped) when full.
+  bool tryWrite(const AccessLogRecord& record);
+
+  // Consumer thread only.  Appends drained records to 'out' and returns
+  // how many were drained.
+  size_t drainTo(std::vector<AccessLogRecord>& out);
+
+ private:
+  std::vector<AccessLogRecord> records_;
+  size_t mask_;
+  std::atomic<uint64_t> head_{0};  // next slot to write
+  std::atomic<uint64_t> tail_{0};  // next slot to read
+};
+
+/**
+ * Binary access log backend.  log() pushes a record into a per-thread
+ * lock-free ring; a background thread periodically drains every ring
+ * into the current mmap'd segment file and rotates to a new segment when
+ * it fills up.  When a ring is full the record is dropped and counted
+ * rather than blocking the worker.
+ *
+ * Segments are named "<pathPrefix>.<index>", start with a SegmentHeader
+ * whose recordCount field is kept current by the rotation thread (so a
+ * crash leaves at most one spill interval of records unaccounted), and
+ * are truncated to their used length on rotation.  decodeFile() reads a
+ * segment back and convertFile() renders it as text, one line per
+ * record.
+ */
+class BinaryAccessLog {
+ public:
+  struct SegmentHeader {
+    static constexpr uint64_t kMagic = 0x70786e61636c6f67ULL;  // "pxnaclog"
+    static constexpr uint32_t kVersion = 1;
+
+    uint64_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t recordCount;
+  };
+
+  explicit BinaryAccessLog(
+      std::string pathPrefix,
+      size_t segmentBytes = 64 * 1024 * 1024,
+      size_t perThreadCapacity = 4096,
+      std::chrono::milliseconds spillInterval = std::chrono::milliseconds(
+          100));
+
+  // Stops the rotation thread after a final drain of all rings.
+  ~BinaryAccessLog();
+
+  // Callable from any thread; never blocks.
+  void log(const AccessLogRecord& record);
+
+  uint64_t getDroppedCount() const {
+    return droppedRecords_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Offline decoder: reads a segment produced by this writer and returns
+   * its committed records, throwing proxygen::Exception on a malformed
+   * file.
+   */
+  static std::vector<AccessLogRecord> decodeFile(const std::string& path);
+
+  // Renders one record as a key=value text line (no trailing newline).
+  static std::string formatRecord(const AccessLogRecord& record);
+
+  // Decodes a segment and writes one formatRecord() line per record.
+  static void convertFile(const std::string& path, std::ostream& out);
+
+ private:
+  AccessLogRingBuffer& threadLocalRing();
+  void spillLoop();
+  void drainAllRings();
+  void append(const std::vector<AccessLogRecord>& records);
+  void openSegment();
+  void closeSegment();
+
+  const std::string pathPrefix_;
+  const size_t segmentBytes_;
+  const size_t perThreadCapacity_;
+  const std::chrono::milliseconds spillInterval_;
+
+  // Rotation thread only (after construction).
+  folly::File file_;
+  char* mapping_{nullptr};
+  size_t writeOffset_{0};
+  size_t segmentIndex_{0};
+
+  folly::ThreadLocal<AccessLogRingBuffer*> ring_;
+  std::mutex ringsMutex_;  // guards rings_ registration
+  std::vector<std::unique_ptr<AccessLogRingBuffer>> rings_;
+
+  std::atomic<uint64_t> droppedRecords_{0};
+
+  std::mutex stopMutex_;
+  std::condition_variable stopCondition_;
+  bool stop_{false};
+  std::thread spillThread_;
+};
+
+} // namespace proxygen
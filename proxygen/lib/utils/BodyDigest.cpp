@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/utils/BodyDigest.h>
+
+#include <folly/Conv.h>
+#include <folly/hash/Checksum.h>
+#include <folly/portability/OpenSSL.h>
+#include <glog/logging.h>
+#include <openssl/evp.h>
+#include <proxygen/lib/utils/CryptUtil.h>
+
+namespace proxygen {
+
+namespace {
+
+const EVP_MD* evpDigest(DigestAlgorithm algorithm) {
+  switch (algorithm) {
+    case DigestAlgorithm::SHA256:
+      return EVP_sha256();
+    case DigestAlgorithm::SHA512:
+      return EVP_sha512();
+    case DigestAlgorithm::MD5:
+      return EVP_md5();
+    case DigestAlgorithm::CRC32C:
+      return nullptr;
+  }
+  LOG(FATAL) << "bad algorithm=" << uint32_t(algorithm);
+  folly::assume_unreachable();
+}
+
+} // namespace
+
+folly::StringPiece digestAlgorithmName(DigestAlgorithm algorithm) {
+  switch (algorithm) {
+    case DigestAlgorithm::SHA256:
+      return "sha-256";
+    case DigestAlgorithm::SHA512:
+      return "sha-512";
+    case DigestAlgorithm::MD5:
+      return "md5";
+    case DigestAlgorithm::CRC32C:
+      return "crc32c";
+  }
+  LOG(FATAL) << "bad algorithm=" << uint32_t(algorithm);
+  folly::assume_unreachable();
+}
+
+BodyDigestContext::BodyDigestContext(DigestAlgorithm algorithm)
+    : algorithm_(algorithm) {
+  auto md = evpDigest(algorithm_);
+  if (md) {
+    mdCtx_ = EVP_MD_CTX_new();
+    CHECK(mdCtx_);
+    CHECK_EQ(EVP_DigestInit_ex(mdCtx_, md, nullptr), 1);
+  }
+}
+
+BodyDigestContext::~BodyDigestContext() {
+  if (mdCtx_) {
+    EVP_MD_CTX_free(mdCtx_);
+  }
+}
+
+void BodyDigestContext::update(folly::ByteRange data) {
+  if (data.empty()) {
+    return;
+  }
+  if (mdCtx_) {
+    CHECK_EQ(EVP_DigestUpdate(mdCtx_, data.data(), data.size()), 1);
+  } else {
+    crc_ = folly::crc32c(data.data(), data.size(), crc_);
+  }
+}
+
+void BodyDigestContext::update(const folly::IOBuf& chain) {
+  for (auto range : chain) {
+    update(range);
+  }
+}
+
+std::string BodyDigestContext::finish() {
+  unsigned char digest[EVP_MAX_MD_SIZE];
+  unsigned int digestLen = 0;
+  if (mdCtx_) {
+    CHECK_EQ(EVP_DigestFinal_ex(mdCtx_, digest, &digestLen), 1);
+  } else {
+    // CRC32C per RFC 3230: final inversion, then the big-endian value
+    uint32_t crc = ~crc_;
+    digest[0] = uint8_t(crc >> 24);
+    digest[1] = uint8_t(crc >> 16);
+    digest[2] = uint8_t(crc >> 8);
+    digest[3] = uint8_t(crc);
+    digestLen = sizeof(crc);
+  }
+  return folly::to<std::string>(digestAlgorithmName(algorithm_),
+                                "=",
+                                base64Encode(folly::ByteRange(
+                                    digest, digestLen)));
+}
+
+} // namespace proxygen
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+#include <string>
+
+typedef struct evp_md_ctx_st EVP_MD_CTX;
+
+namespace proxygen {
+
+enum class DigestAlgorithm : uint8_t {
+  SHA256 = 0,
+  SHA512 = 1,
+  MD5 = 2,
+  CRC32C = 3,
+};
+
+/**
+ * RFC 3230 algorithm token for the given algorithm ("sha-256", etc)
+ */
+folly::StringPiece digestAlgorithmName(DigestAlgorithm algorithm);
+
+/**
+ * Incremental digest over a body streamed in chunks, so the bytes are
+ * hashed in the same pass that already walks them for egress instead of
+ * a second traversal by the handler.  The heavy lifting is delegated to
+ * implementations that pick vectorized/hardware code paths at runtime:
+ * OpenSSL's EVP digests (SHA-NI, AVX2) and folly's crc32c (SSE4.2 /
+ * ARMv8 CRC instructions).
+ */
+class BodyDigestContext {
+ public:
+  explicit BodyDigestContext(DigestAlgorithm algorithm);
+  ~BodyDigestContext();
+
+  BodyDigestContext(const BodyDigestContext&) = delete;
+  BodyDigestContext& operator=(const BodyDigestContext&) = delete;
+
+  void update(folly::ByteRange data);
+
+  /**
+   * Digest every buffer in the chain
+   */
+  void update(const folly::IOBuf& chain);
+
+  /**
+   * Finalize and return an RFC 3230 instance-digest value,
+   * "<algorithm>=<base64 digest>", suitable for a Digest header or
+   * trailer.  The context cannot be updated afterwards.
+   */
+  std::string finish();
+
+  DigestAlgorithm getAlgorithm() const {
+    return algorithm_;
+  }
+
+ private:
+  DigestAlgorithm algorithm_;
+  EVP_MD_CTX* mdCtx_{nullptr};
+  uint32_t crc_{~0u};
+};
+
+} // namespace proxygen
@@ -12,6 +12,7 @@
 #include <folly/Memory.h>
 #include <glog/logging.h>
 #include <memory>
+#include <tuple>
 #include <utility>
 
 namespace proxygen {
@@ -383,4 +384,53 @@ class FilterChain : private FilterType {
   T1* chainEnd_;
 };
 
+/**
+ * A FilterChain whose filter set is fixed at compile time.  The filters
+ * live by value inside the chain object, in declaration order -- a single
+ * contiguous block instead of one heap node per filter -- and are wired up
+ * at construction.  Each hop still dispatches through the T1/T2 vtables
+ * (the interfaces are abstract), but co-locating the filters removes the
+ * per-filter allocations and the pointer-chasing cache misses of the
+ * dynamic chain, and gives the compiler a static type for every filter so
+ * calls into them from outside the chain can be devirtualized.
+ *
+ * Filters are listed outermost first: calls traverse them left to right,
+ * callbacks right to left.  Every filter type must be default
+ * constructible.  The chain does not own the destination.
+ */
+template <typename T1,
+          typename T2,
+          typename FilterType,
+          void (T1::*set_callback)(T2*),
+          typename... FilterTypes>
+class StaticFilterChain
+    : public FilterChain<T1, T2, FilterType, set_callback, false> {
+ public:
+  explicit StaticFilterChain(T1* destination)
+      : FilterChain<T1, T2, FilterType, set_callback, false>(destination) {
+    appendInReverse(std::index_sequence_for<FilterTypes...>());
+  }
+
+  /**
+   * Access the I-th filter (0 = outermost) with its static type.
+   */
+  template <size_t I>
+  auto& getFilter() {
+    return std::get<I>(filters_);
+  }
+
+ private:
+  // append() inserts at the front of the chain, so hand addFilters() the
+  // pack innermost first to keep declaration order == call order
+  template <size_t... Is>
+  void appendInReverse(std::index_sequence<Is...>) {
+    if constexpr (sizeof...(Is) > 0) {
+      this->addFilters(
+          (&std::get<sizeof...(FilterTypes) - 1 - Is>(filters_))...);
+    }
+  }
+
+  std::tuple<FilterTypes...> filters_;
+};
+
 } // namespace proxygen
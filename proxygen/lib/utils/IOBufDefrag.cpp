@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/utils/IOBufDefrag.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace proxygen {
+
+std::unique_ptr<folly::IOBuf> defragmentIOBufChain(
+    std::unique_ptr<folly::IOBuf> chain,
+    size_t smallThreshold,
+    IOBufDefragStats* stats) {
+  IOBufDefragStats localStats;
+  if (!stats) {
+    stats = &localStats;
+  }
+
+  std::unique_ptr<folly::IOBuf> result;
+  folly::IOBuf* slab = nullptr; // open slab with tailroom, if any
+  size_t slabsInRun = 0;
+
+  auto appendBuf = [&](std::unique_ptr<folly::IOBuf> buf) {
+    stats->buffersOut++;
+    if (!result) {
+      result = std::move(buf);
+    } else {
+      result->prependChain(std::move(buf));
+    }
+  };
+
+  auto cur = std::move(chain);
+  while (cur) {
+    auto next = cur->pop();
+    const size_t len = cur->length();
+    stats->buffersIn++;
+    if (len >= smallThreshold) {
+      // Large buffers move over zero-copy and end the current run
+      slab = nullptr;
+      slabsInRun = 0;
+      appendBuf(std::move(cur));
+    } else if (len > 0) {
+      size_t copied = 0;
+      while (copied < len) {
+        if (!slab || slab->tailroom() == 0) {
+          const size_t slabSize =
+              slabsInRun == 0 ? kDefragSmallSlabSize : kDefragLargeSlabSize;
+          auto newSlab = folly::IOBuf::create(slabSize);
+          slab = newSlab.get();
+          ++slabsInRun;
+          appendBuf(std::move(newSlab));
+        }
+        const size_t n = std::min(len - copied, slab->tailroom());
+        memcpy(slab->writableTail(), cur->data() + copied, n);
+        slab->append(n);
+        copied += n;
+      }
+      stats->bytesCopied += len;
+    }
+    cur = std::move(next);
+  }
+
+  if (!result) {
+    // chain held no bytes; hand back an empty buffer rather than null
+    result = folly::IOBuf::create(0);
+    stats->buffersOut++;
+  }
+  return result;
+}
+
+} // namespace proxygen
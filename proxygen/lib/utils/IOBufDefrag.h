@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <folly/io/IOBuf.h>
+
+namespace proxygen {
+
+/**
+ * What a defragmentation pass did to a chain; in/out are the chain's
+ * buffer counts before and after, bytesCopied how much was memcpy'd
+ * into slabs (the rest moved over zero-copy).
+ */
+struct IOBufDefragStats {
+  size_t buffersIn{0};
+  size_t buffersOut{0};
+  size_t bytesCopied{0};
+};
+
+/**
+ * Slab sizes used when coalescing runs of small buffers.  A run starts
+ * in a 4KB slab; runs that overflow it escalate to 16KB slabs, so long
+ * trains of tiny buffers (frame headers, chunk envelopes) collapse into
+ * few allocations while a lone small buffer between large ones costs
+ * one page.  Both match common allocator size classes.
+ */
+constexpr size_t kDefragSmallSlabSize = 4 * 1024;
+constexpr size_t kDefragLargeSlabSize = 16 * 1024;
+
+/**
+ * Rebuild chain so runs of buffers smaller than smallThreshold are
+ * copied into slabs while larger buffers are relinked zero-copy.
+ * Preserves byte order and drops empty buffers.  Intended for gather
+ * lists about to exceed an iovec budget, where the writev setup and
+ * IOV_MAX truncation cost more than copying the small pieces.
+ */
+std::unique_ptr<folly::IOBuf> defragmentIOBufChain(
+    std::unique_ptr<folly::IOBuf> chain,
+    size_t smallThreshold,
+    IOBufDefragStats* stats = nullptr);
+
+} // namespace proxygen
@@ -10,11 +10,18 @@
 
 #include <glog/logging.h>
 
+#include <cstring>
 #include <folly/FBVector.h>
 #include <folly/Optional.h>
 #include <proxygen/lib/utils/UtilInl.h>
 #include <string>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 // TODO: consider changing API methods that take in an reference with versions
 // that don't so that callers can give up ownership if they like via std::move
 // operator (and subsequently we would use it as well).
@@ -23,6 +30,71 @@
 
 namespace proxygen {
 
+namespace detail {
+
+/**
+ * Index of the first occurrence of key in buf, or len if it does not occur.
+ * The key vectors scanned here are short (one byte per entry in the map), so
+ * an inline compare-and-movemask loop beats calling out to memchr, which
+ * pays an alignment preamble tuned for long buffers.
+ */
+#if defined(__SSE2__)
+
+inline size_t findFirstKeyByte(const uint8_t* buf, size_t len, uint8_t key) {
+  size_t i = 0;
+  const __m128i needle = _mm_set1_epi8(static_cast<char>(key));
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + i));
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, needle));
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  for (; i < len; ++i) {
+    if (buf[i] == key) {
+      return i;
+    }
+  }
+  return len;
+}
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+
+inline size_t findFirstKeyByte(const uint8_t* buf, size_t len, uint8_t key) {
+  size_t i = 0;
+  const uint8x16_t needle = vdupq_n_u8(key);
+  for (; i + 16 <= len; i += 16) {
+    if (vmaxvq_u8(vceqq_u8(vld1q_u8(buf + i), needle)) != 0) {
+      break;
+    }
+  }
+  for (; i < len; ++i) {
+    if (buf[i] == key) {
+      return i;
+    }
+  }
+  return len;
+}
+
+#else
+
+inline size_t findFirstKeyByte(const uint8_t* buf, size_t len, uint8_t key) {
+  const void* p = memchr(buf, key, len);
+  return p == nullptr
+             ? len
+             : static_cast<size_t>(static_cast<const uint8_t*>(p) - buf);
+}
+
+#endif
+
+} // namespace detail
+
+// Capacity preset for the InitialCapacity template parameter below.  Keys
+// are one byte each, so reserving a cache line worth of them up front keeps
+// the entire key scan of a header-sized map (tens of entries) within a
+// single line and avoids reallocating the key vector while the map fills.
+constexpr size_t kPerfectIndexMapCacheLineCapacity = 64;
+
 // A type of key-value map implemented by indexing values in a vector.
 // Performance is on average that of an unordered_map or better when the
 // index is used effectively.  CPU and memory usage are significantly reduced
@@ -39,16 +111,24 @@ namespace proxygen {
 //    duplicate keys.  It is mainly used for optimization purposes as the
 //    implementation of default handling adds additional useless work for such
 //    cases in which duplicates are not tolerated.
+// InitialCapacity, if nonzero, is the number of entries reserved in the key
+//    and value vectors on construction.  Use kPerfectIndexMapCacheLineCapacity
+//    for maps with the occupancy profile of an HTTP header block.
 template <typename Key,
           Key OtherKey,
           Key NoneKey,
           Key (*PerfectHashStrToKey)(const std::string &),
           bool AllowDuplicates,
-          bool CaseInsensitive>
+          bool CaseInsensitive,
+          size_t InitialCapacity = 0>
 class PerfectIndexMap {
  public:
   static_assert(sizeof(Key) == 1, "Key must be of size 1 byte.");
   PerfectIndexMap() {
+    if (InitialCapacity > 0) {
+      keys_.reserve(InitialCapacity);
+      values_.reserve(InitialCapacity);
+    }
   }
   virtual ~PerfectIndexMap() = default;
 
@@ -276,11 +356,16 @@ class PerfectIndexMap {
   // searching position.
   std::ptrdiff_t searchForKey(Key key, const Key *&data) const {
     if (data) {
-      data = (Key *)memchr(
-          (void *)data, key, keys_.size() - (data - keys_.data()));
-      if (data) {
+      size_t remaining = keys_.size() - (data - keys_.data());
+      size_t offset =
+          detail::findFirstKeyByte(reinterpret_cast<const uint8_t *>(data),
+                                   remaining,
+                                   static_cast<uint8_t>(key));
+      if (offset < remaining) {
+        data += offset;
         return data - keys_.data();
       }
+      data = nullptr;
     }
     return -1;
   }
@@ -16,13 +16,40 @@
 #include <vector>
 
 namespace proxygen {
+
+namespace {
+
+double invertWeight(uint64_t weight) {
+  return weight == 0 ? 0 : (double)1 / weight;
+}
+
+} // namespace
+
 void RendezvousHash::build(
     std::vector<std::pair<std::string, uint64_t>>& nodes) {
+  nodes_.reserve(nodes.size());
   for (auto it = nodes.begin(); it != nodes.end(); ++it) {
-    std::string key = it->first;
+    const std::string& key = it->first;
     uint64_t weight = it->second;
-    weights_.emplace_back(computeHash(key.c_str(), key.size()), weight);
+    nodes_.push_back(Node{computeHash(key.c_str(), key.size()),
+                          weight,
+                          invertWeight(weight)});
+  }
+}
+
+bool RendezvousHash::updateWeight(const std::string& name, uint64_t weight) {
+  // only the named node is rehashed; everything else keeps its cached
+  // state, so assignments of keys not involving this node are untouched
+  const uint64_t hash = computeHash(name.c_str(), name.size());
+  bool found = false;
+  for (auto& node : nodes_) {
+    if (node.hash == hash) {
+      node.weight = weight;
+      node.invWeight = invertWeight(weight);
+      found = true;
+    }
   }
+  return found;
 }
 
 /*
@@ -134,26 +161,22 @@ size_t RendezvousHash::getNthByWeightedHash(
     const uint64_t key,
     const size_t rank,
     std::vector<size_t>* returnRankIds) const {
-  size_t modRank = rank % weights_.size();
+  size_t modRank = rank % nodes_.size();
   // optimize if required to return element with max weight, rank ==
-  // weights_.size(), keep track of the maxWeightIndex instead of populating
+  // nodes_.size(), keep track of the maxWeightIndex instead of populating
   // scaledWeights array.
   double maxWeight = -1;
   int maxWeightIndex = 0;
 
   std::vector<std::pair<double, size_t>> scaledWeights;
   if (modRank != 0) {
-    scaledWeights.reserve(weights_.size());
+    scaledWeights.reserve(nodes_.size());
   }
-  for (size_t i = 0; i < weights_.size(); ++i) {
-    const auto& entry = weights_[i];
-    // combine the hash with the cluster together
-    double combinedHash = computeHash(entry.first + key);
-    double scaledHash =
-        (double)combinedHash / std::numeric_limits<uint64_t>::max();
+
+  auto rankNode = [&](size_t i, double scaledHash) {
     double scaledWeight = 0;
-    if (entry.second != 0) {
-      scaledWeight = pow(scaledHash, (double)1 / entry.second);
+    if (nodes_[i].weight != 0) {
+      scaledWeight = pow(scaledHash, nodes_[i].invWeight);
     }
     if (modRank == 0) {
       if (scaledWeight > maxWeight) {
@@ -163,6 +186,28 @@ size_t RendezvousHash::getNthByWeightedHash(
     } else {
       scaledWeights.emplace_back(scaledWeight, i);
     }
+  };
+
+  // Mix the key into the cached node hashes a batch at a time: the mixes
+  // and int-to-double conversions carry no cross-node dependency, so the
+  // unrolled block keeps several in flight (and vectorizes where the ISA
+  // allows).  The pow() stays scalar; libm dominates that part anyway.
+  constexpr size_t kBatch = 4;
+  constexpr double kHashSpan = std::numeric_limits<uint64_t>::max();
+  const size_t numNodes = nodes_.size();
+  double scaledHashes[kBatch];
+  size_t i = 0;
+  for (; i + kBatch <= numNodes; i += kBatch) {
+    for (size_t j = 0; j < kBatch; ++j) {
+      scaledHashes[j] =
+          (double)computeHash(nodes_[i + j].hash + key) / kHashSpan;
+    }
+    for (size_t j = 0; j < kBatch; ++j) {
+      rankNode(i + j, scaledHashes[j]);
+    }
+  }
+  for (; i < numNodes; ++i) {
+    rankNode(i, (double)computeHash(nodes_[i].hash + key) / kHashSpan);
   }
 
   size_t rankIndex;
@@ -200,8 +245,8 @@ std::vector<size_t> RendezvousHash::selectNUnweighted(const uint64_t key,
                                                       const size_t rank) const {
   std::vector<size_t> selection;
   // shortcut if rank is equal or larger than array size
-  if (rank >= weights_.size()) {
-    selection = std::vector<size_t>(weights_.size());
+  if (rank >= nodes_.size()) {
+    selection = std::vector<size_t>(nodes_.size());
     std::generate(
         selection.begin(), selection.end(), [n = 0]() mutable { return n++; });
     return selection;
@@ -26,12 +26,34 @@ class RendezvousHash : public ConsistentHash {
 
   void build(std::vector<std::pair<std::string, uint64_t>>&) override;
 
+  /**
+   * Incrementally change one node's weight without rebuilding: only the
+   * named node's cached state is touched, so the other nodes keep their
+   * hashes and every key not mapped to (or from) this node keeps its
+   * assignment.  Weight 0 effectively drains the node.
+   *
+   * Returns false if the name was not part of the pool given to build().
+   * Not thread safe with get(), same as build().
+   */
+  bool updateWeight(const std::string& name, uint64_t weight);
+
   size_t get(const uint64_t key, const size_t rank = 0) const override;
 
   std::vector<size_t> selectNUnweighted(const uint64_t key,
                                         const size_t rank) const;
 
  private:
+  /**
+   * Per-node state cached at build() time so a lookup only mixes the
+   * request key: the node's name hash is fixed, and 1/weight is kept as
+   * a double so the scaling pow() needs no divide.
+   */
+  struct Node {
+    uint64_t hash;
+    uint64_t weight;
+    double invWeight;
+  };
+
   size_t getNthByWeightedHash(const uint64_t key,
                               const size_t modRank,
                               std::vector<size_t>* returnRankIds) const;
@@ -39,7 +61,7 @@ class RendezvousHash : public ConsistentHash {
 
   uint64_t computeHash(uint64_t i) const;
 
-  std::vector<std::pair<uint64_t, uint64_t>> weights_;
+  std::vector<Node> nodes_;
 };
 
 } // namespace proxygen
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/utils/RotatingBloomFilter.h>
+
+#include <folly/hash/Hash.h>
+
+#include <cmath>
+
+namespace {
+
+size_t roundUpToPowerOfTwo(size_t n) {
+  size_t result = 1;
+  while (result < n) {
+    result <<= 1;
+  }
+  return result;
+}
+
+int64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             proxygen::getCurrentTime().time_since_epoch())
+      .count();
+}
+
+} // namespace
+
+namespace proxygen {
+
+RotatingBloomFilter::RotatingBloomFilter(size_t expectedEntries,
+                                         double falsePositiveRate,
+                                         std::chrono::seconds generationLifetime)
+    : numHashes_(std::max<size_t>(
+          1, size_t(std::round(-std::log(falsePositiveRate) / std::log(2))))),
+      generationLifetime_(generationLifetime),
+      wordMask_(roundUpToPowerOfTwo(std::max<size_t>(
+                    1,
+                    size_t(std::ceil(-double(expectedEntries) *
+                                     std::log(falsePositiveRate) /
+                                     (std::log(2) * std::log(2)))) /
+                        64)) -
+                1),
+      generationStartNs_(nowNs()) {
+  words_[0] = std::vector<std::atomic<uint64_t>>(wordMask_ + 1);
+  words_[1] = std::vector<std::atomic<uint64_t>>(wordMask_ + 1);
+}
+
+bool RotatingBloomFilter::testAndSet(uint64_t keyHash) {
+  maybeRotate();
+  const auto current = current_.load(std::memory_order_acquire);
+  // Double hashing: probe i lands at h1 + i * h2
+  const uint64_t h2 = folly::hash::twang_mix64(keyHash) | 1;
+  bool presentInCurrent = true;
+  uint64_t slot = keyHash;
+  for (size_t i = 0; i < numHashes_; i++, slot += h2) {
+    auto& word = words_[current][(slot >> 6) & wordMask_];
+    const uint64_t bit = 1ULL << (slot & 63);
+    if ((word.fetch_or(bit, std::memory_order_relaxed) & bit) == 0) {
+      presentInCurrent = false;
+    }
+  }
+  return presentInCurrent || probe(words_[current ^ 1], keyHash);
+}
+
+bool RotatingBloomFilter::test(uint64_t keyHash) const {
+  const auto current = current_.load(std::memory_order_acquire);
+  return probe(words_[current], keyHash) ||
+         probe(words_[current ^ 1], keyHash);
+}
+
+bool RotatingBloomFilter::probe(
+    const std::vector<std::atomic<uint64_t>>& words, uint64_t keyHash) const {
+  const uint64_t h2 = folly::hash::twang_mix64(keyHash) | 1;
+  uint64_t slot = keyHash;
+  for (size_t i = 0; i < numHashes_; i++, slot += h2) {
+    const uint64_t bit = 1ULL << (slot & 63);
+    if ((words[(slot >> 6) & wordMask_].load(std::memory_order_relaxed) &
+         bit) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void RotatingBloomFilter::maybeRotate() {
+  const auto start = generationStartNs_.load(std::memory_order_relaxed);
+  const auto now = nowNs();
+  if (now - start <
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          generationLifetime_)
+          .count()) {
+    return;
+  }
+  // One thread wins the rotation; everyone else keeps inserting into the
+  // generation that is current while it runs.
+  bool expected = false;
+  if (!rotating_.compare_exchange_strong(
+          expected, true, std::memory_order_acq_rel)) {
+    return;
+  }
+  const auto retiring = current_.load(std::memory_order_relaxed) ^ 1;
+  for (auto& word : words_[retiring]) {
+    word.store(0, std::memory_order_relaxed);
+  }
+  current_.store(retiring, std::memory_order_release);
+  generationStartNs_.store(now, std::memory_order_relaxed);
+  rotating_.store(false, std::memory_order_release);
+}
+
+} // namespace proxygen
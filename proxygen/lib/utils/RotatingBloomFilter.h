@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <proxygen/lib/utils/Time.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace proxygen {
+
+/**
+ * Bloom filter over 64-bit key hashes with lock-free insert and query,
+ * rotated through two generations so stale entries age out.  Inserts go
+ * into the current generation; queries probe both, so a key is
+ * remembered for between one and two generation lifetimes.
+ *
+ * Rotation happens inline on whichever caller first notices the
+ * lifetime has elapsed; it clears the retiring generation word by word
+ * while other threads keep probing, which can only produce false
+ * negatives (a just-rotated-out key briefly reads as absent), never
+ * false positives beyond the filter's configured rate.  That makes it
+ * suitable for anti-replay caches, where a false positive rejects one
+ * legitimate request and a false negative merely falls back to the
+ * pre-filter behavior.
+ */
+class RotatingBloomFilter {
+ public:
+  /**
+   * Sizes the filter for roughly falsePositiveRate when each generation
+   * holds expectedEntries keys.
+   */
+  RotatingBloomFilter(size_t expectedEntries,
+                      double falsePositiveRate,
+                      std::chrono::seconds generationLifetime);
+
+  /**
+   * Returns true if the key was possibly seen within the last one to
+   * two generation lifetimes, and records it in the current generation
+   * either way.  Lock-free; callable from any thread.
+   */
+  bool testAndSet(uint64_t keyHash);
+
+  // Query without inserting.
+  bool test(uint64_t keyHash) const;
+
+  size_t getNumHashes() const {
+    return numHashes_;
+  }
+
+  size_t getBitsPerGeneration() const {
+    return words_[0].size() * 64;
+  }
+
+ private:
+  void maybeRotate();
+  bool probe(const std::vector<std::atomic<uint64_t>>& words,
+             uint64_t keyHash) const;
+
+  const size_t numHashes_;
+  const std::chrono::seconds generationLifetime_;
+  const size_t wordMask_;
+
+  std::vector<std::atomic<uint64_t>> words_[2];
+  std::atomic<uint32_t> current_{0};
+  std::atomic<int64_t> generationStartNs_;
+  std::atomic<bool> rotating_{false};
+};
+
+} // namespace proxygen
@@ -0,0 +1,355 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/utils/SocketTunnel.h>
+
+#include <folly/ExceptionString.h>
+#include <folly/io/async/EventBase.h>
+#include <folly/portability/Fcntl.h>
+#include <folly/portability/Sockets.h>
+#include <folly/portability/Unistd.h>
+
+namespace {
+// Same read sizing the sample proxy uses for its CONNECT relay
+constexpr uint32_t kMinReadSize = 1460;
+constexpr uint32_t kMaxReadSize = 4000;
+#ifdef __linux__
+// Upper bound on bytes parked in each direction's pipe; matches the
+// default pipe capacity so splice never blocks on the pipe itself
+constexpr size_t kMaxPipeBytes = 65536;
+#endif
+} // namespace
+
+namespace proxygen {
+
+void SocketTunnel::start(folly::AsyncTransport::UniquePtr client,
+                         folly::AsyncTransport::UniquePtr server,
+                         StatsCallback statsCallback) {
+  auto* tunnel = new SocketTunnel(
+      std::move(client), std::move(server), std::move(statsCallback));
+#ifdef __linux__
+  if (tunnel->tryStartSplice()) {
+    // The splice relay owns the raw fds now; it may even have finished
+    // already if both sides were at EOF
+    return;
+  }
+#endif
+  tunnel->startBufferRelays();
+}
+
+SocketTunnel::SocketTunnel(folly::AsyncTransport::UniquePtr client,
+                           folly::AsyncTransport::UniquePtr server,
+                           StatsCallback statsCallback)
+    : client_(std::move(client)),
+      server_(std::move(server)),
+      statsCallback_(std::move(statsCallback)) {
+}
+
+SocketTunnel::~SocketTunnel() {
+  if (client_) {
+    client_->setReadCB(nullptr);
+  }
+  if (server_) {
+    server_->setReadCB(nullptr);
+  }
+#ifdef __linux__
+  // Handlers must unregister before their fds close
+  clientHandler_.reset();
+  serverHandler_.reset();
+  for (auto* dir : {&spliceOut_, &spliceBack_}) {
+    for (int fd : dir->pipeFds) {
+      if (fd >= 0) {
+        ::close(fd);
+      }
+    }
+  }
+  if (spliceOut_.srcFd >= 0) {
+    ::close(spliceOut_.srcFd);
+  }
+  if (spliceOut_.dstFd >= 0) {
+    ::close(spliceOut_.dstFd);
+  }
+#endif
+}
+
+void SocketTunnel::startBufferRelays() {
+  VLOG(4) << "starting IOBuf pass-through tunnel";
+  clientToServer_ = std::make_unique<BufferRelay>(
+      *this, client_.get(), server_.get(), bytesClientToServer_);
+  serverToClient_ = std::make_unique<BufferRelay>(
+      *this, server_.get(), client_.get(), bytesServerToClient_);
+  clientToServer_->startRelay();
+  serverToClient_->startRelay();
+}
+
+void SocketTunnel::relayDone() {
+  if (clientToServer_->done() && serverToClient_->done()) {
+    finish();
+  }
+}
+
+void SocketTunnel::closeWithError() {
+  if (closing_) {
+    return;
+  }
+  closing_ = true;
+  // Failing pending writes below re-enters the relays' writeErr, which
+  // lands back here and bails on the flag above
+  if (client_) {
+    client_->setReadCB(nullptr);
+    client_->closeWithReset();
+  }
+  if (server_) {
+    server_->setReadCB(nullptr);
+    server_->closeWithReset();
+  }
+  finish();
+}
+
+void SocketTunnel::finish() {
+  VLOG(4) << "tunnel closed, clientToServer=" << bytesClientToServer_
+          << " serverToClient=" << bytesServerToClient_;
+  if (statsCallback_) {
+    statsCallback_(bytesClientToServer_, bytesServerToClient_);
+  }
+  delete this;
+}
+
+// BufferRelay
+
+void SocketTunnel::BufferRelay::getReadBuffer(void** bufReturn,
+                                              size_t* lenReturn) {
+  auto readSpace = buf_.preallocate(kMinReadSize, kMaxReadSize);
+  *bufReturn = readSpace.first;
+  *lenReturn = readSpace.second;
+}
+
+void SocketTunnel::BufferRelay::readDataAvailable(size_t len) noexcept {
+  buf_.postallocate(len);
+  bytesRelayed_ += len;
+  if (writePending_) {
+    // One write in flight at a time; further bytes wait in buf_ and
+    // reads pause until the destination drains
+    if (!readPaused_) {
+      readPaused_ = true;
+      src_->setReadCB(nullptr);
+    }
+    return;
+  }
+  writePending_ = true;
+  dst_->writeChain(this, buf_.move());
+}
+
+void SocketTunnel::BufferRelay::readEOF() noexcept {
+  srcEof_ = true;
+  maybeFinish();
+}
+
+void SocketTunnel::BufferRelay::readErr(
+    const folly::AsyncSocketException& ex) noexcept {
+  VLOG(4) << "tunnel read error: " << folly::exceptionStr(ex);
+  tunnel_.closeWithError();
+}
+
+void SocketTunnel::BufferRelay::writeSuccess() noexcept {
+  writePending_ = false;
+  if (!buf_.empty()) {
+    writePending_ = true;
+    dst_->writeChain(this, buf_.move());
+    return;
+  }
+  if (readPaused_) {
+    readPaused_ = false;
+    src_->setReadCB(this);
+  }
+  maybeFinish();
+}
+
+void SocketTunnel::BufferRelay::writeErr(
+    size_t /*bytesWritten*/, const folly::AsyncSocketException& ex) noexcept {
+  VLOG(4) << "tunnel write error: " << folly::exceptionStr(ex);
+  tunnel_.closeWithError();
+}
+
+void SocketTunnel::BufferRelay::maybeFinish() {
+  if (srcEof_ && !writePending_ && buf_.empty() && !done_) {
+    done_ = true;
+    dst_->shutdownWrite();
+    // May delete the tunnel (and this relay); must be the last call
+    tunnel_.relayDone();
+  }
+}
+
+#ifdef __linux__
+
+bool SocketTunnel::tryStartSplice() {
+  auto* clientSock = client_->getUnderlyingTransport<folly::AsyncSocket>();
+  auto* serverSock = server_->getUnderlyingTransport<folly::AsyncSocket>();
+  // Only bare TCP sockets can collapse down to fds; any wrapper (TLS,
+  // compression filters) still needs to see the byte stream
+  if (!clientSock || !serverSock ||
+      static_cast<folly::AsyncTransport*>(clientSock) != client_.get() ||
+      static_cast<folly::AsyncTransport*>(serverSock) != server_.get() ||
+      !client_->getSecurityProtocol().empty() ||
+      !server_->getSecurityProtocol().empty() || !clientSock->isDetachable() ||
+      !serverSock->isDetachable()) {
+    return false;
+  }
+  int outPipe[2];
+  int backPipe[2];
+  if (::pipe2(outPipe, O_NONBLOCK | O_CLOEXEC) != 0) {
+    return false;
+  }
+  if (::pipe2(backPipe, O_NONBLOCK | O_CLOEXEC) != 0) {
+    ::close(outPipe[0]);
+    ::close(outPipe[1]);
+    return false;
+  }
+
+  auto* evb = clientSock->getEventBase();
+  clientSock->setReadCB(nullptr);
+  serverSock->setReadCB(nullptr);
+  int clientFd = clientSock->detachNetworkSocket().toFd();
+  int serverFd = serverSock->detachNetworkSocket().toFd();
+  client_.reset();
+  server_.reset();
+
+  spliceOut_ = SpliceDirection{clientFd,
+                               serverFd,
+                               {outPipe[0], outPipe[1]},
+                               0,
+                               false,
+                               false,
+                               &bytesClientToServer_};
+  spliceBack_ = SpliceDirection{serverFd,
+                                clientFd,
+                                {backPipe[0], backPipe[1]},
+                                0,
+                                false,
+                                false,
+                                &bytesServerToClient_};
+  clientHandler_ = std::make_unique<SpliceHandler>(*this, evb, clientFd);
+  serverHandler_ = std::make_unique<SpliceHandler>(*this, evb, serverFd);
+  VLOG(4) << "starting spliced tunnel, client fd=" << clientFd
+          << " server fd=" << serverFd;
+
+  // Prime both directions; the socket buffers may already hold bytes
+  if (pumpSplice(spliceOut_) && pumpSplice(spliceBack_)) {
+    updateSpliceHandlers();
+  }
+  return true;
+}
+
+void SocketTunnel::spliceReady(int fd, uint16_t /*events*/) noexcept {
+  // Readiness on an fd can unblock either direction it participates in
+  if ((spliceOut_.srcFd == fd || spliceOut_.dstFd == fd) &&
+      !pumpSplice(spliceOut_)) {
+    return;
+  }
+  if ((spliceBack_.srcFd == fd || spliceBack_.dstFd == fd) &&
+      !pumpSplice(spliceBack_)) {
+    return;
+  }
+  updateSpliceHandlers();
+}
+
+bool SocketTunnel::pumpSplice(SpliceDirection& dir) {
+  if (dir.done) {
+    return true;
+  }
+  for (;;) {
+    bool srcBlocked = false;
+    if (!dir.srcEof && dir.bytesInPipe < kMaxPipeBytes) {
+      auto n = ::splice(dir.srcFd,
+                        nullptr,
+                        dir.pipeFds[1],
+                        nullptr,
+                        kMaxPipeBytes - dir.bytesInPipe,
+                        SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+      if (n > 0) {
+        dir.bytesInPipe += n;
+      } else if (n == 0) {
+        dir.srcEof = true;
+      } else if (errno == EAGAIN) {
+        srcBlocked = true;
+      } else {
+        PLOG(ERROR) << "tunnel splice read failed, fd=" << dir.srcFd;
+        closeWithError();
+        return false;
+      }
+    }
+    while (dir.bytesInPipe > 0) {
+      auto n = ::splice(dir.pipeFds[0],
+                        nullptr,
+                        dir.dstFd,
+                        nullptr,
+                        dir.bytesInPipe,
+                        SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+      if (n > 0) {
+        dir.bytesInPipe -= n;
+        *dir.bytesRelayed += n;
+      } else if (n < 0 && errno == EAGAIN) {
+        // Destination full; wait for WRITE readiness
+        break;
+      } else {
+        PLOG(ERROR) << "tunnel splice write failed, fd=" << dir.dstFd;
+        closeWithError();
+        return false;
+      }
+    }
+    if (dir.bytesInPipe > 0) {
+      return true;
+    }
+    if (dir.srcEof) {
+      ::shutdown(dir.dstFd, SHUT_WR);
+      dir.done = true;
+      return true;
+    }
+    if (srcBlocked) {
+      return true;
+    }
+  }
+}
+
+void SocketTunnel::updateSpliceHandlers() {
+  if (spliceOut_.done && spliceBack_.done) {
+    finish();
+    return;
+  }
+  auto eventsFor = [this](int fd) {
+    uint16_t events = 0;
+    for (auto* dir : {&spliceOut_, &spliceBack_}) {
+      if (dir->done) {
+        continue;
+      }
+      // Reads pause while the pipe is backed up; that is the only
+      // backpressure this relay needs
+      if (dir->srcFd == fd && !dir->srcEof && dir->bytesInPipe == 0) {
+        events |= folly::EventHandler::READ;
+      }
+      if (dir->dstFd == fd && dir->bytesInPipe > 0) {
+        events |= folly::EventHandler::WRITE;
+      }
+    }
+    return events;
+  };
+  for (auto& entry :
+       {std::make_pair(clientHandler_.get(), spliceOut_.srcFd),
+        std::make_pair(serverHandler_.get(), spliceOut_.dstFd)}) {
+    auto events = eventsFor(entry.second);
+    if (events != 0) {
+      entry.first->registerHandler(events | folly::EventHandler::PERSIST);
+    } else {
+      entry.first->unregisterHandler();
+    }
+  }
+}
+
+#endif // __linux__
+
+} // namespace proxygen
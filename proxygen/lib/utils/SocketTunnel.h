@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <folly/Function.h>
+#include <folly/io/IOBufQueue.h>
+#include <folly/io/async/AsyncSocket.h>
+#include <folly/io/async/AsyncTransport.h>
+#include <folly/io/async/EventHandler.h>
+
+namespace proxygen {
+
+/**
+ * A raw bidirectional byte relay between two transports, used once a
+ * CONNECT or protocol upgrade has turned an HTTP connection into an
+ * opaque tunnel and the codec has nothing left to do (see
+ * HTTPTransaction::Transport::extractTunnelTransport()).
+ *
+ * The tunnel owns both transports, relays until either side closes or
+ * errors, then invokes the stats callback with the byte counts for each
+ * direction and frees itself.  On Linux, when both ends are plaintext
+ * AsyncSockets, it detaches their fds and moves bytes with splice(2)
+ * through a kernel pipe per direction so tunneled payload never crosses
+ * into userspace; otherwise it falls back to an IOBuf pass-through.
+ * Byte accounting is identical in both modes.
+ *
+ * Must be started, and runs entirely, on the transports' EventBase.
+ */
+class SocketTunnel {
+ public:
+  /**
+   * Invoked once when the tunnel closes, with (bytesClientToServer,
+   * bytesServerToClient).  May be empty.
+   */
+  using StatsCallback = folly::Function<void(uint64_t, uint64_t)>;
+
+  /**
+   * Take ownership of both transports and start relaying.  Both must be
+   * attached to the same EventBase.  The tunnel manages its own
+   * lifetime from here on.
+   */
+  static void start(folly::AsyncTransport::UniquePtr client,
+                    folly::AsyncTransport::UniquePtr server,
+                    StatsCallback statsCallback = nullptr);
+
+ private:
+  SocketTunnel(folly::AsyncTransport::UniquePtr client,
+               folly::AsyncTransport::UniquePtr server,
+               StatsCallback statsCallback);
+  ~SocketTunnel();
+
+  /**
+   * One direction of the IOBuf pass-through relay.  Reads from src,
+   * writes to dst, keeping at most one write in flight; reads are
+   * paused while a write is pending so the buffer stays bounded.
+   */
+  class BufferRelay
+      : public folly::AsyncReader::ReadCallback
+      , public folly::AsyncWriter::WriteCallback {
+   public:
+    BufferRelay(SocketTunnel& tunnel,
+                folly::AsyncTransport* src,
+                folly::AsyncTransport* dst,
+                uint64_t& bytesRelayed)
+        : tunnel_(tunnel), src_(src), dst_(dst), bytesRelayed_(bytesRelayed) {
+    }
+
+    void startRelay() {
+      src_->setReadCB(this);
+    }
+
+    bool done() const {
+      return done_;
+    }
+
+    // AsyncReader::ReadCallback
+    void getReadBuffer(void** bufReturn, size_t* lenReturn) override;
+    void readDataAvailable(size_t len) noexcept override;
+    void readEOF() noexcept override;
+    void readErr(const folly::AsyncSocketException& ex) noexcept override;
+
+    // AsyncWriter::WriteCallback
+    void writeSuccess() noexcept override;
+    void writeErr(size_t bytesWritten,
+                  const folly::AsyncSocketException& ex) noexcept override;
+
+   private:
+    void maybeFinish();
+
+    SocketTunnel& tunnel_;
+    folly::AsyncTransport* src_;
+    folly::AsyncTransport* dst_;
+    uint64_t& bytesRelayed_;
+    folly::IOBufQueue buf_{folly::IOBufQueue::cacheChainLength()};
+    bool writePending_{false};
+    bool readPaused_{false};
+    bool srcEof_{false};
+    bool done_{false};
+  };
+
+#ifdef __linux__
+  /**
+   * One direction of the splice relay: srcFd -> pipe -> dstFd.  The
+   * parent owns the fds; each direction owns its pipe.
+   */
+  struct SpliceDirection {
+    int srcFd{-1};
+    int dstFd{-1};
+    int pipeFds[2]{-1, -1};
+    size_t bytesInPipe{0};
+    bool srcEof{false};
+    bool done{false};
+    uint64_t* bytesRelayed{nullptr};
+  };
+
+  /**
+   * Watches one fd; READ readiness pumps the direction where the fd is
+   * the source, WRITE readiness the one where it is the destination.
+   */
+  class SpliceHandler : public folly::EventHandler {
+   public:
+    SpliceHandler(SocketTunnel& tunnel, folly::EventBase* evb, int fd)
+        : folly::EventHandler(evb, folly::NetworkSocket::fromFd(fd)),
+          tunnel_(tunnel),
+          fd_(fd) {
+    }
+
+    void handlerReady(uint16_t events) noexcept override {
+      tunnel_.spliceReady(fd_, events);
+    }
+
+   private:
+    SocketTunnel& tunnel_;
+    int fd_;
+  };
+
+  // Returns true if both transports were plaintext sockets whose fds
+  // could be detached; on false the caller falls back to BufferRelays.
+  bool tryStartSplice();
+  void spliceReady(int fd, uint16_t events) noexcept;
+  // Returns false on a fatal splice error (the tunnel is torn down).
+  bool pumpSplice(SpliceDirection& dir);
+  void updateSpliceHandlers();
+#endif
+
+  void startBufferRelays();
+  // Called by a BufferRelay when its direction has fully drained.
+  void relayDone();
+  void closeWithError();
+  void finish();
+
+  folly::AsyncTransport::UniquePtr client_;
+  folly::AsyncTransport::UniquePtr server_;
+  StatsCallback statsCallback_;
+
+  uint64_t bytesClientToServer_{0};
+  uint64_t bytesServerToClient_{0};
+  bool closing_{false};
+
+  std::unique_ptr<BufferRelay> clientToServer_;
+  std::unique_ptr<BufferRelay> serverToClient_;
+
+#ifdef __linux__
+  SpliceDirection spliceOut_;   // client -> server
+  SpliceDirection spliceBack_;  // server -> client
+  std::unique_ptr<SpliceHandler> clientHandler_;
+  std::unique_ptr<SpliceHandler> serverHandler_;
+#endif
+};
+
+} // namespace proxygen
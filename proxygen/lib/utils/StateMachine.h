@@ -8,7 +8,10 @@
 
 #pragma once
 
+#include <array>
+#include <folly/Likely.h>
 #include <glog/logging.h>
+#include <initializer_list>
 #include <limits>
 #include <tuple>
 
@@ -29,7 +32,7 @@ class StateMachine {
     State newState;
 
     std::tie(newState, ok) = T::find(state, event);
-    if (!ok) {
+    if (FOLLY_UNLIKELY(!ok)) {
       LOG(ERROR) << T::getName() << ": invalid transition tried: " << state
                  << " " << event;
       return false;
@@ -41,6 +44,20 @@ class StateMachine {
     }
   }
 
+  /**
+   * Combined canTransit+transit: one table access, no diagnostics on
+   * failure.  For per-event hot paths (e.g. body chunk loops) where the
+   * caller reports invalid transitions itself.
+   */
+  static bool tryTransit(State& state, Event event) {
+    auto result = T::find(state, event);
+    if (FOLLY_LIKELY(result.second)) {
+      state = result.first;
+      return true;
+    }
+    return false;
+  }
+
   static bool canTransit(const State state, Event event) {
     bool ok;
 
@@ -107,4 +124,49 @@ class TransitionTable {
   }
 };
 
+/**
+ * Dense, constexpr-constructible counterpart of TransitionTable for
+ * state machines whose dimensions are known at compile time.  The
+ * matrix is built at compile time and lives in read-only data, and
+ * find() is a single indexed load that inlines into per-event call
+ * sites instead of going through an out-of-line lookup.
+ */
+template <class State, class Event, std::size_t NStates, std::size_t NEvents>
+class DenseTransitionTable {
+ public:
+  constexpr DenseTransitionTable(
+      std::initializer_list<std::pair<std::pair<State, Event>, State>>
+          transitions)
+      : transitions_{} {
+    for (auto& row : transitions_) {
+      for (auto& cell : row) {
+        cell = kInvalid;
+      }
+    }
+    for (const auto& t : transitions) {
+      transitions_[static_cast<std::size_t>(t.first.first)]
+                  [static_cast<std::size_t>(t.first.second)] =
+                      static_cast<uint8_t>(t.second);
+    }
+  }
+
+  std::pair<State, bool> find(State s, Event e) const {
+    DCHECK_LT(static_cast<std::size_t>(s), NStates);
+    DCHECK_LT(static_cast<std::size_t>(e), NEvents);
+    uint8_t result =
+        transitions_[static_cast<std::size_t>(s)][static_cast<std::size_t>(e)];
+    if (FOLLY_UNLIKELY(result == kInvalid)) {
+      return std::make_pair(s, false);
+    }
+    return std::make_pair(State(result), true);
+  }
+
+ private:
+  static_assert(NStates < std::numeric_limits<uint8_t>::max(),
+                "state index must fit in a byte");
+  static constexpr uint8_t kInvalid = std::numeric_limits<uint8_t>::max();
+
+  std::array<std::array<uint8_t, NEvents>, NStates> transitions_;
+};
+
 } // namespace proxygen
@@ -27,5 +27,10 @@ class StreamDecompressor {
   virtual std::unique_ptr<folly::IOBuf> decompress(const folly::IOBuf* in) = 0;
   virtual bool hasError() = 0;
   virtual bool finished() = 0;
+  /**
+   * Return the decompressor to its initial state so the instance can be
+   * pooled and reused for a new stream.
+   */
+  virtual void reset() = 0;
 };
 } // namespace proxygen
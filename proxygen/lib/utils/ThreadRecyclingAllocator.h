@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <folly/SingletonThreadLocal.h>
+
+namespace proxygen {
+
+/**
+ * Minimal std-compatible allocator that recycles single-object allocations
+ * through a small thread-local free list, so objects that are created and
+ * destroyed at high rates on the same event base thread (transactions, stream
+ * transports) don't round-trip through malloc.
+ *
+ * Only n == 1 allocations are cached, keyed by the instantiating type; array
+ * allocations (container chunk/bucket storage via rebound copies) pass
+ * straight through to operator new/delete.  The free list is capped at
+ * CacheSize entries per thread and releases its blocks at thread exit.
+ */
+template <typename T, size_t CacheSize = 64>
+class ThreadRecyclingAllocator {
+ public:
+  using value_type = T;
+
+  ThreadRecyclingAllocator() = default;
+
+  template <typename U>
+  /* implicit */ ThreadRecyclingAllocator(
+      const ThreadRecyclingAllocator<U, CacheSize>&) noexcept {
+  }
+
+  template <typename U>
+  struct rebind {
+    using other = ThreadRecyclingAllocator<U, CacheSize>;
+  };
+
+  T* allocate(std::size_t n) {
+    if (n == 1) {
+      auto& cache = getCache();
+      if (cache.size > 0) {
+        return static_cast<T*>(cache.blocks[--cache.size]);
+      }
+    }
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, std::size_t n) noexcept {
+    if (n == 1) {
+      auto& cache = getCache();
+      if (cache.size < CacheSize) {
+        cache.blocks[cache.size++] = p;
+        return;
+      }
+    }
+    ::operator delete(p);
+  }
+
+  friend bool operator==(const ThreadRecyclingAllocator&,
+                         const ThreadRecyclingAllocator&) noexcept {
+    return true;
+  }
+
+  friend bool operator!=(const ThreadRecyclingAllocator&,
+                         const ThreadRecyclingAllocator&) noexcept {
+    return false;
+  }
+
+ private:
+  struct Cache {
+    std::array<void*, CacheSize> blocks;
+    std::size_t size{0};
+
+    ~Cache() {
+      while (size > 0) {
+        ::operator delete(blocks[--size]);
+      }
+    }
+  };
+
+  static Cache& getCache() {
+    struct CacheTag {};
+    return folly::SingletonThreadLocal<Cache, CacheTag>::get();
+  }
+};
+
+} // namespace proxygen
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/utils/TokenBucketRateLimiter.h>
+
+#include <algorithm>
+#include <glog/logging.h>
+
+using std::chrono::milliseconds;
+
+namespace {
+
+class RealClock : public proxygen::TokenBucketRateLimiter::Clock {
+ public:
+  proxygen::TimePoint now() override {
+    return proxygen::getCurrentTime();
+  }
+};
+
+proxygen::TokenBucketRateLimiter::Clock& getRealClock() {
+  static RealClock clock;
+  return clock;
+}
+
+} // namespace
+
+namespace proxygen {
+
+TokenBucketRateLimiter::Bucket::Bucket(TokenBucketRateLimiter& limiter,
+                                       Bucket* parent,
+                                       uint64_t bytesPerSecond,
+                                       uint64_t burstBytes)
+    : limiter_(limiter),
+      parent_(parent),
+      rate_(bytesPerSecond),
+      burst_(burstBytes),
+      tokens_(double(burstBytes)),
+      lastRefill_(limiter.now()) {
+}
+
+TokenBucketRateLimiter::Bucket::~Bucket() {
+  limiter_.buckets_.erase(listHook_);
+  // Drop any waits parked on this bucket; their transactions are gone or
+  // going with it
+  auto it = limiter_.waiters_.begin();
+  while (it != limiter_.waiters_.end()) {
+    if (it->leaf == this) {
+      it = limiter_.waiters_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void TokenBucketRateLimiter::Bucket::setRate(uint64_t bytesPerSecond,
+                                             uint64_t burstBytes) {
+  refill(limiter_.now());
+  rate_ = bytesPerSecond;
+  burst_ = burstBytes;
+  tokens_ = std::min(tokens_, double(burst_));
+}
+
+uint64_t TokenBucketRateLimiter::Bucket::getTokens() {
+  refill(limiter_.now());
+  return uint64_t(tokens_);
+}
+
+void TokenBucketRateLimiter::Bucket::refill(TimePoint now) {
+  if (unlimited()) {
+    lastRefill_ = now;
+    return;
+  }
+  auto elapsed = millisecondsBetween(now, lastRefill_);
+  if (elapsed.count() <= 0) {
+    return;
+  }
+  tokens_ = std::min(double(burst_),
+                     tokens_ + double(rate_) * elapsed.count() / 1000.0);
+  lastRefill_ = now;
+}
+
+TokenBucketRateLimiter::TokenBucketRateLimiter(
+    folly::TimeoutManager* timeoutManager,
+    milliseconds tickInterval,
+    Clock* clock)
+    : folly::AsyncTimeout(timeoutManager),
+      clock_(clock ? clock : &getRealClock()),
+      tickInterval_(tickInterval) {
+}
+
+TokenBucketRateLimiter::~TokenBucketRateLimiter() {
+  CHECK(buckets_.empty()) << "destroyed with buckets still alive";
+}
+
+std::unique_ptr<TokenBucketRateLimiter::Bucket>
+TokenBucketRateLimiter::makeBucket(Bucket* parent,
+                                   uint64_t bytesPerSecond,
+                                   uint64_t burstBytes) {
+  std::unique_ptr<Bucket> bucket(
+      new Bucket(*this, parent, bytesPerSecond, burstBytes));
+  buckets_.push_front(bucket.get());
+  bucket->listHook_ = buckets_.begin();
+  return bucket;
+}
+
+bool TokenBucketRateLimiter::tryConsume(Bucket& leaf, uint64_t bytes) {
+  auto timestamp = now();
+  for (Bucket* bucket = &leaf; bucket != nullptr; bucket = bucket->parent_) {
+    bucket->refill(timestamp);
+    if (!bucket->unlimited() && bucket->tokens_ < double(bytes)) {
+      ++bucket->deniedCount_;
+      return false;
+    }
+  }
+  for (Bucket* bucket = &leaf; bucket != nullptr; bucket = bucket->parent_) {
+    if (!bucket->unlimited()) {
+      bucket->tokens_ -= double(bytes);
+    }
+    bucket->bytesConsumed_ += bytes;
+  }
+  return true;
+}
+
+bool TokenBucketRateLimiter::canConsume(Bucket& leaf,
+                                        uint64_t bytes,
+                                        TimePoint timestamp) {
+  for (Bucket* bucket = &leaf; bucket != nullptr; bucket = bucket->parent_) {
+    bucket->refill(timestamp);
+    if (!bucket->unlimited() && bucket->tokens_ < double(bytes)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void TokenBucketRateLimiter::waitForTokens(Bucket& leaf,
+                                           uint64_t bytes,
+                                           Callback* callback) {
+  waiters_.push_back(Waiter{&leaf, bytes, callback});
+  if (!isScheduled()) {
+    scheduleTimeout(tickInterval_.count());
+  }
+}
+
+void TokenBucketRateLimiter::cancelWait(Callback* callback) {
+  auto it = waiters_.begin();
+  while (it != waiters_.end()) {
+    if (it->callback == callback) {
+      it = waiters_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void TokenBucketRateLimiter::timeoutExpired() noexcept {
+  // FIFO sweep.  A fired callback typically consumes inline, which is
+  // naturally reflected in the canConsume checks of later waiters.
+  auto it = waiters_.begin();
+  while (it != waiters_.end()) {
+    if (canConsume(*it->leaf, it->bytes, now())) {
+      auto callback = it->callback;
+      it = waiters_.erase(it);
+      callback->tokensAvailable();
+    } else {
+      ++it;
+    }
+  }
+  if (!waiters_.empty()) {
+    scheduleTimeout(tickInterval_.count());
+  }
+}
+
+TimePoint TokenBucketRateLimiter::now() {
+  return clock_->now();
+}
+
+} // namespace proxygen
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <folly/io/async/AsyncTimeout.h>
+#include <folly/io/async/TimeoutManager.h>
+#include <list>
+#include <memory>
+#include <proxygen/lib/utils/Time.h>
+
+namespace proxygen {
+
+/**
+ * Hierarchical token bucket rate limiter for egress pacing.
+ *
+ * Buckets form a tree (typically transaction -> session -> listener);
+ * consuming bytes through a leaf requires tokens at every level, so a
+ * per-transaction cap, a per-session cap and a per-listener aggregate
+ * cap are all enforced with one call.  Each bucket refills lazily from
+ * its own timestamp, so steady-state consumption costs no timers at all.
+ * Callers that get denied can register for a wakeup; all wakeups across
+ * the limiter are served from one shared timer tick, instead of one
+ * timer per blocked transaction.
+ *
+ * Rates are in bytes per second; the burst is the bucket capacity, i.e.
+ * how many bytes may be sent back-to-back after an idle period.  A rate
+ * of 0 means unlimited: the bucket never constrains its subtree, which
+ * lets a level of the hierarchy be present but inert.
+ *
+ * Single-threaded: one limiter per worker, used only on its
+ * TimeoutManager's thread.  Parent buckets must outlive their children,
+ * and all buckets must be released before the limiter is destroyed.
+ */
+class TokenBucketRateLimiter : private folly::AsyncTimeout {
+ public:
+  /**
+   * Clock interface, injectable for tests (same shape as
+   * AsyncTimeoutSet::TimeoutClock).
+   */
+  class Clock {
+   public:
+    virtual ~Clock() {
+    }
+    virtual TimePoint now() = 0;
+  };
+
+  /**
+   * Notified (once per wait) when a previously denied consume is worth
+   * retrying.  The callback re-attempts tryConsume itself; tokens are
+   * not reserved on its behalf.
+   */
+  class Callback {
+   public:
+    virtual ~Callback() {
+    }
+    virtual void tokensAvailable() noexcept = 0;
+  };
+
+  class Bucket {
+   public:
+    ~Bucket();
+
+    /**
+     * Change the refill rate and capacity.  Accumulated tokens are
+     * clamped to the new burst.
+     */
+    void setRate(uint64_t bytesPerSecond, uint64_t burstBytes);
+
+    uint64_t getRate() const {
+      return rate_;
+    }
+    uint64_t getBurst() const {
+      return burst_;
+    }
+
+    /**
+     * Tokens currently available at this bucket alone, after refill.
+     */
+    uint64_t getTokens();
+
+    // Stats, cumulative since creation
+    uint64_t getBytesConsumed() const {
+      return bytesConsumed_;
+    }
+    uint64_t getDeniedCount() const {
+      return deniedCount_;
+    }
+
+   private:
+    friend class TokenBucketRateLimiter;
+
+    Bucket(TokenBucketRateLimiter& limiter,
+           Bucket* parent,
+           uint64_t bytesPerSecond,
+           uint64_t burstBytes);
+
+    bool unlimited() const {
+      return rate_ == 0;
+    }
+    void refill(TimePoint now);
+
+    TokenBucketRateLimiter& limiter_;
+    Bucket* const parent_;
+    uint64_t rate_;
+    uint64_t burst_;
+    double tokens_;
+    TimePoint lastRefill_;
+    uint64_t bytesConsumed_{0};
+    uint64_t deniedCount_{0};
+    std::list<Bucket*>::iterator listHook_;
+  };
+
+  /**
+   * @param timeoutManager Event base driving the shared wakeup tick.
+   * @param tickInterval   Granularity of waiter wakeups.
+   * @param clock          Optional clock override for tests.
+   */
+  explicit TokenBucketRateLimiter(
+      folly::TimeoutManager* timeoutManager,
+      std::chrono::milliseconds tickInterval = std::chrono::milliseconds(10),
+      Clock* clock = nullptr);
+
+  ~TokenBucketRateLimiter() override;
+
+  /**
+   * Create a bucket under the given parent (nullptr for a root).  The
+   * returned bucket must not outlive its parent or the limiter.
+   */
+  std::unique_ptr<Bucket> makeBucket(Bucket* parent,
+                                     uint64_t bytesPerSecond,
+                                     uint64_t burstBytes);
+
+  /**
+   * All-or-nothing: take bytes from the leaf and every ancestor, or from
+   * none of them.  Returns false (recording a denial on the first level
+   * that lacked tokens) when any level cannot cover the request.
+   */
+  bool tryConsume(Bucket& leaf, uint64_t bytes);
+
+  /**
+   * Ask to be woken when a tryConsume(leaf, bytes) is likely to succeed.
+   * Waiters are checked in FIFO order on the shared tick; the callback
+   * fires at most once per wait and must be re-armed for further waits.
+   */
+  void waitForTokens(Bucket& leaf, uint64_t bytes, Callback* callback);
+
+  /**
+   * Remove a pending wait, e.g. when the transaction dies first.
+   */
+  void cancelWait(Callback* callback);
+
+  size_t getNumBuckets() const {
+    return buckets_.size();
+  }
+  size_t getNumWaiters() const {
+    return waiters_.size();
+  }
+
+ private:
+  struct Waiter {
+    Bucket* leaf;
+    uint64_t bytes;
+    Callback* callback;
+  };
+
+  void timeoutExpired() noexcept override;
+  // True if the leaf and all ancestors can cover bytes, without taking any
+  bool canConsume(Bucket& leaf, uint64_t bytes, TimePoint now);
+  TimePoint now();
+
+  Clock* const clock_;
+  const std::chrono::milliseconds tickInterval_;
+  std::list<Bucket*> buckets_;
+  std::list<Waiter> waiters_;
+};
+
+} // namespace proxygen
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/utils/TraceEventRingBuffer.h>
+
+#include <folly/FileUtil.h>
+#include <folly/portability/Fcntl.h>
+
+#include <cstring>
+
+namespace {
+
+uint64_t toNs(proxygen::TimePoint tp) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             tp.time_since_epoch())
+      .count();
+}
+
+size_t roundUpToPowerOfTwo(size_t n) {
+  size_t result = 2;
+  while (result < n) {
+    result <<= 1;
+  }
+  return result;
+}
+
+} // namespace
+
+namespace proxygen {
+
+TraceEventRingBuffer::TraceEventRingBuffer(size_t capacity)
+    : records_(roundUpToPowerOfTwo(capacity)),
+      mask_(records_.size() - 1) {
+}
+
+bool TraceEventRingBuffer::tryWrite(const TraceEvent& event) {
+  const auto head = head_.load(std::memory_order_relaxed);
+  const auto tail = tail_.load(std::memory_order_acquire);
+  if (head - tail > mask_) {
+    return false;
+  }
+  auto& record = records_[head & mask_];
+  record.type = static_cast<uint32_t>(event.getType());
+  record.id = event.getID();
+  record.parentID = event.getParentID();
+  record.startNs = event.hasStarted() ? toNs(event.getStartTime()) : 0;
+  record.endNs = event.hasEnded() ? toNs(event.getEndTime()) : 0;
+  record.fieldCount = 0;
+  for (auto itr = event.getMetaDataItr();
+       itr.isValid() &&
+       record.fieldCount < TraceEventBinaryRecord::kMaxFields;
+       itr.next()) {
+    if (itr.type() != typeid(int64_t)) {
+      continue;
+    }
+    record.fieldTypes[record.fieldCount] =
+        static_cast<uint32_t>(itr.getKey());
+    record.fieldValues[record.fieldCount] = itr.getValueAs<int64_t>();
+    record.fieldCount++;
+  }
+  head_.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+size_t TraceEventRingBuffer::drainTo(
+    std::vector<TraceEventBinaryRecord>& out) {
+  auto tail = tail_.load(std::memory_order_relaxed);
+  const auto head = head_.load(std::memory_order_acquire);
+  size_t drained = 0;
+  while (tail != head) {
+    out.push_back(records_[tail & mask_]);
+    tail++;
+    drained++;
+  }
+  tail_.store(tail, std::memory_order_release);
+  return drained;
+}
+
+TraceEventRingBufferWriter::TraceEventRingBufferWriter(
+    const std::string& path,
+    size_t perThreadCapacity,
+    std::chrono::milliseconds spillInterval)
+    : perThreadCapacity_(perThreadCapacity),
+      spillInterval_(spillInterval),
+      file_(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC) {
+  TraceEventLogHeader header{TraceEventLogHeader::kMagic,
+                             TraceEventLogHeader::kVersion,
+                             sizeof(TraceEventBinaryRecord)};
+  PCHECK(folly::writeFull(file_.fd(), &header, sizeof(header)) ==
+         sizeof(header));
+  spillThread_ = std::thread([this] { spillLoop(); });
+}
+
+TraceEventRingBufferWriter::~TraceEventRingBufferWriter() {
+  {
+    std::lock_guard<std::mutex> g(stopMutex_);
+    stop_ = true;
+  }
+  stopCondition_.notify_one();
+  spillThread_.join();
+  // The spill thread performs a final drain before exiting, so anything
+  // recorded before this destructor ran is on disk.
+}
+
+TraceEventRingBuffer& TraceEventRingBufferWriter::threadLocalRing() {
+  auto& cached = *ring_;
+  if (!cached) {
+    auto ring = std::make_unique<TraceEventRingBuffer>(perThreadCapacity_);
+    cached = ring.get();
+    std::lock_guard<std::mutex> g(ringsMutex_);
+    rings_.push_back(std::move(ring));
+  }
+  return *cached;
+}
+
+void TraceEventRingBufferWriter::record(const TraceEvent& event) {
+  if (!threadLocalRing().tryWrite(event)) {
+    droppedEvents_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void TraceEventRingBufferWriter::spillLoop() {
+  std::unique_lock<std::mutex> lock(stopMutex_);
+  while (!stop_) {
+    stopCondition_.wait_for(lock, spillInterval_);
+    lock.unlock();
+    drainAllRings();
+    lock.lock();
+  }
+  lock.unlock();
+  drainAllRings();
+}
+
+void TraceEventRingBufferWriter::drainAllRings() {
+  std::vector<TraceEventRingBuffer*> rings;
+  {
+    std::lock_guard<std::mutex> g(ringsMutex_);
+    rings.reserve(rings_.size());
+    for (auto& ring : rings_) {
+      rings.push_back(ring.get());
+    }
+  }
+  std::vector<TraceEventBinaryRecord> spill;
+  for (auto* ring : rings) {
+    ring->drainTo(spill);
+  }
+  if (!spill.empty()) {
+    const size_t bytes = spill.size() * sizeof(TraceEventBinaryRecord);
+    PCHECK(folly::writeFull(file_.fd(), spill.data(), bytes) ==
+           ssize_t(bytes));
+  }
+}
+
+std::vector<TraceEventBinaryRecord> TraceEventRingBufferWriter::decodeFile(
+    const std::string& path) {
+  std::string contents;
+  if (!folly::readFile(path.c_str(), contents)) {
+    folly::throw_exception<Exception>(
+        folly::to<std::string>("cannot read trace log: ", path));
+  }
+  if (contents.size() < sizeof(TraceEventLogHeader)) {
+    folly::throw_exception<Exception>("truncated trace log header");
+  }
+  TraceEventLogHeader header;
+  memcpy(&header, contents.data(), sizeof(header));
+  if (header.magic != TraceEventLogHeader::kMagic ||
+      header.version != TraceEventLogHeader::kVersion ||
+      header.recordSize != sizeof(TraceEventBinaryRecord)) {
+    folly::throw_exception<Exception>("bad trace log header");
+  }
+  const size_t payload = contents.size() - sizeof(header);
+  if (payload % sizeof(TraceEventBinaryRecord) != 0) {
+    folly::throw_exception<Exception>("truncated trace log record");
+  }
+  std::vector<TraceEventBinaryRecord> records(payload /
+                                              sizeof(TraceEventBinaryRecord));
+  memcpy(records.data(), contents.data() + sizeof(header), payload);
+  return records;
+}
+
+} // namespace proxygen
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <proxygen/lib/utils/TraceEvent.h>
+
+#include <folly/File.h>
+#include <folly/ThreadLocal.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace proxygen {
+
+/**
+ * Fixed-size binary form of a TraceEvent, cheap enough to record on the
+ * hot path.  Only integral metadata fields are kept (up to kMaxFields,
+ * in map order); string and string-list fields are dropped, since they
+ * are what makes the std::string-based TraceEvent too expensive to leave
+ * enabled in production.
+ */
+struct TraceEventBinaryRecord {
+  static constexpr size_t kMaxFields = 4;
+
+  uint32_t type;       // TraceEventType
+  uint32_t id;
+  uint32_t parentID;
+  uint32_t fieldCount;
+  uint64_t startNs;    // steady-clock time since epoch, nanoseconds
+  uint64_t endNs;
+  uint32_t fieldTypes[kMaxFields];  // TraceFieldType
+  int64_t fieldValues[kMaxFields];
+};
+
+/**
+ * Single-producer single-consumer ring of binary trace records.  The
+ * producer is the owning thread calling tryWrite(); the consumer is the
+ * spill thread calling drainTo().  Both sides are lock-free.
+ */
+class TraceEventRingBuffer {
+ public:
+  // Capacity is rounded up to a power of two, minimum 2.
+  explicit TraceEventRingBuffer(size_t capacity);
+
+  // Producer thread only.  Returns false (event dropped) when full.
+  bool tryWrite(const TraceEvent& event);
+
+  // Consumer thread only.  Appends drained records to 'out' and returns
+  // how many were drained.
+  size_t drainTo(std::vector<TraceEventBinaryRecord>& out);
+
+ private:
+  std::vector<TraceEventBinaryRecord> records_;
+  size_t mask_;
+  std::atomic<uint64_t> head_{0};  // next slot to write
+  std::atomic<uint64_t> tail_{0};  // next slot to read
+};
+
+/**
+ * Always-on tracing backend.  record() converts a TraceEvent to a
+ * fixed-size binary record and pushes it into a per-thread lock-free
+ * ring; a background thread periodically drains every ring and appends
+ * the records to a binary log file.  When a ring is full the event is
+ * dropped and counted rather than blocking the recording thread.
+ *
+ * The log starts with a TraceEventLogHeader and is decoded offline with
+ * decodeFile().
+ */
+class TraceEventRingBufferWriter {
+ public:
+  struct TraceEventLogHeader {
+    static constexpr uint64_t kMagic = 0x70786e7472636c67ULL;  // "pxntrclg"
+    static constexpr uint32_t kVersion = 1;
+
+    uint64_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+  };
+
+  TraceEventRingBufferWriter(
+      const std::string& path,
+      size_t perThreadCapacity = 4096,
+      std::chrono::milliseconds spillInterval = std::chrono::milliseconds(
+          100));
+
+  // Stops the spill thread after a final drain of all rings.
+  ~TraceEventRingBufferWriter();
+
+  // Callable from any thread; never blocks.
+  void record(const TraceEvent& event);
+
+  uint64_t getDroppedCount() const {
+    return droppedEvents_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Offline decoder: reads a log produced by this writer and returns the
+   * records, throwing proxygen::Exception on a malformed file.
+   */
+  static std::vector<TraceEventBinaryRecord> decodeFile(
+      const std::string& path);
+
+ private:
+  TraceEventRingBuffer& threadLocalRing();
+  void spillLoop();
+  void drainAllRings();
+
+  const size_t perThreadCapacity_;
+  const std::chrono::milliseconds spillInterval_;
+  folly::File file_;
+
+  folly::ThreadLocal<TraceEventRingBuffer*> ring_;
+  std::mutex ringsMutex_;  // guards rings_ registration
+  std::vector<std::unique_ptr<TraceEventRingBuffer>> rings_;
+
+  std::atomic<uint64_t> droppedEvents_{0};
+
+  std::mutex stopMutex_;
+  std::condition_variable stopCondition_;
+  bool stop_{false};
+  std::thread spillThread_;
+};
+
+} // namespace proxygen
@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <folly/tracing/StaticTracepoint.h>
+
+/**
+ * USDT probe points for continuous profilers (bpftrace, perf, etc),
+ * published under the "proxygen" provider.  An untraced probe compiles
+ * to a single nop plus an ELF note, so these are on in every build and
+ * cost nothing until a tracer attaches; do not guard them behind build
+ * flags.
+ *
+ * Naming convention: <layer>_<edge>, e.g. session_accept, txn_create,
+ * codec_ingress.  Arguments must be scalars or pointers; pass object
+ * pointers so tracers can correlate edges belonging to one session or
+ * transaction.
+ *
+ * List probes in a built binary with:
+ *   readelf -n binary | grep proxygen
+ */
+#define PROXYGEN_SDT(name, ...) FOLLY_SDT(proxygen, name, ##__VA_ARGS__)
@@ -37,13 +37,15 @@ WheelTimerInstance::WheelTimerInstance(
 
 WheelTimerInstance::WheelTimerInstance(const WheelTimerInstance& timerInstance)
     : wheelTimerPtr_(timerInstance.wheelTimerPtr_),
-      defaultTimeoutMS_(timerInstance.defaultTimeoutMS_) {
+      defaultTimeoutMS_(timerInstance.defaultTimeoutMS_),
+      timeoutQuantum_(timerInstance.timeoutQuantum_) {
 }
 
 WheelTimerInstance::WheelTimerInstance(
     WheelTimerInstance&& timerInstance) noexcept
     : wheelTimerPtr_(std::move(timerInstance.wheelTimerPtr_)),
-      defaultTimeoutMS_(std::move(timerInstance.defaultTimeoutMS_)) {
+      defaultTimeoutMS_(std::move(timerInstance.defaultTimeoutMS_)),
+      timeoutQuantum_(timerInstance.timeoutQuantum_) {
 }
 
 std::chrono::milliseconds WheelTimerInstance::getDefaultTimeout() const {
@@ -54,11 +56,30 @@ void WheelTimerInstance::setDefaultTimeout(std::chrono::milliseconds timeout) {
   defaultTimeoutMS_ = timeout;
 }
 
+void WheelTimerInstance::setTimeoutQuantum(std::chrono::milliseconds quantum) {
+  timeoutQuantum_ = quantum;
+}
+
+std::chrono::milliseconds WheelTimerInstance::getTimeoutQuantum() const {
+  return timeoutQuantum_;
+}
+
+std::chrono::milliseconds WheelTimerInstance::quantize(
+    std::chrono::milliseconds timeout) const {
+  if (timeoutQuantum_.count() <= 0 || timeout.count() <= 0) {
+    return timeout;
+  }
+  // round up, never down, so a timeout cannot fire before its deadline
+  const auto quantum = timeoutQuantum_.count();
+  return std::chrono::milliseconds(((timeout.count() + quantum - 1) / quantum) *
+                                   quantum);
+}
+
 void WheelTimerInstance::scheduleTimeout(
     folly::HHWheelTimer::Callback* callback,
     std::chrono::milliseconds timeout) {
   if (wheelTimerPtr_) {
-    wheelTimerPtr_->scheduleTimeout(callback, timeout);
+    wheelTimerPtr_->scheduleTimeout(callback, quantize(timeout));
   } else {
     VLOG(2) << "Ingoring scheduleTimeout on an empty WheelTimerInstance";
   }
@@ -70,9 +91,36 @@ void WheelTimerInstance::scheduleTimeout(
   scheduleTimeout(callback, defaultTimeoutMS_);
 }
 
+void WheelTimerInstance::scheduleTimeouts(
+    folly::Range<folly::HHWheelTimer::Callback**> callbacks,
+    std::chrono::milliseconds timeout) {
+  if (!wheelTimerPtr_) {
+    VLOG(2) << "Ingoring scheduleTimeouts on an empty WheelTimerInstance";
+    return;
+  }
+  const auto deadline = quantize(timeout);
+  for (auto* callback : callbacks) {
+    wheelTimerPtr_->scheduleTimeout(callback, deadline);
+  }
+}
+
+void WheelTimerInstance::scheduleTimeouts(
+    folly::Range<folly::HHWheelTimer::Callback**> callbacks) {
+  CHECK_GE(defaultTimeoutMS_.count(), 0);
+  scheduleTimeouts(callbacks, defaultTimeoutMS_);
+}
+
+void WheelTimerInstance::cancelTimeouts(
+    folly::Range<folly::HHWheelTimer::Callback**> callbacks) {
+  for (auto* callback : callbacks) {
+    callback->cancelTimeout();
+  }
+}
+
 WheelTimerInstance& WheelTimerInstance::operator=(const WheelTimerInstance& t) {
   wheelTimerPtr_ = t.wheelTimerPtr_;
   defaultTimeoutMS_ = t.defaultTimeoutMS_;
+  timeoutQuantum_ = t.timeoutQuantum_;
   return *this;
 }
 
@@ -80,6 +128,7 @@ WheelTimerInstance& WheelTimerInstance::operator=(
     const WheelTimerInstance&& timer) {
   wheelTimerPtr_ = std::move(timer.wheelTimerPtr_);
   defaultTimeoutMS_ = std::move(timer.defaultTimeoutMS_);
+  timeoutQuantum_ = timer.timeoutQuantum_;
   return *this;
 }
 
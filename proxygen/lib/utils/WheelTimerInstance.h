@@ -11,6 +11,7 @@
 #include <chrono>
 #include <memory>
 
+#include <folly/Range.h>
 #include <folly/io/async/HHWheelTimer.h>
 
 namespace folly {
@@ -49,6 +50,27 @@ class WheelTimerInstance {
                        std::chrono::milliseconds timeout);
   void scheduleTimeout(folly::HHWheelTimer::Callback* callback);
 
+  // Schedule every callback in the range against one shared deadline.
+  // The deadline is computed (and quantized) once, and because all the
+  // callbacks land in the same wheel bucket the timer's next-fire
+  // bookkeeping settles after the first insert; the rest are cheap
+  // same-bucket list appends.
+  void scheduleTimeouts(folly::Range<folly::HHWheelTimer::Callback**> callbacks,
+                        std::chrono::milliseconds timeout);
+  void scheduleTimeouts(
+      folly::Range<folly::HHWheelTimer::Callback**> callbacks);
+
+  // Cancel every callback in the range; callbacks that are not currently
+  // scheduled are skipped.
+  static void cancelTimeouts(
+      folly::Range<folly::HHWheelTimer::Callback**> callbacks);
+
+  // Coalesce deadlines up to the next multiple of the quantum so timeouts
+  // scheduled close together share a wheel bucket (timeouts never fire
+  // earlier than requested).  Zero, the default, disables coalescing.
+  void setTimeoutQuantum(std::chrono::milliseconds quantum);
+  std::chrono::milliseconds getTimeoutQuantum() const;
+
   WheelTimerInstance& operator=(const WheelTimerInstance& timer);
   WheelTimerInstance& operator=(const WheelTimerInstance&& timer);
 
@@ -60,11 +82,14 @@ class WheelTimerInstance {
   }
 
  private:
+  std::chrono::milliseconds quantize(std::chrono::milliseconds timeout) const;
+
   folly::HHWheelTimer* wheelTimerPtr_{nullptr}; // to support cases when
   // external WheelTimer is
   // specified
 
   std::chrono::milliseconds defaultTimeoutMS_;
+  std::chrono::milliseconds timeoutQuantum_{0};
 };
 
 } // namespace proxygen
@@ -8,8 +8,11 @@
 
 #include "proxygen/lib/utils/ZlibStreamCompressor.h"
 
+#include <algorithm>
+#include <folly/SingletonThreadLocal.h>
 #include <folly/io/Cursor.h>
 #include <folly/lang/Bits.h>
+#include <vector>
 
 using folly::IOBuf;
 
@@ -23,7 +26,59 @@ namespace proxygen {
 
 namespace {
 
-std::unique_ptr<IOBuf> addOutputBuffer(z_stream* stream, uint32_t length) {
+// Cap on the deflateBound-based initial output buffer; larger inputs fall
+// back to growing by FLAGS_zlib_compressor_buffer_growth
+constexpr uint64_t kMaxInitialOutputLength = 1 << 20;
+
+constexpr size_t kMaxPooledStreams = 4;
+
+// deflateInit2 allocates and initializes a couple hundred KB of window and
+// hash state per stream, which is wasteful to redo for every response.
+// Compressors that finish without an error park their stream here and
+// init() revives a parked stream with deflateReset when the type and level
+// match.  Streams are heap-allocated because zlib keeps a back-pointer to
+// the z_stream and rejects one that has changed address.
+struct ZlibStreamPool {
+  struct Entry {
+    CompressionType type;
+    int level;
+    std::unique_ptr<z_stream> stream;
+  };
+
+  std::vector<Entry> streams;
+
+  ~ZlibStreamPool() {
+    for (auto& entry : streams) {
+      deflateEnd(entry.stream.get());
+    }
+  }
+
+  std::unique_ptr<z_stream> acquire(CompressionType type, int level) {
+    for (auto it = streams.begin(); it != streams.end(); ++it) {
+      if (it->type == type && it->level == level) {
+        auto stream = std::move(it->stream);
+        streams.erase(it);
+        return stream;
+      }
+    }
+    return nullptr;
+  }
+
+  void release(CompressionType type, int level, std::unique_ptr<z_stream> s) {
+    if (streams.size() >= kMaxPooledStreams) {
+      deflateEnd(s.get());
+      return;
+    }
+    streams.push_back({type, level, std::move(s)});
+  }
+};
+
+ZlibStreamPool& zlibStreamPool() {
+  struct PoolTag {};
+  return folly::SingletonThreadLocal<ZlibStreamPool, PoolTag>::get();
+}
+
+std::unique_ptr<IOBuf> addOutputBuffer(z_stream* stream, uint64_t length) {
   CHECK_EQ(stream->avail_out, 0);
 
   auto buf = IOBuf::create(length);
@@ -53,24 +108,34 @@ void ZlibStreamCompressor::init() {
 
   status_ = Z_OK;
 
-  zlibStream_.zalloc = Z_NULL;
-  zlibStream_.zfree = Z_NULL;
-  zlibStream_.opaque = Z_NULL;
-  zlibStream_.total_in = 0;
-  zlibStream_.next_in = Z_NULL;
-  zlibStream_.avail_in = 0;
-  zlibStream_.avail_out = 0;
-  zlibStream_.next_out = Z_NULL;
-
   DCHECK(level_ == Z_DEFAULT_COMPRESSION ||
          (level_ >= Z_NO_COMPRESSION && level_ <= Z_BEST_COMPRESSION))
       << "Invalid Zlib compression level. level=" << level_;
 
+  auto pooled = zlibStreamPool().acquire(type_, level_);
+  if (pooled) {
+    if (deflateReset(pooled.get()) == Z_OK) {
+      zlibStream_ = std::move(pooled);
+      return;
+    }
+    deflateEnd(pooled.get());
+  }
+
+  zlibStream_ = std::make_unique<z_stream>();
+  zlibStream_->zalloc = Z_NULL;
+  zlibStream_->zfree = Z_NULL;
+  zlibStream_->opaque = Z_NULL;
+  zlibStream_->total_in = 0;
+  zlibStream_->next_in = Z_NULL;
+  zlibStream_->avail_in = 0;
+  zlibStream_->avail_out = 0;
+  zlibStream_->next_out = Z_NULL;
+
   switch (type_) {
     case CompressionType::GZIP: {
       auto windowBits = type_ == CompressionType::GZIP ? GZIP_WINDOW_BITS
                                                        : DEFLATE_WINDOW_BITS;
-      status_ = deflateInit2(&zlibStream_,
+      status_ = deflateInit2(zlibStream_.get(),
                              level_,
                              Z_DEFLATED,
                              windowBits,
@@ -78,7 +143,7 @@ void ZlibStreamCompressor::init() {
                              Z_DEFAULT_STRATEGY);
     } break;
     case CompressionType::DEFLATE:
-      status_ = deflateInit(&zlibStream_, level_);
+      status_ = deflateInit(zlibStream_.get(), level_);
       break;
     default:
       DCHECK(false) << "Unsupported zlib compression type.";
@@ -95,8 +160,12 @@ ZlibStreamCompressor::ZlibStreamCompressor(CompressionType type, int level)
 }
 
 ZlibStreamCompressor::~ZlibStreamCompressor() {
-  if (init_) {
-    status_ = deflateEnd(&zlibStream_);
+  if (init_ && zlibStream_) {
+    if (hasError()) {
+      status_ = deflateEnd(zlibStream_.get());
+    } else {
+      zlibStreamPool().release(type_, level_, std::move(zlibStream_));
+    }
   }
 }
 
@@ -106,24 +175,32 @@ ZlibStreamCompressor::~ZlibStreamCompressor() {
 std::unique_ptr<IOBuf> ZlibStreamCompressor::compress(const IOBuf* in,
                                                       bool trailer) {
   init();
-  auto bufferLength = FLAGS_zlib_compressor_buffer_growth;
 
-  auto out = addOutputBuffer(&zlibStream_, bufferLength);
+  // Size the first output buffer from deflateBound so typical payloads
+  // deflate into a single allocation instead of growing a few KB at a time
+  const uint64_t bound =
+      deflateBound(zlibStream_.get(), in->computeChainDataLength());
+  const auto bufferLength = std::min<uint64_t>(
+      std::max<uint64_t>(bound,
+                         uint64_t(FLAGS_zlib_compressor_buffer_growth)),
+      kMaxInitialOutputLength);
+
+  auto out = addOutputBuffer(zlibStream_.get(), bufferLength);
 
   for (auto& range : *in) {
     uint64_t remaining = range.size();
     uint64_t written = 0;
     while (remaining) {
       uint32_t step = remaining;
-      zlibStream_.next_in = const_cast<uint8_t*>(range.data() + written);
-      zlibStream_.avail_in = step;
+      zlibStream_->next_in = const_cast<uint8_t*>(range.data() + written);
+      zlibStream_->avail_in = step;
       remaining -= step;
       written += step;
 
-      while (zlibStream_.avail_in != 0) {
-        status_ = deflateHelper(&zlibStream_, out.get(), Z_NO_FLUSH);
+      while (zlibStream_->avail_in != 0) {
+        status_ = deflateHelper(zlibStream_.get(), out.get(), Z_NO_FLUSH);
         if (status_ != Z_OK) {
-          DLOG(FATAL) << "Deflate failed: " << zlibStream_.msg;
+          DLOG(FATAL) << "Deflate failed: " << zlibStream_->msg;
           return nullptr;
         }
       }
@@ -132,28 +209,28 @@ std::unique_ptr<IOBuf> ZlibStreamCompressor::compress(const IOBuf* in,
 
   if (trailer) {
     do {
-      status_ = deflateHelper(&zlibStream_, out.get(), Z_FINISH);
+      status_ = deflateHelper(zlibStream_.get(), out.get(), Z_FINISH);
     } while (status_ == Z_OK);
 
     if (status_ != Z_STREAM_END) {
-      DLOG(FATAL) << "Deflate failed: " << zlibStream_.msg;
+      DLOG(FATAL) << "Deflate failed: " << zlibStream_->msg;
       return nullptr;
     }
   } else {
     do {
-      status_ = deflateHelper(&zlibStream_, out.get(), Z_SYNC_FLUSH);
-    } while (zlibStream_.avail_out == 0);
+      status_ = deflateHelper(zlibStream_.get(), out.get(), Z_SYNC_FLUSH);
+    } while (zlibStream_->avail_out == 0);
 
     if (status_ != Z_OK) {
-      DLOG(FATAL) << "Deflate failed: " << zlibStream_.msg;
+      DLOG(FATAL) << "Deflate failed: " << zlibStream_->msg;
       return nullptr;
     }
   }
 
-  out->prev()->trimEnd(zlibStream_.avail_out);
+  out->prev()->trimEnd(zlibStream_->avail_out);
 
-  zlibStream_.next_out = Z_NULL;
-  zlibStream_.avail_out = 0;
+  zlibStream_->next_out = Z_NULL;
+  zlibStream_->avail_out = 0;
 
   return out;
 }
@@ -48,7 +48,10 @@ class ZlibStreamCompressor : public StreamCompressor {
  private:
   CompressionType type_{CompressionType::NONE};
   int level_{Z_DEFAULT_COMPRESSION};
-  z_stream zlibStream_;
+  // Heap-allocated so the stream keeps a stable address, which lets it be
+  // recycled through the per-thread pool (zlib keeps a back-pointer into
+  // the z_stream and rejects a moved stream)
+  std::unique_ptr<z_stream> zlibStream_;
   int status_{Z_OK};
   bool init_{false};
 };
@@ -45,6 +45,8 @@ class ZlibStreamDecompressor : public StreamDecompressor {
 
   void init(CompressionType type);
 
+  void reset() override;
+
   std::unique_ptr<folly::IOBuf> decompress(const folly::IOBuf* in) override;
 
   int getStatus() {
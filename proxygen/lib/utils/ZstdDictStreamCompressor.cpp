@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "proxygen/lib/utils/ZstdDictStreamCompressor.h"
+
+#include <vector>
+
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBuf.h>
+#include <glog/logging.h>
+
+namespace {
+
+// Per-thread pool of compression contexts. Contexts are only ever used
+// by the thread that acquired them; pooling them amortizes the
+// allocation cost of ZSTD_createCCtx() across responses.
+constexpr size_t kMaxPooledCCtxs = 8;
+
+thread_local std::vector<ZSTD_CCtx*> threadCCtxPool;
+
+ZSTD_CCtx* acquireCCtx() {
+  if (!threadCCtxPool.empty()) {
+    auto* cctx = threadCCtxPool.back();
+    threadCCtxPool.pop_back();
+    return cctx;
+  }
+  return ZSTD_createCCtx();
+}
+
+void releaseCCtx(ZSTD_CCtx* cctx) {
+  if (cctx == nullptr) {
+    return;
+  }
+  if (threadCCtxPool.size() < kMaxPooledCCtxs) {
+    ZSTD_CCtx_reset(cctx, ZSTD_reset_session_and_parameters);
+    threadCCtxPool.push_back(cctx);
+  } else {
+    ZSTD_freeCCtx(cctx);
+  }
+}
+
+} // namespace
+
+namespace proxygen {
+
+void ZstdCompressionDictionary::freeCDict(ZSTD_CDict* cdict) {
+  ZSTD_freeCDict(cdict);
+}
+
+ZstdCompressionDictionary::ZstdCompressionDictionary(
+    const std::string& rawDictionary, int compressionLevel)
+    : cdict_(ZSTD_createCDict(
+          rawDictionary.data(), rawDictionary.size(), compressionLevel)) {
+  CHECK(cdict_) << "Failed to digest zstd dictionary";
+}
+
+ZstdDictStreamCompressor::ZstdDictStreamCompressor(
+    std::shared_ptr<const ZstdCompressionDictionary> dictionary)
+    : dictionary_(std::move(dictionary)), cctx_(acquireCCtx()) {
+  CHECK(dictionary_);
+  if (cctx_ == nullptr ||
+      ZSTD_isError(ZSTD_CCtx_refCDict(cctx_, dictionary_->get()))) {
+    error_ = true;
+  }
+}
+
+ZstdDictStreamCompressor::~ZstdDictStreamCompressor() {
+  releaseCCtx(cctx_);
+}
+
+std::unique_ptr<folly::IOBuf> ZstdDictStreamCompressor::compress(
+    const folly::IOBuf* in, bool last) {
+  if (error_) {
+    return nullptr;
+  }
+  if (in == nullptr) {
+    error_ = true;
+    return nullptr;
+  }
+
+  const size_t outBufAllocSize = ZSTD_CStreamOutSize();
+  auto out = folly::IOBuf::create(outBufAllocSize);
+  folly::io::Appender appender(out.get(), outBufAllocSize);
+
+  auto pump = [&](ZSTD_inBuffer& ibuf, ZSTD_EndDirective mode) {
+    size_t remaining;
+    do {
+      appender.ensure(outBufAllocSize);
+      ZSTD_outBuffer obuf = {appender.writableData(), appender.length(), 0};
+      remaining = ZSTD_compressStream2(cctx_, &obuf, &ibuf, mode);
+      if (ZSTD_isError(remaining)) {
+        error_ = true;
+        return false;
+      }
+      appender.append(obuf.pos);
+      // For FLUSH/END, zstd reports how much internal state is still
+      // pending; loop until it is fully drained.
+    } while (ibuf.pos < ibuf.size ||
+             (mode != ZSTD_e_continue && remaining != 0));
+    return true;
+  };
+
+  for (const folly::ByteRange& range : *in) {
+    if (range.data() == nullptr || range.empty()) {
+      continue;
+    }
+    ZSTD_inBuffer ibuf = {range.data(), range.size(), 0};
+    if (!pump(ibuf, ZSTD_e_continue)) {
+      return nullptr;
+    }
+  }
+
+  ZSTD_inBuffer ibuf = {nullptr, 0, 0};
+  if (!pump(ibuf, last ? ZSTD_e_end : ZSTD_e_flush)) {
+    return nullptr;
+  }
+
+  if (last) {
+    // Re-arm for a potential next frame; the referenced dictionary
+    // survives a session-only reset.
+    ZSTD_CCtx_reset(cctx_, ZSTD_reset_session_only);
+  }
+
+  return out;
+}
+
+} // namespace proxygen
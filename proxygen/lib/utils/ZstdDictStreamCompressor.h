@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <zstd.h>
+
+#include <folly/Memory.h>
+
+#include <proxygen/lib/utils/StreamCompressor.h>
+
+namespace folly {
+class IOBuf;
+}
+
+namespace proxygen {
+
+/**
+ * An immutable pretrained zstd dictionary, digested once at the given
+ * compression level. Safe to share across threads; hold it via
+ * shared_ptr<const ...> and reference it from as many compressors as
+ * needed.
+ */
+class ZstdCompressionDictionary {
+ public:
+  ZstdCompressionDictionary(const std::string& rawDictionary,
+                            int compressionLevel);
+
+  const ZSTD_CDict* get() const {
+    return cdict_.get();
+  }
+
+ private:
+  static void freeCDict(ZSTD_CDict* cdict);
+
+  const std::unique_ptr<ZSTD_CDict,
+                        folly::static_function_deleter<ZSTD_CDict, freeCDict>>
+      cdict_;
+};
+
+/**
+ * A StreamCompressor producing a single zstd frame compressed against a
+ * pretrained dictionary. Decoding requires the same dictionary, so this
+ * is only suitable when the dictionary is distributed to clients out of
+ * band.
+ *
+ * Compression contexts are recycled through a per-thread pool, so
+ * per-response construction doesn't pay for ZSTD_createCCtx() on hot
+ * paths.
+ */
+class ZstdDictStreamCompressor : public StreamCompressor {
+ public:
+  explicit ZstdDictStreamCompressor(
+      std::shared_ptr<const ZstdCompressionDictionary> dictionary);
+
+  ~ZstdDictStreamCompressor() override;
+
+  std::unique_ptr<folly::IOBuf> compress(const folly::IOBuf*,
+                                         bool last = true) override;
+
+  bool hasError() override {
+    return error_;
+  }
+
+ private:
+  std::shared_ptr<const ZstdCompressionDictionary> dictionary_;
+  ZSTD_CCtx* cctx_{nullptr};
+  bool error_{false};
+};
+
+} // namespace proxygen
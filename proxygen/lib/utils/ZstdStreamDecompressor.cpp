@@ -18,11 +18,27 @@ void ZstdStreamDecompressor::freeDCtx(ZSTD_DCtx* dctx) {
   ZSTD_freeDCtx(dctx);
 }
 
-ZstdStreamDecompressor::ZstdStreamDecompressor(bool reuseOutBuf)
+ZstdStreamDecompressor::ZstdStreamDecompressor(bool reuseOutBuf,
+                                               const std::string& dictionary)
     : status_(ZstdStatusType::NONE),
       dctx_(ZSTD_createDCtx()),
       cachedIOBuf_(nullptr),
       reuseOutBuf_(reuseOutBuf) {
+  if (dctx_ && !dictionary.empty()) {
+    auto ret = ZSTD_DCtx_loadDictionary(
+        dctx_.get(), dictionary.data(), dictionary.size());
+    if (ZSTD_isError(ret)) {
+      status_ = ZstdStatusType::ERROR;
+    }
+  }
+}
+
+void ZstdStreamDecompressor::reset() {
+  if (dctx_) {
+    // Keeps any loaded dictionary; only the streaming session restarts
+    ZSTD_DCtx_reset(dctx_.get(), ZSTD_reset_session_only);
+    status_ = ZstdStatusType::NONE;
+  }
 }
 
 std::unique_ptr<folly::IOBuf> ZstdStreamDecompressor::decompress(
@@ -17,6 +17,7 @@
 #endif
 
 #include <memory>
+#include <string>
 #include <zdict.h>
 #include <zstd.h>
 
@@ -28,7 +29,13 @@ namespace proxygen {
 
 class ZstdStreamDecompressor : public StreamDecompressor {
  public:
-  explicit ZstdStreamDecompressor(bool reuseOutBuf = false);
+  /**
+   * If dictionary is non-empty it is loaded into the decompression
+   * context; frames compressed against that dictionary (e.g. by
+   * ZstdDictStreamCompressor) can then be decoded.
+   */
+  explicit ZstdStreamDecompressor(bool reuseOutBuf = false,
+                                  const std::string& dictionary = "");
 
   // May return nullptr on error / no output.
   std::unique_ptr<folly::IOBuf> decompress(const folly::IOBuf* in) override;
@@ -45,6 +52,8 @@ class ZstdStreamDecompressor : public StreamDecompressor {
     return status_ == ZstdStatusType::FINISHED;
   }
 
+  void reset() override;
+
  private:
   static void freeDCtx(ZSTD_DCtx* dctx);
 
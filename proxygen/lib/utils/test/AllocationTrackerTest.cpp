@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/utils/AllocationTracker.h>
+
+#include <folly/ScopeGuard.h>
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+
+TEST(AllocationTracker, DisabledIsNoop) {
+  ASSERT_FALSE(AllocationTracker::isEnabled());
+  AllocationTracker::recordAllocation(AllocationTracker::CODEC, 100);
+
+  auto snapshot = AllocationTracker::getThreadSnapshot();
+  EXPECT_EQ(snapshot.allocations[AllocationTracker::CODEC], 0);
+  EXPECT_EQ(snapshot.bytes[AllocationTracker::CODEC], 0);
+}
+
+TEST(AllocationTracker, RecordsPerSubsystem) {
+  AllocationTracker::enable();
+  SCOPE_EXIT {
+    AllocationTracker::disable();
+  };
+
+  AllocationTracker::recordAllocation(AllocationTracker::CODEC, 100);
+  AllocationTracker::recordAllocation(AllocationTracker::CODEC, 50);
+  AllocationTracker::recordAllocation(AllocationTracker::MESSAGE, 8);
+
+  auto snapshot = AllocationTracker::getThreadSnapshot();
+  EXPECT_EQ(snapshot.allocations[AllocationTracker::CODEC], 2);
+  EXPECT_EQ(snapshot.bytes[AllocationTracker::CODEC], 150);
+  EXPECT_EQ(snapshot.allocations[AllocationTracker::MESSAGE], 1);
+  EXPECT_EQ(snapshot.bytes[AllocationTracker::MESSAGE], 8);
+  EXPECT_EQ(snapshot.allocations[AllocationTracker::SESSION], 0);
+
+  // The global summary includes at least this thread's counters
+  auto summary = AllocationTracker::getGlobalSummary();
+  EXPECT_GE(summary.allocations[AllocationTracker::CODEC], 2);
+  EXPECT_GE(summary.bytes[AllocationTracker::CODEC], 150);
+}
+
+TEST(AllocationTracker, DeltaSnapshots) {
+  AllocationTracker::enable();
+  SCOPE_EXIT {
+    AllocationTracker::disable();
+  };
+
+  AllocationTracker::recordAllocation(AllocationTracker::SESSION, 64);
+  auto baseline = AllocationTracker::getThreadSnapshot();
+
+  AllocationTracker::recordAllocation(AllocationTracker::SESSION, 32);
+  AllocationTracker::recordAllocation(AllocationTracker::COMPRESS, 16);
+
+  auto delta = AllocationTracker::getThreadSnapshot().delta(baseline);
+  EXPECT_EQ(delta.allocations[AllocationTracker::SESSION], 1);
+  EXPECT_EQ(delta.bytes[AllocationTracker::SESSION], 32);
+  EXPECT_EQ(delta.allocations[AllocationTracker::COMPRESS], 1);
+  EXPECT_EQ(delta.bytes[AllocationTracker::COMPRESS], 16);
+}
+
+TEST(AllocationTracker, SamplingRate) {
+  AllocationTracker::enable(10);
+  SCOPE_EXIT {
+    AllocationTracker::disable();
+  };
+
+  uint32_t sampled = 0;
+  for (int i = 0; i < 100; i++) {
+    if (AllocationTracker::shouldSampleTransaction()) {
+      sampled++;
+    }
+  }
+  EXPECT_EQ(sampled, 10);
+}
+
+TEST(AllocationTracker, EnableResetsCounters) {
+  AllocationTracker::enable();
+  AllocationTracker::recordAllocation(AllocationTracker::HANDLER, 24);
+  AllocationTracker::disable();
+
+  AllocationTracker::enable();
+  SCOPE_EXIT {
+    AllocationTracker::disable();
+  };
+  auto snapshot = AllocationTracker::getThreadSnapshot();
+  EXPECT_EQ(snapshot.allocations[AllocationTracker::HANDLER], 0);
+  EXPECT_EQ(snapshot.bytes[AllocationTracker::HANDLER], 0);
+}
@@ -309,6 +309,62 @@ TEST_F(TimeoutTest, CancelTimeout) {
   ASSERT_EQ(timeoutClock_.millisecondsSinceEpoch(), milliseconds(10));
 }
 
+/*
+ * Test that a lazily cancelled timeout stays invisible to front(), can be
+ * rescheduled while still linked, and never fires.
+ */
+TEST_F(TimeoutTest, LazyCancelReschedule) {
+  StackTimeoutSet ts5(
+      &timeoutManager_, milliseconds(5), milliseconds(0), &timeoutClock_);
+
+  TestTimeout t1(&ts5);
+  TestTimeout t2(&ts5);
+
+  t1.cancelTimeout();
+  ASSERT_FALSE(t1.isScheduled());
+  // t1 is still linked at the head of the list, but front() skips it
+  ASSERT_EQ(ts5.front(), &t2);
+
+  // Rescheduling a cancelled-but-still-linked callback unlinks it eagerly
+  // and re-appends it at the tail.
+  setClock(milliseconds(2));
+  ts5.scheduleTimeout(&t1);
+  ASSERT_TRUE(t1.isScheduled());
+  ASSERT_EQ(ts5.front(), &t2);
+
+  setClock(milliseconds(5));
+  ASSERT_EQ(t2.timestamps.size(), 1);
+  ASSERT_EQ(ts5.front(), &t1);
+
+  setClock(milliseconds(7));
+  ASSERT_EQ(t1.timestamps.size(), 1);
+  ASSERT_EQ(t1.timestamps[0], milliseconds(7));
+}
+
+/*
+ * Test that cancelling every timeout in a set disarms the underlying
+ * timeout instead of waking up just to reap the dead entries.
+ */
+TEST_F(TimeoutTest, LazyCancelAll) {
+  StackTimeoutSet ts5(
+      &timeoutManager_, milliseconds(5), milliseconds(0), &timeoutClock_);
+
+  TestTimeout t1(&ts5);
+  TestTimeout t2(&ts5);
+
+  t1.cancelTimeout();
+  t2.cancelTimeout();
+  const AsyncTimeoutSet::Callback* nullCallback = nullptr;
+  ASSERT_EQ(ts5.front(), nullCallback);
+
+  loop();
+
+  ASSERT_EQ(t1.timestamps.size(), 0);
+  ASSERT_EQ(t2.timestamps.size(), 0);
+  // The set never woke up; the clock did not advance.
+  ASSERT_EQ(timeoutClock_.millisecondsSinceEpoch(), milliseconds(0));
+}
+
 /*
  * Test destroying a AsyncTimeoutSet with timeouts outstanding
  */
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/Benchmark.h>
+#include <proxygen/lib/utils/Base64.h>
+
+using namespace folly;
+using namespace proxygen;
+
+// buck build @mode/opt proxygen/lib/utils/test:base64_benchmark
+// ./buck-out/gen/proxygen/lib/utils/test/base64_benchmark
+
+namespace {
+
+std::string makeBlob(size_t len) {
+  std::string blob(len, '\0');
+  for (size_t i = 0; i < len; i++) {
+    blob[i] = static_cast<char>(i * 131 + 7);
+  }
+  return blob;
+}
+
+// signed-token-sized payloads: a compact claim set and a fat one
+const std::string kSmallBlob = makeBlob(64);
+const std::string kTokenBlob = makeBlob(512);
+const std::string kLargeBlob = makeBlob(8192);
+
+folly::ByteRange blobRange(const std::string& blob) {
+  return folly::ByteRange(reinterpret_cast<const uint8_t*>(blob.data()),
+                          blob.size());
+}
+
+const std::string kSmallB64 = Base64::encode(blobRange(kSmallBlob));
+const std::string kTokenB64 = Base64::encode(blobRange(kTokenBlob));
+const std::string kLargeB64 = Base64::encode(blobRange(kLargeBlob));
+const std::string kTokenUrlB64 = Base64::urlEncode(blobRange(kTokenBlob));
+
+} // namespace
+
+BENCHMARK(Encode64B, iters) {
+  for (unsigned i = 0; i < iters; ++i) {
+    doNotOptimizeAway(Base64::encode(blobRange(kSmallBlob)));
+  }
+}
+
+BENCHMARK(Encode512B, iters) {
+  for (unsigned i = 0; i < iters; ++i) {
+    doNotOptimizeAway(Base64::encode(blobRange(kTokenBlob)));
+  }
+}
+
+BENCHMARK(Encode8K, iters) {
+  for (unsigned i = 0; i < iters; ++i) {
+    doNotOptimizeAway(Base64::encode(blobRange(kLargeBlob)));
+  }
+}
+
+BENCHMARK(Decode64B, iters) {
+  for (unsigned i = 0; i < iters; ++i) {
+    doNotOptimizeAway(Base64::decode(kSmallB64, 0));
+  }
+}
+
+BENCHMARK(Decode512B, iters) {
+  for (unsigned i = 0; i < iters; ++i) {
+    doNotOptimizeAway(Base64::decode(kTokenB64, 0));
+  }
+}
+
+BENCHMARK(Decode8K, iters) {
+  for (unsigned i = 0; i < iters; ++i) {
+    doNotOptimizeAway(Base64::decode(kLargeB64, 0));
+  }
+}
+
+// the auth-filter hot path: url-safe decode of a signed token
+BENCHMARK(UrlDecode512B, iters) {
+  for (unsigned i = 0; i < iters; ++i) {
+    doNotOptimizeAway(Base64::urlDecode(kTokenUrlB64));
+  }
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  runBenchmarks();
+  return 0;
+}
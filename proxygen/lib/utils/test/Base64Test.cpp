@@ -8,6 +8,9 @@
 
 #include <proxygen/lib/utils/Base64.h>
 
+#include <algorithm>
+
+#include <folly/io/IOBuf.h>
 #include <folly/portability/GTest.h>
 
 using namespace proxygen;
@@ -62,3 +65,44 @@ TEST(Base64, EncodeDecodeHighBits) {
   EXPECT_EQ(Base64::urlDecode("_--_"), std::string("\xff\xef\xbf", 3));
   EXPECT_EQ(Base64::urlEncode(range("\xff\xef\xbf", 3)), "_--_");
 }
+
+// long enough to run the vectorized bulk path several times over, with
+// every remainder length at the tail
+TEST(Base64, RoundTripLong) {
+  std::string data;
+  for (int i = 0; i < 256; i++) {
+    data.push_back(static_cast<char>(i));
+  }
+  for (size_t len = data.size() - 3; len <= data.size(); len++) {
+    const std::string input = data.substr(0, len);
+    const std::string encoded =
+        Base64::encode(range(input.data(), input.size()));
+    const size_t padding = std::count(encoded.begin(), encoded.end(), '=');
+    EXPECT_EQ(Base64::decode(encoded, padding), input);
+    EXPECT_EQ(Base64::urlDecode(
+                  Base64::urlEncode(range(input.data(), input.size()))),
+              input);
+  }
+}
+
+TEST(Base64, DecodeGarbageLong) {
+  // invalid byte beyond the first vector block still fails cleanly
+  std::string bad(32, 'A');
+  bad[25] = '[';
+  EXPECT_EQ(Base64::decode(bad, 0), "");
+}
+
+TEST(Base64, EncodeIOBufChain) {
+  const std::string data = "the quick brown fox jumps over the lazy dog";
+  auto buf = folly::IOBuf::copyBuffer(data.substr(0, 10));
+  buf->prependChain(folly::IOBuf::copyBuffer(data.substr(10, 1)));
+  buf->prependChain(folly::IOBuf::copyBuffer(data.substr(11)));
+  EXPECT_EQ(Base64::encode(*buf),
+            Base64::encode(range(data.data(), data.size())));
+  EXPECT_EQ(Base64::urlEncode(*buf),
+            Base64::urlEncode(range(data.data(), data.size())));
+
+  auto single = folly::IOBuf::copyBuffer(data);
+  EXPECT_EQ(Base64::encode(*single),
+            Base64::encode(range(data.data(), data.size())));
+}
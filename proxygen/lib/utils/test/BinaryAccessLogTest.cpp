@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/utils/BinaryAccessLog.h>
+
+#include <folly/Conv.h>
+#include <folly/experimental/TestUtil.h>
+#include <folly/portability/GTest.h>
+
+#include <sstream>
+#include <thread>
+
+using namespace proxygen;
+
+namespace {
+
+AccessLogRecord makeRecord(uint64_t streamId, uint16_t status) {
+  AccessLogRecord record;
+  record.startNs = 1000;
+  record.firstByteNs = 2000;
+  record.lastByteNs = 5000;
+  record.streamId = streamId;
+  record.egressBodyBytes = 100 * streamId;
+  record.ingressBodyBytes = 10;
+  record.status = status;
+  static const std::string kSni = "example.com";
+  record.sniLength = uint8_t(kSni.size());
+  memcpy(record.sni, kSni.data(), kSni.size());
+  return record;
+}
+
+} // namespace
+
+TEST(BinaryAccessLogTest, LogAndDecode) {
+  folly::test::TemporaryDirectory dir;
+  const auto prefix = (dir.path() / "access").string();
+  constexpr size_t kRecords = 100;
+  {
+    BinaryAccessLog log(prefix);
+    for (size_t i = 0; i < kRecords; i++) {
+      log.log(makeRecord(i, 200));
+    }
+    EXPECT_EQ(0, log.getDroppedCount());
+  }
+
+  auto records = BinaryAccessLog::decodeFile(prefix + ".0");
+  ASSERT_EQ(kRecords, records.size());
+  for (size_t i = 0; i < kRecords; i++) {
+    const auto& record = records[i];
+    EXPECT_EQ(i, record.streamId);
+    EXPECT_EQ(200, record.status);
+    EXPECT_EQ(100 * i, record.egressBodyBytes);
+    EXPECT_EQ("example.com",
+              std::string(record.sni, record.sniLength));
+  }
+}
+
+TEST(BinaryAccessLogTest, RotatesSegments) {
+  folly::test::TemporaryDirectory dir;
+  const auto prefix = (dir.path() / "access").string();
+  // Segment fits the header plus two records
+  const size_t segmentBytes =
+      sizeof(BinaryAccessLog::SegmentHeader) + 2 * sizeof(AccessLogRecord);
+  constexpr size_t kRecords = 5;
+  {
+    BinaryAccessLog log(prefix, segmentBytes);
+    for (size_t i = 0; i < kRecords; i++) {
+      log.log(makeRecord(i, 200));
+    }
+  }
+
+  size_t total = 0;
+  uint64_t expectedStream = 0;
+  for (size_t segment = 0; segment < 3; segment++) {
+    auto records =
+        BinaryAccessLog::decodeFile(folly::to<std::string>(prefix, ".", segment));
+    for (const auto& record : records) {
+      EXPECT_EQ(expectedStream++, record.streamId);
+    }
+    total += records.size();
+  }
+  EXPECT_EQ(kRecords, total);
+}
+
+TEST(BinaryAccessLogTest, MultiThreadedLog) {
+  folly::test::TemporaryDirectory dir;
+  const auto prefix = (dir.path() / "access").string();
+  constexpr size_t kThreads = 4;
+  constexpr size_t kRecordsPerThread = 500;
+  {
+    BinaryAccessLog log(prefix);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kThreads; t++) {
+      threads.emplace_back([&log, t] {
+        for (size_t i = 0; i < kRecordsPerThread; i++) {
+          log.log(makeRecord(t, 200));
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(0, log.getDroppedCount());
+  }
+
+  EXPECT_EQ(kThreads * kRecordsPerThread,
+            BinaryAccessLog::decodeFile(prefix + ".0").size());
+}
+
+TEST(BinaryAccessLogTest, ConvertsToText) {
+  folly::test::TemporaryDirectory dir;
+  const auto prefix = (dir.path() / "access").string();
+  {
+    BinaryAccessLog log(prefix);
+    log.log(makeRecord(7, 404));
+  }
+
+  std::ostringstream out;
+  BinaryAccessLog::convertFile(prefix + ".0", out);
+  EXPECT_EQ(
+      "start_ns=1000 stream=7 sni=example.com status=404 bytes_out=700 "
+      "bytes_in=10 ttfb_us=1 ttlb_us=4 aborted=0\n",
+      out.str());
+}
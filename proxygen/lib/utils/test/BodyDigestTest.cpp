@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/hash/Checksum.h>
+#include <folly/io/IOBuf.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/utils/BodyDigest.h>
+#include <proxygen/lib/utils/CryptUtil.h>
+
+using namespace proxygen;
+
+TEST(BodyDigestTest, Sha256KnownAnswer) {
+  // chunk boundaries must not affect the digest
+  auto body = folly::IOBuf::copyBuffer("hello ");
+  body->prependChain(folly::IOBuf::copyBuffer("world"));
+
+  BodyDigestContext ctx(DigestAlgorithm::SHA256);
+  ctx.update(*body);
+  EXPECT_EQ(ctx.finish(),
+            "sha-256=uU0nuZNNPgilLlLX2n2r+sSE7+N6U4DukIj3rOLvzek=");
+}
+
+TEST(BodyDigestTest, Md5KnownAnswer) {
+  BodyDigestContext ctx(DigestAlgorithm::MD5);
+  ctx.update(folly::StringPiece("hello world"));
+  EXPECT_EQ(ctx.finish(), "md5=XrY7u+Ae7tCTyyK7j1rNww==");
+}
+
+TEST(BodyDigestTest, Crc32cMatchesOneShot) {
+  folly::StringPiece data("the quick brown fox jumps over the lazy dog");
+
+  BodyDigestContext ctx(DigestAlgorithm::CRC32C);
+  // feed in uneven chunks to exercise checksum chaining
+  ctx.update(data.subpiece(0, 7));
+  ctx.update(data.subpiece(7, 1));
+  ctx.update(data.subpiece(8));
+
+  uint32_t crc =
+      ~folly::crc32c((const uint8_t*)data.data(), data.size(), ~0u);
+  uint8_t be[4] = {
+      uint8_t(crc >> 24), uint8_t(crc >> 16), uint8_t(crc >> 8), uint8_t(crc)};
+  EXPECT_EQ(ctx.finish(),
+            "crc32c=" + base64Encode(folly::ByteRange(be, sizeof(be))));
+}
+
+TEST(BodyDigestTest, EmptyBody) {
+  // digest of zero bytes is still well defined
+  BodyDigestContext ctx(DigestAlgorithm::SHA256);
+  EXPECT_EQ(ctx.finish(),
+            "sha-256=47DEQpj8HBSa+/TImW+5JCeuQeRkm5NMpJWZG3hSuFU=");
+}
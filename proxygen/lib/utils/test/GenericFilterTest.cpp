@@ -565,3 +565,44 @@ TEST_F(OwnedGenericFilterTest, Foreach) {
       });
   EXPECT_EQ(count, 20);
 }
+
+TEST(StaticFilterChainTest, CallsAndCallbacks) {
+  MockTester tester;
+  MockTesterCallback callback;
+  StaticFilterChain<TesterInterface,
+                    TesterInterface::Callback,
+                    TestFilter<false>,
+                    &TesterInterface::setCallback,
+                    TestFilter<false>,
+                    TestFilterNoCallback<false>>
+      chain(&tester);
+  chain.setCallback(&callback);
+
+  // Calls traverse the filters in declaration order to the destination
+  EXPECT_CALL(tester, doA());
+  chain->doA();
+  EXPECT_EQ(chain.getFilter<0>().do_, 1);
+  EXPECT_EQ(chain.getFilter<1>().do_, 1);
+
+  // Callbacks skip the filter that doesn't want them
+  EXPECT_CALL(callback, onA());
+  tester.cb_->onA();
+  EXPECT_EQ(chain.getFilter<0>().on_, 1);
+  EXPECT_EQ(chain.getFilter<1>().on_, 0);
+}
+
+TEST(StaticFilterChainTest, NoFilters) {
+  MockTester tester;
+  MockTesterCallback callback;
+  StaticFilterChain<TesterInterface,
+                    TesterInterface::Callback,
+                    TestFilter<false>,
+                    &TesterInterface::setCallback>
+      chain(&tester);
+  chain.setCallback(&callback);
+
+  EXPECT_CALL(tester, doA());
+  chain->doA();
+  EXPECT_CALL(callback, onA());
+  tester.cb_->onA();
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/utils/IOBufDefrag.h>
+
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+using folly::IOBuf;
+
+namespace {
+
+std::unique_ptr<IOBuf> makeBuf(char fill, size_t len) {
+  auto buf = IOBuf::create(len);
+  memset(buf->writableTail(), fill, len);
+  buf->append(len);
+  return buf;
+}
+
+std::string chainToString(const IOBuf& chain) {
+  std::string out;
+  for (const auto& range : chain) {
+    out.append(reinterpret_cast<const char*>(range.data()), range.size());
+  }
+  return out;
+}
+
+} // namespace
+
+TEST(IOBufDefragTest, CoalescesSmallRuns) {
+  // 100 tiny buffers collapse into a single 4KB slab
+  auto chain = makeBuf('a', 10);
+  for (int i = 1; i < 100; i++) {
+    chain->prependChain(makeBuf('a' + (i % 26), 10));
+  }
+  auto expected = chainToString(*chain);
+
+  IOBufDefragStats stats;
+  auto result = defragmentIOBufChain(std::move(chain), 4096, &stats);
+  EXPECT_EQ(stats.buffersIn, 100);
+  EXPECT_EQ(stats.buffersOut, 1);
+  EXPECT_EQ(stats.bytesCopied, 1000);
+  EXPECT_EQ(result->countChainElements(), 1);
+  EXPECT_EQ(chainToString(*result), expected);
+}
+
+TEST(IOBufDefragTest, LargeBuffersStayZeroCopy) {
+  auto large = makeBuf('L', 64 * 1024);
+  const void* largeData = large->data();
+  auto chain = makeBuf('s', 16);
+  chain->prependChain(std::move(large));
+  chain->prependChain(makeBuf('t', 16));
+  auto expected = chainToString(*chain);
+
+  IOBufDefragStats stats;
+  auto result = defragmentIOBufChain(std::move(chain), 4096, &stats);
+  EXPECT_EQ(stats.buffersIn, 3);
+  EXPECT_EQ(stats.buffersOut, 3);
+  EXPECT_EQ(stats.bytesCopied, 32);
+  EXPECT_EQ(chainToString(*result), expected);
+
+  // the large buffer was relinked, not copied
+  bool foundLarge = false;
+  for (const auto& range : *result) {
+    foundLarge |= (range.data() == largeData);
+  }
+  EXPECT_TRUE(foundLarge);
+}
+
+TEST(IOBufDefragTest, RunsEscalateToLargeSlabs) {
+  // ~24KB of small buffers: one 4KB slab, then 16KB slabs
+  std::unique_ptr<IOBuf> chain;
+  for (int i = 0; i < 24; i++) {
+    auto buf = makeBuf('a' + (i % 26), 1024);
+    if (!chain) {
+      chain = std::move(buf);
+    } else {
+      chain->prependChain(std::move(buf));
+    }
+  }
+  auto expected = chainToString(*chain);
+
+  IOBufDefragStats stats;
+  auto result = defragmentIOBufChain(std::move(chain), 4096, &stats);
+  EXPECT_EQ(stats.buffersIn, 24);
+  EXPECT_EQ(stats.buffersOut, 3); // 4KB + 16KB + remainder
+  EXPECT_EQ(stats.bytesCopied, 24 * 1024);
+  EXPECT_EQ(chainToString(*result), expected);
+}
+
+TEST(IOBufDefragTest, DropsEmptyBuffers) {
+  auto chain = IOBuf::create(128); // empty head, as writeBuf_ can produce
+  chain->prependChain(makeBuf('x', 8));
+  chain->prependChain(IOBuf::create(0));
+
+  IOBufDefragStats stats;
+  auto result = defragmentIOBufChain(std::move(chain), 4096, &stats);
+  EXPECT_EQ(chainToString(*result), "xxxxxxxx");
+  EXPECT_EQ(stats.bytesCopied, 8);
+}
+
+TEST(IOBufDefragTest, EmptyChain) {
+  auto result = defragmentIOBufChain(IOBuf::create(0), 4096, nullptr);
+  ASSERT_NE(result, nullptr);
+  EXPECT_EQ(result->computeChainDataLength(), 0);
+}
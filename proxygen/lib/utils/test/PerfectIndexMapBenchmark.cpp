@@ -7,6 +7,7 @@
  */
 
 #include <algorithm>
+#include <cstring>
 #include <folly/Benchmark.h>
 #include <folly/container/F14Map.h>
 #include <proxygen/lib/http/HTTPCommonHeaders.h>
@@ -86,6 +87,28 @@ typedef PerfectIndexMap<HTTPHeaderCode,
                         false>
     DefaultPerfectIndexMap;
 
+typedef PerfectIndexMap<HTTPHeaderCode,
+                        HTTP_HEADER_OTHER,
+                        HTTP_HEADER_NONE,
+                        HTTPCommonHeaders::hash,
+                        false,
+                        false,
+                        kPerfectIndexMapCacheLineCapacity>
+    CacheLinePerfectIndexMap;
+
+// A typical request header block carries a few tens of headers, not the
+// full common-code keyspace; use that occupancy for the probe benchmarks.
+constexpr size_t kRealisticOccupancy = 20;
+
+std::vector<HTTPHeaderCode> getRealisticHeaderCodes() {
+  auto codes = getTestHeaderCodes();
+  codes.resize(kRealisticOccupancy);
+  return codes;
+}
+
+static const std::vector<HTTPHeaderCode> realisticHeaderCodes =
+    getRealisticHeaderCodes();
+
 } // namespace
 
 void UnorderedMapInsertBench(
@@ -125,8 +148,9 @@ void F14GetBench(folly::F14FastMap<std::string, std::string>& testMap,
   }
 }
 
+template <typename Map>
 void PerfectIndexMapInsertCodeBench(
-    DefaultPerfectIndexMap& map,
+    Map& map,
     const std::vector<HTTPHeaderCode>& keys,
     const std::vector<const std::string*>& values,
     int iters) {
@@ -163,7 +187,8 @@ void UnorderedMapGetBench(std::unordered_map<std::string, std::string>& testMap,
   }
 }
 
-void PerfectIndexMapGetCodeBench(DefaultPerfectIndexMap& map,
+template <typename Map>
+void PerfectIndexMapGetCodeBench(Map& map,
                                  const std::vector<HTTPHeaderCode>& keys,
                                  int iters) {
   for (int i = 0; i < iters; ++i) {
@@ -276,6 +301,69 @@ BENCHMARK(PerfectIndexMapUniqueGetsOtherString, iters) {
       bPerfectIndexMapUniqueGetsOtherStringMap, testHeadersOtherStrings, iters);
 }
 
+// Probe-only comparison at realistic occupancy: scan the raw key vector for
+// every key once per iteration, with the libc scalar path vs the inline
+// vectorized path PerfectIndexMap::searchForKey now uses.
+
+std::vector<uint8_t> getRealisticKeyBytes() {
+  std::vector<uint8_t> keyBytes;
+  for (auto code : realisticHeaderCodes) {
+    keyBytes.push_back(static_cast<uint8_t>(code));
+  }
+  return keyBytes;
+}
+
+static const std::vector<uint8_t> realisticKeyBytes = getRealisticKeyBytes();
+
+BENCHMARK(KeyScanScalarRealisticOccupancy, iters) {
+  for (unsigned i = 0; i < iters; ++i) {
+    for (auto key : realisticKeyBytes) {
+      auto* found =
+          memchr(realisticKeyBytes.data(), key, realisticKeyBytes.size());
+      folly::doNotOptimizeAway(found);
+    }
+  }
+}
+
+BENCHMARK(KeyScanSimdRealisticOccupancy, iters) {
+  for (unsigned i = 0; i < iters; ++i) {
+    for (auto key : realisticKeyBytes) {
+      auto offset = proxygen::detail::findFirstKeyByte(
+          realisticKeyBytes.data(), realisticKeyBytes.size(), key);
+      folly::doNotOptimizeAway(offset);
+    }
+  }
+}
+
+// Whole-map gets at the same occupancy, default construction vs the
+// cache-line capacity preset.
+
+DefaultPerfectIndexMap getBenchPerfectIndexMapRealisticGetsTestMap() {
+  DefaultPerfectIndexMap testMap;
+  PerfectIndexMapInsertCodeBench(
+      testMap, realisticHeaderCodes, testHeadersCodeStrings, 1);
+  return testMap;
+}
+DefaultPerfectIndexMap bPerfectIndexMapRealisticGetsCodeMap =
+    getBenchPerfectIndexMapRealisticGetsTestMap();
+BENCHMARK(PerfectIndexMapRealisticGetsCode, iters) {
+  PerfectIndexMapGetCodeBench(
+      bPerfectIndexMapRealisticGetsCodeMap, realisticHeaderCodes, iters);
+}
+
+CacheLinePerfectIndexMap getBenchCacheLineMapRealisticGetsTestMap() {
+  CacheLinePerfectIndexMap testMap;
+  PerfectIndexMapInsertCodeBench(
+      testMap, realisticHeaderCodes, testHeadersCodeStrings, 1);
+  return testMap;
+}
+CacheLinePerfectIndexMap bCacheLineMapRealisticGetsCodeMap =
+    getBenchCacheLineMapRealisticGetsTestMap();
+BENCHMARK(CacheLinePerfectIndexMapRealisticGetsCode, iters) {
+  PerfectIndexMapGetCodeBench(
+      bCacheLineMapRealisticGetsCodeMap, realisticHeaderCodes, iters);
+}
+
 int main(int argc, char** argv) {
   gflags::ParseCommandLineFlags(&argc, &argv, true);
   folly::runBenchmarks();
@@ -26,13 +26,15 @@ template <typename Key,
           bool AllowDuplicates,
           bool CaseInsensitive,
           uint8_t KeyCommonOffset,
-          uint64_t NumKeys>
+          uint64_t NumKeys,
+          size_t InitialCapacity = 0>
 struct PerfectIndexMapTestsTemplateParams {
   typedef Key TKey;
   static const Key TOtherKey = OtherKey;
   static const Key TNoneKey = NoneKey;
   static const bool TAllowDuplicates = AllowDuplicates;
   static const bool TCaseInsensitive = CaseInsensitive;
+  static const size_t TInitialCapacity = InitialCapacity;
 
   // Pass through wrapper for the hashing method.
   // This method only exists because am unsure how to properly capture it and
@@ -55,7 +57,8 @@ class PerfectIndexMapTests : public testing::Test {
                   T::TNoneKey,
                   T::Hash,
                   T::TAllowDuplicates,
-                  T::TCaseInsensitive>
+                  T::TCaseInsensitive,
+                  T::TInitialCapacity>
       testMap_;
 };
 
@@ -92,7 +95,16 @@ typedef testing::Types<
                                        false,
                                        false,
                                        HTTPHeaderCodeCommonOffset,
-                                       HTTPCommonHeaders::num_codes>>
+                                       HTTPCommonHeaders::num_codes>,
+    PerfectIndexMapTestsTemplateParams<HTTPHeaderCode,
+                                       HTTP_HEADER_OTHER,
+                                       HTTP_HEADER_NONE,
+                                       HTTPCommonHeaders::hash,
+                                       true,
+                                       true,
+                                       HTTPHeaderCodeCommonOffset,
+                                       HTTPCommonHeaders::num_codes,
+                                       kPerfectIndexMapCacheLineCapacity>>
     TestTypes;
 TYPED_TEST_CASE(PerfectIndexMapTests, TestTypes);
 
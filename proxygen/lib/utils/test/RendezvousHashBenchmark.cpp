@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/Benchmark.h>
+#include <folly/Conv.h>
+#include <proxygen/lib/utils/ConsistentHash.h>
+#include <proxygen/lib/utils/RendezvousHash.h>
+
+using namespace folly;
+using namespace proxygen;
+
+// buck build @mode/opt proxygen/lib/utils/test:rendezvous_hash_benchmark
+// ./buck-out/gen/proxygen/lib/utils/test/rendezvous_hash_benchmark
+// -bm_min_iters 1000
+
+namespace {
+
+RendezvousHash buildHash(size_t numNodes) {
+  RendezvousHash hash;
+  std::vector<std::pair<std::string, uint64_t>> nodes;
+  nodes.reserve(numNodes);
+  for (size_t i = 0; i < numNodes; ++i) {
+    // realistic hostname-ish keys and mixed weights
+    nodes.emplace_back(folly::to<std::string>("edge", i, ".cluster.example"),
+                       100 + (i % 5) * 100);
+  }
+  hash.build(nodes);
+  return hash;
+}
+
+RendezvousHash bHash100 = buildHash(100);
+RendezvousHash bHash800 = buildHash(800);
+
+void getBench(const RendezvousHash& hash, unsigned iters) {
+  for (unsigned i = 0; i < iters; ++i) {
+    doNotOptimizeAway(hash.get(i));
+  }
+}
+
+} // namespace
+
+BENCHMARK(RendezvousHashGet100Nodes, iters) {
+  getBench(bHash100, iters);
+}
+
+BENCHMARK(RendezvousHashGet800Nodes, iters) {
+  getBench(bHash800, iters);
+}
+
+// the way routers actually hold the hash: through the ConsistentHash
+// interface, adding a virtual call per lookup
+BENCHMARK(ConsistentHashInterfaceGet800Nodes, iters) {
+  const ConsistentHash& hash = bHash800;
+  for (unsigned i = 0; i < iters; ++i) {
+    doNotOptimizeAway(hash.get(i));
+  }
+}
+
+BENCHMARK(RendezvousHashGetRank3Of800Nodes, iters) {
+  for (unsigned i = 0; i < iters; ++i) {
+    doNotOptimizeAway(bHash800.get(i, 3));
+  }
+}
+
+BENCHMARK(RendezvousHashUpdateWeight800Nodes, iters) {
+  for (unsigned i = 0; i < iters; ++i) {
+    doNotOptimizeAway(
+        bHash800.updateWeight("edge7.cluster.example", 100 + (i % 5) * 100));
+  }
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -299,3 +299,44 @@ TEST(RendezvousHash, selectNUnweighted) {
     EXPECT_GT(different, 0);
   }
 }
+
+TEST(RendezvousHash, ConsistencyWithIncrementalWeightUpdate) {
+  RendezvousHash hashes;
+  int numNodes = 10;
+  std::vector<std::pair<std::string, uint64_t>> nodes;
+  for (int i = 0; i < numNodes; ++i) {
+    nodes.emplace_back(folly::to<std::string>("key", i), 10);
+  }
+  hashes.build(nodes);
+
+  std::map<uint64_t, size_t> mapping;
+  for (uint64_t i = 0; i < 10000; ++i) {
+    mapping[i] = hashes.get(i);
+  }
+
+  // drain one node in place; only its keys should move
+  EXPECT_TRUE(hashes.updateWeight("key5", 0));
+  for (auto&& [key, expected] : mapping) {
+    size_t id = hashes.get(key);
+    EXPECT_NE(5, id);
+    if (expected != 5) {
+      EXPECT_EQ(expected, id);
+    }
+  }
+
+  // restoring the weight restores the original assignment
+  EXPECT_TRUE(hashes.updateWeight("key5", 10));
+  for (auto&& [key, expected] : mapping) {
+    EXPECT_EQ(expected, hashes.get(key));
+  }
+}
+
+TEST(RendezvousHash, UpdateWeightUnknownNode) {
+  RendezvousHash hashes;
+  std::vector<std::pair<std::string, uint64_t>> nodes;
+  for (int i = 0; i < 10; ++i) {
+    nodes.emplace_back(folly::to<std::string>("key", i), 1);
+  }
+  hashes.build(nodes);
+  EXPECT_FALSE(hashes.updateWeight("not-a-node", 7));
+}
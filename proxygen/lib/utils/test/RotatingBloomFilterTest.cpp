@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/utils/RotatingBloomFilter.h>
+
+#include <folly/hash/Hash.h>
+#include <folly/portability/GTest.h>
+
+#include <thread>
+
+using namespace proxygen;
+
+TEST(RotatingBloomFilter, TestAndSet) {
+  RotatingBloomFilter filter(1000, 0.001, std::chrono::seconds(60));
+  for (uint64_t i = 0; i < 1000; i++) {
+    const auto key = folly::hash::twang_mix64(i);
+    // First sighting is fresh, second is a hit; no false negatives
+    EXPECT_FALSE(filter.testAndSet(key));
+    EXPECT_TRUE(filter.testAndSet(key));
+    EXPECT_TRUE(filter.test(key));
+  }
+}
+
+TEST(RotatingBloomFilter, FalsePositiveRate) {
+  constexpr size_t kEntries = 10000;
+  RotatingBloomFilter filter(kEntries, 0.01, std::chrono::seconds(60));
+  for (uint64_t i = 0; i < kEntries; i++) {
+    filter.testAndSet(folly::hash::twang_mix64(i));
+  }
+  size_t falsePositives = 0;
+  for (uint64_t i = kEntries; i < 2 * kEntries; i++) {
+    if (filter.test(folly::hash::twang_mix64(i))) {
+      falsePositives++;
+    }
+  }
+  // Sized for 1%; allow generous slack to keep the test deterministic
+  EXPECT_LT(falsePositives, kEntries / 20);
+}
+
+TEST(RotatingBloomFilter, RotationAgesEntriesOut) {
+  RotatingBloomFilter filter(100, 0.001, std::chrono::seconds(0));
+  const auto key = folly::hash::twang_mix64(42);
+  EXPECT_FALSE(filter.testAndSet(key));
+  // Zero lifetime: every insert rotates, so after two more inserts of
+  // other keys both generations holding 'key' have been cleared
+  filter.testAndSet(folly::hash::twang_mix64(1));
+  filter.testAndSet(folly::hash::twang_mix64(2));
+  EXPECT_FALSE(filter.test(key));
+}
+
+TEST(RotatingBloomFilter, ConcurrentInserts) {
+  constexpr size_t kThreads = 4;
+  constexpr size_t kKeysPerThread = 2000;
+  RotatingBloomFilter filter(
+      kThreads * kKeysPerThread, 0.001, std::chrono::seconds(60));
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < kThreads; t++) {
+    threads.emplace_back([&filter, t] {
+      for (uint64_t i = 0; i < kKeysPerThread; i++) {
+        filter.testAndSet(folly::hash::twang_mix64(t << 32 | i));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (size_t t = 0; t < kThreads; t++) {
+    for (uint64_t i = 0; i < kKeysPerThread; i++) {
+      EXPECT_TRUE(filter.test(folly::hash::twang_mix64(t << 32 | i)));
+    }
+  }
+}
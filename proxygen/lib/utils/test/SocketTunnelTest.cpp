@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/utils/SocketTunnel.h>
+
+#include <cstring>
+
+#include <folly/io/async/EventBase.h>
+#include <folly/portability/GTest.h>
+#include <folly/portability/Sockets.h>
+#include <folly/portability/Unistd.h>
+
+using namespace proxygen;
+
+TEST(SocketTunnelTest, RelaysBothDirectionsAndCounts) {
+  folly::EventBase evb;
+  int clientPair[2];
+  int serverPair[2];
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, clientPair), 0);
+  ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, serverPair), 0);
+  folly::AsyncTransport::UniquePtr client(new folly::AsyncSocket(
+      &evb, folly::NetworkSocket::fromFd(clientPair[1])));
+  folly::AsyncTransport::UniquePtr server(new folly::AsyncSocket(
+      &evb, folly::NetworkSocket::fromFd(serverPair[0])));
+
+  // Queue payload in both directions before the relay starts, then
+  // half-close so the tunnel winds down once everything is through
+  ASSERT_EQ(::write(clientPair[0], "hello", 5), 5);
+  ASSERT_EQ(::write(serverPair[1], "world!", 6), 6);
+  ::shutdown(clientPair[0], SHUT_WR);
+  ::shutdown(serverPair[1], SHUT_WR);
+
+  uint64_t bytesToServer = 0;
+  uint64_t bytesToClient = 0;
+  bool closed = false;
+  SocketTunnel::start(std::move(client),
+                      std::move(server),
+                      [&](uint64_t toServer, uint64_t toClient) {
+                        bytesToServer = toServer;
+                        bytesToClient = toClient;
+                        closed = true;
+                      });
+  evb.loop();
+
+  EXPECT_TRUE(closed);
+  EXPECT_EQ(bytesToServer, 5);
+  EXPECT_EQ(bytesToClient, 6);
+
+  char buf[16];
+  ASSERT_EQ(::read(serverPair[1], buf, sizeof(buf)), 5);
+  EXPECT_EQ(memcmp(buf, "hello", 5), 0);
+  ASSERT_EQ(::read(clientPair[0], buf, sizeof(buf)), 6);
+  EXPECT_EQ(memcmp(buf, "world!", 6), 0);
+  // Both far ends should see EOF once the tunnel has closed
+  EXPECT_EQ(::read(serverPair[1], buf, sizeof(buf)), 0);
+  EXPECT_EQ(::read(clientPair[0], buf, sizeof(buf)), 0);
+  ::close(clientPair[0]);
+  ::close(serverPair[1]);
+}
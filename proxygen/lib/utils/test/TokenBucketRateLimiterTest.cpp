@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/utils/TokenBucketRateLimiter.h>
+
+#include <folly/io/async/EventBase.h>
+#include <folly/portability/GTest.h>
+
+using namespace proxygen;
+using std::chrono::milliseconds;
+
+namespace {
+
+class ManualClock : public TokenBucketRateLimiter::Clock {
+ public:
+  TimePoint now() override {
+    return now_;
+  }
+
+  void advance(milliseconds ms) {
+    now_ += ms;
+  }
+
+ private:
+  TimePoint now_{getCurrentTime()};
+};
+
+class TestWaiter : public TokenBucketRateLimiter::Callback {
+ public:
+  void tokensAvailable() noexcept override {
+    ++fired;
+    if (fn) {
+      fn();
+    }
+  }
+
+  uint32_t fired{0};
+  std::function<void()> fn;
+};
+
+} // namespace
+
+class TokenBucketRateLimiterTest : public testing::Test {
+ protected:
+  folly::EventBase evb_;
+  ManualClock clock_;
+  TokenBucketRateLimiter limiter_{&evb_, milliseconds(1), &clock_};
+};
+
+TEST_F(TokenBucketRateLimiterTest, ConsumeAndRefill) {
+  auto bucket = limiter_.makeBucket(nullptr, 1000, 1000);
+
+  EXPECT_TRUE(limiter_.tryConsume(*bucket, 600));
+  EXPECT_FALSE(limiter_.tryConsume(*bucket, 600));
+  EXPECT_EQ(bucket->getBytesConsumed(), 600);
+  EXPECT_EQ(bucket->getDeniedCount(), 1);
+
+  // 500ms at 1000 B/s refills 500 tokens
+  clock_.advance(milliseconds(500));
+  EXPECT_EQ(bucket->getTokens(), 900);
+  EXPECT_TRUE(limiter_.tryConsume(*bucket, 600));
+
+  // Tokens cap at the burst no matter how long the idle period
+  clock_.advance(milliseconds(60000));
+  EXPECT_EQ(bucket->getTokens(), 1000);
+}
+
+TEST_F(TokenBucketRateLimiterTest, HierarchyEnforcesEveryLevel) {
+  auto listener = limiter_.makeBucket(nullptr, 1000, 1000);
+  auto session1 = limiter_.makeBucket(listener.get(), 800, 800);
+  auto session2 = limiter_.makeBucket(listener.get(), 800, 800);
+  // Unlimited transaction bucket: present in the tree but inert
+  auto txn1 = limiter_.makeBucket(session1.get(), 0, 0);
+  auto txn2 = limiter_.makeBucket(session2.get(), 0, 0);
+
+  // Session cap: txn1 cannot exceed 800 even though the listener has 1000
+  EXPECT_FALSE(limiter_.tryConsume(*txn1, 900));
+  EXPECT_EQ(session1->getDeniedCount(), 1);
+  EXPECT_TRUE(limiter_.tryConsume(*txn1, 800));
+
+  // Listener aggregate: only 200 left for the other session
+  EXPECT_FALSE(limiter_.tryConsume(*txn2, 300));
+  EXPECT_EQ(listener->getDeniedCount(), 1);
+  EXPECT_TRUE(limiter_.tryConsume(*txn2, 200));
+  EXPECT_EQ(listener->getBytesConsumed(), 1000);
+}
+
+TEST_F(TokenBucketRateLimiterTest, WaiterFiresOnSharedTick) {
+  auto bucket = limiter_.makeBucket(nullptr, 1000, 1000);
+  EXPECT_TRUE(limiter_.tryConsume(*bucket, 1000));
+
+  TestWaiter waiter;
+  waiter.fn = [&] { EXPECT_TRUE(limiter_.tryConsume(*bucket, 100)); };
+  limiter_.waitForTokens(*bucket, 100, &waiter);
+  EXPECT_EQ(limiter_.getNumWaiters(), 1);
+
+  // First tick: no tokens yet, waiter stays parked
+  evb_.loopOnce();
+  EXPECT_EQ(waiter.fired, 0);
+
+  // Refill enough for the wait and tick again
+  clock_.advance(milliseconds(200));
+  evb_.loopOnce();
+  EXPECT_EQ(waiter.fired, 1);
+  EXPECT_EQ(limiter_.getNumWaiters(), 0);
+}
+
+TEST_F(TokenBucketRateLimiterTest, WaitersServedInFifoOrder) {
+  auto bucket = limiter_.makeBucket(nullptr, 1000, 1000);
+  EXPECT_TRUE(limiter_.tryConsume(*bucket, 1000));
+
+  // Both want 400; one refill round only covers the first
+  TestWaiter first;
+  TestWaiter second;
+  first.fn = [&] { EXPECT_TRUE(limiter_.tryConsume(*bucket, 400)); };
+  second.fn = [&] { EXPECT_TRUE(limiter_.tryConsume(*bucket, 400)); };
+  limiter_.waitForTokens(*bucket, 400, &first);
+  limiter_.waitForTokens(*bucket, 400, &second);
+
+  clock_.advance(milliseconds(500));
+  evb_.loopOnce();
+  EXPECT_EQ(first.fired, 1);
+  EXPECT_EQ(second.fired, 0);
+
+  clock_.advance(milliseconds(400));
+  evb_.loopOnce();
+  EXPECT_EQ(second.fired, 1);
+}
+
+TEST_F(TokenBucketRateLimiterTest, CancelWaitAndBucketTeardown) {
+  auto bucket = limiter_.makeBucket(nullptr, 1000, 1000);
+  EXPECT_TRUE(limiter_.tryConsume(*bucket, 1000));
+
+  TestWaiter cancelled;
+  TestWaiter doomed;
+  limiter_.waitForTokens(*bucket, 100, &cancelled);
+  limiter_.cancelWait(&cancelled);
+  EXPECT_EQ(limiter_.getNumWaiters(), 0);
+
+  limiter_.waitForTokens(*bucket, 100, &doomed);
+  bucket.reset();
+  EXPECT_EQ(limiter_.getNumWaiters(), 0);
+  EXPECT_EQ(limiter_.getNumBuckets(), 0);
+
+  clock_.advance(milliseconds(1000));
+  evb_.loop();
+  EXPECT_EQ(cancelled.fired, 0);
+  EXPECT_EQ(doomed.fired, 0);
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Facebook, Inc. and its affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <proxygen/lib/utils/TraceEventRingBuffer.h>
+
+#include <folly/experimental/TestUtil.h>
+#include <folly/portability/GTest.h>
+#include <proxygen/lib/utils/Time.h>
+
+#include <thread>
+
+using namespace proxygen;
+
+namespace {
+
+TraceEvent makeEvent(uint32_t parentID, int64_t bytes) {
+  TraceEvent event(TraceEventType::TotalRequest, parentID);
+  TimeUtil tm;
+  event.start(tm);
+  event.addMeta(TraceFieldType::Protocol, bytes);
+  event.addMeta(TraceFieldType::HostName, std::string("should be dropped"));
+  event.end(tm);
+  return event;
+}
+
+} // namespace
+
+TEST(TraceEventRingBufferTest, RecordAndDecode) {
+  folly::test::TemporaryFile logFile;
+  const std::string path = logFile.path().string();
+  constexpr size_t kEvents = 100;
+  {
+    TraceEventRingBufferWriter writer(path);
+    for (size_t i = 0; i < kEvents; i++) {
+      writer.record(makeEvent(i, int64_t(i) * 10));
+    }
+    EXPECT_EQ(0, writer.getDroppedCount());
+  }
+
+  auto records = TraceEventRingBufferWriter::decodeFile(path);
+  ASSERT_EQ(kEvents, records.size());
+  for (size_t i = 0; i < kEvents; i++) {
+    const auto& record = records[i];
+    EXPECT_EQ(static_cast<uint32_t>(TraceEventType::TotalRequest),
+              record.type);
+    EXPECT_EQ(i, record.parentID);
+    EXPECT_GT(record.startNs, 0);
+    EXPECT_GE(record.endNs, record.startNs);
+    // Only the integral field survives; the string one is dropped
+    ASSERT_EQ(1, record.fieldCount);
+    EXPECT_EQ(static_cast<uint32_t>(TraceFieldType::Protocol),
+              record.fieldTypes[0]);
+    EXPECT_EQ(int64_t(i) * 10, record.fieldValues[0]);
+  }
+}
+
+TEST(TraceEventRingBufferTest, MultiThreadedRecord) {
+  folly::test::TemporaryFile logFile;
+  const std::string path = logFile.path().string();
+  constexpr size_t kThreads = 4;
+  constexpr size_t kEventsPerThread = 500;
+  {
+    TraceEventRingBufferWriter writer(path);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kThreads; t++) {
+      threads.emplace_back([&writer, t] {
+        for (size_t i = 0; i < kEventsPerThread; i++) {
+          writer.record(makeEvent(t, int64_t(i)));
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(0, writer.getDroppedCount());
+  }
+
+  auto records = TraceEventRingBufferWriter::decodeFile(path);
+  EXPECT_EQ(kThreads * kEventsPerThread, records.size());
+}
+
+TEST(TraceEventRingBufferTest, DropsWhenFull) {
+  folly::test::TemporaryFile logFile;
+  const std::string path = logFile.path().string();
+  constexpr size_t kCapacity = 8;
+  // Spill interval far in the future so nothing drains mid-test
+  TraceEventRingBufferWriter writer(path, kCapacity, std::chrono::hours(1));
+  for (size_t i = 0; i < 3 * kCapacity; i++) {
+    writer.record(makeEvent(0, 0));
+  }
+  EXPECT_EQ(2 * kCapacity, writer.getDroppedCount());
+}
@@ -13,6 +13,7 @@
 #include <folly/io/IOBuf.h>
 #include <folly/portability/GTest.h>
 #include <glog/logging.h>
+#include <proxygen/lib/utils/ZstdDictStreamCompressor.h>
 #include <proxygen/lib/utils/ZstdStreamCompressor.h>
 #include <proxygen/lib/utils/ZstdStreamDecompressor.h>
 
@@ -241,3 +242,67 @@ TEST_F(ZstdTests, CompressDecompressStreamingProxygenIndependent) {
         std::move(input_pieces), true, reuseBuf);
   }
 }
+
+TEST_F(ZstdTests, DictCompressDecompress) {
+  // Any blob works as a raw content dictionary; use one resembling the
+  // payloads so it actually gets referenced
+  const std::string dictionary(
+      "{\"status\":\"ok\",\"payload\":{\"id\":0,\"name\":\"\"}}");
+  auto cdict = std::make_shared<const ZstdCompressionDictionary>(
+      dictionary, folly::io::COMPRESSION_LEVEL_DEFAULT);
+  ZstdDictStreamCompressor compressor(cdict);
+
+  auto body = folly::IOBuf::copyBuffer(
+      "{\"status\":\"ok\",\"payload\":{\"id\":42,\"name\":\"zstd\"}}");
+  auto compressed = compressor.compress(body.get(), true);
+  ASSERT_FALSE(compressor.hasError());
+  ASSERT_NE(compressed, nullptr);
+
+  // Decoding requires the same dictionary
+  auto zd = std::make_unique<ZstdStreamDecompressor>(false, dictionary);
+  auto decompressed = zd->decompress(compressed.get());
+  ASSERT_FALSE(zd->hasError());
+  ASSERT_TRUE(zd->finished());
+  IOBufEqualTo eq;
+  ASSERT_TRUE(eq(body, decompressed));
+}
+
+TEST_F(ZstdTests, DictCompressStreaming) {
+  const std::string dictionary = "a dictionary full of random junk";
+  auto cdict = std::make_shared<const ZstdCompressionDictionary>(
+      dictionary, folly::io::COMPRESSION_LEVEL_DEFAULT);
+  ZstdDictStreamCompressor compressor(cdict);
+
+  std::vector<std::unique_ptr<folly::IOBuf>> input_pieces;
+  input_pieces.push_back(makeBuf(38));
+  input_pieces.push_back(makeBuf(12));
+  input_pieces.push_back(makeBuf(4096));
+  input_pieces.push_back(makeBuf(0));
+
+  std::vector<std::unique_ptr<folly::IOBuf>> compressed_pieces;
+  size_t i = 0;
+  for (const auto& piece : input_pieces) {
+    const auto end = ++i == input_pieces.size();
+    compressed_pieces.push_back(compressor.compress(piece.get(), end));
+    ASSERT_FALSE(compressor.hasError());
+  }
+
+  auto input = folly::IOBuf::create(0);
+  while (!input_pieces.empty()) {
+    input->appendChain(std::move(input_pieces.back()));
+    input_pieces.pop_back();
+  }
+
+  auto zd = std::make_unique<ZstdStreamDecompressor>(false, dictionary);
+  auto decompressed = folly::IOBuf::create(0);
+  for (const auto& piece : compressed_pieces) {
+    auto dpiece = zd->decompress(piece.get());
+    ASSERT_FALSE(zd->hasError());
+    if (dpiece != nullptr) {
+      decompressed->prev()->appendChain(std::move(dpiece));
+    }
+  }
+  ASSERT_TRUE(zd->finished());
+  IOBufEqualTo eq;
+  ASSERT_TRUE(eq(input, decompressed));
+}